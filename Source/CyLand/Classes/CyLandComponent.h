@@ -216,7 +216,25 @@ struct FCyLandComponentGrassData
 #endif
 	TMap<ULandscapeGrassType*, TArray<uint8>> WeightData;
 
-	FCyLandComponentGrassData() {}
+	// Delta + zlib coded HeightData and WeightData, replacing them once ConditionalCompress() ran.
+	// Grass builders decode the channels they need into their own arrays.
+	TArray<uint8> CompressedHeightData;
+	TMap<ULandscapeGrassType*, TArray<uint8>> CompressedWeightData;
+	int32 NumCompressedSamples;
+
+	// Heights decoded from CompressedHeightData, shared by all the grass builders of the component instead of each
+	// one decoding its own copy. Released by ReleaseSharedHeightData once no builder used them for a while.
+	TSharedPtr<const TArray<uint16>, ESPMode::ThreadSafe> SharedHeightData;
+	double SharedHeightDataLastUseTime;
+
+	// Dropped by the grass data memory budget, regenerated when the component comes back into grass range
+	bool bEvicted;
+
+	FCyLandComponentGrassData()
+		: NumCompressedSamples(0)
+		, SharedHeightDataLastUseTime(0.0)
+		, bEvicted(false)
+	{}
 
 #if WITH_EDITOR
 	FCyLandComponentGrassData(UCyLandComponent* Component);
@@ -228,7 +246,18 @@ struct FCyLandComponentGrassData
 #if WITH_EDITORONLY_DATA
 			HeightMipData.Num() > 0 ||
 #endif
-			WeightData.Num() > 0;
+			WeightData.Num() > 0 ||
+			IsCompressed();
+	}
+
+	bool IsCompressed() const
+	{
+		return NumCompressedSamples > 0;
+	}
+
+	bool IsEvicted() const
+	{
+		return bEvicted;
 	}
 
 	SIZE_T GetAllocatedSize() const;
@@ -236,6 +265,24 @@ struct FCyLandComponentGrassData
 	// Check whether we can discard any data not needed with current scalability settings
 	void ConditionalDiscardDataOnLoad();
 
+	// Replace HeightData and WeightData by their compressed form if grass.CompressGrassData is set.
+	// Only call on data no grass builder references yet.
+	void ConditionalCompress();
+
+	// Restore HeightData and WeightData from the compressed form
+	void Decompress();
+
+	// Decode one channel of the compressed data, returns false if it is missing or corrupt
+	bool DecompressHeightData(TArray<uint16>& OutHeightData) const;
+	bool DecompressWeightData(const ULandscapeGrassType* GrassType, TArray<uint8>& OutWeightData) const;
+
+	// Decoded height channel shared with the other grass builders of the component, null if it is missing or corrupt.
+	// May be called from any thread.
+	TSharedPtr<const TArray<uint16>, ESPMode::ThreadSafe> GetSharedHeightData();
+
+	// Drop the shared decoded heights if no builder holds them and none asked for them since MinLastUseTime
+	void ReleaseSharedHeightData(double MinLastUseTime);
+
 	friend FArchive& operator<<(FArchive& Ar, FCyLandComponentGrassData& Data);
 };
 
@@ -402,6 +449,17 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = BakedTextures)
 	UTexture2D* GIBakedBaseColorTexture;
 
+	/**
+	 * Grass types of the material and the paint layer each of them reads, saved when the grass map only depends on the
+	 * weightmaps so cooked builds can evaluate it on the CPU without the material graph (see grass.CPUWeightEvaluation).
+	 * Empty when the grass map has to be rendered.
+	 */
+	UPROPERTY()
+	TArray<ULandscapeGrassType*> CPUGrassTypes;
+
+	UPROPERTY()
+	TArray<FName> CPUGrassLayerNames;
+
 #if WITH_EDITORONLY_DATA
 	/** LOD level Bias to use when lighting buidling via lightmass, -1 Means automatic LOD calculation based on ForcedLOD + LODBias */
 	UPROPERTY(EditAnywhere, Category=CyLandComponent)
@@ -502,6 +560,9 @@ public:
 
 	CYLAND_API UTexture2D* GetHeightmap(bool InReturnCurrentEditingHeightmap = false) const;
 	CYLAND_API void SetHeightmap(UTexture2D* NewHeightmap);
+
+	/** False while the heightmap atlas page of the component is evicted, its heightmap texels then belong to another component */
+	bool IsHeightmapResident() const { return HeightmapScaleBias.X > 0.0f; }
 	CYLAND_API void SetCurrentEditingHeightmap(UTexture2D* InNewHeightmap);
 
 #if WITH_EDITOR
@@ -545,8 +606,7 @@ public:
 	// true if the component's landscape material supports grass
 	bool MaterialHasGrass() const;
 
-	/** Creates and destroys cooked grass data stored in the map */
-	void RenderGrassMap();
+	/** Destroys cooked grass data stored in the map */
 	void RemoveGrassMap();
 
 	/* Could a grassmap currently be generated, disregarding whether our textures are streamed in? */
@@ -555,6 +615,9 @@ public:
 	/* Are the textures we need to render a grassmap currently streamed in? */
 	bool AreTexturesStreamedForGrassMapRender() const;
 
+	/** Refresh CPUGrassTypes and CPUGrassLayerNames from the material before the component is saved */
+	void UpdateCPUGrassLayers();
+
 	/* Is the grassmap data outdated, eg by a material */
 	bool IsGrassMapOutdated() const;
 
@@ -569,10 +632,31 @@ public:
 	void GeneratePlatformVertexData(const ITargetPlatform* TargetPlatform);
 	void GeneratePlatformPixelData();
 
+	/** First half of GeneratePlatformPixelData. If OutPendingTextures is set, the textures are added to it after BeginCachePlatformData instead of being built here */
+	void GenerateMobileWeightmapTextures(TArray<UTexture2D*>* OutPendingTextures);
+
+	/** Second half of GeneratePlatformPixelData, once the mobile weightmap textures are built */
+	void GenerateMobileMaterialInstances();
+
+	/** Hash of everything the mobile data is generated from */
+	FGuid ComputeMobileDataSourceHash();
+
 	/** Generate mobile data if it's missing or outdated */
 	void CheckGenerateCyLandPlatformData(bool bIsCooking, const ITargetPlatform* TargetPlatform);
+
+	/**
+	 * Generate the mobile data of the components where it's missing or outdated. The vertex data of all the components
+	 * is generated, compressed and saved to the DDC on worker threads (see cyland.ParallelPlatformData).
+	 */
+	static void CheckGenerateCyLandPlatformData(const TArray<UCyLandComponent*>& Components, bool bIsCooking, const ITargetPlatform* TargetPlatform);
 #endif
 
+	/** Creates cooked grass data stored in the map, in cooked builds only possible on the CPU */
+	void RenderGrassMap();
+
+	/* Should the grassmap be evaluated on the CPU from the weightmaps instead of rendered? See grass.CPUWeightEvaluation */
+	bool ShouldEvaluateGrassMapOnCPU() const;
+
 	CYLAND_API int32 GetMaterialInstanceCount(bool InDynamic = true) const;
 	CYLAND_API class UMaterialInstance* GetMaterialInstance(int32 InIndex, bool InDynamic = true) const;
 
@@ -659,6 +743,13 @@ public:
 	 */
 	void GenerateHeightmapMips(TArray<FColor*>& HeightmapTextureMipData, int32 ComponentX1=0, int32 ComponentY1=0, int32 ComponentX2=MAX_int32, int32 ComponentY2=MAX_int32, FCyLandTextureDataInfo* TextureDataInfo=nullptr);
 
+	/**
+	 * Same as GenerateHeightmapMips but works on raw mip data with an explicit heightmap layout, so it does not
+	 * touch any UObject and can run on worker threads.
+	 */
+	static void GenerateHeightmapMipsRaw(int32 InComponentSizeQuads, int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 HeightmapSizeU, int32 HeightmapSizeV, int32 HeightmapOffsetX, int32 HeightmapOffsetY,
+		TArray<FColor*>& HeightmapTextureMipData, int32 ComponentX1=0, int32 ComponentY1=0, int32 ComponentX2=MAX_int32, int32 ComponentY2=MAX_int32, FCyLandTextureDataInfo* TextureDataInfo=nullptr);
+
 	/**
 	 * Generate empty mipmaps for weightmap
 	 */
@@ -685,6 +776,13 @@ public:
 	/** @todo document */
 	static void UpdateMipsTempl(int32 InNumSubsections, int32 InSubsectionSizeQuads, UTexture2D* WeightmapTexture, TArray<DataType*>& WeightmapTextureMipData, int32 ComponentX1=0, int32 ComponentY1=0, int32 ComponentX2=MAX_int32, int32 ComponentY2=MAX_int32, FCyLandTextureDataInfo* TextureDataInfo=nullptr);
 
+	/** UpdateMipsTempl on raw mip data of the given size, safe to call from worker threads */
+	template<typename DataType>
+	static void UpdateMipsTemplRaw(int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 SizeU, int32 SizeV, TArray<DataType*>& TextureMipData, int32 ComponentX1=0, int32 ComponentY1=0, int32 ComponentX2=MAX_int32, int32 ComponentY2=MAX_int32, FCyLandTextureDataInfo* TextureDataInfo=nullptr);
+
+	/** Generate every weightmap mip below the base mip on raw mip data, safe to call from worker threads */
+	static void UpdateWeightmapMipsRaw(int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 WeightmapSizeU, int32 WeightmapSizeV, TArray<FColor*>& WeightmapTextureMipData);
+
 	/** @todo document */
 	CYLAND_API static void UpdateWeightmapMips(int32 InNumSubsections, int32 InSubsectionSizeQuads, UTexture2D* WeightmapTexture, TArray<FColor*>& WeightmapTextureMipData, int32 ComponentX1=0, int32 ComponentY1=0, int32 ComponentX2=MAX_int32, int32 ComponentY2=MAX_int32, FCyLandTextureDataInfo* TextureDataInfo=nullptr);
 
@@ -15,6 +15,8 @@
 
 class ACyLandProxy;
 class FAsyncPreRegisterDDCRequest;
+class FCyLandAsyncCollisionCook;
+class FCyLandCollisionCookJob;
 class UCyLandComponent;
 class UCyLandInfo;
 class UCyLandLayerInfoObject;
@@ -79,6 +81,9 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 	{
 		FGuid Guid;
 
+		/** Size in quads of the low resolution heightfield standing in while the real one cooks asynchronously, 0 for cooked collision */
+		int32 PlaceholderSizeQuads;
+
 #if WITH_PHYSX
 		/** List of PxMaterials used on this landscape */
 		TArray<physx::PxMaterial*> UsedPhysicalMaterialArray;
@@ -91,8 +96,9 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 
 		/** tors **/
 		FPhysXHeightfieldRef()
+			: PlaceholderSizeQuads(0)
 #if WITH_PHYSX
-			: RBHeightfield(nullptr)
+			, RBHeightfield(nullptr)
 			, RBHeightfieldSimple(nullptr)
 #if WITH_EDITOR
 			, RBHeightfieldEd(nullptr)
@@ -103,6 +109,7 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 
 		FPhysXHeightfieldRef(FGuid& InGuid)
 			: Guid(InGuid)
+			, PlaceholderSizeQuads(0)
 #if WITH_PHYSX
 			, RBHeightfield(nullptr)
 			, RBHeightfieldSimple(nullptr)
@@ -139,6 +146,9 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 	  */
 	mutable TSharedPtr<FAsyncPreRegisterDDCRequest>	SpeculativeDDCRequest;
 
+	/** Collision cook running in the thread pool, the physics state is recreated with its result. See cyland.AsyncCollisionCooking */
+	TSharedPtr<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe>	AsyncCollisionCook;
+
 #endif //WITH_EDITORONLY_DATA
 
 	/** 
@@ -159,6 +169,13 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 	int32 HeightfieldColumnsCount;
 	mutable FNavHeightfieldSamples CachedHeightFieldSamples;
 
+	/** Collision vertices (inclusive) changed since the live heightfields were last patched, see FlushHeightfieldUpdates */
+	FIntRect PendingHeightfieldRegion;
+	bool bHeightfieldRegionPending;
+
+	/** Copy of the live heightfield once SetCollisionHeights changed it at runtime, so later changes don't read the heightfield back */
+	TArray<uint16> RuntimeCollisionHeights;
+
 	enum ECollisionQuadFlags : uint8
 	{
 		QF_PhysicalMaterialMask = 63,	// Mask value for the physical material index, stored in the lower 6 bits.
@@ -169,6 +186,7 @@ class UCyLandHeightfieldCollisionComponent : public UPrimitiveComponent
 	//~ Begin UActorComponent Interface.
 protected:
 	virtual void OnCreatePhysicsState() override;
+	virtual void OnDestroyPhysicsState() override;
 public:
 	virtual void ApplyWorldOffset(const FVector& InOffset, bool bWorldShift) override;
 	//~ End UActorComponent Interface.
@@ -221,13 +239,50 @@ public:
 	 */
 	virtual bool CookCollisionData(const FName& Format, bool bUseOnlyDefMaterial, bool bCheckDDC, TArray<uint8>& OutCookedData, TArray<UPhysicalMaterial*>& InOutMaterials) const;
 
-	/** Modify a sub-region of the PhysX heightfield. Note that this does not update the physical material */
+	/**
+	 * Gathers the raw collision data into a job that can be cooked on any thread
+	 * @return false if there is nothing to cook
+	 */
+	virtual bool GatherCollisionCookJob(const FName& Format, bool bUseOnlyDefMaterial, FCyLandCollisionCookJob& OutJob, TArray<UPhysicalMaterial*>& InOutMaterials) const;
+
+	/** Guid of the collision data in the DDC and in the shared collision objects */
+	virtual const FGuid& GetCollisionDataGuid() const { return HeightfieldGuid; }
+
+	/** Wait for the async collision cook of this component, if any, and create the physics state with its result */
+	CYLAND_API void FinishAsyncCollisionCook();
+
+	/** Finish the async collision cooks that are done, called at the end of every frame */
+	static void TickAsyncCollisionCooks();
+
+	/**
+	 * Patch a sub-region of the PhysX heightfields from CollisionHeightData at the end of the frame, without cooking.
+	 * Note that this does not update the physical material
+	 */
 	void UpdateHeightfieldRegion(int32 ComponentX1, int32 ComponentY1, int32 ComponentX2, int32 ComponentY2);
 #endif
 
+	/**
+	 * Change the collision heights of a region at runtime, e.g. for craters or digging, without cooking.
+	 * The region is in collision vertices of this component (inclusive), Heights holds its samples row by row.
+	 * The live heightfields are patched at the end of the frame, physical materials and holes are kept.
+	 */
+	CYLAND_API void SetCollisionHeights(int32 CollisionX1, int32 CollisionY1, int32 CollisionX2, int32 CollisionY2, const uint16* Heights);
+
+	/** Patch the regions changed this frame into the heightfields of all components now instead of at the end of the frame */
+	CYLAND_API static void FlushHeightfieldUpdates();
+
+	/**
+	 * Read back the collision heights the live heightfield was built or patched with, in collision vertex order.
+	 * Works in cooked builds. Returns false while there is no heightfield or only the async cook placeholder.
+	 */
+	CYLAND_API bool GetCollisionHeights(TArray<uint16>& OutHeights) const;
+
 	/** Creates collision object from a cooked collision data */
 	virtual void CreateCollisionObject();
 
+	/** Creates the collision objects from CookedCollisionData, replacing the current ones */
+	virtual void CreateCollisionObjectFromCookedData();
+
 	/** Return the landscape actor associated with this component. */
 	CYLAND_API ACyLandProxy* GetCyLandProxy() const;
 
@@ -240,6 +295,27 @@ public:
 	/** Recreate heightfield and restart physics */
 	CYLAND_API virtual void RecreateCollision();
 
+private:
+	/** Add a region to the ones patched into the heightfields at the end of the frame */
+	void QueueHeightfieldRegion(int32 CollisionX1, int32 CollisionY1, int32 CollisionX2, int32 CollisionY2);
+
+	/** Rebuilds the navigation over bounds whose heights were patched into the heightfield */
+	void DirtyNavigationBounds(const FBox& WorldBounds);
+
+	/** Write the pending region into the complex, simple and editor heightfields */
+	void ApplyPendingHeightfieldRegion();
+
+protected:
+#if WITH_EDITOR
+	/** Start cooking the collision in the thread pool instead of in CreateCollisionObject, returns false if it must be cooked synchronously */
+	bool BeginAsyncCollisionCook(const FName& Format, bool bCheckDDC);
+
+	/** Create a low resolution heightfield without holes to stand in until the async cook finishes */
+	void CreatePlaceholderCollisionObject(const FName& Format);
+#endif
+
+public:
+
 #if WITH_EDITORONLY_DATA
 	// Called from editor code to manage foliage instances on landscape.
 	CYLAND_API void SnapFoliageInstances(const FBox& InInstanceBox);
@@ -0,0 +1,145 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "UObject/Object.h"
+
+#include "CyLandHeightmapAtlas.generated.h"
+
+class ACyLandProxy;
+class UCyLandComponent;
+class UTexture2D;
+struct FCyLandImportHeightmapData;
+
+/**
+ * Paged heightmap storage for runtime-spawned CyLands.
+ *
+ * Regular imports create a heightmap texture per group of components, so a streamed world keeps allocating and
+ * collecting textures as tiles come and go. The atlas instead cuts a few large physical textures into fixed-size
+ * pages, one page per component with its quad mips. A component's page table entry is its heightmap texture and
+ * HeightmapScaleBias, pointing into the physical texture that holds its page.
+ *
+ * Pages are recycled when components are removed or collected. Once every physical texture is allocated, the page
+ * least recently touched is evicted: its component is hidden, its HeightmapScaleBias cleared so the CPU readers of the
+ * heightmap skip it, and it keeps a CPU copy of its page which is uploaded again the next time the component is touched.
+ */
+UCLASS(MinimalAPI)
+class UCyLandHeightmapAtlas : public UObject
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	//~ Begin UObject Interface
+	virtual void BeginDestroy() override;
+	//~ End UObject Interface
+
+	/**
+	 * Set the page layout, must be called before the first page is added.
+	 * @param InPageSize - Texels along one side of a page, the heightmap size of one component
+	 * @param InNumPageMips - Mips stored for each page, the quad mips of the component
+	 * @param InTextureSize - Texels along one side of a physical texture, a power of two multiple of the page size
+	 * @param InMaxTextures - Physical textures allocated before pages get evicted
+	 */
+	CYLAND_API void Initialize(int32 InPageSize, int32 InNumPageMips, int32 InTextureSize, int32 InMaxTextures);
+
+	bool IsInitialized() const { return PageSize > 0; }
+
+#if WITH_EDITOR
+	/**
+	 * Copy the page of a component out of a built import heightmap, make it resident and point the component at it.
+	 * @return false if every slot is in use this frame, the component is then hidden until Update() gives it a slot
+	 */
+	CYLAND_API bool AddPage(UCyLandComponent* Component, const FCyLandImportHeightmapData& Heightmap, int32 HeightmapOffsetX, int32 HeightmapOffsetY);
+
+	/** Make evicted pages touched this frame resident again, at most MaxUploads of them */
+	CYLAND_API void Update(int32 MaxUploads);
+#endif
+
+	/** Free the pages of all the components of a proxy, before it is destroyed */
+	CYLAND_API void RemovePages(ACyLandProxy* Proxy);
+
+	/** Mark the pages of all the components of a proxy as used this frame, evicted pages are uploaded again by Update() */
+	CYLAND_API void TouchPages(ACyLandProxy* Proxy);
+
+	/** Free every page and physical texture */
+	CYLAND_API void Empty();
+
+	int32 GetNumPages() const { return Pages.Num(); }
+	int32 GetNumResidentPages() const { return Pages.Num() - NumEvictedPages; }
+	int32 GetNumPhysicalTextures() const { return PhysicalTextures.Num(); }
+	int32 GetPagesPerTexture() const { return FMath::Square(TextureSize / FMath::Max(PageSize, 1)); }
+
+	/** Log the page usage of the atlas */
+	CYLAND_API void Dump() const;
+
+protected:
+	/** Page table entry of a component */
+	struct FPage
+	{
+		/** Component using the page, the pages of collected components are freed after the garbage collection */
+		TWeakObjectPtr<UCyLandComponent> Component;
+		/** Page texels, all the mips one after the other */
+		TArray<FColor> Texels;
+		/** Atlas slot holding the page, INDEX_NONE while evicted */
+		int32 Slot;
+		/** Frame the page was last touched */
+		uint64 LastUsedFrame;
+		/** Neighbours in the list of resident pages, INDEX_NONE at the ends */
+		int32 PrevResident;
+		int32 NextResident;
+	};
+
+#if WITH_EDITOR
+	/** A free slot, a new physical texture or the slot of the least recently used page not touched this frame */
+	int32 AllocateSlot(ACyLandProxy* TextureOwner);
+
+	/** Write the page into its slot and point the component at it */
+	void UploadPage(int32 PageIndex);
+
+	/** Hide a component and give its slot back */
+	void EvictPage(int32 PageIndex);
+#endif
+
+	/** Move a resident page to the most recently used end of the list, or queue an evicted page for upload */
+	void TouchPage(int32 PageIndex);
+
+	void LinkResidentPage(int32 PageIndex);
+	void UnlinkResidentPage(int32 PageIndex);
+
+	/** Give the slot of a page back and remove it, its page table entry is removed by the caller */
+	void FreePage(int32 PageIndex);
+
+	/** Free the pages of the components collected by the garbage collection */
+	void RemoveStalePages();
+
+	/** Physical textures, cut in (TextureSize / PageSize)^2 slots */
+	UPROPERTY(Transient)
+	TArray<UTexture2D*> PhysicalTextures;
+
+	/** Pages of the components using the atlas, indices are stable */
+	TSparseArray<FPage> Pages;
+
+	/** Page of each component, the components are kept alive by their proxies */
+	TMap<TWeakObjectPtr<UCyLandComponent>, int32> PageTable;
+
+	/** Resident pages from the most to the least recently touched, eviction takes the tail */
+	int32 MostRecentlyUsedPage;
+	int32 LeastRecentlyUsedPage;
+
+	/** Evicted pages touched since the last Update() */
+	TArray<int32> PendingUploads;
+
+	/** Page held by each slot, INDEX_NONE for free slots */
+	TArray<int32> SlotPages;
+	TArray<int32> FreeSlots;
+
+	FDelegateHandle PostGarbageCollectHandle;
+
+	int32 PageSize;
+	int32 NumPageMips;
+	int32 TextureSize;
+	int32 MaxTextures;
+	int32 NumEvictedPages;
+};
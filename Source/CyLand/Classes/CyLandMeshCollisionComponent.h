@@ -99,12 +99,14 @@ public:
 	virtual void ExportCustomProperties(FOutputDevice& Out, uint32 Indent) override;
 	virtual void ImportCustomProperties(const TCHAR* SourceText, FFeedbackContext* Warn) override;
 
-	virtual bool CookCollisionData(const FName& Format, bool bUseOnlyDefMaterial, bool bCheckDDC, TArray<uint8>& OutCookedData, TArray<UPhysicalMaterial*>& InOutMaterials) const override;
+	virtual bool GatherCollisionCookJob(const FName& Format, bool bUseOnlyDefMaterial, FCyLandCollisionCookJob& OutJob, TArray<UPhysicalMaterial*>& InOutMaterials) const override;
+	virtual const FGuid& GetCollisionDataGuid() const override { return MeshGuid; }
 #endif
 	//~ End UObject Interface.
 
 	//~ Begin UCyLandHeightfieldCollisionComponent Interface
 	virtual void CreateCollisionObject() override;
+	virtual void CreateCollisionObjectFromCookedData() override;
 	virtual void RecreateCollision() override;
 	//~ End UCyLandHeightfieldCollisionComponent Interface
 };
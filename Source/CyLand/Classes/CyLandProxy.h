@@ -31,6 +31,7 @@ class UPhysicalMaterial;
 class USplineComponent;
 class UTexture2D;
 struct FAsyncGrassBuilder;
+class FCyLandGrassJob;
 struct FCyLandInfoLayerSettings;
 struct FMeshDescription;
 enum class ENavDataGatheringMode : uint8;
@@ -334,6 +335,8 @@ public:
 	~FCyAsyncGrassTask();
 };
 
+typedef TSharedRef<FCyLandGrassJob, ESPMode::ThreadSafe> FCyLandGrassJobRef;
+
 USTRUCT()
 struct FCyLandProxyMaterialOverride
 {
@@ -540,8 +543,8 @@ public:
 
 	/** A transient data structure for tracking the grass */
 	FCachedCyLandFoliage FoliageCache;
-	/** A transient data structure for tracking the grass tasks*/
-	TArray<FAsyncTask<FCyAsyncGrassTask>* > AsyncFoliageTasks;
+	/** A transient data structure for tracking the grass tasks, run by FCyLandGrassScheduler */
+	TArray<FCyLandGrassJobRef> AsyncFoliageTasks;
 	/** Frame offset for tick interval*/
 	uint32 FrameOffsetForTickInterval;
 
@@ -902,6 +905,13 @@ public:
 							const uint16* HeightData, const TCHAR* HeightmapFileName,
 							const TArray<FCyLandImportLayerInfo>& ImportLayerInfos, ECyLandImportAlphamapType ImportLayerType);
 
+	/**
+	 * Create the components and textures of an import whose CPU stage was already built, possibly on a worker thread.
+	 * This is the game thread half of Imports().
+	 * @param HeightmapAtlas - If set, the components get pages of the atlas instead of heightmap textures of their own
+	 */
+	CYLAND_API void ImportsFromPayload(FGuid Guid, struct FCyLandImportPayload& Payload, const TCHAR* HeightmapFileName, const TArray<FCyLandImportLayerInfo>& ImportLayerInfos, class UCyLandHeightmapAtlas* HeightmapAtlas = nullptr);
+
 	/**
 	 * Exports landscape into raw mesh
 	 * 
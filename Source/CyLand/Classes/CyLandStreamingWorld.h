@@ -0,0 +1,171 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "GameFramework/Actor.h"
+#include "Async/AsyncWork.h"
+#include "CyLandStreamingWorld.generated.h"
+
+class ACyLand;
+class ACyLandStreamingProxy;
+class UCyLandHeightmapAtlas;
+class UMaterialInterface;
+class FCyLandImportTask;
+struct FCyLandImportPayload;
+
+/**
+ * Runtime streamer for unbounded procedural CyLands.
+ *
+ * Instead of importing the whole world up front, the streamer owns an empty ACyLand that acts as the
+ * shared parent (guid, transform, material) and keeps a ring of ACyLandStreamingProxy tiles around the
+ * viewers. Tiles are created/imported and destroyed under a per-frame budget so resident memory only
+ * depends on the streaming radius, not on the size of the world. The CPU side of a tile import (normals,
+ * texture payloads, mips) runs in the thread pool; only the UObject creation is left to the game thread.
+ *
+ * Tiles are imported with the editor-only import path of ACyLandProxy, so streaming only works in builds with
+ * editor data (the editor, PIE, -game from the editor). Packaged builds never load a tile and log a warning once.
+ */
+UCLASS(MinimalAPI, notplaceable, hidecategories=(Input, Replication))
+class ACyLandStreamingWorld : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACyLandStreamingWorld(const FObjectInitializer& ObjectInitializer);
+
+	/** Material assigned to the parent CyLand and every streamed tile */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=CyLand)
+	UMaterialInterface* CyLandMaterial;
+
+	/** Number of subsections per component (1 or 2) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=CyLand, meta=(ClampMin="1", ClampMax="2"))
+	int32 SectionsPerComponent;
+
+	/** Number of quads per component, must be (SectionsPerComponent * (power of two - 1)) */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=CyLand)
+	int32 QuadsPerComponent;
+
+	/** Number of components along one side of a streamed tile */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=CyLand, meta=(ClampMin="1"))
+	int32 ComponentsPerTile;
+
+	/** Tiles whose center is closer than this distance (in world units) to a viewer are loaded */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming)
+	float StreamingDistance;
+
+	/** Loaded tiles are only destroyed once they are further than StreamingDistance * UnloadDistanceScale, to avoid thrashing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="1.0"))
+	float UnloadDistanceScale;
+
+	/** Maximum number of tiles created per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="1"))
+	int32 MaxTileLoadsPerFrame;
+
+	/** Maximum number of tiles whose import payload is built in the thread pool at the same time */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="1"))
+	int32 MaxPendingTileBuilds;
+
+	/** Maximum number of tiles destroyed per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="1"))
+	int32 MaxTileUnloadsPerFrame;
+
+	/** Time budget in milliseconds for tile work per frame; the first tile of a frame is always processed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="0.0"))
+	float StreamingBudgetMs;
+
+	/** Number of unloaded tiles after which a garbage collection is requested, 0 disables */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Streaming, meta=(ClampMin="0"))
+	int32 UnloadsBeforeGarbageCollect;
+
+	/**
+	 * Store the heightmaps of the streamed components as pages of a few shared atlas textures instead of creating
+	 * heightmap textures for every tile. Must be set before InitializeWorld.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=HeightmapAtlas)
+	bool bUseHeightmapAtlas;
+
+	/** Size of the atlas textures, rounded up to a power of two */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=HeightmapAtlas, meta=(ClampMin="256", ClampMax="8192", EditCondition="bUseHeightmapAtlas"))
+	int32 HeightmapAtlasTextureSize;
+
+	/** Atlas textures allocated before the pages of the components least recently within the streaming distance are evicted */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=HeightmapAtlas, meta=(ClampMin="1", EditCondition="bUseHeightmapAtlas"))
+	int32 MaxHeightmapAtlasTextures;
+
+	/** Maximum number of evicted pages uploaded again per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=HeightmapAtlas, meta=(ClampMin="1", EditCondition="bUseHeightmapAtlas"))
+	int32 MaxHeightmapAtlasUploadsPerFrame;
+
+	/** Set up the parent CyLand. Must be called once before the streamer starts ticking. */
+	CYLAND_API void InitializeWorld();
+
+	/** Unload every streamed tile and the parent CyLand */
+	CYLAND_API void UnloadAllTiles();
+
+	/** Number of tile quads along one side */
+	int32 GetTileSizeQuads() const { return ComponentsPerTile * QuadsPerComponent; }
+
+	/** The parent CyLand shared by every tile */
+	ACyLand* GetCyLand() const { return CyLand; }
+
+	/** The heightmap atlas of the streamed tiles, nullptr unless bUseHeightmapAtlas */
+	UCyLandHeightmapAtlas* GetHeightmapAtlas() const { return HeightmapAtlas; }
+
+	/** Number of tiles currently resident */
+	UFUNCTION(BlueprintCallable, Category="CyLand|Streaming")
+	int32 GetNumLoadedTiles() const { return LoadedTiles.Num(); }
+
+	/**
+	 * Fill the height data for a tile. Heights must be a pure function of the global vertex coordinates
+	 * so that border vertices shared by neighboring tiles match.
+	 * @param TileBase - Global vertex coordinates of the first vertex of the tile
+	 * @param NumVerts - Number of vertices along one side of the tile
+	 * @param OutHeights - NumVerts * NumVerts heights, row major
+	 */
+	virtual void GenerateTileHeightData(const FIntPoint& TileBase, int32 NumVerts, TArray<uint16>& OutHeights) const;
+
+	//~ Begin AActor Interface
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//~ End AActor Interface
+
+protected:
+	/** Gather the locations used to drive the streaming ring */
+	void GetViewerLocations(TArray<FVector>& OutLocations) const;
+
+	/** World space center of a tile */
+	FVector GetTileCenter(const FIntPoint& Tile) const;
+
+	/** Generate the heights of a tile and start building its import payload in the thread pool */
+	bool BeginTileBuild(const FIntPoint& Tile);
+
+	/** Drop every tile build still in flight, waiting for the ones that already started */
+	void CancelPendingTiles();
+
+#if WITH_EDITOR
+	/** Spawn the proxy of a tile from its built payload */
+	ACyLandStreamingProxy* LoadTile(const FIntPoint& Tile, FCyLandImportPayload& Payload);
+#endif
+
+	void UnloadTile(ACyLandStreamingProxy* Proxy);
+
+	UPROPERTY(Transient)
+	ACyLand* CyLand;
+
+	/** Heightmap pages of the streamed components, if bUseHeightmapAtlas */
+	UPROPERTY(Transient)
+	UCyLandHeightmapAtlas* HeightmapAtlas;
+
+	/** Resident tiles by tile coordinate, referenced so a tile destroyed by something else is nulled rather than dangling */
+	UPROPERTY(Transient)
+	TMap<FIntPoint, ACyLandStreamingProxy*> LoadedTiles;
+
+#if WITH_EDITOR
+	/** Tiles whose import payload is being built, owned by the streamer */
+	TMap<FIntPoint, FAsyncTask<FCyLandImportTask>*> PendingTiles;
+#endif
+
+	int32 UnloadsSinceGarbageCollect;
+};
@@ -80,6 +80,7 @@ public class CyLand : ModuleRules
                     "RHI",
                     "Renderer",
                     "Landscape",
+                    "NavigationSystem",
                 }
             );
         //PrivateDependencyModuleNames.Add("CyLandEditor");
@@ -45,10 +45,13 @@ CyLand.cpp: Terrain rendering
 #include "Materials/MaterialInstanceDynamic.h"
 #include "ProfilingDebugging/CookStats.h"
 #include "CyLandSplinesComponent.h"
+#include "CyLandGrassScheduler.h"
 #include "EngineGlobals.h"
 #include "Engine/Engine.h"
 #include "EngineUtils.h"
 #include "ComponentRecreateRenderStateContext.h"
+#include "Async/ParallelFor.h"
+#include "CyLandPlatformData.h"
 
 
 #include "MUtils.h"
@@ -70,6 +73,7 @@ DEFINE_STAT(STAT_CyLandInitViewCustomData);
 DEFINE_STAT(STAT_CyLandPostInitViewCustomData);
 DEFINE_STAT(STAT_CyLandComputeCustomMeshBatchLOD);
 DEFINE_STAT(STAT_CyLandComputeCustomShadowMeshBatchLOD);
+DEFINE_STAT(STAT_CyLandIndexBufferCreation);
 DEFINE_STAT(STAT_CyLandVFDrawTimePS);
 DEFINE_STAT(STAT_CyLandComponentRenderPasses);
 DEFINE_STAT(STAT_CyLandTessellatedShadowCascade);
@@ -85,8 +89,11 @@ DEFINE_STAT(STAT_CyLandRegenerateProceduralHeightmapsDrawCalls);
 
 DEFINE_STAT(STAT_CyLandVertexMem);
 DEFINE_STAT(STAT_CyLandOccluderMem);
+DEFINE_STAT(STAT_CyLandIndexMem);
 DEFINE_STAT(STAT_CyLandComponentMem);
 
+DECLARE_CYCLE_STAT(TEXT("Generate Platform Data"), STAT_CyLandGeneratePlatformData, STATGROUP_Landscape);
+
 #if ENABLE_COOK_STATS
 namespace CyLandCookStats
 {
@@ -220,30 +227,37 @@ void UCyLandComponent::AddReferencedObjects(UObject* InThis, FReferenceCollector
 }
 
 #if WITH_EDITOR
+static TAutoConsoleVariable<int32> CVarCyLandParallelPlatformData(
+	TEXT("cyland.ParallelPlatformData"),
+	1,
+	TEXT("1: The mobile vertex data of the outdated components of a proxy is generated, compressed and saved to the DDC on worker threads, and their weightmap textures are built together; 0: one component after another on the game thread"));
+
 void UCyLandComponent::BeginCacheForCookedPlatformData(const ITargetPlatform* TargetPlatform)
 {
 	Super::BeginCacheForCookedPlatformData(TargetPlatform);
 
 	if (TargetPlatform->SupportsFeature(ETargetPlatformFeatures::MobileRendering) && !HasAnyFlags(RF_ClassDefaultObject))
 	{
-		CheckGenerateCyLandPlatformData(true, TargetPlatform);
+		// The first outdated component regenerates its whole proxy in one batch, the next ones then find their data up to date
+		ACyLandProxy* Proxy = GetCyLandProxy();
+		if (Proxy && CVarCyLandParallelPlatformData.GetValueOnGameThread() != 0 && MobileDataSourceHash != ComputeMobileDataSourceHash())
+		{
+			Proxy->CheckGenerateCyLandPlatformData(true, TargetPlatform);
+		}
+		else
+		{
+			CheckGenerateCyLandPlatformData(true, TargetPlatform);
+		}
 	}
 }
 
 void ACyLandProxy::CheckGenerateCyLandPlatformData(bool bIsCooking, const ITargetPlatform* TargetPlatform)
 {
-	for (UCyLandComponent* Component : CyLandComponents)
-	{
-		Component->CheckGenerateCyLandPlatformData(bIsCooking, TargetPlatform);
-	}
+	UCyLandComponent::CheckGenerateCyLandPlatformData(CyLandComponents, bIsCooking, TargetPlatform);
 }
 
-void UCyLandComponent::CheckGenerateCyLandPlatformData(bool bIsCooking, const ITargetPlatform* TargetPlatform)
+FGuid UCyLandComponent::ComputeMobileDataSourceHash()
 {
-#if ENABLE_LANDSCAPE_COOKING
-	
-	// Regenerate platform data only when it's missing or there is a valid hash-mismatch.
-
 	FBufferArchive ComponentStateAr;
 	SerializeStateHashes(ComponentStateAr);
 
@@ -253,50 +267,245 @@ void UCyLandComponent::CheckGenerateCyLandPlatformData(bool bIsCooking, const IT
 	
 	uint32 Hash[5];
 	FSHA1::HashBuffer(ComponentStateAr.GetData(), ComponentStateAr.Num(), (uint8*)Hash);
-	FGuid NewSourceHash = FGuid(Hash[0] ^ Hash[4], Hash[1], Hash[2], Hash[3]);
+	return FGuid(Hash[0] ^ Hash[4], Hash[1], Hash[2], Hash[3]);
+}
 
-	bool bHashMismatch = MobileDataSourceHash != NewSourceHash;
-	bool bMissingVertexData = !PlatformData.HasValidPlatformData();
-	bool bMissingPixelData = MobileMaterialInterfaces.Num() == 0 || MobileWeightmapTextures.Num() == 0 || MaterialPerLOD.Num() == 0;
+void UCyLandComponent::CheckGenerateCyLandPlatformData(bool bIsCooking, const ITargetPlatform* TargetPlatform)
+{
+	CheckGenerateCyLandPlatformData(TArray<UCyLandComponent*>({ this }), bIsCooking, TargetPlatform);
+}
 
-	bool bRegenerateVertexData = bMissingVertexData || bMissingPixelData || bHashMismatch;
-	
-	if (bRegenerateVertexData)
+namespace CyLandPlatformDataBatch
+{
+	/** Mobile data of one outdated component */
+	struct FJob
+	{
+		FJob()
+			: Component(nullptr)
+			, bRegeneratePixelData(false)
+			, bLoadedFromDDC(false)
+			, LoadSeconds(0.0)
+			, GenerateSeconds(0.0)
+			, CompressSeconds(0.0)
+			, SaveSeconds(0.0)
+		{}
+
+		UCyLandComponent* Component;
+		FGuid SourceHash;
+		bool bRegeneratePixelData;
+		bool bLoadedFromDDC;
+
+		/** Set on the game thread when the vertex data has to be generated */
+		TUniquePtr<FCyLandPlatformVertexSource> VertexSource;
+		FCyLandComponentDerivedData PlatformData;
+
+		/** Thread time of the stages run on worker threads */
+		double LoadSeconds;
+		double GenerateSeconds;
+		double CompressSeconds;
+		double SaveSeconds;
+	};
+}
+
+void UCyLandComponent::CheckGenerateCyLandPlatformData(const TArray<UCyLandComponent*>& Components, bool bIsCooking, const ITargetPlatform* TargetPlatform)
+{
+#if ENABLE_LANDSCAPE_COOKING
+	using namespace CyLandPlatformDataBatch;
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandGeneratePlatformData);
+
+	const bool bParallel = CVarCyLandParallelPlatformData.GetValueOnGameThread() != 0;
+	const double StartTime = FPlatformTime::Seconds();
+	double StageStartTime = StartTime;
+
+	// Regenerate platform data only when it's missing or there is a valid hash-mismatch.
+	TArray<FJob> Jobs;
+	for (UCyLandComponent* Component : Components)
+	{
+		if (!Component)
+		{
+			continue;
+		}
+
+		const FGuid NewSourceHash = Component->ComputeMobileDataSourceHash();
+		const bool bHashMismatch = Component->MobileDataSourceHash != NewSourceHash;
+		const bool bMissingVertexData = !Component->PlatformData.HasValidPlatformData();
+		const bool bMissingPixelData = Component->MobileMaterialInterfaces.Num() == 0 || Component->MobileWeightmapTextures.Num() == 0 || Component->MaterialPerLOD.Num() == 0;
+
+		if (bMissingVertexData || bMissingPixelData || bHashMismatch)
+		{
+			FJob& Job = Jobs[Jobs.AddDefaulted()];
+			Job.Component = Component;
+			Job.SourceHash = NewSourceHash;
+			Job.bRegeneratePixelData = bMissingPixelData || bHashMismatch;
+		}
+	}
+
+	if (Jobs.Num() == 0)
+	{
+		return;
+	}
+
+	const double CheckTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	const auto ForEachJob = [bParallel, &Jobs](TFunctionRef<void(FJob&)> Body)
+	{
+		ParallelFor(Jobs.Num(), [&Jobs, &Body](int32 JobIndex)
+		{
+			Body(Jobs[JobIndex]);
+		}, !bParallel);
+	};
+
+	// The DDC is only useful when cooking. When not cooking (e.g. mobile preview) DDC data isn't sufficient to
+	// display correctly, so the platform vertex data must be regenerated.
+	if (bIsCooking)
+	{
+		ForEachJob([](FJob& Job)
+		{
+			const double JobStartTime = FPlatformTime::Seconds();
+			Job.bLoadedFromDDC = Job.PlatformData.LoadFromDDC(Job.SourceHash);
+			Job.LoadSeconds = FPlatformTime::Seconds() - JobStartTime;
+		});
+	}
+
+	const double LoadTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	// Texture sources can only be read on the game thread, the components of a heightmap share the copy of its mips
+	TMap<UTexture2D*, FCyLandPlatformHeightmapMipsPtr> MipCache;
+	TMap<FIntPoint, TArray<FCyLandVertexRef>> VertexOrders;
+	for (FJob& Job : Jobs)
+	{
+		if (!Job.bLoadedFromDDC && !Job.Component->IsTemplate())
+		{
+			Job.VertexSource = MakeUnique<FCyLandPlatformVertexSource>(Job.Component, TargetPlatform, &MipCache);
+
+			const FIntPoint Layout(Job.VertexSource->SubsectionSizeQuads, Job.VertexSource->NumSubsections);
+			if (!VertexOrders.Contains(Layout))
+			{
+				CyLandPlatformData::BuildVertexOrder(Layout.X, Layout.Y, VertexOrders.Add(Layout));
+			}
+		}
+	}
+
+	const double GatherTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	ForEachJob([bIsCooking, &VertexOrders](FJob& Job)
 	{
+		if (!Job.VertexSource)
+		{
+			return;
+		}
+
+		double JobStageTime = FPlatformTime::Seconds();
+		TArray<uint8> NewPlatformData;
+		const FIntPoint Layout(Job.VertexSource->SubsectionSizeQuads, Job.VertexSource->NumSubsections);
+		CyLandPlatformData::BuildVertexData(*Job.VertexSource, VertexOrders.FindChecked(Layout), NewPlatformData);
+		Job.GenerateSeconds = FPlatformTime::Seconds() - JobStageTime;
+
+		JobStageTime = FPlatformTime::Seconds();
+		Job.PlatformData.InitializeFromUncompressedData(NewPlatformData);
+		Job.CompressSeconds = FPlatformTime::Seconds() - JobStageTime;
+
 		if (bIsCooking)
 		{
-			// The DDC is only useful when cooking (see else).
+			JobStageTime = FPlatformTime::Seconds();
+			Job.PlatformData.SaveToDDC(Job.SourceHash);
+			Job.SaveSeconds = FPlatformTime::Seconds() - JobStageTime;
+		}
+	});
+
+	const double GenerateTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	int32 NumDDCHits = 0;
+	int32 NumGenerated = 0;
+	double TotalLoadSeconds = 0.0;
+	double TotalGenerateSeconds = 0.0;
+	double TotalCompressSeconds = 0.0;
+	double TotalSaveSeconds = 0.0;
+	for (FJob& Job : Jobs)
+	{
+		if (!Job.PlatformData.HasValidPlatformData())
+		{
+			continue;
+		}
 
+		if (bIsCooking)
+		{
+			// Only counts hits and misses, the time is in the log below
 			COOK_STAT(auto Timer = CyLandCookStats::UsageStats.TimeSyncWork());
-			if (PlatformData.LoadFromDDC(NewSourceHash))
+			if (Job.bLoadedFromDDC)
 			{
-				COOK_STAT(Timer.AddHit(PlatformData.GetPlatformDataSize()));
+				COOK_STAT(Timer.AddHit(Job.PlatformData.GetPlatformDataSize()));
 			}
 			else
 			{
-				GeneratePlatformVertexData(TargetPlatform);
-				PlatformData.SaveToDDC(NewSourceHash);
-				COOK_STAT(Timer.AddMiss(PlatformData.GetPlatformDataSize()));
+				COOK_STAT(Timer.AddMiss(Job.PlatformData.GetPlatformDataSize()));
 			}
 		}
-		else
-		{
-			// When not cooking (e.g. mobile preview) DDC data isn't sufficient to 
-			// display correctly, so the platform vertex data must be regenerated.
 
-			GeneratePlatformVertexData(TargetPlatform);
+		NumDDCHits += Job.bLoadedFromDDC ? 1 : 0;
+		NumGenerated += Job.bLoadedFromDDC ? 0 : 1;
+		TotalLoadSeconds += Job.LoadSeconds;
+		TotalGenerateSeconds += Job.GenerateSeconds;
+		TotalCompressSeconds += Job.CompressSeconds;
+		TotalSaveSeconds += Job.SaveSeconds;
+
+		Job.Component->PlatformData = MoveTemp(Job.PlatformData);
+	}
+
+	// Textures and materials are UObjects and stay on the game thread, but the weightmap textures of all the
+	// components are built together in the thread pool
+	TArray<UTexture2D*> PendingTextures;
+	int32 NumPixelDataJobs = 0;
+	for (FJob& Job : Jobs)
+	{
+		if (Job.bRegeneratePixelData)
+		{
+			Job.Component->GenerateMobileWeightmapTextures(bParallel ? &PendingTextures : nullptr);
+			NumPixelDataJobs++;
 		}
 	}
 
-	bool bRegeneratePixelData = bMissingPixelData || bHashMismatch;
+	for (UTexture2D* Texture : PendingTextures)
+	{
+		Texture->FinishCachePlatformData();
+		Texture->PostEditChange();
+	}
 
-	if (bRegeneratePixelData)
+	const double TexturesTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	for (FJob& Job : Jobs)
 	{
-		GeneratePlatformPixelData();
+		if (Job.bRegeneratePixelData)
+		{
+			Job.Component->GenerateMobileMaterialInstances();
+		}
+
+		Job.Component->MobileDataSourceHash = Job.SourceHash;
 	}
 
-	MobileDataSourceHash = NewSourceHash;
+	const double MaterialsTime = FPlatformTime::Seconds() - StageStartTime;
+	const double TotalTime = FPlatformTime::Seconds() - StartTime;
+
+	const FString Report = FString::Printf(
+		TEXT("Mobile data of %d/%d components in %.2f ms: check %.2f ms, DDC load %.2f ms (%d hits, %.2f ms thread time), gather %.2f ms, ")
+		TEXT("vertex data of %d components %.2f ms (thread time: generate %.2f ms, compress %.2f ms, DDC save %.2f ms), weightmaps of %d components %.2f ms, materials %.2f ms"),
+		Jobs.Num(), Components.Num(), TotalTime * 1000.0, CheckTime * 1000.0, LoadTime * 1000.0, NumDDCHits, TotalLoadSeconds * 1000.0, GatherTime * 1000.0,
+		NumGenerated, GenerateTime * 1000.0, TotalGenerateSeconds * 1000.0, TotalCompressSeconds * 1000.0, TotalSaveSeconds * 1000.0, NumPixelDataJobs, TexturesTime * 1000.0, MaterialsTime * 1000.0);
 
+	if (Jobs.Num() > 1)
+	{
+		UE_LOG(LogCyLand, Log, TEXT("%s"), *Report);
+	}
+	else
+	{
+		UE_LOG(LogCyLand, Verbose, TEXT("%s"), *Report);
+	}
 #endif
 }
 #endif
@@ -404,6 +613,13 @@ void UCyLandComponent::Serialize(FArchive& Ar)
 		else
 		{
 			Ar << GrassData.Get();
+#if !WITH_EDITOR
+			if (Ar.IsLoading())
+			{
+				// editor builds compress in PostLoad, cooked grass maps have to be compressed here
+				GrassData->ConditionalCompress();
+			}
+#endif
 		}
 	}
 
@@ -845,6 +1061,7 @@ void UCyLandComponent::PostLoad()
 	}
 
 	GrassData->ConditionalDiscardDataOnLoad();
+	GrassData->ConditionalCompress();
 }
 
 #endif // WITH_EDITOR
@@ -1503,6 +1720,15 @@ void ACyLandProxy::PreSave(const class ITargetPlatform* TargetPlatform)
 	if (!HasAnyFlags(RF_ClassDefaultObject))
 	{
 		bHasCyLandGrass = CyLandComponents.ContainsByPredicate([](UCyLandComponent* Component) { return Component->MaterialHasGrass(); });
+
+		// and which paint layers the grass reads, so cooked builds can evaluate the grass maps without the material graph
+		for (UCyLandComponent* Component : CyLandComponents)
+		{
+			if (Component)
+			{
+				Component->UpdateCPUGrassLayers();
+			}
+		}
 	}
 
 	if (GetMutableDefault<UEditorExperimentalSettings>()->bProceduralLandscape)
@@ -2842,12 +3068,9 @@ void ACyLandProxy::TickActor(float DeltaTime, ELevelTick TickType, FActorTickFun
 
 ACyLandProxy::~ACyLandProxy()
 {
-	for (int32 Index = 0; Index < AsyncFoliageTasks.Num(); Index++)
+	for (const FCyLandGrassJobRef& Task : AsyncFoliageTasks)
 	{
-		FAsyncTask<FCyAsyncGrassTask>* Task = AsyncFoliageTasks[Index];
-		Task->EnsureCompletion(true);
-		FCyAsyncGrassTask& Inner = Task->GetTask();
-		delete Task;
+		FCyLandGrassScheduler::Get().Abandon(Task);
 	}
 	AsyncFoliageTasks.Empty();
 
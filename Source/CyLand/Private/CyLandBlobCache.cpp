@@ -0,0 +1,330 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandBlobCache.cpp: Content-addressed store of derived data blobs
+=============================================================================*/
+
+#include "CyLandBlobCache.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCyLandBlobCache, Log, All);
+
+namespace CyLandBlobCache
+{
+	/** Header of the files of the disk store, the blob follows it */
+	struct FDiskHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		int32 BlobSize;
+		uint8 BlobHash[20];
+	};
+}
+
+FCyLandBlobCache::FCyLandBlobCache(const TCHAR* InName, const TCHAR* InCVarPrefix, const TCHAR* InDiskDirectory, const TCHAR* InDiskExtension, uint32 InDiskMagic, uint32 InDiskVersion,
+	bool bUseDiskStoreByDefault, TFunction<void(int64, int32)> InUpdateStats)
+	: Name(InName)
+	, UpdateStats(MoveTemp(InUpdateStats))
+	, DiskDirectory(InDiskDirectory)
+	, DiskExtension(InDiskExtension)
+	, DiskMagic(InDiskMagic)
+	, DiskVersion(InDiskVersion)
+	, TotalBytes(0)
+	, DiskBytes(0)
+	, bDiskScanned(false)
+	, NumMemoryHits(0)
+	, NumDiskHits(0)
+	, NumMisses(0)
+	, NumCorruptFiles(0)
+{
+	const FString Prefix(InCVarPrefix);
+	IConsoleManager& ConsoleManager = IConsoleManager::Get();
+
+	EnableCVar = ConsoleManager.RegisterConsoleVariable(*(Prefix + TEXT(".Enable")), 1,
+		*FString::Printf(TEXT("1: Reuse the blobs of the %s when the inputs are the same; 0: Always rebuild"), InName));
+	MemoryBudgetMBCVar = ConsoleManager.RegisterConsoleVariable(*(Prefix + TEXT(".MemoryBudgetMB")), 64,
+		*FString::Printf(TEXT("Memory budget of the %s in MB, the least recently used blobs are evicted first."), InName));
+	DiskBudgetMBCVar = ConsoleManager.RegisterConsoleVariable(*(Prefix + TEXT(".DiskBudgetMB")), 1024,
+		*FString::Printf(TEXT("Size budget of Saved/%s in MB, the least recently used files are deleted once it's exceeded."), InDiskDirectory));
+	UseDiskStoreCVar = ConsoleManager.RegisterConsoleVariable(*(Prefix + TEXT(".UseDiskStore")), bUseDiskStoreByDefault ? 1 : 0,
+		*FString::Printf(TEXT("1: Also keep the blobs of the %s in Saved/%s so they survive the session; 0: Memory only"), InName, InDiskDirectory));
+
+	FlushCommand = ConsoleManager.RegisterConsoleCommand(*(Prefix + TEXT(".Flush")),
+		*FString::Printf(TEXT("Drop every blob of the %s kept in memory, the disk store is left alone."), InName),
+		FConsoleCommandDelegate::CreateRaw(this, &FCyLandBlobCache::Flush));
+	DumpCommand = ConsoleManager.RegisterConsoleCommand(*(Prefix + TEXT(".Dump")),
+		*FString::Printf(TEXT("Print the size and hit rate of the %s."), InName),
+		FConsoleCommandDelegate::CreateRaw(this, &FCyLandBlobCache::LogStats));
+}
+
+FCyLandBlobCache::~FCyLandBlobCache()
+{
+	for (IConsoleObject* ConsoleObject : { (IConsoleObject*)EnableCVar, (IConsoleObject*)MemoryBudgetMBCVar, (IConsoleObject*)DiskBudgetMBCVar, (IConsoleObject*)UseDiskStoreCVar,
+		(IConsoleObject*)FlushCommand, (IConsoleObject*)DumpCommand })
+	{
+		IConsoleManager::Get().UnregisterConsoleObject(ConsoleObject, false);
+	}
+}
+
+bool FCyLandBlobCache::IsEnabled() const
+{
+	return EnableCVar->GetInt() != 0;
+}
+
+int64 FCyLandBlobCache::GetMemoryBudgetBytes() const
+{
+	return (int64)MemoryBudgetMBCVar->GetInt() * 1024 * 1024;
+}
+
+int64 FCyLandBlobCache::GetDiskBudgetBytes() const
+{
+	return (int64)DiskBudgetMBCVar->GetInt() * 1024 * 1024;
+}
+
+bool FCyLandBlobCache::UseDiskStore() const
+{
+	return UseDiskStoreCVar->GetInt() != 0;
+}
+
+bool FCyLandBlobCache::Find(const FSHAHash& Key, TArray<uint8>& OutBlob)
+{
+	using namespace CyLandBlobCache;
+
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (FEntry* Entry = Entries.Find(Key))
+		{
+			TouchInMemory(*Entry);
+			OutBlob = Entry->Blob;
+			NumMemoryHits++;
+			return true;
+		}
+	}
+
+	if (UseDiskStore())
+	{
+		TArray<uint8> FileData;
+		const FString Path = GetDiskPath(Key);
+		const int32 HeaderSize = sizeof(FDiskHeader);
+		if (FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent) && FileData.Num() >= HeaderSize)
+		{
+			FDiskHeader Header;
+			FMemory::Memcpy(&Header, FileData.GetData(), HeaderSize);
+			if (Header.Magic == DiskMagic && Header.Version == DiskVersion)
+			{
+				// A truncated or damaged file is dropped and the blob built again
+				FSHAHash BlobHash;
+				const int32 BlobSize = FileData.Num() - HeaderSize;
+				FSHA1::HashBuffer(FileData.GetData() + HeaderSize, BlobSize, BlobHash.Hash);
+				if (Header.BlobSize != BlobSize || FMemory::Memcmp(Header.BlobHash, BlobHash.Hash, sizeof(BlobHash.Hash)) != 0)
+				{
+					UE_LOG(LogCyLandBlobCache, Warning, TEXT("%s: Deleting corrupt file %s"), *Name, *Path);
+					IFileManager::Get().Delete(*Path, false, false, true);
+
+					FScopeLock ScopeLock(&Lock);
+					NumCorruptFiles++;
+					NumMisses++;
+					return false;
+				}
+
+				// The file time is what orders the disk store for trimming in later sessions
+				IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+				TouchOnDisk(Path, FileData.Num());
+
+				OutBlob.Reset(BlobSize);
+				OutBlob.Append(FileData.GetData() + HeaderSize, BlobSize);
+
+				TArray<uint8> Blob(OutBlob);
+				FScopeLock ScopeLock(&Lock);
+				NumDiskHits++;
+				AddToMemory(Key, MoveTemp(Blob));
+				return true;
+			}
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	NumMisses++;
+	return false;
+}
+
+void FCyLandBlobCache::Add(const FSHAHash& Key, TArray<uint8>&& Blob)
+{
+	using namespace CyLandBlobCache;
+
+	if (UseDiskStore())
+	{
+		FDiskHeader Header;
+		Header.Magic = DiskMagic;
+		Header.Version = DiskVersion;
+		Header.BlobSize = Blob.Num();
+		FSHA1::HashBuffer(Blob.GetData(), Blob.Num(), Header.BlobHash);
+
+		TArray<uint8> FileData;
+		FileData.Reserve(sizeof(FDiskHeader) + Blob.Num());
+		FileData.Append((const uint8*)&Header, sizeof(FDiskHeader));
+		FileData.Append(Blob);
+
+		// Write to a temp file first so a concurrent reader never sees a partial file
+		const FString Path = GetDiskPath(Key);
+		const FString TempPath = Path + FString::Printf(TEXT(".%u.tmp"), FPlatformTLS::GetCurrentThreadId());
+		if (FFileHelper::SaveArrayToFile(FileData, *TempPath))
+		{
+			if (IFileManager::Get().Move(*Path, *TempPath, true, true, false, true))
+			{
+				TouchOnDisk(Path, FileData.Num());
+			}
+			else
+			{
+				IFileManager::Get().Delete(*TempPath, false, false, true);
+			}
+		}
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	AddToMemory(Key, MoveTemp(Blob));
+}
+
+void FCyLandBlobCache::AddToMemory(const FSHAHash& Key, TArray<uint8>&& Blob)
+{
+	const int64 BudgetBytes = FMath::Max<int64>(GetMemoryBudgetBytes(), 0);
+	if (Blob.Num() > BudgetBytes)
+	{
+		return;
+	}
+
+	FEntry* Entry = Entries.Find(Key);
+	if (Entry)
+	{
+		TotalBytes -= Entry->Blob.Num();
+	}
+	else
+	{
+		Entry = &Entries.Add(Key);
+		LRUList.AddHead(Key);
+		Entry->LRUNode = LRUList.GetHead();
+	}
+	Entry->Blob = MoveTemp(Blob);
+	TouchInMemory(*Entry);
+	TotalBytes += Entry->Blob.Num();
+
+	TrimToBudget(BudgetBytes);
+}
+
+void FCyLandBlobCache::TouchInMemory(FEntry& Entry)
+{
+	if (Entry.LRUNode != LRUList.GetHead())
+	{
+		LRUList.RemoveNode(Entry.LRUNode, false);
+		LRUList.AddHead(Entry.LRUNode);
+	}
+}
+
+void FCyLandBlobCache::TrimToBudget(int64 BudgetBytes)
+{
+	while (TotalBytes > BudgetBytes && LRUList.Num() > 0)
+	{
+		TDoubleLinkedList<FSHAHash>::TDoubleLinkedListNode* Oldest = LRUList.GetTail();
+		TotalBytes -= Entries.FindChecked(Oldest->GetValue()).Blob.Num();
+		Entries.Remove(Oldest->GetValue());
+		LRUList.RemoveNode(Oldest);
+	}
+
+	UpdateStats(TotalBytes, Entries.Num());
+}
+
+void FCyLandBlobCache::TouchOnDisk(const FString& Path, int64 Size)
+{
+	FScopeLock ScopeLock(&DiskLock);
+	if (!bDiskScanned)
+	{
+		ScanDiskStore();
+	}
+
+	FDiskEntry* Entry = DiskEntries.Find(Path);
+	if (Entry)
+	{
+		DiskBytes -= Entry->Size;
+	}
+	else
+	{
+		Entry = &DiskEntries.Add(Path);
+	}
+	Entry->Size = Size;
+	Entry->LastUsed = FDateTime::UtcNow();
+	DiskBytes += Size;
+
+	const int64 BudgetBytes = FMath::Max<int64>(GetDiskBudgetBytes(), 0);
+	if (DiskBytes > BudgetBytes)
+	{
+		TrimDiskToBudget(BudgetBytes);
+	}
+}
+
+void FCyLandBlobCache::ScanDiskStore()
+{
+	bDiskScanned = true;
+
+	// Files left by earlier sessions count against the budget too, in the order they were last used
+	const FString Directory = FPaths::ProjectSavedDir() / DiskDirectory;
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *Directory, *DiskExtension);
+	for (const FString& Filename : Filenames)
+	{
+		const FString Path = Directory / Filename;
+		const FFileStatData StatData = IFileManager::Get().GetStatData(*Path);
+		if (StatData.bIsValid && !StatData.bIsDirectory)
+		{
+			FDiskEntry& Entry = DiskEntries.Add(Path);
+			Entry.Size = StatData.FileSize;
+			Entry.LastUsed = StatData.ModificationTime;
+			DiskBytes += StatData.FileSize;
+		}
+	}
+}
+
+void FCyLandBlobCache::TrimDiskToBudget(int64 BudgetBytes)
+{
+	// Trim a tenth below the budget so a store growing one file at a time isn't sorted on every add
+	const int64 TargetBytes = BudgetBytes - BudgetBytes / 10;
+	const int32 NumFiles = DiskEntries.Num();
+
+	DiskEntries.ValueSort([](const FDiskEntry& A, const FDiskEntry& B) { return A.LastUsed < B.LastUsed; });
+	for (TMap<FString, FDiskEntry>::TIterator It = DiskEntries.CreateIterator(); It && DiskBytes > TargetBytes; ++It)
+	{
+		// A reader racing the delete just misses, a file that can't be deleted now is found again next session
+		IFileManager::Get().Delete(*It.Key(), false, false, true);
+		DiskBytes -= It.Value().Size;
+		It.RemoveCurrent();
+	}
+
+	UE_LOG(LogCyLandBlobCache, Verbose, TEXT("%s: Deleted %d files of the disk store, %.2f MB left"),
+		*Name, NumFiles - DiskEntries.Num(), float(DiskBytes) / (1024.0f * 1024.0f));
+}
+
+void FCyLandBlobCache::Flush()
+{
+	FScopeLock ScopeLock(&Lock);
+	Entries.Empty();
+	LRUList.Empty();
+	TotalBytes = 0;
+
+	UpdateStats(0, 0);
+}
+
+void FCyLandBlobCache::LogStats()
+{
+	FScopeLock ScopeLock(&Lock);
+	FScopeLock DiskScopeLock(&DiskLock);
+	UE_LOG(LogCyLandBlobCache, Display, TEXT("%s: %d entries, %.2f MB, %d memory hits, %d disk hits, %d misses, disk store %d files, %.2f MB, %d corrupt files"),
+		*Name, Entries.Num(), float(TotalBytes) / (1024.0f * 1024.0f), NumMemoryHits, NumDiskHits, NumMisses,
+		DiskEntries.Num(), float(DiskBytes) / (1024.0f * 1024.0f), NumCorruptFiles);
+}
+
+FString FCyLandBlobCache::GetDiskPath(const FSHAHash& Key) const
+{
+	return FPaths::ProjectSavedDir() / DiskDirectory / Key.ToString() + DiskExtension;
+}
@@ -0,0 +1,117 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandBlobCache.h: Content-addressed store of derived data blobs
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/List.h"
+
+/**
+ * Keeps blobs keyed by a hash of everything they are derived from. Entries are never invalidated: any change to the
+ * inputs changes the key.
+ *
+ * Blobs are kept in memory with an LRU byte budget and, when <Prefix>.UseDiskStore is set, also written to a directory
+ * under Saved so they survive the session. Files carry the size and hash of their blob, which are checked on load. The
+ * directory has its own LRU byte budget: the file times are refreshed on every disk hit and the least recently used
+ * files are deleted once the directory grows over it.
+ *
+ * Every cache registers the same console variables and commands under its prefix: <Prefix>.Enable,
+ * <Prefix>.MemoryBudgetMB, <Prefix>.DiskBudgetMB, <Prefix>.UseDiskStore, <Prefix>.Flush and <Prefix>.Dump.
+ *
+ * All functions are thread safe.
+ */
+class FCyLandBlobCache
+{
+public:
+	/**
+	 * @param InName - Name of the cache in the logs and the help of its console variables
+	 * @param InCVarPrefix - Prefix of the console variables and commands of the cache
+	 * @param InDiskDirectory - Directory of the disk store under Saved
+	 * @param InDiskMagic, InDiskVersion - Header of the files of the disk store, bump the version when the blob layout changes
+	 * @param bUseDiskStoreByDefault - Default of <Prefix>.UseDiskStore
+	 * @param InUpdateStats - Called with the lock held with the bytes and the number of the blobs kept in memory whenever they change
+	 */
+	FCyLandBlobCache(const TCHAR* InName, const TCHAR* InCVarPrefix, const TCHAR* InDiskDirectory, const TCHAR* InDiskExtension, uint32 InDiskMagic, uint32 InDiskVersion,
+		bool bUseDiskStoreByDefault, TFunction<void(int64, int32)> InUpdateStats);
+	~FCyLandBlobCache();
+
+	/** Whether the users of the cache should go through it at all, <Prefix>.Enable */
+	bool IsEnabled() const;
+
+	/** Copy the blob stored for Key into OutBlob, looking in memory then on disk. */
+	bool Find(const FSHAHash& Key, TArray<uint8>& OutBlob);
+
+	/** Store the blob for Key, evicting the least recently used blobs over the memory budget */
+	void Add(const FSHAHash& Key, TArray<uint8>&& Blob);
+
+	/** Drop every in-memory blob, the disk store is left alone */
+	void Flush();
+
+	void LogStats();
+
+private:
+	struct FEntry
+	{
+		TArray<uint8> Blob;
+		/** Node of the entry in LRUList, owned by the list */
+		TDoubleLinkedList<FSHAHash>::TDoubleLinkedListNode* LRUNode;
+	};
+
+	struct FDiskEntry
+	{
+		int64 Size;
+		FDateTime LastUsed;
+	};
+
+	void AddToMemory(const FSHAHash& Key, TArray<uint8>&& Blob);
+	void TouchInMemory(FEntry& Entry);
+	void TrimToBudget(int64 BudgetBytes);
+
+	/** Record a file of the disk store as just used, scanning the directory the first time */
+	void TouchOnDisk(const FString& Path, int64 Size);
+	void ScanDiskStore();
+	void TrimDiskToBudget(int64 BudgetBytes);
+
+	int64 GetMemoryBudgetBytes() const;
+	int64 GetDiskBudgetBytes() const;
+	bool UseDiskStore() const;
+
+	FString GetDiskPath(const FSHAHash& Key) const;
+
+	const FString Name;
+	const TFunction<void(int64, int32)> UpdateStats;
+	const FString DiskDirectory;
+	const FString DiskExtension;
+	const uint32 DiskMagic;
+	const uint32 DiskVersion;
+
+	FCriticalSection Lock;
+	TMap<FSHAHash, FEntry> Entries;
+	int64 TotalBytes;
+
+	/** Keys of Entries, most recently used first, so eviction doesn't look for the oldest entry */
+	TDoubleLinkedList<FSHAHash> LRUList;
+
+	/** Sizes and last uses of the files of the disk store, guarded by DiskLock so file deletes don't stall memory hits */
+	FCriticalSection DiskLock;
+	TMap<FString, FDiskEntry> DiskEntries;
+	int64 DiskBytes;
+	bool bDiskScanned;
+
+	int32 NumMemoryHits;
+	int32 NumDiskHits;
+	int32 NumMisses;
+	int32 NumCorruptFiles;
+
+	IConsoleVariable* EnableCVar;
+	IConsoleVariable* MemoryBudgetMBCVar;
+	IConsoleVariable* DiskBudgetMBCVar;
+	IConsoleVariable* UseDiskStoreCVar;
+	IConsoleCommand* FlushCommand;
+	IConsoleCommand* DumpCommand;
+};
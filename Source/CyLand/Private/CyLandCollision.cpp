@@ -30,10 +30,13 @@
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "CyLandHeightfieldCollisionComponent.h"
 #include "CyLandMeshCollisionComponent.h"
+#include "CyLandHeightQuery.h"
 #include "FoliageInstanceBase.h"
 #include "InstancedFoliageActor.h"
 #include "InstancedFoliage.h"
 #include "AI/NavigationSystemHelpers.h"
+#include "NavigationSystem.h"
+#include "NavigationOctree.h"
 #include "Engine/CollisionProfile.h"
 #include "ProfilingDebugging/CookStats.h"
 #include "Interfaces/ITargetPlatform.h"
@@ -44,6 +47,9 @@
 #include "Materials/MaterialInstanceConstant.h"
 #include "Physics/PhysicsInterfaceCore.h"
 #include "Physics/PhysicsInterfaceUtils.h"
+#include "Misc/CoreDelegates.h"
+#include "HAL/IConsoleManager.h"
+#include "Async/AsyncWork.h"
 
 
 //#define WITH_PHYSX 0
@@ -51,12 +57,28 @@
 
 #if WITH_EDITOR && WITH_PHYSX
 	#include "Physics/IPhysXCooking.h"
+	#include "CyLandBlobCache.h"
 #endif
 
 
 
 using namespace PhysicsInterfaceTypes;
 
+DECLARE_CYCLE_STAT(TEXT("Heightfield Region Update"), STAT_CyLandHeightfieldRegionUpdate, STATGROUP_Landscape);
+
+#if WITH_EDITOR && WITH_PHYSX
+static TAutoConsoleVariable<int32> CVarAsyncCollisionCooking(
+	TEXT("cyland.AsyncCollisionCooking"),
+	1,
+	TEXT("Cook collision missing from the DDC in the thread pool instead of on the game thread when the physics state is created.\n")
+	TEXT("0: Off, 1: Game worlds only (PIE, CyLands spawned at runtime), 2: All worlds"));
+
+static TAutoConsoleVariable<int32> CVarAsyncCollisionPlaceholderQuads(
+	TEXT("cyland.AsyncCollisionCooking.PlaceholderQuads"),
+	16,
+	TEXT("Size in quads of the heightfield standing in while the collision of a component cooks asynchronously, 0 for no collision until it is done"));
+#endif
+
 #if ENABLE_COOK_STATS
 namespace CyLandCollisionCookStats
 {
@@ -67,6 +89,11 @@ namespace CyLandCollisionCookStats
 		HeightfieldUsageStats.LogStats(AddStat, TEXT("CyLandCollision.Usage"), TEXT("Heightfield"));
 		MeshUsageStats.LogStats(AddStat, TEXT("CyLandCollision.Usage"), TEXT("Mesh"));
 	});
+
+	static FCookStats::FDDCResourceUsageStats& GetUsageStats(const UCyLandHeightfieldCollisionComponent* Component)
+	{
+		return Component->IsA<UCyLandMeshCollisionComponent>() ? MeshUsageStats : HeightfieldUsageStats;
+	}
 }
 #endif
 
@@ -157,6 +184,298 @@ static FString GetHFDDCKeyString(const FName& Format, bool bDefMaterial, const F
 	return FDerivedDataCacheInterface::BuildCacheKey(*KeyPrefix, LANDSCAPE_COLLISION_DERIVEDDATA_VER, *CombinedStateId.ToString());
 }
 
+#if WITH_EDITOR && WITH_PHYSX
+DECLARE_MEMORY_STAT(TEXT("Collision Cook Cache"), STAT_CyLandCollisionCookCacheMemory, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Collision Cook Cache Entries"), STAT_CyLandCollisionCookCacheEntries, STATGROUP_Landscape);
+
+/**
+ * Cooked heightfield and trimesh collision keyed by a hash of the cook inputs, so components whose collision Guid
+ * changes without the data changing, like the tiles of runtime-generated terrain, don't cook again. Sits behind the DDC
+ * lookup, which is keyed by Guid. Bump the version when the cooked data layout changes.
+ */
+static FCyLandBlobCache GCollisionCookCache(TEXT("collision cook cache"), TEXT("cyland.CollisionCookCache"), TEXT("CyLandCollisionCache"), TEXT(".hfcook"),
+	0x43434343 /* 'CCCC' */, 2, true,
+	[](int64 TotalBytes, int32 NumEntries)
+	{
+		SET_MEMORY_STAT(STAT_CyLandCollisionCookCacheMemory, TotalBytes);
+		SET_DWORD_STAT(STAT_CyLandCollisionCookCacheEntries, NumEntries);
+	});
+
+/** Raw collision data of a component gathered on the game thread, so that the cooking itself can run on any thread */
+class FCyLandCollisionCookJob
+{
+public:
+	FCyLandCollisionCookJob()
+		: Cooker(nullptr)
+		, bTriMesh(false)
+		, bSuccess(false)
+	{
+	}
+
+	/** Cooker of the target physics format, null when there is nothing to cook */
+	const IPhysXCooking* Cooker;
+	FName Format;
+
+	/** Heightfield samples, the simple collision ones are cooked into the same stream after them */
+	FIntPoint HeightfieldSize;
+	TArray<PxHeightFieldSample> Samples;
+	FIntPoint SimpleHeightfieldSize;
+	TArray<PxHeightFieldSample> SimpleSamples;
+
+	/** Triangle mesh of a UCyLandMeshCollisionComponent */
+	bool bTriMesh;
+	TArray<FVector> Vertices;
+	TArray<FTriIndices> Indices;
+	TArray<uint16> MaterialIndices;
+
+	/** Path names of the physical materials the sample and triangle material indices refer to */
+	TArray<FString> MaterialNames;
+
+	TArray<uint8> CookedData;
+	bool bSuccess;
+
+	/** Hash of everything the cook reads, two components with the same collision data share it whatever their Guid */
+	FSHAHash ComputeCacheKey() const
+	{
+		static const uint32 CacheKeyVersion = 2;
+
+		// Blobs of the disk store outlive engine upgrades, a new cooker mustn't be served the output of the old one
+		const uint16 CookerVersion = Cooker->GetVersion(Format);
+
+		FSHA1 HashState;
+		HashState.Update((const uint8*)&CacheKeyVersion, sizeof(CacheKeyVersion));
+		HashState.Update((const uint8*)&CookerVersion, sizeof(CookerVersion));
+		const FString FormatName = Format.ToString();
+		HashState.UpdateWithString(*FormatName, FormatName.Len() + 1);
+		HashState.Update((const uint8*)&bTriMesh, sizeof(bTriMesh));
+		if (bTriMesh)
+		{
+			HashState.Update((const uint8*)Vertices.GetData(), Vertices.Num() * Vertices.GetTypeSize());
+			HashState.Update((const uint8*)Indices.GetData(), Indices.Num() * Indices.GetTypeSize());
+			HashState.Update((const uint8*)MaterialIndices.GetData(), MaterialIndices.Num() * MaterialIndices.GetTypeSize());
+		}
+		else
+		{
+			HashState.Update((const uint8*)&HeightfieldSize, sizeof(HeightfieldSize));
+			HashState.Update((const uint8*)Samples.GetData(), Samples.Num() * Samples.GetTypeSize());
+			const int32 NumSimpleSamples = SimpleSamples.Num();
+			HashState.Update((const uint8*)&NumSimpleSamples, sizeof(NumSimpleSamples));
+			HashState.Update((const uint8*)&SimpleHeightfieldSize, sizeof(SimpleHeightfieldSize));
+			HashState.Update((const uint8*)SimpleSamples.GetData(), SimpleSamples.Num() * SimpleSamples.GetTypeSize());
+		}
+		for (const FString& MaterialName : MaterialNames)
+		{
+			HashState.UpdateWithString(*MaterialName, MaterialName.Len() + 1);
+		}
+		HashState.Final();
+
+		FSHAHash Key;
+		HashState.GetHash(Key.Hash);
+		return Key;
+	}
+
+	void Cook()
+	{
+		const bool bUseCache = GCollisionCookCache.IsEnabled();
+		FSHAHash CacheKey;
+		if (bUseCache)
+		{
+			CacheKey = ComputeCacheKey();
+			if (GCollisionCookCache.Find(CacheKey, CookedData))
+			{
+				bSuccess = true;
+				return;
+			}
+		}
+
+		if (bTriMesh)
+		{
+			const bool bFlipNormals = true;
+			bSuccess = Cooker->CookTriMesh(Format, EPhysXMeshCookFlags::Default, Vertices, Indices, MaterialIndices, bFlipNormals, CookedData);
+		}
+		else
+		{
+			bSuccess = Cooker->CookHeightField(Format, HeightfieldSize, Samples.GetData(), Samples.GetTypeSize(), CookedData);
+			if (bSuccess && SimpleSamples.Num())
+			{
+				bSuccess = Cooker->CookHeightField(Format, SimpleHeightfieldSize, SimpleSamples.GetData(), SimpleSamples.GetTypeSize(), CookedData);
+			}
+		}
+
+		if (bUseCache && bSuccess && CookedData.Num())
+		{
+			GCollisionCookCache.Add(CacheKey, TArray<uint8>(CookedData));
+		}
+	}
+};
+
+/** Collision cook of a component in the thread pool, shared between the component and the task so either can go away first */
+class FCyLandAsyncCollisionCook
+{
+public:
+	FCyLandAsyncCollisionCook()
+		: State(Queued)
+	{
+	}
+
+	/** Collision with holes and physical materials, and the one without holes used by the landscape editor */
+	FCyLandCollisionCookJob Job;
+	FCyLandCollisionCookJob JobEd;
+	TArray<UPhysicalMaterial*> MaterialsEd;
+
+	/** Cook the jobs on this thread, unless another thread already took them */
+	bool TryCook()
+	{
+		if (FPlatformAtomics::InterlockedCompareExchange(&State, Cooking, Queued) != Queued)
+		{
+			return false;
+		}
+
+		if (Job.Cooker)
+		{
+			Job.Cook();
+		}
+		if (JobEd.Cooker)
+		{
+			JobEd.Cook();
+		}
+
+		FPlatformAtomics::InterlockedExchange(&State, Done);
+		return true;
+	}
+
+	bool IsDone() const
+	{
+		return FPlatformAtomics::AtomicRead(&State) == Done;
+	}
+
+	/** Cook on this thread if no worker started yet, otherwise wait for it */
+	void EnsureCompletion()
+	{
+		if (!TryCook())
+		{
+			while (!IsDone())
+			{
+				FPlatformProcess::Sleep(0.0f);
+			}
+		}
+	}
+
+private:
+	enum EState
+	{
+		Queued,
+		Cooking,
+		Done,
+	};
+
+	volatile int32 State;
+};
+
+class FCyLandCollisionCookTask : public FNonAbandonableTask
+{
+public:
+	FCyLandCollisionCookTask(const TSharedRef<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe>& InCook)
+		: Cook(InCook)
+	{
+	}
+
+	void DoWork()
+	{
+		Cook->TryCook();
+	}
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FCyLandCollisionCookTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+
+private:
+	TSharedRef<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe> Cook;
+};
+
+/** Cooked collision data from the speculative DDC request or the DDC, returns false on a miss */
+static bool GetCookedCollisionDataFromDDC(const UCyLandHeightfieldCollisionComponent* Component, const FName& Format, bool bUseDefMaterial, const TArray<UPhysicalMaterial*>& Materials, TArray<uint8>& OutCookedData)
+{
+	COOK_STAT(auto& UsageStats = CyLandCollisionCookStats::GetUsageStats(Component));
+	COOK_STAT(auto Timer = UsageStats.TimeSyncWork());
+	// we have 2 versions of collision objects
+	const int32 CookedDataIndex = bUseDefMaterial ? 0 : 1;
+	const FGuid& Guid = Component->GetCollisionDataGuid();
+
+	// Ensure that content was saved with physical materials before using DDC data
+	if (Guid.IsValid() && Component->GetLinkerUE4Version() >= VER_UE4_LANDSCAPE_SERIALIZE_PHYSICS_MATERIALS)
+	{
+		FString DDCKey = GetHFDDCKeyString(Format, bUseDefMaterial, Guid, Materials);
+
+		// Check if the speculatively-loaded data loaded and is what we wanted
+		if (Component->SpeculativeDDCRequest.IsValid() && DDCKey == Component->SpeculativeDDCRequest->GetKey())
+		{
+			// If we have a DDC request in flight, just time the synchronous cycles used.
+			COOK_STAT(auto WaitTimer = UsageStats.TimeAsyncWait());
+			Component->SpeculativeDDCRequest->WaitAsynchronousCompletion();
+			bool bSuccess = Component->SpeculativeDDCRequest->GetAsynchronousResults(OutCookedData);
+			// World will clean up remaining reference
+			Component->SpeculativeDDCRequest.Reset();
+			if (bSuccess)
+			{
+				COOK_STAT(Timer.Cancel());
+				COOK_STAT(WaitTimer.AddHit(OutCookedData.Num()));
+				Component->bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
+				return true;
+			}
+			else
+			{
+				// If the DDC request failed, then we waited for nothing and will build the resource anyway. Just ignore the wait timer and treat it all as sync time.
+				COOK_STAT(WaitTimer.Cancel());
+			}
+		}
+
+		if (GetDerivedDataCacheRef().GetSynchronous(*DDCKey, OutCookedData))
+		{
+			COOK_STAT(Timer.AddHit(OutCookedData.Num()));
+			Component->bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
+			return true;
+		}
+	}
+
+	// We didn't get anything, so just track the cycles.
+	COOK_STAT(Timer.TrackCyclesOnly());
+	return false;
+}
+
+/** Takes the stream of a cooked job and saves it to the DDC if needed, returns false if the cook failed */
+static bool StoreCookedCollisionData(const UCyLandHeightfieldCollisionComponent* Component, bool bUseDefMaterial, FCyLandCollisionCookJob& Job, TArray<uint8>& OutCookedData, TArray<UPhysicalMaterial*>& InOutMaterials)
+{
+	if (!Job.bSuccess)
+	{
+		OutCookedData.Empty();
+		InOutMaterials.Empty();
+		return false;
+	}
+
+	// we have 2 versions of collision objects
+	const int32 CookedDataIndex = bUseDefMaterial ? 0 : 1;
+	const FGuid& Guid = Component->GetCollisionDataGuid();
+
+	OutCookedData = MoveTemp(Job.CookedData);
+
+	if (Component->bShouldSaveCookedDataToDDC[CookedDataIndex] && Guid.IsValid())
+	{
+		GetDerivedDataCacheRef().Put(*GetHFDDCKeyString(Job.Format, bUseDefMaterial, Guid, InOutMaterials), OutCookedData);
+		Component->bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
+	}
+
+	return true;
+}
+
+/** Collision components waiting for their async cook, see TickAsyncCollisionCooks */
+static TArray<TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>> GPendingCollisionCooks;
+
+/** Bound to OnEndFrame while GPendingCollisionCooks isn't empty */
+static FDelegateHandle GPendingCollisionCooksHandle;
+#endif // WITH_EDITOR && WITH_PHYSX
+
 ECollisionEnabled::Type UCyLandHeightfieldCollisionComponent::GetCollisionEnabled() const
 {
 	if (!HasAnyFlags(RF_ClassDefaultObject))
@@ -223,11 +542,14 @@ void UCyLandHeightfieldCollisionComponent::OnCreatePhysicsState()
 
 			PxTransform PhysXCyLandComponentTransform = U2PTransform(FTransform(CyLandComponentMatrix));
 
-			const bool bCreateSimpleCollision = SimpleCollisionSizeQuads > 0;
+			const bool bCreateSimpleCollision = SimpleCollisionSizeQuads > 0 && HeightfieldRef->RBHeightfieldSimple != nullptr;
 			const float SimpleCollisionScale = bCreateSimpleCollision ? CollisionScale * CollisionSizeQuads / SimpleCollisionSizeQuads : 0;
 
+			// The placeholder standing in while the collision cooks asynchronously covers the component with fewer quads
+			const float HeightfieldScale = HeightfieldRef->PlaceholderSizeQuads > 0 ? CollisionScale * CollisionSizeQuads / HeightfieldRef->PlaceholderSizeQuads : CollisionScale;
+
 			// Create the geometry
-			PxHeightFieldGeometry CyLandComponentGeom(HeightfieldRef->RBHeightfield, PxMeshGeometryFlag::eDOUBLE_SIDED, CyLandScale.Z * LANDSCAPE_ZSCALE, CyLandScale.Y * CollisionScale, CyLandScale.X * CollisionScale);
+			PxHeightFieldGeometry CyLandComponentGeom(HeightfieldRef->RBHeightfield, PxMeshGeometryFlag::eDOUBLE_SIDED, CyLandScale.Z * LANDSCAPE_ZSCALE, CyLandScale.Y * HeightfieldScale, CyLandScale.X * HeightfieldScale);
 
 			if (CyLandComponentGeom.isValid())
 			{
@@ -331,12 +653,21 @@ void UCyLandHeightfieldCollisionComponent::OnCreatePhysicsState()
 				SCOPED_SCENE_WRITE_LOCK(SyncScene);
 				SyncScene->addActor(*HeightFieldActorSync);
 #endif
+
+				FCyLandHeightQuery::UpdateComponent(this);
 			}
 		}
 #endif// WITH_PHYSX
 	}
 }
 
+void UCyLandHeightfieldCollisionComponent::OnDestroyPhysicsState()
+{
+	Super::OnDestroyPhysicsState();
+
+	FCyLandHeightQuery::RemoveComponent(this);
+}
+
 void UCyLandHeightfieldCollisionComponent::ApplyWorldOffset(const FVector& InOffset, bool bWorldShift)
 {
 	Super::ApplyWorldOffset(InOffset, bWorldShift);
@@ -345,6 +676,11 @@ void UCyLandHeightfieldCollisionComponent::ApplyWorldOffset(const FVector& InOff
 	{
 		RecreatePhysicsState();
 	}
+	else
+	{
+		// The heights didn't change but the height queries also keep the landscape transform
+		FCyLandHeightQuery::UpdateComponent(this);
+	}
 }
 
 void UCyLandHeightfieldCollisionComponent::CreateCollisionObject()
@@ -353,8 +689,6 @@ void UCyLandHeightfieldCollisionComponent::CreateCollisionObject()
 	// If we have not created a heightfield yet - do it now.
 	if (!IsValidRef(HeightfieldRef))
 	{
-		UWorld* World = GetWorld();
-
 		FPhysXHeightfieldRef* ExistingHeightfieldRef = nullptr;
 		bool bCheckDDC = true;
 
@@ -385,57 +719,85 @@ void UCyLandHeightfieldCollisionComponent::CreateCollisionObject()
 
 			// Prepare heightfield data
 			static FName PhysicsFormatName(FPlatformProperties::GetPhysicsFormat());
-			CookCollisionData(PhysicsFormatName, false, bCheckDDC, CookedCollisionData, CookedPhysicalMaterials);
+			if (!bCheckDDC || !GetCookedCollisionDataFromDDC(this, PhysicsFormatName, false, CookedPhysicalMaterials, CookedCollisionData))
+			{
+				if (BeginAsyncCollisionCook(PhysicsFormatName, bCheckDDC))
+				{
+					// The physics state is created again with the cooked heightfield when the cook is done
+					CreatePlaceholderCollisionObject(PhysicsFormatName);
+					SpeculativeDDCRequest.Reset();
+					return;
+				}
+
+				CookCollisionData(PhysicsFormatName, false, false, CookedCollisionData, CookedPhysicalMaterials);
+			}
 
 			// The World will clean up any speculatively-loaded data we didn't end up using.
 			SpeculativeDDCRequest.Reset();
-#endif //WITH_EDITOR
 
-			if (CookedCollisionData.Num())
+			// Cook heightfield for the landscape editor (no holes in it)
+			if (CookedCollisionData.Num() && !GetWorld()->IsGameWorld())
 			{
-				HeightfieldRef = GSharedHeightfieldRefs.Add(HeightfieldGuid, new FPhysXHeightfieldRef(HeightfieldGuid));
-
-				// Create heightfield shape
+				TArray<UPhysicalMaterial*> CookedMaterialsEd;
+				if (!CookCollisionData(PhysicsFormatName, true, bCheckDDC, CookedCollisionDataEd, CookedMaterialsEd))
 				{
-					FPhysXInputStream HeightFieldStream(CookedCollisionData.GetData(), CookedCollisionData.Num());
-					HeightfieldRef->RBHeightfield = GPhysXSDK->createHeightField(HeightFieldStream);
-					if (SimpleCollisionSizeQuads > 0)
-					{
-						HeightfieldRef->RBHeightfieldSimple = GPhysXSDK->createHeightField(HeightFieldStream);
-					}
+					CookedCollisionDataEd.Empty();
 				}
+			}
+#endif //WITH_EDITOR
 
-				for (UPhysicalMaterial* PhysicalMaterial : CookedPhysicalMaterials)
-				{
+			CreateCollisionObjectFromCookedData();
+		}
+	}
+#endif //WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::CreateCollisionObjectFromCookedData()
+{
+#if WITH_PHYSX
+	HeightfieldRef = nullptr;
+
+	if (CookedCollisionData.Num())
+	{
+		UWorld* World = GetWorld();
+
+		HeightfieldRef = GSharedHeightfieldRefs.Add(HeightfieldGuid, new FPhysXHeightfieldRef(HeightfieldGuid));
+
+		// Create heightfield shape
+		{
+			FPhysXInputStream HeightFieldStream(CookedCollisionData.GetData(), CookedCollisionData.Num());
+			HeightfieldRef->RBHeightfield = GPhysXSDK->createHeightField(HeightFieldStream);
+			if (SimpleCollisionSizeQuads > 0)
+			{
+				HeightfieldRef->RBHeightfieldSimple = GPhysXSDK->createHeightField(HeightFieldStream);
+			}
+		}
+
+		for (UPhysicalMaterial* PhysicalMaterial : CookedPhysicalMaterials)
+		{
 #if WITH_CHAOS || WITH_IMMEDIATE_PHYSX || PHYSICS_INTERFACE_LLIMMEDIATE
-                    ensure(false);
+			ensure(false);
 #else
-					const FPhysicsMaterialHandle_PhysX& MaterialHandle = PhysicalMaterial->GetPhysicsMaterial();
-					HeightfieldRef->UsedPhysicalMaterialArray.Add(MaterialHandle.Material);
+			const FPhysicsMaterialHandle_PhysX& MaterialHandle = PhysicalMaterial->GetPhysicsMaterial();
+			HeightfieldRef->UsedPhysicalMaterialArray.Add(MaterialHandle.Material);
 #endif
-				}
+		}
 
-				// Release cooked collison data
-				// In cooked builds created collision object will never be deleted while component is alive, so we don't need this data anymore
-				if (FPlatformProperties::RequiresCookedData() || World->IsGameWorld())
-				{
-					CookedCollisionData.Empty();
-				}
+		// Release cooked collison data
+		// In cooked builds created collision object will never be deleted while component is alive, so we don't need this data anymore
+		if (FPlatformProperties::RequiresCookedData() || World->IsGameWorld())
+		{
+			CookedCollisionData.Empty();
+		}
 
 #if WITH_EDITOR
-				// Create heightfield for the landscape editor (no holes in it)
-				if (!World->IsGameWorld())
-				{
-					TArray<UPhysicalMaterial*> CookedMaterialsEd;
-					if (CookCollisionData(PhysicsFormatName, true, bCheckDDC, CookedCollisionDataEd, CookedMaterialsEd))
-					{
-						FPhysXInputStream HeightFieldStream(CookedCollisionDataEd.GetData(), CookedCollisionDataEd.Num());
-						HeightfieldRef->RBHeightfieldEd = GPhysXSDK->createHeightField(HeightFieldStream);
-					}
-				}
-#endif //WITH_EDITOR
-			}
+		// Create heightfield for the landscape editor (no holes in it)
+		if (!World->IsGameWorld() && CookedCollisionDataEd.Num())
+		{
+			FPhysXInputStream HeightFieldStream(CookedCollisionDataEd.GetData(), CookedCollisionDataEd.Num());
+			HeightfieldRef->RBHeightfieldEd = GPhysXSDK->createHeightField(HeightFieldStream);
 		}
+#endif //WITH_EDITOR
 	}
 #endif //WITH_PHYSX
 }
@@ -519,54 +881,43 @@ TArray<PxHeightFieldSample> ConvertHeightfieldDataForPhysx(const UCyLandHeightfi
 bool UCyLandHeightfieldCollisionComponent::CookCollisionData(const FName& Format, bool bUseDefMaterial, bool bCheckDDC, TArray<uint8>& OutCookedData, TArray<UPhysicalMaterial*>& InOutMaterials) const
 {
 #if WITH_PHYSX
-	COOK_STAT(auto Timer = CyLandCollisionCookStats::HeightfieldUsageStats.TimeSyncWork());
-	// we have 2 versions of collision objects
-	const int32 CookedDataIndex = bUseDefMaterial ? 0 : 1;
+	if (bCheckDDC && GetCookedCollisionDataFromDDC(this, Format, bUseDefMaterial, InOutMaterials, OutCookedData))
+	{
+		return true;
+	}
 
-	if (bCheckDDC && HeightfieldGuid.IsValid())
+	COOK_STAT(auto Timer = CyLandCollisionCookStats::GetUsageStats(this).TimeSyncWork());
+
+	FCyLandCollisionCookJob Job;
+	if (!GatherCollisionCookJob(Format, bUseDefMaterial, Job, InOutMaterials))
 	{
-		// Ensure that content was saved with physical materials before using DDC data
-		if (GetLinkerUE4Version() >= VER_UE4_LANDSCAPE_SERIALIZE_PHYSICS_MATERIALS)
-		{
-			FString DDCKey = GetHFDDCKeyString(Format, bUseDefMaterial, HeightfieldGuid, InOutMaterials);
+		// We didn't actually build anything, so just track the cycles.
+		COOK_STAT(Timer.TrackCyclesOnly());
+		return false;
+	}
 
-			// Check if the speculatively-loaded data loaded and is what we wanted
-			if (SpeculativeDDCRequest.IsValid() && DDCKey == SpeculativeDDCRequest->GetKey())
-			{
-				// If we have a DDC request in flight, just time the synchronous cycles used.
-				COOK_STAT(auto WaitTimer = CyLandCollisionCookStats::HeightfieldUsageStats.TimeAsyncWait());
-				SpeculativeDDCRequest->WaitAsynchronousCompletion();
-				bool bSuccess = SpeculativeDDCRequest->GetAsynchronousResults(OutCookedData);
-				// World will clean up remaining reference
-				SpeculativeDDCRequest.Reset();
-				if (bSuccess)
-				{
-					COOK_STAT(Timer.Cancel());
-					COOK_STAT(WaitTimer.AddHit(OutCookedData.Num()));
-					bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
-					return true;
-				}
-				else
-				{
-					// If the DDC request failed, then we waited for nothing and will build the resource anyway. Just ignore the wait timer and treat it all as sync time.
-					COOK_STAT(WaitTimer.Cancel());
-				}
-			}
+	Job.Cook();
 
-			if (GetDerivedDataCacheRef().GetSynchronous(*DDCKey, OutCookedData))
-			{
-				COOK_STAT(Timer.AddHit(OutCookedData.Num()));
-				bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
-				return true;
-			}
-		}
+	if (!StoreCookedCollisionData(this, bUseDefMaterial, Job, OutCookedData, InOutMaterials))
+	{
+		// if we failed to build the resource, just time the cycles we spent.
+		COOK_STAT(Timer.TrackCyclesOnly());
+		return false;
 	}
 
+	COOK_STAT(Timer.AddMiss(OutCookedData.Num()));
+	return true;
+#endif	// WITH_PHYSX
+
+	return false;
+}
+
+bool UCyLandHeightfieldCollisionComponent::GatherCollisionCookJob(const FName& Format, bool bUseDefMaterial, FCyLandCollisionCookJob& OutJob, TArray<UPhysicalMaterial*>& InOutMaterials) const
+{
+#if WITH_PHYSX
 	ACyLandProxy* Proxy = GetCyLandProxy();
 	if (!Proxy || !Proxy->GetRootComponent())
 	{
-		// We didn't actually build anything, so just track the cycles.
-		COOK_STAT(Timer.TrackCyclesOnly());
 		return false;
 	}
 
@@ -597,13 +948,11 @@ bool UCyLandHeightfieldCollisionComponent::CookCollisionData(const FName& Format
 	// List of materials which is actually used by heightfield
 	InOutMaterials.Empty();
 
-	TArray<PxHeightFieldSample> Samples;
-	TArray<PxHeightFieldSample> SimpleSamples;
-	Samples = ConvertHeightfieldDataForPhysx(this, CollisionSizeVerts, bIsMirrored, Heights, bUseDefMaterial, DominantLayers, DefMaterial, InOutMaterials);
+	OutJob.Samples = ConvertHeightfieldDataForPhysx(this, CollisionSizeVerts, bIsMirrored, Heights, bUseDefMaterial, DominantLayers, DefMaterial, InOutMaterials);
 
 	if (bGenerateSimpleCollision)
 	{
-		SimpleSamples = ConvertHeightfieldDataForPhysx(this, SimpleCollisionSizeVerts, bIsMirrored, Heights + NumSamples, bUseDefMaterial, DominantLayers, DefMaterial, InOutMaterials);
+		OutJob.SimpleSamples = ConvertHeightfieldDataForPhysx(this, SimpleCollisionSizeVerts, bIsMirrored, Heights + NumSamples, bUseDefMaterial, DominantLayers, DefMaterial, InOutMaterials);
 	}
 
 	CollisionHeightData.Unlock();
@@ -618,101 +967,33 @@ bool UCyLandHeightfieldCollisionComponent::CookCollisionData(const FName& Format
 		InOutMaterials.Add(DefMaterial);
 	}
 
-	//
-	FIntPoint HFSize = FIntPoint(CollisionSizeVerts, CollisionSizeVerts);
-	TArray<uint8> OutData;
-
-	ITargetPlatformManagerModule* TPM = GetTargetPlatformManager();
-	const IPhysXCooking* Cooker = TPM->FindPhysXCooking(Format);
-	bool Result = Cooker->CookHeightField(Format, HFSize, Samples.GetData(), Samples.GetTypeSize(), OutData);
-
-	if (Result && bGenerateSimpleCollision)
-	{
-		FIntPoint HFSizeSimple = FIntPoint(SimpleCollisionSizeVerts, SimpleCollisionSizeVerts);
-		Result = Cooker->CookHeightField(Format, HFSizeSimple, SimpleSamples.GetData(), SimpleSamples.GetTypeSize(), OutData);
-	}
-
-	if (Result)
-	{
-		COOK_STAT(Timer.AddMiss(OutData.Num()));
-		OutCookedData.SetNumUninitialized(OutData.Num());
-		FMemory::Memcpy(OutCookedData.GetData(), OutData.GetData(), OutData.Num());
-
-		if (bShouldSaveCookedDataToDDC[CookedDataIndex] && HeightfieldGuid.IsValid())
-		{
-			GetDerivedDataCacheRef().Put(*GetHFDDCKeyString(Format, bUseDefMaterial, HeightfieldGuid, InOutMaterials), OutCookedData);
-			bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
-		}
-	}
-	else
+	OutJob.Format = Format;
+	OutJob.Cooker = GetTargetPlatformManager()->FindPhysXCooking(Format);
+	OutJob.HeightfieldSize = FIntPoint(CollisionSizeVerts, CollisionSizeVerts);
+	OutJob.SimpleHeightfieldSize = FIntPoint(SimpleCollisionSizeVerts, SimpleCollisionSizeVerts);
+	for (UPhysicalMaterial* Material : InOutMaterials)
 	{
-		// if we failed to build the resource, just time the cycles we spent.
-		COOK_STAT(Timer.TrackCyclesOnly());
-		OutCookedData.Empty();
-		InOutMaterials.Empty();
+		OutJob.MaterialNames.Add(GetPathNameSafe(Material));
 	}
 
-	return Result;
+	return OutJob.Cooker != nullptr;
 #endif	// WITH_PHYSX
 
 	return false;
 }
 
-bool UCyLandMeshCollisionComponent::CookCollisionData(const FName& Format, bool bUseDefMaterial, bool bCheckDDC, TArray<uint8>& OutCookedData, TArray<UPhysicalMaterial*>& InOutMaterials) const
+bool UCyLandMeshCollisionComponent::GatherCollisionCookJob(const FName& Format, bool bUseDefMaterial, FCyLandCollisionCookJob& OutJob, TArray<UPhysicalMaterial*>& InOutMaterials) const
 {
 #if WITH_PHYSX
-	COOK_STAT(auto Timer = CyLandCollisionCookStats::MeshUsageStats.TimeSyncWork());
-	// we have 2 versions of collision objects
-	const int32 CookedDataIndex = bUseDefMaterial ? 0 : 1;
+	ACyLandProxy* Proxy = GetCyLandProxy();
+	UPhysicalMaterial* DefMaterial = (Proxy && Proxy->DefaultPhysMaterial != nullptr) ? Proxy->DefaultPhysMaterial : GEngine->DefaultPhysMaterial;
 
-	if (bCheckDDC)
-	{
-		// Ensure that content was saved with physical materials before using DDC data
-		if (GetLinkerUE4Version() >= VER_UE4_LANDSCAPE_SERIALIZE_PHYSICS_MATERIALS && MeshGuid.IsValid())
-		{
-			FString DDCKey = GetHFDDCKeyString(Format, bUseDefMaterial, MeshGuid, InOutMaterials);
+	// List of materials which is actually used by trimesh
+	InOutMaterials.Empty();
 
-			// Check if the speculatively-loaded data loaded and is what we wanted
-			if (SpeculativeDDCRequest.IsValid() && DDCKey == SpeculativeDDCRequest->GetKey())
-			{
-				// If we have a DDC request in flight, just time the synchronous cycles used.
-				COOK_STAT(auto WaitTimer = CyLandCollisionCookStats::MeshUsageStats.TimeAsyncWait());
-				SpeculativeDDCRequest->WaitAsynchronousCompletion();
-				bool bSuccess = SpeculativeDDCRequest->GetAsynchronousResults(OutCookedData);
-				// World will clean up remaining reference
-				SpeculativeDDCRequest.Reset();
-				if (bSuccess)
-				{
-					COOK_STAT(Timer.Cancel());
-					COOK_STAT(WaitTimer.AddHit(OutCookedData.Num()));
-					bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
-					return true;
-				}
-				else
-				{
-					// If the DDC request failed, then we waited for nothing and will build the resource anyway. Just ignore the wait timer and treat it all as sync time.
-					COOK_STAT(WaitTimer.Cancel());
-				}
-			}
-
-			if (GetDerivedDataCacheRef().GetSynchronous(*DDCKey, OutCookedData))
-			{
-				COOK_STAT(Timer.AddHit(OutCookedData.Num()));
-				bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
-				return true;
-			}
-		}
-	}
-	
-	ACyLandProxy* Proxy = GetCyLandProxy();
-	UPhysicalMaterial* DefMaterial = (Proxy && Proxy->DefaultPhysMaterial != nullptr) ? Proxy->DefaultPhysMaterial : GEngine->DefaultPhysMaterial;
-
-	// List of materials which is actually used by trimesh
-	InOutMaterials.Empty();
-
-	TArray<FVector>			Vertices;
-	TArray<FTriIndices>		Indices;
-	TArray<uint16>			MaterialIndices;
+	TArray<FVector>&		Vertices = OutJob.Vertices;
+	TArray<FTriIndices>&	Indices = OutJob.Indices;
+	TArray<uint16>&			MaterialIndices = OutJob.MaterialIndices;
 
 	const int32 CollisionSizeVerts = CollisionSizeQuads + 1;
 	const int32 NumVerts = FMath::Square(CollisionSizeVerts);
@@ -827,36 +1108,192 @@ bool UCyLandMeshCollisionComponent::CookCollisionData(const FName& Format, bool
 		InOutMaterials.Add(DefMaterial);
 	}
 
-	bool bFlipNormals = true;
-	TArray<uint8> OutData;
-	ITargetPlatformManagerModule* TPM = GetTargetPlatformManager();
-	const IPhysXCooking* Cooker = TPM->FindPhysXCooking(Format);
-	bool Result = Cooker->CookTriMesh(Format, EPhysXMeshCookFlags::Default, Vertices, Indices, MaterialIndices, bFlipNormals, OutData);
+	OutJob.Format = Format;
+	OutJob.Cooker = GetTargetPlatformManager()->FindPhysXCooking(Format);
+	OutJob.bTriMesh = true;
+	for (UPhysicalMaterial* Material : InOutMaterials)
+	{
+		OutJob.MaterialNames.Add(GetPathNameSafe(Material));
+	}
+
+	return OutJob.Cooker != nullptr;
+#endif // WITH_PHYSX
+
+	return false;
+}
+
+bool UCyLandHeightfieldCollisionComponent::BeginAsyncCollisionCook(const FName& Format, bool bCheckDDC)
+{
+#if WITH_PHYSX
+	UWorld* World = GetWorld();
+	const int32 AsyncMode = CVarAsyncCollisionCooking.GetValueOnGameThread();
+	if (AsyncMode <= 0 || World == nullptr || (AsyncMode == 1 && !World->IsGameWorld()) || !FPlatformProcess::SupportsMultithreading())
+	{
+		return false;
+	}
 
-	if (Result)
+	TSharedRef<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe> Cook = MakeShared<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe>();
+	if (!GatherCollisionCookJob(Format, false, Cook->Job, CookedPhysicalMaterials))
 	{
-		COOK_STAT(Timer.AddMiss(OutData.Num()));
-		OutCookedData.SetNumUninitialized(OutData.Num());
-		FMemory::Memcpy(OutCookedData.GetData(), OutData.GetData(), OutData.Num());
+		return false;
+	}
 
-		if (bShouldSaveCookedDataToDDC[CookedDataIndex] && MeshGuid.IsValid())
+	// Collision for the landscape editor (no holes in it)
+	CookedCollisionDataEd.Empty();
+	if (!World->IsGameWorld())
+	{
+		if (!bCheckDDC || !GetCookedCollisionDataFromDDC(this, Format, true, Cook->MaterialsEd, CookedCollisionDataEd))
 		{
-			GetDerivedDataCacheRef().Put(*GetHFDDCKeyString(Format, bUseDefMaterial, MeshGuid, InOutMaterials), OutCookedData);
-			bShouldSaveCookedDataToDDC[CookedDataIndex] = false;
+			GatherCollisionCookJob(Format, true, Cook->JobEd, Cook->MaterialsEd);
 		}
 	}
-	else
+
+	AsyncCollisionCook = Cook;
+	GPendingCollisionCooks.AddUnique(this);
+
+	if (!GPendingCollisionCooksHandle.IsValid())
+	{
+		GPendingCollisionCooksHandle = FCoreDelegates::OnEndFrame.AddStatic(&UCyLandHeightfieldCollisionComponent::TickAsyncCollisionCooks);
+	}
+
+	(new FAutoDeleteAsyncTask<FCyLandCollisionCookTask>(Cook))->StartBackgroundTask();
+	return true;
+#else
+	return false;
+#endif // WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::CreatePlaceholderCollisionObject(const FName& Format)
+{
+#if WITH_PHYSX
+	const int32 PlaceholderSizeQuads = FMath::Min(CVarAsyncCollisionPlaceholderQuads.GetValueOnGameThread(), CollisionSizeQuads);
+	const int32 CollisionSizeVerts = CollisionSizeQuads + 1;
+
+	ACyLandProxy* Proxy = GetCyLandProxy();
+	const IPhysXCooking* Cooker = GetTargetPlatformManager()->FindPhysXCooking(Format);
+	if (PlaceholderSizeQuads <= 0 || !Proxy || !Proxy->GetRootComponent() || !Cooker || CollisionHeightData.GetElementCount() < FMath::Square(CollisionSizeVerts))
+	{
+		return;
+	}
+
+	UPhysicalMaterial* DefMaterial = Proxy->DefaultPhysMaterial ? Proxy->DefaultPhysMaterial : GEngine->DefaultPhysMaterial;
+
+	// GetComponentTransform() might not be initialized at this point, so use landscape transform
+	const FVector CyLandScale = Proxy->GetRootComponent()->RelativeScale3D;
+	const bool bIsMirrored = (CyLandScale.X*CyLandScale.Y*CyLandScale.Z) < 0.f;
+
+	// Point sample the collision heights
+	const int32 PlaceholderSizeVerts = PlaceholderSizeQuads + 1;
+	const float Ratio = (float)CollisionSizeQuads / (float)PlaceholderSizeQuads;
+
+	TArray<uint16> PlaceholderHeights;
+	PlaceholderHeights.SetNumUninitialized(FMath::Square(PlaceholderSizeVerts));
+
+	const uint16* Heights = (const uint16*)CollisionHeightData.LockReadOnly();
+	for (int32 Y = 0; Y < PlaceholderSizeVerts; Y++)
+	{
+		const int32 SrcY = FMath::Min(FMath::RoundToInt(Y * Ratio), CollisionSizeQuads);
+		for (int32 X = 0; X < PlaceholderSizeVerts; X++)
+		{
+			const int32 SrcX = FMath::Min(FMath::RoundToInt(X * Ratio), CollisionSizeQuads);
+			PlaceholderHeights[Y * PlaceholderSizeVerts + X] = Heights[SrcY * CollisionSizeVerts + SrcX];
+		}
+	}
+	CollisionHeightData.Unlock();
+
+	TArray<UPhysicalMaterial*> Materials;
+	TArray<PxHeightFieldSample> Samples = ConvertHeightfieldDataForPhysx(this, PlaceholderSizeVerts, bIsMirrored, PlaceholderHeights.GetData(), true, nullptr, DefMaterial, Materials);
+
+	TArray<uint8> CookedData;
+	if (!Cooker->CookHeightField(Format, FIntPoint(PlaceholderSizeVerts, PlaceholderSizeVerts), Samples.GetData(), Samples.GetTypeSize(), CookedData))
+	{
+		return;
+	}
+
+	// Not shared, the cooked heightfield replaces it
+	HeightfieldRef = new FPhysXHeightfieldRef();
+	HeightfieldRef->PlaceholderSizeQuads = PlaceholderSizeQuads;
+
+	FPhysXInputStream HeightFieldStream(CookedData.GetData(), CookedData.Num());
+	HeightfieldRef->RBHeightfield = GPhysXSDK->createHeightField(HeightFieldStream);
+
+#if WITH_CHAOS || WITH_IMMEDIATE_PHYSX || PHYSICS_INTERFACE_LLIMMEDIATE
+	ensure(false);
+#else
+	HeightfieldRef->UsedPhysicalMaterialArray.Add(DefMaterial->GetPhysicsMaterial().Material);
+#endif
+#endif // WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::FinishAsyncCollisionCook()
+{
+#if WITH_PHYSX
+	check(IsInGameThread());
+
+	if (!AsyncCollisionCook.IsValid())
+	{
+		return;
+	}
+
+	TSharedPtr<FCyLandAsyncCollisionCook, ESPMode::ThreadSafe> Cook = AsyncCollisionCook;
+	AsyncCollisionCook.Reset();
+	Cook->EnsureCompletion();
+
+	COOK_STAT(auto Timer = CyLandCollisionCookStats::GetUsageStats(this).TimeAsyncWait());
+	if (!StoreCookedCollisionData(this, false, Cook->Job, CookedCollisionData, CookedPhysicalMaterials))
 	{
-		// We didn't actually build anything, so just track the cycles.
 		COOK_STAT(Timer.TrackCyclesOnly());
-		OutCookedData.Empty();
-		InOutMaterials.Empty();
+		UE_LOG(LogCyLand, Warning, TEXT("Failed to cook the collision of %s"), *GetPathName());
+		return;
 	}
+	COOK_STAT(Timer.AddMiss(CookedCollisionData.Num()));
 
-	return Result;
+	if (Cook->JobEd.Cooker)
+	{
+		StoreCookedCollisionData(this, true, Cook->JobEd, CookedCollisionDataEd, Cook->MaterialsEd);
+	}
+
+	// Replace the placeholder, the physics state picks up the cooked collision objects
+	CreateCollisionObjectFromCookedData();
+	RecreatePhysicsState();
 
+	FNavigationSystem::UpdateComponentData(*this);
+#endif // WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::TickAsyncCollisionCooks()
+{
+#if WITH_PHYSX
+	if (GPendingCollisionCooks.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>> Pending = MoveTemp(GPendingCollisionCooks);
+	for (const TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>& Component : Pending)
+	{
+		// Components that went away or recreated their collision dropped their cook
+		if (!Component.IsValid() || !Component->AsyncCollisionCook.IsValid())
+		{
+			continue;
+		}
+
+		if (Component->AsyncCollisionCook->IsDone())
+		{
+			Component->FinishAsyncCollisionCook();
+		}
+		else
+		{
+			GPendingCollisionCooks.Add(Component);
+		}
+	}
+
+	if (GPendingCollisionCooks.Num() == 0)
+	{
+		FCoreDelegates::OnEndFrame.Remove(GPendingCollisionCooksHandle);
+		GPendingCollisionCooksHandle.Reset();
+	}
 #endif // WITH_PHYSX
-	return false;
 }
 #endif //WITH_EDITOR
 
@@ -896,47 +1333,71 @@ void UCyLandMeshCollisionComponent::CreateCollisionObject()
 
 			// Create cooked physics data
 			static FName PhysicsFormatName(FPlatformProperties::GetPhysicsFormat());
-			CookCollisionData(PhysicsFormatName, false, bCheckDDC, CookedCollisionData, CookedPhysicalMaterials);
-#endif //WITH_EDITOR
-
-			if (CookedCollisionData.Num())
+			if (!bCheckDDC || !GetCookedCollisionDataFromDDC(this, PhysicsFormatName, false, CookedPhysicalMaterials, CookedCollisionData))
 			{
-				MeshRef = GSharedMeshRefs.Add(MeshGuid, new FPhysXMeshRef(MeshGuid));
+				if (BeginAsyncCollisionCook(PhysicsFormatName, bCheckDDC))
+				{
+					// No collision until the cook is done, the physics state is created again then
+					return;
+				}
 
-				// Create physics objects
-				FPhysXInputStream Buffer(CookedCollisionData.GetData(), CookedCollisionData.Num());
-				MeshRef->RBTriangleMesh = GPhysXSDK->createTriangleMesh(Buffer);
+				CookCollisionData(PhysicsFormatName, false, false, CookedCollisionData, CookedPhysicalMaterials);
+			}
 
-				for (UPhysicalMaterial* PhysicalMaterial : CookedPhysicalMaterials)
+			// Create collision mesh for the landscape editor (no holes in it)
+			if (CookedCollisionData.Num() && !GetWorld()->IsGameWorld())
+			{
+				TArray<UPhysicalMaterial*> CookedMaterialsEd;
+				if (!CookCollisionData(PhysicsFormatName, true, bCheckDDC, CookedCollisionDataEd, CookedMaterialsEd))
 				{
+					CookedCollisionDataEd.Empty();
+				}
+			}
+#endif //WITH_EDITOR
+
+			CreateCollisionObjectFromCookedData();
+		}
+	}
+#endif //WITH_PHYSX
+}
+
+void UCyLandMeshCollisionComponent::CreateCollisionObjectFromCookedData()
+{
+#if WITH_PHYSX
+	MeshRef = nullptr;
+
+	if (CookedCollisionData.Num())
+	{
+		MeshRef = GSharedMeshRefs.Add(MeshGuid, new FPhysXMeshRef(MeshGuid));
+
+		// Create physics objects
+		FPhysXInputStream Buffer(CookedCollisionData.GetData(), CookedCollisionData.Num());
+		MeshRef->RBTriangleMesh = GPhysXSDK->createTriangleMesh(Buffer);
+
+		for (UPhysicalMaterial* PhysicalMaterial : CookedPhysicalMaterials)
+		{
 #if WITH_CHAOS || WITH_IMMEDIATE_PHYSX || PHYSICS_INTERFACE_LLIMMEDIATE
-                    ensure(false);
+			ensure(false);
 #else
-					MeshRef->UsedPhysicalMaterialArray.Add(PhysicalMaterial->GetPhysicsMaterial().Material);
+			MeshRef->UsedPhysicalMaterialArray.Add(PhysicalMaterial->GetPhysicsMaterial().Material);
 #endif
-				}
+		}
 
-				// Release cooked collison data
-				// In cooked builds created collision object will never be deleted while component is alive, so we don't need this data anymore
-				if (FPlatformProperties::RequiresCookedData() || GetWorld()->IsGameWorld())
-				{
-					CookedCollisionData.Empty();
-				}
+		// Release cooked collison data
+		// In cooked builds created collision object will never be deleted while component is alive, so we don't need this data anymore
+		if (FPlatformProperties::RequiresCookedData() || GetWorld()->IsGameWorld())
+		{
+			CookedCollisionData.Empty();
+		}
 
 #if WITH_EDITOR
-				// Create collision mesh for the landscape editor (no holes in it)
-				if (!GetWorld()->IsGameWorld())
-				{
-					TArray<UPhysicalMaterial*> CookedMaterialsEd;
-					if (CookCollisionData(PhysicsFormatName, true, bCheckDDC, CookedCollisionDataEd, CookedMaterialsEd))
-					{
-						FPhysXInputStream MeshStream(CookedCollisionDataEd.GetData(), CookedCollisionDataEd.Num());
-						MeshRef->RBTriangleMeshEd = GPhysXSDK->createTriangleMesh(MeshStream);
-					}
-				}
-#endif //WITH_EDITOR
-			}
+		// Create collision mesh for the landscape editor (no holes in it)
+		if (!GetWorld()->IsGameWorld() && CookedCollisionDataEd.Num())
+		{
+			FPhysXInputStream MeshStream(CookedCollisionDataEd.GetData(), CookedCollisionDataEd.Num());
+			MeshRef->RBTriangleMeshEd = GPhysXSDK->createTriangleMesh(MeshStream);
 		}
+#endif //WITH_EDITOR
 	}
 #endif //WITH_PHYSX
 }
@@ -1082,108 +1543,378 @@ void UCyLandMeshCollisionComponent::DestroyComponent(bool bPromoteChildren/*= fa
 	Super::DestroyComponent(bPromoteChildren);
 }
 
+#if WITH_PHYSX
+/**
+ * Write the heights of a region of collision vertices into a live heightfield with modifySamples, keeping the
+ * per-triangle materials (and holes) it was cooked with.
+ * @param GetHeight - Height of the collision vertex (X, Y) of the component
+ */
+template<typename HeightFunctionType>
+static void ModifyHeightfieldSamples(PxHeightField* Heightfield, int32 SizeVerts, bool bIsMirrored, const FIntRect& Region, HeightFunctionType GetHeight)
+{
+	// PhysX heightfield has the X and Y axis swapped, and the X component is also inverted
+	const int32 StartCol = Region.Min.Y;
+	const int32 StartRow = bIsMirrored ? Region.Min.X : (SizeVerts - Region.Max.X - 1);
+	const int32 NumCols = Region.Max.Y - Region.Min.Y + 1;
+	const int32 NumRows = Region.Max.X - Region.Min.X + 1;
+
+	TArray<PxHeightFieldSample> Samples;
+	Samples.AddZeroed(NumCols * NumRows);
+
+	for (int32 RowIndex = 0; RowIndex < NumRows; RowIndex++)
+	{
+		const int32 Row = StartRow + RowIndex;
+		const int32 SrcX = bIsMirrored ? Row : (SizeVerts - Row - 1);
+		for (int32 ColIndex = 0; ColIndex < NumCols; ColIndex++)
+		{
+			const int32 Col = StartCol + ColIndex;
+
+			PxHeightFieldSample& Sample = Samples[RowIndex * NumCols + ColIndex];
+			Sample.height = FMath::Clamp<int32>(((int32)GetHeight(SrcX, Col) - 32768), -32768, 32767);
+
+			// Materials are per triangle, the last row/column don't own any
+			if (Row < SizeVerts - 1 && Col < SizeVerts - 1)
+			{
+				const PxU32 TriangleIndex = 2 * (Row * SizeVerts + Col);
+				Sample.materialIndex0 = Heightfield->getTriangleMaterialIndex(TriangleIndex);
+				Sample.materialIndex1 = Heightfield->getTriangleMaterialIndex(TriangleIndex + 1);
+			}
+		}
+	}
+
+	PxHeightFieldDesc SubDesc;
+	SubDesc.format = PxHeightFieldFormat::eS16_TM;
+	SubDesc.nbColumns = NumCols;
+	SubDesc.nbRows = NumRows;
+	SubDesc.samples.data = Samples.GetData();
+	SubDesc.samples.stride = sizeof(PxU32);
+	SubDesc.flags = PxHeightFieldFlag::eNO_BOUNDARY_EDGES;
+
+	Heightfield->modifySamples(StartCol, StartRow, SubDesc, true);
+}
+
+/** Read back all heights of a live heightfield in component collision vertex order */
+static void ReadHeightfieldHeights(PxHeightField* Heightfield, int32 SizeVerts, bool bIsMirrored, TArray<uint16>& OutHeights)
+{
+	TArray<PxHeightFieldSample> Samples;
+	Samples.SetNumUninitialized(FMath::Square(SizeVerts));
+	Heightfield->saveCells(Samples.GetData(), Samples.Num() * Samples.GetTypeSize());
+
+	OutHeights.SetNumUninitialized(FMath::Square(SizeVerts));
+	for (int32 Row = 0; Row < SizeVerts; Row++)
+	{
+		const int32 SrcX = bIsMirrored ? Row : (SizeVerts - Row - 1);
+		for (int32 Col = 0; Col < SizeVerts; Col++)
+		{
+			OutHeights[Col * SizeVerts + SrcX] = (uint16)((int32)Samples[Row * SizeVerts + Col].height + 32768);
+		}
+	}
+}
+#endif // WITH_PHYSX
+
+/** Collision components with a region to patch into their heightfields at the end of the frame */
+static TArray<TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>> GPendingHeightfieldUpdates;
+
+/** Bound to OnEndFrame while GPendingHeightfieldUpdates isn't empty */
+static FDelegateHandle GPendingHeightfieldUpdatesHandle;
+
 #if WITH_EDITOR
 void UCyLandHeightfieldCollisionComponent::UpdateHeightfieldRegion(int32 ComponentX1, int32 ComponentY1, int32 ComponentX2, int32 ComponentY2)
 {
+	// Editor tools patch from CollisionHeightData, heights set at runtime are overwritten
+	RuntimeCollisionHeights.Empty();
+	QueueHeightfieldRegion(ComponentX1, ComponentY1, ComponentX2, ComponentY2);
+}
+#endif// WITH_EDITOR
+
+void UCyLandHeightfieldCollisionComponent::SetCollisionHeights(int32 CollisionX1, int32 CollisionY1, int32 CollisionX2, int32 CollisionY2, const uint16* Heights)
+{
+#if WITH_PHYSX
+	const int32 CollisionSizeVerts = CollisionSizeQuads + 1;
+	if (!ensure(CollisionX1 >= 0 && CollisionY1 >= 0 && CollisionX2 < CollisionSizeVerts && CollisionY2 < CollisionSizeVerts && CollisionX1 <= CollisionX2 && CollisionY1 <= CollisionY2))
+	{
+		return;
+	}
+
+#if WITH_EDITOR
+	// The live heights are read from the cooked heightfield, not the placeholder
+	FinishAsyncCollisionCook();
+#endif
+
+	if (!IsValidRef(HeightfieldRef) || HeightfieldRef->RBHeightfield == nullptr)
+	{
+		return;
+	}
+
+	if (RuntimeCollisionHeights.Num() == 0)
+	{
+		// Read the live heights once, cooked builds don't have CollisionHeightData. Later changes only update the copy
+		const bool bIsMirrored = GetComponentToWorld().GetDeterminant() < 0.f;
+		ReadHeightfieldHeights(HeightfieldRef->RBHeightfield, CollisionSizeVerts, bIsMirrored, RuntimeCollisionHeights);
+	}
+
+	const int32 RegionSizeX = CollisionX2 - CollisionX1 + 1;
+	for (int32 Y = CollisionY1; Y <= CollisionY2; Y++)
+	{
+		FMemory::Memcpy(&RuntimeCollisionHeights[Y * CollisionSizeVerts + CollisionX1], &Heights[(Y - CollisionY1) * RegionSizeX], RegionSizeX * sizeof(uint16));
+	}
+
+	QueueHeightfieldRegion(CollisionX1, CollisionY1, CollisionX2, CollisionY2);
+#endif// WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::QueueHeightfieldRegion(int32 CollisionX1, int32 CollisionY1, int32 CollisionX2, int32 CollisionY2)
+{
+	check(IsInGameThread());
+
+	const FIntRect Region(CollisionX1, CollisionY1, CollisionX2, CollisionY2);
+	if (bHeightfieldRegionPending)
+	{
+		PendingHeightfieldRegion.Union(Region);
+		return;
+	}
+
+	PendingHeightfieldRegion = Region;
+	bHeightfieldRegionPending = true;
+	GPendingHeightfieldUpdates.Add(this);
+
+	if (!GPendingHeightfieldUpdatesHandle.IsValid())
+	{
+		GPendingHeightfieldUpdatesHandle = FCoreDelegates::OnEndFrame.AddStatic(&UCyLandHeightfieldCollisionComponent::FlushHeightfieldUpdates);
+	}
+}
+
+void UCyLandHeightfieldCollisionComponent::FlushHeightfieldUpdates()
+{
+	if (GPendingHeightfieldUpdates.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandHeightfieldRegionUpdate);
+
+	TArray<TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>> Pending = MoveTemp(GPendingHeightfieldUpdates);
+	for (const TWeakObjectPtr<UCyLandHeightfieldCollisionComponent>& Component : Pending)
+	{
+		if (Component.IsValid())
+		{
+			Component->ApplyPendingHeightfieldRegion();
+		}
+	}
+
+	if (GPendingHeightfieldUpdates.Num() == 0 && GPendingHeightfieldUpdatesHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(GPendingHeightfieldUpdatesHandle);
+		GPendingHeightfieldUpdatesHandle.Reset();
+	}
+}
+
+void UCyLandHeightfieldCollisionComponent::ApplyPendingHeightfieldRegion()
+{
+	if (!bHeightfieldRegionPending)
+	{
+		return;
+	}
+
+#if WITH_EDITOR
+	// Regions can't be patched into the placeholder, and the cook may predate the change
+	FinishAsyncCollisionCook();
+#endif
+
+	FIntRect Region = PendingHeightfieldRegion;
+	bHeightfieldRegionPending = false;
+
 #if WITH_PHYSX
-	if (IsValidRef(HeightfieldRef))
+	if (!IsValidRef(HeightfieldRef))
 	{
-		// If we're currently sharing this data with a PIE session, we need to make a new heightfield.
-		if (HeightfieldRef->GetRefCount() > 1)
+		return;
+	}
+
+	const int32 CollisionSizeVerts = CollisionSizeQuads + 1;
+
+	// If we're currently sharing this data with a PIE session, we need to make a new heightfield.
+	// It gets a new Guid, so it is cooked once and the following updates are patched in again.
+	if (HeightfieldRef->GetRefCount() > 1)
+	{
+		TArray<uint16> RuntimeHeights = MoveTemp(RuntimeCollisionHeights);
+		RecreateCollision();
+#if WITH_EDITOR
+		FinishAsyncCollisionCook();
+#endif
+		if (!IsValidRef(HeightfieldRef) || RuntimeHeights.Num() == 0)
 		{
-			RecreateCollision();
 			return;
 		}
 
+		// The new heightfield doesn't have any of the runtime changes yet
+		RuntimeCollisionHeights = MoveTemp(RuntimeHeights);
+		Region = FIntRect(0, 0, CollisionSizeQuads, CollisionSizeQuads);
+	}
+
+	if (HeightfieldRef->RBHeightfield == nullptr)
+	{
+		return;
+	}
+
 #if WITH_CHAOS || WITH_IMMEDIATE_PHYSX || PHYSICS_INTERFACE_LLIMMEDIATE
-        ensure(false);
+	ensure(false);
 #else
-		if (BodyInstance.ActorHandle.SyncActor == NULL)
+	if (BodyInstance.ActorHandle.SyncActor == NULL)
+	{
+		return;
+	}
+
+	const int32 SimpleCollisionSizeVerts = SimpleCollisionSizeQuads > 0 ? SimpleCollisionSizeQuads + 1 : 0;
+	const bool bIsMirrored = GetComponentToWorld().GetDeterminant() < 0.f;
+
+	const uint16* Heights = RuntimeCollisionHeights.Num() == FMath::Square(CollisionSizeVerts) ? RuntimeCollisionHeights.GetData() : nullptr;
+	const uint16* SimpleHeights = nullptr;
+#if WITH_EDITORONLY_DATA
+	bool bLockedHeightData = false;
+	if (Heights == nullptr && CollisionHeightData.GetElementCount() == FMath::Square(CollisionSizeVerts) + FMath::Square(SimpleCollisionSizeVerts))
+	{
+		Heights = (const uint16*)CollisionHeightData.LockReadOnly();
+		SimpleHeights = SimpleCollisionSizeVerts > 0 ? Heights + FMath::Square(CollisionSizeVerts) : nullptr;
+		bLockedHeightData = true;
+	}
+#endif
+	if (Heights == nullptr)
+	{
+		return;
+	}
+
+	// Height range of the region, for the navigation bounds to rebuild
+	uint16 MinHeight = MAX_uint16;
+	uint16 MaxHeight = 0;
+	for (int32 Y = Region.Min.Y; Y <= Region.Max.Y; Y++)
+	{
+		for (int32 X = Region.Min.X; X <= Region.Max.X; X++)
 		{
-			return;
+			const uint16 Height = Heights[Y * CollisionSizeVerts + X];
+			MinHeight = FMath::Min(MinHeight, Height);
+			MaxHeight = FMath::Max(MaxHeight, Height);
 		}
-#endif
+	}
 
-		// We don't lock the async scene as we only set the geometry in the sync scene's RigidActor.
-		// This function is used only during painting for line traces by the painting tools.
-		FPhysicsActorHandle PhysActorHandle = BodyInstance.GetPhysicsActorHandle();
+	// We don't lock the async scene as we only set the geometry in the sync scene's RigidActor.
+	FPhysicsActorHandle PhysActorHandle = BodyInstance.GetPhysicsActorHandle();
+	FPhysicsCommand::ExecuteWrite(PhysActorHandle, [&](const FPhysicsActorHandle& Actor)
+	{
+		auto GetHeight = [&](int32 X, int32 Y) { return Heights[Y * CollisionSizeVerts + X]; };
+		ModifyHeightfieldSamples(HeightfieldRef->RBHeightfield, CollisionSizeVerts, bIsMirrored, Region, GetHeight);
+#if WITH_EDITOR
+		if (HeightfieldRef->RBHeightfieldEd)
+		{
+			ModifyHeightfieldSamples(HeightfieldRef->RBHeightfieldEd, CollisionSizeVerts, bIsMirrored, Region, GetHeight);
+		}
+#endif
 
-		FPhysicsCommand::ExecuteWrite(PhysActorHandle, [&](const FPhysicsActorHandle& Actor)
+		if (HeightfieldRef->RBHeightfieldSimple && SimpleCollisionSizeQuads > 0)
 		{
-			int32 CollisionSizeVerts = CollisionSizeQuads + 1;
-			int32 SimpleCollisionSizeVerts = SimpleCollisionSizeQuads > 0 ? SimpleCollisionSizeQuads + 1 : 0;
-	
-			bool bIsMirrored = GetComponentToWorld().GetDeterminant() < 0.f;
-	
-			uint16* Heights = (uint16*)CollisionHeightData.Lock(LOCK_READ_ONLY);
-			check(CollisionHeightData.GetElementCount() == (FMath::Square(CollisionSizeVerts) + FMath::Square(SimpleCollisionSizeVerts)));
-	
-			// PhysX heightfield has the X and Y axis swapped, and the X component is also inverted
-			int32 HeightfieldX1 = ComponentY1;
-			int32 HeightfieldY1 = (bIsMirrored ? ComponentX1 : (CollisionSizeVerts - ComponentX2 - 1));
-			int32 DstVertsX = ComponentY2 - ComponentY1 + 1;
-			int32 DstVertsY = ComponentX2 - ComponentX1 + 1;
-	
-			TArray<PxHeightFieldSample> Samples;
-			Samples.AddZeroed(DstVertsX*DstVertsY);
-	
-			// Traverse the area in destination heigthfield coordinates
-			for (int32 RowIndex = 0; RowIndex < DstVertsY; RowIndex++)
+			// Only the simple collision vertices touching the region. The simple collision is a mip of the complex one,
+			// so its vertices are CollisionSizeQuads / SimpleCollisionSizeQuads complex quads apart (not always an integer)
+			const float SimpleRatio = (float)CollisionSizeQuads / (float)SimpleCollisionSizeQuads;
+			const FIntRect SimpleRegion(
+				FMath::FloorToInt(Region.Min.X / SimpleRatio),
+				FMath::FloorToInt(Region.Min.Y / SimpleRatio),
+				FMath::Min(FMath::CeilToInt(Region.Max.X / SimpleRatio), SimpleCollisionSizeQuads),
+				FMath::Min(FMath::CeilToInt(Region.Max.Y / SimpleRatio), SimpleCollisionSizeQuads));
+
+			if (SimpleHeights)
 			{
-				for (int32 ColIndex = 0; ColIndex < DstVertsX; ColIndex++)
-				{
-					int32 SrcX = bIsMirrored ? (RowIndex + ComponentX1) : (ComponentX2 - RowIndex);
-					int32 SrcY = ColIndex + ComponentY1;
-					int32 SrcSampleIndex = (SrcY * CollisionSizeVerts) + SrcX;
-					check(SrcSampleIndex < FMath::Square(CollisionSizeVerts));
-					int32 DstSampleIndex = (RowIndex * DstVertsX) + ColIndex;
-	
-					PxHeightFieldSample& Sample = Samples[DstSampleIndex];
-					Sample.height = FMath::Clamp<int32>(((int32)Heights[SrcSampleIndex] - 32768), -32768, 32767);
-	
-					Sample.materialIndex0 = 0;
-					Sample.materialIndex1 = 0;
-				}
+				ModifyHeightfieldSamples(HeightfieldRef->RBHeightfieldSimple, SimpleCollisionSizeVerts, bIsMirrored, SimpleRegion,
+					[&](int32 X, int32 Y) { return SimpleHeights[Y * SimpleCollisionSizeVerts + X]; });
 			}
-	
-			CollisionHeightData.Unlock();
-	
-			PxHeightFieldDesc SubDesc;
-			SubDesc.format = PxHeightFieldFormat::eS16_TM;
-			SubDesc.nbColumns = DstVertsX;
-			SubDesc.nbRows = DstVertsY;
-			SubDesc.samples.data = Samples.GetData();
-			SubDesc.samples.stride = sizeof(PxU32);
-			SubDesc.flags = PxHeightFieldFlag::eNO_BOUNDARY_EDGES;
-	
-			//HeightfieldRef->RBHeightfieldEd->modifySamples(HeightfieldX1, HeightfieldY1, SubDesc, true);
-	
-			//
-			// Reset geometry of heightfield shape. Required by the modifySamples
-			//
-			FVector CyLandScale = GetComponentToWorld().GetScale3D().GetAbs();
-			// Create the geometry
-			PxHeightFieldGeometry CyLandComponentGeom(HeightfieldRef->RBHeightfieldEd, PxMeshGeometryFlags(), CyLandScale.Z * LANDSCAPE_ZSCALE, CyLandScale.Y * CollisionScale, CyLandScale.X * CollisionScale);
-	
+			else
 			{
-				FInlineShapeArray PShapes;
-#if WITH_CHAOS
-				ensure(false);
-				const int32 NumShapes = 0;
-#else
-				const int32 NumShapes = FillInlineShapeArray_AssumesLocked(PShapes, Actor);
-#endif
-				if (NumShapes > 1)
-				{
-					FPhysicsInterface::SetGeometry(PShapes[1], CyLandComponentGeom);
-				}
+				// Runtime heights have no simple collision mip, point sample the full resolution
+				ModifyHeightfieldSamples(HeightfieldRef->RBHeightfieldSimple, SimpleCollisionSizeVerts, bIsMirrored, SimpleRegion,
+					[&](int32 X, int32 Y)
+					{
+						const int32 SrcX = FMath::Min(FMath::RoundToInt(X * SimpleRatio), CollisionSizeQuads);
+						const int32 SrcY = FMath::Min(FMath::RoundToInt(Y * SimpleRatio), CollisionSizeQuads);
+						return Heights[SrcY * CollisionSizeVerts + SrcX];
+					});
 			}
-		});
+		}
+
+		// Reset the geometry of the heightfield shapes, required by modifySamples to update their bounds
+		FInlineShapeArray PShapes;
+		const int32 NumShapes = FillInlineShapeArray_AssumesLocked(PShapes, Actor);
+		for (int32 ShapeIndex = 0; ShapeIndex < NumShapes; ShapeIndex++)
+		{
+			PxHeightFieldGeometry Geometry;
+			if (FPhysicsInterface::GetHeightFieldGeometry(PShapes[ShapeIndex], Geometry))
+			{
+				FPhysicsInterface::SetGeometry(PShapes[ShapeIndex], Geometry);
+			}
+		}
+	});
+
+#if WITH_EDITORONLY_DATA
+	if (bLockedHeightData)
+	{
+		CollisionHeightData.Unlock();
 	}
+#endif
+
+	// Navigation exports the heightfield samples again on its next update
+	CachedHeightFieldSamples = FNavHeightfieldSamples();
 
+	// The heights before the change may have been lower or higher, the whole column over the region is rebuilt
+	const FBox LocalBox(
+		FVector(Region.Min.X * CollisionScale, Region.Min.Y * CollisionScale, FMath::Min(CachedLocalBox.Min.Z, CyLandDataAccess::GetLocalHeight(MinHeight))),
+		FVector(Region.Max.X * CollisionScale, Region.Max.Y * CollisionScale, FMath::Max(CachedLocalBox.Max.Z, CyLandDataAccess::GetLocalHeight(MaxHeight))));
+	DirtyNavigationBounds(LocalBox.TransformBy(GetComponentTransform()));
+
+	FCyLandHeightQuery::UpdateComponent(this);
+#endif
+#endif// WITH_PHYSX
+}
+
+void UCyLandHeightfieldCollisionComponent::DirtyNavigationBounds(const FBox& WorldBounds)
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == nullptr)
+	{
+		return;
+	}
+
+	const FNavigationOctree* NavOctree = NavSys->GetNavOctree();
+	if (NavOctree && NavOctree->IsLazyGathering(*this))
+	{
+		// Lazily gathered heightfields export slices for the tiles being rebuilt, only the ones over the bounds
+		NavSys->AddDirtyArea(WorldBounds, ENavigationDirtyFlag::All);
+	}
+	else
+	{
+		// The octree keeps the geometry exported when the component was registered, it's exported again
+		FNavigationSystem::UpdateComponentData(*this);
+	}
+}
+
+bool UCyLandHeightfieldCollisionComponent::GetCollisionHeights(TArray<uint16>& OutHeights) const
+{
+#if WITH_PHYSX
+	if (!IsValidRef(HeightfieldRef) || HeightfieldRef->RBHeightfield == nullptr || HeightfieldRef->PlaceholderSizeQuads > 0)
+	{
+		return false;
+	}
+
+	const int32 CollisionSizeVerts = CollisionSizeQuads + 1;
+	if (RuntimeCollisionHeights.Num() == FMath::Square(CollisionSizeVerts))
+	{
+		OutHeights = RuntimeCollisionHeights;
+		return true;
+	}
+
+	const bool bIsMirrored = GetComponentToWorld().GetDeterminant() < 0.f;
+	ReadHeightfieldHeights(HeightfieldRef->RBHeightfield, CollisionSizeVerts, bIsMirrored, OutHeights);
+	return true;
+#else
+	return false;
 #endif// WITH_PHYSX
 }
-#endif// WITH_EDITOR
 
 void UCyLandHeightfieldCollisionComponent::DestroyComponent(bool bPromoteChildren/*= false*/)
 {
@@ -1203,6 +1934,11 @@ FBoxSphereBounds UCyLandHeightfieldCollisionComponent::CalcBounds(const FTransfo
 
 void UCyLandHeightfieldCollisionComponent::BeginDestroy()
 {
+	bHeightfieldRegionPending = false;
+	RuntimeCollisionHeights.Empty();
+#if WITH_EDITORONLY_DATA
+	AsyncCollisionCook.Reset();
+#endif
 	HeightfieldRef = NULL;
 	HeightfieldGuid = FGuid();
 	Super::BeginDestroy();
@@ -1223,6 +1959,12 @@ void UCyLandHeightfieldCollisionComponent::RecreateCollision()
 {
 	if (!HasAnyFlags(RF_ClassDefaultObject))
 	{
+#if WITH_EDITORONLY_DATA
+		// The data being cooked is out of date
+		AsyncCollisionCook.Reset();
+#endif
+		// The new heightfield is built from the saved heights
+		RuntimeCollisionHeights.Empty();
 		HeightfieldRef = NULL;
 		HeightfieldGuid = FGuid();
 
@@ -1505,7 +2247,8 @@ bool UCyLandHeightfieldCollisionComponent::DoCustomNavigableGeometryExport(FNavi
 {
 	check(IsInGameThread());
 #if WITH_PHYSX
-	if (IsValidRef(HeightfieldRef) && HeightfieldRef->RBHeightfield)
+	// The placeholder isn't exported, navigation is updated when the cooked heightfield replaces it
+	if (IsValidRef(HeightfieldRef) && HeightfieldRef->RBHeightfield && HeightfieldRef->PlaceholderSizeQuads == 0)
 	{
 		FTransform HFToW = GetComponentTransform();
 		if (HeightfieldRef->RBHeightfieldSimple)
@@ -1546,7 +2289,7 @@ void UCyLandHeightfieldCollisionComponent::PrepareGeometryExportSync()
 {
 	//check(IsInGameThread());
 #if WITH_PHYSX
-	if (IsValidRef(HeightfieldRef) && HeightfieldRef->RBHeightfield != nullptr && CachedHeightFieldSamples.IsEmpty())
+	if (IsValidRef(HeightfieldRef) && HeightfieldRef->RBHeightfield != nullptr && HeightfieldRef->PlaceholderSizeQuads == 0 && CachedHeightFieldSamples.IsEmpty())
 	{
 		const UWorld* World = GetWorld();
 
@@ -2095,6 +2838,7 @@ UCyLandHeightfieldCollisionComponent::UCyLandHeightfieldCollisionComponent(const
 
 	HeightfieldRowsCount = -1;
 	HeightfieldColumnsCount = -1;
+	bHeightfieldRegionPending = false;
 
 	// landscape collision components should be deterministically created and therefor are addressable over the network
 	SetNetAddressable();
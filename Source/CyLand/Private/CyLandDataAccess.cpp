@@ -22,7 +22,8 @@ CYLAND_API FCyLandComponentDataInterface::FCyLandComponentDataInterface(UCyLandC
 	SubsectionSizeVerts = (Component->SubsectionSizeQuads + 1) >> MipLevel;
 	ComponentNumSubsections = Component->NumSubsections;
 
-	if (MipLevel < Component->GetHeightmap(true)->Source.GetNumMips())
+	// The texels of an evicted atlas page belong to another component, the data is then missing as for a mip out of range
+	if (MipLevel < Component->GetHeightmap(true)->Source.GetNumMips() && Component->IsHeightmapResident())
 	{
 		HeightMipData = (FColor*)DataInterface.LockMip(Component->GetHeightmap(true), MipLevel);
 		if (Component->XYOffsetmapTexture)
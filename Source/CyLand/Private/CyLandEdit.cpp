@@ -5,6 +5,8 @@ CyLandEdit.cpp: CyLand editing
 =============================================================================*/
 
 #include "CyLandEdit.h"
+#include "CyLandImportPipeline.h"
+#include "CyLandPlatformData.h"
 #include "Misc/MessageDialog.h"
 #include "Misc/Paths.h"
 #include "Misc/FeedbackContext.h"
@@ -14,6 +16,7 @@ CyLandEdit.cpp: CyLand editing
 #include "Misc/PackageName.h"
 #include "CyLand.h"
 #include "CyLandStreamingProxy.h"
+#include "CyLandHeightmapAtlas.h"
 #include "CyLandInfo.h"
 #include "CyLandComponent.h"
 #include "CyLandLayerInfoObject.h"
@@ -862,11 +865,20 @@ void UCyLandComponent::UpdateCollisionHeightData(const FColor* const HeightmapTe
 	// Material WPO is not currently supported for mesh collision components
 	const bool bUsingGrassMapHeights = Proxy->bBakeMaterialPositionOffsetIntoCollision && !MeshCollisionComponent && GrassData->HasData() && !IsGrassMapOutdated();
 	const uint16* GrassHeights = nullptr;
+	TArray<uint16> DecompressedGrassHeights;
 	if (bUsingGrassMapHeights)
 	{
 		if (CollisionMipLevel == 0)
 		{
-			GrassHeights = GrassData->HeightData.GetData();
+			if (GrassData->IsCompressed())
+			{
+				GrassData->DecompressHeightData(DecompressedGrassHeights);
+				GrassHeights = DecompressedGrassHeights.Num() ? DecompressedGrassHeights.GetData() : nullptr;
+			}
+			else
+			{
+				GrassHeights = GrassData->HeightData.GetData();
+			}
 		}
 		else
 		{
@@ -1398,6 +1410,23 @@ void UCyLandComponent::UpdateCollisionLayerData()
 
 void UCyLandComponent::GenerateHeightmapMips(TArray<FColor*>& HeightmapTextureMipData, int32 ComponentX1/*=0*/, int32 ComponentY1/*=0*/, int32 ComponentX2/*=MAX_int32*/, int32 ComponentY2/*=MAX_int32*/, FCyLandTextureDataInfo* TextureDataInfo/*=nullptr*/)
 {
+	const int32 HeightmapSizeU = GetHeightmap()->Source.GetSizeX();
+	const int32 HeightmapSizeV = GetHeightmap()->Source.GetSizeY();
+
+	const int32 HeightmapOffsetX = FMath::RoundToInt(HeightmapScaleBias.Z * (float)HeightmapSizeU);
+	const int32 HeightmapOffsetY = FMath::RoundToInt(HeightmapScaleBias.W * (float)HeightmapSizeV);
+
+	GenerateHeightmapMipsRaw(ComponentSizeQuads, NumSubsections, SubsectionSizeQuads, HeightmapSizeU, HeightmapSizeV, HeightmapOffsetX, HeightmapOffsetY,
+		HeightmapTextureMipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TextureDataInfo);
+}
+
+void UCyLandComponent::GenerateHeightmapMipsRaw(int32 InComponentSizeQuads, int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 HeightmapSizeU, int32 HeightmapSizeV, int32 HeightmapOffsetX, int32 HeightmapOffsetY,
+	TArray<FColor*>& HeightmapTextureMipData, int32 ComponentX1/*=0*/, int32 ComponentY1/*=0*/, int32 ComponentX2/*=MAX_int32*/, int32 ComponentY2/*=MAX_int32*/, FCyLandTextureDataInfo* TextureDataInfo/*=nullptr*/)
+{
+	const int32 ComponentSizeQuads = InComponentSizeQuads;
+	const int32 NumSubsections = InNumSubsections;
+	const int32 SubsectionSizeQuads = InSubsectionSizeQuads;
+
 	bool EndX = false;
 	bool EndY = false;
 
@@ -1422,12 +1451,6 @@ void UCyLandComponent::GenerateHeightmapMips(TArray<FColor*>& HeightmapTextureMi
 		ComponentY2 = ComponentSizeQuads;
 	}
 
-	int32 HeightmapSizeU = GetHeightmap()->Source.GetSizeX();
-	int32 HeightmapSizeV = GetHeightmap()->Source.GetSizeY();
-
-	int32 HeightmapOffsetX = FMath::RoundToInt(HeightmapScaleBias.Z * (float)HeightmapSizeU);
-	int32 HeightmapOffsetY = FMath::RoundToInt(HeightmapScaleBias.W * (float)HeightmapSizeV);
-
 	for (int32 SubsectionY = 0; SubsectionY < NumSubsections; SubsectionY++)
 	{
 		// Check if subsection is fully above or below the area we are interested in
@@ -1750,9 +1773,12 @@ namespace
 template<typename DataType>
 void UCyLandComponent::UpdateMipsTempl(int32 InNumSubsections, int32 InSubsectionSizeQuads, UTexture2D* Texture, TArray<DataType*>& TextureMipData, int32 ComponentX1/*=0*/, int32 ComponentY1/*=0*/, int32 ComponentX2/*=MAX_int32*/, int32 ComponentY2/*=MAX_int32*/, struct FCyLandTextureDataInfo* TextureDataInfo/*=nullptr*/)
 {
-	int32 WeightmapSizeU = Texture->Source.GetSizeX();
-	int32 WeightmapSizeV = Texture->Source.GetSizeY();
+	UpdateMipsTemplRaw<DataType>(InNumSubsections, InSubsectionSizeQuads, Texture->Source.GetSizeX(), Texture->Source.GetSizeY(), TextureMipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TextureDataInfo);
+}
 
+template<typename DataType>
+void UCyLandComponent::UpdateMipsTemplRaw(int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 WeightmapSizeU, int32 WeightmapSizeV, TArray<DataType*>& TextureMipData, int32 ComponentX1/*=0*/, int32 ComponentY1/*=0*/, int32 ComponentX2/*=MAX_int32*/, int32 ComponentY2/*=MAX_int32*/, struct FCyLandTextureDataInfo* TextureDataInfo/*=nullptr*/)
+{
 	// Find the maximum mip where each texel's data comes from just one subsection.
 	int32 MaxWholeSubsectionMip = FMath::FloorLog2(InSubsectionSizeQuads + 1) - 1;
 
@@ -1918,6 +1944,11 @@ void UCyLandComponent::UpdateWeightmapMips(int32 InNumSubsections, int32 InSubse
 	UpdateMipsTempl<FColor>(InNumSubsections, InSubsectionSizeQuads, WeightmapTexture, WeightmapTextureMipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TextureDataInfo);
 }
 
+void UCyLandComponent::UpdateWeightmapMipsRaw(int32 InNumSubsections, int32 InSubsectionSizeQuads, int32 WeightmapSizeU, int32 WeightmapSizeV, TArray<FColor*>& WeightmapTextureMipData)
+{
+	UpdateMipsTemplRaw<FColor>(InNumSubsections, InSubsectionSizeQuads, WeightmapSizeU, WeightmapSizeV, WeightmapTextureMipData);
+}
+
 void UCyLandComponent::UpdateDataMips(int32 InNumSubsections, int32 InSubsectionSizeQuads, UTexture2D* Texture, TArray<uint8*>& TextureMipData, int32 ComponentX1/*=0*/, int32 ComponentY1/*=0*/, int32 ComponentX2/*=MAX_int32*/, int32 ComponentY2/*=MAX_int32*/, struct FCyLandTextureDataInfo* TextureDataInfo/*=nullptr*/)
 {
 	UpdateMipsTempl<uint8>(InNumSubsections, InSubsectionSizeQuads, Texture, TextureMipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TextureDataInfo);
@@ -2031,33 +2062,6 @@ void UCyLandInfo::GetComponentsInRegion(int32 X1, int32 Y1, int32 X2, int32 Y2,
 	}
 }
 
-// A struct to remember where we have spare texture channels.
-struct FWeightmapTextureAllocation
-{
-	int32 X;
-	int32 Y;
-	int32 ChannelsInUse;
-	UTexture2D* Texture;
-	FColor* TextureData;
-
-	FWeightmapTextureAllocation(int32 InX, int32 InY, int32 InChannels, UTexture2D* InTexture, FColor* InTextureData)
-		: X(InX)
-		, Y(InY)
-		, ChannelsInUse(InChannels)
-		, Texture(InTexture)
-		, TextureData(InTextureData)
-	{}
-};
-
-// A struct to hold the info about each texture chunk of the total heightmap
-struct FHeightmapInfo
-{
-	int32 HeightmapSizeU;
-	int32 HeightmapSizeV;
-	UTexture2D* HeightmapTexture;
-	TArray<FColor*> HeightmapTextureMipData;
-};
-
 TArray<FName> ACyLandProxy::GetLayersFromMaterial(UMaterialInterface* MaterialInterface)
 {
 	TArray<FName> Result;
@@ -2142,7 +2146,6 @@ UCyLandLayerInfoObject* ACyLandProxy::CreateLayerInfo(const TCHAR* LayerName)
 	return LayerInfo;
 }
 
-#define HEIGHTDATA(X,Y) (HeightData[ FMath::Clamp<int32>(Y,0,VertsY) * VertsX + FMath::Clamp<int32>(X,0,VertsX) ])
 CYLAND_API void ACyLandProxy::Imports(
 	const FGuid Guid,
 	const int32 MinX, const int32 MinY, const int32 MaxX, const int32 MaxY,
@@ -2153,12 +2156,25 @@ CYLAND_API void ACyLandProxy::Imports(
 	UE_LOG(LogCyLand, Warning, TEXT("ACyLandProxy Importing ... "));
 	GWarn->BeginSlowTask(LOCTEXT("BeingImportingCyLandTask", "Importing CyLand"), true);
 
-	const int32 VertsX = MaxX - MinX + 1;
-	const int32 VertsY = MaxY - MinY + 1;
+	FCyLandImportPayload Payload(GetRootComponent()->RelativeScale3D, MinX, MinY, MaxX, MaxY, InNumSubsections, InSubsectionSizeQuads, HeightData, ImportLayerInfos, ImportLayerType);
+	Payload.Build();
 
-	ComponentSizeQuads = InNumSubsections * InSubsectionSizeQuads;
-	NumSubsections = InNumSubsections;
-	SubsectionSizeQuads = InSubsectionSizeQuads;
+	ImportsFromPayload(Guid, Payload, HeightmapFileName, ImportLayerInfos);
+
+	GWarn->EndSlowTask();
+}
+
+CYLAND_API void ACyLandProxy::ImportsFromPayload(const FGuid Guid, FCyLandImportPayload& Payload, const TCHAR* const HeightmapFileName, const TArray<FCyLandImportLayerInfo>& ImportLayerInfos, UCyLandHeightmapAtlas* const HeightmapAtlas)
+{
+	check(IsInGameThread());
+	check(Payload.IsBuilt());
+
+	const int32 NumComponentsX = Payload.NumComponentsX;
+	const int32 NumComponentsY = Payload.NumComponentsY;
+
+	ComponentSizeQuads = Payload.ComponentSizeQuads;
+	NumSubsections = Payload.NumSubsections;
+	SubsectionSizeQuads = Payload.SubsectionSizeQuads;
 	CyLandGuid = Guid;
 
 	Modify();
@@ -2166,12 +2182,6 @@ CYLAND_API void ACyLandProxy::Imports(
 	// Create and initialize landscape info object
 	UCyLandInfo* CyLandInfo = CreateCyLandInfo();
 
-	const int32 NumPatchesX = (VertsX - 1);
-	const int32 NumPatchesY = (VertsY - 1);
-
-	const int32 NumComponentsX = NumPatchesX / ComponentSizeQuads;
-	const int32 NumComponentsY = NumPatchesY / ComponentSizeQuads;
-
 	// currently only support importing into a new/blank landscape actor/proxy
 	check(CyLandComponents.Num() == 0);
 	CyLandComponents.Empty(NumComponentsX * NumComponentsY);
@@ -2180,8 +2190,8 @@ CYLAND_API void ACyLandProxy::Imports(
 	{
 		for (int32 X = 0; X < NumComponentsX; X++)
 		{
-			const int32 BaseX = MinX + X * ComponentSizeQuads;
-			const int32 BaseY = MinY + Y * ComponentSizeQuads;
+			const int32 BaseX = Payload.MinX + X * ComponentSizeQuads;
+			const int32 BaseY = Payload.MinY + Y * ComponentSizeQuads;
 
 			UCyLandComponent* CyLandComponent = NewObject<UCyLandComponent>(this, NAME_None, RF_Transactional);
 			CyLandComponent->SetRelativeLocation(FVector(BaseX, BaseY, 0));
@@ -2199,513 +2209,101 @@ CYLAND_API void ACyLandProxy::Imports(
 		}
 	}
 
-	// Ensure that we don't pack so many heightmaps into a texture that their lowest LOD isn't guaranteed to be resident
-#define MAX_HEIGHTMAP_TEXTURE_SIZE 512
-	const int32 ComponentSizeVerts = NumSubsections * (SubsectionSizeQuads + 1);
-	const int32 ComponentsPerHeightmap = FMath::Min(MAX_HEIGHTMAP_TEXTURE_SIZE / ComponentSizeVerts, 1 << (UTexture2D::GetMinTextureResidentMipCount() - 2));
-	check(ComponentsPerHeightmap > 0);
-
-	// Count how many heightmaps we need and the X dimension of the final heightmap
-	int32 NumHeightmapsX = 1;
-	int32 FinalComponentsX = NumComponentsX;
-	while (FinalComponentsX > ComponentsPerHeightmap)
-	{
-		FinalComponentsX -= ComponentsPerHeightmap;
-		NumHeightmapsX++;
-	}
-	// Count how many heightmaps we need and the Y dimension of the final heightmap
-	int32 NumHeightmapsY = 1;
-	int32 FinalComponentsY = NumComponentsY;
-	while (FinalComponentsY > ComponentsPerHeightmap)
-	{
-		FinalComponentsY -= ComponentsPerHeightmap;
-		NumHeightmapsY++;
-	}
-
-	TArray<FHeightmapInfo> HeightmapInfos;
+	TArray<UTexture2D*> PendingTexturePlatformDataCreation;
 
-	for (int32 HmY = 0; HmY < NumHeightmapsY; HmY++)
+	// Copy the prebuilt source mips into the heightmap textures, atlas pages are copied per component below
+	TArray<UTexture2D*> HeightmapTextures;
+	if (!HeightmapAtlas)
 	{
-		for (int32 HmX = 0; HmX < NumHeightmapsX; HmX++)
+		for (const FCyLandImportHeightmapData& Heightmap : Payload.Heightmaps)
 		{
-			FHeightmapInfo& HeightmapInfo = HeightmapInfos[HeightmapInfos.AddZeroed()];
-
-			// make sure the heightmap UVs are powers of two.
-			HeightmapInfo.HeightmapSizeU = (1 << FMath::CeilLogTwo(((HmX == NumHeightmapsX - 1) ? FinalComponentsX : ComponentsPerHeightmap) * ComponentSizeVerts));
-			HeightmapInfo.HeightmapSizeV = (1 << FMath::CeilLogTwo(((HmY == NumHeightmapsY - 1) ? FinalComponentsY : ComponentsPerHeightmap) * ComponentSizeVerts));
-
-			// Construct the heightmap textures
-			HeightmapInfo.HeightmapTexture = CreateCyLandTexture(HeightmapInfo.HeightmapSizeU, HeightmapInfo.HeightmapSizeV, TEXTUREGROUP_Terrain_Heightmap, TSF_BGRA8);
-
-			int32 MipSubsectionSizeQuads = SubsectionSizeQuads;
-			int32 MipSizeU = HeightmapInfo.HeightmapSizeU;
-			int32 MipSizeV = HeightmapInfo.HeightmapSizeV;
-			while (MipSizeU > 1 && MipSizeV > 1 && MipSubsectionSizeQuads >= 1)
+			UTexture2D* const HeightmapTexture = CreateCyLandTexture(Heightmap.SizeU, Heightmap.SizeV, TEXTUREGROUP_Terrain_Heightmap, TSF_BGRA8);
+			for (int32 MipIndex = 0; MipIndex < Heightmap.Mips.Num(); MipIndex++)
 			{
-				int32 MipIndex = HeightmapInfo.HeightmapTextureMipData.Num();
-				FColor* HeightmapTextureData = (FColor*)HeightmapInfo.HeightmapTexture->Source.LockMip(MipIndex);
-				FMemory::Memzero(HeightmapTextureData, MipSizeU*MipSizeV*sizeof(FColor));
-				HeightmapInfo.HeightmapTextureMipData.Add(HeightmapTextureData);
-
-				MipSizeU >>= 1;
-				MipSizeV >>= 1;
-
-				MipSubsectionSizeQuads = ((MipSubsectionSizeQuads + 1) >> 1) - 1;
+				FMemory::Memcpy(HeightmapTexture->Source.LockMip(MipIndex), Heightmap.Mips[MipIndex].GetData(), Heightmap.Mips[MipIndex].Num() * sizeof(FColor));
+				HeightmapTexture->Source.UnlockMip(MipIndex);
 			}
+			HeightmapTextures.Add(HeightmapTexture);
 		}
 	}
 
-	const FVector DrawScale3D = GetRootComponent()->RelativeScale3D;
-
-	// Calculate the normals for each of the two triangles per quad.
-	TArray<FVector> VertexNormals;
-	VertexNormals.AddZeroed(VertsX * VertsY);
-	for (int32 QuadY = 0; QuadY < NumPatchesY; QuadY++)
+	// Weightmaps store their whole mip chain
+	TArray<UTexture2D*> WeightmapTextures;
+	for (const FCyLandImportWeightmapData& Weightmap : Payload.Weightmaps)
 	{
-		for (int32 QuadX = 0; QuadX < NumPatchesX; QuadX++)
+		UTexture2D* const WeightmapTexture = CreateCyLandTexture(Payload.WeightmapSize, Payload.WeightmapSize, TEXTUREGROUP_Terrain_Weightmap, TSF_BGRA8);
+		for (int32 MipIndex = 0; MipIndex < Weightmap.Mips.Num(); MipIndex++)
 		{
-			const FVector Vert00 = FVector(0.0f, 0.0f, ((float)HEIGHTDATA(QuadX + 0, QuadY + 0) - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale3D;
-			const FVector Vert01 = FVector(0.0f, 1.0f, ((float)HEIGHTDATA(QuadX + 0, QuadY + 1) - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale3D;
-			const FVector Vert10 = FVector(1.0f, 0.0f, ((float)HEIGHTDATA(QuadX + 1, QuadY + 0) - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale3D;
-			const FVector Vert11 = FVector(1.0f, 1.0f, ((float)HEIGHTDATA(QuadX + 1, QuadY + 1) - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale3D;
-
-			const FVector FaceNormal1 = ((Vert00 - Vert10) ^ (Vert10 - Vert11)).GetSafeNormal();
-			const FVector FaceNormal2 = ((Vert11 - Vert01) ^ (Vert01 - Vert00)).GetSafeNormal();
-
-			// contribute to the vertex normals.
-			VertexNormals[(QuadX + 1 + VertsX * (QuadY + 0))] += FaceNormal1;
-			VertexNormals[(QuadX + 0 + VertsX * (QuadY + 1))] += FaceNormal2;
-			VertexNormals[(QuadX + 0 + VertsX * (QuadY + 0))] += FaceNormal1 + FaceNormal2;
-			VertexNormals[(QuadX + 1 + VertsX * (QuadY + 1))] += FaceNormal1 + FaceNormal2;
+			FMemory::Memcpy(WeightmapTexture->Source.LockMip(MipIndex), Weightmap.Mips[MipIndex].GetData(), Weightmap.Mips[MipIndex].Num() * sizeof(FColor));
+			WeightmapTexture->Source.UnlockMip(MipIndex);
 		}
-	}
-
-	// Weight values for each layer for each component.
-	TArray<TArray<TArray<uint8>>> ComponentWeightValues;
-	ComponentWeightValues.AddZeroed(NumComponentsX * NumComponentsY);
-
-	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
-	{
-		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
-		{
-			UCyLandComponent* const CyLandComponent = CyLandComponents[ComponentX + ComponentY*NumComponentsX];
-			TArray<TArray<uint8>>& WeightValues = ComponentWeightValues[ComponentX + ComponentY*NumComponentsX];
-
-			// Import alphamap data into local array and check for unused layers for this component.
-			TArray<FCyLandComponentAlphaInfo, TInlineAllocator<16>> EditingAlphaLayerData;
-			for (int32 LayerIndex = 0; LayerIndex < ImportLayerInfos.Num(); LayerIndex++)
-			{
-				FCyLandComponentAlphaInfo* NewAlphaInfo = new(EditingAlphaLayerData) FCyLandComponentAlphaInfo(CyLandComponent, LayerIndex);
-
-				if (ImportLayerInfos[LayerIndex].LayerData.Num())
-				{
-					for (int32 AlphaY = 0; AlphaY <= CyLandComponent->ComponentSizeQuads; AlphaY++)
-					{
-						const uint8* const OldAlphaRowStart = &ImportLayerInfos[LayerIndex].LayerData[(AlphaY + CyLandComponent->GetSectionBase().Y - MinY) * VertsX + (CyLandComponent->GetSectionBase().X - MinX)];
-						uint8* const NewAlphaRowStart = &NewAlphaInfo->AlphaValues[AlphaY * (CyLandComponent->ComponentSizeQuads + 1)];
-						FMemory::Memcpy(NewAlphaRowStart, OldAlphaRowStart, CyLandComponent->ComponentSizeQuads + 1);
-					}
-				}
-			}
-
-			for (int32 AlphaMapIndex = 0; AlphaMapIndex < EditingAlphaLayerData.Num(); AlphaMapIndex++)
-			{
-				if (EditingAlphaLayerData[AlphaMapIndex].IsLayerAllZero())
-				{
-					EditingAlphaLayerData.RemoveAt(AlphaMapIndex);
-					AlphaMapIndex--;
-				}
-			}
-
+		WeightmapUsageMap.Add(WeightmapTexture, FCyLandWeightmapUsage());
+		WeightmapTextures.Add(WeightmapTexture);
 
-			UE_LOG(LogCyLand, Log, TEXT("%s needs %d alphamaps"), *CyLandComponent->GetName(), EditingAlphaLayerData.Num());
-
-			// Calculate weightmap weights for this component
-			WeightValues.Empty(EditingAlphaLayerData.Num());
-			WeightValues.AddZeroed(EditingAlphaLayerData.Num());
-			CyLandComponent->WeightmapLayerAllocations.Empty(EditingAlphaLayerData.Num());
-
-			TArray<bool, TInlineAllocator<16>> IsNoBlendArray;
-			IsNoBlendArray.Empty(EditingAlphaLayerData.Num());
-			IsNoBlendArray.AddZeroed(EditingAlphaLayerData.Num());
-
-			for (int32 WeightLayerIndex = 0; WeightLayerIndex < WeightValues.Num(); WeightLayerIndex++)
-			{
-				// Lookup the original layer name
-				WeightValues[WeightLayerIndex] = EditingAlphaLayerData[WeightLayerIndex].AlphaValues;
-				new(CyLandComponent->WeightmapLayerAllocations) FCyWeightmapLayerAllocationInfo(ImportLayerInfos[EditingAlphaLayerData[WeightLayerIndex].LayerIndex].LayerInfo);
-				IsNoBlendArray[WeightLayerIndex] = ImportLayerInfos[EditingAlphaLayerData[WeightLayerIndex].LayerIndex].LayerInfo->bNoWeightBlend;
-			}
-
-			// Discard the temporary alpha data
-			EditingAlphaLayerData.Empty();
-
-			if (ImportLayerType == ECyLandImportAlphamapType::Layered)
-			{
-				// For each layer...
-				for (int32 WeightLayerIndex = WeightValues.Num() - 1; WeightLayerIndex >= 0; WeightLayerIndex--)
-				{
-					// ... multiply all lower layers'...
-					for (int32 BelowWeightLayerIndex = WeightLayerIndex - 1; BelowWeightLayerIndex >= 0; BelowWeightLayerIndex--)
-					{
-						int32 TotalWeight = 0;
-
-						if (IsNoBlendArray[BelowWeightLayerIndex])
-						{
-							continue; // skip no blend
-						}
-
-						// ... values by...
-						for (int32 Idx = 0; Idx < WeightValues[WeightLayerIndex].Num(); Idx++)
-						{
-							// ... one-minus the current layer's values
-							int32 NewValue = (int32)WeightValues[BelowWeightLayerIndex][Idx] * (int32)(255 - WeightValues[WeightLayerIndex][Idx]) / 255;
-							WeightValues[BelowWeightLayerIndex][Idx] = (uint8)NewValue;
-							TotalWeight += NewValue;
-						}
-
-						if (TotalWeight == 0)
-						{
-							// Remove the layer as it has no contribution
-							WeightValues.RemoveAt(BelowWeightLayerIndex);
-							CyLandComponent->WeightmapLayerAllocations.RemoveAt(BelowWeightLayerIndex);
-							IsNoBlendArray.RemoveAt(BelowWeightLayerIndex);
-
-							// The current layer has been re-numbered
-							WeightLayerIndex--;
-						}
-					}
-				}
-			}
-
-			// Weight normalization for total should be 255...
-			if (WeightValues.Num())
-			{
-				for (int32 Idx = 0; Idx < WeightValues[0].Num(); Idx++)
-				{
-					int32 TotalWeight = 0;
-					int32 MaxLayerIdx = -1;
-					int32 MaxWeight = INT_MIN;
-
-					for (int32 WeightLayerIndex = 0; WeightLayerIndex < WeightValues.Num(); WeightLayerIndex++)
-					{
-						if (!IsNoBlendArray[WeightLayerIndex])
-						{
-							int32 Weight = WeightValues[WeightLayerIndex][Idx];
-							TotalWeight += Weight;
-							if (MaxWeight < Weight)
-							{
-								MaxWeight = Weight;
-								MaxLayerIdx = WeightLayerIndex;
-							}
-						}
-					}
-
-					if (TotalWeight == 0)
-					{
-						if (MaxLayerIdx >= 0)
-						{
-							WeightValues[MaxLayerIdx][Idx] = 255;
-						}
-					}
-					else if (TotalWeight != 255)
-					{
-						// normalization...
-						float Factor = 255.0f / TotalWeight;
-						TotalWeight = 0;
-						for (int32 WeightLayerIndex = 0; WeightLayerIndex < WeightValues.Num(); WeightLayerIndex++)
-						{
-							if (!IsNoBlendArray[WeightLayerIndex])
-							{
-								WeightValues[WeightLayerIndex][Idx] = (uint8)(Factor * WeightValues[WeightLayerIndex][Idx]);
-								TotalWeight += WeightValues[WeightLayerIndex][Idx];
-							}
-						}
-
-						if (255 - TotalWeight && MaxLayerIdx >= 0)
-						{
-							WeightValues[MaxLayerIdx][Idx] += 255 - TotalWeight;
-						}
-					}
-				}
-			}
-		}
+		WeightmapTexture->BeginCachePlatformData();
+		WeightmapTexture->ClearAllCachedCookedPlatformData();
+		PendingTexturePlatformDataCreation.Add(WeightmapTexture);
 	}
 
-	// Remember where we have spare texture channels.
-	TArray<FWeightmapTextureAllocation> TextureAllocations;
+	// Weightmap is sized the same as the component
+	const int32 WeightmapSize = Payload.WeightmapSize;
+	// Should be power of two
+	check(FMath::IsPowerOfTwo(WeightmapSize));
 
-	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
+	for (int32 ComponentIndex = 0; ComponentIndex < CyLandComponents.Num(); ComponentIndex++)
 	{
-		const int32 HmY = ComponentY / ComponentsPerHeightmap;
-		const int32 HeightmapOffsetY = (ComponentY - ComponentsPerHeightmap*HmY) * NumSubsections * (SubsectionSizeQuads + 1);
+		UCyLandComponent* CyLandComponent = CyLandComponents[ComponentIndex];
+		const FCyLandImportComponentData& ComponentData = Payload.Components[ComponentIndex];
+		const FCyLandImportHeightmapData& Heightmap = Payload.Heightmaps[ComponentData.HeightmapIndex];
 
-		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
+		if (HeightmapAtlas)
 		{
-			const int32 HmX = ComponentX / ComponentsPerHeightmap;
-			const FHeightmapInfo& HeightmapInfo = HeightmapInfos[HmX + HmY * NumHeightmapsX];
-
-			UCyLandComponent* CyLandComponent = CyLandComponents[ComponentX + ComponentY*NumComponentsX];
-
-			// Lookup array of weight values for this component.
-			const TArray<TArray<uint8>>& WeightValues = ComponentWeightValues[ComponentX + ComponentY*NumComponentsX];
-
-			// Heightmap offsets
-			const int32 HeightmapOffsetX = (ComponentX - ComponentsPerHeightmap*HmX) * NumSubsections * (SubsectionSizeQuads + 1);
-
-			CyLandComponent->HeightmapScaleBias = FVector4(1.0f / (float)HeightmapInfo.HeightmapSizeU, 1.0f / (float)HeightmapInfo.HeightmapSizeV, (float)((HeightmapOffsetX)) / (float)HeightmapInfo.HeightmapSizeU, ((float)(HeightmapOffsetY)) / (float)HeightmapInfo.HeightmapSizeV);
-			CyLandComponent->SetHeightmap(HeightmapInfo.HeightmapTexture);
-
-			// Weightmap is sized the same as the component
-			const int32 WeightmapSize = (SubsectionSizeQuads + 1) * NumSubsections;
-			// Should be power of two
-			check(FMath::IsPowerOfTwo(WeightmapSize));
-
-			CyLandComponent->WeightmapScaleBias = FVector4(1.0f / (float)WeightmapSize, 1.0f / (float)WeightmapSize, 0.5f / (float)WeightmapSize, 0.5f / (float)WeightmapSize);
-			CyLandComponent->WeightmapSubsectionOffset = (float)(SubsectionSizeQuads + 1) / (float)WeightmapSize;
-
-			// Pointers to the texture data where we'll store each layer. Stride is 4 (FColor)
-			TArray<uint8*> WeightmapTextureDataPointers;
-
-			UE_LOG(LogCyLand, Log, TEXT("%s needs %d weightmap channels"), *CyLandComponent->GetName(), WeightValues.Num());
-
-			// Find texture channels to store each layer.
-			int32 LayerIndex = 0;
-			while (LayerIndex < WeightValues.Num())
-			{
-				const int32 RemainingLayers = WeightValues.Num() - LayerIndex;
-
-				int32 BestAllocationIndex = -1;
-
-				// if we need less than 4 channels, try to find them somewhere to put all of them
-				if (RemainingLayers < 4)
-				{
-					int32 BestDistSquared = MAX_int32;
-					for (int32 TryAllocIdx = 0; TryAllocIdx < TextureAllocations.Num(); TryAllocIdx++)
-					{
-						if (TextureAllocations[TryAllocIdx].ChannelsInUse + RemainingLayers <= 4)
-						{
-							FWeightmapTextureAllocation& TryAllocation = TextureAllocations[TryAllocIdx];
-							const int32 TryDistSquared = FMath::Square(TryAllocation.X - ComponentX) + FMath::Square(TryAllocation.Y - ComponentY);
-							if (TryDistSquared < BestDistSquared)
-							{
-								BestDistSquared = TryDistSquared;
-								BestAllocationIndex = TryAllocIdx;
-							}
-						}
-					}
-				}
-
-				if (BestAllocationIndex != -1)
-				{
-					FWeightmapTextureAllocation& Allocation = TextureAllocations[BestAllocationIndex];
-					FCyLandWeightmapUsage& WeightmapUsage = WeightmapUsageMap.FindChecked(Allocation.Texture);
-
-					UE_LOG(LogCyLand, Log, TEXT("  ==> Storing %d channels starting at %s[%d]"), RemainingLayers, *Allocation.Texture->GetName(), Allocation.ChannelsInUse);
-
-					for (int32 i = 0; i < RemainingLayers; i++)
-					{
-						CyLandComponent->WeightmapLayerAllocations[LayerIndex + i].WeightmapTextureIndex = CyLandComponent->WeightmapTextures.Num();
-						CyLandComponent->WeightmapLayerAllocations[LayerIndex + i].WeightmapTextureChannel = Allocation.ChannelsInUse;
-						WeightmapUsage.ChannelUsage[Allocation.ChannelsInUse] = CyLandComponent;
-						switch (Allocation.ChannelsInUse)
-						{
-						case 1:
-							WeightmapTextureDataPointers.Add((uint8*)&Allocation.TextureData->G);
-							break;
-						case 2:
-							WeightmapTextureDataPointers.Add((uint8*)&Allocation.TextureData->B);
-							break;
-						case 3:
-							WeightmapTextureDataPointers.Add((uint8*)&Allocation.TextureData->A);
-							break;
-						default:
-							// this should not occur.
-							check(0);
-
-						}
-						Allocation.ChannelsInUse++;
-					}
-
-					LayerIndex += RemainingLayers;
-					CyLandComponent->WeightmapTextures.Add(Allocation.Texture);
-				}
-				else
-				{
-					// We couldn't find a suitable place for these layers, so lets make a new one.
-					UTexture2D* const WeightmapTexture = CreateCyLandTexture(WeightmapSize, WeightmapSize, TEXTUREGROUP_Terrain_Weightmap, TSF_BGRA8);
-					FColor* const MipData = (FColor*)WeightmapTexture->Source.LockMip(0);
-
-					const int32 ThisAllocationLayers = FMath::Min<int32>(RemainingLayers, 4);
-					new(TextureAllocations) FWeightmapTextureAllocation(ComponentX, ComponentY, ThisAllocationLayers, WeightmapTexture, MipData);
-					FCyLandWeightmapUsage& WeightmapUsage = WeightmapUsageMap.Add(WeightmapTexture, FCyLandWeightmapUsage());
-
-					UE_LOG(LogCyLand, Log, TEXT("  ==> Storing %d channels in new texture %s"), ThisAllocationLayers, *WeightmapTexture->GetName());
-
-					WeightmapTextureDataPointers.Add((uint8*)&MipData->R);
-					CyLandComponent->WeightmapLayerAllocations[LayerIndex + 0].WeightmapTextureIndex = CyLandComponent->WeightmapTextures.Num();
-					CyLandComponent->WeightmapLayerAllocations[LayerIndex + 0].WeightmapTextureChannel = 0;
-					WeightmapUsage.ChannelUsage[0] = CyLandComponent;
-
-					if (ThisAllocationLayers > 1)
-					{
-						WeightmapTextureDataPointers.Add((uint8*)&MipData->G);
-						CyLandComponent->WeightmapLayerAllocations[LayerIndex + 1].WeightmapTextureIndex = CyLandComponent->WeightmapTextures.Num();
-						CyLandComponent->WeightmapLayerAllocations[LayerIndex + 1].WeightmapTextureChannel = 1;
-						WeightmapUsage.ChannelUsage[1] = CyLandComponent;
-
-						if (ThisAllocationLayers > 2)
-						{
-							WeightmapTextureDataPointers.Add((uint8*)&MipData->B);
-							CyLandComponent->WeightmapLayerAllocations[LayerIndex + 2].WeightmapTextureIndex = CyLandComponent->WeightmapTextures.Num();
-							CyLandComponent->WeightmapLayerAllocations[LayerIndex + 2].WeightmapTextureChannel = 2;
-							WeightmapUsage.ChannelUsage[2] = CyLandComponent;
-
-							if (ThisAllocationLayers > 3)
-							{
-								WeightmapTextureDataPointers.Add((uint8*)&MipData->A);
-								CyLandComponent->WeightmapLayerAllocations[LayerIndex + 3].WeightmapTextureIndex = CyLandComponent->WeightmapTextures.Num();
-								CyLandComponent->WeightmapLayerAllocations[LayerIndex + 3].WeightmapTextureChannel = 3;
-								WeightmapUsage.ChannelUsage[3] = CyLandComponent;
-							}
-						}
-					}
-					CyLandComponent->WeightmapTextures.Add(WeightmapTexture);
-
-					LayerIndex += ThisAllocationLayers;
-				}
-			}
-			check(WeightmapTextureDataPointers.Num() == WeightValues.Num());
-
-			FBox LocalBox(ForceInit);
-			for (int32 SubsectionY = 0; SubsectionY < NumSubsections; SubsectionY++)
-			{
-				for (int32 SubsectionX = 0; SubsectionX < NumSubsections; SubsectionX++)
-				{
-					for (int32 SubY = 0; SubY <= SubsectionSizeQuads; SubY++)
-					{
-						for (int32 SubX = 0; SubX <= SubsectionSizeQuads; SubX++)
-						{
-							// X/Y of the vertex we're looking at in component's coordinates.
-							const int32 CompX = SubsectionSizeQuads * SubsectionX + SubX;
-							const int32 CompY = SubsectionSizeQuads * SubsectionY + SubY;
-
-							// X/Y of the vertex we're looking indexed into the texture data
-							const int32 TexX = (SubsectionSizeQuads + 1) * SubsectionX + SubX;
-							const int32 TexY = (SubsectionSizeQuads + 1) * SubsectionY + SubY;
-
-							const int32 WeightSrcDataIdx = CompY * (ComponentSizeQuads + 1) + CompX;
-							const int32 HeightTexDataIdx = (HeightmapOffsetX + TexX) + (HeightmapOffsetY + TexY) * (HeightmapInfo.HeightmapSizeU);
-
-							const int32 WeightTexDataIdx = (TexX)+(TexY)* (WeightmapSize);
-
-							// copy height and normal data
-							const uint16 HeightValue = HEIGHTDATA(CompX + CyLandComponent->GetSectionBase().X - MinX, CompY + CyLandComponent->GetSectionBase().Y - MinY);
-							const FVector Normal = VertexNormals[CompX + CyLandComponent->GetSectionBase().X - MinX + VertsX * (CompY + CyLandComponent->GetSectionBase().Y - MinY)].GetSafeNormal();
-
-							HeightmapInfo.HeightmapTextureMipData[0][HeightTexDataIdx].R = HeightValue >> 8;
-							HeightmapInfo.HeightmapTextureMipData[0][HeightTexDataIdx].G = HeightValue & 255;
-							HeightmapInfo.HeightmapTextureMipData[0][HeightTexDataIdx].B = FMath::RoundToInt(127.5f * (Normal.X + 1.0f));
-							HeightmapInfo.HeightmapTextureMipData[0][HeightTexDataIdx].A = FMath::RoundToInt(127.5f * (Normal.Y + 1.0f));
-
-							for (int32 WeightmapIndex = 0; WeightmapIndex < WeightValues.Num(); WeightmapIndex++)
-							{
-								WeightmapTextureDataPointers[WeightmapIndex][WeightTexDataIdx * 4] = WeightValues[WeightmapIndex][WeightSrcDataIdx];
-							}
-
-							// Get local space verts
-							const FVector LocalVertex(CompX, CompY, CyLandDataAccess::GetLocalHeight(HeightValue));
-							LocalBox += LocalVertex;
-						}
-					}
-				}
-			}
-
-			CyLandComponent->CachedLocalBox = LocalBox;
+			HeightmapAtlas->AddPage(CyLandComponent, Heightmap, ComponentData.HeightmapOffsetX, ComponentData.HeightmapOffsetY);
+		}
+		else
+		{
+			CyLandComponent->HeightmapScaleBias = FVector4(1.0f / (float)Heightmap.SizeU, 1.0f / (float)Heightmap.SizeV, (float)((ComponentData.HeightmapOffsetX)) / (float)Heightmap.SizeU, ((float)(ComponentData.HeightmapOffsetY)) / (float)Heightmap.SizeV);
+			CyLandComponent->SetHeightmap(HeightmapTextures[ComponentData.HeightmapIndex]);
 		}
-	}
 
-	TArray<UTexture2D*> PendingTexturePlatformDataCreation;
+		CyLandComponent->WeightmapScaleBias = FVector4(1.0f / (float)WeightmapSize, 1.0f / (float)WeightmapSize, 0.5f / (float)WeightmapSize, 0.5f / (float)WeightmapSize);
+		CyLandComponent->WeightmapSubsectionOffset = (float)(SubsectionSizeQuads + 1) / (float)WeightmapSize;
 
-	// Unlock the weightmaps' base mips
-	for (int32 AllocationIndex = 0; AllocationIndex < TextureAllocations.Num(); AllocationIndex++)
-	{
-		UTexture2D* const WeightmapTexture = TextureAllocations[AllocationIndex].Texture;
-		FColor* const BaseMipData = TextureAllocations[AllocationIndex].TextureData;
+		UE_LOG(LogCyLand, Log, TEXT("%s needs %d weightmap channels"), *CyLandComponent->GetName(), ComponentData.LayerIndices.Num());
 
-		// Generate mips for weightmaps
-		UCyLandComponent::GenerateWeightmapMips(NumSubsections, SubsectionSizeQuads, WeightmapTexture, BaseMipData);
+		CyLandComponent->WeightmapLayerAllocations.Empty(ComponentData.LayerIndices.Num());
+		for (int32 WeightLayerIndex = 0; WeightLayerIndex < ComponentData.LayerIndices.Num(); WeightLayerIndex++)
+		{
+			UTexture2D* const WeightmapTexture = WeightmapTextures[ComponentData.WeightmapIndices[WeightLayerIndex]];
+			const int32 Channel = ComponentData.WeightmapChannels[WeightLayerIndex];
 
-		WeightmapTexture->Source.UnlockMip(0);
+			FCyWeightmapLayerAllocationInfo* Allocation = new(CyLandComponent->WeightmapLayerAllocations) FCyWeightmapLayerAllocationInfo(ImportLayerInfos[ComponentData.LayerIndices[WeightLayerIndex]].LayerInfo);
+			Allocation->WeightmapTextureIndex = CyLandComponent->WeightmapTextures.AddUnique(WeightmapTexture);
+			Allocation->WeightmapTextureChannel = Channel;
+			WeightmapUsageMap.FindChecked(WeightmapTexture).ChannelUsage[Channel] = CyLandComponent;
+		}
 
-		WeightmapTexture->BeginCachePlatformData();
-		WeightmapTexture->ClearAllCachedCookedPlatformData();
-		PendingTexturePlatformDataCreation.Add(WeightmapTexture);
+		CyLandComponent->CachedLocalBox = ComponentData.LocalBox;
 	}
 
-	// Generate mipmaps for the components, and create the collision components
-	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
+	// Create the collision data from the prebuilt mips
+	TArray<FColor*> HeightmapMipData;
+	for (int32 ComponentIndex = 0; ComponentIndex < CyLandComponents.Num(); ComponentIndex++)
 	{
-		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
-		{
-			const int32 HmX = ComponentX / ComponentsPerHeightmap;
-			const int32 HmY = ComponentY / ComponentsPerHeightmap;
-			FHeightmapInfo& HeightmapInfo = HeightmapInfos[HmX + HmY * NumHeightmapsX];
+		UCyLandComponent* CyLandComponent = CyLandComponents[ComponentIndex];
+		Payload.Heightmaps[Payload.Components[ComponentIndex].HeightmapIndex].GetMipPointers(HeightmapMipData);
 
-			UCyLandComponent* CyLandComponent = CyLandComponents[ComponentX + ComponentY*NumComponentsX];
-			CyLandComponent->GenerateHeightmapMips(HeightmapInfo.HeightmapTextureMipData, ComponentX == NumComponentsX - 1 ? MAX_int32 : 0, ComponentY == NumComponentsY - 1 ? MAX_int32 : 0);
-			CyLandComponent->UpdateCollisionHeightData(
-				HeightmapInfo.HeightmapTextureMipData[CyLandComponent->CollisionMipLevel],
-				CyLandComponent->SimpleCollisionMipLevel > CyLandComponent->CollisionMipLevel ? HeightmapInfo.HeightmapTextureMipData[CyLandComponent->SimpleCollisionMipLevel] : nullptr);
-			CyLandComponent->UpdateCollisionLayerData();
-		}
+		CyLandComponent->UpdateCollisionHeightData(
+			HeightmapMipData[CyLandComponent->CollisionMipLevel],
+			CyLandComponent->SimpleCollisionMipLevel > CyLandComponent->CollisionMipLevel ? HeightmapMipData[CyLandComponent->SimpleCollisionMipLevel] : nullptr);
+		CyLandComponent->UpdateCollisionLayerData();
 	}
 
-	for (int32 HmIdx = 0; HmIdx < HeightmapInfos.Num(); HmIdx++)
+	for (UTexture2D* HeightmapTexture : HeightmapTextures)
 	{
-		FHeightmapInfo& HeightmapInfo = HeightmapInfos[HmIdx];
-
-		// Add remaining mips down to 1x1 to heightmap texture. These do not represent quads and are just a simple averages of the previous mipmaps. 
-		// These mips are not used for sampling in the vertex shader but could be sampled in the pixel shader.
-		int32 Mip = HeightmapInfo.HeightmapTextureMipData.Num();
-		int32 MipSizeU = (HeightmapInfo.HeightmapTexture->Source.GetSizeX()) >> Mip;
-		int32 MipSizeV = (HeightmapInfo.HeightmapTexture->Source.GetSizeY()) >> Mip;
-		while (MipSizeU > 1 && MipSizeV > 1)
-		{
-			HeightmapInfo.HeightmapTextureMipData.Add((FColor*)HeightmapInfo.HeightmapTexture->Source.LockMip(Mip));
-			const int32 PrevMipSizeU = (HeightmapInfo.HeightmapTexture->Source.GetSizeX()) >> (Mip - 1);
-			const int32 PrevMipSizeV = (HeightmapInfo.HeightmapTexture->Source.GetSizeY()) >> (Mip - 1);
-
-			for (int32 Y = 0; Y < MipSizeV; Y++)
-			{
-				for (int32 X = 0; X < MipSizeU; X++)
-				{
-					FColor* const TexData = &(HeightmapInfo.HeightmapTextureMipData[Mip])[X + Y * MipSizeU];
-
-					const FColor* const PreMipTexData00 = &(HeightmapInfo.HeightmapTextureMipData[Mip - 1])[(X * 2 + 0) + (Y * 2 + 0) * PrevMipSizeU];
-					const FColor* const PreMipTexData01 = &(HeightmapInfo.HeightmapTextureMipData[Mip - 1])[(X * 2 + 0) + (Y * 2 + 1) * PrevMipSizeU];
-					const FColor* const PreMipTexData10 = &(HeightmapInfo.HeightmapTextureMipData[Mip - 1])[(X * 2 + 1) + (Y * 2 + 0) * PrevMipSizeU];
-					const FColor* const PreMipTexData11 = &(HeightmapInfo.HeightmapTextureMipData[Mip - 1])[(X * 2 + 1) + (Y * 2 + 1) * PrevMipSizeU];
-
-					TexData->R = (((int32)PreMipTexData00->R + (int32)PreMipTexData01->R + (int32)PreMipTexData10->R + (int32)PreMipTexData11->R) >> 2);
-					TexData->G = (((int32)PreMipTexData00->G + (int32)PreMipTexData01->G + (int32)PreMipTexData10->G + (int32)PreMipTexData11->G) >> 2);
-					TexData->B = (((int32)PreMipTexData00->B + (int32)PreMipTexData01->B + (int32)PreMipTexData10->B + (int32)PreMipTexData11->B) >> 2);
-					TexData->A = (((int32)PreMipTexData00->A + (int32)PreMipTexData01->A + (int32)PreMipTexData10->A + (int32)PreMipTexData11->A) >> 2);
-				}
-			}
-			Mip++;
-			MipSizeU >>= 1;
-			MipSizeV >>= 1;
-		}
-
-		for (int32 i = 0; i < HeightmapInfo.HeightmapTextureMipData.Num(); i++)
-		{
-			HeightmapInfo.HeightmapTexture->Source.UnlockMip(i);
-		}
-
-		HeightmapInfo.HeightmapTexture->BeginCachePlatformData();
-		HeightmapInfo.HeightmapTexture->ClearAllCachedCookedPlatformData();
-		PendingTexturePlatformDataCreation.Add(HeightmapInfo.HeightmapTexture);
+		HeightmapTexture->BeginCachePlatformData();
+		HeightmapTexture->ClearAllCachedCookedPlatformData();
+		PendingTexturePlatformDataCreation.Add(HeightmapTexture);
 	}
 
 	for (UTexture2D* Texture : PendingTexturePlatformDataCreation)
@@ -2736,8 +2334,6 @@ CYLAND_API void ACyLandProxy::Imports(
 	CyLandInfo->UpdateLayerInfoMap();
 	CyLandInfo->RecreateCollisionComponents();
 	CyLandInfo->UpdateAllAddCollisions();
-
-	GWarn->EndSlowTask();
 }
 
 bool ACyLandProxy::ExportToRawMesh(int32 InExportLOD, FMeshDescription& OutRawMesh) const
@@ -5202,6 +4798,12 @@ void UCyLandComponent::GenerateMobileWeightmapLayerAllocations()
 }
 
 void UCyLandComponent::GeneratePlatformPixelData()
+{
+	GenerateMobileWeightmapTextures(nullptr);
+	GenerateMobileMaterialInstances();
+}
+
+void UCyLandComponent::GenerateMobileWeightmapTextures(TArray<UTexture2D*>* OutPendingTextures)
 {
 	check(!IsTemplate());
 
@@ -5271,8 +4873,21 @@ void UCyLandComponent::GeneratePlatformPixelData()
 
 	for (int TextureIdx = 0; TextureIdx < MobileWeightmapTextures.Num(); TextureIdx++)
 	{
-		MobileWeightmapTextures[TextureIdx]->PostEditChange();
+		if (OutPendingTextures)
+		{
+			MobileWeightmapTextures[TextureIdx]->BeginCachePlatformData();
+			OutPendingTextures->Add(MobileWeightmapTextures[TextureIdx]);
+		}
+		else
+		{
+			MobileWeightmapTextures[TextureIdx]->PostEditChange();
+		}
 	}
+}
+
+void UCyLandComponent::GenerateMobileMaterialInstances()
+{
+	check(!IsTemplate());
 
 	FLinearColor Masks[4];
 	Masks[0] = FLinearColor(1, 0, 0, 0);
@@ -5379,43 +4994,62 @@ void UCyLandComponent::GeneratePlatformPixelData()
 	}
 }
 
-//
-// Generates vertex buffer data from the component's heightmap texture, for use on platforms without vertex texture fetch
-//
-void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetPlatform)
+FCyLandPlatformVertexSource::FCyLandPlatformVertexSource(const UCyLandComponent* Component, const ITargetPlatform* TargetPlatform, TMap<UTexture2D*, FCyLandPlatformHeightmapMipsPtr>* MipCache)
 {
-	if (IsTemplate())
+	check(IsInGameThread());
+
+	UTexture2D* Heightmap = Component->GetHeightmap();
+	check(Heightmap);
+	check(Heightmap->Source.GetFormat() == TSF_BGRA8);
+
+	SubsectionSizeQuads = Component->SubsectionSizeQuads;
+	NumSubsections = Component->NumSubsections;
+	HeightmapSizeX = Heightmap->Source.GetSizeX();
+	HeightmapSizeY = Heightmap->Source.GetSizeY();
+	HeightmapScaleBias = Component->HeightmapScaleBias;
+
+	const int32 SubsectionSizeVerts = SubsectionSizeQuads + 1;
+	const int32 MaxLOD = FMath::CeilLogTwo(SubsectionSizeVerts) - 1;
+	OcclusionMeshMip = FMath::Clamp<int32>(Component->GetCyLandProxy()->OccluderGeometryLOD, -1, MaxLOD);
+	if (TargetPlatform && !TargetPlatform->SupportsFeature(ETargetPlatformFeatures::SoftwareOcclusion))
 	{
-		return;
+		OcclusionMeshMip = INDEX_NONE;
 	}
-	check(GetHeightmap());
-	check(GetHeightmap()->Source.GetFormat() == TSF_BGRA8);
-
-	TArray<uint8> NewPlatformData;
-	FMemoryWriter PlatformAr(NewPlatformData);
 
-	int32 SubsectionSizeVerts = SubsectionSizeQuads + 1;
-	int32 MaxLOD = FMath::CeilLogTwo(SubsectionSizeVerts) - 1;
+	if (MipCache)
+	{
+		if (const FCyLandPlatformHeightmapMipsPtr* CachedMips = MipCache->Find(Heightmap))
+		{
+			HeightmapMips = *CachedMips;
+			return;
+		}
+	}
 
-	float HeightmapSubsectionOffsetU = (float)(SubsectionSizeVerts) / (float)GetHeightmap()->Source.GetSizeX();
-	float HeightmapSubsectionOffsetV = (float)(SubsectionSizeVerts) / (float)GetHeightmap()->Source.GetSizeY();
-	
 	// Get the required mip data
-	TArray<TArray<uint8>> HeightmapMipRawData;
-	TArray<FColor*> HeightmapMipData;
-	for (int32 MipIdx = 0; MipIdx < FMath::Min(LANDSCAPE_MAX_ES_LOD, GetHeightmap()->Source.GetNumMips()); MipIdx++)
+	HeightmapMips = MakeShared<TArray<TArray<uint8>>, ESPMode::ThreadSafe>();
+	for (int32 MipIdx = 0; MipIdx < FMath::Min(LANDSCAPE_MAX_ES_LOD, Heightmap->Source.GetNumMips()); MipIdx++)
 	{
 		int32 MipSubsectionSizeVerts = (SubsectionSizeVerts) >> MipIdx;
 		if (MipSubsectionSizeVerts > 1)
 		{
-			new(HeightmapMipRawData) TArray<uint8>();
-			GetHeightmap()->Source.GetMipData(HeightmapMipRawData.Last(), MipIdx);
-			HeightmapMipData.Add((FColor*)HeightmapMipRawData.Last().GetData());
+			HeightmapMips->AddDefaulted();
+			Heightmap->Source.GetMipData(HeightmapMips->Last(), MipIdx);
 		}
 	}
 
+	if (MipCache)
+	{
+		MipCache->Add(Heightmap, HeightmapMips);
+	}
+}
+
+void CyLandPlatformData::BuildVertexOrder(int32 SubsectionSizeQuads, int32 NumSubsections, TArray<FCyLandVertexRef>& OutVertexOrder)
+{
+	int32 SubsectionSizeVerts = SubsectionSizeQuads + 1;
+	int32 MaxLOD = FMath::CeilLogTwo(SubsectionSizeVerts) - 1;
+
 	TMap<uint64, int32> VertexMap;
-	TArray<FCyLandVertexRef> VertexOrder;
+	TArray<FCyLandVertexRef>& VertexOrder = OutVertexOrder;
 	VertexOrder.Empty(FMath::Square(SubsectionSizeVerts * NumSubsections));
 
 	// Layout index buffer to determine best vertex order
@@ -5477,12 +5111,35 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 		UE_LOG(LogCyLand, Warning, TEXT("VertexOrder count of %d did not match expected size of %d"), 
 			VertexOrder.Num(), FMath::Square(SubsectionSizeVerts) * FMath::Square(NumSubsections));
 	}
+}
+
+void CyLandPlatformData::BuildVertexData(const FCyLandPlatformVertexSource& Source, const TArray<FCyLandVertexRef>& VertexOrder, TArray<uint8>& OutPlatformData)
+{
+	FMemoryWriter PlatformAr(OutPlatformData);
+
+	const int32 SubsectionSizeQuads = Source.SubsectionSizeQuads;
+	const int32 NumSubsections = Source.NumSubsections;
+	const FVector4& HeightmapScaleBias = Source.HeightmapScaleBias;
+
+	int32 SubsectionSizeVerts = SubsectionSizeQuads + 1;
+
+	float HeightmapSubsectionOffsetU = (float)(SubsectionSizeVerts) / (float)Source.HeightmapSizeX;
+	float HeightmapSubsectionOffsetV = (float)(SubsectionSizeVerts) / (float)Source.HeightmapSizeY;
+
+	TArray<const FColor*> HeightmapMipData;
+	for (const TArray<uint8>& MipRawData : *Source.HeightmapMips)
+	{
+		HeightmapMipData.Add((const FColor*)MipRawData.GetData());
+	}
 
 	int32 NumMobileVerices = FMath::Square(SubsectionSizeVerts * NumSubsections);
 	TArray<FCyLandMobileVertex> MobileVertices;
 	MobileVertices.AddZeroed(NumMobileVerices);
 	FCyLandMobileVertex* DstVert = MobileVertices.GetData();
 
+	TArray<int32> MipHeights;
+	MipHeights.AddZeroed(HeightmapMipData.Num());
+
 	// Fill in the vertices in the specified order
 	for (int32 Idx = 0; Idx < VertexOrder.Num(); Idx++)
 	{
@@ -5493,22 +5150,19 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 
 		float HeightmapScaleBiasZ = HeightmapScaleBias.Z + HeightmapSubsectionOffsetU * (float)SubX;
 		float HeightmapScaleBiasW = HeightmapScaleBias.W + HeightmapSubsectionOffsetV * (float)SubY;
-		int32 BaseMipOfsX = FMath::RoundToInt(HeightmapScaleBiasZ * (float)GetHeightmap()->Source.GetSizeX());
-		int32 BaseMipOfsY = FMath::RoundToInt(HeightmapScaleBiasW * (float)GetHeightmap()->Source.GetSizeY());
+		int32 BaseMipOfsX = FMath::RoundToInt(HeightmapScaleBiasZ * (float)Source.HeightmapSizeX);
+		int32 BaseMipOfsY = FMath::RoundToInt(HeightmapScaleBiasW * (float)Source.HeightmapSizeY);
 
 		DstVert->Position[0] = X;
 		DstVert->Position[1] = Y;
 		DstVert->Position[2] = SubX;
 		DstVert->Position[3] = SubY;
 
-		TArray<int32> MipHeights;
-		MipHeights.AddZeroed(HeightmapMipData.Num());
-		int32 LastIndex = 0;
 		uint16 MaxHeight = 0, MinHeight = 65535;
 
 		for (int32 Mip = 0; Mip < HeightmapMipData.Num(); ++Mip)
 		{
-			int32 MipSizeX = GetHeightmap()->Source.GetSizeX() >> Mip;
+			int32 MipSizeX = Source.HeightmapSizeX >> Mip;
 
 			int32 CurrentMipOfsX = BaseMipOfsX >> Mip;
 			int32 CurrentMipOfsY = BaseMipOfsY >> Mip;
@@ -5516,7 +5170,7 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 			int32 MipX = X >> Mip;
 			int32 MipY = Y >> Mip;
 
-			FColor* CurrentMipSrcRow = HeightmapMipData[Mip] + (CurrentMipOfsY + MipY) * MipSizeX + CurrentMipOfsX;
+			const FColor* CurrentMipSrcRow = HeightmapMipData[Mip] + (CurrentMipOfsY + MipY) * MipSizeX + CurrentMipOfsX;
 			uint16 Height = CurrentMipSrcRow[MipX].R << 8 | CurrentMipSrcRow[MipX].G;
 
 			MipHeights[Mip] = Height;
@@ -5549,9 +5203,9 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 	
 	// Generate occlusion mesh
 	TArray<FVector> OccluderVertices;
-	const int32 OcclusionMeshMip = FMath::Clamp<int32>(GetCyLandProxy()->OccluderGeometryLOD, -1, MaxLOD);
+	const int32 OcclusionMeshMip = Source.OcclusionMeshMip;
 
-	if (OcclusionMeshMip >= 0 && (!TargetPlatform || TargetPlatform->SupportsFeature(ETargetPlatformFeatures::SoftwareOcclusion)))
+	if (OcclusionMeshMip >= 0)
 	{
 		int32 LodSubsectionSizeQuads = (SubsectionSizeVerts >> OcclusionMeshMip) - 1;
 		float MipRatio = (float)SubsectionSizeQuads / (float)LodSubsectionSizeQuads;
@@ -5562,19 +5216,19 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 			{
 				float HeightmapScaleBiasZ = HeightmapScaleBias.Z + HeightmapSubsectionOffsetU * (float)SubX;
 				float HeightmapScaleBiasW = HeightmapScaleBias.W + HeightmapSubsectionOffsetV * (float)SubY;
-				int32 BaseMipOfsX = FMath::RoundToInt(HeightmapScaleBiasZ * (float)GetHeightmap()->Source.GetSizeX());
-				int32 BaseMipOfsY = FMath::RoundToInt(HeightmapScaleBiasW * (float)GetHeightmap()->Source.GetSizeY());
+				int32 BaseMipOfsX = FMath::RoundToInt(HeightmapScaleBiasZ * (float)Source.HeightmapSizeX);
+				int32 BaseMipOfsY = FMath::RoundToInt(HeightmapScaleBiasW * (float)Source.HeightmapSizeY);
 
 				for (int32 y = 0; y <= LodSubsectionSizeQuads; y++)
 				{
 					for (int32 x = 0; x <= LodSubsectionSizeQuads; x++)
 					{
-						int32 MipSizeX = GetHeightmap()->Source.GetSizeX() >> OcclusionMeshMip;
+						int32 MipSizeX = Source.HeightmapSizeX >> OcclusionMeshMip;
 
 						int32 CurrentMipOfsX = BaseMipOfsX >> OcclusionMeshMip;
 						int32 CurrentMipOfsY = BaseMipOfsY >> OcclusionMeshMip;
 												
-						FColor* CurrentMipSrcRow = HeightmapMipData[OcclusionMeshMip] + (CurrentMipOfsY + y) * MipSizeX + CurrentMipOfsX;
+						const FColor* CurrentMipSrcRow = HeightmapMipData[OcclusionMeshMip] + (CurrentMipOfsY + y) * MipSizeX + CurrentMipOfsX;
 						uint16 Height = CurrentMipSrcRow[x].R << 8 | CurrentMipSrcRow[x].G;
 
 						FVector VtxPos = FVector(x*MipRatio, y*MipRatio, ((float)Height - 32768.f) * LANDSCAPE_ZSCALE);
@@ -5588,7 +5242,26 @@ void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetP
 	int32 NumOccluderVerices = OccluderVertices.Num();
 	PlatformAr << NumOccluderVerices;
 	PlatformAr.Serialize(OccluderVertices.GetData(), NumOccluderVerices*sizeof(FVector));
-	
+}
+
+//
+// Generates vertex buffer data from the component's heightmap texture, for use on platforms without vertex texture fetch
+//
+void UCyLandComponent::GeneratePlatformVertexData(const ITargetPlatform* TargetPlatform)
+{
+	if (IsTemplate())
+	{
+		return;
+	}
+
+	const FCyLandPlatformVertexSource Source(this, TargetPlatform);
+
+	TArray<FCyLandVertexRef> VertexOrder;
+	CyLandPlatformData::BuildVertexOrder(SubsectionSizeQuads, NumSubsections, VertexOrder);
+
+	TArray<uint8> NewPlatformData;
+	CyLandPlatformData::BuildVertexData(Source, VertexOrder, NewPlatformData);
+
 	// Copy to PlatformData as Compressed
 	PlatformData.InitializeFromUncompressedData(NewPlatformData);
 }
@@ -20,12 +20,78 @@ CyLandEditInterface.cpp: CyLand editing interface
 #include "CyLandDataAccess.h"
 #include "CyLandEdit.h"
 #include "CyLandRender.h"
+#include "CyLandPrivate.h"
+#include "CyLandNormalKernel.h"
 #include "ComponentReregisterContext.h"
 #include "Algo/Transform.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
 
 // Channel remapping
 extern const size_t ChannelOffsets[4] = {STRUCT_OFFSET(FColor,R), STRUCT_OFFSET(FColor,G), STRUCT_OFFSET(FColor,B), STRUCT_OFFSET(FColor,A)};
 
+DECLARE_CYCLE_STAT(TEXT("Edit Set Height Data"), STAT_CyLandEditSetHeightData, STATGROUP_Landscape);
+DECLARE_CYCLE_STAT(TEXT("Edit Set Alpha Data"), STAT_CyLandEditSetAlphaData, STATGROUP_Landscape);
+
+static TAutoConsoleVariable<int32> CVarCyLandParallelComponentWrites(
+	TEXT("cyland.Edit.ParallelComponentWrites"),
+	1,
+	TEXT("1: SetHeightData/SetAlphaData write the texture data of the components of a region on worker threads; 0: one component after another"));
+
+namespace
+{
+	/** Per-component state of SetHeightData, gathered on the game thread before the texels are written */
+	struct FCyLandHeightWriteJob
+	{
+		UCyLandComponent* Component;
+		int32 ComponentIndexX;
+		int32 ComponentIndexY;
+
+		FCyLandTextureDataInfo* TexDataInfo;
+		TArray<FColor*> MipData;
+		FColor* XYOffsetMipData;
+		int32 SizeU;
+		int32 HeightmapOffsetX;
+		int32 HeightmapOffsetY;
+
+		// Box that lies inside component
+		int32 ComponentX1, ComponentY1, ComponentX2, ComponentY2;
+
+		// Written by the worker, to adjust bounding box
+		uint16 MinHeight;
+		uint16 MaxHeight;
+	};
+
+	/** Per-component state of SetAlphaData, gathered on the game thread before the texels are written */
+	struct FCyLandAlphaWriteJob
+	{
+		struct FLayerDataInfo
+		{
+			const uint8* InDataPtr;
+			uint8* TexDataPtr;
+		};
+
+		UCyLandComponent* Component;
+		int32 ComponentIndexX;
+		int32 ComponentIndexY;
+
+		TArray<FCyLandTextureDataInfo*, TInlineAllocator<2>> TexDataInfos;
+		TArray<TArray<FColor*>, TInlineAllocator<2>> WeightmapTextureMipData;
+		TArray<FLayerDataInfo, TInlineAllocator<8>> LayerDataInfos;		// Pointers to all layers' data 
+		TArray<bool, TInlineAllocator<8>> LayerEditDataAllZero;			// Whether the data we are editing for this layer is all zero, written by the worker
+		int32 TexSize;
+
+		// Box that lies inside component
+		int32 ComponentX1, ComponentY1, ComponentX2, ComponentY2;
+	};
+
+	bool UseParallelComponentWrites(int32 NumComponents)
+	{
+		return NumComponents > 1 && CVarCyLandParallelComponentWrites.GetValueOnGameThread() != 0 && FApp::ShouldUseThreadingForPerformance();
+	}
+}
+
 //
 // FCyLandEditDataInterface
 //
@@ -210,10 +276,55 @@ bool FCyLandEditDataInterface::GetComponentsInRegion(int32 X1, int32 Y1, int32 X
 	return bNotLocked;
 }
 
+bool FCyLandEditDataInterface::GetValidVertices(int32 X1, int32 Y1, int32 X2, int32 Y2, TBitArray<>& OutValid) const
+{
+	const int32 SizeX = X2 - X1 + 1;
+	const int32 SizeY = Y2 - Y1 + 1;
+	OutValid.Init(false, SizeX * SizeY);
+	if (ComponentSizeQuads <= 0 || !CyLandInfo)
+	{
+		return false;
+	}
+
+	int32 ComponentIndexX1, ComponentIndexY1, ComponentIndexX2, ComponentIndexY2;
+	ACyLand::CalcComponentIndicesOverlap(X1, Y1, X2, Y2, ComponentSizeQuads, ComponentIndexX1, ComponentIndexY1, ComponentIndexX2, ComponentIndexY2);
+
+	int32 NumValid = 0;
+	for (int32 ComponentIndexY = ComponentIndexY1; ComponentIndexY <= ComponentIndexY2; ComponentIndexY++)
+	{
+		for (int32 ComponentIndexX = ComponentIndexX1; ComponentIndexX <= ComponentIndexX2; ComponentIndexX++)
+		{
+			if (!CyLandInfo->XYtoComponentMap.Contains(FIntPoint(ComponentIndexX, ComponentIndexY)))
+			{
+				continue;
+			}
+
+			// Edge vertices are shared with the neighbours, they are valid if either component is there
+			const int32 CompX1 = FMath::Max(ComponentIndexX * ComponentSizeQuads, X1);
+			const int32 CompY1 = FMath::Max(ComponentIndexY * ComponentSizeQuads, Y1);
+			const int32 CompX2 = FMath::Min((ComponentIndexX + 1) * ComponentSizeQuads, X2);
+			const int32 CompY2 = FMath::Min((ComponentIndexY + 1) * ComponentSizeQuads, Y2);
+			for (int32 Y = CompY1; Y <= CompY2; Y++)
+			{
+				for (int32 X = CompX1; X <= CompX2; X++)
+				{
+					FBitReference Bit = OutValid[(X - X1) + (Y - Y1) * SizeX];
+					NumValid += Bit ? 0 : 1;
+					Bit = true;
+				}
+			}
+		}
+	}
+
+	return NumValid == OutValid.Num();
+}
+
 DEFINE_LOG_CATEGORY_STATIC(LogCyLandEditorInterface, Warning, All);
 void FCyLandEditDataInterface::SetHeightData(int32 X1, int32 Y1, int32 X2, int32 Y2, const uint16* InData, int32 InStride, bool InCalcNormals, const uint16* InNormalData, bool InCreateComponents, UTexture2D* InHeightmap, UTexture2D* InXYOffsetmapTexture,
 											   bool InUpdateBounds, bool InUpdateCollision, bool InGenerateMips)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CyLandEditSetHeightData);
+
 	UE_LOG(LogCyLandEditorInterface, Warning, TEXT("Setting HeightData"));
 	const int32 NumVertsX = 1 + X2 - X1;
 	const int32 NumVertsY = 1 + Y2 - Y1;
@@ -228,43 +339,21 @@ void FCyLandEditDataInterface::SetHeightData(int32 X1, int32 Y1, int32 X2, int32
 	int32 ComponentIndexX1, ComponentIndexY1, ComponentIndexX2, ComponentIndexY2;
 	ACyLand::CalcComponentIndicesOverlap(X1, Y1, X2, Y2, ComponentSizeQuads, ComponentIndexX1, ComponentIndexY1, ComponentIndexX2, ComponentIndexY2);
 
-	FVector* VertexNormals = nullptr;
+	// Packed height and normal texels of the whole block.
+	// Note that the normals at the edges are not correct because they include normals
+	// from triangles outside the current area. They are not updated
+	TArray<FColor> PackedTexels;
 	if (InCalcNormals)
 	{
-		// Calculate the normals for each of the two triangles per quad.
-		// Note that the normals at the edges are not correct because they include normals
-		// from triangles outside the current area. They are not updated
-		VertexNormals = new FVector[NumVertsX*NumVertsY];
-		FMemory::Memzero(VertexNormals, NumVertsX*NumVertsY * sizeof(FVector));
-
-		// Need to consider XYOffset for XY displacemented map
-		FVector2D* XYOffsets = new FVector2D[NumVertsX*NumVertsY];
-		FMemory::Memzero(XYOffsets, NumVertsX*NumVertsY * sizeof(FVector2D));
-		GetXYOffsetDataFast(X1, Y1, X2, Y2, XYOffsets, 0);
-
-		for (int32 Y = 0; Y < NumVertsY - 1; Y++)
-		{
-			for (int32 X = 0; X < NumVertsX - 1; X++)
-			{
-				FVector Vert00 = FVector(XYOffsets[(X + 0) + NumVertsX*(Y + 0)].X, XYOffsets[(X + 0) + NumVertsX*(Y + 0)].Y, ((float)InData[(X + 0) + InStride*(Y + 0)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert01 = FVector(XYOffsets[(X + 0) + NumVertsX*(Y + 0)].X, XYOffsets[(X + 0) + NumVertsX*(Y + 0)].Y + 1.0f, ((float)InData[(X + 0) + InStride*(Y + 1)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert10 = FVector(XYOffsets[(X + 0) + NumVertsX*(Y + 0)].X + 1.0f, XYOffsets[(X + 0) + NumVertsX*(Y + 0)].Y, ((float)InData[(X + 1) + InStride*(Y + 0)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert11 = FVector(XYOffsets[(X + 0) + NumVertsX*(Y + 0)].X + 1.0f, XYOffsets[(X + 0) + NumVertsX*(Y + 0)].Y + 1.0f, ((float)InData[(X + 1) + InStride*(Y + 1)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
-
-				FVector FaceNormal1 = ((Vert00 - Vert10) ^ (Vert10 - Vert11)).GetSafeNormal();
-				FVector FaceNormal2 = ((Vert11 - Vert01) ^ (Vert01 - Vert00)).GetSafeNormal();
-
-				// contribute to the vertex normals.
-				VertexNormals[(X + 1 + NumVertsX*(Y + 0))] += FaceNormal1;
-				VertexNormals[(X + 0 + NumVertsX*(Y + 1))] += FaceNormal2;
-				VertexNormals[(X + 0 + NumVertsX*(Y + 0))] += FaceNormal1 + FaceNormal2;
-				VertexNormals[(X + 1 + NumVertsX*(Y + 1))] += FaceNormal1 + FaceNormal2;
-			}
-		}
-
-		delete[] XYOffsets;
+		PackedTexels.SetNumUninitialized(NumVertsX * NumVertsY);
+		FCyLandNormalKernel NormalKernel(DrawScale, NumVertsX);
+		NormalKernel.ComputeTexels(InData, InStride, NumVertsX, NumVertsY, 0, NumVertsY, PackedTexels.GetData(), NumVertsX);
 	}
 
+	// Gather the components and lock their texture data on the game thread
+	TArray<FCyLandHeightWriteJob> Jobs;
+	const int32 BaseNumMips = InGenerateMips ? FMath::CeilLogTwo(SubsectionSizeQuads + 1) : 1;
+
 	for (int32 ComponentIndexY = ComponentIndexY1; ComponentIndexY <= ComponentIndexY2; ComponentIndexY++)
 	{
 		for (int32 ComponentIndexX = ComponentIndexX1; ComponentIndexX <= ComponentIndexX2; ComponentIndexX++)
@@ -291,169 +380,175 @@ void FCyLandEditDataInterface::SetHeightData(int32 X1, int32 Y1, int32 X2, int32
 
 			Component->Modify();
 
-			FCyLandTextureDataInfo* TexDataInfo = GetTextureDataInfo(Heightmap);
-			FColor* HeightmapTextureData = (FColor*)TexDataInfo->GetMipData(0);
+			FCyLandHeightWriteJob& Job = Jobs.AddDefaulted_GetRef();
+			Job.Component = Component;
+			Job.ComponentIndexX = ComponentIndexX;
+			Job.ComponentIndexY = ComponentIndexY;
 
-			FColor* XYOffsetMipData = nullptr;
+			// Work out how many mips should be calculated directly from one component's data.
+			// The remaining mips are calculated on a per texture basis.
+			// eg if subsection is 7x7 quads, we need one 3 mips total: (8x8, 4x4, 2x2 verts)
+			Job.TexDataInfo = GetTextureDataInfo(Heightmap);
+			Job.MipData.AddUninitialized(BaseNumMips);
+			for (int32 MipIdx = 0; MipIdx < BaseNumMips; MipIdx++)
+			{
+				Job.MipData[MipIdx] = (FColor*)Job.TexDataInfo->GetMipData(MipIdx);
+			}
+
+			Job.XYOffsetMipData = nullptr;
 			if (XYOffsetmapTexture)
 			{
 				FCyLandTextureDataInfo* XYTexDataInfo = GetTextureDataInfo(XYOffsetmapTexture);
-				XYOffsetMipData = (FColor*)XYTexDataInfo->GetMipData(Component->CollisionMipLevel);
+				Job.XYOffsetMipData = (FColor*)XYTexDataInfo->GetMipData(Component->CollisionMipLevel);
 			}
 
 			// Find the texture data corresponding to this vertex
-			int32 SizeU = Heightmap->Source.GetSizeX();
-			int32 SizeV = Heightmap->Source.GetSizeY();
-			int32 HeightmapOffsetX = Component->HeightmapScaleBias.Z * (float)SizeU;
-			int32 HeightmapOffsetY = Component->HeightmapScaleBias.W * (float)SizeV;
+			Job.SizeU = Heightmap->Source.GetSizeX();
+			Job.HeightmapOffsetX = Component->HeightmapScaleBias.Z * (float)Job.SizeU;
+			Job.HeightmapOffsetY = Component->HeightmapScaleBias.W * (float)Heightmap->Source.GetSizeY();
 
 			// Find coordinates of box that lies inside component
-			int32 ComponentX1 = FMath::Clamp<int32>(X1 - ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
-			int32 ComponentY1 = FMath::Clamp<int32>(Y1 - ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
-			int32 ComponentX2 = FMath::Clamp<int32>(X2 - ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
-			int32 ComponentY2 = FMath::Clamp<int32>(Y2 - ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
-
-			// Find subsection range for this box
-			int32 SubIndexX1 = FMath::Clamp<int32>((ComponentX1 - 1) / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);	// -1 because we need to pick up vertices shared between subsections
-			int32 SubIndexY1 = FMath::Clamp<int32>((ComponentY1 - 1) / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
-			int32 SubIndexX2 = FMath::Clamp<int32>(ComponentX2 / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
-			int32 SubIndexY2 = FMath::Clamp<int32>(ComponentY2 / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
+			Job.ComponentX1 = FMath::Clamp<int32>(X1 - ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentY1 = FMath::Clamp<int32>(Y1 - ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentX2 = FMath::Clamp<int32>(X2 - ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentY2 = FMath::Clamp<int32>(Y2 - ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
 
 			// To adjust bounding box
-			uint16 MinHeight = MAX_uint16;
-			uint16 MaxHeight = 0;
+			Job.MinHeight = MAX_uint16;
+			Job.MaxHeight = 0;
+		}
+	}
 
-			for (int32 SubIndexY = SubIndexY1; SubIndexY <= SubIndexY2; SubIndexY++)
+	// Write the texels and the component mips. Components sharing a heightmap own disjoint blocks of it,
+	// the only shared state is the update region list which is locked.
+	ParallelFor(Jobs.Num(), [&](int32 JobIndex)
+	{
+		FCyLandHeightWriteJob& Job = Jobs[JobIndex];
+		FColor* HeightmapTextureData = Job.MipData[0];
+
+		// Find subsection range for this box
+		int32 SubIndexX1 = FMath::Clamp<int32>((Job.ComponentX1 - 1) / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);	// -1 because we need to pick up vertices shared between subsections
+		int32 SubIndexY1 = FMath::Clamp<int32>((Job.ComponentY1 - 1) / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
+		int32 SubIndexX2 = FMath::Clamp<int32>(Job.ComponentX2 / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
+		int32 SubIndexY2 = FMath::Clamp<int32>(Job.ComponentY2 / SubsectionSizeQuads, 0, ComponentNumSubsections - 1);
+
+		for (int32 SubIndexY = SubIndexY1; SubIndexY <= SubIndexY2; SubIndexY++)
+		{
+			for (int32 SubIndexX = SubIndexX1; SubIndexX <= SubIndexX2; SubIndexX++)
 			{
-				for (int32 SubIndexX = SubIndexX1; SubIndexX <= SubIndexX2; SubIndexX++)
+				// Find coordinates of box that lies inside subsection
+				int32 SubX1 = FMath::Clamp<int32>(Job.ComponentX1 - SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
+				int32 SubY1 = FMath::Clamp<int32>(Job.ComponentY1 - SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
+				int32 SubX2 = FMath::Clamp<int32>(Job.ComponentX2 - SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
+				int32 SubY2 = FMath::Clamp<int32>(Job.ComponentY2 - SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
+
+				// Update texture data for the box that lies inside subsection
+				for (int32 SubY = SubY1; SubY <= SubY2; SubY++)
 				{
-					// Find coordinates of box that lies inside subsection
-					int32 SubX1 = FMath::Clamp<int32>(ComponentX1 - SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
-					int32 SubY1 = FMath::Clamp<int32>(ComponentY1 - SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
-					int32 SubX2 = FMath::Clamp<int32>(ComponentX2 - SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
-					int32 SubY2 = FMath::Clamp<int32>(ComponentY2 - SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
-
-					// Update texture data for the box that lies inside subsection
-					for (int32 SubY = SubY1; SubY <= SubY2; SubY++)
+					for (int32 SubX = SubX1; SubX <= SubX2; SubX++)
 					{
-						for (int32 SubX = SubX1; SubX <= SubX2; SubX++)
-						{
-							int32 CyLandX = SubIndexX*SubsectionSizeQuads + ComponentIndexX*ComponentSizeQuads + SubX;
-							int32 CyLandY = SubIndexY*SubsectionSizeQuads + ComponentIndexY*ComponentSizeQuads + SubY;
-							checkSlow(CyLandX >= X1 && CyLandX <= X2);
-							checkSlow(CyLandY >= Y1 && CyLandY <= Y2);
+						int32 CyLandX = SubIndexX*SubsectionSizeQuads + Job.ComponentIndexX*ComponentSizeQuads + SubX;
+						int32 CyLandY = SubIndexY*SubsectionSizeQuads + Job.ComponentIndexY*ComponentSizeQuads + SubY;
+						checkSlow(CyLandX >= X1 && CyLandX <= X2);
+						checkSlow(CyLandY >= Y1 && CyLandY <= Y2);
 
-							// Find the input data corresponding to this vertex
-							int32 DataIndex = (CyLandX - X1) + InStride * (CyLandY - Y1);
-							const uint16& Height = InData[DataIndex];
+						// Find the input data corresponding to this vertex
+						int32 DataIndex = (CyLandX - X1) + InStride * (CyLandY - Y1);
+						const uint16& Height = InData[DataIndex];
 
-							// for bounding box
-							if (Height < MinHeight)
-							{
-								MinHeight = Height;
-							}
-							if (Height > MaxHeight)
-							{
-								MaxHeight = Height;
-							}
+						// for bounding box
+						if (Height < Job.MinHeight)
+						{
+							Job.MinHeight = Height;
+						}
+						if (Height > Job.MaxHeight)
+						{
+							Job.MaxHeight = Height;
+						}
 
-							int32 TexX = HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX;
-							int32 TexY = HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY;
-							FColor& TexData = HeightmapTextureData[TexX + TexY * SizeU];
+						int32 TexX = Job.HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX;
+						int32 TexY = Job.HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY;
+						FColor& TexData = HeightmapTextureData[TexX + TexY * Job.SizeU];
 
-							// Update the texture
-							TexData.R = Height >> 8;
-							TexData.G = Height & 255;
+						// Update the texture
+						TexData.R = Height >> 8;
+						TexData.G = Height & 255;
 
-							// Update normals if we're not on an edge vertex
-							if (VertexNormals && CyLandX > X1 && CyLandX < X2 && CyLandY > Y1 && CyLandY < Y2)
-							{
-								const int32 NormalDataIndex = (CyLandX - X1) + NumVertsX * (CyLandY - Y1);
-								FVector Normal = VertexNormals[NormalDataIndex].GetSafeNormal();
-								TexData.B = FMath::RoundToInt(127.5f * (Normal.X + 1.0f));
-								TexData.A = FMath::RoundToInt(127.5f * (Normal.Y + 1.0f));
-							}
-							else if (InNormalData)
-							{
-								// Need data validation?
-								const uint16& Normal = InNormalData[DataIndex];
-								TexData.B = Normal >> 8;
-								TexData.A = Normal & 255;
-							}
+						// Update normals if we're not on an edge vertex
+						if (PackedTexels.Num() && CyLandX > X1 && CyLandX < X2 && CyLandY > Y1 && CyLandY < Y2)
+						{
+							const FColor& PackedTexel = PackedTexels[(CyLandX - X1) + NumVertsX * (CyLandY - Y1)];
+							TexData.B = PackedTexel.B;
+							TexData.A = PackedTexel.A;
+						}
+						else if (InNormalData)
+						{
+							// Need data validation?
+							const uint16& Normal = InNormalData[DataIndex];
+							TexData.B = Normal >> 8;
+							TexData.A = Normal & 255;
 						}
 					}
-
-					// Record the areas of the texture we need to re-upload
-					int32 TexX1 = HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX1;
-					int32 TexY1 = HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY1;
-					int32 TexX2 = HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX2;
-					int32 TexY2 = HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY2;
-					TexDataInfo->AddMipUpdateRegion(0, TexX1, TexY1, TexX2, TexY2);
 				}
-			}
 
-			// See if we need to adjust the bounds. Note we never shrink the bounding box at this point
-			bool bUpdateBoxSphereBounds = false;
+				// Record the areas of the texture we need to re-upload
+				int32 TexX1 = Job.HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX1;
+				int32 TexY1 = Job.HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY1;
+				int32 TexX2 = Job.HeightmapOffsetX + (SubsectionSizeQuads + 1) * SubIndexX + SubX2;
+				int32 TexY2 = Job.HeightmapOffsetY + (SubsectionSizeQuads + 1) * SubIndexY + SubY2;
+				Job.TexDataInfo->AddMipUpdateRegion(0, TexX1, TexY1, TexX2, TexY2);
+			}
+		}
 
-			if (InUpdateBounds)
-			{
-				float MinLocalZ = CyLandDataAccess::GetLocalHeight(MinHeight);
-				float MaxLocalZ = CyLandDataAccess::GetLocalHeight(MaxHeight);
+		// Update mipmaps
+		if (InGenerateMips)
+		{
+			Job.Component->GenerateHeightmapMips(Job.MipData, Job.ComponentX1, Job.ComponentY1, Job.ComponentX2, Job.ComponentY2, Job.TexDataInfo);
+		}
+	}, !UseParallelComponentWrites(Jobs.Num()));
 
-				if (MinLocalZ < Component->CachedLocalBox.Min.Z)
-				{
-					Component->CachedLocalBox.Min.Z = MinLocalZ;
-					bUpdateBoxSphereBounds = true;
-				}
-				if (MaxLocalZ > Component->CachedLocalBox.Max.Z)
-				{
-					Component->CachedLocalBox.Max.Z = MaxLocalZ;
-					bUpdateBoxSphereBounds = true;
-				}
+	// Notify the components one after another
+	for (FCyLandHeightWriteJob& Job : Jobs)
+	{
+		UCyLandComponent* Component = Job.Component;
 
-				if (bUpdateBoxSphereBounds)
-				{
-					Component->UpdateComponentToWorld();
-				}
-			}
+		// See if we need to adjust the bounds. Note we never shrink the bounding box at this point
+		bool bUpdateBoxSphereBounds = false;
 
-			// Update mipmaps
+		if (InUpdateBounds)
+		{
+			float MinLocalZ = CyLandDataAccess::GetLocalHeight(Job.MinHeight);
+			float MaxLocalZ = CyLandDataAccess::GetLocalHeight(Job.MaxHeight);
 
-			// Work out how many mips should be calculated directly from one component's data.
-			// The remaining mips are calculated on a per texture basis.
-			// eg if subsection is 7x7 quads, we need one 3 mips total: (8x8, 4x4, 2x2 verts)
-			if (InGenerateMips)
+			if (MinLocalZ < Component->CachedLocalBox.Min.Z)
 			{
-				int32 BaseNumMips = FMath::CeilLogTwo(SubsectionSizeQuads + 1);
-				TArray<FColor*> MipData;
-				MipData.AddUninitialized(BaseNumMips);
-				MipData[0] = HeightmapTextureData;
-				for (int32 MipIdx = 1; MipIdx < BaseNumMips; MipIdx++)
-				{
-					MipData[MipIdx] = (FColor*)TexDataInfo->GetMipData(MipIdx);
-				}
-				Component->GenerateHeightmapMips(MipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TexDataInfo);
-
-				if (InUpdateCollision)
-				{
-					// Update collision
-					Component->UpdateCollisionHeightData(
-						MipData[Component->CollisionMipLevel],
-						Component->SimpleCollisionMipLevel > Component->CollisionMipLevel ? MipData[Component->SimpleCollisionMipLevel] : nullptr,
-						ComponentX1, ComponentY1, ComponentX2, ComponentY2, bUpdateBoxSphereBounds,
-						XYOffsetMipData);
-				}
+				Component->CachedLocalBox.Min.Z = MinLocalZ;
+				bUpdateBoxSphereBounds = true;
+			}
+			if (MaxLocalZ > Component->CachedLocalBox.Max.Z)
+			{
+				Component->CachedLocalBox.Max.Z = MaxLocalZ;
+				bUpdateBoxSphereBounds = true;
 			}
 
+			if (bUpdateBoxSphereBounds)
+			{
+				Component->UpdateComponentToWorld();
+			}
+		}
 
-			// Update GUID for Platform Data
-			FPlatformMisc::CreateGuid(Component->StateId);
+		if (InGenerateMips && InUpdateCollision)
+		{
+			// Update collision
+			Component->UpdateCollisionHeightData(
+				Job.MipData[Component->CollisionMipLevel],
+				Component->SimpleCollisionMipLevel > Component->CollisionMipLevel ? Job.MipData[Component->SimpleCollisionMipLevel] : nullptr,
+				Job.ComponentX1, Job.ComponentY1, Job.ComponentX2, Job.ComponentY2, bUpdateBoxSphereBounds,
+				Job.XYOffsetMipData);
 		}
-	}
 
-	if (VertexNormals)
-	{
-		delete[] VertexNormals;
+		// Update GUID for Platform Data
+		FPlatformMisc::CreateGuid(Component->StateId);
 	}
 }
 
@@ -463,49 +558,27 @@ void FCyLandEditDataInterface::SetHeightData(int32 X1, int32 Y1, int32 X2, int32
 void FCyLandEditDataInterface::RecalculateNormals()
 {
 	if (!CyLandInfo) return;
+	// one extra row of vertex either side of the component
+	const int32 Stride = ComponentSizeQuads+3;
+	uint16* HeightData = new uint16[FMath::Square(Stride)];
+	FColor* PackedTexels = new FColor[FMath::Square(Stride)];
+	FCyLandNormalKernel NormalKernel(DrawScale, Stride);
+
 	// Recalculate normals for each component in turn
 	for( auto It = CyLandInfo->XYtoComponentMap.CreateIterator(); It; ++It )
 	{
 		UCyLandComponent* Component = It.Value();
 
-		// one extra row of vertex either side of the component
 		int32 X1 = Component->GetSectionBase().X-1;
 		int32 Y1 = Component->GetSectionBase().Y-1;
 		int32 X2 = Component->GetSectionBase().X+ComponentSizeQuads+1;
 		int32 Y2 = Component->GetSectionBase().Y+ComponentSizeQuads+1;
-		int32 Stride = ComponentSizeQuads+3; 
-
-		uint16* HeightData = new uint16[FMath::Square(Stride)];
-		FVector* VertexNormals = new FVector[FMath::Square(Stride)];
-		FMemory::Memzero(VertexNormals, FMath::Square(Stride)*sizeof(FVector));
-		FVector2D* XYOffsets = new FVector2D[FMath::Square(Stride)];
-		FMemory::Memzero(XYOffsets, FMath::Square(Stride)*sizeof(FVector2D));
 
-		// Get XY offset
-		GetXYOffsetDataFast(X1,Y1,X2,Y2,XYOffsets,0);
 		// Get the vertex positions for entire quad
 		GetHeightData(X1,Y1,X2,Y2,HeightData,0);
 
-		// Contribute face normals for all triangles contributing to this components' normals
-		for( int32 Y=0;Y<Stride-1;Y++ )
-		{
-			for( int32 X=0;X<Stride-1;X++ )
-			{
-				FVector Vert00 = FVector(XYOffsets[(X+0) + Stride*(Y+0)].X,		XYOffsets[(X+0) + Stride*(Y+0)].Y, ((float)HeightData[(X+0) + Stride*(Y+0)] - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert01 = FVector(XYOffsets[(X+0) + Stride*(Y+0)].X,		XYOffsets[(X+0) + Stride*(Y+0)].Y+1.0f, ((float)HeightData[(X+0) + Stride*(Y+1)] - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert10 = FVector(XYOffsets[(X+0) + Stride*(Y+0)].X+1.0f,	XYOffsets[(X+0) + Stride*(Y+0)].Y, ((float)HeightData[(X+1) + Stride*(Y+0)] - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale;
-				FVector Vert11 = FVector(XYOffsets[(X+0) + Stride*(Y+0)].X+1.0f,	XYOffsets[(X+0) + Stride*(Y+0)].Y+1.0f,((float)HeightData[(X+1) + Stride*(Y+1)] - 32768.0f)*LANDSCAPE_ZSCALE) * DrawScale;
-
-				FVector FaceNormal1 = ((Vert00-Vert10) ^ (Vert10-Vert11)).GetSafeNormal();
-				FVector FaceNormal2 = ((Vert11-Vert01) ^ (Vert01-Vert00)).GetSafeNormal(); 
-
-				// contribute to the vertex normals.
-				VertexNormals[(X+1 + Stride*(Y+0))] += FaceNormal1;
-				VertexNormals[(X+0 + Stride*(Y+1))] += FaceNormal2;
-				VertexNormals[(X+0 + Stride*(Y+0))] += FaceNormal1 + FaceNormal2;
-				VertexNormals[(X+1 + Stride*(Y+1))] += FaceNormal1 + FaceNormal2;
-			}
-		}
+		// Every vertex of the component has all its neighbors, only the inner rows are needed
+		NormalKernel.ComputeTexels(HeightData, Stride, Stride, Stride, 1, Stride-1, PackedTexels + Stride, Stride);
 
 		// Find the texture data corresponding to this vertex
 		int32 SizeU = Component->GetHeightmap(true)->Source.GetSizeX();
@@ -534,17 +607,13 @@ void FCyLandEditDataInterface::RecalculateNormals()
 						FColor& TexData = HeightmapTextureData[ TexX + TexY * SizeU ];
 
 						// Update the texture
-						FVector Normal = VertexNormals[DataIndex].GetSafeNormal();
-						TexData.B = FMath::RoundToInt( 127.5f * (Normal.X + 1.0f) );
-						TexData.A = FMath::RoundToInt( 127.5f * (Normal.Y + 1.0f) );
+						TexData.B = PackedTexels[DataIndex].B;
+						TexData.A = PackedTexels[DataIndex].A;
 					}
 				}
 			}
 		}
 
-		delete[] XYOffsets;
-		delete[] HeightData;
-		delete[] VertexNormals;
 
 		// Record the areas of the texture we need to re-upload
 		int32 TexX1 = HeightmapOffsetX;
@@ -566,6 +635,9 @@ void FCyLandEditDataInterface::RecalculateNormals()
 		}
 		Component->GenerateHeightmapMips( MipData, 0, 0, ComponentSizeQuads, ComponentSizeQuads, TexDataInfo );
 	}
+
+	delete[] HeightData;
+	delete[] PackedTexels;
 }
 
 template<typename TStoreData>
@@ -1401,17 +1473,25 @@ namespace
 		int32 Y1;
 		uint16* Data;
 		int32 Stride;
+		// Bits of the samples stored, optional
+		TBitArray<>* Valid;
 
-		FArrayStoreData(int32 InX1, int32 InY1, uint16* InData, int32 InStride)
+		FArrayStoreData(int32 InX1, int32 InY1, uint16* InData, int32 InStride, TBitArray<>* InValid = nullptr)
 			:	X1(InX1)
 			,	Y1(InY1)
 			,	Data(InData)
 			,	Stride(InStride)
+			,	Valid(InValid)
 		{}
 
 		inline void Store(int32 CyLandX, int32 CyLandY, uint16 Height)
 		{
-			Data[ (CyLandY-Y1) * Stride + (CyLandX-X1) ] = Height;
+			const int32 Index = (CyLandY-Y1) * Stride + (CyLandX-X1);
+			Data[Index] = Height;
+			if (Valid)
+			{
+				(*Valid)[Index] = true;
+			}
 		}
 
 		// for interpolation
@@ -1451,25 +1531,25 @@ namespace
 
 };
 
-void FCyLandEditDataInterface::GetHeightData(int32& X1, int32& Y1, int32& X2, int32& Y2, uint16* Data, int32 Stride)
+void FCyLandEditDataInterface::GetHeightData(int32& X1, int32& Y1, int32& X2, int32& Y2, uint16* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
 
-	FArrayStoreData ArrayStoreData(X1, Y1, Data, Stride);
+	FArrayStoreData ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetHeightDataTempl(X1, Y1, X2, Y2, ArrayStoreData);
 }
 
-void FCyLandEditDataInterface::GetHeightDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint16* Data, int32 Stride, uint16* NormalData /*= NULL*/, UTexture2D* InHeightmap)
+void FCyLandEditDataInterface::GetHeightDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint16* Data, int32 Stride, uint16* NormalData /*= NULL*/, UTexture2D* InHeightmap, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
 
-	FArrayStoreData ArrayStoreData(X1, Y1, Data, Stride);
+	FArrayStoreData ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	if (NormalData)
 	{
 		FArrayStoreData ArrayNormalData(X1, Y1, NormalData, Stride);
@@ -2162,15 +2242,28 @@ namespace
 		TDataType* Data;
 		int32 Stride;
 		int32 ArraySize;
+		// Bits of the samples stored, optional
+		TBitArray<>* Valid;
 
-		TArrayStoreData(int32 InX1, int32 InY1, TDataType* InData, int32 InStride)
+		TArrayStoreData(int32 InX1, int32 InY1, TDataType* InData, int32 InStride, TBitArray<>* InValid = nullptr)
 			:	X1(InX1)
 			,	Y1(InY1)
 			,	Data(InData)
 			,	Stride(InStride)
 			,	ArraySize(1)
+			,	Valid(InValid)
 		{}
 
+		inline int32 GetIndex(int32 CyLandX, int32 CyLandY)
+		{
+			const int32 Index = (CyLandY-Y1) * Stride + (CyLandX-X1);
+			if (Valid)
+			{
+				(*Valid)[Index] = true;
+			}
+			return Index;
+		}
+
 		inline void Store(int32 CyLandX, int32 CyLandY, uint8 Weight) {}
 		inline void Store(int32 CyLandX, int32 CyLandY, uint8 Weight, int32 LayerIdx) {}
 		inline void Store(int32 CyLandX, int32 CyLandY, FVector2D Offset) {}
@@ -2180,7 +2273,7 @@ namespace
 
 	template<> void TArrayStoreData<uint8>::Store(int32 CyLandX, int32 CyLandY, uint8 Weight)
 	{
-		Data[ (CyLandY-Y1) * Stride + (CyLandX-X1) ] = Weight;
+		Data[GetIndex(CyLandX, CyLandY)] = Weight;
 	}
 
 	template<> uint8 TArrayStoreData<uint8>::Load(int32 CyLandX, int32 CyLandY)
@@ -2200,18 +2293,18 @@ namespace
 
 	template<> void TArrayStoreData<FVector2D>::Store(int32 CyLandX, int32 CyLandY, FVector2D Offset)
 	{
-		Data[ (CyLandY-Y1) * Stride + (CyLandX-X1) ] = Offset;
+		Data[GetIndex(CyLandX, CyLandY)] = Offset;
 	}
 
 	template<> void TArrayStoreData<FVector>::Store(int32 CyLandX, int32 CyLandY, FVector2D Offset)
 	{
-		Data[ (CyLandY-Y1) * Stride + (CyLandX-X1) ] = FVector(Offset.X, Offset.Y, 0.0f);
+		Data[GetIndex(CyLandX, CyLandY)] = FVector(Offset.X, Offset.Y, 0.0f);
 	}
 
 	// Data items should be initialized with ArraySize
 	template<> void TArrayStoreData<TArray<uint8>>::Store(int32 CyLandX, int32 CyLandY, uint8 Weight, int32 LayerIdx)
 	{
-		TArray<uint8>& Value = Data[ ((CyLandY-Y1) * Stride + (CyLandX-X1)) ];
+		TArray<uint8>& Value = Data[GetIndex(CyLandX, CyLandY)];
 		if (Value.Num() != ArraySize)
 		{
 			Value.Empty(ArraySize);
@@ -2961,6 +3054,8 @@ void FCyLandEditDataInterface::SetAlphaData(UCyLandLayerInfoObject* const LayerI
 
 void FCyLandEditDataInterface::SetAlphaData(const TSet<UCyLandLayerInfoObject*>& DirtyLayerInfos, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, const uint8* Data, int32 Stride, ECyLandLayerPaintingRestriction PaintingRestriction /*= None*/)
 {
+	SCOPE_CYCLE_COUNTER(STAT_CyLandEditSetAlphaData);
+
 	if (DirtyLayerInfos.Num() == 0)
 	{
 		return;
@@ -2975,9 +3070,10 @@ void FCyLandEditDataInterface::SetAlphaData(const TSet<UCyLandLayerInfoObject*>&
 		check(CyLandInfo->GetLayerInfoIndex(LayerInfo) != INDEX_NONE);
 	}
 
+	const int32 NumLayers = CyLandInfo->Layers.Num();
 	if (Stride == 0)
 	{
-		Stride = (1+X2-X1) * CyLandInfo->Layers.Num();
+		Stride = (1+X2-X1) * NumLayers;
 	}
 
 	check(ComponentSizeQuads > 0);
@@ -2988,19 +3084,9 @@ void FCyLandEditDataInterface::SetAlphaData(const TSet<UCyLandLayerInfoObject*>&
 	int32 ComponentIndexY2 = (Y2 >= 0) ? Y2 / ComponentSizeQuads : (Y2+1) / ComponentSizeQuads - 1;
 
 	TArray<UCyLandLayerInfoObject*, TInlineAllocator<8>> NeedAllocationInfos;
-	TArray<FCyLandTextureDataInfo*, TInlineAllocator<2>> TexDataInfos;
 
-	struct FLayerDataInfo
-	{
-		const uint8* InDataPtr;
-		uint8* TexDataPtr;
-	};
-
-	TArray<FLayerDataInfo, TInlineAllocator<8>> LayerDataInfos;		// Pointers to all layers' data 
-	TArray<bool, TInlineAllocator<8>> LayerEditDataAllZero; // Whether the data we are editing for this layer is all zero 
-	TArray<FColor*> CollisionWeightmapMipData;
-	TArray<FColor*> SimpleCollisionWeightmapMipData;
-	TArray<FColor*> WeightmapTextureMipData;
+	// Allocate the missing layers and lock the weightmap data on the game thread
+	TArray<FCyLandAlphaWriteJob> Jobs;
 
 	for (int32 ComponentIndexY = ComponentIndexY1; ComponentIndexY <= ComponentIndexY2; ComponentIndexY++)
 	{
@@ -3062,90 +3148,161 @@ void FCyLandEditDataInterface::SetAlphaData(const TSet<UCyLandLayerInfoObject*>&
 				}
 			}
 
-			// Lock data for all the weightmaps
-			TexDataInfos.Reset();
-			TexDataInfos.AddUninitialized(Component->WeightmapTextures.Num());
+			FCyLandAlphaWriteJob& Job = Jobs.AddDefaulted_GetRef();
+			Job.Component = Component;
+			Job.ComponentIndexX = ComponentIndexX;
+			Job.ComponentIndexY = ComponentIndexY;
+
+			// Lock data for all the weightmaps, including every mip the worker updates
+			Job.TexDataInfos.AddUninitialized(Component->WeightmapTextures.Num());
+			Job.WeightmapTextureMipData.AddDefaulted(Component->WeightmapTextures.Num());
 
 			for (int32 WeightmapIdx = 0; WeightmapIdx < Component->WeightmapTextures.Num(); ++WeightmapIdx)
 			{
-				TexDataInfos[WeightmapIdx] = GetTextureDataInfo(Component->WeightmapTextures[WeightmapIdx]);
+				FCyLandTextureDataInfo* TexDataInfo = GetTextureDataInfo(Component->WeightmapTextures[WeightmapIdx]);
+				Job.TexDataInfos[WeightmapIdx] = TexDataInfo;
+
+				const int32 NumMips = Component->WeightmapTextures[WeightmapIdx]->Source.GetNumMips();
+				Job.WeightmapTextureMipData[WeightmapIdx].AddUninitialized(NumMips);
+				for (int32 MipIdx = 0; MipIdx < NumMips; MipIdx++)
+				{
+					Job.WeightmapTextureMipData[WeightmapIdx][MipIdx] = (FColor*)TexDataInfo->GetMipData(MipIdx);
+				}
 			}
 
-			LayerDataInfos.Reset();        // Pointers to all layers' data
-			LayerDataInfos.AddUninitialized(Component->WeightmapLayerAllocations.Num());
-			LayerEditDataAllZero.Reset(); // Whether the data we are editing for this layer is all zero 
-			LayerEditDataAllZero.AddUninitialized(Component->WeightmapLayerAllocations.Num());
+			Job.LayerDataInfos.AddUninitialized(Component->WeightmapLayerAllocations.Num());
+			Job.LayerEditDataAllZero.AddUninitialized(Component->WeightmapLayerAllocations.Num());
 
 			for (int32 LayerIdx = 0; LayerIdx < Component->WeightmapLayerAllocations.Num(); LayerIdx++)
 			{
 				FCyWeightmapLayerAllocationInfo& Allocation = Component->WeightmapLayerAllocations[LayerIdx];
 				const int32 LayerDataIdx = CyLandInfo->GetLayerInfoIndex(Component->WeightmapLayerAllocations[LayerIdx].LayerInfo);
 				check(LayerDataIdx != INDEX_NONE);
-				LayerDataInfos[LayerIdx].InDataPtr = Data + LayerDataIdx;
-				LayerDataInfos[LayerIdx].TexDataPtr = (uint8*)TexDataInfos[Allocation.WeightmapTextureIndex]->GetMipData(0) + ChannelOffsets[Allocation.WeightmapTextureChannel];
-				LayerEditDataAllZero[LayerIdx] = true;
+				Job.LayerDataInfos[LayerIdx].InDataPtr = Data + LayerDataIdx;
+				Job.LayerDataInfos[LayerIdx].TexDataPtr = (uint8*)Job.WeightmapTextureMipData[Allocation.WeightmapTextureIndex][0] + ChannelOffsets[Allocation.WeightmapTextureChannel];
+				Job.LayerEditDataAllZero[LayerIdx] = true;
 			}
 
 			// Find the texture data corresponding to this vertex
-			const int32 TexSize = (Component->SubsectionSizeQuads+1) * Component->NumSubsections; 
+			Job.TexSize = (Component->SubsectionSizeQuads+1) * Component->NumSubsections; 
 
 			// Find coordinates of box that lies inside component
-			const int32 ComponentX1 = FMath::Clamp<int32>(X1-ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
-			const int32 ComponentY1 = FMath::Clamp<int32>(Y1-ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
-			const int32 ComponentX2 = FMath::Clamp<int32>(X2-ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
-			const int32 ComponentY2 = FMath::Clamp<int32>(Y2-ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentX1 = FMath::Clamp<int32>(X1-ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentY1 = FMath::Clamp<int32>(Y1-ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentX2 = FMath::Clamp<int32>(X2-ComponentIndexX*ComponentSizeQuads, 0, ComponentSizeQuads);
+			Job.ComponentY2 = FMath::Clamp<int32>(Y2-ComponentIndexY*ComponentSizeQuads, 0, ComponentSizeQuads);
+		}
+	}
+
+	// Components can share a weightmap texture through different channels, and the mip update rewrites whole texels,
+	// so every component sharing a texture with another one is processed by the same worker
+	TArray<int32> JobGroups;
+	JobGroups.AddUninitialized(Jobs.Num());
+	{
+		auto FindGroup = [&JobGroups](int32 JobIndex)
+		{
+			while (JobGroups[JobIndex] != JobIndex)
+			{
+				JobIndex = JobGroups[JobIndex] = JobGroups[JobGroups[JobIndex]];
+			}
+			return JobIndex;
+		};
+
+		TMap<UTexture2D*, int32> TextureJobs;
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+		{
+			JobGroups[JobIndex] = JobIndex;
+			for (UTexture2D* WeightmapTexture : Jobs[JobIndex].Component->WeightmapTextures)
+			{
+				if (const int32* OtherJobIndex = TextureJobs.Find(WeightmapTexture))
+				{
+					JobGroups[FindGroup(JobIndex)] = FindGroup(*OtherJobIndex);
+				}
+				else
+				{
+					TextureJobs.Add(WeightmapTexture, JobIndex);
+				}
+			}
+		}
+	}
+
+	TArray<TArray<int32, TInlineAllocator<4>>> Groups;
+	{
+		TMap<int32, int32> GroupIndices;
+		for (int32 JobIndex = 0; JobIndex < Jobs.Num(); JobIndex++)
+		{
+			int32 Root = JobIndex;
+			while (JobGroups[Root] != Root)
+			{
+				Root = JobGroups[Root];
+			}
+
+			int32* GroupIndex = GroupIndices.Find(Root);
+			if (GroupIndex == nullptr)
+			{
+				GroupIndex = &GroupIndices.Add(Root, Groups.AddDefaulted());
+			}
+			Groups[*GroupIndex].Add(JobIndex);
+		}
+	}
+
+	// Write the texels and the weightmap mips
+	ParallelFor(Groups.Num(), [&](int32 GroupIndex)
+	{
+		for (int32 JobIndex : Groups[GroupIndex])
+		{
+			FCyLandAlphaWriteJob& Job = Jobs[JobIndex];
+			UCyLandComponent* Component = Job.Component;
 
 			// Find subsection range for this box
-			const int32 SubIndexX1 = FMath::Clamp<int32>((ComponentX1-1) / SubsectionSizeQuads,0,ComponentNumSubsections-1);	// -1 because we need to pick up vertices shared between subsections
-			const int32 SubIndexY1 = FMath::Clamp<int32>((ComponentY1-1) / SubsectionSizeQuads,0,ComponentNumSubsections-1);
-			const int32 SubIndexX2 = FMath::Clamp<int32>(ComponentX2 / SubsectionSizeQuads,0,ComponentNumSubsections-1);
-			const int32 SubIndexY2 = FMath::Clamp<int32>(ComponentY2 / SubsectionSizeQuads,0,ComponentNumSubsections-1);
+			const int32 SubIndexX1 = FMath::Clamp<int32>((Job.ComponentX1-1) / SubsectionSizeQuads,0,ComponentNumSubsections-1);	// -1 because we need to pick up vertices shared between subsections
+			const int32 SubIndexY1 = FMath::Clamp<int32>((Job.ComponentY1-1) / SubsectionSizeQuads,0,ComponentNumSubsections-1);
+			const int32 SubIndexX2 = FMath::Clamp<int32>(Job.ComponentX2 / SubsectionSizeQuads,0,ComponentNumSubsections-1);
+			const int32 SubIndexY2 = FMath::Clamp<int32>(Job.ComponentY2 / SubsectionSizeQuads,0,ComponentNumSubsections-1);
 
 			for (int32 SubIndexY = SubIndexY1; SubIndexY <= SubIndexY2; SubIndexY++)
 			{
 				for (int32 SubIndexX = SubIndexX1; SubIndexX <= SubIndexX2; SubIndexX++)
 				{
 					// Find coordinates of box that lies inside subsection
-					const int32 SubX1 = FMath::Clamp<int32>(ComponentX1-SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
-					const int32 SubY1 = FMath::Clamp<int32>(ComponentY1-SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
-					const int32 SubX2 = FMath::Clamp<int32>(ComponentX2-SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
-					const int32 SubY2 = FMath::Clamp<int32>(ComponentY2-SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
+					const int32 SubX1 = FMath::Clamp<int32>(Job.ComponentX1-SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
+					const int32 SubY1 = FMath::Clamp<int32>(Job.ComponentY1-SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
+					const int32 SubX2 = FMath::Clamp<int32>(Job.ComponentX2-SubsectionSizeQuads*SubIndexX, 0, SubsectionSizeQuads);
+					const int32 SubY2 = FMath::Clamp<int32>(Job.ComponentY2-SubsectionSizeQuads*SubIndexY, 0, SubsectionSizeQuads);
 
 					// Update texture data for the box that lies inside subsection
 					for (int32 SubY = SubY1; SubY <= SubY2; SubY++)
 					{
 						for (int32 SubX = SubX1; SubX <= SubX2; SubX++)
 						{
-							const int32 CyLandX = SubIndexX*SubsectionSizeQuads + ComponentIndexX*ComponentSizeQuads + SubX;
-							const int32 CyLandY = SubIndexY*SubsectionSizeQuads + ComponentIndexY*ComponentSizeQuads + SubY;
+							const int32 CyLandX = SubIndexX*SubsectionSizeQuads + Job.ComponentIndexX*ComponentSizeQuads + SubX;
+							const int32 CyLandY = SubIndexY*SubsectionSizeQuads + Job.ComponentIndexY*ComponentSizeQuads + SubY;
 							checkSlow( CyLandX >= X1 && CyLandX <= X2 );
 							checkSlow( CyLandY >= Y1 && CyLandY <= Y2 );
 
 							// Find the input data corresponding to this vertex
-							const int32 DataIndex = (CyLandY-Y1) * Stride + (CyLandX-X1) * CyLandInfo->Layers.Num();
+							const int32 DataIndex = (CyLandY-Y1) * Stride + (CyLandX-X1) * NumLayers;
 
 							// Adjust all layer weights
 							const int32 TexX = (SubsectionSizeQuads+1) * SubIndexX + SubX;
 							const int32 TexY = (SubsectionSizeQuads+1) * SubIndexY + SubY;
 
-							const int32 TexDataIndex = 4 * (TexX + TexY * TexSize);
-
-							int32 OtherLayerWeightSum = 0;
+							const int32 TexDataIndex = 4 * (TexX + TexY * Job.TexSize);
 
 							// Apply weights to all layers simultaneously.
-							for (int32 LayerIdx = 0; LayerIdx < Component->WeightmapLayerAllocations.Num(); LayerIdx++)
+							for (int32 LayerIdx = 0; LayerIdx < Job.LayerDataInfos.Num(); LayerIdx++)
 							{
 								// this is equivalent to saying if (DirtyLayerInfos.Contains(Allocation.LayerInfo))
 								// which is what we really mean here, but this is quicker
 								// and I've lost count of the depth we've nested for loops at this point
-								if (LayerDataInfos[LayerIdx].TexDataPtr != NULL)
+								if (Job.LayerDataInfos[LayerIdx].TexDataPtr != NULL)
 								{
-									uint8& Weight = LayerDataInfos[LayerIdx].TexDataPtr[TexDataIndex];
+									uint8& Weight = Job.LayerDataInfos[LayerIdx].TexDataPtr[TexDataIndex];
 
-									Weight = LayerDataInfos[LayerIdx].InDataPtr[DataIndex]; // Only for whole weight
+									Weight = Job.LayerDataInfos[LayerIdx].InDataPtr[DataIndex]; // Only for whole weight
 									if (Weight != 0)
 									{
-										LayerEditDataAllZero[LayerIdx] = false;
+										Job.LayerEditDataAllZero[LayerIdx] = false;
 									}
 								}
 							}
@@ -3157,80 +3314,75 @@ void FCyLandEditDataInterface::SetAlphaData(const TSet<UCyLandLayerInfoObject*>&
 					const int32 TexY1 = (SubsectionSizeQuads+1) * SubIndexY + SubY1;
 					const int32 TexX2 = (SubsectionSizeQuads+1) * SubIndexX + SubX2;
 					const int32 TexY2 = (SubsectionSizeQuads+1) * SubIndexY + SubY2;
-					for (int32 WeightmapIdx = 0; WeightmapIdx < Component->WeightmapTextures.Num(); WeightmapIdx++)
+					for (FCyLandTextureDataInfo* TexDataInfo : Job.TexDataInfos)
 					{
-						if (TexDataInfos[WeightmapIdx] != NULL)
+						if (TexDataInfo != NULL)
 						{
-							TexDataInfos[WeightmapIdx]->AddMipUpdateRegion(0,TexX1,TexY1,TexX2,TexY2);
+							TexDataInfo->AddMipUpdateRegion(0,TexX1,TexY1,TexX2,TexY2);
 						}
 					}
 				}
 			}
 
 			// Update mipmaps
-			CollisionWeightmapMipData.Reset();
-			CollisionWeightmapMipData.AddUninitialized(Component->WeightmapTextures.Num());
-			for (int32 WeightmapIdx = 0; WeightmapIdx < Component->WeightmapTextures.Num(); WeightmapIdx++)
+			for (int32 WeightmapIdx = 0; WeightmapIdx < Job.TexDataInfos.Num(); WeightmapIdx++)
 			{
-				UTexture2D* const WeightmapTexture = Component->WeightmapTextures[WeightmapIdx];
+				UCyLandComponent::UpdateWeightmapMips(ComponentNumSubsections, SubsectionSizeQuads, Component->WeightmapTextures[WeightmapIdx], Job.WeightmapTextureMipData[WeightmapIdx], Job.ComponentX1, Job.ComponentY1, Job.ComponentX2, Job.ComponentY2, Job.TexDataInfos[WeightmapIdx]);
+			}
+		}
+	}, !UseParallelComponentWrites(Groups.Num()));
 
-				const int32 NumMips = WeightmapTexture->Source.GetNumMips();
-				WeightmapTextureMipData.Reset();
-				WeightmapTextureMipData.AddUninitialized(NumMips);
-				for (int32 MipIdx = 0; MipIdx < NumMips; MipIdx++)
-				{
-					FColor* const MipData = (FColor*)TexDataInfos[WeightmapIdx]->GetMipData(MipIdx);
-					WeightmapTextureMipData[MipIdx] = MipData;
-				}
-				CollisionWeightmapMipData[WeightmapIdx] = WeightmapTextureMipData[Component->CollisionMipLevel];
+	// Notify the components one after another
+	TArray<FColor*> CollisionWeightmapMipData;
+	TArray<FColor*> SimpleCollisionWeightmapMipData;
 
-				UCyLandComponent::UpdateWeightmapMips(ComponentNumSubsections, SubsectionSizeQuads, WeightmapTexture, WeightmapTextureMipData, ComponentX1, ComponentY1, ComponentX2, ComponentY2, TexDataInfos[WeightmapIdx]);
-				WeightmapTextureMipData.Reset();
-			}
+	for (FCyLandAlphaWriteJob& Job : Jobs)
+	{
+		UCyLandComponent* Component = Job.Component;
 
+		for (int32 WeightmapIdx = 0; WeightmapIdx < Job.WeightmapTextureMipData.Num(); WeightmapIdx++)
+		{
+			CollisionWeightmapMipData.Add(Job.WeightmapTextureMipData[WeightmapIdx][Component->CollisionMipLevel]);
 			if (Component->SimpleCollisionMipLevel > Component->CollisionMipLevel)
 			{
-				for (int32 WeightmapIdx = 0; WeightmapIdx < Component->WeightmapTextures.Num(); WeightmapIdx++)
-				{
-					SimpleCollisionWeightmapMipData.Add((FColor*)TexDataInfos[WeightmapIdx]->GetMipData(Component->SimpleCollisionMipLevel));
-				}
+				SimpleCollisionWeightmapMipData.Add(Job.WeightmapTextureMipData[WeightmapIdx][Component->SimpleCollisionMipLevel]);
 			}
+		}
 
-			// Update dominant layer info stored in collision component
-			Component->UpdateCollisionLayerData(
-				CollisionWeightmapMipData.GetData(),
-				Component->SimpleCollisionMipLevel > Component->CollisionMipLevel ? SimpleCollisionWeightmapMipData.GetData() : nullptr,
-				ComponentX1, ComponentY1, ComponentX2, ComponentY2);
-			CollisionWeightmapMipData.Reset();
-			SimpleCollisionWeightmapMipData.Reset();
+		// Update dominant layer info stored in collision component
+		Component->UpdateCollisionLayerData(
+			CollisionWeightmapMipData.GetData(),
+			Component->SimpleCollisionMipLevel > Component->CollisionMipLevel ? SimpleCollisionWeightmapMipData.GetData() : nullptr,
+			Job.ComponentX1, Job.ComponentY1, Job.ComponentX2, Job.ComponentY2);
+		CollisionWeightmapMipData.Reset();
+		SimpleCollisionWeightmapMipData.Reset();
 
-			// Check if we need to remove weightmap allocations for layers that were completely painted away
-			bool bRemovedLayer = false;
-			for (int32 LayerIdx = 0; LayerIdx < Component->WeightmapLayerAllocations.Num(); LayerIdx++)
+		// Check if we need to remove weightmap allocations for layers that were completely painted away
+		bool bRemovedLayer = false;
+		for (int32 LayerIdx = 0; LayerIdx < Component->WeightmapLayerAllocations.Num(); LayerIdx++)
+		{
+			if (Job.LayerEditDataAllZero[LayerIdx])
 			{
-				if (LayerEditDataAllZero[LayerIdx])
-				{
-					bool bLayerDeleted = DeleteLayerIfAllZero(Component, LayerDataInfos[LayerIdx].TexDataPtr, TexSize, LayerIdx);
+				bool bLayerDeleted = DeleteLayerIfAllZero(Component, Job.LayerDataInfos[LayerIdx].TexDataPtr, Job.TexSize, LayerIdx);
 
-					if (bLayerDeleted)
-					{
-						LayerEditDataAllZero.RemoveAt(LayerIdx);
-						LayerDataInfos.RemoveAt(LayerIdx);
-						LayerIdx--;
+				if (bLayerDeleted)
+				{
+					Job.LayerEditDataAllZero.RemoveAt(LayerIdx);
+					Job.LayerDataInfos.RemoveAt(LayerIdx);
+					LayerIdx--;
 
-						bRemovedLayer = true;
-					}
+					bRemovedLayer = true;
 				}
 			}
+		}
 
-			if (bRemovedLayer)
-			{
-				Component->UpdateMaterialInstances();
+		if (bRemovedLayer)
+		{
+			Component->UpdateMaterialInstances();
 
-				Component->EditToolRenderData.UpdateDebugColorMaterial(Component);
+			Component->EditToolRenderData.UpdateDebugColorMaterial(Component);
 
-				Component->UpdateEditToolRenderData();
-			}
+			Component->UpdateEditToolRenderData();
 		}
 	}
 }
@@ -3974,23 +4126,23 @@ void FCyLandEditDataInterface::GetWeightDataTempl(UCyLandLayerInfoObject* LayerI
 	}
 }
 
-void FCyLandEditDataInterface::GetWeightData(UCyLandLayerInfoObject* LayerInfo, int32& X1, int32& Y1, int32& X2, int32& Y2, uint8* Data, int32 Stride)
+void FCyLandEditDataInterface::GetWeightData(UCyLandLayerInfoObject* LayerInfo, int32& X1, int32& Y1, int32& X2, int32& Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
-	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetWeightDataTempl(LayerInfo, X1, Y1, X2, Y2, ArrayStoreData);
 }
 
-void FCyLandEditDataInterface::GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride)
+void FCyLandEditDataInterface::GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
-	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetWeightDataTemplFast(LayerInfo, X1, Y1, X2, Y2, ArrayStoreData);
 }
 
@@ -4006,13 +4158,13 @@ void FCyLandEditDataInterface::GetWeightDataFast(UCyLandLayerInfoObject* LayerIn
 	GetWeightDataTemplFast(LayerInfo, X1, Y1, X2, Y2, SparseStoreData);
 }
 
-void FCyLandEditDataInterface::GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TArray<uint8>* Data, int32 Stride)
+void FCyLandEditDataInterface::GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TArray<uint8>* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
-	TArrayStoreData<TArray<uint8>> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<TArray<uint8>> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetWeightDataTemplFast(LayerInfo, X1, Y1, X2, Y2, ArrayStoreData);
 }
 
@@ -4262,13 +4414,13 @@ void FCyLandEditDataInterface::GetSelectData(const int32 X1, const int32 Y1, con
 	GetSelectDataTempl(X1, Y1, X2, Y2, SparseStoreData);
 }
 
-void FCyLandEditDataInterface::GetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride)
+void FCyLandEditDataInterface::GetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
-	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<uint8> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetSelectDataTempl(X1, Y1, X2, Y2, ArrayStoreData);
 }
 
@@ -5095,13 +5247,13 @@ void FCyLandEditDataInterface::GetXYOffsetData(int32& X1, int32& Y1, int32& X2,
 	GetXYOffsetDataTempl(X1, Y1, X2, Y2, SparseStoreData);
 }
 
-void FCyLandEditDataInterface::GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, FVector* Data, int32 Stride)
+void FCyLandEditDataInterface::GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, FVector* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if (Stride == 0)
 	{
 		Stride = (1 + X2 - X1);
 	}
-	TArrayStoreData<FVector> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<FVector> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetXYOffsetDataTempl(X1, Y1, X2, Y2, ArrayStoreData);
 }
 
@@ -5195,13 +5347,13 @@ void FCyLandEditDataInterface::GetXYOffsetDataFast(const int32 X1, const int32 Y
 	GetXYOffsetDataTemplFast(X1, Y1, X2, Y2, SparseStoreData);
 }
 
-void FCyLandEditDataInterface::GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, FVector* Data, int32 Stride)
+void FCyLandEditDataInterface::GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, FVector* Data, int32 Stride, TBitArray<>* OutValid /*= nullptr*/)
 {
 	if( Stride==0 )
 	{
 		Stride = (1+X2-X1);
 	}
-	TArrayStoreData<FVector> ArrayStoreData(X1, Y1, Data, Stride);
+	TArrayStoreData<FVector> ArrayStoreData(X1, Y1, Data, Stride, OutValid);
 	GetXYOffsetDataTemplFast(X1, Y1, X2, Y2, ArrayStoreData);
 }
 
@@ -0,0 +1,857 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandErosion.cpp: Tiled, multithreaded thermal and hydraulic erosion
+=============================================================================*/
+
+#include "CyLandErosion.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Parse.h"
+#include "CyLandPrivate.h"
+
+#if WITH_EDITOR
+#include "Engine/World.h"
+#include "CyLandInfo.h"
+#include "CyLandInfoMap.h"
+#include "CyLandLayerInfoObject.h"
+#include "CyLandEdit.h"
+#include "ScopedTransaction.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "CyLand"
+
+DECLARE_CYCLE_STAT(TEXT("Erosion"), STAT_CyLandErosion, STATGROUP_Landscape);
+
+namespace CyLandErosion
+{
+	/** Height of the vertices outside the grid and of the holes, nothing flows into them and their mask is 0 so nothing flows out */
+	static const float WallHeight = 1.0e30f;
+
+	/** Water below this evaporates completely, so a run stops once the water is gone */
+	static const float MinWater = 1.0f;
+
+	/** Size an array for a tile without giving back the memory of a bigger tile, optionally zeroed */
+	static void ResetTileArray(TArray<float>& Array, int32 Num, bool bZeroed)
+	{
+		Array.SetNumUninitialized(Num, false);
+		if (bZeroed)
+		{
+			FMemory::Memzero(Array.GetData(), Num * sizeof(float));
+		}
+	}
+
+	/**
+	 * A tile and its halo copied out of the grid. Each iteration is valid on a region two vertices smaller on each side
+	 * than the one before: one for the fluxes, which read the neighbours, and one for the gather, which reads their fluxes.
+	 * A worker keeps its tile for a whole run and loads every tile it processes into the same buffers.
+	 */
+	struct FTile
+	{
+		int32 OriginX;
+		int32 OriginY;
+		int32 Width;
+		int32 Height;
+
+		TArray<float> Heights;
+		TArray<float> Water;
+		TArray<float> Sediment;
+		TArray<float> Mask;
+		TArray<float> Softness;
+		TArray<TArray<float>> LayerWeights;
+
+		/** State each vertex had when the fluxes were computed, heights for thermal erosion and heights + water for hydraulic */
+		TArray<float> Altitude;
+		/** What a vertex sends to a neighbour is Scale times their altitude difference */
+		TArray<float> Scale;
+		/** Total sent by a vertex */
+		TArray<float> Out;
+		/** Sediment carried per unit of water leaving a vertex */
+		TArray<float> SedimentPerWater;
+		/** Layer weights a vertex had when the fluxes were computed, and what its weights send per unit of slope */
+		TArray<TArray<float>> LayerAltitude;
+		TArray<float> WeightScale;
+
+		FTile()
+			: OriginX(0)
+			, OriginY(0)
+			, Width(0)
+			, Height(0)
+		{}
+
+		/** Copy a tile and its halo out of the grid */
+		void Load(const FCyLandErosion& Erosion, int32 InOriginX, int32 InOriginY, int32 InWidth, int32 InHeight, bool bHydraulic)
+		{
+			OriginX = InOriginX;
+			OriginY = InOriginY;
+			Width = InWidth;
+			Height = InHeight;
+
+			const int32 NumVerts = Width * Height;
+			ResetTileArray(Heights, NumVerts, false);
+			ResetTileArray(Mask, NumVerts, false);
+			ResetTileArray(Altitude, NumVerts, true);
+			ResetTileArray(Scale, NumVerts, true);
+			ResetTileArray(Out, NumVerts, true);
+			if (bHydraulic)
+			{
+				ResetTileArray(Water, NumVerts, false);
+				ResetTileArray(Sediment, NumVerts, false);
+				ResetTileArray(SedimentPerWater, NumVerts, true);
+			}
+			else
+			{
+				ResetTileArray(Softness, NumVerts, false);
+				LayerWeights.SetNum(Erosion.LayerWeights.Num());
+				LayerAltitude.SetNum(Erosion.LayerWeights.Num());
+				for (int32 Layer = 0; Layer < LayerWeights.Num(); Layer++)
+				{
+					ResetTileArray(LayerWeights[Layer], NumVerts, false);
+					ResetTileArray(LayerAltitude[Layer], NumVerts, true);
+				}
+				if (LayerWeights.Num())
+				{
+					ResetTileArray(WeightScale, NumVerts, true);
+				}
+			}
+
+			for (int32 Y = 0; Y < Height; Y++)
+			{
+				const int32 GridY = OriginY + Y;
+				for (int32 X = 0; X < Width; X++)
+				{
+					const int32 GridX = OriginX + X;
+					const int32 Index = X + Y * Width;
+					const int32 GridIndex = GridX + GridY * Erosion.GetSizeX();
+					const bool bInGrid = GridX >= 0 && GridY >= 0 && GridX < Erosion.GetSizeX() && GridY < Erosion.GetSizeY() && !(Erosion.Holes.Num() && Erosion.Holes[GridIndex]);
+
+					Heights[Index] = bInGrid ? Erosion.Heights[GridIndex] : WallHeight;
+					Mask[Index] = bInGrid ? (Erosion.Mask.Num() ? Erosion.Mask[GridIndex] : 1.0f) : 0.0f;
+					if (bHydraulic)
+					{
+						Water[Index] = bInGrid ? Erosion.Water[GridIndex] : 0.0f;
+						Sediment[Index] = bInGrid ? Erosion.Sediment[GridIndex] : 0.0f;
+					}
+					else
+					{
+						Softness[Index] = bInGrid ? (Erosion.Softness.Num() ? Erosion.Softness[GridIndex] : 1.0f) : 0.0f;
+						for (int32 Layer = 0; Layer < LayerWeights.Num(); Layer++)
+						{
+							LayerWeights[Layer][Index] = bInGrid ? Erosion.LayerWeights[Layer][GridIndex] : 0.0f;
+						}
+					}
+				}
+			}
+		}
+
+		/** Copy the region [Border, Size - Border) back out, clipped to the grid. Holes are skipped, the outputs keep what they had there */
+		void Store(int32 Border, int32 GridSizeX, int32 GridSizeY, const TBitArray<>& Holes, TArray<float>& OutHeights, TArray<float>* OutWater, TArray<float>* OutSediment, TArray<TArray<float>>* OutLayerWeights) const
+		{
+			for (int32 Y = Border; Y < Height - Border; Y++)
+			{
+				const int32 GridY = OriginY + Y;
+				if (GridY < 0 || GridY >= GridSizeY)
+				{
+					continue;
+				}
+
+				const int32 X1 = FMath::Max(Border, -OriginX);
+				const int32 X2 = FMath::Min(Width - Border, GridSizeX - OriginX);
+
+				// Runs of vertices between the holes
+				int32 RunX1 = X1;
+				while (RunX1 < X2)
+				{
+					int32 RunX2 = RunX1;
+					if (Holes.Num())
+					{
+						const int32 GridRow = OriginX + GridY * GridSizeX;
+						while (RunX1 < X2 && Holes[GridRow + RunX1])
+						{
+							RunX1++;
+						}
+						RunX2 = RunX1;
+						while (RunX2 < X2 && !Holes[GridRow + RunX2])
+						{
+							RunX2++;
+						}
+					}
+					else
+					{
+						RunX2 = X2;
+					}
+
+					const int32 Count = RunX2 - RunX1;
+					if (Count > 0)
+					{
+						StoreRun(RunX1 + Y * Width, OriginX + RunX1 + GridY * GridSizeX, Count, OutHeights, OutWater, OutSediment, OutLayerWeights);
+					}
+					RunX1 = RunX2;
+				}
+			}
+		}
+
+		void StoreRun(int32 Index, int32 GridIndex, int32 Count, TArray<float>& OutHeights, TArray<float>* OutWater, TArray<float>* OutSediment, TArray<TArray<float>>* OutLayerWeights) const
+		{
+			FMemory::Memcpy(&OutHeights[GridIndex], &Heights[Index], Count * sizeof(float));
+			if (OutWater)
+			{
+				FMemory::Memcpy(&(*OutWater)[GridIndex], &Water[Index], Count * sizeof(float));
+				FMemory::Memcpy(&(*OutSediment)[GridIndex], &Sediment[Index], Count * sizeof(float));
+			}
+			if (OutLayerWeights)
+			{
+				for (int32 Layer = 0; Layer < LayerWeights.Num(); Layer++)
+				{
+					FMemory::Memcpy(&(*OutLayerWeights)[Layer][GridIndex], &LayerWeights[Layer][Index], Count * sizeof(float));
+				}
+			}
+		}
+	};
+
+	/** The Erosion tool: every vertex sends material down the slopes steeper than the threshold, proportionally to the slope */
+	struct FThermalKernel
+	{
+		static const bool bHydraulic = false;
+
+		float Threshold;
+		float Strength;
+
+		/** Layer weights of the ground the material lands on, and most material whose weights move per unit of slope */
+		float SurfaceThickness;
+		float WeightMoveThreshold;
+
+		bool Step(FTile& Tile, int32 Border) const
+		{
+			const int32 Width = Tile.Width;
+			const int32 Offsets[4] = { -1, 1, -Width, Width };
+			const int32 NumLayers = Tile.LayerWeights.Num();
+
+			float* RESTRICT Heights = Tile.Heights.GetData();
+			float* RESTRICT Altitude = Tile.Altitude.GetData();
+			float* RESTRICT Scale = Tile.Scale.GetData();
+			float* RESTRICT Out = Tile.Out.GetData();
+			const float* RESTRICT Mask = Tile.Mask.GetData();
+			const float* RESTRICT Softness = Tile.Softness.GetData();
+
+			// Fluxes
+			for (int32 Y = Border + 1; Y < Tile.Height - Border - 1; Y++)
+			{
+				for (int32 Index = Border + 1 + Y * Width; Index < Tile.Width - Border - 1 + Y * Width; Index++)
+				{
+					const float Center = Heights[Index];
+					const float BrushValue = Mask[Index];
+					Altitude[Index] = Center;
+					Scale[Index] = 0.0f;
+					Out[Index] = 0.0f;
+
+					if (NumLayers)
+					{
+						for (int32 Layer = 0; Layer < NumLayers; Layer++)
+						{
+							Tile.LayerAltitude[Layer][Index] = Tile.LayerWeights[Layer][Index];
+						}
+						Tile.WeightScale[Index] = 0.0f;
+					}
+
+					if (BrushValue <= 0.0f || Softness[Index] <= 0.0f)
+					{
+						continue;
+					}
+
+					float SlopeTotal = 0.0f;
+					float SlopeMax = Threshold;
+					float TransferSlopes = 0.0f;
+					for (int32 Neighbor = 0; Neighbor < 4; Neighbor++)
+					{
+						const float Slope = Center - Heights[Index + Offsets[Neighbor]];
+						if (Slope * BrushValue > Threshold)
+						{
+							SlopeTotal += Slope;
+							SlopeMax = FMath::Max(SlopeMax, Slope);
+						}
+						TransferSlopes += Slope > Threshold ? Slope : 0.0f;
+					}
+
+					if (SlopeTotal > 0.0f)
+					{
+						Scale[Index] = (SlopeMax - Threshold) * Softness[Index] * Strength * BrushValue / SlopeTotal;
+						Out[Index] = Scale[Index] * TransferSlopes;
+
+						if (NumLayers)
+						{
+							const float WeightTransfer = FMath::Min(WeightMoveThreshold, SlopeMax - Threshold);
+							Tile.WeightScale[Index] = Softness[Index] * Strength * BrushValue * WeightTransfer / SlopeTotal;
+						}
+					}
+				}
+			}
+
+			// Gather
+			TArray<float, TInlineAllocator<16>> NewWeights;
+			NewWeights.SetNumUninitialized(NumLayers);
+			bool bChanged = false;
+			for (int32 Y = Border + 2; Y < Tile.Height - Border - 2; Y++)
+			{
+				for (int32 Index = Border + 2 + Y * Width; Index < Tile.Width - Border - 2 + Y * Width; Index++)
+				{
+					const float Center = Altitude[Index];
+					float In = 0.0f;
+					for (int32 Neighbor = 0; Neighbor < 4; Neighbor++)
+					{
+						const int32 NeighborIndex = Index + Offsets[Neighbor];
+						const float Slope = Altitude[NeighborIndex] - Center;
+						In += Slope > Threshold ? Scale[NeighborIndex] * Slope : 0.0f;
+					}
+
+					Heights[Index] = Center - Out[Index] + In;
+					bChanged |= Out[Index] > 0.0f;
+
+					if (NumLayers)
+					{
+						// The weights of the surface are mixed with those of the material landing on it, then renormalized
+						float WeightIn[4];
+						float TotalWeightIn = 0.0f;
+						for (int32 Neighbor = 0; Neighbor < 4; Neighbor++)
+						{
+							const int32 NeighborIndex = Index + Offsets[Neighbor];
+							const float Slope = Altitude[NeighborIndex] - Center;
+							WeightIn[Neighbor] = Slope > Threshold ? Tile.WeightScale[NeighborIndex] * Slope : 0.0f;
+							TotalWeightIn += WeightIn[Neighbor];
+						}
+
+						if (TotalWeightIn > 0.0f)
+						{
+							float TotalWeight = 0.0f;
+							for (int32 Layer = 0; Layer < NumLayers; Layer++)
+							{
+								const float* RESTRICT LayerAltitude = Tile.LayerAltitude[Layer].GetData();
+								float Weight = LayerAltitude[Index] * SurfaceThickness;
+								for (int32 Neighbor = 0; Neighbor < 4; Neighbor++)
+								{
+									Weight += LayerAltitude[Index + Offsets[Neighbor]] * WeightIn[Neighbor];
+								}
+								NewWeights[Layer] = Weight;
+								TotalWeight += Weight;
+							}
+
+							if (TotalWeight > 0.0f)
+							{
+								for (int32 Layer = 0; Layer < NumLayers; Layer++)
+								{
+									Tile.LayerWeights[Layer][Index] = NewWeights[Layer] / TotalWeight;
+								}
+							}
+						}
+					}
+				}
+			}
+
+			return bChanged;
+		}
+	};
+
+	/**
+	 * The Hydraulic Erosion tool: water dissolves the ground under it, flows to the lower neighbours carrying its
+	 * sediment, then partly evaporates and deposits the sediment it can't carry anymore
+	 */
+	struct FHydraulicKernel
+	{
+		static const bool bHydraulic = true;
+
+		float DissolvingRatio;
+		float AltitudeScale;
+		float EvaporateRatio;
+		float SedimentCapacity;
+
+		bool Step(FTile& Tile, int32 Border) const
+		{
+			const int32 Width = Tile.Width;
+			const int32 Offsets[8] = { -1, 1, -Width, Width, -1 - Width, 1 + Width, 1 - Width, -1 + Width };
+
+			float* RESTRICT Heights = Tile.Heights.GetData();
+			float* RESTRICT Water = Tile.Water.GetData();
+			float* RESTRICT Sediment = Tile.Sediment.GetData();
+			float* RESTRICT Altitude = Tile.Altitude.GetData();
+			float* RESTRICT Scale = Tile.Scale.GetData();
+			float* RESTRICT Out = Tile.Out.GetData();
+			float* RESTRICT SedimentPerWater = Tile.SedimentPerWater.GetData();
+			const float* RESTRICT Mask = Tile.Mask.GetData();
+
+			// Dissolving
+			for (int32 Y = Border; Y < Tile.Height - Border; Y++)
+			{
+				for (int32 Index = Border + Y * Width; Index < Tile.Width - Border + Y * Width; Index++)
+				{
+					const float DissolvedAmount = DissolvingRatio * Water[Index] * Mask[Index];
+					if (DissolvedAmount > 0.0f && Heights[Index] >= DissolvedAmount)
+					{
+						Heights[Index] -= DissolvedAmount;
+						Sediment[Index] += DissolvedAmount;
+					}
+				}
+			}
+
+			// Fluxes, water goes to the lower neighbours proportionally to the altitude difference
+			for (int32 Y = Border + 1; Y < Tile.Height - Border - 1; Y++)
+			{
+				for (int32 Index = Border + 1 + Y * Width; Index < Tile.Width - Border - 1 + Y * Width; Index++)
+				{
+					const float CenterAltitude = Heights[Index] + Water[Index];
+					const float BrushValue = Mask[Index];
+					Altitude[Index] = CenterAltitude;
+					Scale[Index] = 0.0f;
+					Out[Index] = 0.0f;
+					SedimentPerWater[Index] = Water[Index] > 0.0f ? Sediment[Index] / Water[Index] : 0.0f;
+
+					if (BrushValue <= 0.0f)
+					{
+						continue;
+					}
+
+					float TotalAltitudeDiff = 0.0f;
+					float AverageAltitude = 0.0f;
+					int32 LowerNeighbor = 0;
+					bool bHeightDiff = false;
+					for (int32 Neighbor = 0; Neighbor < 8; Neighbor++)
+					{
+						const int32 NeighborIndex = Index + Offsets[Neighbor];
+						const float NeighborAltitude = Heights[NeighborIndex] + Water[NeighborIndex];
+						if (CenterAltitude > NeighborAltitude)
+						{
+							TotalAltitudeDiff += CenterAltitude - NeighborAltitude;
+							AverageAltitude += NeighborAltitude;
+							LowerNeighbor++;
+							bHeightDiff |= Heights[Index] > Heights[NeighborIndex];
+						}
+					}
+
+					if (LowerNeighbor > 0)
+					{
+						AverageAltitude /= LowerNeighbor;
+						// This is not mathematically correct, but makes good result
+						if (bHeightDiff)
+						{
+							AverageAltitude *= AltitudeScale;
+						}
+
+						const float WaterTransfer = FMath::Min(Water[Index], CenterAltitude - AverageAltitude) * BrushValue;
+						Scale[Index] = WaterTransfer / TotalAltitudeDiff;
+						Out[Index] = WaterTransfer;
+					}
+				}
+			}
+
+			// Gather, then evaporation
+			bool bWaterExist = false;
+			for (int32 Y = Border + 2; Y < Tile.Height - Border - 2; Y++)
+			{
+				for (int32 Index = Border + 2 + Y * Width; Index < Tile.Width - Border - 2 + Y * Width; Index++)
+				{
+					const float CenterAltitude = Altitude[Index];
+					float InWater = 0.0f;
+					float InSediment = 0.0f;
+					for (int32 Neighbor = 0; Neighbor < 8; Neighbor++)
+					{
+						const int32 NeighborIndex = Index + Offsets[Neighbor];
+						const float AltitudeDiff = Altitude[NeighborIndex] - CenterAltitude;
+						const float WaterDiff = AltitudeDiff > 0.0f ? Scale[NeighborIndex] * AltitudeDiff : 0.0f;
+						InWater += WaterDiff;
+						InSediment += WaterDiff * SedimentPerWater[NeighborIndex];
+					}
+
+					float NewWater = FMath::Max(Water[Index] - Out[Index] + InWater, 0.0f);
+					float NewSediment = FMath::Max(Sediment[Index] - Out[Index] * SedimentPerWater[Index] + InSediment, 0.0f);
+
+					if (Mask[Index] > 0.0f && NewWater > 0.0f)
+					{
+						bWaterExist = true;
+						NewWater *= 1.0f - EvaporateRatio;
+						NewWater = NewWater >= MinWater ? NewWater : 0.0f;
+
+						const float SedimentDiff = NewSediment - SedimentCapacity * NewWater;
+						if (SedimentDiff > 0.0f)
+						{
+							NewSediment -= SedimentDiff;
+							Heights[Index] += SedimentDiff;
+						}
+					}
+
+					Water[Index] = NewWater;
+					Sediment[Index] = NewSediment;
+				}
+			}
+
+			return bWaterExist;
+		}
+	};
+}
+
+FCyLandErosion::FCyLandErosion(int32 InSizeX, int32 InSizeY)
+	: TileSize(DefaultTileSize)
+	, SizeX(InSizeX)
+	, SizeY(InSizeY)
+{
+	check(SizeX > 0 && SizeY > 0);
+	Heights.SetNumZeroed(SizeX * SizeY);
+}
+
+void FCyLandErosion::SetHeights(const uint16* InHeights, int32 Stride)
+{
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const uint16* Row = InHeights + Y * Stride;
+		float* RESTRICT OutRow = Heights.GetData() + Y * SizeX;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			OutRow[X] = Row[X];
+		}
+	}
+
+	Water.Empty();
+	Sediment.Empty();
+}
+
+void FCyLandErosion::GetHeights(uint16* OutHeights, int32 Stride) const
+{
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const float* Row = Heights.GetData() + Y * SizeX;
+		uint16* RESTRICT OutRow = OutHeights + Y * Stride;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			OutRow[X] = (uint16)FMath::Clamp<int32>(FMath::RoundToInt(Row[X]), 0, 65535);
+		}
+	}
+}
+
+void FCyLandErosion::Rain(float Amount)
+{
+	Water.SetNumZeroed(SizeX * SizeY);
+	Sediment.SetNumZeroed(SizeX * SizeY);
+	for (int32 Index = 0; Index < Water.Num(); Index++)
+	{
+		if (Holes.Num() == 0 || !Holes[Index])
+		{
+			Water[Index] += Amount * (Mask.Num() ? Mask[Index] : 1.0f);
+		}
+	}
+}
+
+template<typename TKernel>
+int32 FCyLandErosion::Run(int32 Iterations, const TKernel& Kernel)
+{
+	using namespace CyLandErosion;
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandErosion);
+
+	check(Mask.Num() == 0 || Mask.Num() == Heights.Num());
+	check(Softness.Num() == 0 || Softness.Num() == Heights.Num());
+	check(Holes.Num() == 0 || Holes.Num() == Heights.Num());
+	for (const TArray<float>& Weights : LayerWeights)
+	{
+		check(Weights.Num() == Heights.Num());
+	}
+	const bool bLayerWeights = !TKernel::bHydraulic && LayerWeights.Num() > 0;
+	if (TKernel::bHydraulic)
+	{
+		Water.SetNumZeroed(Heights.Num());
+		Sediment.SetNumZeroed(Heights.Num());
+	}
+
+	const int32 Size = FMath::Max(TileSize, 1);
+	const int32 Halo = 2 * IterationsPerRound;
+	const int32 NumTilesX = FMath::DivideAndRoundUp(SizeX, Size);
+	const int32 NumTilesY = FMath::DivideAndRoundUp(SizeY, Size);
+
+	// Tiles read their halo from the current state, so their interior goes to the next one. The holes aren't stored,
+	// the next state starts with what they have
+	const bool bHoles = Holes.Num() > 0;
+	TArray<float> NextHeights;
+	TArray<float> NextWater;
+	TArray<float> NextSediment;
+	if (bHoles)
+	{
+		NextHeights = Heights;
+	}
+	else
+	{
+		NextHeights.SetNumUninitialized(Heights.Num());
+	}
+	if (TKernel::bHydraulic)
+	{
+		if (bHoles)
+		{
+			NextWater = Water;
+			NextSediment = Sediment;
+		}
+		else
+		{
+			NextWater.SetNumUninitialized(Heights.Num());
+			NextSediment.SetNumUninitialized(Heights.Num());
+		}
+	}
+	TArray<TArray<float>> NextLayerWeights;
+	if (bLayerWeights)
+	{
+		if (bHoles)
+		{
+			NextLayerWeights = LayerWeights;
+		}
+		else
+		{
+			NextLayerWeights.SetNum(LayerWeights.Num());
+			for (TArray<float>& Weights : NextLayerWeights)
+			{
+				Weights.SetNumUninitialized(Heights.Num());
+			}
+		}
+	}
+
+	// One tile per job, the jobs take the tiles in turn so their buffers are allocated once for all the rounds
+	const int32 NumTiles = NumTilesX * NumTilesY;
+	const int32 NumJobs = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumTiles);
+	TArray<FTile> JobTiles;
+	JobTiles.SetNum(NumJobs);
+
+	int32 IterationsRun = 0;
+	while (IterationsRun < Iterations)
+	{
+		const int32 RoundIterations = FMath::Min(Halo / 2, Iterations - IterationsRun);
+		FThreadSafeCounter NumActiveTiles;
+		FThreadSafeCounter NextTileIndex;
+
+		ParallelFor(NumJobs, [&](int32 Job)
+		{
+			FTile& Tile = JobTiles[Job];
+			for (int32 TileIndex = NextTileIndex.Increment() - 1; TileIndex < NumTiles; TileIndex = NextTileIndex.Increment() - 1)
+			{
+				const int32 TileX = (TileIndex % NumTilesX) * Size;
+				const int32 TileY = (TileIndex / NumTilesX) * Size;
+				const int32 TileSizeX = FMath::Min(Size, SizeX - TileX);
+				const int32 TileSizeY = FMath::Min(Size, SizeY - TileY);
+
+				Tile.Load(*this, TileX - Halo, TileY - Halo, TileSizeX + 2 * Halo, TileSizeY + 2 * Halo, TKernel::bHydraulic);
+
+				bool bActive = false;
+				for (int32 Iteration = 0; Iteration < RoundIterations; Iteration++)
+				{
+					bActive |= Kernel.Step(Tile, 2 * Iteration);
+				}
+
+				Tile.Store(Halo, SizeX, SizeY, Holes, NextHeights, TKernel::bHydraulic ? &NextWater : nullptr, TKernel::bHydraulic ? &NextSediment : nullptr, bLayerWeights ? &NextLayerWeights : nullptr);
+
+				if (bActive)
+				{
+					NumActiveTiles.Increment();
+				}
+			}
+		});
+
+		Exchange(Heights, NextHeights);
+		if (TKernel::bHydraulic)
+		{
+			Exchange(Water, NextWater);
+			Exchange(Sediment, NextSediment);
+		}
+		if (bLayerWeights)
+		{
+			Exchange(LayerWeights, NextLayerWeights);
+		}
+
+		IterationsRun += RoundIterations;
+		if (NumActiveTiles.GetValue() == 0)
+		{
+			break;
+		}
+	}
+
+	return IterationsRun;
+}
+
+int32 FCyLandErosion::RunThermal(const FCyLandThermalErosionSettings& Settings)
+{
+	CyLandErosion::FThermalKernel Kernel;
+	Kernel.Threshold = Settings.Threshold;
+	Kernel.Strength = Settings.Strength;
+	// As the Erosion tool always did, between a quarter and half the surface thickness moves with the material
+	const int32 Thickness = FMath::Max(Settings.SurfaceThickness, 1);
+	Kernel.SurfaceThickness = Thickness;
+	Kernel.WeightMoveThreshold = FMath::Min(FMath::Max<float>(Thickness >> 2, Settings.Threshold), (float)(Thickness >> 1));
+	return Run(Settings.Iterations, Kernel);
+}
+
+int32 FCyLandErosion::RunHydraulic(const FCyLandHydraulicErosionSettings& Settings)
+{
+	CyLandErosion::FHydraulicKernel Kernel;
+	Kernel.DissolvingRatio = 0.07f * Settings.Strength;
+	Kernel.AltitudeScale = 1.0f - 0.1f * Settings.Strength;
+	Kernel.EvaporateRatio = Settings.EvaporateRatio;
+	Kernel.SedimentCapacity = 0.1f * Settings.SedimentCapacity;
+	return Run(Settings.Iterations, Kernel);
+}
+
+#if WITH_EDITOR
+bool FCyLandErosion::ErodeCyLand(UCyLandInfo* CyLandInfo, FIntRect Region, const FCyLandThermalErosionSettings* Thermal, const FCyLandHydraulicErosionSettings* Hydraulic, float RainAmount)
+{
+	if (!CyLandInfo || (!Thermal && !Hydraulic))
+	{
+		return false;
+	}
+
+	int32 MinX, MinY, MaxX, MaxY;
+	if (!CyLandInfo->GetCyLandExtent(MinX, MinY, MaxX, MaxY))
+	{
+		return false;
+	}
+
+	if (Region.Area() > 0)
+	{
+		MinX = FMath::Max(MinX, Region.Min.X);
+		MinY = FMath::Max(MinY, Region.Min.Y);
+		MaxX = FMath::Min(MaxX, Region.Max.X);
+		MaxY = FMath::Min(MaxY, Region.Max.Y);
+		if (MinX > MaxX || MinY > MaxY)
+		{
+			return false;
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FCyLandEditDataInterface CyLandEdit(CyLandInfo);
+	FCyLandErosion Erosion(MaxX - MinX + 1, MaxY - MinY + 1);
+	const int32 NumVerts = Erosion.GetSizeX() * Erosion.GetSizeY();
+
+	TArray<uint16> HeightData;
+	HeightData.SetNumZeroed(NumVerts);
+	TBitArray<> Valid;
+	if (CyLandEdit.GetValidVertices(MinX, MinY, MaxX, MaxY, Valid))
+	{
+		CyLandEdit.GetHeightDataFast(MinX, MinY, MaxX, MaxY, HeightData.GetData(), 0);
+	}
+	else
+	{
+		// Missing components are walls that keep their heights. They are filled in from their neighbours rather than
+		// left at 0 for the normals computed along them when the heights are written back
+		Erosion.Holes.Init(false, NumVerts);
+		for (int32 Index = 0; Index < NumVerts; Index++)
+		{
+			Erosion.Holes[Index] = !Valid[Index];
+		}
+		int32 X1 = MinX, Y1 = MinY, X2 = MaxX, Y2 = MaxY;
+		CyLandEdit.GetHeightData(X1, Y1, X2, Y2, HeightData.GetData(), Erosion.GetSizeX());
+	}
+	Erosion.SetHeights(HeightData.GetData(), Erosion.GetSizeX());
+
+	if (Thermal)
+	{
+		// Softness = 1 - sum of the layer weights times their hardness
+		TArray<uint8> WeightData;
+		for (const FCyLandInfoLayerSettings& Layer : CyLandInfo->Layers)
+		{
+			if (Layer.LayerInfoObj && Layer.LayerInfoObj->Hardness > 0.0f)
+			{
+				WeightData.SetNumZeroed(NumVerts);
+				CyLandEdit.GetWeightDataFast(Layer.LayerInfoObj, MinX, MinY, MaxX, MaxY, WeightData.GetData(), 0);
+
+				if (Erosion.Softness.Num() == 0)
+				{
+					Erosion.Softness.Init(1.0f, NumVerts);
+				}
+				for (int32 Index = 0; Index < NumVerts; Index++)
+				{
+					Erosion.Softness[Index] -= (float)WeightData[Index] / 255.0f * Layer.LayerInfoObj->Hardness;
+				}
+			}
+		}
+	}
+
+	const double ReadTime = FPlatformTime::Seconds() - StartTime;
+	double StageStartTime = FPlatformTime::Seconds();
+
+	int32 ThermalIterations = 0;
+	if (Thermal)
+	{
+		ThermalIterations = Erosion.RunThermal(*Thermal);
+	}
+	const double ThermalTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	int32 HydraulicIterations = 0;
+	if (Hydraulic)
+	{
+		Erosion.Rain(RainAmount);
+		HydraulicIterations = Erosion.RunHydraulic(*Hydraulic);
+	}
+	const double HydraulicTime = FPlatformTime::Seconds() - StageStartTime;
+	StageStartTime = FPlatformTime::Seconds();
+
+	Erosion.GetHeights(HeightData.GetData(), Erosion.GetSizeX());
+	CyLandEdit.SetHeightData(MinX, MinY, MaxX, MaxY, HeightData.GetData(), 0, true);
+	CyLandEdit.Flush();
+
+	const double WriteTime = FPlatformTime::Seconds() - StageStartTime;
+
+	UE_LOG(LogCyLand, Log, TEXT("Eroded %dx%d vertices of %s: read %.2f s, thermal %d iterations %.2f s, hydraulic %d iterations %.2f s, write %.2f s"),
+		Erosion.GetSizeX(), Erosion.GetSizeY(), *CyLandInfo->GetName(), ReadTime, ThermalIterations, ThermalTime, HydraulicIterations, HydraulicTime, WriteTime);
+
+	return true;
+}
+
+namespace CyLandErosion
+{
+	static void ErodeCommand(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const FString Cmd = FString::Join(Args, TEXT(" "));
+
+		// FParse::Param wants a dash in front, the flags are plain words here
+		const bool bHydraulic = Args.Contains(TEXT("Hydraulic"));
+		const bool bThermal = Args.Contains(TEXT("Thermal")) || !bHydraulic;
+
+		FCyLandThermalErosionSettings Thermal;
+		FParse::Value(*Cmd, TEXT("ThermalIterations="), Thermal.Iterations);
+		FParse::Value(*Cmd, TEXT("Threshold="), Thermal.Threshold);
+		FParse::Value(*Cmd, TEXT("Strength="), Thermal.Strength);
+
+		FCyLandHydraulicErosionSettings Hydraulic;
+		float RainAmount = 128.0f;
+		FParse::Value(*Cmd, TEXT("HydraulicIterations="), Hydraulic.Iterations);
+		FParse::Value(*Cmd, TEXT("Strength="), Hydraulic.Strength);
+		FParse::Value(*Cmd, TEXT("SedimentCapacity="), Hydraulic.SedimentCapacity);
+		FParse::Value(*Cmd, TEXT("Rain="), RainAmount);
+
+		FIntRect Region;
+		FParse::Value(*Cmd, TEXT("MinX="), Region.Min.X);
+		FParse::Value(*Cmd, TEXT("MinY="), Region.Min.Y);
+		FParse::Value(*Cmd, TEXT("MaxX="), Region.Max.X);
+		FParse::Value(*Cmd, TEXT("MaxY="), Region.Max.Y);
+
+		if (!World)
+		{
+			return;
+		}
+
+		FScopedTransaction Transaction(LOCTEXT("Undo_ErodeCyLand", "Eroding CyLand"));
+
+		int32 NumEroded = 0;
+		for (const TPair<FGuid, UCyLandInfo*>& Pair : UCyLandInfoMap::GetCyLandInfoMap(World).Map)
+		{
+			NumEroded += FCyLandErosion::ErodeCyLand(Pair.Value, Region, bThermal ? &Thermal : nullptr, bHydraulic ? &Hydraulic : nullptr, RainAmount) ? 1 : 0;
+		}
+
+		Ar.Logf(TEXT("Eroded %d CyLands"), NumEroded);
+	}
+
+	static FAutoConsoleCommand ErodeCmd(
+		TEXT("CyLand.Erode"),
+		TEXT("Erode every CyLand of the editor world as a batch job, thermal erosion unless only Hydraulic is given. ")
+		TEXT("Args: [Thermal] [Hydraulic] [ThermalIterations=28] [Threshold=64] [Strength=0.3] [HydraulicIterations=75] [SedimentCapacity=0.3] [Rain=128] [MinX= MinY= MaxX= MaxY=]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&ErodeCommand));
+}
+#endif // WITH_EDITOR
+
+#undef LOCTEXT_NAMESPACE
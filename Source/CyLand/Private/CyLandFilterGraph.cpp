@@ -0,0 +1,680 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandFilterGraph.cpp: Chains of height filters run over whole landscapes
+=============================================================================*/
+
+#include "CyLandFilterGraph.h"
+#include "CyLandNoise.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Async/ParallelFor.h"
+#include "Misc/Parse.h"
+#include "CyLandPrivate.h"
+
+#if WITH_EDITOR
+#include "Engine/World.h"
+#include "CyLandInfo.h"
+#include "CyLandInfoMap.h"
+#include "CyLandEdit.h"
+#include "ScopedTransaction.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "CyLand"
+
+DECLARE_CYCLE_STAT(TEXT("Filter Graph"), STAT_CyLandFilterGraph, STATGROUP_Landscape);
+
+void FCyLandSmoothHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	if (Radius == 0 || Strength <= 0.0f)
+	{
+		return;
+	}
+
+	if (Tile.Valid.Num())
+	{
+		ApplyWithHoles(Tile);
+		return;
+	}
+
+	const int32 SizeX = Tile.SizeX;
+	const int32 SizeY = Tile.SizeY;
+
+	// Rows first, then columns, both with running sums. Sums are in double so 16 bit heights don't lose precision
+	TArray<float> RowSmoothed;
+	RowSmoothed.SetNumUninitialized(SizeX * SizeY);
+	TArray<double> Sums;
+	Sums.SetNumUninitialized(SizeX + 1);
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const float* Row = Tile.GetRow(Y);
+		Sums[0] = 0.0;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			Sums[X + 1] = Sums[X] + Row[X];
+		}
+
+		float* RESTRICT OutRow = RowSmoothed.GetData() + Y * SizeX;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const int32 XRadius = FMath::Min3(Radius, X, SizeX - X - 1);
+			OutRow[X] = (Sums[X + XRadius + 1] - Sums[X - XRadius]) / (2 * XRadius + 1);
+		}
+	}
+
+	// Running sums of whole rows, so the column pass also works on rows
+	Sums.SetNumUninitialized(SizeX * (SizeY + 1));
+	FMemory::Memzero(Sums.GetData(), SizeX * sizeof(double));
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const double* RESTRICT Above = Sums.GetData() + Y * SizeX;
+		const float* RESTRICT Row = RowSmoothed.GetData() + Y * SizeX;
+		double* RESTRICT OutSums = Sums.GetData() + (Y + 1) * SizeX;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			OutSums[X] = Above[X] + Row[X];
+		}
+	}
+
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const int32 YRadius = FMath::Min3(Radius, Y, SizeY - Y - 1);
+		const double* RESTRICT Top = Sums.GetData() + (Y - YRadius) * SizeX;
+		const double* RESTRICT Bottom = Sums.GetData() + (Y + YRadius + 1) * SizeX;
+		const double InvNumSamples = 1.0 / (2 * YRadius + 1);
+		float* RESTRICT Row = Tile.GetRow(Y);
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			Row[X] = FMath::Lerp(Row[X], (float)((Bottom[X] - Top[X]) * InvNumSamples), Strength);
+		}
+	}
+}
+
+void FCyLandSmoothHeightFilter::ApplyWithHoles(FCyLandFilterTile& Tile) const
+{
+	const int32 SizeX = Tile.SizeX;
+	const int32 SizeY = Tile.SizeY;
+
+	// As Apply, with running sums of the valid heights and of the number of valid vertices
+	TArray<double> RowSums;
+	TArray<int32> RowCounts;
+	RowSums.SetNumUninitialized(SizeX * SizeY);
+	RowCounts.SetNumUninitialized(SizeX * SizeY);
+	TArray<double> Sums;
+	TArray<int32> Counts;
+	Sums.SetNumUninitialized(SizeX + 1);
+	Counts.SetNumUninitialized(SizeX + 1);
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const float* Row = Tile.GetRow(Y);
+		Sums[0] = 0.0;
+		Counts[0] = 0;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const bool bValid = Tile.Valid[X + Y * SizeX];
+			Sums[X + 1] = Sums[X] + (bValid ? Row[X] : 0.0f);
+			Counts[X + 1] = Counts[X] + (bValid ? 1 : 0);
+		}
+
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const int32 XRadius = FMath::Min3(Radius, X, SizeX - X - 1);
+			RowSums[X + Y * SizeX] = Sums[X + XRadius + 1] - Sums[X - XRadius];
+			RowCounts[X + Y * SizeX] = Counts[X + XRadius + 1] - Counts[X - XRadius];
+		}
+	}
+
+	Sums.SetNumUninitialized(SizeX * (SizeY + 1));
+	Counts.SetNumUninitialized(SizeX * (SizeY + 1));
+	FMemory::Memzero(Sums.GetData(), SizeX * sizeof(double));
+	FMemory::Memzero(Counts.GetData(), SizeX * sizeof(int32));
+	for (int32 Index = 0; Index < SizeX * SizeY; Index++)
+	{
+		Sums[Index + SizeX] = Sums[Index] + RowSums[Index];
+		Counts[Index + SizeX] = Counts[Index] + RowCounts[Index];
+	}
+
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const int32 YRadius = FMath::Min3(Radius, Y, SizeY - Y - 1);
+		const int32 Top = (Y - YRadius) * SizeX;
+		const int32 Bottom = (Y + YRadius + 1) * SizeX;
+		float* RESTRICT Row = Tile.GetRow(Y);
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			// A valid vertex is in its own window, there is at least one
+			if (Tile.Valid[X + Y * SizeX])
+			{
+				const double Average = (Sums[Bottom + X] - Sums[Top + X]) / (Counts[Bottom + X] - Counts[Top + X]);
+				Row[X] = FMath::Lerp(Row[X], (float)Average, Strength);
+			}
+		}
+	}
+}
+
+void FCyLandFlattenHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	for (float& Value : Tile.Heights)
+	{
+		const float Delta = Height - Value;
+		if ((Delta > 0.0f && bRaise) || (Delta < 0.0f && bLower))
+		{
+			Value += Delta * Strength;
+		}
+	}
+}
+
+void FCyLandNoiseHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	if (Scale <= DELTA)
+	{
+		return;
+	}
+
+	FCyLandNoise Noise(Scale, Amount);
+	Noise.SetDomainWarp(WarpScale, WarpAmount);
+
+	TArray<float> NoiseData;
+	NoiseData.SetNumUninitialized(Tile.SizeX);
+	for (int32 Y = 0; Y < Tile.SizeY; Y++)
+	{
+		Noise.SampleRow(Tile.Origin.X, Tile.Origin.Y + Y, Tile.SizeX, NoiseData.GetData());
+
+		float* Row = Tile.GetRow(Y);
+		for (int32 X = 0; X < Tile.SizeX; X++)
+		{
+			Row[X] += NoiseData[X];
+		}
+	}
+}
+
+void FCyLandRampHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	const FVector2D Start2D(Start);
+	const FVector2D Direction = FVector2D(End) - Start2D;
+	const float LengthSquared = Direction.SizeSquared();
+	if (LengthSquared <= KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	const float HalfWidth = Width * 0.5f;
+	for (int32 Y = 0; Y < Tile.SizeY; Y++)
+	{
+		float* Row = Tile.GetRow(Y);
+		for (int32 X = 0; X < Tile.SizeX; X++)
+		{
+			const FVector2D Offset = FVector2D(Tile.Origin.X + X, Tile.Origin.Y + Y) - Start2D;
+			const float Along = (Offset | Direction) / LengthSquared;
+			if (Along < 0.0f || Along > 1.0f)
+			{
+				continue;
+			}
+
+			const float Distance = (Offset - Direction * Along).Size();
+			const float Alpha = Distance <= HalfWidth ? 1.0f : 1.0f - (Distance - HalfWidth) / FMath::Max(Falloff, KINDA_SMALL_NUMBER);
+			if (Alpha > 0.0f)
+			{
+				Row[X] = FMath::Lerp(Row[X], FMath::Lerp(Start.Z, End.Z, Along), Alpha);
+			}
+		}
+	}
+}
+
+/** The vertices of the tile that aren't valid are the holes of the erosion */
+static void SetErosionHoles(const FCyLandFilterTile& Tile, FCyLandErosion& Erosion)
+{
+	if (Tile.Valid.Num())
+	{
+		Erosion.Holes.Init(false, Tile.Valid.Num());
+		for (int32 Index = 0; Index < Tile.Valid.Num(); Index++)
+		{
+			Erosion.Holes[Index] = !Tile.Valid[Index];
+		}
+	}
+}
+
+void FCyLandThermalErosionHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	FCyLandErosion Erosion(Tile.SizeX, Tile.SizeY);
+	SetErosionHoles(Tile, Erosion);
+	Exchange(Erosion.Heights, Tile.Heights);
+	Erosion.RunThermal(Settings);
+	Exchange(Erosion.Heights, Tile.Heights);
+}
+
+void FCyLandHydraulicErosionHeightFilter::Apply(FCyLandFilterTile& Tile) const
+{
+	FCyLandErosion Erosion(Tile.SizeX, Tile.SizeY);
+	SetErosionHoles(Tile, Erosion);
+	Exchange(Erosion.Heights, Tile.Heights);
+	Erosion.Rain(RainAmount);
+	Erosion.RunHydraulic(Settings);
+	Exchange(Erosion.Heights, Tile.Heights);
+}
+
+bool FCyLandFilterGraph::AddFromString(const FString& Description, FString& OutError)
+{
+	TArray<FString> Stages;
+	Description.ParseIntoArray(Stages, TEXT("|"));
+
+	for (const FString& Stage : Stages)
+	{
+		TArray<FString> Tokens;
+		Stage.ParseIntoArrayWS(Tokens);
+		if (Tokens.Num() == 0)
+		{
+			continue;
+		}
+
+		const FString& Name = Tokens[0];
+		if (Name == TEXT("Smooth"))
+		{
+			int32 Radius = 4;
+			float Strength = 1.0f;
+			FParse::Value(*Stage, TEXT("Radius="), Radius);
+			FParse::Value(*Stage, TEXT("Strength="), Strength);
+			Add<FCyLandSmoothHeightFilter>(Radius, Strength);
+		}
+		else if (Name == TEXT("Flatten"))
+		{
+			float Height = 32768.0f;
+			float Strength = 1.0f;
+			FParse::Value(*Stage, TEXT("Height="), Height);
+			FParse::Value(*Stage, TEXT("Strength="), Strength);
+			Add<FCyLandFlattenHeightFilter>(Height, Strength, !Tokens.Contains(TEXT("LowerOnly")), !Tokens.Contains(TEXT("RaiseOnly")));
+		}
+		else if (Name == TEXT("Noise"))
+		{
+			float Amount = 256.0f;
+			float Scale = 128.0f;
+			FParse::Value(*Stage, TEXT("Amount="), Amount);
+			float WarpScale = 0.0f;
+			float WarpAmount = 0.0f;
+			FParse::Value(*Stage, TEXT("Scale="), Scale);
+			FParse::Value(*Stage, TEXT("WarpScale="), WarpScale);
+			FParse::Value(*Stage, TEXT("WarpAmount="), WarpAmount);
+			Add<FCyLandNoiseHeightFilter>(Amount, Scale, WarpScale, WarpAmount);
+		}
+		else if (Name == TEXT("Ramp"))
+		{
+			FVector Start(ForceInitToZero), End(ForceInitToZero);
+			float Width = 8.0f;
+			float Falloff = 8.0f;
+			FParse::Value(*Stage, TEXT("StartX="), Start.X);
+			FParse::Value(*Stage, TEXT("StartY="), Start.Y);
+			FParse::Value(*Stage, TEXT("StartZ="), Start.Z);
+			FParse::Value(*Stage, TEXT("EndX="), End.X);
+			FParse::Value(*Stage, TEXT("EndY="), End.Y);
+			FParse::Value(*Stage, TEXT("EndZ="), End.Z);
+			FParse::Value(*Stage, TEXT("Width="), Width);
+			FParse::Value(*Stage, TEXT("Falloff="), Falloff);
+			Add<FCyLandRampHeightFilter>(Start, End, Width, Falloff);
+		}
+		else if (Name == TEXT("Thermal"))
+		{
+			FCyLandThermalErosionSettings Settings;
+			FParse::Value(*Stage, TEXT("Iterations="), Settings.Iterations);
+			FParse::Value(*Stage, TEXT("Threshold="), Settings.Threshold);
+			FParse::Value(*Stage, TEXT("Strength="), Settings.Strength);
+			Add<FCyLandThermalErosionHeightFilter>(Settings);
+		}
+		else if (Name == TEXT("Hydraulic"))
+		{
+			FCyLandHydraulicErosionSettings Settings;
+			float RainAmount = 128.0f;
+			FParse::Value(*Stage, TEXT("Iterations="), Settings.Iterations);
+			FParse::Value(*Stage, TEXT("Strength="), Settings.Strength);
+			FParse::Value(*Stage, TEXT("SedimentCapacity="), Settings.SedimentCapacity);
+			FParse::Value(*Stage, TEXT("Rain="), RainAmount);
+			Add<FCyLandHydraulicErosionHeightFilter>(Settings, RainAmount);
+		}
+		else
+		{
+			OutError = FString::Printf(TEXT("Unknown filter '%s'"), *Name);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int32 FCyLandFilterGraph::GetApron() const
+{
+	int32 Apron = 0;
+	for (const TUniquePtr<FCyLandHeightFilter>& Filter : Filters)
+	{
+		Apron += Filter->GetApron();
+	}
+	return Apron;
+}
+
+namespace CyLandFilterGraph
+{
+	/** Heights of a band of the landscape read in one go */
+	struct FBand
+	{
+		FIntRect Rect;
+		TArray<uint16> Heights;
+
+		/** Vertices that have heights, empty if they all have */
+		TBitArray<> Valid;
+
+		int32 GetSizeX() const { return Rect.Max.X - Rect.Min.X + 1; }
+
+		void Read(const TFunctionRef<void(const FIntRect&, uint16*, TBitArray<>&)>& ReadHeights, const FIntRect& InRect)
+		{
+			Rect = InRect;
+			Heights.SetNumZeroed(GetSizeX() * (Rect.Max.Y - Rect.Min.Y + 1));
+			Valid.Empty();
+			ReadHeights(Rect, Heights.GetData(), Valid);
+		}
+	};
+}
+
+void FCyLandFilterGraph::RunBands(const TCHAR* Name, const FIntRect& Extent, const FIntRect& Region, int32 TileSize, TFunctionRef<void(const FIntRect&, uint16*, TBitArray<>&)> ReadHeights, TFunctionRef<void(const FIntRect&, const uint16*)> WriteHeights) const
+{
+	using namespace CyLandFilterGraph;
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandFilterGraph);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const int32 Apron = GetApron();
+
+	// A band is read before the previous one is written, its apron must not reach further up than that band
+	const int32 BandSize = FMath::DivideAndRoundUp(FMath::Max(Apron, 1), TileSize) * TileSize;
+
+	// Tile and band boundaries are multiples of the tile size in landscape coordinates, so they fall on component edges
+	const int32 FirstTileX = FMath::FloorToInt((float)Region.Min.X / TileSize);
+	const int32 NumTilesX = FMath::FloorToInt((float)Region.Max.X / TileSize) - FirstTileX + 1;
+	const int32 FirstBand = FMath::FloorToInt((float)Region.Min.Y / BandSize);
+	const int32 NumBands = FMath::FloorToInt((float)Region.Max.Y / BandSize) - FirstBand + 1;
+
+	const auto GetBandRect = [&](int32 BandIndex)
+	{
+		const int32 Y1 = FMath::Max((FirstBand + BandIndex) * BandSize, Region.Min.Y);
+		const int32 Y2 = FMath::Min((FirstBand + BandIndex + 1) * BandSize - 1, Region.Max.Y);
+		return FIntRect(Region.Min.X, Y1, Region.Max.X, Y2);
+	};
+
+	const auto GetReadRect = [&](const FIntRect& Rect)
+	{
+		return FIntRect(
+			(Rect.Min - FIntPoint(Apron, Apron)).ComponentMax(Extent.Min),
+			(Rect.Max + FIntPoint(Apron, Apron)).ComponentMin(Extent.Max));
+	};
+
+	FBand Input;
+	FBand NextInput;
+	NextInput.Read(ReadHeights, GetReadRect(GetBandRect(0)));
+
+	// Last rows written, rewritten with the next band so their normals see the final heights on both sides
+	const int32 NumOverlapRows = 2;
+	TArray<uint16> Output;
+	TArray<uint16> OverlapRows;
+	int32 NumOverlap = 0;
+
+	double FilterTime = 0.0;
+	for (int32 BandIndex = 0; BandIndex < NumBands; BandIndex++)
+	{
+		Exchange(Input, NextInput);
+		if (BandIndex + 1 < NumBands)
+		{
+			NextInput.Read(ReadHeights, GetReadRect(GetBandRect(BandIndex + 1)));
+		}
+
+		const FIntRect BandRect = GetBandRect(BandIndex);
+		const int32 BandSizeX = BandRect.Max.X - BandRect.Min.X + 1;
+		const int32 BandSizeY = BandRect.Max.Y - BandRect.Min.Y + 1;
+
+		Output.SetNumUninitialized(BandSizeX * (NumOverlap + BandSizeY));
+		if (NumOverlap > 0)
+		{
+			FMemory::Memcpy(Output.GetData(), OverlapRows.GetData(), BandSizeX * NumOverlap * sizeof(uint16));
+		}
+		uint16* BandOutput = Output.GetData() + BandSizeX * NumOverlap;
+
+		const double FilterStartTime = FPlatformTime::Seconds();
+		ParallelFor(NumTilesX, [&](int32 TileIndex)
+		{
+			const int32 TileX1 = FMath::Max((FirstTileX + TileIndex) * TileSize, BandRect.Min.X);
+			const int32 TileX2 = FMath::Min((FirstTileX + TileIndex + 1) * TileSize - 1, BandRect.Max.X);
+			const FIntRect ReadRect = GetReadRect(FIntRect(TileX1, BandRect.Min.Y, TileX2, BandRect.Max.Y));
+
+			FCyLandFilterTile Tile;
+			Tile.Origin = ReadRect.Min;
+			Tile.SizeX = ReadRect.Max.X - ReadRect.Min.X + 1;
+			Tile.SizeY = ReadRect.Max.Y - ReadRect.Min.Y + 1;
+			Tile.Heights.SetNumUninitialized(Tile.SizeX * Tile.SizeY);
+			for (int32 Y = 0; Y < Tile.SizeY; Y++)
+			{
+				const uint16* InputRow = Input.Heights.GetData() + (Tile.Origin.Y + Y - Input.Rect.Min.Y) * Input.GetSizeX() + (Tile.Origin.X - Input.Rect.Min.X);
+				float* RESTRICT Row = Tile.GetRow(Y);
+				for (int32 X = 0; X < Tile.SizeX; X++)
+				{
+					Row[X] = InputRow[X];
+				}
+			}
+
+			// Only tiles with holes carry the bits, the filters are faster without them
+			if (Input.Valid.Num())
+			{
+				bool bHoles = false;
+				Tile.Valid.Init(false, Tile.SizeX * Tile.SizeY);
+				for (int32 Y = 0; Y < Tile.SizeY; Y++)
+				{
+					const int32 InputIndex = (Tile.Origin.Y + Y - Input.Rect.Min.Y) * Input.GetSizeX() + (Tile.Origin.X - Input.Rect.Min.X);
+					for (int32 X = 0; X < Tile.SizeX; X++)
+					{
+						const bool bValid = Input.Valid[InputIndex + X];
+						Tile.Valid[X + Y * Tile.SizeX] = bValid;
+						bHoles |= !bValid;
+					}
+				}
+				if (!bHoles)
+				{
+					Tile.Valid.Empty();
+				}
+			}
+
+			for (const TUniquePtr<FCyLandHeightFilter>& Filter : Filters)
+			{
+				Filter->Apply(Tile);
+			}
+
+			for (int32 Y = BandRect.Min.Y; Y <= BandRect.Max.Y; Y++)
+			{
+				const float* Row = Tile.GetRow(Y - Tile.Origin.Y) + (TileX1 - Tile.Origin.X);
+				uint16* RESTRICT OutputRow = BandOutput + (Y - BandRect.Min.Y) * BandSizeX + (TileX1 - BandRect.Min.X);
+				for (int32 X = 0; X <= TileX2 - TileX1; X++)
+				{
+					OutputRow[X] = (uint16)FMath::Clamp<int32>(FMath::RoundToInt(Row[X]), 0, 65535);
+				}
+
+				if (Tile.Valid.Num())
+				{
+					// Holes keep the heights read
+					const int32 TileRowIndex = (Y - Tile.Origin.Y) * Tile.SizeX + (TileX1 - Tile.Origin.X);
+					const uint16* InputRow = Input.Heights.GetData() + (Y - Input.Rect.Min.Y) * Input.GetSizeX() + (TileX1 - Input.Rect.Min.X);
+					for (int32 X = 0; X <= TileX2 - TileX1; X++)
+					{
+						if (!Tile.Valid[TileRowIndex + X])
+						{
+							OutputRow[X] = InputRow[X];
+						}
+					}
+				}
+			}
+		});
+		FilterTime += FPlatformTime::Seconds() - FilterStartTime;
+
+		WriteHeights(FIntRect(BandRect.Min.X, BandRect.Min.Y - NumOverlap, BandRect.Max.X, BandRect.Max.Y), Output.GetData());
+
+		NumOverlap = FMath::Min(NumOverlapRows, BandSizeY);
+		OverlapRows.SetNumUninitialized(BandSizeX * NumOverlap);
+		FMemory::Memcpy(OverlapRows.GetData(), BandOutput + BandSizeX * (BandSizeY - NumOverlap), BandSizeX * NumOverlap * sizeof(uint16));
+	}
+
+	UE_LOG(LogCyLand, Log, TEXT("Filtered %dx%d vertices of %s with %d filters in %d bands of %d tiles, apron %d: filters %.2f s, total %.2f s"),
+		Region.Width() + 1, Region.Height() + 1, Name, Filters.Num(), NumBands, NumTilesX, Apron, FilterTime, FPlatformTime::Seconds() - StartTime);
+}
+
+bool FCyLandFilterGraph::RunOnHeightmap(TArray<uint16>& Heights, int32 SizeX, int32 SizeY, int32 TileSize, const TBitArray<>* Valid) const
+{
+	if (Filters.Num() == 0 || SizeX <= 0 || SizeY <= 0 || Heights.Num() != SizeX * SizeY || (Valid && Valid->Num() != Heights.Num()))
+	{
+		return false;
+	}
+
+	const FIntRect Extent(0, 0, SizeX - 1, SizeY - 1);
+	RunBands(TEXT("heightmap"), Extent, Extent, FMath::Max(TileSize, 1),
+		[&](const FIntRect& Rect, uint16* OutHeights, TBitArray<>& OutValid)
+		{
+			const int32 RectSizeX = Rect.Max.X - Rect.Min.X + 1;
+			for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+			{
+				FMemory::Memcpy(OutHeights + (Y - Rect.Min.Y) * RectSizeX, Heights.GetData() + Y * SizeX + Rect.Min.X, RectSizeX * sizeof(uint16));
+			}
+
+			if (Valid)
+			{
+				bool bHoles = false;
+				OutValid.Init(false, RectSizeX * (Rect.Max.Y - Rect.Min.Y + 1));
+				for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+				{
+					for (int32 X = Rect.Min.X; X <= Rect.Max.X; X++)
+					{
+						const bool bValid = (*Valid)[X + Y * SizeX];
+						OutValid[(X - Rect.Min.X) + (Y - Rect.Min.Y) * RectSizeX] = bValid;
+						bHoles |= !bValid;
+					}
+				}
+				if (!bHoles)
+				{
+					OutValid.Empty();
+				}
+			}
+		},
+		[&](const FIntRect& Rect, const uint16* InHeights)
+		{
+			const int32 RectSizeX = Rect.Max.X - Rect.Min.X + 1;
+			for (int32 Y = Rect.Min.Y; Y <= Rect.Max.Y; Y++)
+			{
+				FMemory::Memcpy(Heights.GetData() + Y * SizeX + Rect.Min.X, InHeights + (Y - Rect.Min.Y) * RectSizeX, RectSizeX * sizeof(uint16));
+			}
+		});
+
+	return true;
+}
+
+#if WITH_EDITOR
+bool FCyLandFilterGraph::Run(UCyLandInfo* CyLandInfo, FIntRect Region, int32 ComponentsPerTile) const
+{
+	if (!CyLandInfo || Filters.Num() == 0)
+	{
+		return false;
+	}
+
+	FIntRect Extent;
+	if (!CyLandInfo->GetCyLandExtent(Extent.Min.X, Extent.Min.Y, Extent.Max.X, Extent.Max.Y))
+	{
+		return false;
+	}
+
+	if (Region.Area() > 0)
+	{
+		Region.Min = Region.Min.ComponentMax(Extent.Min);
+		Region.Max = Region.Max.ComponentMin(Extent.Max);
+		if (Region.Min.X > Region.Max.X || Region.Min.Y > Region.Max.Y)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		Region = Extent;
+	}
+
+	FCyLandEditDataInterface CyLandEdit(CyLandInfo);
+	RunBands(*CyLandInfo->GetName(), Extent, Region, CyLandInfo->ComponentSizeQuads * FMath::Max(ComponentsPerTile, 1),
+		[&](const FIntRect& Rect, uint16* OutHeights, TBitArray<>& OutValid)
+		{
+			if (CyLandEdit.GetValidVertices(Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y, OutValid))
+			{
+				OutValid.Empty();
+				CyLandEdit.GetHeightDataFast(Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y, OutHeights, 0);
+			}
+			else
+			{
+				// Missing components are filled in from their neighbours rather than left at 0. The filters leave them
+				// out, but the normals computed along them when the band is written back see these heights
+				int32 X1 = Rect.Min.X, Y1 = Rect.Min.Y, X2 = Rect.Max.X, Y2 = Rect.Max.Y;
+				CyLandEdit.GetHeightData(X1, Y1, X2, Y2, OutHeights, Rect.Max.X - Rect.Min.X + 1);
+			}
+		},
+		[&](const FIntRect& Rect, const uint16* InHeights)
+		{
+			CyLandEdit.SetHeightData(Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y, InHeights, 0, true);
+			CyLandEdit.Flush();
+		});
+
+	return true;
+}
+
+namespace CyLandFilterGraph
+{
+	static void FilterCommand(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		// The region and the tile size are taken out before the rest is split in stages
+		FIntRect Region;
+		int32 ComponentsPerTile = 2;
+		TArray<FString> StageArgs;
+		for (const FString& Arg : Args)
+		{
+			if (!FParse::Value(*Arg, TEXT("MinX="), Region.Min.X) &&
+				!FParse::Value(*Arg, TEXT("MinY="), Region.Min.Y) &&
+				!FParse::Value(*Arg, TEXT("MaxX="), Region.Max.X) &&
+				!FParse::Value(*Arg, TEXT("MaxY="), Region.Max.Y) &&
+				!FParse::Value(*Arg, TEXT("ComponentsPerTile="), ComponentsPerTile))
+			{
+				StageArgs.Add(Arg);
+			}
+		}
+
+		FCyLandFilterGraph Graph;
+		FString Error;
+		if (!Graph.AddFromString(FString::Join(StageArgs, TEXT(" ")), Error))
+		{
+			Ar.Logf(TEXT("%s"), *Error);
+			return;
+		}
+
+		if (!World || Graph.Num() == 0)
+		{
+			return;
+		}
+
+		FScopedTransaction Transaction(LOCTEXT("Undo_FilterCyLand", "Filtering CyLand"));
+
+		int32 NumFiltered = 0;
+		for (const TPair<FGuid, UCyLandInfo*>& Pair : UCyLandInfoMap::GetCyLandInfoMap(World).Map)
+		{
+			NumFiltered += Graph.Run(Pair.Value, Region, ComponentsPerTile) ? 1 : 0;
+		}
+
+		Ar.Logf(TEXT("Filtered %d CyLands"), NumFiltered);
+	}
+
+	static FAutoConsoleCommand FilterCmd(
+		TEXT("CyLand.Filter"),
+		TEXT("Run a chain of height filters over every CyLand of the editor world as a batch job, stages are separated by '|'. ")
+		TEXT("Example: CyLand.Filter Smooth Radius=4 | Noise Amount=256 Scale=128 | Thermal Iterations=28. ")
+		TEXT("Stages: Smooth [Radius=] [Strength=], Flatten [Height=] [Strength=] [RaiseOnly|LowerOnly], Noise [Amount=] [Scale=] [WarpScale=] [WarpAmount=], ")
+		TEXT("Ramp StartX= StartY= StartZ= EndX= EndY= EndZ= [Width=] [Falloff=], Thermal [Iterations=] [Threshold=] [Strength=], ")
+		TEXT("Hydraulic [Iterations=] [Strength=] [SedimentCapacity=] [Rain=]. Args: [MinX= MinY= MaxX= MaxY=] [ComponentsPerTile=2]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&FilterCommand));
+}
+#endif // WITH_EDITOR
+
+#undef LOCTEXT_NAMESPACE
@@ -36,6 +36,7 @@
 #include "Materials/Material.h"
 #include "Landscape/Classes/LandscapeGrassType.h"
 #include "Landscape/Classes/Materials/MaterialExpressionLandscapeGrassOutput.h"
+#include "Landscape/Classes/Materials/MaterialExpressionLandscapeLayerSample.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "ContentStreaming.h"
 #include "CyLandDataAccess.h"
@@ -54,6 +55,14 @@
 #include "InstancedStaticMesh.h"
 #include "MeshPassProcessor.h"
 #include "MeshPassProcessor.inl"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Misc/Compression.h"
+#include "CyLandBlobCache.h"
+#include "Async/ParallelFor.h"
+#include "CyLandGrassPlacement.h"
+#include "CyLandGrassScheduler.h"
 
 #define LOCTEXT_NAMESPACE "CyLand"
 
@@ -152,11 +161,61 @@ static TAutoConsoleVariable<int32> CVarIgnoreExcludeBoxes(
 	0,
 	TEXT("For debugging. Ignores any exclusion boxes."));
 
+static TAutoConsoleVariable<int32> CVarGrassCPUWeightEvaluation(
+	TEXT("grass.CPUWeightEvaluation"),
+	1,
+	TEXT("Grass maps of materials whose grass inputs are plain layer samples can be evaluated on the CPU from the heightmap and weightmaps.\n")
+	TEXT("0: Always render grass maps on the GPU (cooked builds then only use the saved grass maps); 1: Use the CPU when the grass map can't be rendered\n")
+	TEXT("(eg null RHI, cooked builds); 2: Always use the CPU when possible"));
+
+static TAutoConsoleVariable<int32> CVarGrassSchedulerChunkCandidates(
+	TEXT("grass.Scheduler.ChunkCandidates"),
+	16384,
+	TEXT("Grass sub-sections with at least this many candidate instances sample them in parallel chunks instead of on a single worker."));
+
+/** Halton blocks generated and sampled together by sub-sections over grass.Scheduler.ChunkCandidates */
+static const int32 BlocksPerChunkedBatch = 32;
+
+static TAutoConsoleVariable<int32> CVarCompressGrassData(
+	TEXT("grass.CompressGrassData"),
+	1,
+	TEXT("1: Keep grass map heights and weights delta + zlib coded in memory, grass builders decode them; 0: Keep them uncompressed"));
+
+static TAutoConsoleVariable<int32> CVarGrassDataMemoryBudgetMB(
+	TEXT("grass.GrassDataMemoryBudgetMB"),
+	512,
+	TEXT("Memory budget of the grass maps of all components in MB, the grass maps of the components farthest from the cameras are dropped\n")
+	TEXT("and generated again when they come back into range. Cooked grass maps are only dropped if they can be evaluated on the CPU (see grass.CPUWeightEvaluation). 0: Unlimited"));
+
+DECLARE_MEMORY_STAT(TEXT("Grass Map Data"), STAT_GrassMapDataMemory, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Grass Maps Evicted"), STAT_GrassMapsEvicted, STATGROUP_Landscape);
+
+DECLARE_MEMORY_STAT(TEXT("Grass Build Cache"), STAT_GrassBuildCacheMemory, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Grass Build Cache Entries"), STAT_GrassBuildCacheEntries, STATGROUP_Landscape);
+
+/**
+ * Serialized output (instance buffer and cluster tree) of FAsyncGrassBuilder::Build keyed by a hash of everything the
+ * build reads, so a grass component coming back into range doesn't have to be rebuilt. Bump the version when the
+ * blob layout of FAsyncGrassBuilder changes.
+ */
+static FCyLandBlobCache GGrassBuildCache(TEXT("grass build cache"), TEXT("grass.BuildCache"), TEXT("CyLandGrassCache"), TEXT(".grass"),
+	0x43474243 /* 'CGBC' */, 2, false,
+	[](int64 TotalBytes, int32 NumEntries)
+	{
+		SET_MEMORY_STAT(STAT_GrassBuildCacheMemory, TotalBytes);
+		SET_DWORD_STAT(STAT_GrassBuildCacheEntries, NumEntries);
+	});
+
 DECLARE_CYCLE_STAT(TEXT("Grass Async Build Time"), STAT_FoliageGrassAsyncBuildTime, STATGROUP_Foliage);
+DECLARE_CYCLE_STAT(TEXT("Grass Build Cache Load"), STAT_FoliageGrassBuildCacheLoad, STATGROUP_Foliage);
 DECLARE_CYCLE_STAT(TEXT("Grass Start Comp"), STAT_FoliageGrassStartComp, STATGROUP_Foliage);
 DECLARE_CYCLE_STAT(TEXT("Grass End Comp"), STAT_FoliageGrassEndComp, STATGROUP_Foliage);
 DECLARE_CYCLE_STAT(TEXT("Grass Destroy Comps"), STAT_FoliageGrassDestoryComp, STATGROUP_Foliage);
 DECLARE_CYCLE_STAT(TEXT("Grass Update"), STAT_GrassUpdate, STATGROUP_Foliage);
+DECLARE_CYCLE_STAT(TEXT("Grass Weights CPU"), STAT_GrassEvaluateWeightsCPU, STATGROUP_Foliage);
+DECLARE_CYCLE_STAT(TEXT("Grass Data Compress"), STAT_GrassDataCompress, STATGROUP_Foliage);
+DECLARE_CYCLE_STAT(TEXT("Grass Data Decompress"), STAT_GrassDataDecompress, STATGROUP_Foliage);
+DECLARE_CYCLE_STAT(TEXT("Grass Data Budget"), STAT_GrassDataBudget, STATGROUP_Foliage);
 
 static int32 GGrassUpdateInterval = 1;
 
@@ -199,6 +258,9 @@ static FAutoConsoleVariableSink CVarGrassSink(FConsoleCommandDelegate::CreateSta
 //
 
 #if WITH_EDITOR
+
+extern const size_t ChannelOffsets[4];
+
 static bool ShouldCacheCyLandGrassShaders(EShaderPlatform Platform, const FMaterial* Material, const FVertexFactoryType* VertexFactoryType)
 {
 	// We only need grass weight shaders for CyLand vertex factories on desktop platforms
@@ -758,6 +820,7 @@ public:
 			UCyLandComponent* Component = GrassDataPair.Key;
 			FCyLandComponentGrassData* ComponentGrassData = GrassDataPair.Value.Release();
 			ACyLandProxy* Proxy = Component->GetCyLandProxy();
+			ComponentGrassData->ConditionalCompress();
 
 			// Assign the new data (thread-safe)
 			Component->GrassData = MakeShareable(ComponentGrassData);
@@ -799,6 +862,429 @@ public:
 	}
 };
 
+/**
+ * Get the grass types of a landscape material and the paint layer each of them reads. Only succeeds when every
+ * connected grass input is a plain layer sample and the material has no world position offset, in which case the
+ * grass map doesn't depend on the material at all and can be evaluated by FCyLandGrassWeightEvaluatorCPU.
+ * Unconnected inputs get NAME_None.
+ */
+static bool GetCPUGrassLayerNames(UMaterialInterface* Material, TArray<ULandscapeGrassType*>& OutGrassTypes, TArray<FName>& OutLayerNames)
+{
+	UMaterial* BaseMaterial = Material ? Material->GetMaterial() : nullptr;
+	if (BaseMaterial == nullptr || BaseMaterial->WorldPositionOffset.IsConnected())
+	{
+		return false;
+	}
+
+	TArray<const UMaterialExpressionLandscapeGrassOutput*> GrassExpressions;
+	BaseMaterial->GetAllExpressionsOfType<UMaterialExpressionLandscapeGrassOutput>(GrassExpressions);
+	if (GrassExpressions.Num() == 0 || GrassExpressions[0]->GrassTypes.Num() == 0)
+	{
+		return false;
+	}
+
+	OutGrassTypes.Reset(GrassExpressions[0]->GrassTypes.Num());
+	OutLayerNames.Reset(GrassExpressions[0]->GrassTypes.Num());
+	for (const FGrassInput& GrassInput : GrassExpressions[0]->GrassTypes)
+	{
+		FName LayerName = NAME_None;
+		if (GrassInput.Input.IsConnected())
+		{
+			const UMaterialExpressionLandscapeLayerSample* LayerSample = Cast<UMaterialExpressionLandscapeLayerSample>(GrassInput.Input.Expression);
+			if (LayerSample == nullptr)
+			{
+				return false;
+			}
+			LayerName = LayerSample->ParameterName;
+		}
+		OutGrassTypes.Add(GrassInput.GrassType);
+		OutLayerNames.Add(LayerName);
+	}
+
+	return true;
+}
+
+/** Result of GetCPUGrassLayerNames for a base material, valid as long as the material StateId doesn't change */
+struct FCPUGrassLayersCacheEntry
+{
+	FGuid StateId;
+	TArray<ULandscapeGrassType*> GrassTypes;
+	TArray<FName> LayerNames;
+};
+
+/** GetCPUGrassLayerNames per base material, so UpdateGrass doesn't walk the material graph of every component every tick */
+static TMap<TWeakObjectPtr<UMaterial>, FCPUGrassLayersCacheEntry> GCPUGrassLayersCache;
+
+/** Cached GetCPUGrassLayerNames, GrassTypes is empty if the grass map of the material has to be rendered */
+static const FCPUGrassLayersCacheEntry& FindCPUGrassLayers(UMaterialInterface* Material)
+{
+	static const FCPUGrassLayersCacheEntry NoLayers;
+
+	UMaterial* BaseMaterial = Material ? Material->GetMaterial() : nullptr;
+	if (BaseMaterial == nullptr)
+	{
+		return NoLayers;
+	}
+
+	FCPUGrassLayersCacheEntry& Entry = GCPUGrassLayersCache.FindOrAdd(BaseMaterial);
+	if (Entry.StateId != BaseMaterial->StateId || !Entry.StateId.IsValid())
+	{
+		Entry.StateId = BaseMaterial->StateId;
+		if (!GetCPUGrassLayerNames(BaseMaterial, Entry.GrassTypes, Entry.LayerNames))
+		{
+			Entry.GrassTypes.Reset();
+			Entry.LayerNames.Reset();
+		}
+	}
+	return Entry;
+}
+
+void UCyLandComponent::UpdateCPUGrassLayers()
+{
+	const FCPUGrassLayersCacheEntry& Layers = FindCPUGrassLayers(GetCyLandMaterial());
+	CPUGrassTypes = Layers.GrassTypes;
+	CPUGrassLayerNames = Layers.LayerNames;
+}
+
+#endif //WITH_EDITOR
+
+/** Grass types of a component and the paint layer each of them reads for FCyLandGrassWeightEvaluatorCPU, false if its grass map has to be rendered */
+static bool GetCPUGrassLayers(const UCyLandComponent* Component, const TArray<ULandscapeGrassType*>*& OutGrassTypes, const TArray<FName>*& OutLayerNames)
+{
+#if WITH_EDITOR
+	// the material can change under us, use its current graph instead of what was saved with the component
+	const FCPUGrassLayersCacheEntry& Layers = FindCPUGrassLayers(Component->GetCyLandMaterial());
+	OutGrassTypes = &Layers.GrassTypes;
+	OutLayerNames = &Layers.LayerNames;
+#else
+	OutGrassTypes = &Component->CPUGrassTypes;
+	OutLayerNames = &Component->CPUGrassLayerNames;
+#endif
+	return OutGrassTypes->Num() > 0 && OutGrassTypes->Num() == OutLayerNames->Num();
+}
+
+/**
+ * Can mip 0 of a heightmap or weightmap be read on the CPU: from the source data with editor data, otherwise from the
+ * platform data of uncompressed textures. Dedicated server cooks strip the texture data, their grass maps can only
+ * come from the ones saved in the map.
+ */
+static bool HasCPUMipData(UTexture2D* Texture)
+{
+	if (Texture == nullptr)
+	{
+		return false;
+	}
+
+#if WITH_EDITORONLY_DATA
+	if (Texture->Source.IsValid())
+	{
+		return Texture->Source.GetFormat() == TSF_BGRA8;
+	}
+#endif
+
+	const FTexturePlatformData* PlatformData = Texture->PlatformData;
+	return PlatformData && PlatformData->Mips.Num() > 0 && PlatformData->PixelFormat == PF_B8G8R8A8;
+}
+
+/**
+ * CPU counterpart of FCyLandGrassWeightExporter for components accepted by GetCPUGrassLayers: heights are read from
+ * mip 0 of the heightmap and grass weights from the weightmap channels of the matching paint layers, which is what the
+ * exporter would read back from its render target. No rendering is involved so this also works with the null RHI and
+ * in cooked builds, as long as the texture data is available (see HasCPUMipData).
+ *
+ * Mips are copied on the game thread, the per-component work then runs with ParallelFor.
+ * Collision baking isn't supported (it is only useful with world position offset anyway).
+ */
+class FCyLandGrassWeightEvaluatorCPU
+{
+	/** One channel of a weightmap mip, starting at the first texel of the component */
+	struct FLayerSource
+	{
+		const uint8* Data;
+		int32 Stride;
+	};
+
+	struct FComponentJob
+	{
+		UCyLandComponent* Component;
+		const FColor* Heightmap;
+		int32 HeightmapStride;
+
+		/** Grass types of the component material, and the paint layer each one reads (Data is null if the layer isn't painted) */
+		TArray<ULandscapeGrassType*> GrassTypes;
+		TArray<FLayerSource> Layers;
+
+		TUniquePtr<FCyLandComponentGrassData> GrassData;
+	};
+
+	/** Copy of mip 0 of a texture, empty if it couldn't be read */
+	struct FMip
+	{
+		TArray<uint8> Data;
+		int32 SizeX;
+		int32 SizeY;
+	};
+
+	int32 ComponentSizeVerts;
+
+	/** Texels of the component textures covered by a component, subsections duplicate their edge texels */
+	int32 ComponentSizeTexels;
+
+	/** Texel offset in the component textures of each vertex row/column */
+	TArray<int32> VertexToTexel;
+
+	TMap<UTexture2D*, FMip> Mips;
+	TArray<FComponentJob> Jobs;
+
+public:
+	FCyLandGrassWeightEvaluatorCPU(ACyLandProxy* CyLandProxy, const TArray<UCyLandComponent*>& InCyLandComponents)
+		: ComponentSizeVerts(CyLandProxy->ComponentSizeQuads + 1)
+		, ComponentSizeTexels((CyLandProxy->SubsectionSizeQuads + 1) * CyLandProxy->NumSubsections)
+	{
+		check(IsInGameThread());
+
+		static const int32 ChannelOffsets[4] = { (int32)STRUCT_OFFSET(FColor, R), (int32)STRUCT_OFFSET(FColor, G), (int32)STRUCT_OFFSET(FColor, B), (int32)STRUCT_OFFSET(FColor, A) };
+
+		const int32 SubsectionSizeQuads = CyLandProxy->SubsectionSizeQuads;
+		const int32 NumSubsections = CyLandProxy->NumSubsections;
+		VertexToTexel.SetNumUninitialized(ComponentSizeVerts);
+		for (int32 Vertex = 0; Vertex < ComponentSizeVerts; Vertex++)
+		{
+			const int32 SubIndex = FMath::Min(Vertex / SubsectionSizeQuads, NumSubsections - 1);
+			VertexToTexel[Vertex] = Vertex + SubIndex;
+		}
+
+		Jobs.Reserve(InCyLandComponents.Num());
+		for (UCyLandComponent* Component : InCyLandComponents)
+		{
+			const TArray<ULandscapeGrassType*>* GrassTypes;
+			const TArray<FName>* LayerNames;
+			// The texels of an evicted atlas page belong to another component
+			if (!Component->IsHeightmapResident() || !GetCPUGrassLayers(Component, GrassTypes, LayerNames))
+			{
+				continue;
+			}
+
+			int32 HeightmapStride;
+			const uint8* Heightmap = GetComponentTexels(Component->GetHeightmap(), Component->HeightmapScaleBias, HeightmapStride);
+			if (Heightmap == nullptr)
+			{
+				continue;
+			}
+
+			FComponentJob Job;
+			Job.Component = Component;
+			Job.Heightmap = (const FColor*)Heightmap;
+			Job.HeightmapStride = HeightmapStride / sizeof(FColor);
+			Job.GrassTypes = *GrassTypes;
+
+			bool bValid = true;
+			Job.Layers.AddZeroed(LayerNames->Num());
+			for (const FCyWeightmapLayerAllocationInfo& Allocation : Component->WeightmapLayerAllocations)
+			{
+				if (Allocation.LayerInfo == nullptr || !Component->WeightmapTextures.IsValidIndex(Allocation.WeightmapTextureIndex))
+				{
+					continue;
+				}
+
+				const int32 Index = LayerNames->Find(Allocation.GetLayerName());
+				if (Index == INDEX_NONE)
+				{
+					continue;
+				}
+
+				FLayerSource LayerSource;
+				LayerSource.Data = GetComponentTexels(Component->WeightmapTextures[Allocation.WeightmapTextureIndex], Component->WeightmapScaleBias, LayerSource.Stride);
+				if (LayerSource.Data == nullptr)
+				{
+					bValid = false;
+					break;
+				}
+				LayerSource.Data += ChannelOffsets[Allocation.WeightmapTextureChannel];
+
+				for (int32 LayerIndex = Index; LayerIndex < LayerNames->Num(); LayerIndex++)
+				{
+					if ((*LayerNames)[LayerIndex] == Allocation.GetLayerName())
+					{
+						Job.Layers[LayerIndex] = LayerSource;
+					}
+				}
+			}
+
+			if (bValid)
+			{
+#if WITH_EDITOR
+				Job.GrassData = MakeUnique<FCyLandComponentGrassData>(Component);
+#else
+				Job.GrassData = MakeUnique<FCyLandComponentGrassData>();
+#endif
+				Jobs.Add(MoveTemp(Job));
+			}
+		}
+	}
+
+	/** Whether any of the components could be evaluated, the others keep their grass data */
+	bool HasJobs() const
+	{
+		return Jobs.Num() > 0;
+	}
+
+	TMap<UCyLandComponent*, TUniquePtr<FCyLandComponentGrassData>, TInlineSetAllocator<1>> FetchResults()
+	{
+		{
+			SCOPE_CYCLE_COUNTER(STAT_GrassEvaluateWeightsCPU);
+			ParallelFor(Jobs.Num(), [this](int32 JobIndex)
+			{
+				EvaluateComponent(Jobs[JobIndex]);
+			});
+		}
+
+		TMap<UCyLandComponent*, TUniquePtr<FCyLandComponentGrassData>, TInlineSetAllocator<1>> Results;
+		Results.Reserve(Jobs.Num());
+		for (FComponentJob& Job : Jobs)
+		{
+			Results.Add(Job.Component, MoveTemp(Job.GrassData));
+		}
+		return Results;
+	}
+
+	void ApplyResults()
+	{
+		TMap<UCyLandComponent*, TUniquePtr<FCyLandComponentGrassData>, TInlineSetAllocator<1>> NewGrassData = FetchResults();
+
+		for (auto&& GrassDataPair : NewGrassData)
+		{
+			GrassDataPair.Value->ConditionalCompress();
+
+			// Assign the new data (thread-safe)
+			GrassDataPair.Key->GrassData = MakeShareable(GrassDataPair.Value.Release());
+		}
+	}
+
+private:
+	/** Copy of mip 0 of a texture shared by all components using the texture, null if the texture data can't be read */
+	const FMip* GetMip(UTexture2D* Texture)
+	{
+		FMip* Mip = Mips.Find(Texture);
+		if (Mip != nullptr)
+		{
+			return Mip->Data.Num() > 0 ? Mip : nullptr;
+		}
+
+		Mip = &Mips.Add(Texture);
+		Mip->SizeX = 0;
+		Mip->SizeY = 0;
+		if (!HasCPUMipData(Texture))
+		{
+			return nullptr;
+		}
+
+#if WITH_EDITORONLY_DATA
+		if (Texture->Source.IsValid())
+		{
+			Mip->SizeX = Texture->Source.GetSizeX();
+			Mip->SizeY = Texture->Source.GetSizeY();
+			Texture->Source.GetMipData(Mip->Data, 0);
+			return Mip->Data.Num() == Mip->SizeX * Mip->SizeY * (int32)sizeof(FColor) ? Mip : nullptr;
+		}
+#endif
+
+		// Streamed mips are loaded from their bulk data file, inline ones are only there until the RHI resource is created
+		FTexturePlatformData* PlatformData = Texture->PlatformData;
+		TArray<void*, TInlineAllocator<MAX_TEXTURE_MIP_COUNT>> MipData;
+		MipData.AddZeroed(PlatformData->Mips.Num());
+		if (PlatformData->TryLoadMips(0, MipData.GetData()) && MipData[0] != nullptr)
+		{
+			const FTexture2DMipMap& Mip0 = PlatformData->Mips[0];
+			Mip->SizeX = Mip0.SizeX;
+			Mip->SizeY = Mip0.SizeY;
+			Mip->Data.SetNumUninitialized(Mip0.SizeX * Mip0.SizeY * sizeof(FColor));
+			FMemory::Memcpy(Mip->Data.GetData(), MipData[0], Mip->Data.Num());
+		}
+		for (void* Data : MipData)
+		{
+			FMemory::Free(Data);
+		}
+
+		return Mip->Data.Num() > 0 ? Mip : nullptr;
+	}
+
+	/** First texel of a component in mip 0 of one of its textures, null if the texture data can't be read or doesn't cover the component */
+	const uint8* GetComponentTexels(UTexture2D* Texture, const FVector4& ScaleBias, int32& OutStride)
+	{
+		const FMip* Mip = GetMip(Texture);
+		if (Mip == nullptr)
+		{
+			return nullptr;
+		}
+
+		// The scale is one texel of the full size texture, which mip 0 no longer is when the cook dropped mips.
+		// Weightmaps are biased by half a texel for sampling, so the offset is rounded down.
+		const int32 OffsetX = FMath::FloorToInt(ScaleBias.Z * (float)Mip->SizeX);
+		const int32 OffsetY = FMath::FloorToInt(ScaleBias.W * (float)Mip->SizeY);
+		if (FMath::RoundToInt(ScaleBias.X * (float)Mip->SizeX) != 1 || FMath::RoundToInt(ScaleBias.Y * (float)Mip->SizeY) != 1
+			|| OffsetX < 0 || OffsetY < 0 || OffsetX + ComponentSizeTexels > Mip->SizeX || OffsetY + ComponentSizeTexels > Mip->SizeY)
+		{
+			return nullptr;
+		}
+
+		OutStride = Mip->SizeX * sizeof(FColor);
+		return Mip->Data.GetData() + (OffsetX + OffsetY * Mip->SizeX) * sizeof(FColor);
+	}
+
+	/** Fill the grass data of a component, only reads the copied mips so may run on any thread */
+	void EvaluateComponent(FComponentJob& Job) const
+	{
+		FCyLandComponentGrassData& GrassData = *Job.GrassData;
+		const int32 NumVerts = FMath::Square(ComponentSizeVerts);
+
+		GrassData.HeightData.SetNumUninitialized(NumVerts);
+		uint16* HeightDest = GrassData.HeightData.GetData();
+		for (int32 y = 0; y < ComponentSizeVerts; y++)
+		{
+			const FColor* HeightRow = Job.Heightmap + VertexToTexel[y] * Job.HeightmapStride;
+			for (int32 x = 0; x < ComponentSizeVerts; x++)
+			{
+				const FColor& Texel = HeightRow[VertexToTexel[x]];
+				*HeightDest++ = (((uint16)Texel.R) << 8) + (uint16)(Texel.G);
+			}
+		}
+
+		for (int32 Index = 0; Index < Job.GrassTypes.Num(); Index++)
+		{
+			// null grass types and layers that aren't painted on this component would be entirely weight 0
+			ULandscapeGrassType* GrassType = Job.GrassTypes[Index];
+			const FLayerSource& Layer = Job.Layers[Index];
+			if (GrassType == nullptr || Layer.Data == nullptr || GrassData.WeightData.Contains(GrassType))
+			{
+				continue;
+			}
+
+			TArray<uint8> Weights;
+			Weights.SetNumUninitialized(NumVerts);
+			uint8* WeightDest = Weights.GetData();
+			uint8 AnyWeight = 0;
+			for (int32 y = 0; y < ComponentSizeVerts; y++)
+			{
+				const uint8* WeightRow = Layer.Data + VertexToTexel[y] * Layer.Stride;
+				for (int32 x = 0; x < ComponentSizeVerts; x++)
+				{
+					const uint8 Weight = WeightRow[VertexToTexel[x] * sizeof(FColor)];
+					*WeightDest++ = Weight;
+					AnyWeight |= Weight;
+				}
+			}
+
+			if (AnyWeight != 0)
+			{
+				GrassData.WeightData.Add(GrassType, MoveTemp(Weights));
+			}
+		}
+	}
+};
+
+#if WITH_EDITOR
+
 FCyLandComponentGrassData::FCyLandComponentGrassData(UCyLandComponent* Component)
 	: RotationForWPO(Component->GetCyLandMaterial()->GetMaterial()->WorldPositionOffset.IsConnected() ? Component->GetComponentTransform().GetRotation() : FQuat(0, 0, 0, 0))
 {
@@ -864,7 +1350,7 @@ bool UCyLandComponent::CanRenderGrassMap() const
 {
 	// Check we can render
 	UWorld* ComponentWorld = GetWorld();//!GIsEditor ||   || ComponentWorld->IsGameWorld() 
-	if (GUsingNullRHI || !ComponentWorld|| ComponentWorld->FeatureLevel < ERHIFeatureLevel::SM4 || !SceneProxy)
+	if (GUsingNullRHI || !ComponentWorld|| ComponentWorld->FeatureLevel < ERHIFeatureLevel::SM4 || !SceneProxy || !IsHeightmapResident())
 	{
 		return false;
 	}
@@ -911,50 +1397,6 @@ bool UCyLandComponent::AreTexturesStreamedForGrassMapRender() const
 	return true;
 }
 
-void UCyLandComponent::RenderGrassMap()
-{
-	UMaterialInterface* Material = GetCyLandMaterial();
-	if (CanRenderGrassMap())
-	{
-		TArray<ULandscapeGrassType*> GrassTypes;
-
-		TArray<const UMaterialExpressionLandscapeGrassOutput*> GrassExpressions;
-		Material->GetMaterial()->GetAllExpressionsOfType<UMaterialExpressionLandscapeGrassOutput>(GrassExpressions);
-		if (GrassExpressions.Num() > 0)
-		{
-			GrassTypes.Empty(GrassExpressions[0]->GrassTypes.Num());
-			for (auto& GrassTypeInput : GrassExpressions[0]->GrassTypes)
-			{
-				GrassTypes.Add(GrassTypeInput.GrassType);
-			}
-		}
-
-		const bool bBakeMaterialPositionOffsetIntoCollision = (GetCyLandProxy() && GetCyLandProxy()->bBakeMaterialPositionOffsetIntoCollision);
-
-		TArray<int32> HeightMips;
-		if (bBakeMaterialPositionOffsetIntoCollision)
-		{
-			if (CollisionMipLevel > 0)
-			{
-				HeightMips.Add(CollisionMipLevel);
-			}
-			if (SimpleCollisionMipLevel > CollisionMipLevel)
-			{
-				HeightMips.Add(SimpleCollisionMipLevel);
-			}
-		}
-
-		if (GrassTypes.Num() > 0 || bBakeMaterialPositionOffsetIntoCollision)
-		{
-			TArray<UCyLandComponent*> CyLandComponents;
-			CyLandComponents.Add(this);
-
-			FCyLandGrassWeightExporter Exporter(GetCyLandProxy(), MoveTemp(CyLandComponents), MoveTemp(GrassTypes), true, MoveTemp(HeightMips));
-			Exporter.ApplyResults();
-		}
-	}
-}
-
 TArray<uint16> UCyLandComponent::RenderWPOHeightmap(int32 LOD)
 {
 	TArray<uint16> Results;
@@ -995,6 +1437,31 @@ void UCyLandComponent::RemoveGrassMap()
 
 void ACyLandProxy::RenderGrassMaps(const TArray<UCyLandComponent*>& InCyLandComponents, const TArray<ULandscapeGrassType*>& GrassTypes)
 {
+	TArray<UCyLandComponent*> ComponentsToRender;
+	TArray<UCyLandComponent*> ComponentsToEvaluate;
+	for (UCyLandComponent* Component : InCyLandComponents)
+	{
+		if (Component->ShouldEvaluateGrassMapOnCPU())
+		{
+			ComponentsToEvaluate.Add(Component);
+		}
+		else
+		{
+			ComponentsToRender.Add(Component);
+		}
+	}
+
+	if (ComponentsToEvaluate.Num() > 0)
+	{
+		FCyLandGrassWeightEvaluatorCPU Evaluator(this, ComponentsToEvaluate);
+		Evaluator.ApplyResults();
+	}
+
+	if (ComponentsToRender.Num() == 0)
+	{
+		return;
+	}
+
 	TArray<int32> HeightMips;
 	if (CollisionMipLevel > 0)
 	{
@@ -1005,12 +1472,96 @@ void ACyLandProxy::RenderGrassMaps(const TArray<UCyLandComponent*>& InCyLandComp
 		HeightMips.Add(SimpleCollisionMipLevel);
 	}
 
-	FCyLandGrassWeightExporter Exporter(this, InCyLandComponents, GrassTypes, true, MoveTemp(HeightMips));
+	FCyLandGrassWeightExporter Exporter(this, ComponentsToRender, GrassTypes, true, MoveTemp(HeightMips));
 	Exporter.ApplyResults();
 }
 
 #endif //WITH_EDITOR
 
+bool UCyLandComponent::ShouldEvaluateGrassMapOnCPU() const
+{
+	const int32 Mode = CVarGrassCPUWeightEvaluation.GetValueOnGameThread();
+#if WITH_EDITOR
+	if (Mode <= 0 || (Mode == 1 && CanRenderGrassMap()))
+#else
+	// cooked builds can't render grass maps, the CPU is the only way to generate them
+	if (Mode <= 0)
+#endif
+	{
+		return false;
+	}
+
+	ACyLandProxy* Proxy = GetCyLandProxy();
+	if (Proxy == nullptr || Proxy->bBakeMaterialPositionOffsetIntoCollision || !IsHeightmapResident() || !HasCPUMipData(GetHeightmap()))
+	{
+		return false;
+	}
+
+	const TArray<ULandscapeGrassType*>* GrassTypes;
+	const TArray<FName>* LayerNames;
+	return GetCPUGrassLayers(this, GrassTypes, LayerNames);
+}
+
+void UCyLandComponent::RenderGrassMap()
+{
+	if (ShouldEvaluateGrassMapOnCPU())
+	{
+		TArray<UCyLandComponent*> CyLandComponents;
+		CyLandComponents.Add(this);
+
+		FCyLandGrassWeightEvaluatorCPU Evaluator(GetCyLandProxy(), CyLandComponents);
+		if (Evaluator.HasJobs())
+		{
+			Evaluator.ApplyResults();
+			return;
+		}
+	}
+
+#if WITH_EDITOR
+	UMaterialInterface* Material = GetCyLandMaterial();
+	if (CanRenderGrassMap())
+	{
+		TArray<ULandscapeGrassType*> GrassTypes;
+
+		TArray<const UMaterialExpressionLandscapeGrassOutput*> GrassExpressions;
+		Material->GetMaterial()->GetAllExpressionsOfType<UMaterialExpressionLandscapeGrassOutput>(GrassExpressions);
+		if (GrassExpressions.Num() > 0)
+		{
+			GrassTypes.Empty(GrassExpressions[0]->GrassTypes.Num());
+			for (auto& GrassTypeInput : GrassExpressions[0]->GrassTypes)
+			{
+				GrassTypes.Add(GrassTypeInput.GrassType);
+			}
+		}
+
+		const bool bBakeMaterialPositionOffsetIntoCollision = (GetCyLandProxy() && GetCyLandProxy()->bBakeMaterialPositionOffsetIntoCollision);
+
+		TArray<int32> HeightMips;
+		if (bBakeMaterialPositionOffsetIntoCollision)
+		{
+			if (CollisionMipLevel > 0)
+			{
+				HeightMips.Add(CollisionMipLevel);
+			}
+			if (SimpleCollisionMipLevel > CollisionMipLevel)
+			{
+				HeightMips.Add(SimpleCollisionMipLevel);
+			}
+		}
+
+		if (GrassTypes.Num() > 0 || bBakeMaterialPositionOffsetIntoCollision)
+		{
+			TArray<UCyLandComponent*> CyLandComponents;
+			CyLandComponents.Add(this);
+
+			FCyLandGrassWeightExporter Exporter(GetCyLandProxy(), MoveTemp(CyLandComponents), MoveTemp(GrassTypes), true, MoveTemp(HeightMips));
+			Exporter.ApplyResults();
+		}
+	}
+#endif
+}
+
+
 // the purpose of this class is to copy the lightmap from the terrain, and set the CoordinateScale and CoordinateBias to zero.
 // we re-use the same texture references, so the memory cost is relatively minimal.
 class FCyLandGrassLightMap : public FLightMap2D
@@ -1042,6 +1593,10 @@ public:
 //
 // FCyLandComponentGrassData
 //
+
+/** Guards SharedHeightData of all grass data, decoding happens outside of it */
+static FCriticalSection GGrassSharedHeightDataLock;
+
 SIZE_T FCyLandComponentGrassData::GetAllocatedSize() const
 {
 	SIZE_T WeightSize = 0; 
@@ -1049,13 +1604,216 @@ SIZE_T FCyLandComponentGrassData::GetAllocatedSize() const
 	{
 		WeightSize += It.Value().GetAllocatedSize();
 	}
+	for (auto It = CompressedWeightData.CreateConstIterator(); It; ++It)
+	{
+		WeightSize += It.Value().GetAllocatedSize();
+	}
+	SIZE_T HeightMipSize = 0;
+	{
+		FScopeLock Lock(&GGrassSharedHeightDataLock);
+		HeightMipSize += SharedHeightData.IsValid() ? SharedHeightData->GetAllocatedSize() : 0;
+	}
+#if WITH_EDITORONLY_DATA
+	HeightMipSize += HeightMipData.GetAllocatedSize();
+	for (auto It = HeightMipData.CreateConstIterator(); It; ++It)
+	{
+		HeightMipSize += It.Value().GetAllocatedSize();
+	}
+#endif
 	return sizeof(*this)
-		+ HeightData.GetAllocatedSize()
-		+ WeightData.GetAllocatedSize() + WeightSize;
+		+ HeightData.GetAllocatedSize() + CompressedHeightData.GetAllocatedSize() + HeightMipSize
+		+ WeightData.GetAllocatedSize() + CompressedWeightData.GetAllocatedSize() + WeightSize;
+}
+
+/**
+ * Grass maps are smooth, so each sample is predicted from its left neighbor (or the one above at the start of a row)
+ * and the zigzag coded residuals, split in byte planes, are left to zlib.
+ */
+template<typename T, typename SignedT>
+static void EncodeGrassChannel(const TArray<T>& Samples, TArray<uint8>& OutCompressed)
+{
+	const int32 Num = Samples.Num();
+	int32 Stride = FMath::RoundToInt(FMath::Sqrt((float)Num));
+	if (Stride * Stride != Num)
+	{
+		Stride = FMath::Max(Num, 1);
+	}
+
+	TArray<uint8> Residuals;
+	Residuals.SetNumUninitialized(Num * sizeof(T));
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		const T Predicted = Index == 0 ? 0 : (Index % Stride ? Samples[Index - 1] : Samples[Index - Stride]);
+		const SignedT Delta = (SignedT)(T)(Samples[Index] - Predicted);
+		const T Code = (T)(((T)Delta << 1) ^ (T)(Delta >> (sizeof(T) * 8 - 1)));
+		for (int32 Byte = 0; Byte < sizeof(T); Byte++)
+		{
+			Residuals[Byte * Num + Index] = (uint8)(Code >> (Byte * 8));
+		}
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Residuals.Num());
+	OutCompressed.SetNumUninitialized(CompressedSize);
+	verify(FCompression::CompressMemory(NAME_Zlib, OutCompressed.GetData(), CompressedSize, Residuals.GetData(), Residuals.Num()));
+	OutCompressed.SetNum(CompressedSize, true);
+}
+
+template<typename T, typename SignedT>
+static bool DecodeGrassChannel(const TArray<uint8>& Compressed, int32 Num, TArray<T>& OutSamples)
+{
+	TArray<uint8> Residuals;
+	Residuals.SetNumUninitialized(Num * sizeof(T));
+	if (Compressed.Num() == 0 || !FCompression::UncompressMemory(NAME_Zlib, Residuals.GetData(), Residuals.Num(), Compressed.GetData(), Compressed.Num()))
+	{
+		OutSamples.Reset();
+		return false;
+	}
+
+	int32 Stride = FMath::RoundToInt(FMath::Sqrt((float)Num));
+	if (Stride * Stride != Num)
+	{
+		Stride = FMath::Max(Num, 1);
+	}
+
+	OutSamples.SetNumUninitialized(Num);
+	for (int32 Index = 0; Index < Num; Index++)
+	{
+		T Code = 0;
+		for (int32 Byte = 0; Byte < sizeof(T); Byte++)
+		{
+			Code |= (T)Residuals[Byte * Num + Index] << (Byte * 8);
+		}
+		const T Delta = (T)((Code >> 1) ^ (T)(0 - (Code & 1)));
+		const T Predicted = Index == 0 ? 0 : (Index % Stride ? OutSamples[Index - 1] : OutSamples[Index - Stride]);
+		OutSamples[Index] = (T)(Predicted + Delta);
+	}
+	return true;
+}
+
+void FCyLandComponentGrassData::ConditionalCompress()
+{
+	if (IsCompressed() || HeightData.Num() == 0 || CVarCompressGrassData.GetValueOnAnyThread() == 0)
+	{
+		return;
+	}
+
+	for (auto It = WeightData.CreateConstIterator(); It; ++It)
+	{
+		if (It.Value().Num() != HeightData.Num())
+		{
+			// not the layout the builders expect, leave it alone
+			return;
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_GrassDataCompress);
+
+	NumCompressedSamples = HeightData.Num();
+	EncodeGrassChannel<uint16, int16>(HeightData, CompressedHeightData);
+	for (auto It = WeightData.CreateConstIterator(); It; ++It)
+	{
+		EncodeGrassChannel<uint8, int8>(It.Value(), CompressedWeightData.Add(It.Key()));
+	}
+
+	HeightData.Empty();
+	WeightData.Empty();
+}
+
+void FCyLandComponentGrassData::Decompress()
+{
+	if (!IsCompressed())
+	{
+		return;
+	}
+
+	DecompressHeightData(HeightData);
+	for (auto It = CompressedWeightData.CreateConstIterator(); It; ++It)
+	{
+		TArray<uint8>& Weights = WeightData.Add(It.Key());
+		if (!DecodeGrassChannel<uint8, int8>(It.Value(), NumCompressedSamples, Weights))
+		{
+			WeightData.Remove(It.Key());
+		}
+	}
+
+	CompressedHeightData.Empty();
+	CompressedWeightData.Empty();
+	NumCompressedSamples = 0;
+
+	FScopeLock Lock(&GGrassSharedHeightDataLock);
+	SharedHeightData.Reset();
+}
+
+bool FCyLandComponentGrassData::DecompressHeightData(TArray<uint16>& OutHeightData) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GrassDataDecompress);
+	return DecodeGrassChannel<uint16, int16>(CompressedHeightData, NumCompressedSamples, OutHeightData);
+}
+
+TSharedPtr<const TArray<uint16>, ESPMode::ThreadSafe> FCyLandComponentGrassData::GetSharedHeightData()
+{
+	{
+		FScopeLock Lock(&GGrassSharedHeightDataLock);
+		SharedHeightDataLastUseTime = FPlatformTime::Seconds();
+		if (SharedHeightData.IsValid())
+		{
+			return SharedHeightData;
+		}
+	}
+
+	// builders of the component racing here both decode, the first one to finish is shared
+	TSharedPtr<TArray<uint16>, ESPMode::ThreadSafe> Decoded = MakeShareable(new TArray<uint16>());
+	if (!DecompressHeightData(*Decoded))
+	{
+		return nullptr;
+	}
+
+	FScopeLock Lock(&GGrassSharedHeightDataLock);
+	if (!SharedHeightData.IsValid())
+	{
+		SharedHeightData = Decoded;
+	}
+	return SharedHeightData;
+}
+
+void FCyLandComponentGrassData::ReleaseSharedHeightData(double MinLastUseTime)
+{
+	FScopeLock Lock(&GGrassSharedHeightDataLock);
+	if (SharedHeightData.IsValid() && SharedHeightData.IsUnique() && SharedHeightDataLastUseTime < MinLastUseTime)
+	{
+		SharedHeightData.Reset();
+	}
+}
+
+bool FCyLandComponentGrassData::DecompressWeightData(const ULandscapeGrassType* GrassType, TArray<uint8>& OutWeightData) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_GrassDataDecompress);
+	const TArray<uint8>* Compressed = CompressedWeightData.Find(GrassType);
+	if (Compressed == nullptr)
+	{
+		OutWeightData.Reset();
+		return false;
+	}
+	return DecodeGrassChannel<uint8, int8>(*Compressed, NumCompressedSamples, OutWeightData);
 }
 
 FArchive& operator<<(FArchive& Ar, FCyLandComponentGrassData& Data)
 {
+	if (Ar.IsSaving() && Data.IsCompressed())
+	{
+		// the compressed form is memory only, packages keep the raw layout
+		FCyLandComponentGrassData Expanded(Data);
+		Expanded.Decompress();
+		return Ar << Expanded;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Data.CompressedHeightData.Empty();
+		Data.CompressedWeightData.Empty();
+		Data.NumCompressedSamples = 0;
+	}
+
 	Ar.UsingCustomVersion(FCyLandCustomVersion::GUID);
 
 #if WITH_EDITORONLY_DATA
@@ -1268,21 +2026,52 @@ struct FGrassBuilderBase
 // FCyLandComponentGrassAccess - accessor wrapper for data for one GrassType from one Component
 struct FCyLandComponentGrassAccess
 {
-	FCyLandComponentGrassAccess(const UCyLandComponent* InComponent, const ULandscapeGrassType* GrassType)
+	FCyLandComponentGrassAccess(const UCyLandComponent* InComponent, const ULandscapeGrassType* InGrassType)
 	: GrassData(InComponent->GrassData)
-	, HeightData(InComponent->GrassData->HeightData)
-	, WeightData(InComponent->GrassData->WeightData.Find(GrassType))
+	, GrassType(InGrassType)
+	, HeightData(nullptr)
+	, WeightData(nullptr)
 	, Stride(InComponent->ComponentSizeQuads + 1)
-	{}
+	{
+		if (!GrassData->IsCompressed())
+		{
+			HeightData = &GrassData->HeightData;
+			WeightData = GrassData->WeightData.Find(GrassType);
+		}
+	}
 
 	bool IsValid()
 	{
-		return WeightData && WeightData->Num() == FMath::Square(Stride) && HeightData.Num() == FMath::Square(Stride);
+		if (GrassData->IsCompressed())
+		{
+			return GrassData->NumCompressedSamples == FMath::Square(Stride) && GrassData->CompressedWeightData.Contains(GrassType);
+		}
+		return WeightData && WeightData->Num() == FMath::Square(Stride) && HeightData->Num() == FMath::Square(Stride);
+	}
+
+	/**
+	 * Decode compressed grass data, must be called on the task thread before anything else. The heights are shared
+	 * with the other builders of the component, the weights of the grass type are owned by this builder.
+	 */
+	bool Decode()
+	{
+		if (!GrassData->IsCompressed())
+		{
+			return true;
+		}
+		SharedHeightData = GrassData->GetSharedHeightData();
+		if (!SharedHeightData.IsValid() || !GrassData->DecompressWeightData(GrassType, DecodedWeightData))
+		{
+			return false;
+		}
+		HeightData = SharedHeightData.Get();
+		WeightData = &DecodedWeightData;
+		return true;
 	}
 
 	FORCEINLINE float GetHeight(int32 IdxX, int32 IdxY)
 	{
-		return CyLandDataAccess::GetLocalHeight(HeightData[IdxX + Stride*IdxY]);
+		return CyLandDataAccess::GetLocalHeight((*HeightData)[IdxX + Stride*IdxY]);
 	}
 	FORCEINLINE float GetWeight(int32 IdxX, int32 IdxY)
 	{
@@ -1294,28 +2083,22 @@ struct FCyLandComponentGrassAccess
 		return Stride;
 	}
 
+	void UpdateHash(FSHA1& HashState) const
+	{
+		HashState.Update((const uint8*)HeightData->GetData(), HeightData->Num() * HeightData->GetTypeSize());
+		HashState.Update(WeightData->GetData(), WeightData->Num());
+	}
+
 private:
 	TSharedRef<FCyLandComponentGrassData, ESPMode::ThreadSafe> GrassData;
-	TArray<uint16>& HeightData;
+	const ULandscapeGrassType* GrassType;
+	const TArray<uint16>* HeightData;
 	TArray<uint8>* WeightData;
+	TSharedPtr<const TArray<uint16>, ESPMode::ThreadSafe> SharedHeightData;
+	TArray<uint8> DecodedWeightData;
 	int32 Stride;
 };
 
-template<uint32 Base>
-static FORCEINLINE float Halton(uint32 Index)
-{
-	float Result = 0.0f;
-	float InvBase = 1.0f / Base;
-	float Fraction = InvBase;
-	while( Index > 0 )
-	{
-		Result += ( Index % Base ) * Fraction;
-		Index /= Base;
-		Fraction *= InvBase;
-	}
-	return Result;
-}
-
 struct FAsyncGrassBuilder : public FGrassBuilderBase
 {
 	FCyLandComponentGrassAccess GrassData;
@@ -1466,14 +2249,24 @@ struct FAsyncGrassBuilder : public FGrassBuilderBase
 			FVector2D LightMapCoordinate = NormalizedGrassCoordinate * LightmapBaseScale + LightmapBaseBias;
 			FVector2D ShadowMapCoordinate = NormalizedGrassCoordinate * ShadowmapBaseScale + ShadowmapBaseBias;
 
-			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomStream.GetFraction(), LightMapCoordinate, ShadowMapCoordinate);
+			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomFraction, LightMapCoordinate, ShadowMapCoordinate);
 		}
 		else
 		{
-			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomStream.GetFraction());
+			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomFraction);
 		}
 	}
 
+	/**
+	 * Per-instance random value passed to SetInstance. Two numbers are drawn because SetInstance used to draw its own
+	 * on top of its argument, keeping the sequence means existing grass layouts don't change.
+	 */
+	float DrawInstanceRandom()
+	{
+		RandomStream.GetFraction();
+		return RandomStream.GetFraction();
+	}
+
 	FVector GetRandomScale() const
 	{
 		FVector Result(1.0f);
@@ -1514,183 +2307,95 @@ struct FAsyncGrassBuilder : public FGrassBuilderBase
 		return false;
 	}
 
+	template<typename T>
+	static void UpdateCacheKey(FSHA1& HashState, const T& Value)
+	{
+		HashState.Update((const uint8*)&Value, sizeof(T));
+	}
+
+	/** Hash of everything Build() reads, must be called before Build() as it consumes the random stream and moves Origin */
+	FSHAHash ComputeCacheKey(const FCachedCyLandFoliage::FGrassCompKey& Key) const
+	{
+		FSHA1 HashState;
+
+		UpdateCacheKey(HashState, Key.SqrtSubsections);
+		UpdateCacheKey(HashState, Key.CachedMaxInstancesPerComponent);
+		UpdateCacheKey(HashState, Key.SubsectionX);
+		UpdateCacheKey(HashState, Key.SubsectionY);
+		UpdateCacheKey(HashState, Key.NumVarieties);
+		UpdateCacheKey(HashState, Key.VarietyIndex);
+
+		GrassData.UpdateHash(HashState);
+
+		UpdateCacheKey(HashState, DrawScale);
+		UpdateCacheKey(HashState, SectionBase);
+		UpdateCacheKey(HashState, CyLandSectionOffset);
+		UpdateCacheKey(HashState, ComponentOrigin);
+		UpdateCacheKey(HashState, Origin);
+		UpdateCacheKey(HashState, Extent);
+		UpdateCacheKey(HashState, SqrtMaxInstances);
+		UpdateCacheKey(HashState, Scaling);
+		UpdateCacheKey(HashState, ScaleX);
+		UpdateCacheKey(HashState, ScaleY);
+		UpdateCacheKey(HashState, ScaleZ);
+		UpdateCacheKey(HashState, RandomRotation);
+		UpdateCacheKey(HashState, RandomScale);
+		UpdateCacheKey(HashState, AlignToSurface);
+		UpdateCacheKey(HashState, PlacementJitter);
+		UpdateCacheKey(HashState, RandomStream.GetInitialSeed());
+		UpdateCacheKey(HashState, XForm);
+		UpdateCacheKey(HashState, MeshBox.Min);
+		UpdateCacheKey(HashState, MeshBox.Max);
+		UpdateCacheKey(HashState, DesiredInstancesPerLeaf);
+		UpdateCacheKey(HashState, HaltonBaseIndex);
+		UpdateCacheKey(HashState, UseCyLandLightmap);
+		UpdateCacheKey(HashState, LightmapBaseBias);
+		UpdateCacheKey(HashState, LightmapBaseScale);
+		UpdateCacheKey(HashState, ShadowmapBaseBias);
+		UpdateCacheKey(HashState, ShadowmapBaseScale);
+		UpdateCacheKey(HashState, LightMapComponentBias);
+		UpdateCacheKey(HashState, LightMapComponentScale);
+		UpdateCacheKey(HashState, RequireCPUAccess);
+		for (const FBox& Box : ExcludedBoxes)
+		{
+			UpdateCacheKey(HashState, Box.Min);
+			UpdateCacheKey(HashState, Box.Max);
+		}
+
+		FSHAHash Result;
+		HashState.Final();
+		HashState.GetHash(Result.Hash);
+		return Result;
+	}
+
+	/** Save or load the output of Build() */
+	void SerializeOutput(FArchive& Ar)
+	{
+		Ar << TotalInstances;
+		Ar << OutOcclusionLayerNum;
+		InstanceBuffer.Serialize(Ar);
+		Ar << ClusterTree;
+
+		if (Ar.IsLoading())
+		{
+			InstanceBuffer.SetAllowCPUAccess(RequireCPUAccess);
+		}
+	}
+
 	void Build()
 	{
 		SCOPE_CYCLE_COUNTER(STAT_FoliageGrassAsyncBuildTime);
 		check(bHaveValidData);
 		double StartTime = FPlatformTime::Seconds();
 
-		float Div = 1.0f / float(SqrtMaxInstances);
 		TArray<FMatrix> InstanceTransforms;
 		if (HaltonBaseIndex)
 		{
-			if (Extent.X < 0)
-			{
-				Origin.X += Extent.X;
-				Extent.X *= -1.0f;
-			}
-			if (Extent.Y < 0)
-			{
-				Origin.Y += Extent.Y;
-				Extent.Y *= -1.0f;
-			}
-			int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
-			InstanceTransforms.Reserve(MaxNum);
-			FVector DivExtent(Extent * Div);
-			for (int32 InstanceIndex = 0; InstanceIndex < MaxNum; InstanceIndex++)
-			{
-				float HaltonX = Halton<2>(InstanceIndex + HaltonBaseIndex);
-				float HaltonY = Halton<3>(InstanceIndex + HaltonBaseIndex);
-				FVector Location(Origin.X + HaltonX * Extent.X, Origin.Y + HaltonY * Extent.Y, 0.0f);
-				FVector LocationWithHeight;
-				float Weight = GetLayerWeightAtLocationLocal(Location, &LocationWithHeight);
-				bool bKeep = Weight > 0.0f && Weight >= RandomStream.GetFraction() && !IsExcluded(LocationWithHeight);
-				if (bKeep)
-				{
-					const FVector Scale = RandomScale ? GetRandomScale() : FVector(1);
-					const float Rot = RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f;
-					const FMatrix BaseXForm = FScaleRotationTranslationMatrix(Scale, FRotator(0.0f, Rot, 0.0f), FVector::ZeroVector);
-					FMatrix OutXForm;
-					if (AlignToSurface)
-					{
-						FVector LocationWithHeightDX;
-						FVector LocationDX(Location);
-						LocationDX.X = FMath::Clamp<float>(LocationDX.X + (HaltonX < 0.5f ? DivExtent.X : -DivExtent.X), Origin.X, Origin.X + Extent.X);
-						GetLayerWeightAtLocationLocal(LocationDX, &LocationWithHeightDX, false);
-
-						FVector LocationWithHeightDY;
-						FVector LocationDY(Location);
-						LocationDY.Y = FMath::Clamp<float>(LocationDX.Y + (HaltonY < 0.5f ? DivExtent.Y : -DivExtent.Y), Origin.Y, Origin.Y + Extent.Y);
-						GetLayerWeightAtLocationLocal(LocationDY, &LocationWithHeightDY, false);
-
-						if (LocationWithHeight != LocationWithHeightDX && LocationWithHeight != LocationWithHeightDY)
-						{
-							FVector NewZ = ((LocationWithHeight - LocationWithHeightDX) ^ (LocationWithHeight - LocationWithHeightDY)).GetSafeNormal();
-							NewZ *= FMath::Sign(NewZ.Z);
-
-							const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
-							const FVector NewY = NewZ ^ NewX;
-
-							FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
-							OutXForm = (BaseXForm * Align).ConcatTranslation(LocationWithHeight) * XForm;
-						}
-						else
-						{
-							OutXForm = BaseXForm.ConcatTranslation(LocationWithHeight) * XForm;
-						}
-					}
-					else
-					{
-						OutXForm = BaseXForm.ConcatTranslation(LocationWithHeight) * XForm;
-					}
-					InstanceTransforms.Add(OutXForm);
-				}
-			}
-			if (InstanceTransforms.Num())
-			{
-				TotalInstances += InstanceTransforms.Num();
-				InstanceBuffer.AllocateInstances(InstanceTransforms.Num(), EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
-				for (int32 InstanceIndex = 0; InstanceIndex < InstanceTransforms.Num(); InstanceIndex++)
-				{
-					const FMatrix& OutXForm = InstanceTransforms[InstanceIndex];
-					SetInstance(InstanceIndex, OutXForm, RandomStream.GetFraction());
-				}
-			}
+			BuildHalton(InstanceTransforms);
 		}
 		else
 		{
-			int32 NumKept = 0;
-			float MaxJitter1D = FMath::Clamp<float>(PlacementJitter, 0.0f, .99f) * Div * .5f;
-			FVector MaxJitter(MaxJitter1D, MaxJitter1D, 0.0f);
-			MaxJitter *= Extent;
-			Origin += Extent * (Div * 0.5f);
-			struct FInstanceLocal
-			{
-				FVector Pos;
-				bool bKeep;
-			};
-			TArray<FInstanceLocal> Instances;
-			Instances.AddUninitialized(SqrtMaxInstances * SqrtMaxInstances);
-			{
-				int32 InstanceIndex = 0;
-				for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
-				{
-					for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
-					{
-						FVector Location(Origin.X + float(xStart) * Div * Extent.X, Origin.Y + float(yStart) * Div * Extent.Y, 0.0f);
-
-						// NOTE: We evaluate the random numbers on the stack and store them in locals rather than inline within the FVector() constructor below, because 
-						// the order of evaluation of function arguments in C++ is unspecified.  We really want this to behave consistently on all sorts of
-						// different platforms!
-						const float FirstRandom = RandomStream.GetFraction();
-						const float SecondRandom = RandomStream.GetFraction();
-						Location += FVector(FirstRandom * 2.0f - 1.0f, SecondRandom * 2.0f - 1.0f, 0.0f) * MaxJitter;
-
-						FInstanceLocal& Instance = Instances[InstanceIndex];
-						float Weight = GetLayerWeightAtLocationLocal(Location, &Instance.Pos);
-						Instance.bKeep = Weight > 0.0f && Weight >= RandomStream.GetFraction() && !IsExcluded(Instance.Pos);
-						if (Instance.bKeep)
-						{
-							NumKept++;
-						}
-						InstanceIndex++;
-					}
-				}
-			}
-			if (NumKept)
-			{
-				InstanceTransforms.AddUninitialized(NumKept);
-				TotalInstances += NumKept;
-				{
-					InstanceBuffer.AllocateInstances(NumKept, EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
-					int32 InstanceIndex = 0;
-					int32 OutInstanceIndex = 0;
-					for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
-					{
-						for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
-						{
-							const FInstanceLocal& Instance = Instances[InstanceIndex];
-							if (Instance.bKeep)
-							{
-								const FVector Scale = RandomScale ? GetRandomScale() : FVector(1);
-								const float Rot = RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f;
-								const FMatrix BaseXForm = FScaleRotationTranslationMatrix(Scale, FRotator(0.0f, Rot, 0.0f), FVector::ZeroVector);
-								FMatrix OutXForm;
-								if (AlignToSurface)
-								{
-									FVector PosX1 = xStart ? Instances[InstanceIndex - SqrtMaxInstances].Pos : Instance.Pos;
-									FVector PosX2 = (xStart + 1 < SqrtMaxInstances) ? Instances[InstanceIndex + SqrtMaxInstances].Pos : Instance.Pos;
-									FVector PosY1 = yStart ? Instances[InstanceIndex - 1].Pos : Instance.Pos;
-									FVector PosY2 = (yStart + 1 < SqrtMaxInstances) ? Instances[InstanceIndex + 1].Pos : Instance.Pos;
-
-									if (PosX1 != PosX2 && PosY1 != PosY2)
-									{
-										FVector NewZ = ((PosX1 - PosX2) ^ (PosY1 - PosY2)).GetSafeNormal();
-										NewZ *= FMath::Sign(NewZ.Z);
-
-										const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
-										const FVector NewY = NewZ ^ NewX;
-
-										FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
-										OutXForm = (BaseXForm * Align).ConcatTranslation(Instance.Pos) * XForm;
-									}
-									else
-									{
-										OutXForm = BaseXForm.ConcatTranslation(Instance.Pos) * XForm;
-									}
-								}
-								else
-								{
-									OutXForm = BaseXForm.ConcatTranslation(Instance.Pos) * XForm;
-								}
-								InstanceTransforms[OutInstanceIndex] = OutXForm;
-								SetInstance(OutInstanceIndex++, OutXForm, RandomStream.GetFraction());
-							}
-							InstanceIndex++;
-						}
-					}
-				}
-			}
+			BuildGrid(InstanceTransforms);
 		}
 
 		int32 NumInstances = InstanceTransforms.Num();
@@ -1723,59 +2428,247 @@ struct FAsyncGrassBuilder : public FGrassBuilderBase
 		}
 		BuildTime = FPlatformTime::Seconds() - StartTime;
 	}
-	FORCEINLINE_DEBUGGABLE float GetLayerWeightAtLocationLocal(const FVector& InLocation, FVector* OutLocation, bool bWeight = true)
+
+	/**
+	 * Halton placement, one block of candidates at a time: generate the positions, sample weight and height for the
+	 * whole block, walk the random stream in candidate order to pick the kept ones, then build their transforms.
+	 */
+	void BuildHalton(TArray<FMatrix>& InstanceTransforms)
 	{
-		// Find location
-		float TestX = InLocation.X / DrawScale.X - (float)SectionBase.X;
-		float TestY = InLocation.Y / DrawScale.Y - (float)SectionBase.Y;
+		using namespace CyLandGrassPlacement;
+
+		if (Extent.X < 0)
+		{
+			Origin.X += Extent.X;
+			Extent.X *= -1.0f;
+		}
+		if (Extent.Y < 0)
+		{
+			Origin.Y += Extent.Y;
+			Extent.Y *= -1.0f;
+		}
+		const float Div = 1.0f / float(SqrtMaxInstances);
+		const int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
+		InstanceTransforms.Reserve(MaxNum);
+		const FVector DivExtent(Extent * Div);
+		const FVector2D SectionOffset(DrawScale.X * float(CyLandSectionOffset.X), DrawScale.Y * float(CyLandSectionOffset.Y));
+
+		// Large sub-sections generate and sample several blocks at once in parallel chunks, the random walk stays sequential
+		const bool bChunked = MaxNum >= CVarGrassSchedulerChunkCandidates.GetValueOnAnyThread();
+		const int32 BatchSize = bChunked ? BlockSize * BlocksPerChunkedBatch : BlockSize;
+
+		TArray<float> HaltonX, HaltonY, X, Y, Weight, Z;
+		for (TArray<float>* Array : { &HaltonX, &HaltonY, &X, &Y, &Weight, &Z })
+		{
+			Array->SetNumUninitialized(FMath::Min<int32>(BatchSize, MaxNum));
+		}
+
+		// Kept candidates of the current batch, and the locations next to them used to align to the surface
+		TArray<int32> Kept;
+		TArray<FVector> KeptScale;
+		TArray<float> KeptRotation;
+		TArray<float> AlignX, AlignY, AlignZ;
 
-		// Find data
-		int32 X1 = FMath::FloorToInt(TestX);
-		int32 Y1 = FMath::FloorToInt(TestY);
-		int32 X2 = FMath::CeilToInt(TestX);
-		int32 Y2 = FMath::CeilToInt(TestY);
+		for (int32 BatchStart = 0; BatchStart < MaxNum; BatchStart += BatchSize)
+		{
+			const int32 Num = FMath::Min<int32>(BatchSize, MaxNum - BatchStart);
+			const int32 NumBlocks = FMath::DivideAndRoundUp<int32>(Num, BlockSize);
+			ParallelFor(NumBlocks, [&](int32 Block)
+			{
+				const int32 Start = Block * BlockSize;
+				const int32 NumInBlock = FMath::Min<int32>(BlockSize, Num - Start);
+				GenerateHalton(HaltonBaseIndex + BatchStart + Start, NumInBlock, Origin, Extent, HaltonX.GetData() + Start, HaltonY.GetData() + Start, X.GetData() + Start, Y.GetData() + Start);
+				SampleBilinear(GrassData, DrawScale, SectionBase, X.GetData() + Start, Y.GetData() + Start, NumInBlock, Weight.GetData() + Start, Z.GetData() + Start);
+			}, NumBlocks < 2);
+
+			Kept.Reset();
+			KeptScale.Reset();
+			KeptRotation.Reset();
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				const FVector LocationWithHeight(X[Index] - SectionOffset.X, Y[Index] - SectionOffset.Y, Z[Index]);
+				if (Weight[Index] > 0.0f && Weight[Index] >= RandomStream.GetFraction() && !IsExcluded(LocationWithHeight))
+				{
+					Kept.Add(Index);
+					KeptScale.Add(RandomScale ? GetRandomScale() : FVector(1));
+					KeptRotation.Add(RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f);
+				}
+			}
 
-		// Clamp to prevent the sampling of the final columns from overflowing
-		int32 IdxX1 = FMath::Clamp<int32>(X1, 0, GrassData.GetStride() - 1);
-		int32 IdxY1 = FMath::Clamp<int32>(Y1, 0, GrassData.GetStride() - 1);
-		int32 IdxX2 = FMath::Clamp<int32>(X2, 0, GrassData.GetStride() - 1);
-		int32 IdxY2 = FMath::Clamp<int32>(Y2, 0, GrassData.GetStride() - 1);
+			const int32 NumKept = Kept.Num();
+			if (AlignToSurface && NumKept)
+			{
+				// [0, NumKept) are the neighbors along X, [NumKept, 2 * NumKept) along Y
+				AlignX.SetNumUninitialized(NumKept * 2, false);
+				AlignY.SetNumUninitialized(NumKept * 2, false);
+				AlignZ.SetNumUninitialized(NumKept * 2, false);
+				for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+				{
+					const int32 Index = Kept[KeptIndex];
+					AlignX[KeptIndex] = FMath::Clamp<float>(X[Index] + (HaltonX[Index] < 0.5f ? DivExtent.X : -DivExtent.X), Origin.X, Origin.X + Extent.X);
+					AlignY[KeptIndex] = Y[Index];
+					AlignX[NumKept + KeptIndex] = X[Index];
+					AlignY[NumKept + KeptIndex] = FMath::Clamp<float>(Y[Index] + (HaltonY[Index] < 0.5f ? DivExtent.Y : -DivExtent.Y), Origin.Y, Origin.Y + Extent.Y);
+				}
+				SampleBilinearParallel(GrassData, DrawScale, SectionBase, AlignX.GetData(), AlignY.GetData(), NumKept * 2, nullptr, AlignZ.GetData(), !bChunked);
+			}
 
-		float LerpX = FMath::Fractional(TestX);
-		float LerpY = FMath::Fractional(TestY);
+			for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+			{
+				const int32 Index = Kept[KeptIndex];
+				const FVector LocationWithHeight(X[Index] - SectionOffset.X, Y[Index] - SectionOffset.Y, Z[Index]);
+				const FMatrix BaseXForm = FScaleRotationTranslationMatrix(KeptScale[KeptIndex], FRotator(0.0f, KeptRotation[KeptIndex], 0.0f), FVector::ZeroVector);
+				if (AlignToSurface)
+				{
+					const FVector LocationWithHeightDX(AlignX[KeptIndex] - SectionOffset.X, AlignY[KeptIndex] - SectionOffset.Y, AlignZ[KeptIndex]);
+					const FVector LocationWithHeightDY(AlignX[NumKept + KeptIndex] - SectionOffset.X, AlignY[NumKept + KeptIndex] - SectionOffset.Y, AlignZ[NumKept + KeptIndex]);
+					InstanceTransforms.Add(GetAlignedTransform(BaseXForm, LocationWithHeight, LocationWithHeight, LocationWithHeightDX, LocationWithHeight, LocationWithHeightDY));
+				}
+				else
+				{
+					InstanceTransforms.Add(BaseXForm.ConcatTranslation(LocationWithHeight) * XForm);
+				}
+			}
+		}
 
-		float Result = 0.0f;
-		if (bWeight)
+		if (InstanceTransforms.Num())
 		{
-			// sample
-			float Sample11 = GrassData.GetWeight(IdxX1, IdxY1);
-			float Sample21 = GrassData.GetWeight(IdxX2, IdxY1);
-			float Sample12 = GrassData.GetWeight(IdxX1, IdxY2);
-			float Sample22 = GrassData.GetWeight(IdxX2, IdxY2);
+			TotalInstances += InstanceTransforms.Num();
+			InstanceBuffer.AllocateInstances(InstanceTransforms.Num(), EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
+			for (int32 InstanceIndex = 0; InstanceIndex < InstanceTransforms.Num(); InstanceIndex++)
+			{
+				SetInstance(InstanceIndex, InstanceTransforms[InstanceIndex], DrawInstanceRandom());
+			}
+		}
+	}
 
-			// Bilinear interpolate
-			Result = FMath::Lerp(
-				FMath::Lerp(Sample11, Sample21, LerpX),
-				FMath::Lerp(Sample12, Sample22, LerpX),
-				LerpY);
+	/**
+	 * Grid placement. The jitter of a candidate depends on how many random numbers the previous ones used, which
+	 * depends on their weight, so the jitter and weight pass stays sequential; heights are then sampled in one batch
+	 * and the random numbers of the kept instances drawn before building all transforms.
+	 */
+	void BuildGrid(TArray<FMatrix>& InstanceTransforms)
+	{
+		using namespace CyLandGrassPlacement;
+
+		const float Div = 1.0f / float(SqrtMaxInstances);
+		float MaxJitter1D = FMath::Clamp<float>(PlacementJitter, 0.0f, .99f) * Div * .5f;
+		FVector MaxJitter(MaxJitter1D, MaxJitter1D, 0.0f);
+		MaxJitter *= Extent;
+		Origin += Extent * (Div * 0.5f);
+		const FVector2D SectionOffset(DrawScale.X * float(CyLandSectionOffset.X), DrawScale.Y * float(CyLandSectionOffset.Y));
+
+		const int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
+		TArray<float> X, Y, Z;
+		TArray<bool> Keep;
+		X.SetNumUninitialized(MaxNum);
+		Y.SetNumUninitialized(MaxNum);
+		Z.SetNumUninitialized(MaxNum);
+		Keep.SetNumUninitialized(MaxNum);
+		{
+			int32 InstanceIndex = 0;
+			for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
+			{
+				for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
+				{
+					// NOTE: We evaluate the random numbers on the stack and store them in locals rather than inline within the FVector() constructor below, because 
+					// the order of evaluation of function arguments in C++ is unspecified.  We really want this to behave consistently on all sorts of
+					// different platforms!
+					const float FirstRandom = RandomStream.GetFraction();
+					const float SecondRandom = RandomStream.GetFraction();
+					X[InstanceIndex] = Origin.X + float(xStart) * Div * Extent.X + (FirstRandom * 2.0f - 1.0f) * MaxJitter.X;
+					Y[InstanceIndex] = Origin.Y + float(yStart) * Div * Extent.Y + (SecondRandom * 2.0f - 1.0f) * MaxJitter.Y;
+
+					float Weight;
+					SampleBilinearScalar(GrassData, DrawScale, SectionBase, X[InstanceIndex], Y[InstanceIndex], &Weight, nullptr);
+					Keep[InstanceIndex] = Weight > 0.0f && Weight >= RandomStream.GetFraction();
+					InstanceIndex++;
+				}
+			}
 		}
 
+		const bool bChunked = MaxNum >= CVarGrassSchedulerChunkCandidates.GetValueOnAnyThread();
+		SampleBilinearParallel(GrassData, DrawScale, SectionBase, X.GetData(), Y.GetData(), MaxNum, nullptr, Z.GetData(), !bChunked);
+
+		auto GetPos = [&](int32 InstanceIndex)
+		{
+			return FVector(X[InstanceIndex] - SectionOffset.X, Y[InstanceIndex] - SectionOffset.Y, Z[InstanceIndex]);
+		};
+
+		TArray<int32> Kept;
+		for (int32 InstanceIndex = 0; InstanceIndex < MaxNum; InstanceIndex++)
 		{
-			// sample
-			float Sample11 = GrassData.GetHeight(IdxX1, IdxY1);
-			float Sample21 = GrassData.GetHeight(IdxX2, IdxY1);
-			float Sample12 = GrassData.GetHeight(IdxX1, IdxY2);
-			float Sample22 = GrassData.GetHeight(IdxX2, IdxY2);
+			if (Keep[InstanceIndex] && !IsExcluded(GetPos(InstanceIndex)))
+			{
+				Kept.Add(InstanceIndex);
+			}
+		}
 
-			OutLocation->X = InLocation.X - DrawScale.X * float(CyLandSectionOffset.X);
-			OutLocation->Y = InLocation.Y - DrawScale.Y * float(CyLandSectionOffset.Y);
-			// Bilinear interpolate
-			OutLocation->Z = DrawScale.Z * FMath::Lerp(
-				FMath::Lerp(Sample11, Sample21, LerpX),
-				FMath::Lerp(Sample12, Sample22, LerpX),
-				LerpY);
+		const int32 NumKept = Kept.Num();
+		if (NumKept == 0)
+		{
+			return;
 		}
-		return Result;
+
+		// Same order of random numbers as when each instance was finished before starting the next one
+		TArray<FVector> KeptScale;
+		TArray<float> KeptRotation;
+		TArray<float> KeptRandom;
+		KeptScale.Reserve(NumKept);
+		KeptRotation.Reserve(NumKept);
+		KeptRandom.Reserve(NumKept);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			KeptScale.Add(RandomScale ? GetRandomScale() : FVector(1));
+			KeptRotation.Add(RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f);
+			KeptRandom.Add(DrawInstanceRandom());
+		}
+
+		InstanceTransforms.SetNumUninitialized(NumKept);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			const int32 InstanceIndex = Kept[KeptIndex];
+			const int32 xStart = InstanceIndex / SqrtMaxInstances;
+			const int32 yStart = InstanceIndex % SqrtMaxInstances;
+			const FVector Pos = GetPos(InstanceIndex);
+			const FMatrix BaseXForm = FScaleRotationTranslationMatrix(KeptScale[KeptIndex], FRotator(0.0f, KeptRotation[KeptIndex], 0.0f), FVector::ZeroVector);
+			if (AlignToSurface)
+			{
+				const FVector PosX1 = xStart ? GetPos(InstanceIndex - SqrtMaxInstances) : Pos;
+				const FVector PosX2 = (xStart + 1 < SqrtMaxInstances) ? GetPos(InstanceIndex + SqrtMaxInstances) : Pos;
+				const FVector PosY1 = yStart ? GetPos(InstanceIndex - 1) : Pos;
+				const FVector PosY2 = (yStart + 1 < SqrtMaxInstances) ? GetPos(InstanceIndex + 1) : Pos;
+				InstanceTransforms[KeptIndex] = GetAlignedTransform(BaseXForm, Pos, PosX1, PosX2, PosY1, PosY2);
+			}
+			else
+			{
+				InstanceTransforms[KeptIndex] = BaseXForm.ConcatTranslation(Pos) * XForm;
+			}
+		}
+
+		TotalInstances += NumKept;
+		InstanceBuffer.AllocateInstances(NumKept, EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			SetInstance(KeptIndex, InstanceTransforms[KeptIndex], KeptRandom[KeptIndex]);
+		}
+	}
+
+	/** Transform of an instance at Pos, aligned to the surface through the pairs of positions around it when they differ */
+	FORCEINLINE FMatrix GetAlignedTransform(const FMatrix& BaseXForm, const FVector& Pos, const FVector& PosX1, const FVector& PosX2, const FVector& PosY1, const FVector& PosY2) const
+	{
+		if (PosX1 != PosX2 && PosY1 != PosY2)
+		{
+			FVector NewZ = ((PosX1 - PosX2) ^ (PosY1 - PosY2)).GetSafeNormal();
+			NewZ *= FMath::Sign(NewZ.Z);
+
+			const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
+			const FVector NewY = NewZ ^ NewX;
+
+			FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
+			return (BaseXForm * Align).ConcatTranslation(Pos) * XForm;
+		}
+		return BaseXForm.ConcatTranslation(Pos) * XForm;
 	}
 };
 
@@ -1909,6 +2802,146 @@ int32 ACyLandProxy::TotalTexturesToStreamForVisibleGrassMapRender = 0;
 int32 ACyLandProxy::TotalComponentsNeedingTextureBaking = 0;
 #endif
 
+/** Frames between two passes of the grass map memory budget over all components */
+static const uint32 GrassDataBudgetInterval = 30;
+
+/** Distance to the cameras beyond which none of the grass of a proxy is built */
+static float GetGrassDiscardDistance(ACyLandProxy* Proxy, ERHIFeatureLevel::Type FeatureLevel)
+{
+	float MaxEndCullDistance = 0.0f;
+	for (ULandscapeGrassType* GrassType : Proxy->GetGrassTypes())
+	{
+		if (GrassType)
+		{
+			for (const FGrassVariety& GrassVariety : GrassType->GrassVarieties)
+			{
+				MaxEndCullDistance = FMath::Max<float>(MaxEndCullDistance, GrassVariety.EndCullDistance.GetValueForFeatureLevel(FeatureLevel));
+			}
+		}
+	}
+	return CVarGuardBandDiscardMultiplier.GetValueOnGameThread() * MaxEndCullDistance * CVarGrassCullDistanceScale.GetValueOnGameThread();
+}
+
+/**
+ * Drop the grass maps of the components farthest from the cameras until the grass maps of the world fit in
+ * grass.GrassDataMemoryBudgetMB. Components in grass range, those whose grass map heights are baked into collision
+ * and, in cooked builds, those that can't be evaluated on the CPU keep theirs. UpdateGrass generates evicted grass
+ * maps again when their component comes back into range.
+ * Only game worlds are trimmed, evicted grass maps of a world that gets saved would be saved empty.
+ */
+static void EnforceGrassDataMemoryBudget(UWorld* World, const TArray<FVector>& Cameras)
+{
+	if (!World->IsGameWorld())
+	{
+		return;
+	}
+
+	// every world has its own interval, the proxies of all the worlds call this every tick
+	static TMap<TWeakObjectPtr<UWorld>, uint32> LastFrameNumbers;
+	uint32* LastFrameNumber = LastFrameNumbers.Find(World);
+	if (LastFrameNumber == nullptr)
+	{
+		for (auto It = LastFrameNumbers.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		LastFrameNumber = &LastFrameNumbers.Add(World, 0);
+	}
+	if (GFrameNumber - *LastFrameNumber < GrassDataBudgetInterval)
+	{
+		return;
+	}
+	*LastFrameNumber = GFrameNumber;
+
+	SCOPE_CYCLE_COUNTER(STAT_GrassDataBudget);
+
+	struct FResidentGrassData
+	{
+		UCyLandComponent* Component;
+		float Distance;
+		SIZE_T Size;
+	};
+
+	const ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
+	TMap<ACyLandProxy*, float> DiscardDistances;
+	TArray<FResidentGrassData> Evictable;
+	SIZE_T TotalSize = 0;
+	for (UCyLandComponent* Component : TObjectRange<UCyLandComponent>())
+	{
+		if (Component->GetWorld() != World || !Component->GrassData->HasData())
+		{
+			continue;
+		}
+
+		const SIZE_T Size = Component->GrassData->GetAllocatedSize();
+		TotalSize += Size;
+
+		ACyLandProxy* Proxy = Component->GetCyLandProxy();
+		if (Cameras.Num() == 0 || Proxy == nullptr || Proxy->bBakeMaterialPositionOffsetIntoCollision)
+		{
+			continue;
+		}
+
+#if !WITH_EDITOR
+		// cooked grass maps can only be regenerated on the CPU
+		if (!Component->ShouldEvaluateGrassMapOnCPU())
+		{
+			continue;
+		}
+#endif
+
+		float MinDistance = MAX_flt;
+		for (auto& Pos : Cameras)
+		{
+			MinDistance = FMath::Min<float>(MinDistance, Component->Bounds.ComputeSquaredDistanceFromBoxToPoint(Pos));
+		}
+		MinDistance = FMath::Sqrt(MinDistance);
+
+		float* DiscardDistance = DiscardDistances.Find(Proxy);
+		if (DiscardDistance == nullptr)
+		{
+			DiscardDistance = &DiscardDistances.Add(Proxy, GetGrassDiscardDistance(Proxy, FeatureLevel));
+		}
+		if (MinDistance > *DiscardDistance)
+		{
+			Evictable.Add({ Component, MinDistance, Size });
+		}
+	}
+
+	const SIZE_T BudgetBytes = (SIZE_T)FMath::Max(CVarGrassDataMemoryBudgetMB.GetValueOnGameThread(), 0) * 1024 * 1024;
+	if (BudgetBytes > 0 && TotalSize > BudgetBytes)
+	{
+		Evictable.Sort([](const FResidentGrassData& A, const FResidentGrassData& B) { return A.Distance > B.Distance; });
+
+		int32 NumEvicted = 0;
+		for (const FResidentGrassData& Resident : Evictable)
+		{
+			if (TotalSize <= BudgetBytes)
+			{
+				break;
+			}
+
+			// keep what IsGrassMapOutdated compares against, builders still using the old data keep it alive
+			TSharedRef<FCyLandComponentGrassData, ESPMode::ThreadSafe> EvictedData = MakeShareable(new FCyLandComponentGrassData());
+#if WITH_EDITORONLY_DATA
+			EvictedData->MaterialStateIds = Resident.Component->GrassData->MaterialStateIds;
+			EvictedData->RotationForWPO = Resident.Component->GrassData->RotationForWPO;
+#endif
+			EvictedData->bEvicted = true;
+			Resident.Component->GrassData = EvictedData;
+
+			TotalSize -= Resident.Size;
+			NumEvicted++;
+		}
+		INC_DWORD_STAT_BY(STAT_GrassMapsEvicted, NumEvicted);
+	}
+
+	SET_MEMORY_STAT(STAT_GrassMapDataMemory, TotalSize);
+}
+
 void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 {
 	SCOPE_CYCLE_COUNTER(STAT_GrassUpdate);
@@ -1941,6 +2974,8 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 		UWorld* World = GetWorld();
 		if (World)
 		{
+			EnforceGrassDataMemoryBudget(World, Cameras);
+
 #if WITH_EDITOR
 			int32 RequiredTexturesNotStreamedIn = 0;
 			TSet<UCyLandComponent*> ComponentsNeedingGrassMapRender;
@@ -1976,8 +3011,9 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 
 						if (GrassTypes.Num() > 0 || bBakeMaterialPositionOffsetIntoCollision)
 						{
+							// evicted grass maps are only rendered again once back in range, see below
 							if (Component->IsGrassMapOutdated() ||
-								!Component->GrassData->HasData())
+								(!Component->GrassData->HasData() && !Component->GrassData->IsEvicted()))
 							{
 								ComponentsNeedingGrassMapRender.Add(Component);
 							}
@@ -1992,18 +3028,55 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 #endif
 			ERHIFeatureLevel::Type FeatureLevel = World->Scene->GetFeatureLevel();
 
-			int32 NumCompsCreated = 0;
+			// visit components nearest to a camera first, so the one new component per frame is the one the player needs most
+			TArray<int32> ComponentOrder;
+			ComponentOrder.Reserve(CyLandComponents.Num());
 			for (int32 ComponentIndex = 0; ComponentIndex < CyLandComponents.Num(); ComponentIndex++)
+			{
+				ComponentOrder.Add(ComponentIndex);
+			}
+			if (Cameras.Num())
+			{
+				TArray<float> ComponentDistances;
+				ComponentDistances.AddUninitialized(CyLandComponents.Num());
+				for (int32 ComponentIndex = 0; ComponentIndex < CyLandComponents.Num(); ComponentIndex++)
+				{
+					UCyLandComponent* Component = CyLandComponents[ComponentIndex];
+					float MinDistanceSquared = MAX_flt;
+					if (Component)
+					{
+						for (auto& Pos : Cameras)
+						{
+							MinDistanceSquared = FMath::Min<float>(MinDistanceSquared, Component->Bounds.ComputeSquaredDistanceFromBoxToPoint(Pos));
+						}
+					}
+					ComponentDistances[ComponentIndex] = MinDistanceSquared;
+				}
+				ComponentOrder.Sort([&ComponentDistances](int32 A, int32 B) { return ComponentDistances[A] < ComponentDistances[B]; });
+			}
+
+			const bool bDiscardGrassDataOnLoad = !GIsEditor && CVarGrassDiscardDataOnLoad.GetValueOnGameThread() != 0;
+			const double SharedHeightDataReleaseTime = FPlatformTime::Seconds() - 1.0;
+
+			int32 NumCompsCreated = 0;
+			for (int32 ComponentIndex : ComponentOrder)
 			{
 
 				UCyLandComponent* Component = CyLandComponents[ComponentIndex];
 
-				// skip if we have no data and no way to generate it
-				if (Component==nullptr || (World->IsGameWorld() && !Component->GrassData->HasData()))
+				// skip if we have no data and no way to generate it, grass maps discarded on load stay discarded
+				if (Component==nullptr || (World->IsGameWorld() && !Component->GrassData->HasData() && !Component->GrassData->IsEvicted()
+					&& (bDiscardGrassDataOnLoad || !Component->ShouldEvaluateGrassMapOnCPU())))
 				{
 					continue;
 				}
 
+				// the builders of a component are started over several frames, they share its decoded heights until a second after the last one
+				if (Component->GrassData->IsCompressed())
+				{
+					Component->GrassData->ReleaseSharedHeightData(SharedHeightDataReleaseTime);
+				}
+
 				FScopeCycleCounter Context(Component->GetStatID());
 
 				FBoxSphereBounds WorldBounds = Component->CalcBounds(Component->GetComponentTransform());
@@ -2079,7 +3152,7 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 									{
 										float MinDistanceToSubComp = MinDistanceToComp;
 
-										FBox WorldSubBox;
+										FBox WorldSubBox(ForceInit);
 
 										if ((bCullSubsections && SqrtSubsections > 1) || Component->ActiveExcludedBoxes.Num())
 										{
@@ -2181,16 +3254,18 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 										}
 										NewComp.ExclusionChangeTag = GGrassExclusionChangeTag;
 
-#if WITH_EDITOR
 										// render grass data if we don't have any
 										if (!Component->GrassData->HasData())
 										{
-											if (!Component->CanRenderGrassMap())
+											// grass maps evaluated on the CPU read the texture data, they don't need shaders or streaming
+											const bool bEvaluateOnCPU = Component->ShouldEvaluateGrassMapOnCPU();
+#if WITH_EDITOR
+											if (!bEvaluateOnCPU && !Component->CanRenderGrassMap())
 											{
 												// we can't currently render grassmaps (eg shaders not compiled)
 												continue;
 											}
-											else if (!Component->AreTexturesStreamedForGrassMapRender())
+											else if (!bEvaluateOnCPU && !Component->AreTexturesStreamedForGrassMapRender())
 											{
 												// we're ready to generate but our textures need streaming in
 												DesiredForceStreamedTextures.Add(Component->GetHeightmap());
@@ -2201,12 +3276,19 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 												RequiredTexturesNotStreamedIn++;
 												continue;
 											}
+#else
+											if (!bEvaluateOnCPU)
+											{
+												continue;
+											}
+#endif
 
 											QUICK_SCOPE_CYCLE_COUNTER(STAT_GrassRenderToTexture);
 											Component->RenderGrassMap();
+#if WITH_EDITOR
 											ComponentsNeedingGrassMapRender.Remove(Component);
-										}
 #endif
+										}
 
 										NumCompsCreated++;
 
@@ -2310,11 +3392,12 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 
 										if (Builder->bHaveValidData)
 										{
-											FAsyncTask<FCyAsyncGrassTask>* Task = new FAsyncTask<FCyAsyncGrassTask>(Builder, NewComp.Key, HierarchicalInstancedStaticMeshComponent);
+											const FBox JobBounds = WorldSubBox.IsValid ? WorldSubBox : WorldBounds.GetBox();
+											FCyLandGrassJobRef Job = MakeShareable(new FCyLandGrassJob(Builder, NewComp.Key, HierarchicalInstancedStaticMeshComponent, JobBounds, DiscardDistance));
 
-											Task->StartBackgroundTask();
+											FCyLandGrassScheduler::Get().Submit(Job, MinDistanceToSubComp);
 
-											AsyncFoliageTasks.Add(Task);
+											AsyncFoliageTasks.Add(Job);
 										}
 										else
 										{
@@ -2351,9 +3434,10 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 					TArray<UCyLandComponent*> ComponentsToRender;
 					for (auto Component : ComponentsNeedingGrassMapRender)
 					{
-						if (Component->CanRenderGrassMap())
+						const bool bEvaluateOnCPU = Component->ShouldEvaluateGrassMapOnCPU();
+						if (bEvaluateOnCPU || Component->CanRenderGrassMap())
 						{
-							if (Component->AreTexturesStreamedForGrassMapRender())
+							if (bEvaluateOnCPU || Component->AreTexturesStreamedForGrassMapRender())
 							{
 								// We really want to throttle the number based on component size.
 								if (NumComponentsRendered <= 4)
@@ -2473,12 +3557,25 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 			}
 		}
 	}
+	if (AsyncFoliageTasks.Num() && !bForceSync)
+	{
+		QUICK_SCOPE_CYCLE_COUNTER(STAT_Grass_UpdatePriorities);
+		// the cameras moved since the tasks were queued, nearer ones go first and ones out of range are dropped
+		FCyLandGrassScheduler::Get().UpdatePriorities(AsyncFoliageTasks, Cameras);
+	}
 	{
 		QUICK_SCOPE_CYCLE_COUNTER(STAT_Grass_FinishAsync);
 		// finish async tasks
 		for (int32 Index = 0; Index < AsyncFoliageTasks.Num(); Index++)
 		{
-			FAsyncTask<FCyAsyncGrassTask>* Task = AsyncFoliageTasks[Index];
+			FCyLandGrassJobRef Task = AsyncFoliageTasks[Index];
+			if (Task->WasCancelled())
+			{
+				// never built, forget the component so its empty HISMC goes away with the unused ones next update
+				AsyncFoliageTasks.RemoveAtSwap(Index--);
+				FoliageCache.CachedGrassComps.Remove(Task->GetTask().Key);
+				continue;
+			}
 			if (bForceSync)
 			{
 				Task->EnsureCompletion();
@@ -2535,7 +3632,6 @@ void ACyLandProxy::UpdateGrass(const TArray<FVector>& Cameras, bool bForceSync)
 
 					Existing->Touch();
 				}
-				delete Task;
 				if (!bForceSync)
 				{
 					break; // one per frame is fine
@@ -2554,7 +3650,37 @@ FCyAsyncGrassTask::FCyAsyncGrassTask(FAsyncGrassBuilder* InBuilder, const FCache
 
 void FCyAsyncGrassTask::DoWork()
 {
-	Builder->Build();
+	if (!Builder->GrassData.Decode())
+	{
+		// corrupt grass map, leave the component empty
+		return;
+	}
+
+	if (!GGrassBuildCache.IsEnabled())
+	{
+		Builder->Build();
+		return;
+	}
+
+	// Components coming back into range produce the same build again, reuse it when nothing changed
+	FCyLandBlobCache& BuildCache = GGrassBuildCache;
+	const FSHAHash CacheKey = Builder->ComputeCacheKey(Key);
+
+	TArray<uint8> Blob;
+	if (BuildCache.Find(CacheKey, Blob))
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FoliageGrassBuildCacheLoad);
+		FMemoryReader Ar(Blob);
+		Builder->SerializeOutput(Ar);
+	}
+	else
+	{
+		Builder->Build();
+
+		FMemoryWriter Ar(Blob);
+		Builder->SerializeOutput(Ar);
+		BuildCache.Add(CacheKey, MoveTemp(Blob));
+	}
 }
 
 FCyAsyncGrassTask::~FCyAsyncGrassTask()
@@ -0,0 +1,204 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandGrassScheduler.cpp: Distance-prioritized job queue for grass builds
+=============================================================================*/
+
+#include "CyLandGrassScheduler.h"
+#include "Async/AsyncWork.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
+
+static TAutoConsoleVariable<int32> CVarGrassSchedulerMaxWorkers(
+	TEXT("grass.Scheduler.MaxWorkers"),
+	0,
+	TEXT("Number of thread pool tasks building grass at the same time, 0 uses all but one thread of the pool."));
+
+static TAutoConsoleVariable<int32> CVarGrassSchedulerCancelOutOfRange(
+	TEXT("grass.Scheduler.CancelOutOfRange"),
+	1,
+	TEXT("1: Cancel queued grass builds whose sub-section moved beyond the discard distance of every camera; 0: Always finish them"));
+
+/** Thread pool task draining the grass queue */
+class FCyLandGrassWorkerTask : public FNonAbandonableTask
+{
+public:
+	void DoWork()
+	{
+		FCyLandGrassScheduler::Get().RunJobs();
+	}
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FCyLandGrassWorkerTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+};
+
+FCyLandGrassJob::FCyLandGrassJob(FAsyncGrassBuilder* InBuilder, const FCachedCyLandFoliage::FGrassCompKey& InKey, UHierarchicalInstancedStaticMeshComponent* InFoliage, const FBox& InWorldBounds, float InDiscardDistance)
+	: Task(InBuilder, InKey, InFoliage)
+	, WorldBounds(InWorldBounds)
+	, DiscardDistance(InDiscardDistance)
+	, Priority(0.0f)
+	, State(Queued)
+{
+}
+
+void FCyLandGrassJob::EnsureCompletion()
+{
+	check(IsInGameThread());
+
+	if (State.GetValue() == Queued && FCyLandGrassScheduler::Get().Retract(*this))
+	{
+		Task.DoWork();
+		State.Set(Done);
+		return;
+	}
+
+	// A worker has it, builds take milliseconds so just yield until it's done
+	while (!IsDone())
+	{
+		FPlatformProcess::Sleep(0.0f);
+	}
+}
+
+FCyLandGrassScheduler& FCyLandGrassScheduler::Get()
+{
+	static FCyLandGrassScheduler Scheduler;
+	return Scheduler;
+}
+
+FCyLandGrassScheduler::FCyLandGrassScheduler()
+	: NumWorkers(0)
+{
+}
+
+void FCyLandGrassScheduler::Submit(const FCyLandGrassJobRef& Job, float Distance)
+{
+	int32 MaxWorkers = CVarGrassSchedulerMaxWorkers.GetValueOnGameThread();
+	if (MaxWorkers <= 0)
+	{
+		MaxWorkers = GThreadPool ? GThreadPool->GetNumThreads() - 1 : 1;
+	}
+	MaxWorkers = FMath::Max(MaxWorkers, 1);
+
+	bool bStartWorker = false;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Job->Priority = Distance;
+		Queue.Add(Job);
+		if (NumWorkers < MaxWorkers)
+		{
+			NumWorkers++;
+			bStartWorker = true;
+		}
+	}
+
+	if (bStartWorker)
+	{
+		(new FAutoDeleteAsyncTask<FCyLandGrassWorkerTask>())->StartBackgroundTask();
+	}
+}
+
+void FCyLandGrassScheduler::UpdatePriorities(const TArray<FCyLandGrassJobRef>& Jobs, const TArray<FVector>& Cameras)
+{
+	if (Cameras.Num() == 0)
+	{
+		return;
+	}
+
+	const bool bCancelOutOfRange = CVarGrassSchedulerCancelOutOfRange.GetValueOnGameThread() != 0;
+
+	FScopeLock ScopeLock(&Lock);
+	for (const FCyLandGrassJobRef& Job : Jobs)
+	{
+		if (Job->State.GetValue() != FCyLandGrassJob::Queued)
+		{
+			continue;
+		}
+
+		float MinDistanceSquared = MAX_flt;
+		for (const FVector& Pos : Cameras)
+		{
+			MinDistanceSquared = FMath::Min<float>(MinDistanceSquared, Job->WorldBounds.ComputeSquaredDistanceToPoint(Pos));
+		}
+		Job->Priority = FMath::Sqrt(MinDistanceSquared);
+
+		if (bCancelOutOfRange && Job->Priority > Job->DiscardDistance)
+		{
+			Queue.RemoveSingleSwap(Job);
+			Job->State.Set(FCyLandGrassJob::Cancelled);
+		}
+	}
+}
+
+void FCyLandGrassScheduler::Abandon(const FCyLandGrassJobRef& Job)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		if (Job->State.GetValue() == FCyLandGrassJob::Queued)
+		{
+			Queue.RemoveSingleSwap(Job);
+			Job->State.Set(FCyLandGrassJob::Cancelled);
+			return;
+		}
+	}
+
+	while (!Job->IsDone())
+	{
+		FPlatformProcess::Sleep(0.0f);
+	}
+}
+
+bool FCyLandGrassScheduler::Retract(FCyLandGrassJob& Job)
+{
+	FScopeLock ScopeLock(&Lock);
+	if (Job.State.GetValue() != FCyLandGrassJob::Queued)
+	{
+		return false;
+	}
+
+	const int32 Index = Queue.IndexOfByPredicate([&Job](const FCyLandGrassJobRef& Queued) { return &Queued.Get() == &Job; });
+	check(Index != INDEX_NONE);
+	Queue.RemoveAtSwap(Index);
+	Job.State.Set(FCyLandGrassJob::Running);
+	return true;
+}
+
+void FCyLandGrassScheduler::RunJobs()
+{
+	for (;;)
+	{
+		TSharedPtr<FCyLandGrassJob, ESPMode::ThreadSafe> Job;
+		{
+			FScopeLock ScopeLock(&Lock);
+			int32 BestIndex = INDEX_NONE;
+			for (int32 Index = 0; Index < Queue.Num(); Index++)
+			{
+				if (BestIndex == INDEX_NONE || Queue[Index]->Priority < Queue[BestIndex]->Priority)
+				{
+					BestIndex = Index;
+				}
+			}
+
+			if (BestIndex == INDEX_NONE)
+			{
+				NumWorkers--;
+				return;
+			}
+
+			Job = Queue[BestIndex];
+			Queue.RemoveAtSwap(BestIndex);
+			Job->State.Set(FCyLandGrassJob::Running);
+		}
+
+		RunJob(*Job);
+	}
+}
+
+void FCyLandGrassScheduler::RunJob(FCyLandGrassJob& Job)
+{
+	Job.Task.DoWork();
+	Job.State.Set(FCyLandGrassJob::Done);
+}
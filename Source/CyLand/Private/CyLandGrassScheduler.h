@@ -0,0 +1,99 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandGrassScheduler.h: Distance-prioritized job queue for grass builds
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "CyLandProxy.h"
+
+/** One grass sub-section build, owned by ACyLandProxy::AsyncFoliageTasks and queued in FCyLandGrassScheduler */
+class FCyLandGrassJob
+{
+public:
+	FCyLandGrassJob(FAsyncGrassBuilder* InBuilder, const FCachedCyLandFoliage::FGrassCompKey& InKey, UHierarchicalInstancedStaticMeshComponent* InFoliage, const FBox& InWorldBounds, float InDiscardDistance);
+
+	FCyAsyncGrassTask& GetTask() { return Task; }
+
+	/** Finished building, or cancelled */
+	bool IsDone() const
+	{
+		const int32 CurrentState = State.GetValue();
+		return CurrentState == Done || CurrentState == Cancelled;
+	}
+
+	/** Dropped by the scheduler before it started because it went out of range, the builder has no output */
+	bool WasCancelled() const
+	{
+		return State.GetValue() == Cancelled;
+	}
+
+	/** Build on the calling thread if still queued, otherwise wait for the worker running it. Game thread only. */
+	void EnsureCompletion();
+
+private:
+	friend class FCyLandGrassScheduler;
+
+	enum EState
+	{
+		Queued,
+		Running,
+		Done,
+		Cancelled,
+	};
+
+	FCyAsyncGrassTask Task;
+
+	/** World bounds of the grass sub-section and the distance to the cameras beyond which it isn't wanted anymore */
+	FBox WorldBounds;
+	float DiscardDistance;
+
+	/** Distance to the nearest camera, lowest runs first. Protected by the scheduler lock. */
+	float Priority;
+
+	FThreadSafeCounter State;
+};
+
+/**
+ * Runs grass builds nearest-camera first instead of in the order UpdateGrass discovers them.
+ *
+ * Jobs of every proxy go in one queue. Up to grass.Scheduler.MaxWorkers tasks in the global thread pool drain it,
+ * each always taking the job closest to a camera, and exit when it is empty. UpdateGrass re-prioritizes queued jobs
+ * with the current cameras every tick and cancels the ones that moved beyond their discard distance before they
+ * started. Large sub-sections additionally split their sampling in chunks over the task graph (see
+ * grass.Scheduler.ChunkCandidates) so idle workers help with them.
+ *
+ * The queue holds at most grass.MaxAsyncTasks jobs per proxy, so picking the best job is a linear scan.
+ */
+class FCyLandGrassScheduler
+{
+public:
+	static FCyLandGrassScheduler& Get();
+
+	/** Queue a job, Distance is its initial priority */
+	void Submit(const FCyLandGrassJobRef& Job, float Distance);
+
+	/** Recompute the priority of the queued jobs from the cameras, and cancel those that went out of range */
+	void UpdatePriorities(const TArray<FCyLandGrassJobRef>& Jobs, const TArray<FVector>& Cameras);
+
+	/** Cancel a job if it hasn't started yet, otherwise wait for it. Used when the owner goes away. */
+	void Abandon(const FCyLandGrassJobRef& Job);
+
+	/** Remove a queued job so the caller can run it, returns false if a worker already took it */
+	bool Retract(FCyLandGrassJob& Job);
+
+	/** Worker loop, runs jobs until the queue is empty */
+	void RunJobs();
+
+private:
+	FCyLandGrassScheduler();
+
+	static void RunJob(FCyLandGrassJob& Job);
+
+	FCriticalSection Lock;
+	TArray<FCyLandGrassJobRef> Queue;
+	int32 NumWorkers;
+};
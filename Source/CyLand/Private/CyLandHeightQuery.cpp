@@ -0,0 +1,431 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandHeightQuery.cpp: Batched CPU height and normal queries on CyLand collision
+=============================================================================*/
+
+#include "CyLandHeightQuery.h"
+#include "CyLandProxy.h"
+#include "CyLandHeightfieldCollisionComponent.h"
+#include "CyLandDataAccess.h"
+#include "Engine/World.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/CoreDelegates.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectIterator.h"
+
+DECLARE_CYCLE_STAT(TEXT("Height Query"), STAT_CyLandHeightQuery, STATGROUP_Landscape);
+DECLARE_CYCLE_STAT(TEXT("Height Query Update"), STAT_CyLandHeightQueryUpdate, STATGROUP_Landscape);
+
+typedef TTuple<FObjectKey, FGuid> FCyLandHeightQueryKey;
+
+/** Query services by world and landscape, game thread only */
+static TMap<FCyLandHeightQueryKey, TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe>> GCyLandHeightQueries;
+
+/** Bound to OnEndFrame while a query service has queued tiles */
+static FDelegateHandle GCyLandHeightQueryFlushHandle;
+
+FCyLandHeightQuery::FCyLandHeightQuery()
+	: Snapshot(MakeShareable(new FSnapshot()))
+{
+}
+
+TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe> FCyLandHeightQuery::Get(const ACyLandProxy* Proxy)
+{
+	check(IsInGameThread());
+	check(Proxy);
+
+	UWorld* World = Proxy->GetWorld();
+	const FCyLandHeightQueryKey Key(FObjectKey(World), Proxy->GetCyLandGuid());
+	if (const TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe>* Existing = GCyLandHeightQueries.Find(Key))
+	{
+		return *Existing;
+	}
+
+	static FDelegateHandle WorldCleanupHandle;
+	if (!WorldCleanupHandle.IsValid())
+	{
+		WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddLambda([](UWorld* CleanedWorld, bool bSessionEnded, bool bCleanupResources)
+		{
+			FCyLandHeightQuery::RemoveWorld(CleanedWorld);
+		});
+	}
+
+	TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe> Query = MakeShareable(new FCyLandHeightQuery());
+	GCyLandHeightQueries.Add(Key, Query);
+
+	// Tiles of the components that already have collision, the others are added when their physics state is created
+	for (TObjectIterator<UCyLandHeightfieldCollisionComponent> It; It; ++It)
+	{
+		UCyLandHeightfieldCollisionComponent* Component = *It;
+		if (Component->GetWorld() != World || Component->IsPendingKill())
+		{
+			continue;
+		}
+
+		const ACyLandProxy* ComponentProxy = Component->GetCyLandProxy();
+		if (ComponentProxy && ComponentProxy->GetCyLandGuid() == Proxy->GetCyLandGuid())
+		{
+			Query->AddComponent(Component, ComponentProxy);
+		}
+	}
+
+	// The first queries shouldn't wait for the end of the frame
+	Query->PublishPendingTiles();
+
+	return Query;
+}
+
+TSharedPtr<FCyLandHeightQuery, ESPMode::ThreadSafe> FCyLandHeightQuery::Find(const UCyLandHeightfieldCollisionComponent* Component, const ACyLandProxy*& OutProxy)
+{
+	check(IsInGameThread());
+
+	if (GCyLandHeightQueries.Num() == 0)
+	{
+		return nullptr;
+	}
+
+	OutProxy = Component->GetCyLandProxy();
+	if (OutProxy == nullptr)
+	{
+		return nullptr;
+	}
+
+	const FCyLandHeightQueryKey Key(FObjectKey(Component->GetWorld()), OutProxy->GetCyLandGuid());
+	if (const TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe>* Existing = GCyLandHeightQueries.Find(Key))
+	{
+		return *Existing;
+	}
+	return nullptr;
+}
+
+void FCyLandHeightQuery::UpdateComponent(const UCyLandHeightfieldCollisionComponent* Component)
+{
+	const ACyLandProxy* Proxy = nullptr;
+	TSharedPtr<FCyLandHeightQuery, ESPMode::ThreadSafe> Query = Find(Component, Proxy);
+	if (Query.IsValid())
+	{
+		Query->AddComponent(Component, Proxy);
+	}
+}
+
+void FCyLandHeightQuery::RemoveComponent(const UCyLandHeightfieldCollisionComponent* Component)
+{
+	const ACyLandProxy* Proxy = nullptr;
+	TSharedPtr<FCyLandHeightQuery, ESPMode::ThreadSafe> Query = Find(Component, Proxy);
+	if (Query.IsValid() && Proxy->ComponentSizeQuads > 0)
+	{
+		const FIntPoint Key = Component->GetSectionBase() / Proxy->ComponentSizeQuads;
+		Query->QueueTile(Key, nullptr, nullptr);
+	}
+}
+
+void FCyLandHeightQuery::RemoveWorld(const UWorld* World)
+{
+	check(IsInGameThread());
+
+	const FObjectKey WorldKey(World);
+	for (auto It = GCyLandHeightQueries.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Get<0>() == WorldKey)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FCyLandHeightQuery::AddComponent(const UCyLandHeightfieldCollisionComponent* Component, const ACyLandProxy* Proxy)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandHeightQueryUpdate);
+
+	TArray<uint16> Heights;
+	if (Proxy->ComponentSizeQuads <= 0 || !Component->GetCollisionHeights(Heights))
+	{
+		return;
+	}
+
+	FTile* Tile = new FTile();
+	Tile->Key = Component->GetSectionBase() / Proxy->ComponentSizeQuads;
+	Tile->SizeVerts = Component->CollisionSizeQuads + 1;
+	Tile->VertsPerQuad = (float)Component->CollisionSizeQuads / (float)Proxy->ComponentSizeQuads;
+	check(Heights.Num() == FMath::Square(Tile->SizeVerts));
+
+	Tile->Heights.SetNumUninitialized(Heights.Num());
+	for (int32 Index = 0; Index < Heights.Num(); Index++)
+	{
+		Tile->Heights[Index] = ((float)Heights[Index] - 32768.0f) * LANDSCAPE_ZSCALE;
+	}
+
+	QueueTile(Tile->Key, MakeShareable(Tile), Proxy);
+}
+
+FCyLandHeightQuery::FSnapshotRef FCyLandHeightQuery::GetSnapshot() const
+{
+	FScopeLock ScopeLock(&SnapshotLock);
+	return Snapshot;
+}
+
+void FCyLandHeightQuery::QueueTile(const FIntPoint& Key, const TSharedPtr<const FTile, ESPMode::ThreadSafe>& Tile, const ACyLandProxy* Proxy)
+{
+	check(IsInGameThread());
+
+	// Collision is usually updated a few components at a time, the snapshot is rebuilt once for all of them
+	PendingTiles.Add(Key, Tile);
+	if (Proxy)
+	{
+		PendingProxy = Proxy;
+	}
+
+	if (!GCyLandHeightQueryFlushHandle.IsValid())
+	{
+		GCyLandHeightQueryFlushHandle = FCoreDelegates::OnEndFrame.AddStatic(&FCyLandHeightQuery::FlushPendingTiles);
+	}
+}
+
+void FCyLandHeightQuery::FlushPendingTiles()
+{
+	check(IsInGameThread());
+
+	for (const TPair<FCyLandHeightQueryKey, TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe>>& Pair : GCyLandHeightQueries)
+	{
+		Pair.Value->PublishPendingTiles();
+	}
+
+	FCoreDelegates::OnEndFrame.Remove(GCyLandHeightQueryFlushHandle);
+	GCyLandHeightQueryFlushHandle.Reset();
+}
+
+void FCyLandHeightQuery::PublishPendingTiles()
+{
+	check(IsInGameThread());
+
+	if (PendingTiles.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandHeightQueryUpdate);
+
+	// Only the game thread replaces the snapshot, so it can be read without the lock here
+	const FSnapshot& Current = *Snapshot;
+	FSnapshot* NewSnapshot = new FSnapshot();
+
+	if (const ACyLandProxy* Proxy = PendingProxy.Get())
+	{
+		const FTransform CyLandToWorld = Proxy->CyLandActorToWorld();
+		NewSnapshot->WorldToCyLand = CyLandToWorld.ToInverseMatrixWithScale();
+		NewSnapshot->CyLandToWorld = CyLandToWorld.ToMatrixWithScale();
+		NewSnapshot->ComponentSizeQuads = Proxy->ComponentSizeQuads;
+	}
+	else
+	{
+		NewSnapshot->WorldToCyLand = Current.WorldToCyLand;
+		NewSnapshot->CyLandToWorld = Current.CyLandToWorld;
+		NewSnapshot->ComponentSizeQuads = Current.ComponentSizeQuads;
+	}
+
+	NewSnapshot->Tiles.Reserve(Current.Tiles.Num() + PendingTiles.Num());
+	for (const FTileRef& Existing : Current.Tiles)
+	{
+		if (!PendingTiles.Contains(Existing->Key))
+		{
+			NewSnapshot->Tiles.Add(Existing);
+		}
+	}
+	for (const TPair<FIntPoint, TSharedPtr<const FTile, ESPMode::ThreadSafe>>& Pending : PendingTiles)
+	{
+		if (Pending.Value.IsValid())
+		{
+			NewSnapshot->Tiles.Add(Pending.Value.ToSharedRef());
+		}
+	}
+
+	PendingTiles.Reset();
+	PendingProxy.Reset();
+
+	if (NewSnapshot->Tiles.Num() > 0)
+	{
+		FIntPoint GridMax(MIN_int32, MIN_int32);
+		NewSnapshot->GridMin = FIntPoint(MAX_int32, MAX_int32);
+		for (const FTileRef& Existing : NewSnapshot->Tiles)
+		{
+			NewSnapshot->GridMin = NewSnapshot->GridMin.ComponentMin(Existing->Key);
+			GridMax = GridMax.ComponentMax(Existing->Key);
+		}
+		NewSnapshot->GridSize = GridMax - NewSnapshot->GridMin + FIntPoint(1, 1);
+
+		NewSnapshot->Grid.SetNumZeroed(NewSnapshot->GridSize.X * NewSnapshot->GridSize.Y);
+		for (const FTileRef& Existing : NewSnapshot->Tiles)
+		{
+			const FIntPoint GridPos = Existing->Key - NewSnapshot->GridMin;
+			NewSnapshot->Grid[GridPos.Y * NewSnapshot->GridSize.X + GridPos.X] = &Existing.Get();
+		}
+	}
+
+	FSnapshotRef NewSnapshotRef = MakeShareable(NewSnapshot);
+	FScopeLock ScopeLock(&SnapshotLock);
+	Snapshot = NewSnapshotRef;
+}
+
+int32 FCyLandHeightQuery::QueryHeights(const FVector2D* Positions, int32 Num, float* OutHeights, FVector* OutNormals, bool* OutValid) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandHeightQuery);
+
+	const FSnapshotRef CurrentSnapshot = GetSnapshot();
+	const FSnapshot& Data = *CurrentSnapshot;
+
+	const FMatrix& ToCyLand = Data.WorldToCyLand;
+	const FMatrix& ToWorld = Data.CyLandToWorld;
+
+	// Landscape XY of world XY, the Z row is skipped as the landscape is only rotated around Z
+	const VectorRegister ToCyLandXX = VectorSetFloat1(ToCyLand.M[0][0]);
+	const VectorRegister ToCyLandYX = VectorSetFloat1(ToCyLand.M[1][0]);
+	const VectorRegister ToCyLandWX = VectorSetFloat1(ToCyLand.M[3][0]);
+	const VectorRegister ToCyLandXY = VectorSetFloat1(ToCyLand.M[0][1]);
+	const VectorRegister ToCyLandYY = VectorSetFloat1(ToCyLand.M[1][1]);
+	const VectorRegister ToCyLandWY = VectorSetFloat1(ToCyLand.M[3][1]);
+
+	// World Z of landscape XYZ
+	const VectorRegister ToWorldXZ = VectorSetFloat1(ToWorld.M[0][2]);
+	const VectorRegister ToWorldYZ = VectorSetFloat1(ToWorld.M[1][2]);
+	const VectorRegister ToWorldZZ = VectorSetFloat1(ToWorld.M[2][2]);
+	const VectorRegister ToWorldWZ = VectorSetFloat1(ToWorld.M[3][2]);
+
+	const float ComponentSize = (float)Data.ComponentSizeQuads;
+	const float InvComponentSize = 1.0f / ComponentSize;
+
+	MS_ALIGN(16) float WorldX[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float WorldY[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float LocalX[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float LocalY[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float Corners[4][4] GCC_ALIGN(16);
+	MS_ALIGN(16) float LerpX[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float LerpY[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float VertsPerQuad[4] GCC_ALIGN(16);
+	MS_ALIGN(16) float Results[4][4] GCC_ALIGN(16);
+	bool bLaneValid[4];
+
+	int32 NumValid = 0;
+	for (int32 Start = 0; Start < Num; Start += 4)
+	{
+		const int32 NumLanes = FMath::Min(4, Num - Start);
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			// Unused lanes of the last block repeat the first position
+			const FVector2D& Position = Positions[Start + (Lane < NumLanes ? Lane : 0)];
+			WorldX[Lane] = Position.X;
+			WorldY[Lane] = Position.Y;
+		}
+
+		const VectorRegister WX = VectorLoadAligned(WorldX);
+		const VectorRegister WY = VectorLoadAligned(WorldY);
+		const VectorRegister LX = VectorMultiplyAdd(WX, ToCyLandXX, VectorMultiplyAdd(WY, ToCyLandYX, ToCyLandWX));
+		const VectorRegister LY = VectorMultiplyAdd(WX, ToCyLandXY, VectorMultiplyAdd(WY, ToCyLandYY, ToCyLandWY));
+		VectorStoreAligned(LX, LocalX);
+		VectorStoreAligned(LY, LocalY);
+
+		for (int32 Lane = 0; Lane < 4; Lane++)
+		{
+			const int32 KeyX = FMath::FloorToInt(LocalX[Lane] * InvComponentSize);
+			const int32 KeyY = FMath::FloorToInt(LocalY[Lane] * InvComponentSize);
+			const FTile* Tile = Data.FindTile(KeyX, KeyY);
+			bLaneValid[Lane] = Tile != nullptr;
+			if (!Tile)
+			{
+				Corners[0][Lane] = Corners[1][Lane] = Corners[2][Lane] = Corners[3][Lane] = 0.0f;
+				LerpX[Lane] = LerpY[Lane] = VertsPerQuad[Lane] = 0.0f;
+				continue;
+			}
+
+			const float TileX = (LocalX[Lane] - KeyX * ComponentSize) * Tile->VertsPerQuad;
+			const float TileY = (LocalY[Lane] - KeyY * ComponentSize) * Tile->VertsPerQuad;
+			const int32 X0 = FMath::Clamp(FMath::FloorToInt(TileX), 0, Tile->SizeVerts - 2);
+			const int32 Y0 = FMath::Clamp(FMath::FloorToInt(TileY), 0, Tile->SizeVerts - 2);
+			const float* Row0 = &Tile->Heights[Y0 * Tile->SizeVerts + X0];
+			const float* Row1 = Row0 + Tile->SizeVerts;
+
+			Corners[0][Lane] = Row0[0];
+			Corners[1][Lane] = Row0[1];
+			Corners[2][Lane] = Row1[0];
+			Corners[3][Lane] = Row1[1];
+			LerpX[Lane] = FMath::Clamp(TileX - X0, 0.0f, 1.0f);
+			LerpY[Lane] = FMath::Clamp(TileY - Y0, 0.0f, 1.0f);
+			VertsPerQuad[Lane] = Tile->VertsPerQuad;
+		}
+
+		const VectorRegister H00 = VectorLoadAligned(Corners[0]);
+		const VectorRegister H10 = VectorLoadAligned(Corners[1]);
+		const VectorRegister H01 = VectorLoadAligned(Corners[2]);
+		const VectorRegister H11 = VectorLoadAligned(Corners[3]);
+		const VectorRegister FX = VectorLoadAligned(LerpX);
+		const VectorRegister FY = VectorLoadAligned(LerpY);
+
+		const VectorRegister Top = VectorMultiplyAdd(FX, VectorSubtract(H10, H00), H00);
+		const VectorRegister Bottom = VectorMultiplyAdd(FX, VectorSubtract(H11, H01), H01);
+		const VectorRegister LZ = VectorMultiplyAdd(FY, VectorSubtract(Bottom, Top), Top);
+		VectorStoreAligned(VectorMultiplyAdd(LX, ToWorldXZ, VectorMultiplyAdd(LY, ToWorldYZ, VectorMultiplyAdd(LZ, ToWorldZZ, ToWorldWZ))), Results[0]);
+
+		if (OutNormals)
+		{
+			// Height slopes per landscape quad, the local normal is (-SlopeX, -SlopeY, 1)
+			const VectorRegister Scale = VectorLoadAligned(VertsPerQuad);
+			const VectorRegister DeltaX0 = VectorSubtract(H10, H00);
+			const VectorRegister DeltaX1 = VectorSubtract(H11, H01);
+			const VectorRegister DeltaY0 = VectorSubtract(H01, H00);
+			const VectorRegister DeltaY1 = VectorSubtract(H11, H10);
+			const VectorRegister SlopeX = VectorMultiply(Scale, VectorMultiplyAdd(FY, VectorSubtract(DeltaX1, DeltaX0), DeltaX0));
+			const VectorRegister SlopeY = VectorMultiply(Scale, VectorMultiplyAdd(FX, VectorSubtract(DeltaY1, DeltaY0), DeltaY0));
+
+			// Normals transform by the inverse transpose, world axis i is row i of world to landscape dotted with the local normal
+			VectorRegister Normal[3];
+			for (int32 Axis = 0; Axis < 3; Axis++)
+			{
+				Normal[Axis] = VectorSubtract(VectorSetFloat1(ToCyLand.M[Axis][2]),
+					VectorMultiplyAdd(SlopeX, VectorSetFloat1(ToCyLand.M[Axis][0]), VectorMultiply(SlopeY, VectorSetFloat1(ToCyLand.M[Axis][1]))));
+			}
+
+			const VectorRegister SquareSum = VectorMultiplyAdd(Normal[0], Normal[0], VectorMultiplyAdd(Normal[1], Normal[1], VectorMultiply(Normal[2], Normal[2])));
+			const VectorRegister InvLength = VectorReciprocalSqrtAccurate(VectorMax(SquareSum, VectorSetFloat1(SMALL_NUMBER)));
+			VectorStoreAligned(VectorMultiply(Normal[0], InvLength), Results[1]);
+			VectorStoreAligned(VectorMultiply(Normal[1], InvLength), Results[2]);
+			VectorStoreAligned(VectorMultiply(Normal[2], InvLength), Results[3]);
+		}
+
+		for (int32 Lane = 0; Lane < NumLanes; Lane++)
+		{
+			const int32 Index = Start + Lane;
+			const bool bValid = bLaneValid[Lane];
+			NumValid += bValid ? 1 : 0;
+			OutHeights[Index] = bValid ? Results[0][Lane] : 0.0f;
+			if (OutNormals)
+			{
+				OutNormals[Index] = bValid ? FVector(Results[1][Lane], Results[2][Lane], Results[3][Lane]) : FVector::UpVector;
+			}
+			if (OutValid)
+			{
+				OutValid[Index] = bValid;
+			}
+		}
+	}
+
+	return NumValid;
+}
+
+int32 FCyLandHeightQuery::QueryHeights(const TArray<FVector2D>& Positions, TArray<float>& OutHeights, TArray<FVector>* OutNormals, TArray<bool>* OutValid) const
+{
+	OutHeights.SetNumUninitialized(Positions.Num());
+	if (OutNormals)
+	{
+		OutNormals->SetNumUninitialized(Positions.Num());
+	}
+	if (OutValid)
+	{
+		OutValid->SetNumUninitialized(Positions.Num());
+	}
+	return QueryHeights(Positions.GetData(), Positions.Num(), OutHeights.GetData(), OutNormals ? OutNormals->GetData() : nullptr, OutValid ? OutValid->GetData() : nullptr);
+}
+
+bool FCyLandHeightQuery::QueryHeight(const FVector2D& Position, float& OutHeight, FVector* OutNormal) const
+{
+	return QueryHeights(&Position, 1, &OutHeight, OutNormal) > 0;
+}
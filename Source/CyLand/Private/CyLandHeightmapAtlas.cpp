@@ -0,0 +1,442 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandHeightmapAtlas.cpp: Paged heightmap storage for runtime-spawned CyLands
+=============================================================================*/
+
+#include "CyLandHeightmapAtlas.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/Texture2D.h"
+#include "UObject/UObjectIterator.h"
+#include "UObject/UObjectGlobals.h"
+#include "CyLandProxy.h"
+#include "CyLandComponent.h"
+#include "CyLandPrivate.h"
+#include "CyLandImportPipeline.h"
+
+DECLARE_CYCLE_STAT(TEXT("Heightmap Atlas Upload"), STAT_CyLandHeightmapAtlasUpload, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Heightmap Atlas Textures"), STAT_CyLandHeightmapAtlasTextures, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Heightmap Atlas Pages"), STAT_CyLandHeightmapAtlasPages, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Heightmap Atlas Evicted Pages"), STAT_CyLandHeightmapAtlasEvictedPages, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Heightmap Atlas Evictions"), STAT_CyLandHeightmapAtlasEvictions, STATGROUP_Landscape);
+
+UCyLandHeightmapAtlas::UCyLandHeightmapAtlas(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, MostRecentlyUsedPage(INDEX_NONE)
+	, LeastRecentlyUsedPage(INDEX_NONE)
+	, PageSize(0)
+	, NumPageMips(0)
+	, TextureSize(0)
+	, MaxTextures(0)
+	, NumEvictedPages(0)
+{
+}
+
+void UCyLandHeightmapAtlas::BeginDestroy()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	PostGarbageCollectHandle.Reset();
+	Empty();
+
+	Super::BeginDestroy();
+}
+
+void UCyLandHeightmapAtlas::Initialize(int32 InPageSize, int32 InNumPageMips, int32 InTextureSize, int32 InMaxTextures)
+{
+	check(Pages.Num() == 0);
+	check(FMath::IsPowerOfTwo(InPageSize));
+
+	PageSize = InPageSize;
+	NumPageMips = FMath::Clamp(InNumPageMips, 1, FMath::FloorLog2(PageSize) + 1);
+	TextureSize = FMath::Max((int32)FMath::RoundUpToPowerOfTwo(InTextureSize), PageSize);
+	MaxTextures = FMath::Max(InMaxTextures, 1);
+
+	if (!PostGarbageCollectHandle.IsValid())
+	{
+		PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UCyLandHeightmapAtlas::RemoveStalePages);
+	}
+}
+
+void UCyLandHeightmapAtlas::Empty()
+{
+	DEC_DWORD_STAT_BY(STAT_CyLandHeightmapAtlasTextures, PhysicalTextures.Num());
+	DEC_DWORD_STAT_BY(STAT_CyLandHeightmapAtlasPages, Pages.Num());
+	DEC_DWORD_STAT_BY(STAT_CyLandHeightmapAtlasEvictedPages, NumEvictedPages);
+
+	Pages.Empty();
+	PageTable.Empty();
+	PendingUploads.Empty();
+	SlotPages.Empty();
+	FreeSlots.Empty();
+	PhysicalTextures.Empty();
+	MostRecentlyUsedPage = INDEX_NONE;
+	LeastRecentlyUsedPage = INDEX_NONE;
+	NumEvictedPages = 0;
+}
+
+void UCyLandHeightmapAtlas::RemovePages(ACyLandProxy* Proxy)
+{
+	for (UCyLandComponent* Component : Proxy->CyLandComponents)
+	{
+		int32 PageIndex;
+		if (PageTable.RemoveAndCopyValue(Component, PageIndex))
+		{
+			FreePage(PageIndex);
+		}
+	}
+}
+
+void UCyLandHeightmapAtlas::RemoveStalePages()
+{
+	// Collected components can't be looked up any more, stale keys are only removed while iterating
+	for (TMap<TWeakObjectPtr<UCyLandComponent>, int32>::TIterator It(PageTable); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			FreePage(It.Value());
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UCyLandHeightmapAtlas::FreePage(int32 PageIndex)
+{
+	const FPage& Page = Pages[PageIndex];
+	if (Page.Slot != INDEX_NONE)
+	{
+		UnlinkResidentPage(PageIndex);
+		SlotPages[Page.Slot] = INDEX_NONE;
+		FreeSlots.Add(Page.Slot);
+	}
+	else
+	{
+		NumEvictedPages--;
+		DEC_DWORD_STAT(STAT_CyLandHeightmapAtlasEvictedPages);
+	}
+
+	Pages.RemoveAt(PageIndex);
+	DEC_DWORD_STAT(STAT_CyLandHeightmapAtlasPages);
+}
+
+void UCyLandHeightmapAtlas::TouchPages(ACyLandProxy* Proxy)
+{
+	for (UCyLandComponent* Component : Proxy->CyLandComponents)
+	{
+		if (const int32* PageIndex = PageTable.Find(Component))
+		{
+			TouchPage(*PageIndex);
+		}
+	}
+}
+
+void UCyLandHeightmapAtlas::TouchPage(int32 PageIndex)
+{
+	FPage& Page = Pages[PageIndex];
+	if (Page.LastUsedFrame == GFrameCounter)
+	{
+		return;
+	}
+	Page.LastUsedFrame = GFrameCounter;
+
+	if (Page.Slot != INDEX_NONE)
+	{
+		UnlinkResidentPage(PageIndex);
+		LinkResidentPage(PageIndex);
+	}
+	else
+	{
+		PendingUploads.Add(PageIndex);
+	}
+}
+
+void UCyLandHeightmapAtlas::LinkResidentPage(int32 PageIndex)
+{
+	FPage& Page = Pages[PageIndex];
+	Page.PrevResident = INDEX_NONE;
+	Page.NextResident = MostRecentlyUsedPage;
+	if (MostRecentlyUsedPage != INDEX_NONE)
+	{
+		Pages[MostRecentlyUsedPage].PrevResident = PageIndex;
+	}
+	else
+	{
+		LeastRecentlyUsedPage = PageIndex;
+	}
+	MostRecentlyUsedPage = PageIndex;
+}
+
+void UCyLandHeightmapAtlas::UnlinkResidentPage(int32 PageIndex)
+{
+	FPage& Page = Pages[PageIndex];
+	if (Page.PrevResident != INDEX_NONE)
+	{
+		Pages[Page.PrevResident].NextResident = Page.NextResident;
+	}
+	else
+	{
+		MostRecentlyUsedPage = Page.NextResident;
+	}
+
+	if (Page.NextResident != INDEX_NONE)
+	{
+		Pages[Page.NextResident].PrevResident = Page.PrevResident;
+	}
+	else
+	{
+		LeastRecentlyUsedPage = Page.PrevResident;
+	}
+	Page.PrevResident = Page.NextResident = INDEX_NONE;
+}
+
+#if WITH_EDITOR
+bool UCyLandHeightmapAtlas::AddPage(UCyLandComponent* Component, const FCyLandImportHeightmapData& Heightmap, int32 HeightmapOffsetX, int32 HeightmapOffsetY)
+{
+	check(IsInitialized());
+	check(!PageTable.Contains(Component));
+	check(Heightmap.NumQuadMips >= NumPageMips);
+
+	const int32 PageIndex = Pages.Add(FPage());
+	PageTable.Add(Component, PageIndex);
+	INC_DWORD_STAT(STAT_CyLandHeightmapAtlasPages);
+
+	{
+		FPage& Page = Pages[PageIndex];
+		Page.Component = Component;
+		Page.Slot = INDEX_NONE;
+		Page.LastUsedFrame = GFrameCounter;
+		Page.PrevResident = Page.NextResident = INDEX_NONE;
+
+		// The CPU copy outlives the slot so an evicted page can come back without the import payload
+		for (int32 Mip = 0; Mip < NumPageMips; Mip++)
+		{
+			const int32 MipPageSize = PageSize >> Mip;
+			const int32 MipSizeU = Heightmap.SizeU >> Mip;
+			for (int32 Y = 0; Y < MipPageSize; Y++)
+			{
+				Page.Texels.Append(&Heightmap.Mips[Mip][(HeightmapOffsetX >> Mip) + ((HeightmapOffsetY >> Mip) + Y) * MipSizeU], MipPageSize);
+			}
+		}
+	}
+
+	const int32 Slot = AllocateSlot(Component->GetCyLandProxy());
+	if (Slot == INDEX_NONE)
+	{
+		// Every page is in use this frame, the component waits hidden until Update() finds it a slot
+		Component->SetHeightmap(PhysicalTextures[0]);
+		Component->HeightmapScaleBias = FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+		Component->SetVisibility(false);
+		NumEvictedPages++;
+		INC_DWORD_STAT(STAT_CyLandHeightmapAtlasEvictedPages);
+		PendingUploads.Add(PageIndex);
+		return false;
+	}
+
+	Pages[PageIndex].Slot = Slot;
+	UploadPage(PageIndex);
+	return true;
+}
+
+void UCyLandHeightmapAtlas::Update(int32 MaxUploads)
+{
+	if (PendingUploads.Num() == 0)
+	{
+		return;
+	}
+
+	// Pages touched again next frame are queued again, the others stay evicted
+	int32 NumUploads = 0;
+	const int32 MaxNumUploads = FMath::Max(MaxUploads, 1);
+	for (int32 PageIndex : PendingUploads)
+	{
+		if (NumUploads >= MaxNumUploads)
+		{
+			break;
+		}
+
+		// Pages freed since they were queued, or already uploaded
+		if (!Pages.IsAllocated(PageIndex) || Pages[PageIndex].Slot != INDEX_NONE || Pages[PageIndex].LastUsedFrame != GFrameCounter)
+		{
+			continue;
+		}
+
+		UCyLandComponent* Component = Pages[PageIndex].Component.Get();
+		if (Component == nullptr)
+		{
+			continue;
+		}
+
+		const int32 Slot = AllocateSlot(Component->GetCyLandProxy());
+		if (Slot == INDEX_NONE)
+		{
+			break;
+		}
+
+		Pages[PageIndex].Slot = Slot;
+		NumEvictedPages--;
+		DEC_DWORD_STAT(STAT_CyLandHeightmapAtlasEvictedPages);
+		NumUploads++;
+
+		UTexture2D* const PreviousHeightmap = Component->GetHeightmap();
+		UploadPage(PageIndex);
+
+		// The material instances reference the heightmap texture
+		if (Component->GetHeightmap() != PreviousHeightmap)
+		{
+			Component->UpdateMaterialInstances();
+		}
+		Component->SetVisibility(true);
+		Component->MarkRenderStateDirty();
+	}
+	PendingUploads.Reset();
+}
+
+int32 UCyLandHeightmapAtlas::AllocateSlot(ACyLandProxy* TextureOwner)
+{
+	if (FreeSlots.Num() > 0)
+	{
+		return FreeSlots.Pop(false);
+	}
+
+	if (PhysicalTextures.Num() < MaxTextures)
+	{
+		UTexture2D* const Texture = TextureOwner->CreateCyLandTexture(TextureSize, TextureSize, TEXTUREGROUP_Terrain_Heightmap, TSF_BGRA8, this);
+
+		// Slots are written with UpdateTextureRegions, which needs every mip resident
+		Texture->NeverStream = true;
+		for (int32 Mip = 0; Mip < Texture->Source.GetNumMips(); Mip++)
+		{
+			FMemory::Memzero(Texture->Source.LockMip(Mip), FMath::Square(TextureSize >> Mip) * sizeof(FColor));
+			Texture->Source.UnlockMip(Mip);
+		}
+		Texture->BeginCachePlatformData();
+		Texture->FinishCachePlatformData();
+		Texture->PostEditChange();
+
+		PhysicalTextures.Add(Texture);
+		INC_DWORD_STAT(STAT_CyLandHeightmapAtlasTextures);
+
+		// Free slots are popped from the back, so the first slots of the texture are used first
+		const int32 FirstSlot = SlotPages.Num();
+		for (int32 Slot = 0; Slot < GetPagesPerTexture(); Slot++)
+		{
+			SlotPages.Add(INDEX_NONE);
+		}
+		for (int32 Slot = SlotPages.Num() - 1; Slot > FirstSlot; Slot--)
+		{
+			FreeSlots.Add(Slot);
+		}
+		return FirstSlot;
+	}
+
+	// Evict the least recently used page, pages touched this frame are being drawn
+	const int32 PageIndex = LeastRecentlyUsedPage;
+	if (PageIndex == INDEX_NONE || Pages[PageIndex].LastUsedFrame >= GFrameCounter)
+	{
+		return INDEX_NONE;
+	}
+
+	EvictPage(PageIndex);
+	return FreeSlots.Pop(false);
+}
+
+void UCyLandHeightmapAtlas::UploadPage(int32 PageIndex)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandHeightmapAtlasUpload);
+	FPage& Page = Pages[PageIndex];
+	UCyLandComponent* const Component = Page.Component.Get();
+	check(Page.Slot != INDEX_NONE && Component);
+
+	const int32 PagesPerSide = TextureSize / PageSize;
+	const int32 SlotInTexture = Page.Slot % GetPagesPerTexture();
+	const int32 PageX = (SlotInTexture % PagesPerSide) * PageSize;
+	const int32 PageY = (SlotInTexture / PagesPerSide) * PageSize;
+	UTexture2D* const Texture = PhysicalTextures[Page.Slot / GetPagesPerTexture()];
+
+	int32 MipTexelOffset = 0;
+	for (int32 Mip = 0; Mip < NumPageMips; Mip++)
+	{
+		const int32 MipPageSize = PageSize >> Mip;
+		const int32 MipTextureSize = TextureSize >> Mip;
+		const FColor* const MipTexels = &Page.Texels[MipTexelOffset];
+		MipTexelOffset += FMath::Square(MipPageSize);
+
+		// The source mips are kept in sync for the editor side readers of the heightmap (data access, grass)
+		FColor* const SourceMip = (FColor*)Texture->Source.LockMip(Mip);
+		for (int32 Y = 0; Y < MipPageSize; Y++)
+		{
+			FMemory::Memcpy(&SourceMip[(PageX >> Mip) + ((PageY >> Mip) + Y) * MipTextureSize], &MipTexels[Y * MipPageSize], MipPageSize * sizeof(FColor));
+		}
+		Texture->Source.UnlockMip(Mip);
+
+		const int32 MipDataSize = FMath::Square(MipPageSize) * sizeof(FColor);
+		uint8* const RegionData = (uint8*)FMemory::Malloc(MipDataSize);
+		FMemory::Memcpy(RegionData, MipTexels, MipDataSize);
+
+		FUpdateTextureRegion2D* const Region = new FUpdateTextureRegion2D(PageX >> Mip, PageY >> Mip, 0, 0, MipPageSize, MipPageSize);
+		Texture->UpdateTextureRegions(Mip, 1, Region, MipPageSize * sizeof(FColor), sizeof(FColor), RegionData,
+			[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+			{
+				FMemory::Free(SrcData);
+				delete Regions;
+			});
+	}
+
+	SlotPages[Page.Slot] = PageIndex;
+	LinkResidentPage(PageIndex);
+
+	Component->HeightmapScaleBias = FVector4(1.0f / (float)TextureSize, 1.0f / (float)TextureSize, (float)PageX / (float)TextureSize, (float)PageY / (float)TextureSize);
+	Component->SetHeightmap(Texture);
+}
+
+void UCyLandHeightmapAtlas::EvictPage(int32 PageIndex)
+{
+	UnlinkResidentPage(PageIndex);
+
+	FPage& Page = Pages[PageIndex];
+	SlotPages[Page.Slot] = INDEX_NONE;
+	FreeSlots.Add(Page.Slot);
+	Page.Slot = INDEX_NONE;
+	NumEvictedPages++;
+	INC_DWORD_STAT(STAT_CyLandHeightmapAtlasEvictedPages);
+	INC_DWORD_STAT(STAT_CyLandHeightmapAtlasEvictions);
+
+	// The proxy goes away before the slot is drawn with its new page, and the CPU readers of the heightmap
+	// (grass, data access) see the page isn't resident instead of reading the next owner's texels
+	if (UCyLandComponent* Component = Page.Component.Get())
+	{
+		Component->HeightmapScaleBias = FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+		Component->SetVisibility(false);
+	}
+}
+#endif // WITH_EDITOR
+
+void UCyLandHeightmapAtlas::Dump() const
+{
+	const SIZE_T TextureMemory = (SIZE_T)PhysicalTextures.Num() * FMath::Square(TextureSize) * sizeof(FColor) * 4 / 3;
+	SIZE_T PageMemory = 0;
+	for (const FPage& Page : Pages)
+	{
+		PageMemory += Page.Texels.GetAllocatedSize();
+	}
+
+	UE_LOG(LogCyLand, Warning, TEXT("%s: %d physical textures of %d (max %d), %d texel pages with %d mips, %d/%d slots used, %d pages evicted, %.2f MB textures, %.2f MB page copies"),
+		*GetPathName(), PhysicalTextures.Num(), TextureSize, MaxTextures, PageSize, NumPageMips, SlotPages.Num() - FreeSlots.Num(), SlotPages.Num(), NumEvictedPages,
+		TextureMemory / (1024.0f * 1024.0f), PageMemory / (1024.0f * 1024.0f));
+}
+
+static void DumpCyLandHeightmapAtlases(const TArray<FString>& Args)
+{
+	for (TObjectIterator<UCyLandHeightmapAtlas> It; It; ++It)
+	{
+		if (It->IsInitialized())
+		{
+			It->Dump();
+		}
+	}
+}
+
+static FAutoConsoleCommand DumpCyLandHeightmapAtlasesCmd(
+	TEXT("CyLand.DumpHeightmapAtlases"),
+	TEXT("Print the physical textures and pages of the CyLand heightmap atlases."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpCyLandHeightmapAtlases)
+	);
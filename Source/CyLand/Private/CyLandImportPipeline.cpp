@@ -0,0 +1,550 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandImportPipeline.cpp: CPU side of ACyLandProxy::Imports
+=============================================================================*/
+
+#include "CyLandImportPipeline.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "CyLandComponent.h"
+#include "CyLandLayerInfoObject.h"
+#include "CyLandDataAccess.h"
+#include "CyLandPrivate.h"
+#include "CyLandNormalKernel.h"
+
+#if WITH_EDITOR
+
+extern const size_t ChannelOffsets[4];
+
+DECLARE_CYCLE_STAT(TEXT("Import Build Payload"), STAT_CyLandImportBuildPayload, STATGROUP_Landscape);
+
+// Ensure that we don't pack so many heightmaps into a texture that their lowest LOD isn't guaranteed to be resident
+#define MAX_HEIGHTMAP_TEXTURE_SIZE 512
+
+FCyLandImportPayload::FCyLandImportPayload(const FVector& InDrawScale3D, int32 InMinX, int32 InMinY, int32 InMaxX, int32 InMaxY, int32 InNumSubsections, int32 InSubsectionSizeQuads,
+	const uint16* InHeightData, const TArray<FCyLandImportLayerInfo>& ImportLayerInfos, ECyLandImportAlphamapType InImportLayerType)
+	: MinX(InMinX)
+	, MinY(InMinY)
+	, MaxX(InMaxX)
+	, MaxY(InMaxY)
+	, NumSubsections(InNumSubsections)
+	, SubsectionSizeQuads(InSubsectionSizeQuads)
+	, ComponentSizeQuads(InNumSubsections * InSubsectionSizeQuads)
+	, DrawScale3D(InDrawScale3D)
+	, ImportLayerType(InImportLayerType)
+	, bBuilt(false)
+{
+	check(IsInGameThread());
+
+	const int32 VertsX = MaxX - MinX + 1;
+	const int32 VertsY = MaxY - MinY + 1;
+
+	NumComponentsX = (VertsX - 1) / ComponentSizeQuads;
+	NumComponentsY = (VertsY - 1) / ComponentSizeQuads;
+	WeightmapSize = (SubsectionSizeQuads + 1) * NumSubsections;
+
+	HeightData.AddUninitialized(VertsX * VertsY);
+	FMemory::Memcpy(HeightData.GetData(), InHeightData, VertsX * VertsY * sizeof(uint16));
+
+	Layers.AddDefaulted(ImportLayerInfos.Num());
+	for (int32 LayerIndex = 0; LayerIndex < ImportLayerInfos.Num(); LayerIndex++)
+	{
+		Layers[LayerIndex].LayerData = ImportLayerInfos[LayerIndex].LayerData;
+		Layers[LayerIndex].bNoWeightBlend = ImportLayerInfos[LayerIndex].LayerInfo && ImportLayerInfos[LayerIndex].LayerInfo->bNoWeightBlend;
+	}
+
+	// The min resident mip count reads engine globals, so resolve it here rather than in Build()
+	const int32 ComponentSizeVerts = NumSubsections * (SubsectionSizeQuads + 1);
+	ComponentsPerHeightmap = FMath::Min(MAX_HEIGHTMAP_TEXTURE_SIZE / ComponentSizeVerts, 1 << (UTexture2D::GetMinTextureResidentMipCount() - 2));
+	check(ComponentsPerHeightmap > 0);
+
+	Components.AddDefaulted(NumComponentsX * NumComponentsY);
+}
+
+void FCyLandImportPayload::Build()
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandImportBuildPayload);
+	check(!bBuilt);
+
+	TArray<FColor> PackedTexels;
+	BuildPackedTexels(PackedTexels);
+
+	ParallelFor(Components.Num(), [this](int32 ComponentIndex)
+	{
+		BuildComponentWeights(ComponentIndex);
+	});
+
+	BuildHeightmapLayout();
+
+	ParallelFor(Components.Num(), [this, &PackedTexels](int32 ComponentIndex)
+	{
+		PackComponentHeights(ComponentIndex, PackedTexels);
+	});
+
+	// Mip padding of the border components spills over their neighbors, so mips are generated per texture
+	ParallelFor(Heightmaps.Num(), [this](int32 HeightmapIndex)
+	{
+		GenerateHeightmapMips(HeightmapIndex);
+	});
+
+	BuildWeightmapAllocations();
+
+	ParallelFor(Weightmaps.Num(), [this](int32 WeightmapIndex)
+	{
+		PackWeightmap(WeightmapIndex);
+	});
+
+	// Inputs are not needed anymore
+	HeightData.Empty();
+	Layers.Empty();
+
+	bBuilt = true;
+}
+
+void FCyLandImportPayload::BuildPackedTexels(TArray<FColor>& OutPackedTexels) const
+{
+	const int32 VertsX = MaxX - MinX + 1;
+	const int32 VertsY = MaxY - MinY + 1;
+
+	OutPackedTexels.SetNumUninitialized(VertsX * VertsY);
+
+	// Rows are independent once the face rows around them are known, so the grid is split in bands
+	// that each recompute the face row above their first row.
+	const int32 RowsPerBand = 64;
+	const int32 NumBands = FMath::DivideAndRoundUp(VertsY, RowsPerBand);
+	ParallelFor(NumBands, [&](int32 Band)
+	{
+		const int32 RowBegin = Band * RowsPerBand;
+		const int32 RowEnd = FMath::Min(RowBegin + RowsPerBand, VertsY);
+
+		FCyLandNormalKernel NormalKernel(DrawScale3D, VertsX);
+		NormalKernel.ComputeTexels(HeightData.GetData(), VertsX, VertsX, VertsY, RowBegin, RowEnd, &OutPackedTexels[RowBegin * VertsX], VertsX);
+	});
+}
+
+void FCyLandImportPayload::BuildComponentWeights(int32 ComponentIndex)
+{
+	const int32 VertsX = MaxX - MinX + 1;
+	const int32 ComponentX = ComponentIndex % NumComponentsX;
+	const int32 ComponentY = ComponentIndex / NumComponentsX;
+	const int32 ComponentSizeVerts = ComponentSizeQuads + 1;
+
+	FCyLandImportComponentData& Component = Components[ComponentIndex];
+	TArray<TArray<uint8>>& WeightValues = Component.WeightValues;
+	TArray<bool, TInlineAllocator<16>> IsNoBlendArray;
+
+	// Import alphamap data into local array and skip unused layers for this component.
+	for (int32 LayerIndex = 0; LayerIndex < Layers.Num(); LayerIndex++)
+	{
+		const TArray<uint8>& LayerData = Layers[LayerIndex].LayerData;
+		if (!LayerData.Num())
+		{
+			continue;
+		}
+
+		TArray<uint8> AlphaValues;
+		AlphaValues.AddUninitialized(FMath::Square(ComponentSizeVerts));
+		bool bAllZero = true;
+		for (int32 AlphaY = 0; AlphaY < ComponentSizeVerts; AlphaY++)
+		{
+			const uint8* const OldAlphaRowStart = &LayerData[(AlphaY + ComponentY * ComponentSizeQuads) * VertsX + ComponentX * ComponentSizeQuads];
+			uint8* const NewAlphaRowStart = &AlphaValues[AlphaY * ComponentSizeVerts];
+			FMemory::Memcpy(NewAlphaRowStart, OldAlphaRowStart, ComponentSizeVerts);
+
+			for (int32 AlphaX = 0; AlphaX < ComponentSizeVerts && bAllZero; AlphaX++)
+			{
+				bAllZero = NewAlphaRowStart[AlphaX] == 0;
+			}
+		}
+
+		if (!bAllZero)
+		{
+			Component.LayerIndices.Add(LayerIndex);
+			WeightValues.Add(MoveTemp(AlphaValues));
+			IsNoBlendArray.Add(Layers[LayerIndex].bNoWeightBlend);
+		}
+	}
+
+	if (ImportLayerType == ECyLandImportAlphamapType::Layered)
+	{
+		// For each layer...
+		for (int32 WeightLayerIndex = WeightValues.Num() - 1; WeightLayerIndex >= 0; WeightLayerIndex--)
+		{
+			// ... multiply all lower layers'...
+			for (int32 BelowWeightLayerIndex = WeightLayerIndex - 1; BelowWeightLayerIndex >= 0; BelowWeightLayerIndex--)
+			{
+				int32 TotalWeight = 0;
+
+				if (IsNoBlendArray[BelowWeightLayerIndex])
+				{
+					continue; // skip no blend
+				}
+
+				// ... values by...
+				for (int32 Idx = 0; Idx < WeightValues[WeightLayerIndex].Num(); Idx++)
+				{
+					// ... one-minus the current layer's values
+					int32 NewValue = (int32)WeightValues[BelowWeightLayerIndex][Idx] * (int32)(255 - WeightValues[WeightLayerIndex][Idx]) / 255;
+					WeightValues[BelowWeightLayerIndex][Idx] = (uint8)NewValue;
+					TotalWeight += NewValue;
+				}
+
+				if (TotalWeight == 0)
+				{
+					// Remove the layer as it has no contribution
+					WeightValues.RemoveAt(BelowWeightLayerIndex);
+					Component.LayerIndices.RemoveAt(BelowWeightLayerIndex);
+					IsNoBlendArray.RemoveAt(BelowWeightLayerIndex);
+
+					// The current layer has been re-numbered
+					WeightLayerIndex--;
+				}
+			}
+		}
+	}
+
+	// Weight normalization for total should be 255...
+	if (WeightValues.Num())
+	{
+		for (int32 Idx = 0; Idx < WeightValues[0].Num(); Idx++)
+		{
+			int32 TotalWeight = 0;
+			int32 MaxLayerIdx = -1;
+			int32 MaxWeight = INT_MIN;
+
+			for (int32 WeightLayerIndex = 0; WeightLayerIndex < WeightValues.Num(); WeightLayerIndex++)
+			{
+				if (!IsNoBlendArray[WeightLayerIndex])
+				{
+					int32 Weight = WeightValues[WeightLayerIndex][Idx];
+					TotalWeight += Weight;
+					if (MaxWeight < Weight)
+					{
+						MaxWeight = Weight;
+						MaxLayerIdx = WeightLayerIndex;
+					}
+				}
+			}
+
+			if (TotalWeight == 0)
+			{
+				if (MaxLayerIdx >= 0)
+				{
+					WeightValues[MaxLayerIdx][Idx] = 255;
+				}
+			}
+			else if (TotalWeight != 255)
+			{
+				// normalization...
+				float Factor = 255.0f / TotalWeight;
+				TotalWeight = 0;
+				for (int32 WeightLayerIndex = 0; WeightLayerIndex < WeightValues.Num(); WeightLayerIndex++)
+				{
+					if (!IsNoBlendArray[WeightLayerIndex])
+					{
+						WeightValues[WeightLayerIndex][Idx] = (uint8)(Factor * WeightValues[WeightLayerIndex][Idx]);
+						TotalWeight += WeightValues[WeightLayerIndex][Idx];
+					}
+				}
+
+				if (255 - TotalWeight && MaxLayerIdx >= 0)
+				{
+					WeightValues[MaxLayerIdx][Idx] += 255 - TotalWeight;
+				}
+			}
+		}
+	}
+}
+
+void FCyLandImportPayload::BuildHeightmapLayout()
+{
+	const int32 ComponentSizeVerts = NumSubsections * (SubsectionSizeQuads + 1);
+
+	// Count how many heightmaps we need and the X/Y dimension of the final heightmap
+	int32 NumHeightmapsX = 1;
+	int32 FinalComponentsX = NumComponentsX;
+	while (FinalComponentsX > ComponentsPerHeightmap)
+	{
+		FinalComponentsX -= ComponentsPerHeightmap;
+		NumHeightmapsX++;
+	}
+	int32 NumHeightmapsY = 1;
+	int32 FinalComponentsY = NumComponentsY;
+	while (FinalComponentsY > ComponentsPerHeightmap)
+	{
+		FinalComponentsY -= ComponentsPerHeightmap;
+		NumHeightmapsY++;
+	}
+
+	Heightmaps.AddDefaulted(NumHeightmapsX * NumHeightmapsY);
+	for (int32 HmY = 0; HmY < NumHeightmapsY; HmY++)
+	{
+		for (int32 HmX = 0; HmX < NumHeightmapsX; HmX++)
+		{
+			FCyLandImportHeightmapData& Heightmap = Heightmaps[HmX + HmY * NumHeightmapsX];
+
+			// make sure the heightmap UVs are powers of two.
+			Heightmap.SizeU = (1 << FMath::CeilLogTwo(((HmX == NumHeightmapsX - 1) ? FinalComponentsX : ComponentsPerHeightmap) * ComponentSizeVerts));
+			Heightmap.SizeV = (1 << FMath::CeilLogTwo(((HmY == NumHeightmapsY - 1) ? FinalComponentsY : ComponentsPerHeightmap) * ComponentSizeVerts));
+
+			int32 MipSubsectionSizeQuads = SubsectionSizeQuads;
+			int32 MipSizeU = Heightmap.SizeU;
+			int32 MipSizeV = Heightmap.SizeV;
+			while (MipSizeU > 1 && MipSizeV > 1 && MipSubsectionSizeQuads >= 1)
+			{
+				Heightmap.Mips.AddDefaulted_GetRef().AddZeroed(MipSizeU * MipSizeV);
+
+				MipSizeU >>= 1;
+				MipSizeV >>= 1;
+
+				MipSubsectionSizeQuads = ((MipSubsectionSizeQuads + 1) >> 1) - 1;
+			}
+			Heightmap.NumQuadMips = Heightmap.Mips.Num();
+
+			// Remaining mips down to 1x1 are simple averages of the previous mips
+			while (MipSizeU > 1 && MipSizeV > 1)
+			{
+				Heightmap.Mips.AddDefaulted_GetRef().AddZeroed(MipSizeU * MipSizeV);
+				MipSizeU >>= 1;
+				MipSizeV >>= 1;
+			}
+		}
+	}
+
+	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
+	{
+		const int32 HmY = ComponentY / ComponentsPerHeightmap;
+		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
+		{
+			const int32 HmX = ComponentX / ComponentsPerHeightmap;
+
+			FCyLandImportComponentData& Component = Components[ComponentX + ComponentY * NumComponentsX];
+			Component.HeightmapIndex = HmX + HmY * NumHeightmapsX;
+			Component.HeightmapOffsetX = (ComponentX - ComponentsPerHeightmap * HmX) * ComponentSizeVerts;
+			Component.HeightmapOffsetY = (ComponentY - ComponentsPerHeightmap * HmY) * ComponentSizeVerts;
+		}
+	}
+}
+
+void FCyLandImportPayload::PackComponentHeights(int32 ComponentIndex, const TArray<FColor>& PackedTexels)
+{
+	const int32 VertsX = MaxX - MinX + 1;
+	const int32 ComponentX = ComponentIndex % NumComponentsX;
+	const int32 ComponentY = ComponentIndex / NumComponentsX;
+
+	FCyLandImportComponentData& Component = Components[ComponentIndex];
+	FCyLandImportHeightmapData& Heightmap = Heightmaps[Component.HeightmapIndex];
+	FColor* const HeightmapTextureData = Heightmap.Mips[0].GetData();
+
+	uint16 MinHeight = MAX_uint16;
+	uint16 MaxHeight = 0;
+	for (int32 SubsectionY = 0; SubsectionY < NumSubsections; SubsectionY++)
+	{
+		for (int32 SubsectionX = 0; SubsectionX < NumSubsections; SubsectionX++)
+		{
+			for (int32 SubY = 0; SubY <= SubsectionSizeQuads; SubY++)
+			{
+				// X/Y of the first vertex of the subsection row in component's coordinates.
+				const int32 CompX = SubsectionSizeQuads * SubsectionX;
+				const int32 CompY = SubsectionSizeQuads * SubsectionY + SubY;
+
+				// X/Y of the vertex we're looking indexed into the texture data
+				const int32 TexX = (SubsectionSizeQuads + 1) * SubsectionX;
+				const int32 TexY = (SubsectionSizeQuads + 1) * SubsectionY + SubY;
+
+				const int32 HeightTexDataIdx = (Component.HeightmapOffsetX + TexX) + (Component.HeightmapOffsetY + TexY) * Heightmap.SizeU;
+				const int32 SrcDataIdx = (CompX + ComponentX * ComponentSizeQuads) + (CompY + ComponentY * ComponentSizeQuads) * VertsX;
+
+				// Subsection rows are contiguous in both the source and the texture
+				FMemory::Memcpy(&HeightmapTextureData[HeightTexDataIdx], &PackedTexels[SrcDataIdx], (SubsectionSizeQuads + 1) * sizeof(FColor));
+
+				for (int32 SubX = 0; SubX <= SubsectionSizeQuads; SubX++)
+				{
+					const uint16 HeightValue = HeightData[SrcDataIdx + SubX];
+					MinHeight = FMath::Min(MinHeight, HeightValue);
+					MaxHeight = FMath::Max(MaxHeight, HeightValue);
+				}
+			}
+		}
+	}
+
+	// Local space bounds of the component's vertices
+	Component.LocalBox = FBox(FVector(0.0f, 0.0f, CyLandDataAccess::GetLocalHeight(MinHeight)), FVector(ComponentSizeQuads, ComponentSizeQuads, CyLandDataAccess::GetLocalHeight(MaxHeight)));
+}
+
+void FCyLandImportPayload::GenerateHeightmapMips(int32 HeightmapIndex)
+{
+	FCyLandImportHeightmapData& Heightmap = Heightmaps[HeightmapIndex];
+
+	TArray<FColor*> MipData;
+	Heightmap.GetMipPointers(MipData);
+
+	// Quad mips, generated from the component data
+	TArray<FColor*> QuadMipData(MipData.GetData(), Heightmap.NumQuadMips);
+	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
+	{
+		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
+		{
+			const FCyLandImportComponentData& Component = Components[ComponentX + ComponentY * NumComponentsX];
+			if (Component.HeightmapIndex == HeightmapIndex)
+			{
+				UCyLandComponent::GenerateHeightmapMipsRaw(ComponentSizeQuads, NumSubsections, SubsectionSizeQuads, Heightmap.SizeU, Heightmap.SizeV, Component.HeightmapOffsetX, Component.HeightmapOffsetY,
+					QuadMipData, ComponentX == NumComponentsX - 1 ? MAX_int32 : 0, ComponentY == NumComponentsY - 1 ? MAX_int32 : 0);
+			}
+		}
+	}
+
+	// These mips do not represent quads and are just a simple averages of the previous mipmaps.
+	for (int32 Mip = Heightmap.NumQuadMips; Mip < MipData.Num(); Mip++)
+	{
+		const int32 MipSizeU = Heightmap.SizeU >> Mip;
+		const int32 MipSizeV = Heightmap.SizeV >> Mip;
+		const int32 PrevMipSizeU = Heightmap.SizeU >> (Mip - 1);
+
+		for (int32 Y = 0; Y < MipSizeV; Y++)
+		{
+			for (int32 X = 0; X < MipSizeU; X++)
+			{
+				FColor* const TexData = &MipData[Mip][X + Y * MipSizeU];
+
+				const FColor* const PreMipTexData00 = &MipData[Mip - 1][(X * 2 + 0) + (Y * 2 + 0) * PrevMipSizeU];
+				const FColor* const PreMipTexData01 = &MipData[Mip - 1][(X * 2 + 0) + (Y * 2 + 1) * PrevMipSizeU];
+				const FColor* const PreMipTexData10 = &MipData[Mip - 1][(X * 2 + 1) + (Y * 2 + 0) * PrevMipSizeU];
+				const FColor* const PreMipTexData11 = &MipData[Mip - 1][(X * 2 + 1) + (Y * 2 + 1) * PrevMipSizeU];
+
+				TexData->R = (((int32)PreMipTexData00->R + (int32)PreMipTexData01->R + (int32)PreMipTexData10->R + (int32)PreMipTexData11->R) >> 2);
+				TexData->G = (((int32)PreMipTexData00->G + (int32)PreMipTexData01->G + (int32)PreMipTexData10->G + (int32)PreMipTexData11->G) >> 2);
+				TexData->B = (((int32)PreMipTexData00->B + (int32)PreMipTexData01->B + (int32)PreMipTexData10->B + (int32)PreMipTexData11->B) >> 2);
+				TexData->A = (((int32)PreMipTexData00->A + (int32)PreMipTexData01->A + (int32)PreMipTexData10->A + (int32)PreMipTexData11->A) >> 2);
+			}
+		}
+	}
+}
+
+void FCyLandImportPayload::BuildWeightmapAllocations()
+{
+	// Same channel sharing heuristic as the original game thread import: a component needing less
+	// than 4 channels reuses the closest texture with enough free channels.
+	for (int32 ComponentY = 0; ComponentY < NumComponentsY; ComponentY++)
+	{
+		for (int32 ComponentX = 0; ComponentX < NumComponentsX; ComponentX++)
+		{
+			FCyLandImportComponentData& Component = Components[ComponentX + ComponentY * NumComponentsX];
+			const int32 NumLayers = Component.WeightValues.Num();
+			Component.WeightmapIndices.Reset(NumLayers);
+			Component.WeightmapChannels.Reset(NumLayers);
+
+			int32 LayerIndex = 0;
+			while (LayerIndex < NumLayers)
+			{
+				const int32 RemainingLayers = NumLayers - LayerIndex;
+
+				int32 BestAllocationIndex = -1;
+
+				// if we need less than 4 channels, try to find them somewhere to put all of them
+				if (RemainingLayers < 4)
+				{
+					int32 BestDistSquared = MAX_int32;
+					for (int32 TryAllocIdx = 0; TryAllocIdx < Weightmaps.Num(); TryAllocIdx++)
+					{
+						const FCyLandImportWeightmapData& TryAllocation = Weightmaps[TryAllocIdx];
+						if (TryAllocation.ChannelsInUse + RemainingLayers <= 4)
+						{
+							const int32 TryDistSquared = FMath::Square(TryAllocation.ComponentX - ComponentX) + FMath::Square(TryAllocation.ComponentY - ComponentY);
+							if (TryDistSquared < BestDistSquared)
+							{
+								BestDistSquared = TryDistSquared;
+								BestAllocationIndex = TryAllocIdx;
+							}
+						}
+					}
+				}
+
+				if (BestAllocationIndex != -1)
+				{
+					FCyLandImportWeightmapData& Allocation = Weightmaps[BestAllocationIndex];
+					for (int32 i = 0; i < RemainingLayers; i++)
+					{
+						Component.WeightmapIndices.Add(BestAllocationIndex);
+						Component.WeightmapChannels.Add(Allocation.ChannelsInUse++);
+					}
+					LayerIndex += RemainingLayers;
+				}
+				else
+				{
+					// We couldn't find a suitable place for these layers, so lets make a new one.
+					const int32 ThisAllocationLayers = FMath::Min<int32>(RemainingLayers, 4);
+					const int32 NewAllocationIndex = Weightmaps.AddDefaulted();
+					FCyLandImportWeightmapData& Allocation = Weightmaps[NewAllocationIndex];
+					Allocation.ComponentX = ComponentX;
+					Allocation.ComponentY = ComponentY;
+					Allocation.ChannelsInUse = ThisAllocationLayers;
+
+					for (int32 i = 0; i < ThisAllocationLayers; i++)
+					{
+						Component.WeightmapIndices.Add(NewAllocationIndex);
+						Component.WeightmapChannels.Add(i);
+					}
+					LayerIndex += ThisAllocationLayers;
+				}
+			}
+		}
+	}
+}
+
+void FCyLandImportPayload::PackWeightmap(int32 WeightmapIndex)
+{
+	FCyLandImportWeightmapData& Weightmap = Weightmaps[WeightmapIndex];
+
+	const int32 NumMips = FMath::FloorLog2(WeightmapSize) + 1;
+	Weightmap.Mips.AddDefaulted(NumMips);
+	for (int32 Mip = 0; Mip < NumMips; Mip++)
+	{
+		Weightmap.Mips[Mip].AddZeroed(FMath::Square(FMath::Max(WeightmapSize >> Mip, 1)));
+	}
+
+	FColor* const BaseMipData = Weightmap.Mips[0].GetData();
+	for (const FCyLandImportComponentData& Component : Components)
+	{
+		for (int32 WeightLayerIndex = 0; WeightLayerIndex < Component.WeightValues.Num(); WeightLayerIndex++)
+		{
+			if (Component.WeightmapIndices[WeightLayerIndex] != WeightmapIndex)
+			{
+				continue;
+			}
+
+			// Stride is 4 (FColor), channels are in R, G, B, A order
+			uint8* const ChannelData = (uint8*)&BaseMipData->R + ChannelOffsets[Component.WeightmapChannels[WeightLayerIndex]];
+			const TArray<uint8>& WeightValues = Component.WeightValues[WeightLayerIndex];
+
+			for (int32 SubsectionY = 0; SubsectionY < NumSubsections; SubsectionY++)
+			{
+				for (int32 SubsectionX = 0; SubsectionX < NumSubsections; SubsectionX++)
+				{
+					for (int32 SubY = 0; SubY <= SubsectionSizeQuads; SubY++)
+					{
+						for (int32 SubX = 0; SubX <= SubsectionSizeQuads; SubX++)
+						{
+							const int32 CompX = SubsectionSizeQuads * SubsectionX + SubX;
+							const int32 CompY = SubsectionSizeQuads * SubsectionY + SubY;
+							const int32 TexX = (SubsectionSizeQuads + 1) * SubsectionX + SubX;
+							const int32 TexY = (SubsectionSizeQuads + 1) * SubsectionY + SubY;
+
+							ChannelData[(TexX + TexY * WeightmapSize) * 4] = WeightValues[CompY * (ComponentSizeQuads + 1) + CompX];
+						}
+					}
+				}
+			}
+		}
+	}
+
+	TArray<FColor*> MipData;
+	for (TArray<FColor>& Mip : Weightmap.Mips)
+	{
+		MipData.Add(Mip.GetData());
+	}
+	UCyLandComponent::UpdateWeightmapMipsRaw(NumSubsections, SubsectionSizeQuads, WeightmapSize, WeightmapSize, MipData);
+}
+
+#endif // WITH_EDITOR
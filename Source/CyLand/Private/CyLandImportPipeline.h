@@ -0,0 +1,146 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandImportPipeline.h: CPU side of ACyLandProxy::Imports
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/AsyncWork.h"
+#include "CyLandProxy.h"
+
+#if WITH_EDITOR
+
+/** Per-component result of the CPU import stage */
+struct FCyLandImportComponentData
+{
+	/** Import layer index of each weight layer kept for this component, in allocation order */
+	TArray<int32> LayerIndices;
+
+	/** Normalized weight values of each kept layer, (ComponentSizeQuads+1)^2 each */
+	TArray<TArray<uint8>> WeightValues;
+
+	/** Payload weightmap texture and channel of each kept layer */
+	TArray<int32> WeightmapIndices;
+	TArray<int32> WeightmapChannels;
+
+	/** Heightmap texture this component lives in, and its offset in texels */
+	int32 HeightmapIndex;
+	int32 HeightmapOffsetX;
+	int32 HeightmapOffsetY;
+
+	FBox LocalBox;
+};
+
+/** A heightmap texture of the import with its full source mip chain */
+struct FCyLandImportHeightmapData
+{
+	int32 SizeU;
+	int32 SizeV;
+
+	/** Number of leading mips that represent quads, the rest are plain averages */
+	int32 NumQuadMips;
+
+	TArray<TArray<FColor>> Mips;
+
+	void GetMipPointers(TArray<FColor*>& OutMipData)
+	{
+		OutMipData.Reset(Mips.Num());
+		for (TArray<FColor>& Mip : Mips)
+		{
+			OutMipData.Add(Mip.GetData());
+		}
+	}
+};
+
+/** A weightmap texture of the import with its full source mip chain */
+struct FCyLandImportWeightmapData
+{
+	/** Component that created the allocation, used to share free channels with close neighbors */
+	int32 ComponentX;
+	int32 ComponentY;
+	int32 ChannelsInUse;
+
+	TArray<TArray<FColor>> Mips;
+};
+
+/** Source data of an import layer, copied on the game thread so the CPU stage doesn't touch any UObject */
+struct FCyLandImportLayerSource
+{
+	TArray<uint8> LayerData;
+	bool bNoWeightBlend;
+};
+
+/**
+ * Everything ACyLandProxy::Imports computes before creating UObjects: packed height/normal texels, per-component
+ * weight normalization, weightmap channel packing and all heightmap/weightmap texture payloads.
+ * Build() only touches the data in this struct and may run on any thread.
+ */
+struct FCyLandImportPayload
+{
+	/** Copy the import inputs, must be called on the game thread */
+	FCyLandImportPayload(const FVector& InDrawScale3D, int32 InMinX, int32 InMinY, int32 InMaxX, int32 InMaxY, int32 InNumSubsections, int32 InSubsectionSizeQuads,
+		const uint16* InHeightData, const TArray<FCyLandImportLayerInfo>& ImportLayerInfos, ECyLandImportAlphamapType InImportLayerType);
+
+	/** Run the CPU stage. Internally parallel, may be called from a worker thread. */
+	void Build();
+
+	bool IsBuilt() const { return bBuilt; }
+
+	int32 MinX, MinY, MaxX, MaxY;
+	int32 NumSubsections;
+	int32 SubsectionSizeQuads;
+	int32 ComponentSizeQuads;
+	int32 NumComponentsX;
+	int32 NumComponentsY;
+	int32 WeightmapSize;
+	int32 ComponentsPerHeightmap;
+	FVector DrawScale3D;
+	ECyLandImportAlphamapType ImportLayerType;
+
+	TArray<uint16> HeightData;
+	TArray<FCyLandImportLayerSource> Layers;
+
+	/** Results, indexed by ComponentX + ComponentY * NumComponentsX */
+	TArray<FCyLandImportComponentData> Components;
+	TArray<FCyLandImportHeightmapData> Heightmaps;
+	TArray<FCyLandImportWeightmapData> Weightmaps;
+
+private:
+	void BuildPackedTexels(TArray<FColor>& OutPackedTexels) const;
+	void BuildComponentWeights(int32 ComponentIndex);
+	void BuildHeightmapLayout();
+	void BuildWeightmapAllocations();
+	void PackComponentHeights(int32 ComponentIndex, const TArray<FColor>& PackedTexels);
+	void GenerateHeightmapMips(int32 HeightmapIndex);
+	void PackWeightmap(int32 WeightmapIndex);
+
+	bool bBuilt;
+};
+
+typedef TSharedPtr<FCyLandImportPayload, ESPMode::ThreadSafe> FCyLandImportPayloadPtr;
+
+/** Runs FCyLandImportPayload::Build in the thread pool */
+class FCyLandImportTask : public FNonAbandonableTask
+{
+public:
+	FCyLandImportPayloadPtr Payload;
+
+	FCyLandImportTask(const FCyLandImportPayloadPtr& InPayload)
+		: Payload(InPayload)
+	{
+	}
+
+	void DoWork()
+	{
+		Payload->Build();
+	}
+
+	FORCEINLINE TStatId GetStatId() const
+	{
+		RETURN_QUICK_DECLARE_CYCLE_STAT(FCyLandImportTask, STATGROUP_ThreadPoolAsyncTasks);
+	}
+};
+
+#endif // WITH_EDITOR
@@ -0,0 +1,444 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLODSimulation.cpp: Offline replay of CyLand LOD decisions along camera paths
+=============================================================================*/
+
+#include "CyLandLODSimulation.h"
+#include "CyLandLODMath.h"
+#include "ConvexVolume.h"
+#include "CoreGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+
+bool FCyLandCameraPath::LoadFromFile(const FString& Filename)
+{
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+	{
+		return false;
+	}
+
+	Samples.Reset();
+	for (const FString& Line : Lines)
+	{
+		TArray<FString> Values;
+		Line.ParseIntoArray(Values, TEXT(","));
+
+		// Skips the header and anything else that isn't a sample
+		if (Values.Num() != 8 || !Values[0].IsNumeric())
+		{
+			continue;
+		}
+
+		FCyLandCameraSample& Sample = Samples.AddDefaulted_GetRef();
+		Sample.Time = FCString::Atof(*Values[0]);
+		Sample.Location = FVector(FCString::Atof(*Values[1]), FCString::Atof(*Values[2]), FCString::Atof(*Values[3]));
+		Sample.Rotation = FRotator(FCString::Atof(*Values[4]), FCString::Atof(*Values[5]), FCString::Atof(*Values[6]));
+		Sample.FOV = FCString::Atof(*Values[7]);
+	}
+
+	return Samples.Num() > 0;
+}
+
+bool FCyLandCameraPath::SaveToFile(const FString& Filename) const
+{
+	FString Text = TEXT("Time,X,Y,Z,Pitch,Yaw,Roll,FOV\n");
+	for (const FCyLandCameraSample& Sample : Samples)
+	{
+		Text += FString::Printf(TEXT("%f,%f,%f,%f,%f,%f,%f,%f\n"), Sample.Time, Sample.Location.X, Sample.Location.Y, Sample.Location.Z, Sample.Rotation.Pitch, Sample.Rotation.Yaw, Sample.Rotation.Roll, Sample.FOV);
+	}
+	return FFileHelper::SaveStringToFile(Text, *Filename);
+}
+
+FCyLandCameraPath FCyLandCameraPath::MakeFlyover(float Size, float Height, int32 NumSamples)
+{
+	FCyLandCameraPath Path;
+	Path.Samples.SetNum(NumSamples);
+
+	const float Radius = Size * 0.35f;
+	for (int32 Index = 0; Index < NumSamples; Index++)
+	{
+		// Vary the height along the lap so the camera goes from grazing the ground to overlooking it
+		const float Angle = 2.0f * PI * Index / NumSamples;
+		FCyLandCameraSample& Sample = Path.Samples[Index];
+		Sample.Time = Index / 30.0f;
+		Sample.Location = FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, Height * (1.0f + 0.75f * FMath::Sin(3.0f * Angle)));
+		Sample.Rotation = (FVector(0.0f, 0.0f, 0.0f) - Sample.Location).Rotation();
+		Sample.FOV = 90.0f;
+	}
+
+	return Path;
+}
+
+FString FCyLandLODSimulationReport::GetSummary() const
+{
+	if (Frames.Num() == 0)
+	{
+		return TEXT("No frames");
+	}
+
+	double TotalVisible = 0.0;
+	double TotalCombined = 0.0;
+	double TotalTessellated = 0.0;
+	double TotalTriangles = 0.0;
+	double TotalSeconds = 0.0;
+	int64 MaxTriangles = 0;
+	double MaxSeconds = 0.0;
+	TArray<int64> Histogram;
+
+	for (const FCyLandLODSimulationFrame& Frame : Frames)
+	{
+		TotalVisible += Frame.NumVisible;
+		TotalCombined += Frame.NumCombined;
+		TotalTessellated += Frame.NumTessellated;
+		TotalTriangles += Frame.NumTriangles;
+		TotalSeconds += Frame.DecisionSeconds;
+		MaxTriangles = FMath::Max(MaxTriangles, Frame.NumTriangles);
+		MaxSeconds = FMath::Max(MaxSeconds, Frame.DecisionSeconds);
+
+		Histogram.SetNumZeroed(FMath::Max(Histogram.Num(), Frame.LODHistogram.Num()));
+		for (int32 LODIndex = 0; LODIndex < Frame.LODHistogram.Num(); LODIndex++)
+		{
+			Histogram[LODIndex] += Frame.LODHistogram[LODIndex];
+		}
+	}
+
+	const int32 NumFrames = Frames.Num();
+	FString Summary = FString::Printf(TEXT("%d frames: %.1f visible components, %.1f combined, %.1f tessellated, %.0f triangles (peak %lld), decisions %.2f us (peak %.2f us)"),
+		NumFrames, TotalVisible / NumFrames, TotalCombined / NumFrames, TotalTessellated / NumFrames, TotalTriangles / NumFrames, MaxTriangles, TotalSeconds * 1000000.0 / NumFrames, MaxSeconds * 1000000.0);
+
+	int64 TotalSubSections = 0;
+	for (int64 Count : Histogram)
+	{
+		TotalSubSections += Count;
+	}
+
+	Summary += TEXT("\nSub-sections per LOD:");
+	for (int32 LODIndex = 0; LODIndex < Histogram.Num(); LODIndex++)
+	{
+		Summary += FString::Printf(TEXT(" LOD%d %.1f%%"), LODIndex, TotalSubSections > 0 ? 100.0 * Histogram[LODIndex] / TotalSubSections : 0.0);
+	}
+
+	return Summary;
+}
+
+bool FCyLandLODSimulationReport::SaveToFile(const FString& Filename) const
+{
+	int32 NumLODs = 0;
+	for (const FCyLandLODSimulationFrame& Frame : Frames)
+	{
+		NumLODs = FMath::Max(NumLODs, Frame.LODHistogram.Num());
+	}
+
+	FString Text = TEXT("Frame,Visible,Combined,Tessellated,Triangles,DecisionUs");
+	for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++)
+	{
+		Text += FString::Printf(TEXT(",LOD%d"), LODIndex);
+	}
+	Text += TEXT("\n");
+
+	for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); FrameIndex++)
+	{
+		const FCyLandLODSimulationFrame& Frame = Frames[FrameIndex];
+		Text += FString::Printf(TEXT("%d,%d,%d,%d,%lld,%.3f"), FrameIndex, Frame.NumVisible, Frame.NumCombined, Frame.NumTessellated, Frame.NumTriangles, Frame.DecisionSeconds * 1000000.0);
+		for (int32 LODIndex = 0; LODIndex < NumLODs; LODIndex++)
+		{
+			Text += FString::Printf(TEXT(",%d"), Frame.LODHistogram.IsValidIndex(LODIndex) ? Frame.LODHistogram[LODIndex] : 0);
+		}
+		Text += TEXT("\n");
+	}
+
+	return FFileHelper::SaveStringToFile(Text, *Filename);
+}
+
+FCyLandLODSimulation::FCyLandLODSimulation(const FCyLandLODSimulationSettings& InSettings)
+	: Settings(InSettings)
+{
+	Settings.NumSubsections = FMath::Clamp(Settings.NumSubsections, 1, 2);
+	Settings.SubsectionSizeQuads = FMath::Max(Settings.SubsectionSizeQuads, 1);
+
+	// Same setup as the FCyLandComponentSceneProxy constructor
+	MaxLOD = FMath::CeilLogTwo(Settings.SubsectionSizeQuads + 1) - 1;
+	CyLandLODMath::BuildLODScreenRatioSquared(MaxLOD, Settings.LOD0DistributionSetting, Settings.LODDistributionSetting, LODScreenRatioSquared);
+
+	if (Settings.MaxLODLevel >= 0)
+	{
+		MaxLOD = FMath::Min(MaxLOD, Settings.MaxLODLevel);
+	}
+
+	LastLOD = MaxLOD;
+	Settings.ForcedLOD = Settings.ForcedLOD != INDEX_NONE ? FMath::Clamp(Settings.ForcedLOD, 0, LastLOD) : INDEX_NONE;
+	Settings.LODBias = FMath::Clamp(Settings.LODBias, -MaxLOD, MaxLOD);
+	MinValidLOD = FMath::Clamp(Settings.LODBias, -MaxLOD, MaxLOD);
+	MaxValidLOD = FMath::Min(MaxLOD, MaxLOD + Settings.LODBias);
+
+	ComponentMaxExtend = Settings.SubsectionSizeQuads * FMath::Max(Settings.Scale.X, Settings.Scale.Y);
+
+	// Grid centered on the origin over rolling hills a few components wide
+	const int32 ComponentSizeQuads = Settings.SubsectionSizeQuads * Settings.NumSubsections;
+	const FVector2D ComponentSize(ComponentSizeQuads * Settings.Scale.X, ComponentSizeQuads * Settings.Scale.Y);
+	const FVector2D GridOrigin(-0.5f * Settings.NumComponents.X * ComponentSize.X, -0.5f * Settings.NumComponents.Y * ComponentSize.Y);
+	const float HillFrequency = 2.0f * PI / (8.0f * FMath::Max(ComponentSize.X, ComponentSize.Y));
+	const int32 NumHeightSamples = 9;
+
+	Components.Reserve(Settings.NumComponents.X * Settings.NumComponents.Y);
+	for (int32 ComponentY = 0; ComponentY < Settings.NumComponents.Y; ComponentY++)
+	{
+		for (int32 ComponentX = 0; ComponentX < Settings.NumComponents.X; ComponentX++)
+		{
+			const FVector2D Min = GridOrigin + FVector2D(ComponentX * ComponentSize.X, ComponentY * ComponentSize.Y);
+
+			float MinZ = MAX_flt;
+			float MaxZ = -MAX_flt;
+			for (int32 SampleY = 0; SampleY < NumHeightSamples; SampleY++)
+			{
+				for (int32 SampleX = 0; SampleX < NumHeightSamples; SampleX++)
+				{
+					const float X = Min.X + ComponentSize.X * SampleX / (NumHeightSamples - 1);
+					const float Y = Min.Y + ComponentSize.Y * SampleY / (NumHeightSamples - 1);
+					const float Z = 0.5f * Settings.HeightRange * FMath::Sin(X * HillFrequency) * FMath::Cos(Y * HillFrequency * 0.7f);
+					MinZ = FMath::Min(MinZ, Z);
+					MaxZ = FMath::Max(MaxZ, Z);
+				}
+			}
+
+			FComponent& Component = Components.AddDefaulted_GetRef();
+			Component.Box = FBox(FVector(Min.X, Min.Y, MinZ), FVector(Min.X + ComponentSize.X, Min.Y + ComponentSize.Y, MaxZ));
+			Component.Origin = Component.Box.GetCenter();
+			Component.SphereRadius = Component.Box.GetExtent().Size();
+
+			const float SubSectionMaxExtend = ComponentMaxExtend / 2.0f;
+			const FVector ComponentTopLeftCorner = Component.Origin - FVector(SubSectionMaxExtend, SubSectionMaxExtend, 0.0f);
+			for (int32 SubSectionIndex = 0; SubSectionIndex < 4; SubSectionIndex++)
+			{
+				const int32 SubX = SubSectionIndex % 2;
+				const int32 SubY = SubSectionIndex / 2;
+				Component.SubSectionOrigins[SubSectionIndex] = ComponentTopLeftCorner + FVector(ComponentMaxExtend * SubX, ComponentMaxExtend * SubY, 0.0f);
+			}
+		}
+	}
+}
+
+FCyLandLODSimulationFrame FCyLandLODSimulation::SimulateFrame(const FCyLandCameraSample& Camera) const
+{
+	FCyLandLODSimulationFrame Frame;
+	Frame.LODHistogram.SetNumZeroed(LastLOD + 1);
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Same matrices a player camera ends up with
+	const FMatrix ViewRotationMatrix = FInverseRotationMatrix(Camera.Rotation) * FMatrix(
+		FPlane(0, 0, 1, 0),
+		FPlane(1, 0, 0, 0),
+		FPlane(0, 1, 0, 0),
+		FPlane(0, 0, 0, 1));
+	const float HalfFOV = FMath::DegreesToRadians(FMath::Clamp(Camera.FOV, 1.0f, 170.0f) * 0.5f);
+	const FMatrix ProjectionMatrix = FReversedZPerspectiveMatrix(HalfFOV, HalfFOV, 1.0f, Settings.AspectRatio, GNearClippingPlane, GNearClippingPlane);
+	const float ScreenMultiple = CyLandLODMath::GetScreenMultiple(ProjectionMatrix);
+
+	FConvexVolume Frustum;
+	GetViewFrustumBounds(Frustum, FTranslationMatrix(-Camera.Location) * ViewRotationMatrix * ProjectionMatrix, false);
+
+	const float ComponentSquaredScreenSizeToUseSubSections = FMath::Square(Settings.ComponentScreenSizeToUseSubSections);
+	const float TessellationComponentSquaredScreenSize = FMath::Square(Settings.TessellationComponentScreenSize);
+	const float PreferedLOD = (float)Settings.ForcedLOD;
+	const float MinLOD = FMath::Max(0.0f, MinValidLOD);
+	const float MaxLODClamp = FMath::Min((float)LastLOD, MaxValidLOD);
+	const int32 NumSubSections = FMath::Square(Settings.NumSubsections);
+	const int32 SubsectionSizeVerts = Settings.SubsectionSizeQuads + 1;
+
+	for (const FComponent& Component : Components)
+	{
+		if (Settings.bFrustumCull && !Frustum.IntersectBox(Component.Origin, Component.Box.GetExtent()))
+		{
+			continue;
+		}
+
+		Frame.NumVisible++;
+
+		// FCyLandComponentSceneProxy::CalculateBatchElementLOD
+		const float ComponentScreenSize = CyLandLODMath::GetComponentScreenSize(Camera.Location, ScreenMultiple, Component.Origin, ComponentMaxExtend, Component.SphereRadius);
+		int32 SubSectionLODs[4];
+		bool bCombined = true;
+
+		if (Settings.NumSubsections > 1)
+		{
+			float SubSectionScreenSizes[4];
+			for (int32 SubSectionIndex = 0; SubSectionIndex < NumSubSections; SubSectionIndex++)
+			{
+				SubSectionScreenSizes[SubSectionIndex] = CyLandLODMath::GetComponentScreenSize(Camera.Location, ScreenMultiple, Component.SubSectionOrigins[SubSectionIndex], ComponentMaxExtend / 2.0f, Component.SphereRadius / 2.0f);
+				SubSectionLODs[SubSectionIndex] = FMath::FloorToInt(CyLandLODMath::GetBiasedLOD(LODScreenRatioSquared, SubSectionScreenSizes[SubSectionIndex], Settings.ViewLODScale, PreferedLOD, Settings.LODBias, MinLOD, MaxLODClamp));
+			}
+
+			if (Settings.ForcedLOD == INDEX_NONE && CyLandLODMath::UseSubSectionLODs(ComponentScreenSize, ComponentSquaredScreenSizeToUseSubSections, Settings.ViewLODScale))
+			{
+				bCombined = CyLandLODMath::SubSectionsHaveSameScreenSize(SubSectionScreenSizes, NumSubSections, Settings.ViewLODScale);
+			}
+
+			if (bCombined)
+			{
+				const int32 CombinedLOD = FMath::Min(FMath::Min(SubSectionLODs[0], SubSectionLODs[1]), FMath::Min(SubSectionLODs[2], SubSectionLODs[3]));
+				for (int32 SubSectionIndex = 0; SubSectionIndex < NumSubSections; SubSectionIndex++)
+				{
+					SubSectionLODs[SubSectionIndex] = CombinedLOD;
+				}
+			}
+		}
+		else
+		{
+			SubSectionLODs[0] = FMath::FloorToInt(CyLandLODMath::GetBiasedLOD(LODScreenRatioSquared, ComponentScreenSize, Settings.ViewLODScale, PreferedLOD, Settings.LODBias, MinLOD, MaxLODClamp));
+		}
+
+		Frame.NumCombined += bCombined ? 1 : 0;
+		Frame.NumTessellated += CyLandLODMath::UseTessellation(ComponentScreenSize, TessellationComponentSquaredScreenSize, Settings.ViewLODScale) ? 1 : 0;
+
+		for (int32 SubSectionIndex = 0; SubSectionIndex < NumSubSections; SubSectionIndex++)
+		{
+			const int32 LOD = FMath::Clamp(SubSectionLODs[SubSectionIndex], 0, LastLOD);
+			Frame.LODHistogram[LOD]++;
+			Frame.NumTriangles += CyLandLODMath::GetSubSectionTriangleCount(SubsectionSizeVerts, LOD);
+		}
+	}
+
+	Frame.DecisionSeconds = FPlatformTime::Seconds() - StartTime;
+	return Frame;
+}
+
+FCyLandLODSimulationReport FCyLandLODSimulation::Run(const FCyLandCameraPath& Path) const
+{
+	FCyLandLODSimulationReport Report;
+	Report.Frames.Reserve(Path.Samples.Num());
+	for (const FCyLandCameraSample& Sample : Path.Samples)
+	{
+		Report.Frames.Add(SimulateFrame(Sample));
+	}
+	return Report;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace CyLandLODSimulationCommands
+{
+	static FString GetDefaultDirectory()
+	{
+		return FPaths::ProfilingDir() / TEXT("CyLandLODSimulation");
+	}
+
+	static void Simulate(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const FString Cmd = FString::Join(Args, TEXT(" "));
+
+		FCyLandLODSimulationSettings Settings;
+		int32 NumComponents = Settings.NumComponents.X;
+		FParse::Value(*Cmd, TEXT("Components="), NumComponents);
+		NumComponents = FMath::Clamp(NumComponents, 1, 1024);
+		Settings.NumComponents = FIntPoint(NumComponents, NumComponents);
+		FParse::Value(*Cmd, TEXT("SubsectionQuads="), Settings.SubsectionSizeQuads);
+		FParse::Value(*Cmd, TEXT("Subsections="), Settings.NumSubsections);
+		FParse::Value(*Cmd, TEXT("LOD0Distribution="), Settings.LOD0DistributionSetting);
+		FParse::Value(*Cmd, TEXT("LODDistribution="), Settings.LODDistributionSetting);
+		FParse::Value(*Cmd, TEXT("SubSectionScreenSize="), Settings.ComponentScreenSizeToUseSubSections);
+		FParse::Value(*Cmd, TEXT("TessellationScreenSize="), Settings.TessellationComponentScreenSize);
+		FParse::Value(*Cmd, TEXT("MaxLOD="), Settings.MaxLODLevel);
+		FParse::Value(*Cmd, TEXT("Bias="), Settings.LODBias);
+		FParse::Value(*Cmd, TEXT("ForcedLOD="), Settings.ForcedLOD);
+		FParse::Value(*Cmd, TEXT("LODScale="), Settings.ViewLODScale);
+		Settings.bFrustumCull = !FParse::Param(*Cmd, TEXT("NoCull"));
+
+		const FCyLandLODSimulation Simulation(Settings);
+
+		FCyLandCameraPath Path;
+		FString PathFilename;
+		if (FParse::Value(*Cmd, TEXT("Path="), PathFilename))
+		{
+			if (!Path.LoadFromFile(PathFilename))
+			{
+				Ar.Logf(ELogVerbosity::Error, TEXT("Couldn't read a camera path from %s"), *PathFilename);
+				return;
+			}
+		}
+		else
+		{
+			int32 NumSamples = 600;
+			FParse::Value(*Cmd, TEXT("Samples="), NumSamples);
+			const float Size = Settings.NumComponents.X * Settings.SubsectionSizeQuads * Settings.NumSubsections * Settings.Scale.X;
+			Path = FCyLandCameraPath::MakeFlyover(Size, Settings.HeightRange, FMath::Max(NumSamples, 1));
+		}
+
+		const FCyLandLODSimulationReport Report = Simulation.Run(Path);
+
+		FString ReportFilename = GetDefaultDirectory() / FString::Printf(TEXT("Report-%s.csv"), *FDateTime::Now().ToString());
+		FParse::Value(*Cmd, TEXT("Report="), ReportFilename);
+		const bool bSaved = Report.SaveToFile(ReportFilename);
+
+		Ar.Logf(TEXT("CyLand LOD simulation, %dx%d components of %dx%d sub-sections of %d quads, max LOD %d\n%s\nPer frame report %s %s"),
+			Settings.NumComponents.X, Settings.NumComponents.Y, Settings.NumSubsections, Settings.NumSubsections, Settings.SubsectionSizeQuads, Simulation.GetMaxLOD(),
+			*Report.GetSummary(), bSaved ? TEXT("saved to") : TEXT("couldn't be saved to"), *ReportFilename);
+	}
+
+	static FCyLandCameraPath RecordedPath;
+	static FString RecordFilename;
+	static FDelegateHandle RecordTickerHandle;
+	static double RecordStartTime = 0.0;
+
+	/** Samples the camera of the first local player of the first game world */
+	static bool RecordCamera(float DeltaTime)
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			UWorld* World = Context.World();
+			APlayerController* PlayerController = (World && World->IsGameWorld()) ? World->GetFirstPlayerController() : nullptr;
+			if (PlayerController && PlayerController->PlayerCameraManager)
+			{
+				FCyLandCameraSample& Sample = RecordedPath.Samples.AddDefaulted_GetRef();
+				Sample.Time = FPlatformTime::Seconds() - RecordStartTime;
+				Sample.Location = PlayerController->PlayerCameraManager->GetCameraLocation();
+				Sample.Rotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+				Sample.FOV = PlayerController->PlayerCameraManager->GetFOVAngle();
+				break;
+			}
+		}
+		return true;
+	}
+
+	static void Record(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		if (RecordTickerHandle.IsValid())
+		{
+			FTicker::GetCoreTicker().RemoveTicker(RecordTickerHandle);
+			RecordTickerHandle.Reset();
+
+			const bool bSaved = RecordedPath.SaveToFile(RecordFilename);
+			Ar.Logf(TEXT("Recorded %d camera samples, %s %s"), RecordedPath.Samples.Num(), bSaved ? TEXT("saved to") : TEXT("couldn't be saved to"), *RecordFilename);
+			RecordedPath.Samples.Empty();
+			return;
+		}
+
+		RecordFilename = Args.Num() > 0 ? Args[0] : GetDefaultDirectory() / FString::Printf(TEXT("CameraPath-%s.csv"), *FDateTime::Now().ToString());
+		RecordStartTime = FPlatformTime::Seconds();
+		RecordTickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&RecordCamera));
+		Ar.Logf(TEXT("Recording the player camera, run CyLand.LODSimulation.Record again to stop"));
+	}
+
+	static FAutoConsoleCommand SimulateCmd(
+		TEXT("CyLand.LODSimulation"),
+		TEXT("Replay a camera path over a synthetic landscape with the CyLand LOD math and report LODs, triangles and decision time per frame. ")
+		TEXT("Args: [Path=CameraPath.csv, default a flyover] [Samples=600] [Report=Report.csv] [Components=32] [Subsections=1] [SubsectionQuads=63] ")
+		TEXT("[LOD0Distribution=1.75] [LODDistribution=2] [SubSectionScreenSize=0.65] [TessellationScreenSize=0.8] [MaxLOD=-1] [Bias=0] [ForcedLOD=-1] [LODScale=1] [-NoCull]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&Simulate));
+
+	static FAutoConsoleCommand RecordCmd(
+		TEXT("CyLand.LODSimulation.Record"),
+		TEXT("Start or stop recording the player camera into a path for CyLand.LODSimulation. Args: [Filename]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&Record));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,294 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLODSolver.cpp: Per-view LOD selection of all the components of a CyLand
+=============================================================================*/
+
+#include "CyLandLODSolver.h"
+#include "CyLandComponent.h"
+#include "CyLandLODMath.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "SceneView.h"
+
+DECLARE_CYCLE_STAT(TEXT("LOD Solver"), STAT_CyLandLODSolver, STATGROUP_Landscape);
+
+int32 GCyLandLODSolver = 1;
+static FAutoConsoleVariableRef CVarCyLandLODSolver(
+	TEXT("r.CyLandLODSolver"),
+	GCyLandLODSolver,
+	TEXT("1: Solve the LODs of all landscape components of a view in one pass; 0: Every component computes its own and its neighbors' LODs")
+);
+
+TMap<FCyLandNeighborInfo::FCyLandKey, FCyLandLODSolver*> FCyLandLODSolver::Solvers;
+
+bool FCyLandLODSolver::IsEnabled()
+{
+	return GCyLandLODSolver != 0;
+}
+
+void FCyLandLODSolver::Register(FCyLandComponentSceneProxy* Proxy)
+{
+	check(IsInRenderingThread());
+
+	if (Proxy->LODSolver != nullptr)
+	{
+		return;
+	}
+
+	FCyLandLODSolver*& Solver = Solvers.FindOrAdd(Proxy->CyLandKey);
+	if (Solver == nullptr)
+	{
+		Solver = new FCyLandLODSolver();
+	}
+
+	// Solve and Find can still be running on the tasks of a view
+	FScopeLock ScopeLock(&Solver->Lock);
+
+	Proxy->LODSolver = Solver;
+	Proxy->LODSolverSlot = Solver->Proxies.Add(Proxy);
+
+	const int32 NumElements = Align(Solver->Proxies.Num() * ElementsPerSlot, 4);
+	for (TArray<float>* Array : { &Solver->OriginX, &Solver->OriginY, &Solver->OriginZ, &Solver->MaxExtend, &Solver->Radius })
+	{
+		Array->SetNumZeroed(NumElements);
+	}
+
+	Solver->PackBounds(Proxy->LODSolverSlot);
+
+	// Slots changed, the LODs solved so far this frame are stale
+	Solver->ViewLODs.Empty();
+}
+
+void FCyLandLODSolver::Unregister(FCyLandComponentSceneProxy* Proxy)
+{
+	check(IsInRenderingThread());
+
+	FCyLandLODSolver* Solver = Proxy->LODSolver;
+	if (Solver == nullptr)
+	{
+		return;
+	}
+
+	bool bEmpty;
+	{
+		FScopeLock ScopeLock(&Solver->Lock);
+
+		const int32 Slot = Proxy->LODSolverSlot;
+		check(Solver->Proxies[Slot] == Proxy);
+		Proxy->LODSolver = nullptr;
+		Proxy->LODSolverSlot = INDEX_NONE;
+
+		// Move the last proxy into the free slot
+		Solver->Proxies.RemoveAtSwap(Slot);
+		if (Slot < Solver->Proxies.Num())
+		{
+			Solver->Proxies[Slot]->LODSolverSlot = Slot;
+			Solver->PackBounds(Slot);
+		}
+
+		const int32 NumElements = Align(Solver->Proxies.Num() * ElementsPerSlot, 4);
+		for (TArray<float>* Array : { &Solver->OriginX, &Solver->OriginY, &Solver->OriginZ, &Solver->MaxExtend, &Solver->Radius })
+		{
+			Array->SetNum(NumElements);
+			// Padding lanes have no radius and so no screen size
+			FMemory::Memzero(Array->GetData() + Solver->Proxies.Num() * ElementsPerSlot, (NumElements - Solver->Proxies.Num() * ElementsPerSlot) * sizeof(float));
+		}
+
+		Solver->ViewLODs.Empty();
+		bEmpty = Solver->Proxies.Num() == 0;
+	}
+
+	// The lock lives in the solver, it's released before the solver is deleted
+	if (bEmpty)
+	{
+		Solvers.Remove(Proxy->CyLandKey);
+		delete Solver;
+	}
+}
+
+void FCyLandLODSolver::UpdateBounds(const FCyLandComponentSceneProxy* Proxy)
+{
+	check(IsInRenderingThread());
+
+	FScopeLock ScopeLock(&Lock);
+	check(Proxies[Proxy->LODSolverSlot] == Proxy);
+
+	PackBounds(Proxy->LODSolverSlot);
+	ViewLODs.Empty();
+}
+
+void FCyLandLODSolver::PackBounds(int32 Slot)
+{
+	const FCyLandComponentSceneProxy* Proxy = Proxies[Slot];
+	const FBoxSphereBounds& Bounds = Proxy->CyLandComponent->Bounds;
+
+	// Same origins, extents and radii GetComponentScreenSize is called with by CalculateBatchElementLOD
+	const int32 Base = Slot * ElementsPerSlot;
+	OriginX[Base] = Bounds.Origin.X;
+	OriginY[Base] = Bounds.Origin.Y;
+	OriginZ[Base] = Bounds.Origin.Z;
+	MaxExtend[Base] = Proxy->ComponentMaxExtend;
+	Radius[Base] = Bounds.SphereRadius;
+
+	for (int32 SubSectionIndex = 0; SubSectionIndex < FCyLandComponentSceneProxy::MAX_SUBSECTION_COUNT; SubSectionIndex++)
+	{
+		const int32 Element = Base + 1 + SubSectionIndex;
+		if (Proxy->NumSubsections > 1)
+		{
+			const FVector& Origin = Proxy->SubSectionScreenSizeTestingPosition[SubSectionIndex];
+			OriginX[Element] = Origin.X;
+			OriginY[Element] = Origin.Y;
+			OriginZ[Element] = Origin.Z;
+			MaxExtend[Element] = Proxy->ComponentMaxExtend / 2.0f;
+			Radius[Element] = Bounds.SphereRadius / 2.0f;
+		}
+		else
+		{
+			OriginX[Element] = OriginX[Base];
+			OriginY[Element] = OriginY[Base];
+			OriginZ[Element] = OriginZ[Base];
+			MaxExtend[Element] = MaxExtend[Base];
+			Radius[Element] = Radius[Base];
+		}
+	}
+}
+
+float FCyLandLODSolver::GetScreenMultiple(const FSceneView& View)
+{
+	return CyLandLODMath::GetScreenMultiple(View.ViewMatrices.GetProjectionMatrix());
+}
+
+bool FCyLandLODSolver::FViewLODs::Matches(const FSceneView& InView, const FVector& InViewOrigin, float InScreenMultiple, float InViewLODScale) const
+{
+	// Views are transient, a new view of another renderer can reuse the address within a frame
+	return View == &InView && FrameNumber == GFrameNumberRenderThread && ViewOrigin == InViewOrigin && ScreenMultiple == InScreenMultiple && ViewLODScale == InViewLODScale;
+}
+
+void FCyLandLODSolver::SolveScreenSizes(const FVector& ViewOrigin, float ScreenMultiple, TArray<float>& OutScreenSizes) const
+{
+	// CyLandLODMath::GetComponentScreenSize, four elements at a time
+	const VectorRegister ViewX = VectorSetFloat1(ViewOrigin.X);
+	const VectorRegister ViewY = VectorSetFloat1(ViewOrigin.Y);
+	const VectorRegister ViewZ = VectorSetFloat1(ViewOrigin.Z);
+	const VectorRegister Multiple = VectorSetFloat1(ScreenMultiple);
+	const VectorRegister One = VectorOne();
+	const VectorRegister Two = VectorSetFloat1(2.0f);
+
+	const int32 NumElements = OriginX.Num();
+	OutScreenSizes.SetNumUninitialized(NumElements);
+	for (int32 Index = 0; Index < NumElements; Index += 4)
+	{
+		const VectorRegister Extend = VectorLoad(&MaxExtend[Index]);
+		const VectorRegister ToViewX = VectorAbs(VectorSubtract(ViewX, VectorLoad(&OriginX[Index])));
+		const VectorRegister ToViewY = VectorAbs(VectorSubtract(ViewY, VectorLoad(&OriginY[Index])));
+		const VectorRegister ToViewZ = VectorAbs(VectorSubtract(ViewZ, VectorLoad(&OriginZ[Index])));
+		const VectorRegister DeltaX = VectorSubtract(ToViewX, VectorMin(ToViewX, Extend));
+		const VectorRegister DeltaY = VectorSubtract(ToViewY, VectorMin(ToViewY, Extend));
+		const VectorRegister DeltaZ = VectorSubtract(ToViewZ, VectorMin(ToViewZ, Extend));
+		const VectorRegister DistSquared = VectorAdd(VectorAdd(VectorMultiply(DeltaX, DeltaX), VectorMultiply(DeltaY, DeltaY)), VectorMultiply(DeltaZ, DeltaZ));
+
+		const VectorRegister ScreenRadius = VectorMultiply(Multiple, VectorLoad(&Radius[Index]));
+		const VectorRegister SquaredScreenRadius = VectorDivide(VectorMultiply(ScreenRadius, ScreenRadius), VectorMax(One, DistSquared));
+		VectorStore(VectorMin(VectorMultiply(SquaredScreenRadius, Two), One), &OutScreenSizes[Index]);
+	}
+}
+
+FCyLandComponentLOD FCyLandLODSolver::Solve(const FSceneView& View, float ViewLODScale, const FCyLandComponentSceneProxy* Proxy)
+{
+	const FVector ViewOrigin = View.ViewMatrices.GetViewOrigin();
+	const float ScreenMultiple = GetScreenMultiple(View);
+	const int32 Slot = Proxy->LODSolverSlot;
+
+	FViewLODsPtr Solved;
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		for (const FViewLODsPtr& Existing : ViewLODs)
+		{
+			if (Existing->Matches(View, ViewOrigin, ScreenMultiple, ViewLODScale))
+			{
+				Solved = Existing;
+				break;
+			}
+		}
+
+		if (!Solved.IsValid())
+		{
+			SCOPE_CYCLE_COUNTER(STAT_CyLandLODSolver);
+
+			// Results of previous frames aren't read anymore
+			ViewLODs.RemoveAll([](const FViewLODsPtr& Existing) { return Existing->FrameNumber != GFrameNumberRenderThread; });
+
+			Solved = MakeShareable(new FViewLODs());
+			Solved->View = &View;
+			Solved->FrameNumber = GFrameNumberRenderThread;
+			Solved->ViewOrigin = ViewOrigin;
+			Solved->ScreenMultiple = ScreenMultiple;
+			Solved->ViewLODScale = ViewLODScale;
+			SolveScreenSizes(ViewOrigin, ScreenMultiple, Solved->ScreenSizes);
+			Solved->LODs.SetNumUninitialized(Proxies.Num());
+			Solved->SlotStates.SetNumZeroed(Proxies.Num());
+			ViewLODs.Add(Solved);
+		}
+	}
+
+	// The view LODs are shared, a proxy registering meanwhile only drops them from the list
+	volatile int32* SlotState = (volatile int32*)&Solved->SlotStates[Slot];
+	if (FPlatformAtomics::AtomicRead(SlotState) == SlotSolved)
+	{
+		return Solved->LODs[Slot];
+	}
+
+	// The screen size to LOD mapping depends on the settings, streaming state and debug overrides of the proxy
+	const float* ElementScreenSizes = &Solved->ScreenSizes[Slot * ElementsPerSlot];
+	FCyLandComponentSceneProxy::FViewCustomDataLOD Scratch;
+	FCyLandComponentLOD LOD;
+	LOD.ScreenSizeSquared = ElementScreenSizes[0];
+	for (int32 SubSectionIndex = 0; SubSectionIndex < FCyLandComponentSceneProxy::MAX_SUBSECTION_COUNT; SubSectionIndex++)
+	{
+		const bool bSubSection = Proxy->NumSubsections > 1;
+		LOD.SubSectionScreenSizeSquared[SubSectionIndex] = bSubSection ? ElementScreenSizes[1 + SubSectionIndex] : LOD.ScreenSizeSquared;
+
+		if (bSubSection || SubSectionIndex == 0)
+		{
+			Proxy->CalculateLODFromScreenSize(View, LOD.SubSectionScreenSizeSquared[SubSectionIndex], ViewLODScale, SubSectionIndex, Scratch);
+			LOD.SubSectionLOD[SubSectionIndex] = Scratch.SubSections[SubSectionIndex].fBatchElementCurrentLOD;
+		}
+		else
+		{
+			LOD.SubSectionLOD[SubSectionIndex] = LOD.SubSectionLOD[0];
+		}
+	}
+
+	// Publish for the neighbor lookups, unless another task of the view got there first
+	if (FPlatformAtomics::InterlockedCompareExchange(SlotState, SlotWriting, SlotUnsolved) == SlotUnsolved)
+	{
+		Solved->LODs[Slot] = LOD;
+		FPlatformAtomics::InterlockedExchange(SlotState, SlotSolved);
+	}
+
+	return LOD;
+}
+
+bool FCyLandLODSolver::Find(const FSceneView& View, float ViewLODScale, int32 Slot, FCyLandComponentLOD& OutLOD) const
+{
+	const FVector ViewOrigin = View.ViewMatrices.GetViewOrigin();
+	const float ScreenMultiple = GetScreenMultiple(View);
+
+	FScopeLock ScopeLock(&Lock);
+	for (const FViewLODsPtr& Existing : ViewLODs)
+	{
+		if (Existing->Matches(View, ViewOrigin, ScreenMultiple, ViewLODScale))
+		{
+			// Culled proxies never solve their LODs, the caller computes them
+			if (Existing->SlotStates.IsValidIndex(Slot) && FPlatformAtomics::AtomicRead((volatile const int32*)&Existing->SlotStates[Slot]) == SlotSolved)
+			{
+				OutLOD = Existing->LODs[Slot];
+				return true;
+			}
+			return false;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,108 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLODSolver.h: Per-view LOD selection of all the components of a CyLand
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CyLandRender.h"
+
+/** Solved screen sizes and LODs of one component for a view */
+struct FCyLandComponentLOD
+{
+	float ScreenSizeSquared;
+
+	/** Sub-section 0 is the whole component when it has no sub-sections */
+	float SubSectionScreenSizeSquared[FCyLandComponentSceneProxy::MAX_SUBSECTION_COUNT];
+	float SubSectionLOD[FCyLandComponentSceneProxy::MAX_SUBSECTION_COUNT];
+};
+
+/**
+ * Computes the screen sizes and LODs of every component of a landscape for a view at once, instead of every proxy
+ * doing it in InitViewCustomData and again for each of its neighbors that has no custom data in PostInitViewCustomData.
+ *
+ * Proxies register the bounds of the component and of its sub-sections into packed SoA arrays. The first proxy of the
+ * landscape to initialize its custom data for a view solves the screen sizes of all of them four at a time with
+ * VectorRegister. Each visible proxy then maps its own screen sizes to LODs outside of the lock, so the parallel view
+ * tasks don't wait on each other and culled components cost nothing past their screen size. The results live until
+ * the next frame, neighbor lookups read the LODs of the visible proxies and compute the others themselves.
+ *
+ * Registration happens on the render thread, solving and reading from the parallel visibility and mesh command tasks.
+ */
+class FCyLandLODSolver
+{
+public:
+	/** Whether InitViewCustomData should go through the solver, r.CyLandLODSolver */
+	static bool IsEnabled();
+
+	/** Add a proxy to the solver of its landscape */
+	static void Register(FCyLandComponentSceneProxy* Proxy);
+
+	/** Remove a proxy from its solver, deleting the solver with its last proxy */
+	static void Unregister(FCyLandComponentSceneProxy* Proxy);
+
+	/** Repack the bounds of a proxy after it moved */
+	void UpdateBounds(const FCyLandComponentSceneProxy* Proxy);
+
+	/** LODs of the component of Proxy for the view, solving the screen sizes of all components the first time the view asks this frame */
+	FCyLandComponentLOD Solve(const FSceneView& View, float ViewLODScale, const FCyLandComponentSceneProxy* Proxy);
+
+	/** LODs of the component in Slot if its proxy solved them for the view and LOD scale this frame */
+	bool Find(const FSceneView& View, float ViewLODScale, int32 Slot, FCyLandComponentLOD& OutLOD) const;
+
+private:
+	/** Component bounds followed by the bounds of its sub-sections */
+	enum { ElementsPerSlot = 1 + FCyLandComponentSceneProxy::MAX_SUBSECTION_COUNT };
+
+	/** State of a slot of FViewLODs::LODs */
+	enum ESlotState
+	{
+		SlotUnsolved,
+		SlotWriting,
+		SlotSolved,
+	};
+
+	struct FViewLODs
+	{
+		const FSceneView* View;
+		uint32 FrameNumber;
+		FVector ViewOrigin;
+		float ScreenMultiple;
+		float ViewLODScale;
+
+		/** Screen sizes of all the elements, written under the lock before the view LODs are shared */
+		TArray<float> ScreenSizes;
+
+		/** LODs of the slots whose proxy solved them, SlotStates are ESlotState changed with atomics */
+		TArray<FCyLandComponentLOD> LODs;
+		TArray<int32> SlotStates;
+
+		bool Matches(const FSceneView& InView, const FVector& InViewOrigin, float InScreenMultiple, float InViewLODScale) const;
+	};
+
+	typedef TSharedPtr<FViewLODs, ESPMode::ThreadSafe> FViewLODsPtr;
+
+	void PackBounds(int32 Slot);
+	void SolveScreenSizes(const FVector& ViewOrigin, float ScreenMultiple, TArray<float>& OutScreenSizes) const;
+
+	static float GetScreenMultiple(const FSceneView& View);
+
+	/** Proxies by slot */
+	TArray<FCyLandComponentSceneProxy*> Proxies;
+
+	/** Bounds of the components and their sub-sections, ElementsPerSlot per slot padded to a multiple of 4 */
+	TArray<float> OriginX;
+	TArray<float> OriginY;
+	TArray<float> OriginZ;
+	TArray<float> MaxExtend;
+	TArray<float> Radius;
+
+	/** Guards the slots, the packed bounds and the list of solved views, the render thread mutators race the view tasks */
+	mutable FCriticalSection Lock;
+	TArray<FViewLODsPtr> ViewLODs;
+
+	/** Solvers by landscape, render thread only */
+	static TMap<FCyLandNeighborInfo::FCyLandKey, FCyLandLODSolver*> Solvers;
+};
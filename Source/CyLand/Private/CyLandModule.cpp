@@ -20,6 +20,8 @@
 #include "CyLand.h"
 #include "Engine/Texture2D.h"
 #include "Misc/Paths.h"
+#include "Misc/CoreDelegates.h"
+#include "CyLandSharedBuffersPool.h"
 
 DEFINE_LOG_CATEGORY_STATIC(CYLOG, Warning, All);
 
@@ -257,6 +259,16 @@ void FCyLandModule::StartupModule()
 	FWorldDelegates::OnPostDuplicate.AddStatic(
 		&WorldDuplicateEventFunction
 	);
+
+	// Expire the shared buffers kept idle for streaming even when no proxy is added or released
+	FCoreDelegates::OnEndFrameRT.AddStatic(
+		&FCyLandSharedBuffersPool::TickEndOfFrame
+	);
+
+	// Free the shared buffers kept idle for streaming before the renderer goes away
+	FCoreDelegates::OnEnginePreExit.AddStatic(
+		&FCyLandSharedBuffersPool::EnqueueShutdown
+	);
 }
 
 void FCyLandModule::ShutdownModule()
@@ -0,0 +1,278 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandNoise.cpp: Octave Perlin noise evaluated eight samples at a time
+=============================================================================*/
+
+#include "CyLandNoise.h"
+
+namespace CyLandNoise
+{
+	static const int32 Permutations[256] =
+	{
+		151, 160, 137, 91, 90, 15,
+		131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
+		190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
+		88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
+		77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
+		102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
+		135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
+		5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
+		223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+		129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
+		251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
+		49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
+		138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
+	};
+
+	/**
+	 * Gradients of the 16 hashes as factors of X and Y: the per-sample code picks U among X and Y, V among Y and 0,
+	 * and negates them with the low bits of the hash
+	 */
+	struct FGradientTable
+	{
+		float X[16];
+		float Y[16];
+
+		FGradientTable()
+		{
+			for (int32 Hash = 0; Hash < 16; Hash++)
+			{
+				const bool bUIsX = Hash < 8 || Hash == 12 || Hash == 13;
+				const bool bVIsY = Hash < 4 || Hash == 12 || Hash == 13;
+				const float USign = (Hash & 1) == 0 ? 1.0f : -1.0f;
+				const float VSign = (Hash & 2) == 0 ? 1.0f : -1.0f;
+				X[Hash] = bUIsX ? USign : 0.0f;
+				Y[Hash] = (bUIsX ? 0.0f : USign) + (bVIsY ? VSign : 0.0f);
+			}
+		}
+	};
+	static const FGradientTable Gradients;
+
+	/** Offset of the second warp noise, so both displacement axes are not the same noise */
+	static const float WarpOffset = 131.7f;
+
+	FORCEINLINE float Fade(float T)
+	{
+		return T * T * T * (T * (T * 6 - 15) + 10);
+	}
+
+	FORCEINLINE VectorRegister VectorFade(const VectorRegister& T)
+	{
+		const VectorRegister T3 = VectorMultiply(VectorMultiply(T, T), T);
+		const VectorRegister Inner = VectorAdd(VectorMultiply(T, VectorSubtract(VectorMultiply(T, VectorSetFloat1(6.0f)), VectorSetFloat1(15.0f))), VectorSetFloat1(10.0f));
+		return VectorMultiply(T3, Inner);
+	}
+
+	FORCEINLINE VectorRegister VectorLerp(const VectorRegister& A, const VectorRegister& B, const VectorRegister& Alpha)
+	{
+		return VectorAdd(A, VectorMultiply(Alpha, VectorSubtract(B, A)));
+	}
+
+	FORCEINLINE float Grad(int32 Hash, float X, float Y)
+	{
+		return Gradients.X[Hash & 15] * X + Gradients.Y[Hash & 15] * Y;
+	}
+}
+
+FCyLandNoise::FCyLandNoise(float InScale, float InAmount, float InBase, int32 InNumOctaves)
+	: Base(InBase)
+	, Amount(InAmount)
+	, NumOctaves(FMath::Clamp<int32>(InNumOctaves, 0, MaxOctaves))
+	, WarpScale(0.0f)
+	, WarpAmount(0.0f)
+{
+	// No noise at all when the scale is too small, as with FNoiseParameter
+	if (InScale <= DELTA)
+	{
+		NumOctaves = 0;
+	}
+
+	for (int32 Octave = 0; Octave < NumOctaves; Octave++)
+	{
+		const float OctaveShift = 1 << Octave;
+		OctaveScales[Octave] = OctaveShift / InScale;
+		OctaveAmplitudes[Octave] = 1.0f / OctaveShift;
+	}
+}
+
+void FCyLandNoise::SetDomainWarp(float InWarpScale, float InWarpAmount)
+{
+	const bool bWarp = InWarpScale > DELTA && InWarpAmount != 0.0f;
+	WarpScale = bWarp ? 1.0f / InWarpScale : 0.0f;
+	WarpAmount = bWarp ? InWarpAmount : 0.0f;
+}
+
+float FCyLandNoise::PerlinNoise2D(float X, float Y)
+{
+	using namespace CyLandNoise;
+
+	const int32 FloorX = FMath::FloorToInt(X);
+	const int32 FloorY = FMath::FloorToInt(Y);
+	const int32 IntX = FloorX & 255;
+	const int32 IntY = FloorY & 255;
+	const float FracX = X - FloorX;
+	const float FracY = Y - FloorY;
+
+	const float U = Fade(FracX);
+	const float V = Fade(FracY);
+
+	const int32 A = Permutations[IntX] + IntY;
+	const int32 AA = Permutations[A & 255];
+	const int32 AB = Permutations[(A + 1) & 255];
+	const int32 B = Permutations[(IntX + 1) & 255] + IntY;
+	const int32 BA = Permutations[B & 255];
+	const int32 BB = Permutations[(B + 1) & 255];
+
+	return FMath::Lerp(FMath::Lerp(Grad(Permutations[AA], FracX, FracY), Grad(Permutations[BA], FracX - 1, FracY), U),
+		FMath::Lerp(Grad(Permutations[AB], FracX, FracY - 1), Grad(Permutations[BB], FracX - 1, FracY - 1), U), V);
+}
+
+void FCyLandNoise::AddPerlinNoise8(const float* X, const float* Y, float Amplitude, float* InOutValues)
+{
+	using namespace CyLandNoise;
+
+	// Lattice lookups per sample, they don't vectorize
+	MS_ALIGN(16) float FracX[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float FracY[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float Gradient[8][NumSamplesPerCall] GCC_ALIGN(16);
+	for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+	{
+		// Floor rather than truncate, so the lattice doesn't repeat a cell at 0 and the noise stays continuous
+		const int32 FloorX = FMath::FloorToInt(X[Sample]);
+		const int32 FloorY = FMath::FloorToInt(Y[Sample]);
+		const int32 IntX = FloorX & 255;
+		const int32 IntY = FloorY & 255;
+		FracX[Sample] = X[Sample] - FloorX;
+		FracY[Sample] = Y[Sample] - FloorY;
+
+		const int32 A = Permutations[IntX] + IntY;
+		const int32 B = Permutations[(IntX + 1) & 255] + IntY;
+		const int32 Hashes[4] =
+		{
+			Permutations[Permutations[A & 255]] & 15,			// AA
+			Permutations[Permutations[B & 255]] & 15,			// BA
+			Permutations[Permutations[(A + 1) & 255]] & 15,	// AB
+			Permutations[Permutations[(B + 1) & 255]] & 15,	// BB
+		};
+		for (int32 Corner = 0; Corner < 4; Corner++)
+		{
+			Gradient[2 * Corner][Sample] = Gradients.X[Hashes[Corner]];
+			Gradient[2 * Corner + 1][Sample] = Gradients.Y[Hashes[Corner]];
+		}
+	}
+
+	const VectorRegister One = VectorOne();
+	const VectorRegister VAmplitude = VectorSetFloat1(Amplitude);
+	for (int32 Lane = 0; Lane < NumSamplesPerCall; Lane += 4)
+	{
+		const VectorRegister X0 = VectorLoadAligned(FracX + Lane);
+		const VectorRegister Y0 = VectorLoadAligned(FracY + Lane);
+		const VectorRegister X1 = VectorSubtract(X0, One);
+		const VectorRegister Y1 = VectorSubtract(Y0, One);
+
+		const auto Dot = [&](int32 Corner, const VectorRegister& CornerX, const VectorRegister& CornerY)
+		{
+			return VectorAdd(VectorMultiply(VectorLoadAligned(Gradient[2 * Corner] + Lane), CornerX), VectorMultiply(VectorLoadAligned(Gradient[2 * Corner + 1] + Lane), CornerY));
+		};
+
+		const VectorRegister U = VectorFade(X0);
+		const VectorRegister V = VectorFade(Y0);
+		const VectorRegister Noise = VectorLerp(
+			VectorLerp(Dot(0, X0, Y0), Dot(1, X1, Y0), U),
+			VectorLerp(Dot(2, X0, Y1), Dot(3, X1, Y1), U), V);
+
+		VectorStore(VectorMultiplyAdd(Noise, VAmplitude, VectorLoad(InOutValues + Lane)), InOutValues + Lane);
+	}
+}
+
+void FCyLandNoise::Sample8(const float* X, const float* Y, float* OutValues) const
+{
+	using namespace CyLandNoise;
+
+	MS_ALIGN(16) float WarpedX[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float WarpedY[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float OctaveX[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float OctaveY[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float Noise[NumSamplesPerCall] GCC_ALIGN(16) = { 0 };
+	FMemory::Memcpy(WarpedX, X, sizeof(WarpedX));
+	FMemory::Memcpy(WarpedY, Y, sizeof(WarpedY));
+
+	if (WarpAmount != 0.0f)
+	{
+		MS_ALIGN(16) float Displacement[2][NumSamplesPerCall] GCC_ALIGN(16) = { { 0 } };
+		for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+		{
+			OctaveX[Sample] = X[Sample] * WarpScale;
+			OctaveY[Sample] = Y[Sample] * WarpScale;
+		}
+		AddPerlinNoise8(OctaveX, OctaveY, WarpAmount, Displacement[0]);
+		for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+		{
+			OctaveX[Sample] += WarpOffset;
+			OctaveY[Sample] += WarpOffset;
+		}
+		AddPerlinNoise8(OctaveX, OctaveY, WarpAmount, Displacement[1]);
+		for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+		{
+			WarpedX[Sample] += Displacement[0][Sample];
+			WarpedY[Sample] += Displacement[1][Sample];
+		}
+	}
+
+	for (int32 Octave = 0; Octave < NumOctaves; Octave++)
+	{
+		for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+		{
+			OctaveX[Sample] = WarpedX[Sample] * OctaveScales[Octave];
+			OctaveY[Sample] = WarpedY[Sample] * OctaveScales[Octave];
+		}
+		AddPerlinNoise8(OctaveX, OctaveY, OctaveAmplitudes[Octave], Noise);
+	}
+
+	for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+	{
+		OutValues[Sample] = Base + Noise[Sample] * Amount;
+	}
+}
+
+void FCyLandNoise::SampleRow(int32 X, int32 Y, int32 Count, float* OutValues) const
+{
+	SampleRow(X, Y, Count, OutValues, false);
+}
+
+void FCyLandNoise::SampleRowMirrored(int32 X, int32 Y, int32 Count, float* OutValues) const
+{
+	SampleRow(X, Y, Count, OutValues, true);
+}
+
+void FCyLandNoise::SampleRow(int32 X, int32 Y, int32 Count, float* OutValues, bool bMirrored) const
+{
+	MS_ALIGN(16) float SampleX[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float SampleY[NumSamplesPerCall] GCC_ALIGN(16);
+	MS_ALIGN(16) float Values[NumSamplesPerCall] GCC_ALIGN(16);
+	for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+	{
+		SampleY[Sample] = bMirrored ? FMath::Abs(Y) : Y;
+	}
+
+	for (int32 First = 0; First < Count; First += NumSamplesPerCall)
+	{
+		const int32 NumSamples = FMath::Min<int32>(Count - First, NumSamplesPerCall);
+		for (int32 Sample = 0; Sample < NumSamplesPerCall; Sample++)
+		{
+			const int32 SampleIndex = X + First + FMath::Min(Sample, NumSamples - 1);
+			SampleX[Sample] = bMirrored ? FMath::Abs(SampleIndex) : SampleIndex;
+		}
+
+		Sample8(SampleX, SampleY, Values);
+		FMemory::Memcpy(OutValues + First, Values, NumSamples * sizeof(float));
+	}
+}
+
+float FCyLandNoise::Sample(int32 X, int32 Y) const
+{
+	float Value = 0.0f;
+	SampleRow(X, Y, 1, &Value);
+	return Value;
+}
@@ -0,0 +1,321 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandNormalKernel.cpp: Vectorized heightmap normal computation and packing
+=============================================================================*/
+
+#include "CyLandNormalKernel.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "CyLandDataAccess.h"
+#include "CyLandPrivate.h"
+
+namespace
+{
+	/** Normalize four vectors in place, vectors shorter than SMALL_NUMBER become zero as with GetSafeNormal */
+	FORCEINLINE void VectorSafeNormalize(VectorRegister& X, VectorRegister& Y, VectorRegister& Z)
+	{
+		const VectorRegister SquareSum = VectorMultiplyAdd(X, X, VectorMultiplyAdd(Y, Y, VectorMultiply(Z, Z)));
+		const VectorRegister NonZeroMask = VectorCompareGE(SquareSum, VectorSetFloat1(SMALL_NUMBER));
+		const VectorRegister Scale = VectorSelect(NonZeroMask, VectorReciprocalSqrtAccurate(VectorMax(SquareSum, VectorSetFloat1(SMALL_NUMBER))), VectorZero());
+		X = VectorMultiply(X, Scale);
+		Y = VectorMultiply(Y, Scale);
+		Z = VectorMultiply(Z, Scale);
+	}
+}
+
+void FCyLandNormalKernel::FFaceRow::Init(int32 NumPaddedQuads)
+{
+	X1.SetNumZeroed(NumPaddedQuads);
+	Y1.SetNumZeroed(NumPaddedQuads);
+	Z1.SetNumZeroed(NumPaddedQuads);
+	X2.SetNumZeroed(NumPaddedQuads);
+	Y2.SetNumZeroed(NumPaddedQuads);
+	Z2.SetNumZeroed(NumPaddedQuads);
+}
+
+FCyLandNormalKernel::FCyLandNormalKernel(const FVector& InDrawScale, int32 InMaxVertsX)
+	: DrawScale(InDrawScale)
+	, MaxVertsX(InMaxVertsX)
+{
+	check(MaxVertsX > 0);
+
+	for (int32 Index = 0; Index < 2; Index++)
+	{
+		ZRows[Index].SetNumUninitialized(MaxVertsX);
+		// One quad of zero padding on each side
+		FaceRows[Index].Init(MaxVertsX + 1);
+	}
+
+	NormalX.SetNumUninitialized(MaxVertsX);
+	NormalY.SetNumUninitialized(MaxVertsX);
+}
+
+void FCyLandNormalKernel::LoadHeights(const uint16* Heights, int32 NumVerts, float* OutZ) const
+{
+	const float ZScale = LANDSCAPE_ZSCALE * DrawScale.Z;
+	for (int32 X = 0; X < NumVerts; X++)
+	{
+		OutZ[X] = ((float)Heights[X] - 32768.0f) * ZScale;
+	}
+}
+
+void FCyLandNormalKernel::ComputeFaceRow(const float* Z0, const float* Z1, int32 NumQuads, FFaceRow& OutRow) const
+{
+	// With the quad corners at (0,0), (1,0), (0,1), (1,1) scaled by DrawScale the cross products reduce to:
+	// Face1 = (Sy * (Z00 - Z10), Sx * (Z10 - Z11), Sx * Sy)
+	// Face2 = (Sy * (Z01 - Z11), Sx * (Z00 - Z01), Sx * Sy)
+	const float Sx = DrawScale.X;
+	const float Sy = DrawScale.Y;
+	const float Sxy = Sx * Sy;
+
+	// Results are written shifted by one for the padding
+	float* RESTRICT OutX1 = OutRow.X1.GetData() + 1;
+	float* RESTRICT OutY1 = OutRow.Y1.GetData() + 1;
+	float* RESTRICT OutZ1 = OutRow.Z1.GetData() + 1;
+	float* RESTRICT OutX2 = OutRow.X2.GetData() + 1;
+	float* RESTRICT OutY2 = OutRow.Y2.GetData() + 1;
+	float* RESTRICT OutZ2 = OutRow.Z2.GetData() + 1;
+
+	const VectorRegister VSx = VectorSetFloat1(Sx);
+	const VectorRegister VSy = VectorSetFloat1(Sy);
+	const VectorRegister VSxy = VectorSetFloat1(Sxy);
+
+	int32 Quad = 0;
+	for (; Quad + 4 <= NumQuads; Quad += 4)
+	{
+		const VectorRegister Z00 = VectorLoad(Z0 + Quad);
+		const VectorRegister Z10 = VectorLoad(Z0 + Quad + 1);
+		const VectorRegister Z01 = VectorLoad(Z1 + Quad);
+		const VectorRegister Z11 = VectorLoad(Z1 + Quad + 1);
+
+		VectorRegister X1 = VectorMultiply(VSy, VectorSubtract(Z00, Z10));
+		VectorRegister Y1 = VectorMultiply(VSx, VectorSubtract(Z10, Z11));
+		VectorRegister W1 = VSxy;
+		VectorSafeNormalize(X1, Y1, W1);
+
+		VectorRegister X2 = VectorMultiply(VSy, VectorSubtract(Z01, Z11));
+		VectorRegister Y2 = VectorMultiply(VSx, VectorSubtract(Z00, Z01));
+		VectorRegister W2 = VSxy;
+		VectorSafeNormalize(X2, Y2, W2);
+
+		VectorStore(X1, OutX1 + Quad);
+		VectorStore(Y1, OutY1 + Quad);
+		VectorStore(W1, OutZ1 + Quad);
+		VectorStore(X2, OutX2 + Quad);
+		VectorStore(Y2, OutY2 + Quad);
+		VectorStore(W2, OutZ2 + Quad);
+	}
+
+	for (; Quad < NumQuads; Quad++)
+	{
+		const FVector Face1 = FVector(Sy * (Z0[Quad] - Z0[Quad + 1]), Sx * (Z0[Quad + 1] - Z1[Quad + 1]), Sxy).GetSafeNormal();
+		const FVector Face2 = FVector(Sy * (Z1[Quad] - Z1[Quad + 1]), Sx * (Z0[Quad] - Z1[Quad]), Sxy).GetSafeNormal();
+
+		OutX1[Quad] = Face1.X;
+		OutY1[Quad] = Face1.Y;
+		OutZ1[Quad] = Face1.Z;
+		OutX2[Quad] = Face2.X;
+		OutY2[Quad] = Face2.Y;
+		OutZ2[Quad] = Face2.Z;
+	}
+
+	// Trailing padding, the row may have been used for a wider grid before
+	OutX1[NumQuads] = OutY1[NumQuads] = OutZ1[NumQuads] = 0.0f;
+	OutX2[NumQuads] = OutY2[NumQuads] = OutZ2[NumQuads] = 0.0f;
+}
+
+void FCyLandNormalKernel::PackRow(const FFaceRow* Above, const FFaceRow* Below, const uint16* Heights, int32 NumVerts, FColor* OutTexels)
+{
+	// Vertex X gets both faces of quad X and face 1 of quad X-1 from the row below,
+	// and face 2 of quad X and both faces of quad X-1 from the row above.
+	// With the padding quad X is at index X+1 and quad X-1 at index X.
+	int32 Vert = 0;
+	for (; Vert + 4 <= NumVerts; Vert += 4)
+	{
+		VectorRegister X = VectorZero();
+		VectorRegister Y = VectorZero();
+		VectorRegister Z = VectorZero();
+
+		if (Below)
+		{
+			X = VectorAdd(X, VectorAdd(VectorAdd(VectorLoad(&Below->X1[Vert + 1]), VectorLoad(&Below->X2[Vert + 1])), VectorLoad(&Below->X1[Vert])));
+			Y = VectorAdd(Y, VectorAdd(VectorAdd(VectorLoad(&Below->Y1[Vert + 1]), VectorLoad(&Below->Y2[Vert + 1])), VectorLoad(&Below->Y1[Vert])));
+			Z = VectorAdd(Z, VectorAdd(VectorAdd(VectorLoad(&Below->Z1[Vert + 1]), VectorLoad(&Below->Z2[Vert + 1])), VectorLoad(&Below->Z1[Vert])));
+		}
+		if (Above)
+		{
+			X = VectorAdd(X, VectorAdd(VectorLoad(&Above->X2[Vert + 1]), VectorAdd(VectorLoad(&Above->X1[Vert]), VectorLoad(&Above->X2[Vert]))));
+			Y = VectorAdd(Y, VectorAdd(VectorLoad(&Above->Y2[Vert + 1]), VectorAdd(VectorLoad(&Above->Y1[Vert]), VectorLoad(&Above->Y2[Vert]))));
+			Z = VectorAdd(Z, VectorAdd(VectorLoad(&Above->Z2[Vert + 1]), VectorAdd(VectorLoad(&Above->Z1[Vert]), VectorLoad(&Above->Z2[Vert]))));
+		}
+
+		VectorSafeNormalize(X, Y, Z);
+		VectorStore(X, &NormalX[Vert]);
+		VectorStore(Y, &NormalY[Vert]);
+	}
+
+	for (; Vert < NumVerts; Vert++)
+	{
+		FVector Normal = FVector::ZeroVector;
+		if (Below)
+		{
+			Normal += FVector(Below->X1[Vert + 1], Below->Y1[Vert + 1], Below->Z1[Vert + 1]) + FVector(Below->X2[Vert + 1], Below->Y2[Vert + 1], Below->Z2[Vert + 1]) + FVector(Below->X1[Vert], Below->Y1[Vert], Below->Z1[Vert]);
+		}
+		if (Above)
+		{
+			Normal += FVector(Above->X2[Vert + 1], Above->Y2[Vert + 1], Above->Z2[Vert + 1]) + FVector(Above->X1[Vert], Above->Y1[Vert], Above->Z1[Vert]) + FVector(Above->X2[Vert], Above->Y2[Vert], Above->Z2[Vert]);
+		}
+		Normal = Normal.GetSafeNormal();
+		NormalX[Vert] = Normal.X;
+		NormalY[Vert] = Normal.Y;
+	}
+
+	for (int32 X = 0; X < NumVerts; X++)
+	{
+		FColor& Texel = OutTexels[X];
+		Texel.R = Heights[X] >> 8;
+		Texel.G = Heights[X] & 255;
+		Texel.B = PackNormalComponent(NormalX[X]);
+		Texel.A = PackNormalComponent(NormalY[X]);
+	}
+}
+
+void FCyLandNormalKernel::ComputeTexels(const uint16* Heights, int32 HeightStride, int32 NumVertsX, int32 NumVertsY, int32 RowBegin, int32 RowEnd, FColor* OutTexels, int32 OutStride)
+{
+	check(NumVertsX > 0 && NumVertsX <= MaxVertsX);
+	check(RowBegin >= 0 && RowBegin <= RowEnd && RowEnd <= NumVertsY);
+
+	const int32 NumQuads = NumVertsX - 1;
+	int32 ZIndex = 0;
+	int32 FaceIndex = 0;
+
+	LoadHeights(Heights + RowBegin * HeightStride, NumVertsX, ZRows[ZIndex].GetData());
+
+	const FFaceRow* Above = nullptr;
+	if (RowBegin > 0)
+	{
+		LoadHeights(Heights + (RowBegin - 1) * HeightStride, NumVertsX, ZRows[ZIndex ^ 1].GetData());
+		ComputeFaceRow(ZRows[ZIndex ^ 1].GetData(), ZRows[ZIndex].GetData(), NumQuads, FaceRows[FaceIndex]);
+		Above = &FaceRows[FaceIndex];
+		FaceIndex ^= 1;
+	}
+
+	for (int32 Y = RowBegin; Y < RowEnd; Y++)
+	{
+		const FFaceRow* Below = nullptr;
+		if (Y + 1 < NumVertsY)
+		{
+			LoadHeights(Heights + (Y + 1) * HeightStride, NumVertsX, ZRows[ZIndex ^ 1].GetData());
+			ComputeFaceRow(ZRows[ZIndex].GetData(), ZRows[ZIndex ^ 1].GetData(), NumQuads, FaceRows[FaceIndex]);
+			Below = &FaceRows[FaceIndex];
+		}
+
+		PackRow(Above, Below, Heights + Y * HeightStride, NumVertsX, OutTexels + (Y - RowBegin) * OutStride);
+
+		Above = Below;
+		FaceIndex ^= 1;
+		ZIndex ^= 1;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace CyLandNormalKernelBenchmark
+{
+	/** The per-quad FVector implementation the kernel replaced, kept as reference */
+	static void ReferenceTexels(const uint16* Heights, int32 NumVertsX, int32 NumVertsY, const FVector& DrawScale, FColor* OutTexels)
+	{
+		FVector* VertexNormals = new FVector[NumVertsX * NumVertsY];
+		FMemory::Memzero(VertexNormals, NumVertsX * NumVertsY * sizeof(FVector));
+
+		for (int32 Y = 0; Y < NumVertsY - 1; Y++)
+		{
+			for (int32 X = 0; X < NumVertsX - 1; X++)
+			{
+				FVector Vert00 = FVector(0.0f, 0.0f, ((float)Heights[(X + 0) + NumVertsX*(Y + 0)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
+				FVector Vert01 = FVector(0.0f, 1.0f, ((float)Heights[(X + 0) + NumVertsX*(Y + 1)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
+				FVector Vert10 = FVector(1.0f, 0.0f, ((float)Heights[(X + 1) + NumVertsX*(Y + 0)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
+				FVector Vert11 = FVector(1.0f, 1.0f, ((float)Heights[(X + 1) + NumVertsX*(Y + 1)] - 32768.0f) * LANDSCAPE_ZSCALE) * DrawScale;
+
+				FVector FaceNormal1 = ((Vert00 - Vert10) ^ (Vert10 - Vert11)).GetSafeNormal();
+				FVector FaceNormal2 = ((Vert11 - Vert01) ^ (Vert01 - Vert00)).GetSafeNormal();
+
+				// contribute to the vertex normals.
+				VertexNormals[(X + 1 + NumVertsX*(Y + 0))] += FaceNormal1;
+				VertexNormals[(X + 0 + NumVertsX*(Y + 1))] += FaceNormal2;
+				VertexNormals[(X + 0 + NumVertsX*(Y + 0))] += FaceNormal1 + FaceNormal2;
+				VertexNormals[(X + 1 + NumVertsX*(Y + 1))] += FaceNormal1 + FaceNormal2;
+			}
+		}
+
+		for (int32 Index = 0; Index < NumVertsX * NumVertsY; Index++)
+		{
+			const FVector Normal = VertexNormals[Index].GetSafeNormal();
+			OutTexels[Index].R = Heights[Index] >> 8;
+			OutTexels[Index].G = Heights[Index] & 255;
+			OutTexels[Index].B = FMath::RoundToInt(127.5f * (Normal.X + 1.0f));
+			OutTexels[Index].A = FMath::RoundToInt(127.5f * (Normal.Y + 1.0f));
+		}
+
+		delete[] VertexNormals;
+	}
+
+	static void Run(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const int32 NumVerts = Args.Num() > 0 ? FMath::Clamp(FCString::Atoi(*Args[0]), 2, 8193) : 1009;
+		const int32 NumIterations = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 10;
+		const FVector DrawScale(100.0f, 100.0f, 100.0f);
+
+		// Rolling hills with some noise so every quad has a different normal
+		FRandomStream RandomStream(0x1234);
+		TArray<uint16> Heights;
+		Heights.SetNumUninitialized(NumVerts * NumVerts);
+		for (int32 Y = 0; Y < NumVerts; Y++)
+		{
+			for (int32 X = 0; X < NumVerts; X++)
+			{
+				const float Hills = FMath::Sin(X * 0.05f) * FMath::Cos(Y * 0.03f) * 8000.0f;
+				Heights[X + Y * NumVerts] = (uint16)FMath::Clamp<int32>(32768 + FMath::RoundToInt(Hills) + RandomStream.RandRange(-64, 64), 0, MAX_uint16);
+			}
+		}
+
+		TArray<FColor> ReferenceOutput;
+		TArray<FColor> KernelOutput;
+		ReferenceOutput.SetNumUninitialized(NumVerts * NumVerts);
+		KernelOutput.SetNumUninitialized(NumVerts * NumVerts);
+
+		double ReferenceTime = MAX_dbl;
+		double KernelTime = MAX_dbl;
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			double StartTime = FPlatformTime::Seconds();
+			ReferenceTexels(Heights.GetData(), NumVerts, NumVerts, DrawScale, ReferenceOutput.GetData());
+			ReferenceTime = FMath::Min(ReferenceTime, FPlatformTime::Seconds() - StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			FCyLandNormalKernel Kernel(DrawScale, NumVerts);
+			Kernel.ComputeTexels(Heights.GetData(), NumVerts, NumVerts, NumVerts, 0, NumVerts, KernelOutput.GetData(), NumVerts);
+			KernelTime = FMath::Min(KernelTime, FPlatformTime::Seconds() - StartTime);
+		}
+
+		int32 MaxError = 0;
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < NumVerts * NumVerts; Index++)
+		{
+			const int32 Error = FMath::Max(FMath::Abs((int32)ReferenceOutput[Index].B - (int32)KernelOutput[Index].B), FMath::Abs((int32)ReferenceOutput[Index].A - (int32)KernelOutput[Index].A));
+			MaxError = FMath::Max(MaxError, Error);
+			NumMismatches += (Error != 0 || ReferenceOutput[Index].R != KernelOutput[Index].R || ReferenceOutput[Index].G != KernelOutput[Index].G) ? 1 : 0;
+		}
+
+		Ar.Logf(TEXT("CyLand normal kernel, %dx%d vertices, best of %d: reference %.3f ms, kernel %.3f ms (%.2fx), %d texels differ, max normal error %d"),
+			NumVerts, NumVerts, NumIterations, ReferenceTime * 1000.0, KernelTime * 1000.0, ReferenceTime / FMath::Max(KernelTime, 1e-9), NumMismatches, MaxError);
+	}
+
+	static FAutoConsoleCommand BenchmarkCmd(
+		TEXT("CyLand.BenchmarkNormals"),
+		TEXT("Compare the vectorized heightmap normal kernel with the reference implementation. Args: [NumVerts=1009] [Iterations=10]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
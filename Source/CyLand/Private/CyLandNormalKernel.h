@@ -0,0 +1,76 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandNormalKernel.h: Vectorized heightmap normal computation and packing
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Computes heightmap texels (R/G = height, B/A = vertex normal X/Y) a row at a time.
+ *
+ * Vertex normals are the normalized sum of the normals of the two triangles of every adjacent quad,
+ * the same as the per-quad FVector code it replaces. Face normals of a quad row are computed once
+ * and reused for the vertex rows above and below it. The inner loops use VectorRegister (SSE/NEON)
+ * four quads at a time with a scalar tail; platforms without SIMD get the FPU implementation of
+ * VectorRegister.
+ *
+ * XY offsets are not taken into account: the original code offset all four corners of a quad by the
+ * same amount, which cancels out in the cross products.
+ */
+class FCyLandNormalKernel
+{
+public:
+	/**
+	 * @param InDrawScale - Scale of the landscape, heights are scaled by LANDSCAPE_ZSCALE * DrawScale.Z
+	 * @param InMaxVertsX - Widest row that will be processed
+	 */
+	FCyLandNormalKernel(const FVector& InDrawScale, int32 InMaxVertsX);
+
+	/**
+	 * Compute the texels of rows [RowBegin, RowEnd) of a NumVertsX x NumVertsY grid of heights.
+	 * Vertices on the border of the grid only accumulate the quads inside the grid.
+	 * @param Heights - First sample of the grid
+	 * @param HeightStride - Distance between two rows of Heights, in samples
+	 * @param OutTexels - Texel of the first vertex of RowBegin
+	 * @param OutStride - Distance between two rows of OutTexels, in texels
+	 */
+	void ComputeTexels(const uint16* Heights, int32 HeightStride, int32 NumVertsX, int32 NumVertsY, int32 RowBegin, int32 RowEnd, FColor* OutTexels, int32 OutStride);
+
+	/** Packed normal channel value of a normalized normal component */
+	static FORCEINLINE uint8 PackNormalComponent(float Value)
+	{
+		return (uint8)FMath::RoundToInt(127.5f * (Value + 1.0f));
+	}
+
+private:
+	/** Normals of both triangles of every quad of a row, SoA with one zero quad of padding on each side */
+	struct FFaceRow
+	{
+		TArray<float> X1, Y1, Z1;
+		TArray<float> X2, Y2, Z2;
+
+		void Init(int32 NumPaddedQuads);
+	};
+
+	/** Convert a row of heights to scaled Z */
+	void LoadHeights(const uint16* Heights, int32 NumVerts, float* OutZ) const;
+
+	/** Face normals of the quad row between two height rows */
+	void ComputeFaceRow(const float* Z0, const float* Z1, int32 NumQuads, FFaceRow& OutRow) const;
+
+	/** Accumulate, normalize and pack the vertex normals of a row from the quad rows around it (either may be null) */
+	void PackRow(const FFaceRow* Above, const FFaceRow* Below, const uint16* Heights, int32 NumVerts, FColor* OutTexels);
+
+	FVector DrawScale;
+	int32 MaxVertsX;
+
+	/** Sliding window of heights and face rows */
+	TArray<float> ZRows[2];
+	FFaceRow FaceRows[2];
+
+	/** Normalized X/Y of the row being packed */
+	TArray<float> NormalX, NormalY;
+};
@@ -0,0 +1,54 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandPlatformData.h: Mobile platform vertex data generation, usable off the game thread
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_EDITOR
+
+class UCyLandComponent;
+class UTexture2D;
+class ITargetPlatform;
+struct FCyLandVertexRef;
+
+/** Heightmap source mips used for the mobile vertex data, shared by the components of a heightmap */
+typedef TSharedPtr<TArray<TArray<uint8>>, ESPMode::ThreadSafe> FCyLandPlatformHeightmapMipsPtr;
+
+/**
+ * What GeneratePlatformVertexData reads from a component, copied on the game thread so the vertex data can then be
+ * built on any thread.
+ */
+struct FCyLandPlatformVertexSource
+{
+	/**
+	 * @param MipCache - Optional, mips already copied for other components, the mips of this heightmap are added to it
+	 */
+	FCyLandPlatformVertexSource(const UCyLandComponent* Component, const ITargetPlatform* TargetPlatform, TMap<UTexture2D*, FCyLandPlatformHeightmapMipsPtr>* MipCache = nullptr);
+
+	int32 SubsectionSizeQuads;
+	int32 NumSubsections;
+	int32 HeightmapSizeX;
+	int32 HeightmapSizeY;
+	FVector4 HeightmapScaleBias;
+
+	/** Mip the occluder mesh is built from, INDEX_NONE for no occluder mesh */
+	int32 OcclusionMeshMip;
+
+	/** Heightmap mips down to the last one with more than one vertex per sub-section, at most LANDSCAPE_MAX_ES_LOD */
+	FCyLandPlatformHeightmapMipsPtr HeightmapMips;
+};
+
+namespace CyLandPlatformData
+{
+	/** Order of the mobile vertices, lowest LOD first; it only depends on the sub-section layout */
+	void BuildVertexOrder(int32 SubsectionSizeQuads, int32 NumSubsections, TArray<FCyLandVertexRef>& OutVertexOrder);
+
+	/** Serialize the mobile vertices and the occluder mesh of a component, uncompressed */
+	void BuildVertexData(const FCyLandPlatformVertexSource& Source, const TArray<FCyLandVertexRef>& VertexOrder, TArray<uint8>& OutPlatformData);
+}
+
+#endif // WITH_EDITOR
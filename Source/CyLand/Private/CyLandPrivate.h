@@ -20,6 +20,7 @@ DECLARE_CYCLE_STAT_EXTERN(TEXT("Init View Custom Data"), STAT_CyLandInitViewCust
 DECLARE_CYCLE_STAT_EXTERN(TEXT("PostInit View Custom Data"), STAT_CyLandPostInitViewCustomData, STATGROUP_Landscape, );
 DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Custom Mesh Batch LOD"), STAT_CyLandComputeCustomMeshBatchLOD, STATGROUP_Landscape, );
 DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Custom Shadow Mesh Batch LOD"), STAT_CyLandComputeCustomShadowMeshBatchLOD, STATGROUP_Landscape, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Index Buffer Creation"), STAT_CyLandIndexBufferCreation, STATGROUP_Landscape, );
 
 DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Components Using SubSection DrawCall"), STAT_CyLandComponentUsingSubSectionDrawCalls, STATGROUP_Landscape, );
 DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Tessellated Shadow Cascade"), STAT_CyLandTessellatedShadowCascade, STATGROUP_Landscape, );
@@ -36,4 +37,5 @@ DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Regenerate Procedural Heightmap DrawCall
 
 DECLARE_MEMORY_STAT_EXTERN(TEXT("Vertex Mem"), STAT_CyLandVertexMem, STATGROUP_Landscape, );
 DECLARE_MEMORY_STAT_EXTERN(TEXT("Occluder Mem"), STAT_CyLandOccluderMem, STATGROUP_Landscape, );
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Index Mem"), STAT_CyLandIndexMem, STATGROUP_Landscape, );
 DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Component Mem"), STAT_CyLandComponentMem, STATGROUP_Landscape, );
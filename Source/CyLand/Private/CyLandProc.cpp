@@ -2,6 +2,8 @@
 
 #include "CyLandProc.h"
 #include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+#include "CyLandNoise.h"
 #include "CyLand/Classes/CyLand.h"
 #include "CyLand/Classes/CyLandComponent.h"
 #include "CyLand/Classes/CyLandInfo.h"
@@ -25,6 +27,7 @@ Super(initilizer)
 
 ACyLand* UProceuduralGameLandUtils::SpawnGameLand(AActor* context, UMaterialInterface* mat
 	, int32 SectionsPerComponent, int32 ComponentCountX, int32 ComponentCountY, int32 QuadsPerComponent
+	, float NoiseAmount, float NoiseScale
 	)
 {
 	UWorld* GameWorld = context->GetWorld();
@@ -51,6 +54,24 @@ ACyLand* UProceuduralGameLandUtils::SpawnGameLand(AActor* context, UMaterialInte
 				WordData[i] = 32768;
 			}
 
+			// Procedural base terrain, rows in parallel
+			if (NoiseAmount != 0.0f)
+			{
+				const FCyLandNoise Noise(NoiseScale, NoiseAmount, 32768.0f);
+				ParallelFor(SizeY, [&](int32 Y)
+				{
+					TArray<float> NoiseData;
+					NoiseData.SetNumUninitialized(SizeX);
+					Noise.SampleRow(0, Y, SizeX, NoiseData.GetData());
+
+					uint16* RESTRICT HeightScanline = WordData + Y * SizeX;
+					for (int32 X = 0; X < SizeX; X++)
+					{
+						HeightScanline[X] = (uint16)FMath::Clamp<int32>(FMath::RoundToInt(NoiseData[X]), 0, 65535);
+					}
+				});
+			}
+
 
 		FVector Offset = FVector(-ComponentCountX * QuadsPerComponent / 2, -ComponentCountY * QuadsPerComponent / 2, 0);
 
@@ -77,6 +98,27 @@ ACyLand* UProceuduralGameLandUtils::SpawnGameLand(AActor* context, UMaterialInte
 	return NULL;
 }
 
+ACyLandStreamingWorld* UProceuduralGameLandUtils::SpawnStreamingGameLand(AActor* context, UMaterialInterface* mat
+	, int32 SectionsPerComponent, int32 ComponentsPerTile, int32 QuadsPerComponent, float StreamingDistance
+	)
+{
+	UWorld* GameWorld = context->GetWorld();
+	if (GameWorld && GameWorld->GetCurrentLevel()->bIsVisible)
+	{
+		ACyLandStreamingWorld* StreamingWorld = GameWorld->SpawnActor<ACyLandStreamingWorld>(FVector::ZeroVector, FRotator(0, 0, 0));
+		StreamingWorld->SetActorRelativeScale3D(FVector(100, 100, 100));
+		StreamingWorld->CyLandMaterial = mat;
+		StreamingWorld->SectionsPerComponent = SectionsPerComponent;
+		StreamingWorld->ComponentsPerTile = ComponentsPerTile;
+		StreamingWorld->QuadsPerComponent = QuadsPerComponent;
+		StreamingWorld->StreamingDistance = StreamingDistance;
+		StreamingWorld->InitializeWorld();
+		return StreamingWorld;
+	}
+
+	return NULL;
+}
+
 void UProceuduralGameLandUtils::NotifyMaterialUpdated(ACyLand* CyLand)
 {
 	auto property = FPropertyChangedEvent(ACyLand::StaticClass()->FindPropertyByName("CyLandMaterial"));
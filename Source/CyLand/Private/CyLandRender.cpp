@@ -30,6 +30,9 @@ CyLandRender.cpp: New terrain rendering
 #include "Engine/StaticMesh.h"
 #include "CyLandInfo.h"
 #include "CyLandDataAccess.h"
+#include "CyLandLODSolver.h"
+#include "CyLandSharedBuffersPool.h"
+#include "CyLandLODMath.h"
 #include "DrawDebugHelpers.h"
 #include "PrimitiveSceneInfo.h"
 #include "SceneView.h"
@@ -47,6 +50,14 @@ FAutoConsoleVariableRef CVarCyLandMeshLODBias(
 	ECVF_Scalability
 );
 
+int32 GCyLandPackedVertices = 1;
+FAutoConsoleVariableRef CVarCyLandPackedVertices(
+	TEXT("r.CyLandPackedVertices"),
+	GCyLandPackedVertices,
+	TEXT("1: Shared CyLand vertex buffers use 2 bytes per component (8 bytes per vertex), 0: 4 bytes per component (16 bytes per vertex). Applies to buffers created afterwards."),
+	ECVF_RenderThreadSafe
+);
+
 float GCyLandLOD0DistributionScale = 1.f;
 FAutoConsoleVariableRef CVarCyLandLOD0DistributionScale(
 	TEXT("r.CyLandLOD0DistributionScale"),
@@ -603,7 +614,6 @@ void UCyLandComponent::GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterial
 //
 // FCyLandComponentSceneProxy
 //
-TMap<uint32, FCyLandSharedBuffers*>FCyLandComponentSceneProxy::SharedBuffersMap;
 TMap<FCyLandNeighborInfo::FCyLandKey, TMap<FIntPoint, const FCyLandNeighborInfo*> > FCyLandNeighborInfo::SharedSceneProxyMap;
 
 const static FName NAME_CyLandResourceNameForDebugging(TEXT("CyLand"));
@@ -639,6 +649,7 @@ FCyLandComponentSceneProxy::FCyLandComponentSceneProxy(UCyLandComponent* InCompo
 	, SharedBuffers(nullptr)
 	, VertexFactory(nullptr)
 	, ComponentLightInfo(nullptr)
+	, LODSolver(nullptr)
 #if WITH_EDITORONLY_DATA
 	, EditToolRenderData(InComponent->EditToolRenderData)
 	, LODFalloff_DEPRECATED(InComponent->GetCyLandProxy()->LODFalloff_DEPRECATED)
@@ -705,22 +716,8 @@ FCyLandComponentSceneProxy::FCyLandComponentSceneProxy(UCyLandComponent* InCompo
 		HeightmapSubsectionOffsetV = ((float)(InComponent->SubsectionSizeQuads + 1) / (float)HeightmapTexture->GetSizeY());
 	}
 
-	float ScreenSizeRatioDivider = FMath::Max(InComponent->GetCyLandProxy()->LOD0DistributionSetting * GCyLandLOD0DistributionScale, 1.01f);
-	float CurrentScreenSizeRatio = 1.0f;
-
-	LODScreenRatioSquared.AddUninitialized(MaxLOD + 1);
-
-	// LOD 0 handling
-	LODScreenRatioSquared[0] = FMath::Square(CurrentScreenSizeRatio);
-	CurrentScreenSizeRatio /= ScreenSizeRatioDivider;
-	ScreenSizeRatioDivider = FMath::Max(InComponent->GetCyLandProxy()->LODDistributionSetting * GCyLandLODDistributionScale, 1.01f);
-
-	// Other LODs
-	for (int32 LODIndex = 1; LODIndex <= MaxLOD; ++LODIndex) // This should ALWAYS be calculated from the component size, not user MaxLOD override
-	{
-		LODScreenRatioSquared[LODIndex] = FMath::Square(CurrentScreenSizeRatio);
-		CurrentScreenSizeRatio /= ScreenSizeRatioDivider;
-	}
+	// This should ALWAYS be calculated from the component size, not user MaxLOD override
+	CyLandLODMath::BuildLODScreenRatioSquared(MaxLOD, InComponent->GetCyLandProxy()->LOD0DistributionSetting * GCyLandLOD0DistributionScale, InComponent->GetCyLandProxy()->LODDistributionSetting * GCyLandLODDistributionScale, LODScreenRatioSquared);
 
 	if (InComponent->GetCyLandProxy()->MaxLODLevel >= 0)
 	{
@@ -864,64 +861,39 @@ void FCyLandComponentSceneProxy::CreateRenderThreadResources()
 	if (IsComponentLevelVisible())
 	{
 		RegisterNeighbors();
+		FCyLandLODSolver::Register(this);
 	}
 
 	auto FeatureLevel = GetScene().GetFeatureLevel();
 
-	SharedBuffers = FCyLandComponentSceneProxy::SharedBuffersMap.FindRef(SharedBuffersKey);
+	SharedBuffers = FCyLandSharedBuffersPool::Acquire(SharedBuffersKey);
 	if (SharedBuffers == nullptr)
 	{
 		SharedBuffers = new FCyLandSharedBuffers(
 			SharedBuffersKey, SubsectionSizeQuads, NumSubsections,
-			FeatureLevel, bRequiresAdjacencyInformation, /*NumOcclusionVertices*/ 0);
+			FeatureLevel, /*NumOcclusionVertices*/ 0);
 
-		FCyLandComponentSceneProxy::SharedBuffersMap.Add(SharedBuffersKey, SharedBuffers);
+		FCyLandSharedBuffersPool::Add(SharedBuffers);
 
 		if (!XYOffsetmapTexture)
 		{
 			FCyLandVertexFactory* CyLandVertexFactory = new FCyLandVertexFactory(FeatureLevel);
-			CyLandVertexFactory->Data.PositionComponent = FVertexStreamComponent(SharedBuffers->VertexBuffer, 0, sizeof(FCyLandVertex), VET_Float4);
+			CyLandVertexFactory->Data.PositionComponent = FVertexStreamComponent(SharedBuffers->VertexBuffer, 0, SharedBuffers->VertexBuffer->GetStride(), SharedBuffers->VertexBuffer->GetElementType());
 			CyLandVertexFactory->InitResource();
 			SharedBuffers->VertexFactory = CyLandVertexFactory;
 		}
 		else
 		{
 			FCyLandXYOffsetVertexFactory* CyLandXYOffsetVertexFactory = new FCyLandXYOffsetVertexFactory(FeatureLevel);
-			CyLandXYOffsetVertexFactory->Data.PositionComponent = FVertexStreamComponent(SharedBuffers->VertexBuffer, 0, sizeof(FCyLandVertex), VET_Float4);
+			CyLandXYOffsetVertexFactory->Data.PositionComponent = FVertexStreamComponent(SharedBuffers->VertexBuffer, 0, SharedBuffers->VertexBuffer->GetStride(), SharedBuffers->VertexBuffer->GetElementType());
 			CyLandXYOffsetVertexFactory->InitResource();
 			SharedBuffers->VertexFactory = CyLandXYOffsetVertexFactory;
 		}
 	}
 
-	SharedBuffers->AddRef();
-
-	if (bRequiresAdjacencyInformation)
-	{
-		if (SharedBuffers->AdjacencyIndexBuffers == nullptr)
-		{
-			ensure(SharedBuffers->NumIndexBuffers > 0);
-			if (SharedBuffers->IndexBuffers[0])
-			{
-				// Recreate Index Buffers, this case happens only there are CyLand Components using different material (one uses tessellation, other don't use it) 
-				if (SharedBuffers->bUse32BitIndices && !((FRawStaticIndexBuffer16or32<uint32>*)SharedBuffers->IndexBuffers[0])->Num())
-				{
-					SharedBuffers->CreateIndexBuffers<uint32>(FeatureLevel, bRequiresAdjacencyInformation);
-				}
-				else if (!((FRawStaticIndexBuffer16or32<uint16>*)SharedBuffers->IndexBuffers[0])->Num())
-				{
-					SharedBuffers->CreateIndexBuffers<uint16>(FeatureLevel, bRequiresAdjacencyInformation);
-				}
-			}
-
-			SharedBuffers->AdjacencyIndexBuffers = new FCyLandSharedAdjacencyIndexBuffer(SharedBuffers);
-		}
-
-		// Delayed Initialize for IndexBuffers
-		for (int32 i = 0; i < SharedBuffers->NumIndexBuffers; i++)
-		{
-			SharedBuffers->IndexBuffers[i]->InitResource();
-		}
-	}
+	// Build the LODs this proxy can select that no other proxy built yet, with adjacency if it uses tessellation.
+	// LOD selection clamps to the bias minimum and never goes past LastLOD, whatever the view and the streamed mip.
+	SharedBuffers->RequestLODs(FMath::Max(0, FMath::FloorToInt(MinValidLOD)), LastLOD, bRequiresAdjacencyInformation);
 
 	// Assign vertex factory
 	VertexFactory = SharedBuffers->VertexFactory;
@@ -984,25 +956,32 @@ void FCyLandComponentSceneProxy::CreateRenderThreadResources()
 #endif
 }
 
+#if WITH_EDITOR
+const FMeshBatch& FCyLandComponentSceneProxy::GetGrassMeshBatch() const
+{
+	// Grass maps are only rendered in the editor when grass types need them, so the buffer is built the first time
+	SharedBuffers->RequestGrassIndexBuffer();
+	return GrassMeshBatch;
+}
+#endif
+
 void FCyLandComponentSceneProxy::OnLevelAddedToWorld()
 {
 	RegisterNeighbors();
+	FCyLandLODSolver::Register(this);
 }
 
 FCyLandComponentSceneProxy::~FCyLandComponentSceneProxy()
 {
 	UnregisterNeighbors();
+	FCyLandLODSolver::Unregister(this);
 
 	// Free the subsection uniform buffer
 	CyLandCyUniformShaderParameters.ReleaseResource();
 
 	if (SharedBuffers)
 	{
-		check(SharedBuffers == FCyLandComponentSceneProxy::SharedBuffersMap.FindRef(SharedBuffersKey));
-		if (SharedBuffers->Release() == 0)
-		{
-			FCyLandComponentSceneProxy::SharedBuffersMap.Remove(SharedBuffersKey);
-		}
+		FCyLandSharedBuffersPool::Release(SharedBuffers);
 		SharedBuffers = nullptr;
 	}
 }
@@ -1265,24 +1244,16 @@ void FCyLandComponentSceneProxy::OnTransformChanged()
 	);
 
 	CyLandCyUniformShaderParameters.SetContents(CyLandParams);
+
+	if (LODSolver)
+	{
+		LODSolver->UpdateBounds(this);
+	}
 }
 
 float FCyLandComponentSceneProxy::GetComponentScreenSize(const FSceneView* View, const FVector& Origin, float MaxExtend, float ElementRadius) const
 {
-	FVector CameraOrigin = View->ViewMatrices.GetViewOrigin();
-	FMatrix ProjMatrix = View->ViewMatrices.GetProjectionMatrix();
-
-	const FVector OriginToCamera = (CameraOrigin - Origin).GetAbs();
-	const FVector ClosestPoint = OriginToCamera.ComponentMin(FVector(MaxExtend));
-	const float DistSquared = (OriginToCamera - ClosestPoint).SizeSquared();
-
-	// Get projection multiple accounting for view scaling.
-	const float ScreenMultiple = FMath::Max(0.5f * ProjMatrix.M[0][0], 0.5f * ProjMatrix.M[1][1]);
-
-	// Calculate screen-space projected radius
-	float SquaredScreenRadius = FMath::Square(ScreenMultiple * ElementRadius) / FMath::Max(1.0f, DistSquared);
-
-	return FMath::Min(SquaredScreenRadius * 2.0f, 1.0f);
+	return CyLandLODMath::GetComponentScreenSize(View->ViewMatrices.GetViewOrigin(), CyLandLODMath::GetScreenMultiple(View->ViewMatrices.GetProjectionMatrix()), Origin, MaxExtend, ElementRadius);
 }
 
 void FCyLandComponentSceneProxy::BuildDynamicMeshElement(const FViewCustomDataLOD* InPrimitiveCustomData, bool InToolMesh, bool InHasTessellation, bool InDisableTessellation, FMeshBatch& OutMeshBatch, TArray<FCyLandBatchElementParams, SceneRenderingAllocator>& OutStaticBatchParamArray) const
@@ -1547,6 +1518,11 @@ void FCyLandComponentSceneProxy::ApplyWorldOffset(FVector InOffset)
 			}
 		}
 	}
+
+	if (LODSolver)
+	{
+		LODSolver->UpdateBounds(this);
+	}
 }
 
 void FCyLandComponentSceneProxy::DrawStaticElements(FStaticPrimitiveDrawInterface* PDI)
@@ -1700,14 +1676,7 @@ void FCyLandComponentSceneProxy::CalculateLODFromScreenSize(const FSceneView& In
 	int8 LocalLODBias = LODBias + (int8)GCyLandMeshLODBias;
 	FViewCustomDataSubSectionLOD& SubSectionLODData = InOutLODData.SubSections[InSubSectionIndex];
 
-	if (PreferedLOD >= 0.0f)
-	{
-		PreferedLOD = FMath::Clamp<float>(PreferedLOD + LocalLODBias, FMath::Max((float)MinStreamedLOD, MinValidLOD), FMath::Min((float)LastLOD, MaxValidLOD));
-	}
-	else
-	{
-		PreferedLOD = FMath::Clamp<float>(ComputeBatchElementCurrentLOD(GetLODFromScreenSize(InMeshScreenSizeSquared, InViewLODScale), InMeshScreenSizeSquared) + LocalLODBias, FMath::Max((float)MinStreamedLOD, MinValidLOD), FMath::Min((float)LastLOD, MaxValidLOD));
-	}
+	PreferedLOD = CyLandLODMath::GetBiasedLOD(LODScreenRatioSquared, InMeshScreenSizeSquared, InViewLODScale, PreferedLOD, LocalLODBias, FMath::Max((float)MinStreamedLOD, MinValidLOD), FMath::Min((float)LastLOD, MaxValidLOD));
 
 	check(PreferedLOD != -1.0f && PreferedLOD <= MaxLOD);
 	SubSectionLODData.fBatchElementCurrentLOD = PreferedLOD;
@@ -1787,10 +1756,8 @@ uint64 FCyLandComponentSceneProxy::GetStaticBatchElementVisibility(const FSceneV
 	return BatchesToRenderMask;
 }
 
-void FCyLandComponentSceneProxy::CalculateBatchElementLOD(const FSceneView& InView, float InMeshScreenSizeSquared, float InViewLODScale, FViewCustomDataLOD& InOutLODData, bool InForceCombined) const
+void FCyLandComponentSceneProxy::CalculateBatchElementLOD(const FSceneView& InView, float InMeshScreenSizeSquared, float InViewLODScale, FViewCustomDataLOD& InOutLODData, bool InForceCombined, const FCyLandComponentLOD* InSolvedLOD) const
 {
-	float SquaredViewLODScale = FMath::Square(InViewLODScale);
-
 	check(InMeshScreenSizeSquared >= 0.0f && InMeshScreenSizeSquared <= 1.0f);
 	float ComponentScreenSize = InMeshScreenSizeSquared;
 
@@ -1800,7 +1767,7 @@ void FCyLandComponentSceneProxy::CalculateBatchElementLOD(const FSceneView& InVi
 
 		float SubSectionMaxExtend = ComponentMaxExtend / 2.0f;
 		float SubSectionRadius = CyLandComponent->Bounds.SphereRadius / 2.0f;
-		float CombinedScreenRatio = 0.0f;
+		float SubSectionScreenSizes[MAX_SUBSECTION_COUNT];
 		bool AllSubSectionHaveSameScreenSize = true;
 
 		// Compute screen size of each sub section to determine if we should use the combined logic or the individual logic
@@ -1811,38 +1778,32 @@ void FCyLandComponentSceneProxy::CalculateBatchElementLOD(const FSceneView& InVi
 				int32 SubSectionIndex = SubX + SubY * NumSubsections;
 				FViewCustomDataSubSectionLOD& SubSectionLODData = InOutLODData.SubSections[SubSectionIndex];
 
-				SubSectionLODData.ScreenSizeSquared = GetComponentScreenSize(&InView, SubSectionScreenSizeTestingPosition[SubSectionIndex], SubSectionMaxExtend, SubSectionRadius);
+				if (InSolvedLOD)
+				{
+					SubSectionLODData.ScreenSizeSquared = InSolvedLOD->SubSectionScreenSizeSquared[SubSectionIndex];
+					SubSectionLODData.fBatchElementCurrentLOD = InSolvedLOD->SubSectionLOD[SubSectionIndex];
+					SubSectionLODData.BatchElementCurrentLOD = FMath::FloorToInt(SubSectionLODData.fBatchElementCurrentLOD);
+				}
+				else
+				{
+					SubSectionLODData.ScreenSizeSquared = GetComponentScreenSize(&InView, SubSectionScreenSizeTestingPosition[SubSectionIndex], SubSectionMaxExtend, SubSectionRadius);
+					CalculateLODFromScreenSize(InView, SubSectionLODData.ScreenSizeSquared, InViewLODScale, SubSectionIndex, InOutLODData);
+				}
 
 				check(SubSectionLODData.ScreenSizeSquared > 0.0f);
-
-				CalculateLODFromScreenSize(InView, SubSectionLODData.ScreenSizeSquared, InViewLODScale, SubSectionIndex, InOutLODData);
 				check(SubSectionLODData.fBatchElementCurrentLOD != -1.0f);
 
 				InOutLODData.ShaderCurrentLOD.Component(SubSectionIndex) = SubSectionLODData.fBatchElementCurrentLOD;
-
-				// Determine if we should use the combined batch or not
-				if (ComponentScreenSize > ComponentSquaredScreenSizeToUseSubSections * SquaredViewLODScale)
-				{
-					if (AllSubSectionHaveSameScreenSize)
-					{
-						float CurrentScreenRadiusSquared = SubSectionLODData.ScreenSizeSquared * SquaredViewLODScale;
-
-						if (CombinedScreenRatio > 0.0f && !FMath::IsNearlyEqual(CombinedScreenRatio, CurrentScreenRadiusSquared, KINDA_SMALL_NUMBER))
-						{
-							AllSubSectionHaveSameScreenSize = false;
-						}
-
-						CombinedScreenRatio += CurrentScreenRadiusSquared;
-
-						if (SubSectionIndex > 0)
-						{
-							CombinedScreenRatio *= 0.5f;
-						}
-					}
-				}
+				SubSectionScreenSizes[SubSectionIndex] = SubSectionLODData.ScreenSizeSquared;
 			}
 		}
 
+		// Determine if we should use the combined batch or not
+		if (CyLandLODMath::UseSubSectionLODs(ComponentScreenSize, ComponentSquaredScreenSizeToUseSubSections, InViewLODScale))
+		{
+			AllSubSectionHaveSameScreenSize = CyLandLODMath::SubSectionsHaveSameScreenSize(SubSectionScreenSizes, NumSubsections * NumSubsections, InViewLODScale);
+		}
+
 		if (!GCyLandDebugOptions.IsCombinedDisabled() && (AllSubSectionHaveSameScreenSize || GCyLandDebugOptions.IsCombinedAll() || ForcedLOD != INDEX_NONE || InForceCombined))
 		{
 			InOutLODData.UseCombinedMeshBatch = true;
@@ -1862,7 +1823,17 @@ void FCyLandComponentSceneProxy::CalculateBatchElementLOD(const FSceneView& InVi
 		FViewCustomDataSubSectionLOD& SubSectionLODData = InOutLODData.SubSections[SubSectionIndex];
 
 		SubSectionLODData.ScreenSizeSquared = ComponentScreenSize;
-		CalculateLODFromScreenSize(InView, SubSectionLODData.ScreenSizeSquared, InViewLODScale, SubSectionIndex, InOutLODData);
+
+		// The solved LOD only applies if the screen size wasn't provided by the caller
+		if (InSolvedLOD && InSolvedLOD->ScreenSizeSquared == ComponentScreenSize)
+		{
+			SubSectionLODData.fBatchElementCurrentLOD = InSolvedLOD->SubSectionLOD[SubSectionIndex];
+			SubSectionLODData.BatchElementCurrentLOD = FMath::FloorToInt(SubSectionLODData.fBatchElementCurrentLOD);
+		}
+		else
+		{
+			CalculateLODFromScreenSize(InView, SubSectionLODData.ScreenSizeSquared, InViewLODScale, SubSectionIndex, InOutLODData);
+		}
 		check(SubSectionLODData.fBatchElementCurrentLOD != -1.0f);
 
 		InOutLODData.ShaderCurrentLOD.Component(SubSectionIndex) = SubSectionLODData.fBatchElementCurrentLOD;
@@ -1888,61 +1859,12 @@ int32 FCyLandComponentSceneProxy::ConvertBatchElementLODToBatchElementIndex(int8
 
 float FCyLandComponentSceneProxy::ComputeBatchElementCurrentLOD(int32 InSelectedLODIndex, float InComponentScreenSize) const
 {
-	check(LODScreenRatioSquared.IsValidIndex(InSelectedLODIndex));
-
-	bool LastElement = InSelectedLODIndex == LODScreenRatioSquared.Num() - 1;
-	float CurrentLODScreenRatio = LODScreenRatioSquared[InSelectedLODIndex];
-	float NextLODScreenRatio = LastElement ? 0 : LODScreenRatioSquared[InSelectedLODIndex + 1];
-
-	float LODScreenRatioRange = CurrentLODScreenRatio - NextLODScreenRatio;
-
-	if (InComponentScreenSize > CurrentLODScreenRatio || InComponentScreenSize < NextLODScreenRatio)
-	{
-		// Find corresponding LODIndex to appropriately calculate Ratio and apply it to new LODIndex
-		int32 LODFromScreenSize = GetLODFromScreenSize(InComponentScreenSize, 1.0f); // for 4.19 only
-		CurrentLODScreenRatio = LODScreenRatioSquared[LODFromScreenSize];
-		NextLODScreenRatio = LODFromScreenSize == LODScreenRatioSquared.Num() - 1 ? 0 : LODScreenRatioSquared[LODFromScreenSize + 1];
-		LODScreenRatioRange = CurrentLODScreenRatio - NextLODScreenRatio;
-	}
-
-	float CurrentLODRangeRatio = (InComponentScreenSize - NextLODScreenRatio) / LODScreenRatioRange;
-	float fLOD = (float)InSelectedLODIndex + (1.0f - CurrentLODRangeRatio);
-
-	return fLOD;
+	return CyLandLODMath::ComputeBatchElementCurrentLOD(LODScreenRatioSquared, InSelectedLODIndex, InComponentScreenSize);
 }
 
 int8 FCyLandComponentSceneProxy::GetLODFromScreenSize(float InScreenSizeSquared, float InViewLODScale) const
 {
-	int32 LODScreenRatioSquaredCount = LODScreenRatioSquared.Num();
-	float ScreenSizeSquared = InScreenSizeSquared / InViewLODScale;
-
-	if (ScreenSizeSquared <= LODScreenRatioSquared[LODScreenRatioSquaredCount - 1])
-	{
-		return LODScreenRatioSquaredCount - 1;
-	}
-	else if (ScreenSizeSquared > LODScreenRatioSquared[1])
-	{
-		return 0;
-	}
-	else
-	{
-		int32 HalfPointIndex = (LODScreenRatioSquaredCount - 1) / 2;
-		int32 StartingIndex = ScreenSizeSquared < LODScreenRatioSquared[HalfPointIndex] ? HalfPointIndex : 1;
-		int8 SelectedLODIndex = INDEX_NONE;
-
-		for (int32 i = StartingIndex; i < LODScreenRatioSquaredCount - 1; ++i)
-		{
-			if (ScreenSizeSquared > LODScreenRatioSquared[i + 1])
-			{
-				SelectedLODIndex = i;
-				break;
-			}
-		}
-
-		return SelectedLODIndex;
-	}
-
-	return INDEX_NONE;
+	return CyLandLODMath::GetLODFromScreenSize(LODScreenRatioSquared, InScreenSizeSquared, InViewLODScale);
 }
 
 void* FCyLandComponentSceneProxy::InitViewCustomData(const FSceneView& InView, float InViewLODScale, FMemStackBase& InCustomDataMemStack, bool InIsStaticRelevant, bool InIsShadowOnly, const FLODMask* InVisiblePrimitiveLODMask, float InMeshScreenSizeSquared)
@@ -1958,13 +1880,22 @@ void* FCyLandComponentSceneProxy::InitViewCustomData(const FSceneView& InView, f
 	check(InMeshScreenSizeSquared <= 1.0f);
 	LODData->ComponentScreenSize = InMeshScreenSizeSquared;
 
+	// Solve the screen sizes of the whole landscape for this view at once, or read what another proxy solved for it
+	FCyLandComponentLOD SolverLOD;
+	const FCyLandComponentLOD* SolvedLOD = nullptr;
+	if (LODSolver && FCyLandLODSolver::IsEnabled())
+	{
+		SolverLOD = LODSolver->Solve(InView, InViewLODScale, this);
+		SolvedLOD = &SolverLOD;
+	}
+
 	// If a valid screen size was provided, we use it instead of recomputing it
 	if (InMeshScreenSizeSquared < 0.0f)
 	{
-		LODData->ComponentScreenSize = GetComponentScreenSize(&InView, CyLandComponent->Bounds.Origin, ComponentMaxExtend, CyLandComponent->Bounds.SphereRadius);
+		LODData->ComponentScreenSize = SolvedLOD ? SolvedLOD->ScreenSizeSquared : GetComponentScreenSize(&InView, CyLandComponent->Bounds.Origin, ComponentMaxExtend, CyLandComponent->Bounds.SphereRadius);
 	}
 
-	CalculateBatchElementLOD(InView, LODData->ComponentScreenSize, InViewLODScale, *LODData, false);
+	CalculateBatchElementLOD(InView, LODData->ComponentScreenSize, InViewLODScale, *LODData, false, SolvedLOD);
 
 	if (InIsStaticRelevant)
 	{
@@ -2140,6 +2071,18 @@ float FCyLandComponentSceneProxy::GetNeighborLOD(const FSceneView& InView, float
 		}
 	}
 
+	// Neighbors without custom data may still have solved their LODs with the same LOD scale the computation below uses
+	if (ComputeNeighborCustomDataLOD && LODSolver)
+	{
+		const int32 NeighborSlot = Neighbor != nullptr ? Neighbor->LODSolverSlot : LODSolverSlot;
+		FCyLandComponentLOD SolvedLOD;
+		if (NeighborSlot != INDEX_NONE && LODSolver->Find(InView, InView.LODDistanceFactor, NeighborSlot, SolvedLOD))
+		{
+			ComputeNeighborCustomDataLOD = false;
+			NeighborLOD = FMath::Max(SolvedLOD.SubSectionLOD[DesiredSubSectionIndex], InBatchElementCurrentLOD);
+		}
+	}
+
 	if (ComputeNeighborCustomDataLOD)
 	{
 		FVector CyLandComponentOrigin = CyLandComponent->Bounds.Origin;
@@ -2266,13 +2209,12 @@ bool FCyLandComponentSceneProxy::CanUseMeshBatchForShadowCascade(int8 InLODIndex
 
 	check(MeshBatch != nullptr);
 
-	if (!MeshBatch->CastShadow || MeshBatch->TessellationDisablingShadowMapMeshSize == 0)
+	if (!MeshBatch->CastShadow)
 	{
 		return true;
 	}
 
-	float WorldUnitsForOneTexel = InShadowMapCascadeSize / InShadowMapTextureResolution; // We assume Shadow Map texture to be squared
-	return MeshBatch->TessellationDisablingShadowMapMeshSize >= WorldUnitsForOneTexel * (GShadowMapWorldUnitsToTexelFactor != -1.0f ? GShadowMapWorldUnitsToTexelFactor : 1.0f);
+	return CyLandLODMath::CanUseTessellationForShadowCascade(MeshBatch->TessellationDisablingShadowMapMeshSize, InShadowMapTextureResolution, InShadowMapCascadeSize, GShadowMapWorldUnitsToTexelFactor);
 }
 
 FLODMask FCyLandComponentSceneProxy::GetCustomLOD(const FSceneView& InView, float InViewLODScale, int32 InForcedLODLevel, float& OutScreenSizeSquared) const
@@ -2335,7 +2277,7 @@ FLODMask FCyLandComponentSceneProxy::GetCustomLOD(const FSceneView& InView, floa
 		{
 			const int8 TessellatedMeshBatchLODIndex = 0;
 			const int8 NonTessellatedMeshBatchLODIndex = 1;
-			LODToRender.SetLOD(OutScreenSizeSquared >= TessellationComponentSquaredScreenSize * InViewLODScale ? BaseMeshBatchIndex + TessellatedMeshBatchLODIndex : BaseMeshBatchIndex + NonTessellatedMeshBatchLODIndex);
+			LODToRender.SetLOD(CyLandLODMath::UseTessellation(OutScreenSizeSquared, TessellationComponentSquaredScreenSize, InViewLODScale) ? BaseMeshBatchIndex + TessellatedMeshBatchLODIndex : BaseMeshBatchIndex + NonTessellatedMeshBatchLODIndex);
 		}
 		else
 		{
@@ -2425,7 +2367,7 @@ FLODMask FCyLandComponentSceneProxy::GetCustomWholeSceneShadowLOD(const FSceneVi
 			const int8 ShadowTessellatedMeshBatchLODIndex = 2;
 			const int8 ShadowNonTessellatedMeshBatchLODIndex = 3;
 
-			bool UseTessellationMeshBatch = ScreenSizeSquared >= TessellationComponentSquaredScreenSize * InViewLODScale;
+			bool UseTessellationMeshBatch = CyLandLODMath::UseTessellation(ScreenSizeSquared, TessellationComponentSquaredScreenSize, InViewLODScale);
 
 			if (UseTessellationMeshBatch)
 			{
@@ -2532,7 +2474,7 @@ void FCyLandComponentSceneProxy::GetDynamicMeshElements(const TArray<const FScen
 			{
 				check(AvailableMaterials.Num() > 1);
 				float ScreenSizeSquared = GetComponentScreenSize(View, CyLandComponent->Bounds.Origin, ComponentMaxExtend, CyLandComponent->Bounds.SphereRadius);
-				DisableTessellation = (ScreenSizeSquared < TessellationComponentSquaredScreenSize * View->LODDistanceFactor) ? true : false;
+				DisableTessellation = !CyLandLODMath::UseTessellation(ScreenSizeSquared, TessellationComponentSquaredScreenSize, View->LODDistanceFactor);
 
 				if (!DisableTessellation)
 				{
@@ -2845,18 +2787,9 @@ bool FCyLandComponentSceneProxy::CollectOccluderElements(FOccluderElementsCollec
 //
 // FCyLandVertexBuffer
 //
-/**
-* Initialize the RHI for this rendering resource
-*/
-void FCyLandVertexBuffer::InitRHI()
+template <typename VertexType>
+static void FillCyLandVertices(VertexType* Vertex, int32 SubsectionSizeVerts, int32 NumSubsections)
 {
-	//UE_LOG(LogCyLand, Warning, TEXT("ACyLand InitRHI"));
-	// create a static vertex buffer
-	FRHIResourceCreateInfo CreateInfo;
-	void* BufferData = nullptr;
-	VertexBufferRHI = RHICreateAndLockVertexBuffer(NumVertices * sizeof(FCyLandVertex), BUF_Static, CreateInfo, BufferData);
-	FCyLandVertex* Vertex = (FCyLandVertex*)BufferData;
-	int32 VertexIndex = 0;
 	for (int32 SubY = 0; SubY < NumSubsections; SubY++)
 	{
 		for (int32 SubX = 0; SubX < NumSubsections; SubX++)
@@ -2865,18 +2798,55 @@ void FCyLandVertexBuffer::InitRHI()
 			{
 				for (int32 x = 0; x < SubsectionSizeVerts; x++)
 				{
-					Vertex->VertexX = x;
-					Vertex->VertexY = y;
-					Vertex->SubX = SubX;
-					Vertex->SubY = SubY;
+					Vertex->VertexX = (float)x;
+					Vertex->VertexY = (float)y;
+					Vertex->SubX = (float)SubX;
+					Vertex->SubY = (float)SubY;
 					Vertex++;
-					VertexIndex++;
 				}
 			}
 		}
 	}
-	check(NumVertices == VertexIndex);
+}
+
+void FCyLandVertexBuffer::FillVertices(void* OutVertices, int32 InSubsectionSizeVerts, int32 InNumSubsections, bool bInPacked)
+{
+	if (bInPacked)
+	{
+		// Halves hold integers up to 2048 exactly, sub-sections have at most 256 vertices a side
+		check(InSubsectionSizeVerts <= 2048);
+		FillCyLandVertices((FCyLandPackedVertex*)OutVertices, InSubsectionSizeVerts, InNumSubsections);
+	}
+	else
+	{
+		FillCyLandVertices((FCyLandVertex*)OutVertices, InSubsectionSizeVerts, InNumSubsections);
+	}
+}
+
+/**
+* Initialize the RHI for this rendering resource
+*/
+void FCyLandVertexBuffer::InitRHI()
+{
+	//UE_LOG(LogCyLand, Warning, TEXT("ACyLand InitRHI"));
+	// create a static vertex buffer
+	FRHIResourceCreateInfo CreateInfo;
+	void* BufferData = nullptr;
+	check(NumVertices == FMath::Square(SubsectionSizeVerts) * FMath::Square(NumSubsections));
+	VertexBufferRHI = RHICreateAndLockVertexBuffer(NumVertices * GetStride(), BUF_Static, CreateInfo, BufferData);
+	FillVertices(BufferData, SubsectionSizeVerts, NumSubsections, bPacked);
 	RHIUnlockVertexBuffer(VertexBufferRHI);
+
+	INC_DWORD_STAT_BY(STAT_CyLandVertexMem, NumVertices * GetStride());
+}
+
+void FCyLandVertexBuffer::ReleaseRHI()
+{
+	if (VertexBufferRHI.IsValid())
+	{
+		DEC_DWORD_STAT_BY(STAT_CyLandVertexMem, NumVertices * GetStride());
+	}
+	FVertexBuffer::ReleaseRHI();
 }
 
 //
@@ -2884,15 +2854,14 @@ void FCyLandVertexBuffer::InitRHI()
 //
 
 template <typename INDEX_TYPE>
-void FCyLandSharedBuffers::CreateIndexBuffers(ERHIFeatureLevel::Type InFeatureLevel, bool bRequiresAdjacencyInformation)
+void FCyLandSharedBuffers::CreateIndexBuffers()
 {
 	//UE_LOG(LogCyLand, Warning, TEXT("ACyLand CreateIndexBuffers"));
-	if (InFeatureLevel <= ERHIFeatureLevel::ES3_1)
+	SCOPE_CYCLE_COUNTER(STAT_CyLandIndexBufferCreation);
+
+	if (!bVertexScoresComputed)
 	{
-		if (!bVertexScoresComputed)
-		{
-			bVertexScoresComputed = ComputeVertexScores();
-		}
+		bVertexScoresComputed = ComputeVertexScores();
 	}
 
 	TMap<uint64, INDEX_TYPE> VertexMap;
@@ -2914,191 +2883,288 @@ void FCyLandSharedBuffers::CreateIndexBuffers(ERHIFeatureLevel::Type InFeatureLe
 		MaxIndexFull = 0;
 		MinIndexFull = MAX_int32;
 
-		if (InFeatureLevel <= ERHIFeatureLevel::ES3_1)
-		{
-			// ES2 version
-			float MipRatio = (float)SubsectionSizeQuads / (float)LodSubsectionSizeQuads; // Morph current MIP to base MIP
+		// ES2 version
+		float MipRatio = (float)SubsectionSizeQuads / (float)LodSubsectionSizeQuads; // Morph current MIP to base MIP
 
-			for (int32 SubY = 0; SubY < NumSubsections; SubY++)
+		for (int32 SubY = 0; SubY < NumSubsections; SubY++)
+		{
+			for (int32 SubX = 0; SubX < NumSubsections; SubX++)
 			{
-				for (int32 SubX = 0; SubX < NumSubsections; SubX++)
-				{
-					TArray<INDEX_TYPE> SubIndices;
-					SubIndices.Empty(FMath::Square(LodSubsectionSizeQuads) * 6);
+				TArray<INDEX_TYPE> SubIndices;
+				SubIndices.Empty(FMath::Square(LodSubsectionSizeQuads) * 6);
 
-					int32& MaxIndex = IndexRanges[Mip].MaxIndex[SubX][SubY];
-					int32& MinIndex = IndexRanges[Mip].MinIndex[SubX][SubY];
-					MaxIndex = 0;
-					MinIndex = MAX_int32;
+				int32& MaxIndex = IndexRanges[Mip].MaxIndex[SubX][SubY];
+				int32& MinIndex = IndexRanges[Mip].MinIndex[SubX][SubY];
+				MaxIndex = 0;
+				MinIndex = MAX_int32;
 
-					for (int32 y = 0; y < LodSubsectionSizeQuads; y++)
+				for (int32 y = 0; y < LodSubsectionSizeQuads; y++)
+				{
+					for (int32 x = 0; x < LodSubsectionSizeQuads; x++)
 					{
-						for (int32 x = 0; x < LodSubsectionSizeQuads; x++)
+						int32 x0 = FMath::RoundToInt((float)x * MipRatio);
+						int32 y0 = FMath::RoundToInt((float)y * MipRatio);
+						int32 x1 = FMath::RoundToInt((float)(x + 1) * MipRatio);
+						int32 y1 = FMath::RoundToInt((float)(y + 1) * MipRatio);
+
+						FCyLandVertexRef V00(x0, y0, SubX, SubY);
+						FCyLandVertexRef V10(x1, y0, SubX, SubY);
+						FCyLandVertexRef V11(x1, y1, SubX, SubY);
+						FCyLandVertexRef V01(x0, y1, SubX, SubY);
+
+						uint64 Key00 = V00.MakeKey();
+						uint64 Key10 = V10.MakeKey();
+						uint64 Key11 = V11.MakeKey();
+						uint64 Key01 = V01.MakeKey();
+
+						INDEX_TYPE i00;
+						INDEX_TYPE i10;
+						INDEX_TYPE i11;
+						INDEX_TYPE i01;
+
+						INDEX_TYPE* KeyPtr = VertexMap.Find(Key00);
+						if (KeyPtr == nullptr)
 						{
-							int32 x0 = FMath::RoundToInt((float)x * MipRatio);
-							int32 y0 = FMath::RoundToInt((float)y * MipRatio);
-							int32 x1 = FMath::RoundToInt((float)(x + 1) * MipRatio);
-							int32 y1 = FMath::RoundToInt((float)(y + 1) * MipRatio);
-
-							FCyLandVertexRef V00(x0, y0, SubX, SubY);
-							FCyLandVertexRef V10(x1, y0, SubX, SubY);
-							FCyLandVertexRef V11(x1, y1, SubX, SubY);
-							FCyLandVertexRef V01(x0, y1, SubX, SubY);
-
-							uint64 Key00 = V00.MakeKey();
-							uint64 Key10 = V10.MakeKey();
-							uint64 Key11 = V11.MakeKey();
-							uint64 Key01 = V01.MakeKey();
-
-							INDEX_TYPE i00;
-							INDEX_TYPE i10;
-							INDEX_TYPE i11;
-							INDEX_TYPE i01;
-
-							INDEX_TYPE* KeyPtr = VertexMap.Find(Key00);
-							if (KeyPtr == nullptr)
-							{
-								i00 = VertexCount++;
-								VertexMap.Add(Key00, i00);
-							}
-							else
-							{
-								i00 = *KeyPtr;
-							}
-
-							KeyPtr = VertexMap.Find(Key10);
-							if (KeyPtr == nullptr)
-							{
-								i10 = VertexCount++;
-								VertexMap.Add(Key10, i10);
-							}
-							else
-							{
-								i10 = *KeyPtr;
-							}
+							i00 = VertexCount++;
+							VertexMap.Add(Key00, i00);
+						}
+						else
+						{
+							i00 = *KeyPtr;
+						}
 
-							KeyPtr = VertexMap.Find(Key11);
-							if (KeyPtr == nullptr)
-							{
-								i11 = VertexCount++;
-								VertexMap.Add(Key11, i11);
-							}
-							else
-							{
-								i11 = *KeyPtr;
-							}
+						KeyPtr = VertexMap.Find(Key10);
+						if (KeyPtr == nullptr)
+						{
+							i10 = VertexCount++;
+							VertexMap.Add(Key10, i10);
+						}
+						else
+						{
+							i10 = *KeyPtr;
+						}
 
-							KeyPtr = VertexMap.Find(Key01);
-							if (KeyPtr == nullptr)
-							{
-								i01 = VertexCount++;
-								VertexMap.Add(Key01, i01);
-							}
-							else
-							{
-								i01 = *KeyPtr;
-							}
+						KeyPtr = VertexMap.Find(Key11);
+						if (KeyPtr == nullptr)
+						{
+							i11 = VertexCount++;
+							VertexMap.Add(Key11, i11);
+						}
+						else
+						{
+							i11 = *KeyPtr;
+						}
 
-							// Update the min/max index ranges
-							MaxIndex = FMath::Max<int32>(MaxIndex, i00);
-							MinIndex = FMath::Min<int32>(MinIndex, i00);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i10);
-							MinIndex = FMath::Min<int32>(MinIndex, i10);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i11);
-							MinIndex = FMath::Min<int32>(MinIndex, i11);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i01);
-							MinIndex = FMath::Min<int32>(MinIndex, i01);
-
-							SubIndices.Add(i00);
-							SubIndices.Add(i11);
-							SubIndices.Add(i10);
-
-							SubIndices.Add(i00);
-							SubIndices.Add(i01);
-							SubIndices.Add(i11);
+						KeyPtr = VertexMap.Find(Key01);
+						if (KeyPtr == nullptr)
+						{
+							i01 = VertexCount++;
+							VertexMap.Add(Key01, i01);
+						}
+						else
+						{
+							i01 = *KeyPtr;
 						}
+
+						// Update the min/max index ranges
+						MaxIndex = FMath::Max<int32>(MaxIndex, i00);
+						MinIndex = FMath::Min<int32>(MinIndex, i00);
+						MaxIndex = FMath::Max<int32>(MaxIndex, i10);
+						MinIndex = FMath::Min<int32>(MinIndex, i10);
+						MaxIndex = FMath::Max<int32>(MaxIndex, i11);
+						MinIndex = FMath::Min<int32>(MinIndex, i11);
+						MaxIndex = FMath::Max<int32>(MaxIndex, i01);
+						MinIndex = FMath::Min<int32>(MinIndex, i01);
+
+						SubIndices.Add(i00);
+						SubIndices.Add(i11);
+						SubIndices.Add(i10);
+
+						SubIndices.Add(i00);
+						SubIndices.Add(i01);
+						SubIndices.Add(i11);
 					}
+				}
 
-					// update min/max for full subsection
-					MaxIndexFull = FMath::Max<int32>(MaxIndexFull, MaxIndex);
-					MinIndexFull = FMath::Min<int32>(MinIndexFull, MinIndex);
+				// update min/max for full subsection
+				MaxIndexFull = FMath::Max<int32>(MaxIndexFull, MaxIndex);
+				MinIndexFull = FMath::Min<int32>(MinIndexFull, MinIndex);
 
-					TArray<INDEX_TYPE> NewSubIndices;
-					::OptimizeFaces<INDEX_TYPE>(SubIndices, NewSubIndices, 32);
-					NewIndices.Append(NewSubIndices);
-				}
+				TArray<INDEX_TYPE> NewSubIndices;
+				::OptimizeFaces<INDEX_TYPE>(SubIndices, NewSubIndices, 32);
+				NewIndices.Append(NewSubIndices);
 			}
 		}
-		else
+
+		// Create and init new index buffer with index data
+		FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = (FRawStaticIndexBuffer16or32<INDEX_TYPE>*)IndexBuffers[Mip];
+		if (!IndexBuffer)
 		{
-			// non-ES2 version
-			int32 SubOffset = 0;
-			for (int32 SubY = 0; SubY < NumSubsections; SubY++)
+			IndexBuffer = new FRawStaticIndexBuffer16or32<INDEX_TYPE>(false);
+		}
+		IndexBuffer->AssignNewBuffer(NewIndices);
+		IndexBuffer->InitResource();
+
+		IndexBuffers[Mip] = IndexBuffer;
+		IndexBufferSize += NewIndices.Num() * sizeof(INDEX_TYPE);
+	}
+
+	BuiltLODMask = (1u << NumIndexBuffers) - 1;
+	INC_MEMORY_STAT_BY(STAT_CyLandIndexMem, IndexBufferSize);
+}
+
+
+void FCyLandSharedBuffers::InitGridIndexRanges()
+{
+	for (int32 Mip = 0; Mip < NumIndexBuffers; Mip++)
+	{
+		const int32 LodSubsectionSizeQuads = (SubsectionSizeVerts >> Mip) - 1;
+
+		FCyLandIndexRanges& Ranges = IndexRanges[Mip];
+		Ranges.MaxIndexFull = 0;
+		Ranges.MinIndexFull = MAX_int32;
+
+		int32 SubOffset = 0;
+		for (int32 SubY = 0; SubY < NumSubsections; SubY++)
+		{
+			for (int32 SubX = 0; SubX < NumSubsections; SubX++)
 			{
-				for (int32 SubX = 0; SubX < NumSubsections; SubX++)
-				{
-					int32& MaxIndex = IndexRanges[Mip].MaxIndex[SubX][SubY];
-					int32& MinIndex = IndexRanges[Mip].MinIndex[SubX][SubY];
-					MaxIndex = 0;
-					MinIndex = MAX_int32;
+				// From the first vertex of the sub-section to the last vertex the LOD uses, see BuildGridIndices
+				Ranges.MinIndex[SubX][SubY] = SubOffset;
+				Ranges.MaxIndex[SubX][SubY] = SubOffset + LodSubsectionSizeQuads * (SubsectionSizeVerts + 1);
 
-					for (int32 y = 0; y < LodSubsectionSizeQuads; y++)
-					{
-						for (int32 x = 0; x < LodSubsectionSizeQuads; x++)
-						{
-							INDEX_TYPE i00 = (x + 0) + (y + 0) * SubsectionSizeVerts + SubOffset;
-							INDEX_TYPE i10 = (x + 1) + (y + 0) * SubsectionSizeVerts + SubOffset;
-							INDEX_TYPE i11 = (x + 1) + (y + 1) * SubsectionSizeVerts + SubOffset;
-							INDEX_TYPE i01 = (x + 0) + (y + 1) * SubsectionSizeVerts + SubOffset;
-
-							NewIndices.Add(i00);
-							NewIndices.Add(i11);
-							NewIndices.Add(i10);
-
-							NewIndices.Add(i00);
-							NewIndices.Add(i01);
-							NewIndices.Add(i11);
-
-							// Update the min/max index ranges
-							MaxIndex = FMath::Max<int32>(MaxIndex, i00);
-							MinIndex = FMath::Min<int32>(MinIndex, i00);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i10);
-							MinIndex = FMath::Min<int32>(MinIndex, i10);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i11);
-							MinIndex = FMath::Min<int32>(MinIndex, i11);
-							MaxIndex = FMath::Max<int32>(MaxIndex, i01);
-							MinIndex = FMath::Min<int32>(MinIndex, i01);
-						}
-					}
+				// update min/max for full subsection
+				Ranges.MaxIndexFull = FMath::Max<int32>(Ranges.MaxIndexFull, Ranges.MaxIndex[SubX][SubY]);
+				Ranges.MinIndexFull = FMath::Min<int32>(Ranges.MinIndexFull, Ranges.MinIndex[SubX][SubY]);
 
-					// update min/max for full subsection
-					MaxIndexFull = FMath::Max<int32>(MaxIndexFull, MaxIndex);
-					MinIndexFull = FMath::Min<int32>(MinIndexFull, MinIndex);
+				SubOffset += FMath::Square(SubsectionSizeVerts);
+			}
+		}
+	}
+}
+
+template <typename INDEX_TYPE>
+void FCyLandSharedBuffers::BuildGridIndices(int32 Mip, TArray<INDEX_TYPE>& OutIndices) const
+{
+	int32 LodSubsectionSizeQuads = (SubsectionSizeVerts >> Mip) - 1;
+	int32 ExpectedNumIndices = FMath::Square(NumSubsections) * FMath::Square(LodSubsectionSizeQuads) * 6;
+	OutIndices.Reset(ExpectedNumIndices);
 
-					SubOffset += FMath::Square(SubsectionSizeVerts);
+	int32 SubOffset = 0;
+	for (int32 SubY = 0; SubY < NumSubsections; SubY++)
+	{
+		for (int32 SubX = 0; SubX < NumSubsections; SubX++)
+		{
+			for (int32 y = 0; y < LodSubsectionSizeQuads; y++)
+			{
+				for (int32 x = 0; x < LodSubsectionSizeQuads; x++)
+				{
+					INDEX_TYPE i00 = (x + 0) + (y + 0) * SubsectionSizeVerts + SubOffset;
+					INDEX_TYPE i10 = (x + 1) + (y + 0) * SubsectionSizeVerts + SubOffset;
+					INDEX_TYPE i11 = (x + 1) + (y + 1) * SubsectionSizeVerts + SubOffset;
+					INDEX_TYPE i01 = (x + 0) + (y + 1) * SubsectionSizeVerts + SubOffset;
+
+					OutIndices.Add(i00);
+					OutIndices.Add(i11);
+					OutIndices.Add(i10);
+
+					OutIndices.Add(i00);
+					OutIndices.Add(i01);
+					OutIndices.Add(i11);
 				}
 			}
 
-			check(MinIndexFull <= (uint32)((INDEX_TYPE)(~(INDEX_TYPE)0)));
-			check(NewIndices.Num() == ExpectedNumIndices);
+			SubOffset += FMath::Square(SubsectionSizeVerts);
 		}
+	}
 
-		// Create and init new index buffer with index data
-		FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = (FRawStaticIndexBuffer16or32<INDEX_TYPE>*)IndexBuffers[Mip];
-		if (!IndexBuffer)
+	check(OutIndices.Num() == ExpectedNumIndices);
+}
+
+template <typename INDEX_TYPE>
+void FCyLandSharedBuffers::CreateLODIndexBuffers(int32 MinLOD, int32 MaxLOD, bool bRequiresAdjacencyInformation)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandIndexBufferCreation);
+
+	if (bRequiresAdjacencyInformation && AdjacencyIndexBuffers == nullptr)
+	{
+		AdjacencyIndexBuffers = new FCyLandSharedAdjacencyIndexBuffer(this);
+	}
+
+	const SIZE_T PreviousIndexBufferSize = IndexBufferSize;
+	TArray<INDEX_TYPE> NewIndices;
+
+	for (int32 Mip = MinLOD; Mip <= MaxLOD; Mip++)
+	{
+		const uint32 LODBit = 1u << Mip;
+		const bool bBuildIndices = (BuiltLODMask & LODBit) == 0;
+		const bool bBuildAdjacency = bRequiresAdjacencyInformation && (BuiltAdjacencyLODMask & LODBit) == 0;
+		if (!bBuildIndices && !bBuildAdjacency)
 		{
-			IndexBuffer = new FRawStaticIndexBuffer16or32<INDEX_TYPE>(false);
+			continue;
 		}
-		IndexBuffer->AssignNewBuffer(NewIndices);
 
-		// Delay init resource to keep CPU data until create AdjacencyIndexbuffers
-		if (!bRequiresAdjacencyInformation)
+		// The CPU copy of built LODs is gone once they are initialized, the grid is cheaper to lay out again than to keep
+		BuildGridIndices<INDEX_TYPE>(Mip, NewIndices);
+
+		if (bBuildIndices)
 		{
+			FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = (FRawStaticIndexBuffer16or32<INDEX_TYPE>*)IndexBuffers[Mip];
+			IndexBuffer->AssignNewBuffer(NewIndices);
 			IndexBuffer->InitResource();
+
+			IndexBufferSize += NewIndices.Num() * sizeof(INDEX_TYPE);
+			BuiltLODMask |= LODBit;
 		}
 
-		IndexBuffers[Mip] = IndexBuffer;
+		if (bBuildAdjacency)
+		{
+			AdjacencyIndexBuffers->CreateLOD<INDEX_TYPE>(Mip, (SubsectionSizeVerts >> Mip) - 1, NumSubsections, NewIndices);
+
+			// PN-AEN patches have 12 indices per triangle
+			IndexBufferSize += NewIndices.Num() * 4 * sizeof(INDEX_TYPE);
+			BuiltAdjacencyLODMask |= LODBit;
+		}
+	}
+
+	INC_MEMORY_STAT_BY(STAT_CyLandIndexMem, IndexBufferSize - PreviousIndexBufferSize);
+}
+
+void FCyLandSharedBuffers::RequestLODs(int32 MinLOD, int32 MaxLOD, bool bRequiresAdjacencyInformation)
+{
+	check(IsInRenderingThread());
+
+	if (!bSupportsLODRequests)
+	{
+		// Every LOD was built with the buffers
+		return;
+	}
+
+	MinLOD = FMath::Clamp(MinLOD, 0, NumIndexBuffers - 1);
+	MaxLOD = FMath::Clamp(MaxLOD, MinLOD, NumIndexBuffers - 1);
+
+	if (bUse32BitIndices)
+	{
+		CreateLODIndexBuffers<uint32>(MinLOD, MaxLOD, bRequiresAdjacencyInformation);
+	}
+	else
+	{
+		CreateLODIndexBuffers<uint16>(MinLOD, MaxLOD, bRequiresAdjacencyInformation);
+	}
+}
+
+SIZE_T FCyLandSharedBuffers::GetResourceSize() const
+{
+	SIZE_T ResourceSize = IndexBufferSize;
+	if (VertexBuffer)
+	{
+		ResourceSize += NumVertices * VertexBuffer->GetStride();
+	}
+	if (OccluderIndicesSP.IsValid())
+	{
+		ResourceSize += OccluderIndicesSP->GetAllocatedSize();
 	}
+	return ResourceSize;
 }
 
 void FCyLandSharedBuffers::CreateOccluderIndexBuffer(int32 NumOccluderVertices)
@@ -3153,8 +3219,8 @@ void FCyLandSharedBuffers::CreateGrassIndexBuffer()
 
 	for (int32 Mip = 0; Mip < NumMips; ++Mip)
 	{
-		// Store offset to the start of this mip in the index buffer
-		GrassIndexMipOffsets.Add(NewIndices.Num());
+		// Offsets to the start of each mip were laid out with the buffers for the grass mesh batches
+		check(GrassIndexMipOffsets[Mip] == NewIndices.Num());
 
 		int32 MipSubsectionSizeVerts = SubsectionSizeVerts >> Mip;
 		int32 SubOffset = 0;
@@ -3179,15 +3245,36 @@ void FCyLandSharedBuffers::CreateGrassIndexBuffer()
 
 	check(NewIndices.Num() == ExpectedNumIndices);
 
-	// Create and init new index buffer with index data
-	FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = new FRawStaticIndexBuffer16or32<INDEX_TYPE>(false);
+	// Init the index buffer the grass mesh batches point at with index data
+	FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = (FRawStaticIndexBuffer16or32<INDEX_TYPE>*)GrassIndexBuffer;
 	IndexBuffer->AssignNewBuffer(NewIndices);
 	IndexBuffer->InitResource();
-	GrassIndexBuffer = IndexBuffer;
+
+	IndexBufferSize += NewIndices.Num() * sizeof(INDEX_TYPE);
+	INC_MEMORY_STAT_BY(STAT_CyLandIndexMem, NewIndices.Num() * sizeof(INDEX_TYPE));
+}
+
+void FCyLandSharedBuffers::RequestGrassIndexBuffer()
+{
+	check(IsInRenderingThread());
+
+	if (GrassIndexBuffer && !GrassIndexBuffer->IsInitialized())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CyLandIndexBufferCreation);
+
+		if (bUse32BitIndices)
+		{
+			CreateGrassIndexBuffer<uint32>();
+		}
+		else
+		{
+			CreateGrassIndexBuffer<uint16>();
+		}
+	}
 }
 #endif
 
-FCyLandSharedBuffers::FCyLandSharedBuffers(const int32 InSharedBuffersKey, const int32 InSubsectionSizeQuads, const int32 InNumSubsections, const ERHIFeatureLevel::Type InFeatureLevel, const bool bRequiresAdjacencyInformation, int32 NumOccluderVertices)
+FCyLandSharedBuffers::FCyLandSharedBuffers(const int32 InSharedBuffersKey, const int32 InSubsectionSizeQuads, const int32 InNumSubsections, const ERHIFeatureLevel::Type InFeatureLevel, int32 NumOccluderVertices)
 	: SharedBuffersKey(InSharedBuffersKey)
 	, NumIndexBuffers(FMath::CeilLogTwo(InSubsectionSizeQuads + 1))
 	, SubsectionSizeVerts(InSubsectionSizeQuads + 1)
@@ -3196,41 +3283,54 @@ FCyLandSharedBuffers::FCyLandSharedBuffers(const int32 InSharedBuffersKey, const
 	, VertexBuffer(nullptr)
 	, AdjacencyIndexBuffers(nullptr)
 	, bUse32BitIndices(false)
+	, BuiltLODMask(0)
+	, BuiltAdjacencyLODMask(0)
+	, IndexBufferSize(0)
 #if WITH_EDITOR
 	, GrassIndexBuffer(nullptr)
 #endif
+	, bSupportsLODRequests(InFeatureLevel > ERHIFeatureLevel::ES3_1)
 {
 	NumVertices = FMath::Square(SubsectionSizeVerts) * FMath::Square(NumSubsections);
 	if (InFeatureLevel > ERHIFeatureLevel::ES3_1)
 	{
 		// Vertex Buffer cannot be shared
-		VertexBuffer = new FCyLandVertexBuffer(InFeatureLevel, NumVertices, SubsectionSizeVerts, NumSubsections);
+		VertexBuffer = new FCyLandVertexBuffer(InFeatureLevel, NumVertices, SubsectionSizeVerts, NumSubsections, GCyLandPackedVertices != 0);
 	}
 	IndexBuffers = new FIndexBuffer*[NumIndexBuffers];
 	FMemory::Memzero(IndexBuffers, sizeof(FIndexBuffer*)* NumIndexBuffers);
 	IndexRanges = new FCyLandIndexRanges[NumIndexBuffers]();
 
 	// See if we need to use 16 or 32-bit index buffers
-	if (NumVertices > 65535)
+	bUse32BitIndices = NumVertices > 65535;
+
+	if (bSupportsLODRequests)
 	{
-		bUse32BitIndices = true;
-		CreateIndexBuffers<uint32>(InFeatureLevel, bRequiresAdjacencyInformation);
+		// Buffers of every LOD exist up front for the mesh batches to point at, the LODs proxies request are built in RequestLODs
+		for (int32 Mip = 0; Mip < NumIndexBuffers; Mip++)
+		{
+			IndexBuffers[Mip] = bUse32BitIndices ? (FIndexBuffer*)new FRawStaticIndexBuffer16or32<uint32>(false) : (FIndexBuffer*)new FRawStaticIndexBuffer16or32<uint16>(false);
+		}
+		InitGridIndexRanges();
+
 #if WITH_EDITOR
-		if (InFeatureLevel > ERHIFeatureLevel::ES3_1)
+		const int32 NumMips = FMath::CeilLogTwo(SubsectionSizeVerts);
+		int32 MipOffset = 0;
+		for (int32 Mip = 0; Mip < NumMips; ++Mip)
 		{
-			CreateGrassIndexBuffer<uint32>();
+			GrassIndexMipOffsets.Add(MipOffset);
+			MipOffset += FMath::Square(NumSubsections) * FMath::Square(SubsectionSizeVerts >> Mip);
 		}
+		GrassIndexBuffer = bUse32BitIndices ? (FIndexBuffer*)new FRawStaticIndexBuffer16or32<uint32>(false) : (FIndexBuffer*)new FRawStaticIndexBuffer16or32<uint16>(false);
 #endif
 	}
+	else if (bUse32BitIndices)
+	{
+		CreateIndexBuffers<uint32>();
+	}
 	else
 	{
-		CreateIndexBuffers<uint16>(InFeatureLevel, bRequiresAdjacencyInformation);
-#if WITH_EDITOR
-		if (InFeatureLevel > ERHIFeatureLevel::ES3_1)
-		{
-			CreateGrassIndexBuffer<uint16>();
-		}
-#endif
+		CreateIndexBuffers<uint16>();
 	}
 
 	CreateOccluderIndexBuffer(NumOccluderVertices);
@@ -3259,6 +3359,8 @@ FCyLandSharedBuffers::~FCyLandSharedBuffers()
 	delete AdjacencyIndexBuffers;
 	delete VertexFactory;
 
+	DEC_MEMORY_STAT_BY(STAT_CyLandIndexMem, IndexBufferSize);
+
 	if (OccluderIndicesSP.IsValid())
 	{
 		DEC_DWORD_STAT_BY(STAT_CyLandOccluderMem, OccluderIndicesSP->GetAllocatedSize());
@@ -3266,9 +3368,9 @@ FCyLandSharedBuffers::~FCyLandSharedBuffers()
 }
 
 template<typename IndexType>
-static void BuildCyLandAdjacencyIndexBuffer(int32 LODSubsectionSizeQuads, int32 NumSubsections, const FRawStaticIndexBuffer16or32<IndexType>* Indices, TArray<IndexType>& OutPnAenIndices)
+static void BuildCyLandAdjacencyIndexBuffer(int32 LODSubsectionSizeQuads, int32 NumSubsections, const TArray<IndexType>& Indices, TArray<IndexType>& OutPnAenIndices)
 {
-	if (Indices && Indices->Num())
+	if (Indices.Num())
 	{
 		// CyLand use regular grid, so only expand Index buffer works
 		// PN AEN Dominant Corner
@@ -3289,20 +3391,20 @@ static void BuildCyLandAdjacencyIndexBuffer(int32 LODSubsectionSizeQuads, int32
 				{
 					uint32 OutStartIdx = TriIdx * 12;
 					uint32 InStartIdx = TriIdx * 3;
-					OutPnAenIndices[OutStartIdx + 0] = Indices->Get(InStartIdx + 0);
-					OutPnAenIndices[OutStartIdx + 1] = Indices->Get(InStartIdx + 1);
-					OutPnAenIndices[OutStartIdx + 2] = Indices->Get(InStartIdx + 2);
-
-					OutPnAenIndices[OutStartIdx + 3] = Indices->Get(InStartIdx + 0);
-					OutPnAenIndices[OutStartIdx + 4] = Indices->Get(InStartIdx + 1);
-					OutPnAenIndices[OutStartIdx + 5] = Indices->Get(InStartIdx + 1);
-					OutPnAenIndices[OutStartIdx + 6] = Indices->Get(InStartIdx + 2);
-					OutPnAenIndices[OutStartIdx + 7] = Indices->Get(InStartIdx + 2);
-					OutPnAenIndices[OutStartIdx + 8] = Indices->Get(InStartIdx + 0);
-
-					OutPnAenIndices[OutStartIdx + 9] = Indices->Get(InStartIdx + 0);
-					OutPnAenIndices[OutStartIdx + 10] = Indices->Get(InStartIdx + 1);
-					OutPnAenIndices[OutStartIdx + 11] = Indices->Get(InStartIdx + 2);
+					OutPnAenIndices[OutStartIdx + 0] = Indices[InStartIdx + 0];
+					OutPnAenIndices[OutStartIdx + 1] = Indices[InStartIdx + 1];
+					OutPnAenIndices[OutStartIdx + 2] = Indices[InStartIdx + 2];
+
+					OutPnAenIndices[OutStartIdx + 3] = Indices[InStartIdx + 0];
+					OutPnAenIndices[OutStartIdx + 4] = Indices[InStartIdx + 1];
+					OutPnAenIndices[OutStartIdx + 5] = Indices[InStartIdx + 1];
+					OutPnAenIndices[OutStartIdx + 6] = Indices[InStartIdx + 2];
+					OutPnAenIndices[OutStartIdx + 7] = Indices[InStartIdx + 2];
+					OutPnAenIndices[OutStartIdx + 8] = Indices[InStartIdx + 0];
+
+					OutPnAenIndices[OutStartIdx + 9] = Indices[InStartIdx + 0];
+					OutPnAenIndices[OutStartIdx + 10] = Indices[InStartIdx + 1];
+					OutPnAenIndices[OutStartIdx + 11] = Indices[InStartIdx + 2];
 				}
 			}
 		}
@@ -3321,32 +3423,30 @@ FCyLandSharedAdjacencyIndexBuffer::FCyLandSharedAdjacencyIndexBuffer(FCyLandShar
 	// Currently only support PN-AEN-Dominant Corner, which is the only mode for UE4 for now
 	IndexBuffers.Empty(Buffers->NumIndexBuffers);
 
-	bool b32BitIndex = Buffers->NumVertices > 65535;
 	for (int32 i = 0; i < Buffers->NumIndexBuffers; ++i)
 	{
-		if (b32BitIndex)
+		if (Buffers->bUse32BitIndices)
 		{
-			TArray<uint32> OutPnAenIndices;
-			BuildCyLandAdjacencyIndexBuffer<uint32>((Buffers->SubsectionSizeVerts >> i) - 1, Buffers->NumSubsections, (FRawStaticIndexBuffer16or32<uint32>*)Buffers->IndexBuffers[i], OutPnAenIndices);
-
-			FRawStaticIndexBuffer16or32<uint32>* IndexBuffer = new FRawStaticIndexBuffer16or32<uint32>();
-			IndexBuffer->AssignNewBuffer(OutPnAenIndices);
-			IndexBuffers.Add(IndexBuffer);
+			IndexBuffers.Add(new FRawStaticIndexBuffer16or32<uint32>());
 		}
 		else
 		{
-			TArray<uint16> OutPnAenIndices;
-			BuildCyLandAdjacencyIndexBuffer<uint16>((Buffers->SubsectionSizeVerts >> i) - 1, Buffers->NumSubsections, (FRawStaticIndexBuffer16or32<uint16>*)Buffers->IndexBuffers[i], OutPnAenIndices);
-
-			FRawStaticIndexBuffer16or32<uint16>* IndexBuffer = new FRawStaticIndexBuffer16or32<uint16>();
-			IndexBuffer->AssignNewBuffer(OutPnAenIndices);
-			IndexBuffers.Add(IndexBuffer);
+			IndexBuffers.Add(new FRawStaticIndexBuffer16or32<uint16>());
 		}
-
-		IndexBuffers[i]->InitResource();
 	}
 }
 
+template <typename INDEX_TYPE>
+void FCyLandSharedAdjacencyIndexBuffer::CreateLOD(int32 LODIndex, int32 LODSubsectionSizeQuads, int32 NumSubsections, const TArray<INDEX_TYPE>& Indices)
+{
+	TArray<INDEX_TYPE> OutPnAenIndices;
+	BuildCyLandAdjacencyIndexBuffer<INDEX_TYPE>(LODSubsectionSizeQuads, NumSubsections, Indices, OutPnAenIndices);
+
+	FRawStaticIndexBuffer16or32<INDEX_TYPE>* IndexBuffer = (FRawStaticIndexBuffer16or32<INDEX_TYPE>*)IndexBuffers[LODIndex];
+	IndexBuffer->AssignNewBuffer(OutPnAenIndices);
+	IndexBuffer->InitResource();
+}
+
 FCyLandSharedAdjacencyIndexBuffer::~FCyLandSharedAdjacencyIndexBuffer()
 {
 	for (int32 i = 0; i < IndexBuffers.Num(); ++i)
@@ -11,6 +11,7 @@ CyLandRenderMobile.cpp: CyLand Rendering without using vertex texture fetch
 #include "PrimitiveSceneInfo.h"
 #include "CyLandLayerInfoObject.h"
 #include "MeshMaterialShader.h"
+#include "CyLandSharedBuffersPool.h"
 
 void FCyLandVertexFactoryMobile::InitRHI()
 {
@@ -385,20 +386,18 @@ void FCyLandComponentSceneProxyMobile::CreateRenderThreadResources()
 	
 	auto FeatureLevel = GetScene().GetFeatureLevel();
 	// Use only Index buffers
-	SharedBuffers = FCyLandComponentSceneProxy::SharedBuffersMap.FindRef(SharedBuffersKey);
+	SharedBuffers = FCyLandSharedBuffersPool::Acquire(SharedBuffersKey);
 	if (SharedBuffers == nullptr)
 	{
 		int32 NumOcclusionVertices = MobileRenderData->OccluderVerticesSP.IsValid() ? MobileRenderData->OccluderVerticesSP->Num() : 0;
 				
 		SharedBuffers = new FCyLandSharedBuffers(
 			SharedBuffersKey, SubsectionSizeQuads, NumSubsections,
-			GetScene().GetFeatureLevel(), false, NumOcclusionVertices);
+			GetScene().GetFeatureLevel(), NumOcclusionVertices);
 
-		FCyLandComponentSceneProxy::SharedBuffersMap.Add(SharedBuffersKey, SharedBuffers);
+		FCyLandSharedBuffersPool::Add(SharedBuffers);
 	}
 
-	SharedBuffers->AddRef();
-
 	// Init vertex buffer
 	check(MobileRenderData->VertexBuffer);
 	MobileRenderData->VertexBuffer->InitResource();
@@ -0,0 +1,255 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandSharedBuffersPool.cpp: Render thread pool of CyLand shared vertex and index buffers
+=============================================================================*/
+
+#include "CyLandSharedBuffersPool.h"
+#include "CyLandRender.h"
+#include "CyLandPrivate.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Templates/RefCounting.h"
+
+DECLARE_MEMORY_STAT(TEXT("Idle Shared Buffers Mem"), STAT_CyLandIdleSharedBuffersMem, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shared Buffers"), STAT_CyLandSharedBuffers, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Idle Shared Buffers"), STAT_CyLandIdleSharedBuffers, STATGROUP_Landscape);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Shared Buffers Reused"), STAT_CyLandSharedBuffersReused, STATGROUP_Landscape);
+
+static float GCyLandSharedBuffersIdleTime = 30.0f;
+static FAutoConsoleVariableRef CVarCyLandSharedBuffersIdleTime(
+	TEXT("r.CyLandSharedBuffersIdleTime"),
+	GCyLandSharedBuffersIdleTime,
+	TEXT("Seconds the shared vertex and index buffers of a component size are kept after the last CyLand component of that size is removed, so streaming components back in doesn't rebuild them. 0 frees them right away."),
+	ECVF_RenderThreadSafe
+);
+
+static int32 GCyLandSharedBuffersIdleBudget = 32;
+static FAutoConsoleVariableRef CVarCyLandSharedBuffersIdleBudget(
+	TEXT("r.CyLandSharedBuffersIdleBudget"),
+	GCyLandSharedBuffersIdleBudget,
+	TEXT("Memory in MB idle CyLand shared buffers can use, the buffers idle for the longest are freed first."),
+	ECVF_RenderThreadSafe
+);
+
+namespace CyLandSharedBuffersPool
+{
+	struct FEntry
+	{
+		/** The pool reference, the buffers are idle when it is the only one */
+		TRefCountPtr<FCyLandSharedBuffers> Buffers;
+		/** Time the last proxy released the buffers */
+		double IdleSince;
+		int32 NumReuses;
+	};
+
+	static TMap<uint32, FEntry> Entries;
+	static bool bKeepIdleBuffers = true;
+	static int32 NumIdleEntries = 0;
+
+	static bool IsIdle(const FEntry& Entry)
+	{
+		return Entry.Buffers->GetRefCount() == 1;
+	}
+
+	static void UpdateStats()
+	{
+		SIZE_T IdleSize = 0;
+		int32 NumIdle = 0;
+		for (const TPair<uint32, FEntry>& Pair : Entries)
+		{
+			if (IsIdle(Pair.Value))
+			{
+				IdleSize += Pair.Value.Buffers->GetResourceSize();
+				NumIdle++;
+			}
+		}
+
+		NumIdleEntries = NumIdle;
+
+		SET_MEMORY_STAT(STAT_CyLandIdleSharedBuffersMem, IdleSize);
+		SET_DWORD_STAT(STAT_CyLandSharedBuffers, Entries.Num());
+		SET_DWORD_STAT(STAT_CyLandIdleSharedBuffers, NumIdle);
+	}
+}
+
+FCyLandSharedBuffers* FCyLandSharedBuffersPool::Acquire(uint32 SharedBuffersKey)
+{
+	using namespace CyLandSharedBuffersPool;
+	check(IsInRenderingThread());
+
+	FEntry* Entry = Entries.Find(SharedBuffersKey);
+	if (Entry == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (IsIdle(*Entry))
+	{
+		Entry->NumReuses++;
+		INC_DWORD_STAT(STAT_CyLandSharedBuffersReused);
+	}
+
+	Entry->Buffers->AddRef();
+	UpdateStats();
+	return Entry->Buffers.GetReference();
+}
+
+void FCyLandSharedBuffersPool::Add(FCyLandSharedBuffers* Buffers)
+{
+	using namespace CyLandSharedBuffersPool;
+	check(IsInRenderingThread());
+	check(!Entries.Contains(Buffers->SharedBuffersKey));
+
+	FEntry& Entry = Entries.Add(Buffers->SharedBuffersKey);
+	Entry.Buffers = Buffers;
+	Entry.IdleSince = 0.0;
+	Entry.NumReuses = 0;
+
+	Buffers->AddRef();
+	Trim();
+}
+
+void FCyLandSharedBuffersPool::Release(FCyLandSharedBuffers* Buffers)
+{
+	using namespace CyLandSharedBuffersPool;
+	check(IsInRenderingThread());
+
+	FEntry* Entry = Entries.Find(Buffers->SharedBuffersKey);
+	check(Entry && Entry->Buffers.GetReference() == Buffers);
+
+	Buffers->Release();
+	if (IsIdle(*Entry))
+	{
+		Entry->IdleSince = FPlatformTime::Seconds();
+	}
+
+	Trim();
+}
+
+void FCyLandSharedBuffersPool::Trim(bool bFlush)
+{
+	using namespace CyLandSharedBuffersPool;
+	check(IsInRenderingThread());
+
+	const double Now = FPlatformTime::Seconds();
+	const bool bFreeAllIdle = bFlush || !bKeepIdleBuffers || GCyLandSharedBuffersIdleTime <= 0.0f;
+	const SIZE_T IdleBudget = (SIZE_T)FMath::Max(GCyLandSharedBuffersIdleBudget, 0) * 1024 * 1024;
+
+	// Free what expired, then the buffers idle for the longest until the rest fits the budget
+	TArray<uint32, TInlineAllocator<8>> IdleKeys;
+	SIZE_T IdleSize = 0;
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!IsIdle(It.Value()))
+		{
+			continue;
+		}
+
+		if (bFreeAllIdle || Now - It.Value().IdleSince > GCyLandSharedBuffersIdleTime)
+		{
+			It.RemoveCurrent();
+		}
+		else
+		{
+			IdleKeys.Add(It.Key());
+			IdleSize += It.Value().Buffers->GetResourceSize();
+		}
+	}
+
+	if (IdleSize > IdleBudget)
+	{
+		IdleKeys.Sort([](uint32 A, uint32 B) { return Entries[A].IdleSince < Entries[B].IdleSince; });
+		for (int32 Index = 0; Index < IdleKeys.Num() && IdleSize > IdleBudget; Index++)
+		{
+			IdleSize -= Entries[IdleKeys[Index]].Buffers->GetResourceSize();
+			Entries.Remove(IdleKeys[Index]);
+		}
+	}
+
+	UpdateStats();
+}
+
+void FCyLandSharedBuffersPool::TickEndOfFrame()
+{
+	check(IsInRenderingThread());
+
+	// Nothing can expire while every set of buffers has a proxy
+	if (CyLandSharedBuffersPool::NumIdleEntries > 0)
+	{
+		Trim();
+	}
+}
+
+void FCyLandSharedBuffersPool::Shutdown()
+{
+	CyLandSharedBuffersPool::bKeepIdleBuffers = false;
+	Trim(true);
+}
+
+void FCyLandSharedBuffersPool::EnqueueShutdown()
+{
+	ENQUEUE_RENDER_COMMAND(CyLandSharedBuffersPoolShutdown)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			FCyLandSharedBuffersPool::Shutdown();
+		});
+}
+
+void FCyLandSharedBuffersPool::Dump()
+{
+	using namespace CyLandSharedBuffersPool;
+	check(IsInRenderingThread());
+
+	const double Now = FPlatformTime::Seconds();
+	SIZE_T TotalSize = 0;
+	for (const TPair<uint32, FEntry>& Pair : Entries)
+	{
+		const FCyLandSharedBuffers* Buffers = Pair.Value.Buffers.GetReference();
+		const SIZE_T Size = Buffers->GetResourceSize();
+		TotalSize += Size;
+
+		FString BuiltLODs;
+		for (int32 LODIndex = 0; LODIndex < Buffers->NumIndexBuffers; LODIndex++)
+		{
+			BuiltLODs += (Buffers->BuiltLODMask & (1u << LODIndex)) ? ((Buffers->BuiltAdjacencyLODMask & (1u << LODIndex)) ? TEXT("T") : TEXT("X")) : TEXT("-");
+		}
+
+		const uint32 NumUsers = Buffers->GetRefCount() - 1;
+		UE_LOG(LogCyLand, Warning, TEXT("Key 0x%08x: %d sub-sections of %d verts, %s indices, LODs [%s], %.2f MB, %s, reused %d times"),
+			Pair.Key, Buffers->NumSubsections, Buffers->SubsectionSizeVerts, Buffers->bUse32BitIndices ? TEXT("32-bit") : TEXT("16-bit"), *BuiltLODs,
+			Size / (1024.0f * 1024.0f), NumUsers > 0 ? *FString::Printf(TEXT("%u proxies"), NumUsers) : *FString::Printf(TEXT("idle for %.1f s"), Now - Pair.Value.IdleSince), Pair.Value.NumReuses);
+	}
+
+	UE_LOG(LogCyLand, Warning, TEXT("%d CyLand shared buffers, %.2f MB (LODs: X built, T built with adjacency, - never selected)"), Entries.Num(), TotalSize / (1024.0f * 1024.0f));
+}
+
+static void DumpCyLandSharedBuffers(const TArray<FString>& Args)
+{
+	ENQUEUE_RENDER_COMMAND(DumpCyLandSharedBuffers)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			FCyLandSharedBuffersPool::Dump();
+		});
+}
+
+static void FlushCyLandSharedBuffers(const TArray<FString>& Args)
+{
+	ENQUEUE_RENDER_COMMAND(FlushCyLandSharedBuffers)(
+		[](FRHICommandListImmediate& RHICmdList)
+		{
+			FCyLandSharedBuffersPool::Trim(true);
+		});
+}
+
+static FAutoConsoleCommand DumpCyLandSharedBuffersCmd(
+	TEXT("CyLand.DumpSharedBuffers"),
+	TEXT("Print the shared vertex and index buffers of CyLand components, the LODs built for each and their memory."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&DumpCyLandSharedBuffers)
+	);
+
+static FAutoConsoleCommand FlushCyLandSharedBuffersCmd(
+	TEXT("CyLand.FlushSharedBuffers"),
+	TEXT("Free the CyLand shared buffers no component uses anymore."),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FlushCyLandSharedBuffers)
+	);
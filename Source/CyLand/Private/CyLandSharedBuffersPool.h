@@ -0,0 +1,50 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandSharedBuffersPool.h: Render thread pool of CyLand shared vertex and index buffers
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FCyLandSharedBuffers;
+
+/**
+ * Owns the FCyLandSharedBuffers of every CyLand proxy, keyed by the shared buffers key of the proxies (component
+ * size, sub-sections, feature level and vertex factory). Proxies with the same key share one set of buffers, which
+ * only builds the LODs the proxies request (see FCyLandSharedBuffers::RequestLODs).
+ *
+ * When the last proxy using a set of buffers goes away, the pool keeps the buffers idle for
+ * r.CyLandSharedBuffersIdleTime seconds, within r.CyLandSharedBuffersIdleBudget MB, so components streaming back in
+ * or re-registering in the editor reuse them rather than building them again. The idle time is checked at the end of
+ * every frame, so buffers expire also when no proxy comes or goes anymore.
+ *
+ * Render thread only.
+ */
+class FCyLandSharedBuffersPool
+{
+public:
+	/** Buffers of a key with a reference added for the caller, or nullptr if the caller has to create them and Add them */
+	static FCyLandSharedBuffers* Acquire(uint32 SharedBuffersKey);
+
+	/** Adds buffers the caller created after Acquire failed, with a reference for the caller */
+	static void Add(FCyLandSharedBuffers* Buffers);
+
+	/** Releases a reference Acquire or Add gave, buffers no proxy uses anymore are kept idle */
+	static void Release(FCyLandSharedBuffers* Buffers);
+
+	/** Frees idle buffers past the idle time or over the idle budget, or all of them if bFlush */
+	static void Trim(bool bFlush = false);
+
+	/** Trims expired idle buffers, bound to FCoreDelegates::OnEndFrameRT */
+	static void TickEndOfFrame();
+
+	/** Frees idle buffers and stops keeping buffers idle, for engine exit */
+	static void Shutdown();
+
+	/** Shutdown on the render thread, from the game thread on engine exit */
+	static void EnqueueShutdown();
+
+	static void Dump();
+};
@@ -0,0 +1,466 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandStreamingWorld.cpp: Camera driven tile streaming for runtime CyLands
+=============================================================================*/
+
+#include "CyLandStreamingWorld.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "ContentStreaming.h"
+#include "CyLand.h"
+#include "CyLandStreamingProxy.h"
+#include "CyLandInfo.h"
+#include "CyLandHeightmapAtlas.h"
+#include "CyLandPrivate.h"
+#include "CyLandImportPipeline.h"
+
+DECLARE_CYCLE_STAT(TEXT("Streaming World Tick"), STAT_CyLandStreamingWorldTick, STATGROUP_Landscape);
+DECLARE_CYCLE_STAT(TEXT("Streaming World Load Tile"), STAT_CyLandStreamingWorldLoadTile, STATGROUP_Landscape);
+DECLARE_CYCLE_STAT(TEXT("Streaming World Unload Tile"), STAT_CyLandStreamingWorldUnloadTile, STATGROUP_Landscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Streamed Tiles"), STAT_CyLandStreamedTiles, STATGROUP_Landscape);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pending Streamed Tiles"), STAT_CyLandPendingStreamedTiles, STATGROUP_Landscape);
+
+static TAutoConsoleVariable<int32> CVarCyLandStreamingEnable(
+	TEXT("cyland.Streaming.Enable"),
+	1,
+	TEXT("1: Streaming worlds load and unload tiles around the viewers; 0: Streaming is frozen"));
+
+static TAutoConsoleVariable<float> CVarCyLandStreamingDistanceScale(
+	TEXT("cyland.Streaming.DistanceScale"),
+	1.0f,
+	TEXT("Multiplier on the streaming distance of every CyLand streaming world."),
+	ECVF_Scalability);
+
+ACyLandStreamingWorld::ACyLandStreamingWorld(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+	, CyLandMaterial(nullptr)
+	, SectionsPerComponent(1)
+	, QuadsPerComponent(63)
+	, ComponentsPerTile(8)
+	, StreamingDistance(150000.0f)
+	, UnloadDistanceScale(1.25f)
+	, MaxTileLoadsPerFrame(1)
+	, MaxPendingTileBuilds(4)
+	, MaxTileUnloadsPerFrame(2)
+	, StreamingBudgetMs(4.0f)
+	, UnloadsBeforeGarbageCollect(16)
+	, bUseHeightmapAtlas(false)
+	, HeightmapAtlasTextureSize(2048)
+	, MaxHeightmapAtlasTextures(8)
+	, MaxHeightmapAtlasUploadsPerFrame(16)
+	, CyLand(nullptr)
+	, HeightmapAtlas(nullptr)
+	, UnloadsSinceGarbageCollect(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootComponent0"));
+	RootComponent->SetMobility(EComponentMobility::Movable);
+}
+
+void ACyLandStreamingWorld::InitializeWorld()
+{
+	check(!CyLand);
+	check(QuadsPerComponent % SectionsPerComponent == 0);
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	CyLand = World->SpawnActor<ACyLand>(GetActorLocation(), GetActorRotation(), SpawnParams);
+	CyLand->SetActorRelativeScale3D(GetActorScale3D());
+	CyLand->GetRootComponent()->SetMobility(EComponentMobility::Movable);
+	if (CyLandMaterial)
+	{
+		CyLand->CyLandMaterial = CyLandMaterial;
+	}
+
+	// The parent has no components of its own, it only carries the properties shared with the tiles
+	CyLand->ComponentSizeQuads = QuadsPerComponent;
+	CyLand->NumSubsections = SectionsPerComponent;
+	CyLand->SubsectionSizeQuads = QuadsPerComponent / SectionsPerComponent;
+	CyLand->SetCyLandGuid(FGuid::NewGuid());
+	CyLand->CreateCyLandInfo();
+
+	if (bUseHeightmapAtlas)
+	{
+		// A page holds one component with its quad mips, the same layout the import gives it in a heightmap texture
+		const int32 SubsectionSizeVerts = QuadsPerComponent / SectionsPerComponent + 1;
+		HeightmapAtlas = NewObject<UCyLandHeightmapAtlas>(this);
+		HeightmapAtlas->Initialize(SubsectionSizeVerts * SectionsPerComponent, FMath::CeilLogTwo(SubsectionSizeVerts), HeightmapAtlasTextureSize, MaxHeightmapAtlasTextures);
+	}
+}
+
+void ACyLandStreamingWorld::GenerateTileHeightData(const FIntPoint& TileBase, int32 NumVerts, TArray<uint16>& OutHeights) const
+{
+	// Flat by default, subclasses provide the actual terrain
+	OutHeights.Init(32768, NumVerts * NumVerts);
+}
+
+FVector ACyLandStreamingWorld::GetTileCenter(const FIntPoint& Tile) const
+{
+	const float HalfTile = GetTileSizeQuads() * 0.5f;
+	const FVector LocalCenter((Tile.X * GetTileSizeQuads()) + HalfTile, (Tile.Y * GetTileSizeQuads()) + HalfTile, 0.0f);
+	return CyLand->GetActorTransform().TransformPosition(LocalCenter);
+}
+
+void ACyLandStreamingWorld::GetViewerLocations(TArray<FVector>& OutLocations) const
+{
+	OutLocations.Reset();
+
+	const int32 NumViews = IStreamingManager::Get().GetNumViews();
+	for (int32 Index = 0; Index < NumViews; Index++)
+	{
+		OutLocations.Add(IStreamingManager::Get().GetViewInformation(Index).ViewOrigin);
+	}
+
+	if (!OutLocations.Num())
+	{
+		OutLocations = GetWorld()->ViewLocationsRenderedLastFrame;
+	}
+}
+
+void ACyLandStreamingWorld::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	SCOPE_CYCLE_COUNTER(STAT_CyLandStreamingWorldTick);
+
+	if (!CyLand || CVarCyLandStreamingEnable.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	TArray<FVector> Viewers;
+	GetViewerLocations(Viewers);
+	if (!Viewers.Num())
+	{
+		return;
+	}
+
+	// Work in the 2D plane of the CyLand, heights do not matter for streaming
+	const float LoadDistance = StreamingDistance * CVarCyLandStreamingDistanceScale.GetValueOnGameThread();
+	const float UnloadDistance = LoadDistance * FMath::Max(UnloadDistanceScale, 1.0f);
+	const float TileWorldSize = GetTileSizeQuads() * CyLand->GetActorScale3D().X;
+	const int32 TileRadius = FMath::CeilToInt(LoadDistance / TileWorldSize);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double BudgetSeconds = StreamingBudgetMs / 1000.0;
+
+	auto GetMinDistSquared2D = [&Viewers](const FVector& Location)
+	{
+		float MinDistSquared = MAX_flt;
+		for (const FVector& Viewer : Viewers)
+		{
+			MinDistSquared = FMath::Min(MinDistSquared, FVector::DistSquaredXY(Viewer, Location));
+		}
+		return MinDistSquared;
+	};
+
+	// Tiles destroyed by something else, with their level for instance, are streamed in again
+	for (auto It = LoadedTiles.CreateIterator(); It; ++It)
+	{
+		if (!It.Value() || It.Value()->IsPendingKillPending())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Unload first so the memory is released before new tiles get allocated
+	{
+		TArray<TPair<float, FIntPoint>, TInlineAllocator<16>> TilesToUnload;
+		for (const auto& TilePair : LoadedTiles)
+		{
+			const float DistSquared = GetMinDistSquared2D(GetTileCenter(TilePair.Key));
+			if (DistSquared > FMath::Square(UnloadDistance))
+			{
+				TilesToUnload.Emplace(DistSquared, TilePair.Key);
+			}
+			else if (HeightmapAtlas && DistSquared <= FMath::Square(LoadDistance))
+			{
+				// Tiles kept only by the unload hysteresis age in the atlas and are the first pages evicted
+				HeightmapAtlas->TouchPages(TilePair.Value);
+			}
+		}
+
+		// Furthest first
+		TilesToUnload.Sort([](const TPair<float, FIntPoint>& A, const TPair<float, FIntPoint>& B) { return A.Key > B.Key; });
+
+		const int32 NumToUnload = FMath::Min(TilesToUnload.Num(), FMath::Max(MaxTileUnloadsPerFrame, 1));
+		for (int32 Index = 0; Index < NumToUnload; Index++)
+		{
+			if (Index > 0 && FPlatformTime::Seconds() - StartTime > BudgetSeconds)
+			{
+				break;
+			}
+
+			ACyLandStreamingProxy* Proxy = nullptr;
+			LoadedTiles.RemoveAndCopyValue(TilesToUnload[Index].Value, Proxy);
+			UnloadTile(Proxy);
+		}
+	}
+
+#if WITH_EDITOR
+	// Drop builds that went out of range before they could be finished
+	for (auto It = PendingTiles.CreateIterator(); It; ++It)
+	{
+		FAsyncTask<FCyLandImportTask>* Build = It.Value();
+		if (GetMinDistSquared2D(GetTileCenter(It.Key())) > FMath::Square(UnloadDistance) && (Build->IsDone() || Build->Cancel()))
+		{
+			delete Build;
+			It.RemoveCurrent();
+		}
+	}
+
+	// Finish the built tiles, nearest first
+	{
+		TArray<TPair<float, FIntPoint>, TInlineAllocator<16>> BuiltTiles;
+		for (const auto& PendingPair : PendingTiles)
+		{
+			if (PendingPair.Value->IsDone())
+			{
+				BuiltTiles.Emplace(GetMinDistSquared2D(GetTileCenter(PendingPair.Key)), PendingPair.Key);
+			}
+		}
+
+		BuiltTiles.Sort([](const TPair<float, FIntPoint>& A, const TPair<float, FIntPoint>& B) { return A.Key < B.Key; });
+
+		const int32 NumToLoad = FMath::Min(BuiltTiles.Num(), FMath::Max(MaxTileLoadsPerFrame, 1));
+		for (int32 Index = 0; Index < NumToLoad; Index++)
+		{
+			if (Index > 0 && FPlatformTime::Seconds() - StartTime > BudgetSeconds)
+			{
+				break;
+			}
+
+			const FIntPoint Tile = BuiltTiles[Index].Value;
+			FAsyncTask<FCyLandImportTask>* Build = nullptr;
+			PendingTiles.RemoveAndCopyValue(Tile, Build);
+
+			if (ACyLandStreamingProxy* Proxy = LoadTile(Tile, *Build->GetTask().Payload))
+			{
+				LoadedTiles.Add(Tile, Proxy);
+			}
+			delete Build;
+		}
+	}
+
+	if (HeightmapAtlas)
+	{
+		HeightmapAtlas->Update(MaxHeightmapAtlasUploadsPerFrame);
+	}
+#endif
+
+	// Collect the ring of wanted tiles around each viewer
+	TArray<TPair<float, FIntPoint>> TilesToLoad;
+	{
+		const FTransform& CyLandToWorld = CyLand->GetActorTransform();
+		TSet<FIntPoint> Candidates;
+		for (const FVector& Viewer : Viewers)
+		{
+			const FVector LocalViewer = CyLandToWorld.InverseTransformPosition(Viewer);
+			const FIntPoint ViewerTile(FMath::FloorToInt(LocalViewer.X / GetTileSizeQuads()), FMath::FloorToInt(LocalViewer.Y / GetTileSizeQuads()));
+
+			for (int32 Y = -TileRadius; Y <= TileRadius; Y++)
+			{
+				for (int32 X = -TileRadius; X <= TileRadius; X++)
+				{
+					Candidates.Add(ViewerTile + FIntPoint(X, Y));
+				}
+			}
+		}
+
+		for (const FIntPoint& Tile : Candidates)
+		{
+			if (LoadedTiles.Contains(Tile))
+			{
+				continue;
+			}
+#if WITH_EDITOR
+			if (PendingTiles.Contains(Tile))
+			{
+				continue;
+			}
+#endif
+
+			const float DistSquared = GetMinDistSquared2D(GetTileCenter(Tile));
+			if (DistSquared <= FMath::Square(LoadDistance))
+			{
+				TilesToLoad.Emplace(DistSquared, Tile);
+			}
+		}
+	}
+
+	// Nearest first
+	TilesToLoad.Sort([](const TPair<float, FIntPoint>& A, const TPair<float, FIntPoint>& B) { return A.Key < B.Key; });
+
+#if WITH_EDITOR
+	const int32 NumToBuild = FMath::Min(TilesToLoad.Num(), FMath::Max(MaxPendingTileBuilds, 1) - PendingTiles.Num());
+#else
+	const int32 NumToBuild = FMath::Min(TilesToLoad.Num(), 1);
+#endif
+	for (int32 Index = 0; Index < NumToBuild; Index++)
+	{
+		if (Index > 0 && FPlatformTime::Seconds() - StartTime > BudgetSeconds)
+		{
+			break;
+		}
+
+		if (!BeginTileBuild(TilesToLoad[Index].Value))
+		{
+			break;
+		}
+	}
+
+#if WITH_EDITOR
+	SET_DWORD_STAT(STAT_CyLandPendingStreamedTiles, PendingTiles.Num());
+#endif
+	SET_DWORD_STAT(STAT_CyLandStreamedTiles, LoadedTiles.Num());
+
+	if (UnloadsBeforeGarbageCollect > 0 && UnloadsSinceGarbageCollect >= UnloadsBeforeGarbageCollect)
+	{
+		// Tile textures and components are only released once collected
+		UnloadsSinceGarbageCollect = 0;
+		GEngine->ForceGarbageCollection(false);
+	}
+}
+
+bool ACyLandStreamingWorld::BeginTileBuild(const FIntPoint& Tile)
+{
+#if WITH_EDITOR
+	const int32 TileSizeQuads = GetTileSizeQuads();
+	const int32 NumVerts = TileSizeQuads + 1;
+	const FIntPoint TileBase(Tile.X * TileSizeQuads, Tile.Y * TileSizeQuads);
+
+	// Subclasses are not required to be thread safe, so heights are still generated here
+	TArray<uint16> HeightData;
+	GenerateTileHeightData(TileBase, NumVerts, HeightData);
+	check(HeightData.Num() == NumVerts * NumVerts);
+
+	TArray<FCyLandImportLayerInfo> ImportLayers;
+	FCyLandImportPayloadPtr Payload = MakeShareable(new FCyLandImportPayload(CyLand->GetActorScale3D(), TileBase.X, TileBase.Y, TileBase.X + TileSizeQuads, TileBase.Y + TileSizeQuads,
+		SectionsPerComponent, QuadsPerComponent / SectionsPerComponent, HeightData.GetData(), ImportLayers, ECyLandImportAlphamapType::Additive));
+
+	FAsyncTask<FCyLandImportTask>* Build = new FAsyncTask<FCyLandImportTask>(Payload);
+	Build->StartBackgroundTask();
+	PendingTiles.Add(Tile, Build);
+	return true;
+#else
+	static bool bWarned = false;
+	if (!bWarned)
+	{
+		bWarned = true;
+		UE_LOG(LogCyLand, Warning, TEXT("CyLand streaming worlds require ACyLandProxy::Imports which is only available with editor data"));
+	}
+	return false;
+#endif
+}
+
+void ACyLandStreamingWorld::CancelPendingTiles()
+{
+#if WITH_EDITOR
+	for (const auto& PendingPair : PendingTiles)
+	{
+		FAsyncTask<FCyLandImportTask>* Build = PendingPair.Value;
+		if (!Build->Cancel())
+		{
+			Build->EnsureCompletion();
+		}
+		delete Build;
+	}
+	PendingTiles.Empty();
+#endif
+}
+
+#if WITH_EDITOR
+ACyLandStreamingProxy* ACyLandStreamingWorld::LoadTile(const FIntPoint& Tile, FCyLandImportPayload& Payload)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandStreamingWorldLoadTile);
+
+	const FIntPoint TileBase(Payload.MinX, Payload.MinY);
+	const FTransform& CyLandToWorld = CyLand->GetActorTransform();
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	ACyLandStreamingProxy* Proxy = GetWorld()->SpawnActor<ACyLandStreamingProxy>(CyLandToWorld.TransformPosition(FVector(TileBase.X, TileBase.Y, 0.0f)), CyLand->GetActorRotation(), SpawnParams);
+	if (!Proxy)
+	{
+		return nullptr;
+	}
+
+	Proxy->SetActorRelativeScale3D(CyLand->GetActorScale3D());
+	Proxy->GetRootComponent()->SetMobility(EComponentMobility::Movable);
+	Proxy->CyLandActor = CyLand;
+	Proxy->CyLandMaterial = CyLand->CyLandMaterial;
+	Proxy->CyLandSectionOffset = TileBase;
+
+	TArray<FCyLandImportLayerInfo> ImportLayers;
+	Proxy->ImportsFromPayload(CyLand->GetCyLandGuid(), Payload, nullptr, ImportLayers, HeightmapAtlas);
+
+	UE_LOG(LogCyLand, Verbose, TEXT("Streamed in CyLand tile (%d, %d)"), Tile.X, Tile.Y);
+	return Proxy;
+}
+#endif
+
+void ACyLandStreamingWorld::UnloadTile(ACyLandStreamingProxy* Proxy)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CyLandStreamingWorldUnloadTile);
+
+	if (!Proxy || Proxy->IsPendingKillPending())
+	{
+		return;
+	}
+
+	// Game worlds do not unregister proxies from the info on their own
+	if (UCyLandInfo* CyLandInfo = CyLand ? CyLand->GetCyLandInfo() : nullptr)
+	{
+		CyLandInfo->UnregisterActor(Proxy);
+	}
+
+	if (HeightmapAtlas)
+	{
+		HeightmapAtlas->RemovePages(Proxy);
+	}
+
+	Proxy->FlushGrassComponents();
+	Proxy->Destroy();
+	UnloadsSinceGarbageCollect++;
+}
+
+void ACyLandStreamingWorld::UnloadAllTiles()
+{
+	CancelPendingTiles();
+
+	for (const auto& TilePair : LoadedTiles)
+	{
+		UnloadTile(TilePair.Value);
+	}
+	LoadedTiles.Empty();
+
+	if (CyLand && !CyLand->IsPendingKillPending())
+	{
+		if (UCyLandInfo* CyLandInfo = CyLand->GetCyLandInfo())
+		{
+			CyLandInfo->UnregisterActor(CyLand);
+		}
+		CyLand->Destroy();
+	}
+	CyLand = nullptr;
+
+	if (HeightmapAtlas)
+	{
+		HeightmapAtlas->Empty();
+	}
+}
+
+void ACyLandStreamingWorld::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnloadAllTiles();
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,106 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandVertexFetchReport.cpp: Vertex memory and fetch bytes of the CyLand vertex layouts
+=============================================================================*/
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Parse.h"
+#include "CyLandRender.h"
+#include "CyLandLODSimulation.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace CyLandVertexFetchReport
+{
+	FORCEINLINE FVector4 FetchVertex(const FCyLandVertex& Vertex)
+	{
+		return FVector4(Vertex.VertexX, Vertex.VertexY, Vertex.SubX, Vertex.SubY);
+	}
+
+	FORCEINLINE FVector4 FetchVertex(const FCyLandPackedVertex& Vertex)
+	{
+		return FVector4(Vertex.VertexX.GetFloat(), Vertex.VertexY.GetFloat(), Vertex.SubX.GetFloat(), Vertex.SubY.GetFloat());
+	}
+
+	static void Run(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const FString Cmd = FString::Join(Args, TEXT(" "));
+
+		int32 SubsectionSizeQuads = 63;
+		int32 NumSubsections = 2;
+		int32 NumComponents = 32;
+		FParse::Value(*Cmd, TEXT("SubsectionQuads="), SubsectionSizeQuads);
+		FParse::Value(*Cmd, TEXT("Subsections="), NumSubsections);
+		FParse::Value(*Cmd, TEXT("Components="), NumComponents);
+		SubsectionSizeQuads = FMath::Clamp(SubsectionSizeQuads, 1, 255);
+		NumSubsections = FMath::Clamp(NumSubsections, 1, 2);
+		NumComponents = FMath::Clamp(NumComponents, 1, 1024);
+
+		const int32 SubsectionSizeVerts = SubsectionSizeQuads + 1;
+		const int32 NumVertices = FMath::Square(SubsectionSizeVerts) * FMath::Square(NumSubsections);
+
+		// Both layouts filled like FCyLandVertexBuffer fills them, the values must be the same
+		TArray<uint8> FullVertices;
+		TArray<uint8> PackedVertices;
+		FullVertices.SetNumUninitialized(NumVertices * sizeof(FCyLandVertex));
+		PackedVertices.SetNumUninitialized(NumVertices * sizeof(FCyLandPackedVertex));
+		FCyLandVertexBuffer::FillVertices(FullVertices.GetData(), SubsectionSizeVerts, NumSubsections, false);
+		FCyLandVertexBuffer::FillVertices(PackedVertices.GetData(), SubsectionSizeVerts, NumSubsections, true);
+
+		int32 NumMismatches = 0;
+		for (int32 VertexIndex = 0; VertexIndex < NumVertices; VertexIndex++)
+		{
+			const FVector4 Full = FetchVertex(((const FCyLandVertex*)FullVertices.GetData())[VertexIndex]);
+			const FVector4 Packed = FetchVertex(((const FCyLandPackedVertex*)PackedVertices.GetData())[VertexIndex]);
+			NumMismatches += (Full != Packed) ? 1 : 0;
+		}
+
+		// The fetch itself happens in the input assembler and can't be timed from here, decoding the halves on the CPU would
+		// time FFloat16::GetFloat instead. The model counts the bytes of a LOD 0 draw: every vertex once when the post
+		// transform cache hits, up to one vertex per index of the triangle list when it misses.
+		const int32 NumIndices = FMath::Square(NumSubsections) * FMath::Square(SubsectionSizeQuads) * 6;
+
+		Ar.Logf(TEXT("CyLand vertex layouts, %d sub-sections of %d verts: %d bytes per vertex, %.1f KB per shared buffer vs packed %d bytes, %.1f KB (%d vertices differ)"),
+			FMath::Square(NumSubsections), SubsectionSizeVerts, (int32)sizeof(FCyLandVertex), FullVertices.Num() / 1024.0f, (int32)sizeof(FCyLandPackedVertex), PackedVertices.Num() / 1024.0f, NumMismatches);
+		Ar.Logf(TEXT("Vertex fetch of a LOD 0 draw (%d indices): %.1f KB to %.1f KB vs packed %.1f KB to %.1f KB (%.2fx less), use profilegpu to time it"),
+			NumIndices, FullVertices.Num() / 1024.0f, (float)NumIndices * sizeof(FCyLandVertex) / 1024.0f,
+			PackedVertices.Num() / 1024.0f, (float)NumIndices * sizeof(FCyLandPackedVertex) / 1024.0f, (float)sizeof(FCyLandVertex) / sizeof(FCyLandPackedVertex));
+
+		// Vertices the GPU fetches per frame along a flyover, each drawn sub-section fetches its LOD's grid once
+		FCyLandLODSimulationSettings Settings;
+		Settings.NumComponents = FIntPoint(NumComponents, NumComponents);
+		Settings.SubsectionSizeQuads = SubsectionSizeQuads;
+		Settings.NumSubsections = NumSubsections;
+
+		const float Size = NumComponents * SubsectionSizeQuads * NumSubsections * Settings.Scale.X;
+		const FCyLandLODSimulationReport Report = FCyLandLODSimulation(Settings).Run(FCyLandCameraPath::MakeFlyover(Size, Settings.HeightRange, 120));
+
+		double TotalVertices = 0.0;
+		double PeakVertices = 0.0;
+		for (const FCyLandLODSimulationFrame& Frame : Report.Frames)
+		{
+			double FrameVertices = 0.0;
+			for (int32 LODIndex = 0; LODIndex < Frame.LODHistogram.Num(); LODIndex++)
+			{
+				FrameVertices += (double)Frame.LODHistogram[LODIndex] * FMath::Square(SubsectionSizeVerts >> LODIndex);
+			}
+			TotalVertices += FrameVertices;
+			PeakVertices = FMath::Max(PeakVertices, FrameVertices);
+		}
+
+		const double AverageVertices = TotalVertices / FMath::Max(Report.Frames.Num(), 1);
+		Ar.Logf(TEXT("Flyover of %dx%d components, vertex fetch per frame: %.2f MB (peak %.2f MB) vs packed %.2f MB (peak %.2f MB), per pass drawing the landscape"),
+			NumComponents, NumComponents, AverageVertices * sizeof(FCyLandVertex) / (1024.0 * 1024.0), PeakVertices * sizeof(FCyLandVertex) / (1024.0 * 1024.0),
+			AverageVertices * sizeof(FCyLandPackedVertex) / (1024.0 * 1024.0), PeakVertices * sizeof(FCyLandPackedVertex) / (1024.0 * 1024.0));
+	}
+
+	static FAutoConsoleCommand ReportCmd(
+		TEXT("CyLand.VertexFetchReport"),
+		TEXT("Report the memory and the modelled vertex fetch bytes (nothing is timed) of the full and packed (r.CyLandPackedVertices) CyLand vertex layouts. ")
+		TEXT("Args: [SubsectionQuads=63] [Subsections=2] [Components=32]"),
+		FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
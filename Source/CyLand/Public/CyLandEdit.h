@@ -46,12 +46,15 @@ struct FCyLandTextureDataInfo
 
 	int32 NumMips() { return MipInfo.Num(); }
 
+	// thread safe, components sharing the texture may record their regions from worker threads
 	void AddMipUpdateRegion(int32 MipNum, int32 InX1, int32 InY1, int32 InX2, int32 InY2)
 	{
 		check( MipNum < MipInfo.Num() );
+		FScopeLock ScopeLock(&MipUpdateRegionsLock);
 		new(MipInfo[MipNum].MipUpdateRegions) FUpdateTextureRegion2D(InX1, InY1, InX1, InY1, 1+InX2-InX1, 1+InY2-InY1);
 	}
 
+	// not thread safe the first time a mip is requested, lock the mips on the game thread before handing them to workers
 	void* GetMipData(int32 MipNum)
 	{
 		check( MipNum < MipInfo.Num() );
@@ -75,6 +78,7 @@ struct FCyLandTextureDataInfo
 private:
 	UTexture2D* Texture;
 	TArray<FMipInfo> MipInfo;
+	FCriticalSection MipUpdateRegionsLock;
 };
 
 struct CYLAND_API FCyLandTextureDataInterface
@@ -116,6 +120,12 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	// Misc
 	bool GetComponentsInRegion(int32 X1, int32 Y1, int32 X2, int32 Y2, TSet<UCyLandComponent*>* OutComponents = NULL);
 
+	/**
+	 * Which vertices of a region, Max included, belong to a component. The bits are in rows of the region width
+	 * @return true if they all do
+	 */
+	bool GetValidVertices(int32 X1, int32 Y1, int32 X2, int32 Y2, TBitArray<>& OutValid) const;
+
 	//
 	// Heightmap access
 	//
@@ -130,9 +140,9 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	// Without data interpolation, able to get normal data
 	template<typename TStoreData>
 	void GetHeightDataTemplFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TStoreData& StoreData, UTexture2D* InHeightmap = nullptr, TStoreData* NormalData = NULL);
-	// Implementation for fixed array
-	void GetHeightData(int32& X1, int32& Y1, int32& X2, int32& Y2, uint16* Data, int32 Stride);
-	void GetHeightDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint16* Data, int32 Stride, uint16* NormalData = NULL, UTexture2D* InHeightmap = nullptr);
+	// Implementation for fixed array, OutValid gets the bits of the samples stored set in the same layout as Data (sized by the caller)
+	void GetHeightData(int32& X1, int32& Y1, int32& X2, int32& Y2, uint16* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
+	void GetHeightDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint16* Data, int32 Stride, uint16* NormalData = NULL, UTexture2D* InHeightmap = nullptr, TBitArray<>* OutValid = nullptr);
 	// Implementation for sparse array
 	void GetHeightData(int32& X1, int32& Y1, int32& X2, int32& Y2, TMap<FIntPoint, uint16>& SparseData);
 	void GetHeightDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TMap<FIntPoint, uint16>& SparseData, TMap<FIntPoint, uint16>* NormalData = NULL, UTexture2D* InHeightmap = nullptr);
@@ -150,11 +160,11 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	// Without data interpolation
 	template<typename TStoreData>
 	void GetWeightDataTemplFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TStoreData& StoreData);
-	// Implementation for fixed array
-	void GetWeightData(UCyLandLayerInfoObject* LayerInfo, int32& X1, int32& Y1, int32& X2, int32& Y2, uint8* Data, int32 Stride);
+	// Implementation for fixed array, OutValid as for the heights
+	void GetWeightData(UCyLandLayerInfoObject* LayerInfo, int32& X1, int32& Y1, int32& X2, int32& Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
 	//void GetWeightData(FName LayerName, int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<uint8>* Data, int32 Stride);
-	void GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride);
-	void GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TArray<uint8>* Data, int32 Stride);
+	void GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
+	void GetWeightDataFast(UCyLandLayerInfoObject* LayerInfo, const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TArray<uint8>* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
 	// Implementation for sparse array
 	void GetWeightData(UCyLandLayerInfoObject* LayerInfo, int32& X1, int32& Y1, int32& X2, int32& Y2, TMap<FIntPoint, uint8>& SparseData);
 	//void GetWeightData(FName LayerName, int32& X1, int32& Y1, int32& X2, int32& Y2, TMap<uint64, TArray<uint8>>& SparseData);
@@ -176,7 +186,7 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	// Without data interpolation, Select Data 
 	template<typename TStoreData>
 	void GetSelectDataTempl(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TStoreData& StoreData);
-	void GetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride);
+	void GetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, uint8* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
 	void GetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TMap<FIntPoint, uint8>& SparseData);
 	void SetSelectData(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, const uint8* Data, int32 Stride);
 
@@ -194,7 +204,7 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	void GetXYOffsetDataTempl(int32& X1, int32& Y1, int32& X2, int32& Y2, TStoreData& StoreData);
 	void GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, FVector2D* Data, int32 Stride);
 	void GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TMap<FIntPoint, FVector2D>& SparseData);
-	void GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, FVector* Data, int32 Stride);
+	void GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, FVector* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
 	void GetXYOffsetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TMap<FIntPoint, FVector>& SparseData);
 	// Without data interpolation
 	template<typename TStoreData>
@@ -202,7 +212,7 @@ struct CYLAND_API FCyLandEditDataInterface : public FCyLandTextureDataInterface
 	// Without data interpolation, able to get normal data
 	void GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, FVector2D* Data, int32 Stride);
 	void GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TMap<FIntPoint, FVector2D>& SparseData);
-	void GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, FVector* Data, int32 Stride);
+	void GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, FVector* Data, int32 Stride, TBitArray<>* OutValid = nullptr);
 	void GetXYOffsetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TMap<FIntPoint, FVector>& SparseData);
 
 	template<typename T>
@@ -285,6 +295,17 @@ struct FHeightmapAccessor
 	{
 		CyLandEdit->GetHeightDataFast(X1, Y1, X2, Y2, Data);
 	}
+
+	// Dense versions, Data and Valid are sized by the caller to the requested region in rows of its width
+	void GetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<uint16>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit->GetHeightData(X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
+	void GetDataFast(int32 X1, int32 Y1, int32 X2, int32 Y2, TArray<uint16>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit->GetHeightDataFast(X1, Y1, X2, Y2, Data.GetData(), 0, nullptr, nullptr, &Valid);
+	}
 	void SetData(const ACyLand& land, int32 X1, int32 Y1, int32 X2, int32 Y2, const uint16* Data, ECyLandLayerPaintingRestriction PaintingRestriction = ECyLandLayerPaintingRestriction::None);
 
 	void SetData(int32 X1, int32 Y1, int32 X2, int32 Y2, const uint16* Data, ECyLandLayerPaintingRestriction PaintingRestriction = ECyLandLayerPaintingRestriction::None)
@@ -440,6 +461,17 @@ struct FAlphamapAccessor
 		CyLandEdit.GetWeightDataFast(LayerInfo, X1, Y1, X2, Y2, Data);
 	}
 
+	// Dense versions, Data and Valid are sized by the caller to the requested region in rows of its width
+	void GetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<uint8>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit.GetWeightData(LayerInfo, X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
+	void GetDataFast(int32 X1, int32 Y1, int32 X2, int32 Y2, TArray<uint8>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit.GetWeightDataFast(LayerInfo, X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
 	void SetData(int32 X1, int32 Y1, int32 X2, int32 Y2, const uint8* Data, ECyLandLayerPaintingRestriction PaintingRestriction)
 	{
 		TSet<UCyLandComponent*> Components;
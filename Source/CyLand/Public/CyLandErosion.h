@@ -0,0 +1,142 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandErosion.h: Tiled, multithreaded thermal and hydraulic erosion
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCyLandInfo;
+
+/** Thermal erosion, material slides down slopes steeper than the threshold (the Erosion tool) */
+struct FCyLandThermalErosionSettings
+{
+	FCyLandThermalErosionSettings()
+		: Iterations(28)
+		, Threshold(64.0f)
+		, Strength(0.3f)
+		, SurfaceThickness(256)
+	{}
+
+	int32 Iterations;
+
+	/** Height difference between neighbours, in heightmap units, above which material moves */
+	float Threshold;
+
+	/** Fraction of the excess slope moved per iteration */
+	float Strength;
+
+	/** Depth of ground, in heightmap units, whose layer weights are mixed with the material sliding onto it */
+	int32 SurfaceThickness;
+};
+
+/** Hydraulic erosion, water dissolves the ground, flows downhill and deposits its sediment as it evaporates (the Hydraulic Erosion tool) */
+struct FCyLandHydraulicErosionSettings
+{
+	FCyLandHydraulicErosionSettings()
+		: Iterations(75)
+		, Strength(0.3f)
+		, SedimentCapacity(0.3f)
+		, EvaporateRatio(0.5f)
+	{}
+
+	int32 Iterations;
+
+	/** Scales how much ground the water dissolves, and how far the water level drops when it flows down a slope */
+	float Strength;
+
+	/** How much sediment the water can carry */
+	float SedimentCapacity;
+
+	/** Fraction of the water evaporating per iteration */
+	float EvaporateRatio;
+};
+
+/**
+ * Erosion on float SoA grids of heights, water and sediment.
+ *
+ * Each iteration is written as fluxes: every vertex first works out what it sends to its neighbours from the state of
+ * the previous iteration, then gathers what its neighbours send it, so the vertices are independent of each other.
+ * The grid is cut in cache-sized tiles that run on worker threads. A tile copies itself and a halo of its neighbours
+ * into local buffers and runs several iterations on them before its interior is written back; each iteration needs
+ * two vertices of halo, so tiles only exchange halos every IterationsPerRound iterations.
+ *
+ * Vertices outside the grid and holes are walls, nothing flows in or out of them. Vertices with a mask of 0 don't
+ * erode but still receive what their neighbours send them.
+ */
+class CYLAND_API FCyLandErosion
+{
+public:
+	FCyLandErosion(int32 InSizeX, int32 InSizeY);
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+
+	/** Copy heightmap heights in, water and sediment are cleared */
+	void SetHeights(const uint16* InHeights, int32 Stride);
+
+	/** Copy the heights out, rounded and clamped to the heightmap range */
+	void GetHeights(uint16* OutHeights, int32 Stride) const;
+
+	/** Per vertex erosion strength in [0, 1], all 1 if empty */
+	TArray<float> Mask;
+
+	/** Vertices that aren't part of the terrain, such as those of missing components. They are walls and keep their heights. None if empty */
+	TBitArray<> Holes;
+
+	/** Per vertex softness for thermal erosion (1 minus the layer hardness), all 1 if empty */
+	TArray<float> Softness;
+
+	/**
+	 * Paint layer weights in [0, 1], one array of vertices per layer. If set, thermal erosion carries the weights of
+	 * a vertex along with the material it sends, and the weights of the vertices receiving material are renormalized.
+	 */
+	TArray<TArray<float>> LayerWeights;
+
+	/** Heights in heightmap units */
+	TArray<float> Heights;
+
+	/** Water of hydraulic erosion, the rain has to be added before running it */
+	TArray<float> Water;
+	TArray<float> Sediment;
+
+	/** Add the same amount of water to every vertex, scaled by the mask */
+	void Rain(float Amount);
+
+	/** @return Number of iterations run, less than asked for if nothing moved anymore */
+	int32 RunThermal(const FCyLandThermalErosionSettings& Settings);
+
+	/** @return Number of iterations run, less than asked for if all the water evaporated */
+	int32 RunHydraulic(const FCyLandHydraulicErosionSettings& Settings);
+
+#if WITH_EDITOR
+	/**
+	 * Erode a whole landscape, or part of it, as a batch job: the heights are read in one go, eroded, and written back
+	 * with their normals. Thermal erosion uses the hardness of the paint layers.
+	 * @param Region - Landscape vertex region, Max included, clipped to the landscape. The whole landscape if its area is 0
+	 * @param Thermal - Thermal erosion settings, skipped if null
+	 * @param Hydraulic - Hydraulic erosion settings, skipped if null. Runs after thermal erosion
+	 * @param RainAmount - Water on every vertex when hydraulic erosion starts
+	 * @return false if there is nothing to erode
+	 */
+	static bool ErodeCyLand(UCyLandInfo* CyLandInfo, FIntRect Region, const FCyLandThermalErosionSettings* Thermal, const FCyLandHydraulicErosionSettings* Hydraulic, float RainAmount = 128.0f);
+#endif
+
+	/** Vertices along the side of a tile, the whole grid is one tile if it is smaller. The results don't depend on it */
+	int32 TileSize;
+
+	static const int32 DefaultTileSize = 64;
+
+	/** Iterations run on a tile between two halo exchanges */
+	static const int32 IterationsPerRound = 4;
+
+private:
+	/** Run the rounds of an erosion over all the tiles */
+	template<typename TKernel>
+	int32 Run(int32 Iterations, const TKernel& Kernel);
+
+	int32 SizeX;
+	int32 SizeY;
+};
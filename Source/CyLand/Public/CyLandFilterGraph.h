@@ -0,0 +1,257 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandFilterGraph.h: Chains of height filters run over whole landscapes
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+#include "CyLandErosion.h"
+
+class UCyLandInfo;
+
+/** Heights of a block of the landscape, with the apron its filters read around the vertices that get written */
+struct FCyLandFilterTile
+{
+	/** Landscape vertex coordinates of the first height */
+	FIntPoint Origin;
+	int32 SizeX;
+	int32 SizeY;
+
+	/** Heights in heightmap units, SizeY rows of SizeX */
+	TArray<float> Heights;
+
+	/**
+	 * Vertices that have heights, in the same layout, all of them if empty. The others belong to missing components:
+	 * filters don't read them, and what they write there is thrown away
+	 */
+	TBitArray<> Valid;
+
+	float* GetRow(int32 Y) { return Heights.GetData() + Y * SizeX; }
+	const float* GetRow(int32 Y) const { return Heights.GetData() + Y * SizeX; }
+};
+
+/**
+ * A height operation of a filter graph, run on one tile at a time, possibly on several tiles at once.
+ * A filter may be wrong near the edges of a tile where it reads vertices that aren't there, as long as it is right
+ * further than its apron from the edges. The edges of the landscape are the edges of the tiles along them, and the
+ * vertices that aren't valid are holes in the tile.
+ */
+class CYLAND_API FCyLandHeightFilter
+{
+public:
+	virtual ~FCyLandHeightFilter() {}
+
+	/** Distance in vertices up to which the result of a vertex depends on its neighbours */
+	virtual int32 GetApron() const { return 0; }
+
+	virtual void Apply(FCyLandFilterTile& Tile) const = 0;
+};
+
+/** Box filter, the window is clamped at the landscape edges so it stays symmetric, as with the Smooth tool. Holes are left out of the window */
+class CYLAND_API FCyLandSmoothHeightFilter : public FCyLandHeightFilter
+{
+public:
+	FCyLandSmoothHeightFilter(int32 InRadius, float InStrength = 1.0f)
+		: Radius(FMath::Max(InRadius, 0))
+		, Strength(InStrength)
+	{}
+
+	virtual int32 GetApron() const override { return Radius; }
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	/** Apply to a tile with holes, averaging the valid vertices of the window */
+	void ApplyWithHoles(FCyLandFilterTile& Tile) const;
+
+	int32 Radius;
+	float Strength;
+};
+
+/** Move the heights towards a target height, as with the Flatten tool */
+class CYLAND_API FCyLandFlattenHeightFilter : public FCyLandHeightFilter
+{
+public:
+	FCyLandFlattenHeightFilter(float InHeight, float InStrength = 1.0f, bool bInRaise = true, bool bInLower = true)
+		: Height(InHeight)
+		, Strength(InStrength)
+		, bRaise(bInRaise)
+		, bLower(bInLower)
+	{}
+
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	float Height;
+	float Strength;
+	bool bRaise;
+	bool bLower;
+};
+
+/** Add four octaves of Perlin noise, sampled in landscape vertex coordinates so tiles match */
+class CYLAND_API FCyLandNoiseHeightFilter : public FCyLandHeightFilter
+{
+public:
+	/**
+	 * @param InAmount - Amplitude of the noise, in heightmap units
+	 * @param InScale - Size of the first octave, in vertices
+	 * @param InWarpScale, InWarpAmount - Domain warping of the noise, in vertices, off if the amount is 0
+	 */
+	FCyLandNoiseHeightFilter(float InAmount, float InScale, float InWarpScale = 0.0f, float InWarpAmount = 0.0f)
+		: Amount(InAmount)
+		, Scale(InScale)
+		, WarpScale(InWarpScale)
+		, WarpAmount(InWarpAmount)
+	{}
+
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	float Amount;
+	float Scale;
+	float WarpScale;
+	float WarpAmount;
+};
+
+/** Straight ramp between two points, with a flat top and a linear falloff on its sides, as with the Ramp tool */
+class CYLAND_API FCyLandRampHeightFilter : public FCyLandHeightFilter
+{
+public:
+	/**
+	 * @param InStart, InEnd - Landscape vertex coordinates in X and Y, heightmap units in Z
+	 * @param InWidth - Width of the flat top, in vertices
+	 * @param InFalloff - Width of each side slope, in vertices
+	 */
+	FCyLandRampHeightFilter(const FVector& InStart, const FVector& InEnd, float InWidth, float InFalloff)
+		: Start(InStart)
+		, End(InEnd)
+		, Width(InWidth)
+		, Falloff(InFalloff)
+	{}
+
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	FVector Start;
+	FVector End;
+	float Width;
+	float Falloff;
+};
+
+/** Thermal erosion, each iteration reads two vertices further. Holes are walls */
+class CYLAND_API FCyLandThermalErosionHeightFilter : public FCyLandHeightFilter
+{
+public:
+	FCyLandThermalErosionHeightFilter(const FCyLandThermalErosionSettings& InSettings)
+		: Settings(InSettings)
+	{}
+
+	virtual int32 GetApron() const override { return 2 * Settings.Iterations; }
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	FCyLandThermalErosionSettings Settings;
+};
+
+/** Rain on every vertex followed by hydraulic erosion, each iteration reads two vertices further. Holes are walls */
+class CYLAND_API FCyLandHydraulicErosionHeightFilter : public FCyLandHeightFilter
+{
+public:
+	FCyLandHydraulicErosionHeightFilter(const FCyLandHydraulicErosionSettings& InSettings, float InRainAmount = 128.0f)
+		: Settings(InSettings)
+		, RainAmount(InRainAmount)
+	{}
+
+	virtual int32 GetApron() const override { return 2 * Settings.Iterations; }
+	virtual void Apply(FCyLandFilterTile& Tile) const override;
+
+private:
+	FCyLandHydraulicErosionSettings Settings;
+	float RainAmount;
+};
+
+/** Filter written by the caller, it may run on several tiles at once */
+class CYLAND_API FCyLandFunctionHeightFilter : public FCyLandHeightFilter
+{
+public:
+	FCyLandFunctionHeightFilter(TFunction<void(FCyLandFilterTile&)> InFunction, int32 InApron = 0)
+		: Function(MoveTemp(InFunction))
+		, Apron(InApron)
+	{}
+
+	virtual int32 GetApron() const override { return Apron; }
+	virtual void Apply(FCyLandFilterTile& Tile) const override { Function(Tile); }
+
+private:
+	TFunction<void(FCyLandFilterTile&)> Function;
+	int32 Apron;
+};
+
+/**
+ * Chain of height filters run over a landscape without the editor tools, for batch processing.
+ *
+ * The landscape is processed in bands of component aligned tiles. Each tile is read once with the apron all its
+ * filters need, goes through every filter in turn in float, and only its interior is written back, so the filters
+ * are chained without going through the heightmap textures in between. The tiles of a band run in parallel, and the
+ * next band is read before the current one is written so the aprons only ever see the original heights.
+ */
+class CYLAND_API FCyLandFilterGraph
+{
+public:
+	/** Append a filter, the filters run in the order they were added */
+	template<typename FilterType, typename... ArgTypes>
+	FilterType& Add(ArgTypes&&... Args)
+	{
+		FilterType* Filter = new FilterType(Forward<ArgTypes>(Args)...);
+		Filters.Add(TUniquePtr<FCyLandHeightFilter>(Filter));
+		return *Filter;
+	}
+
+	/**
+	 * Append filters from a description, one filter per stage and stages separated by '|', for instance
+	 * "Smooth Radius=4 | Noise Amount=256 Scale=128 | Thermal Iterations=28".
+	 * Stages: Smooth [Radius=] [Strength=], Flatten Height= [Strength=] [RaiseOnly|LowerOnly], Noise Amount= Scale= [WarpScale=] [WarpAmount=],
+	 * Ramp StartX= StartY= StartZ= EndX= EndY= EndZ= [Width=] [Falloff=], Thermal [Iterations=] [Threshold=] [Strength=],
+	 * Hydraulic [Iterations=] [Strength=] [SedimentCapacity=] [Rain=]
+	 * @return false if a stage isn't known, OutError says which
+	 */
+	bool AddFromString(const FString& Description, FString& OutError);
+
+	int32 Num() const { return Filters.Num(); }
+
+	/** Vertices read around a tile, the sum of the aprons of the filters */
+	int32 GetApron() const;
+
+	/**
+	 * Run the filters over a heightmap in memory, in the same bands and tiles as a landscape, for content build steps
+	 * that don't have a world or the editor tools (see UCyLandFilterCommandlet).
+	 * @param Heights - SizeY rows of SizeX heights, filtered in place
+	 * @param TileSize - Side of the tiles, in vertices
+	 * @param Valid - Vertices that have heights, in the same layout. The others are holes, as missing components are, and keep their heights. All of them if null
+	 * @return false if there is nothing to filter
+	 */
+	bool RunOnHeightmap(TArray<uint16>& Heights, int32 SizeX, int32 SizeY, int32 TileSize = 128, const TBitArray<>* Valid = nullptr) const;
+
+#if WITH_EDITOR
+	/**
+	 * Run the filters over a landscape and write the heights back with their normals.
+	 * @param Region - Landscape vertex region, Max included, clipped to the landscape. The whole landscape if its area is 0
+	 * @param ComponentsPerTile - Side of the tiles, in components
+	 * @return false if there is nothing to filter
+	 */
+	bool Run(UCyLandInfo* CyLandInfo, FIntRect Region = FIntRect(), int32 ComponentsPerTile = 2) const;
+#endif
+
+private:
+	/**
+	 * Run the filters over a region in bands of tiles.
+	 * @param Extent - Vertices that can be read, Max included
+	 * @param ReadHeights - Reads a rect of vertices, Max included, in rows of the rect width, and which of them are valid. The bits are left empty if they all are
+	 * @param WriteHeights - Writes a rect of vertices in the same layout, a band and the last rows of the band before it. Vertices that aren't valid get the heights read
+	 */
+	void RunBands(const TCHAR* Name, const FIntRect& Extent, const FIntRect& Region, int32 TileSize, TFunctionRef<void(const FIntRect&, uint16*, TBitArray<>&)> ReadHeights, TFunctionRef<void(const FIntRect&, const uint16*)> WriteHeights) const;
+
+	TArray<TUniquePtr<FCyLandHeightFilter>> Filters;
+};
@@ -0,0 +1,197 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandGrassPlacement.h: Batched candidate generation and sampling for grass builders
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/ParallelFor.h"
+
+/**
+ * Building blocks of the batched grass instance placement: candidates are handled in blocks of SoA float arrays
+ * instead of one FVector at a time.
+ *
+ * Bilinear sampling does the index and lerp math four candidates at a time with VectorRegister, only the corner
+ * loads are scalar. Everything here returns exactly what the per-instance code did (FMath::Lerp, FloorToInt,
+ * CeilToInt, Fractional and Halton), so instance layouts don't change.
+ *
+ * Header only so the test builders outside of the CyLand module can use it.
+ */
+namespace CyLandGrassPlacement
+{
+	/** Candidates per block, small enough for the SoA arrays of a block to stay in cache */
+	enum { BlockSize = 1024 };
+
+	template<uint32 Base>
+	FORCEINLINE float Halton(uint32 Index)
+	{
+		float Result = 0.0f;
+		float InvBase = 1.0f / Base;
+		float Fraction = InvBase;
+		while (Index > 0)
+		{
+			Result += (Index % Base) * Fraction;
+			Index /= Base;
+			Fraction *= InvBase;
+		}
+		return Result;
+	}
+
+	/** Halton<2> by bit reversal, exact below 2^24 where every digit still fits in the mantissa */
+	FORCEINLINE float Halton2(uint32 Index)
+	{
+		return Index < (1u << 24) ? float(ReverseBits(Index)) * (1.0f / 4294967296.0f) : Halton<2>(Index);
+	}
+
+	/** Halton candidates [FirstIndex, FirstIndex + Num) spread over the rectangle Origin, Origin + Extent */
+	inline void GenerateHalton(uint32 FirstIndex, int32 Num, const FVector& Origin, const FVector& Extent, float* OutHaltonX, float* OutHaltonY, float* OutX, float* OutY)
+	{
+		for (int32 Index = 0; Index < Num; Index++)
+		{
+			const float HaltonX = Halton2(FirstIndex + Index);
+			const float HaltonY = Halton<3>(FirstIndex + Index);
+			OutHaltonX[Index] = HaltonX;
+			OutHaltonY[Index] = HaltonY;
+			OutX[Index] = Origin.X + HaltonX * Extent.X;
+			OutY[Index] = Origin.Y + HaltonY * Extent.Y;
+		}
+	}
+
+	/** Scalar reference of SampleBilinear for a single location, either output may be null */
+	template<typename AccessType>
+	FORCEINLINE void SampleBilinearScalar(AccessType& Access, const FVector& DrawScale, const FIntPoint& SectionBase, float X, float Y, float* OutWeight, float* OutZ)
+	{
+		const float TestX = X / DrawScale.X - (float)SectionBase.X;
+		const float TestY = Y / DrawScale.Y - (float)SectionBase.Y;
+
+		// Clamp to prevent the sampling of the final columns from overflowing
+		const int32 IdxX1 = FMath::Clamp<int32>(FMath::FloorToInt(TestX), 0, Access.GetStride() - 1);
+		const int32 IdxY1 = FMath::Clamp<int32>(FMath::FloorToInt(TestY), 0, Access.GetStride() - 1);
+		const int32 IdxX2 = FMath::Clamp<int32>(FMath::CeilToInt(TestX), 0, Access.GetStride() - 1);
+		const int32 IdxY2 = FMath::Clamp<int32>(FMath::CeilToInt(TestY), 0, Access.GetStride() - 1);
+
+		const float LerpX = FMath::Fractional(TestX);
+		const float LerpY = FMath::Fractional(TestY);
+
+		if (OutWeight)
+		{
+			*OutWeight = FMath::Lerp(
+				FMath::Lerp(Access.GetWeight(IdxX1, IdxY1), Access.GetWeight(IdxX2, IdxY1), LerpX),
+				FMath::Lerp(Access.GetWeight(IdxX1, IdxY2), Access.GetWeight(IdxX2, IdxY2), LerpX),
+				LerpY);
+		}
+
+		if (OutZ)
+		{
+			*OutZ = DrawScale.Z * FMath::Lerp(
+				FMath::Lerp(Access.GetHeight(IdxX1, IdxY1), Access.GetHeight(IdxX2, IdxY1), LerpX),
+				FMath::Lerp(Access.GetHeight(IdxX1, IdxY2), Access.GetHeight(IdxX2, IdxY2), LerpX),
+				LerpY);
+		}
+	}
+
+	/** FMath::Lerp on four lanes, same operation order */
+	FORCEINLINE VectorRegister VectorLerp(const VectorRegister& A, const VectorRegister& B, const VectorRegister& Alpha)
+	{
+		return VectorAdd(A, VectorMultiply(Alpha, VectorSubtract(B, A)));
+	}
+
+	/**
+	 * Bilinear layer weight and scaled height at Num local locations.
+	 * @param Access - Grass data accessor with GetStride(), GetWeight(X, Y) and GetHeight(X, Y)
+	 * @param OutWeight - Interpolated weights, may be null when only heights are needed
+	 * @param OutZ - DrawScale.Z * interpolated local height
+	 */
+	template<typename AccessType>
+	void SampleBilinear(AccessType& Access, const FVector& DrawScale, const FIntPoint& SectionBase, const float* X, const float* Y, int32 Num, float* OutWeight, float* OutZ)
+	{
+		const VectorRegister Zero = VectorZero();
+		const VectorRegister One = VectorOne();
+		const VectorRegister MaxIndex = VectorSetFloat1(float(Access.GetStride() - 1));
+		const VectorRegister ScaleX = VectorSetFloat1(DrawScale.X);
+		const VectorRegister ScaleY = VectorSetFloat1(DrawScale.Y);
+		const VectorRegister ScaleZ = VectorSetFloat1(DrawScale.Z);
+		const VectorRegister BaseX = VectorSetFloat1((float)SectionBase.X);
+		const VectorRegister BaseY = VectorSetFloat1((float)SectionBase.Y);
+
+		MS_ALIGN(16) float Indices[4][4] GCC_ALIGN(16);
+		MS_ALIGN(16) float Weights[4][4] GCC_ALIGN(16);
+		MS_ALIGN(16) float Heights[4][4] GCC_ALIGN(16);
+
+		int32 Index = 0;
+		for (; Index + 4 <= Num; Index += 4)
+		{
+			const VectorRegister TestX = VectorSubtract(VectorDivide(VectorLoad(X + Index), ScaleX), BaseX);
+			const VectorRegister TestY = VectorSubtract(VectorDivide(VectorLoad(Y + Index), ScaleY), BaseY);
+			const VectorRegister TruncX = VectorTruncate(TestX);
+			const VectorRegister TruncY = VectorTruncate(TestY);
+			const VectorRegister LerpX = VectorSubtract(TestX, TruncX);
+			const VectorRegister LerpY = VectorSubtract(TestY, TruncY);
+
+			// Floor is one below the truncation for negative fractions, ceil one above for positive fractions
+			const VectorRegister FloorX = VectorSubtract(TruncX, VectorBitwiseAnd(VectorCompareGT(Zero, LerpX), One));
+			const VectorRegister FloorY = VectorSubtract(TruncY, VectorBitwiseAnd(VectorCompareGT(Zero, LerpY), One));
+			const VectorRegister CeilX = VectorAdd(TruncX, VectorBitwiseAnd(VectorCompareGT(LerpX, Zero), One));
+			const VectorRegister CeilY = VectorAdd(TruncY, VectorBitwiseAnd(VectorCompareGT(LerpY, Zero), One));
+
+			VectorStoreAligned(VectorMin(VectorMax(FloorX, Zero), MaxIndex), Indices[0]);
+			VectorStoreAligned(VectorMin(VectorMax(FloorY, Zero), MaxIndex), Indices[1]);
+			VectorStoreAligned(VectorMin(VectorMax(CeilX, Zero), MaxIndex), Indices[2]);
+			VectorStoreAligned(VectorMin(VectorMax(CeilY, Zero), MaxIndex), Indices[3]);
+
+			for (int32 Lane = 0; Lane < 4; Lane++)
+			{
+				const int32 IdxX1 = (int32)Indices[0][Lane];
+				const int32 IdxY1 = (int32)Indices[1][Lane];
+				const int32 IdxX2 = (int32)Indices[2][Lane];
+				const int32 IdxY2 = (int32)Indices[3][Lane];
+
+				if (OutWeight)
+				{
+					Weights[0][Lane] = Access.GetWeight(IdxX1, IdxY1);
+					Weights[1][Lane] = Access.GetWeight(IdxX2, IdxY1);
+					Weights[2][Lane] = Access.GetWeight(IdxX1, IdxY2);
+					Weights[3][Lane] = Access.GetWeight(IdxX2, IdxY2);
+				}
+				Heights[0][Lane] = Access.GetHeight(IdxX1, IdxY1);
+				Heights[1][Lane] = Access.GetHeight(IdxX2, IdxY1);
+				Heights[2][Lane] = Access.GetHeight(IdxX1, IdxY2);
+				Heights[3][Lane] = Access.GetHeight(IdxX2, IdxY2);
+			}
+
+			if (OutWeight)
+			{
+				const VectorRegister Weight = VectorLerp(
+					VectorLerp(VectorLoadAligned(Weights[0]), VectorLoadAligned(Weights[1]), LerpX),
+					VectorLerp(VectorLoadAligned(Weights[2]), VectorLoadAligned(Weights[3]), LerpX),
+					LerpY);
+				VectorStore(Weight, OutWeight + Index);
+			}
+
+			const VectorRegister Height = VectorLerp(
+				VectorLerp(VectorLoadAligned(Heights[0]), VectorLoadAligned(Heights[1]), LerpX),
+				VectorLerp(VectorLoadAligned(Heights[2]), VectorLoadAligned(Heights[3]), LerpX),
+				LerpY);
+			VectorStore(VectorMultiply(ScaleZ, Height), OutZ + Index);
+		}
+
+		for (; Index < Num; Index++)
+		{
+			SampleBilinearScalar(Access, DrawScale, SectionBase, X[Index], Y[Index], OutWeight ? OutWeight + Index : nullptr, OutZ + Index);
+		}
+	}
+
+	/** SampleBilinear split in BlockSize chunks over the task graph, so idle workers help with large grass sub-sections */
+	template<typename AccessType>
+	void SampleBilinearParallel(AccessType& Access, const FVector& DrawScale, const FIntPoint& SectionBase, const float* X, const float* Y, int32 Num, float* OutWeight, float* OutZ, bool bForceSingleThread)
+	{
+		const int32 NumChunks = FMath::DivideAndRoundUp<int32>(Num, BlockSize);
+		ParallelFor(NumChunks, [&](int32 Chunk)
+		{
+			const int32 Start = Chunk * BlockSize;
+			SampleBilinear(Access, DrawScale, SectionBase, X + Start, Y + Start, FMath::Min<int32>(BlockSize, Num - Start), OutWeight ? OutWeight + Start : nullptr, OutZ + Start);
+		}, bForceSingleThread || NumChunks < 2);
+	}
+}
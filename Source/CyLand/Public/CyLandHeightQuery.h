@@ -0,0 +1,137 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandHeightQuery.h: Batched CPU height and normal queries on CyLand collision
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ACyLandProxy;
+class UCyLandHeightfieldCollisionComponent;
+class UWorld;
+
+/**
+ * Read-only ground queries on a CPU copy of the collision heights of one CyLand, for gameplay code issuing lots of
+ * them (AI, ballistics, foliage snapping) without line traces or an FCyLandComponentDataInterface per component.
+ *
+ * Each collision component contributes a tile of heights read back from its live heightfield, so runtime edits
+ * (SetCollisionHeights) and cooked builds are covered. Tiles are refreshed when the physics state of a component is
+ * created or its heightfield is patched, and dropped when the physics state is destroyed. Holes are not taken into
+ * account, their heights are returned like any other.
+ *
+ * Updates happen on the game thread and are gathered until the end of the frame, which publishes one new snapshot of
+ * the tile grid for all of them. Queries grab the current snapshot once per batch so they can run on any thread at the
+ * same time as updates. Batches are evaluated four positions at
+ * a time with VectorRegister, only the tile lookup and the corner loads are per position.
+ *
+ * The landscape may be translated, scaled and rotated around Z, queries are vertical in world space.
+ */
+class CYLAND_API FCyLandHeightQuery
+{
+public:
+	/** Query service of the landscape of Proxy in its world, created and filled on first use. Game thread only. */
+	static TSharedRef<FCyLandHeightQuery, ESPMode::ThreadSafe> Get(const ACyLandProxy* Proxy);
+
+	/**
+	 * World space height and normal under a batch of world XY positions.
+	 * @param OutHeights - World Z of the ground, 0 where there is no collision
+	 * @param OutNormals - World space ground normals, may be null
+	 * @param OutValid - Whether there was collision under each position, may be null
+	 * @return Number of positions with collision under them
+	 */
+	int32 QueryHeights(const FVector2D* Positions, int32 Num, float* OutHeights, FVector* OutNormals = nullptr, bool* OutValid = nullptr) const;
+
+	int32 QueryHeights(const TArray<FVector2D>& Positions, TArray<float>& OutHeights, TArray<FVector>* OutNormals = nullptr, TArray<bool>* OutValid = nullptr) const;
+
+	/** Single position version of QueryHeights, returns false if there is no collision under it */
+	bool QueryHeight(const FVector2D& Position, float& OutHeight, FVector* OutNormal = nullptr) const;
+
+	/** Copy the current heights of a collision component into its tile, if its landscape has a query service */
+	static void UpdateComponent(const UCyLandHeightfieldCollisionComponent* Component);
+
+	/** Drop the tile of a collision component, if its landscape has a query service */
+	static void RemoveComponent(const UCyLandHeightfieldCollisionComponent* Component);
+
+	/** Release the query services of a world that is going away */
+	static void RemoveWorld(const UWorld* World);
+
+private:
+	/** Heights of one collision component, local Z in landscape quad units */
+	struct FTile
+	{
+		FIntPoint Key;
+		int32 SizeVerts;
+		/** Collision vertices per landscape quad */
+		float VertsPerQuad;
+		TArray<float> Heights;
+	};
+
+	typedef TSharedRef<const FTile, ESPMode::ThreadSafe> FTileRef;
+
+	/** Immutable state the queries run on, replaced as a whole by updates */
+	struct FSnapshot
+	{
+		FSnapshot()
+			: WorldToCyLand(FMatrix::Identity)
+			, CyLandToWorld(FMatrix::Identity)
+			, ComponentSizeQuads(1)
+			, GridMin(0, 0)
+			, GridSize(0, 0)
+		{
+		}
+
+		/** World XY to landscape XY, and landscape XYZ to world Z */
+		FMatrix WorldToCyLand;
+		FMatrix CyLandToWorld;
+		int32 ComponentSizeQuads;
+
+		/** Dense grid of the tiles by component key, null where there is no collision */
+		FIntPoint GridMin;
+		FIntPoint GridSize;
+		TArray<const FTile*> Grid;
+
+		/** Keeps the tiles referenced by Grid alive */
+		TArray<FTileRef> Tiles;
+
+		const FTile* FindTile(int32 KeyX, int32 KeyY) const
+		{
+			const int32 GridX = KeyX - GridMin.X;
+			const int32 GridY = KeyY - GridMin.Y;
+			if ((uint32)GridX >= (uint32)GridSize.X || (uint32)GridY >= (uint32)GridSize.Y)
+			{
+				return nullptr;
+			}
+			return Grid[GridY * GridSize.X + GridX];
+		}
+	};
+
+	typedef TSharedRef<const FSnapshot, ESPMode::ThreadSafe> FSnapshotRef;
+
+	FCyLandHeightQuery();
+
+	FSnapshotRef GetSnapshot() const;
+
+	/** Add (or replace) the tile at Key in the next snapshot, a null tile drops it. Game thread only. */
+	void QueueTile(const FIntPoint& Key, const TSharedPtr<const FTile, ESPMode::ThreadSafe>& Tile, const ACyLandProxy* Proxy);
+
+	/** Publish a snapshot with the queued tiles, game thread only */
+	void PublishPendingTiles();
+
+	/** Bound to OnEndFrame while tiles are queued */
+	static void FlushPendingTiles();
+
+	void AddComponent(const UCyLandHeightfieldCollisionComponent* Component, const ACyLandProxy* Proxy);
+
+	static TSharedPtr<FCyLandHeightQuery, ESPMode::ThreadSafe> Find(const UCyLandHeightfieldCollisionComponent* Component, const ACyLandProxy*& OutProxy);
+
+	mutable FCriticalSection SnapshotLock;
+	FSnapshotRef Snapshot;
+
+	/** Tiles waiting for the end of the frame by component key, null to drop the tile */
+	TMap<FIntPoint, TSharedPtr<const FTile, ESPMode::ThreadSafe>> PendingTiles;
+
+	/** Proxy giving the transform of the next snapshot, unset to keep the current one */
+	TWeakObjectPtr<const ACyLandProxy> PendingProxy;
+};
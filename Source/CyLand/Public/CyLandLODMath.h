@@ -0,0 +1,190 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLODMath.h: Screen size, LOD and tessellation decisions of CyLand components
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The math FCyLandComponentSceneProxy makes its LOD, sub-section and tessellation decisions with, free of any
+ * renderer state so it can be evaluated without a scene (see FCyLandLODSimulation).
+ *
+ * Header only so the simulation and the tests outside of the CyLand module run exactly what the proxy runs.
+ */
+namespace CyLandLODMath
+{
+	/** Screen size thresholds of each LOD, squared, for LOD 0 to MaxLOD. Thresholds decrease with the LOD index. */
+	inline void BuildLODScreenRatioSquared(int32 MaxLOD, float LOD0DistributionSetting, float LODDistributionSetting, TArray<float>& OutLODScreenRatioSquared)
+	{
+		float ScreenSizeRatioDivider = FMath::Max(LOD0DistributionSetting, 1.01f);
+		float CurrentScreenSizeRatio = 1.0f;
+
+		OutLODScreenRatioSquared.Reset(MaxLOD + 1);
+		OutLODScreenRatioSquared.AddUninitialized(MaxLOD + 1);
+
+		// LOD 0 handling
+		OutLODScreenRatioSquared[0] = FMath::Square(CurrentScreenSizeRatio);
+		CurrentScreenSizeRatio /= ScreenSizeRatioDivider;
+		ScreenSizeRatioDivider = FMath::Max(LODDistributionSetting, 1.01f);
+
+		// Other LODs
+		for (int32 LODIndex = 1; LODIndex <= MaxLOD; ++LODIndex)
+		{
+			OutLODScreenRatioSquared[LODIndex] = FMath::Square(CurrentScreenSizeRatio);
+			CurrentScreenSizeRatio /= ScreenSizeRatioDivider;
+		}
+	}
+
+	/** Projection multiple accounting for view scaling */
+	FORCEINLINE float GetScreenMultiple(const FMatrix& ProjMatrix)
+	{
+		return FMath::Max(0.5f * ProjMatrix.M[0][0], 0.5f * ProjMatrix.M[1][1]);
+	}
+
+	/** Squared screen size of a component or sub-section, from the closest point of its XY extent to the camera */
+	FORCEINLINE float GetComponentScreenSize(const FVector& CameraOrigin, float ScreenMultiple, const FVector& Origin, float MaxExtend, float ElementRadius)
+	{
+		const FVector OriginToCamera = (CameraOrigin - Origin).GetAbs();
+		const FVector ClosestPoint = OriginToCamera.ComponentMin(FVector(MaxExtend));
+		const float DistSquared = (OriginToCamera - ClosestPoint).SizeSquared();
+
+		// Calculate screen-space projected radius
+		float SquaredScreenRadius = FMath::Square(ScreenMultiple * ElementRadius) / FMath::Max(1.0f, DistSquared);
+
+		return FMath::Min(SquaredScreenRadius * 2.0f, 1.0f);
+	}
+
+	/** Discrete LOD of a squared screen size */
+	inline int8 GetLODFromScreenSize(const TArray<float>& LODScreenRatioSquared, float InScreenSizeSquared, float InViewLODScale)
+	{
+		int32 LODScreenRatioSquaredCount = LODScreenRatioSquared.Num();
+		float ScreenSizeSquared = InScreenSizeSquared / InViewLODScale;
+
+		if (ScreenSizeSquared <= LODScreenRatioSquared[LODScreenRatioSquaredCount - 1])
+		{
+			return LODScreenRatioSquaredCount - 1;
+		}
+		else if (ScreenSizeSquared > LODScreenRatioSquared[1])
+		{
+			return 0;
+		}
+		else
+		{
+			int32 HalfPointIndex = (LODScreenRatioSquaredCount - 1) / 2;
+			int32 StartingIndex = ScreenSizeSquared < LODScreenRatioSquared[HalfPointIndex] ? HalfPointIndex : 1;
+			int8 SelectedLODIndex = INDEX_NONE;
+
+			for (int32 i = StartingIndex; i < LODScreenRatioSquaredCount - 1; ++i)
+			{
+				if (ScreenSizeSquared > LODScreenRatioSquared[i + 1])
+				{
+					SelectedLODIndex = i;
+					break;
+				}
+			}
+
+			return SelectedLODIndex;
+		}
+	}
+
+	/** Continuous LOD of a squared screen size within the range of the selected discrete LOD, used for morphing */
+	inline float ComputeBatchElementCurrentLOD(const TArray<float>& LODScreenRatioSquared, int32 InSelectedLODIndex, float InComponentScreenSize)
+	{
+		check(LODScreenRatioSquared.IsValidIndex(InSelectedLODIndex));
+
+		bool LastElement = InSelectedLODIndex == LODScreenRatioSquared.Num() - 1;
+		float CurrentLODScreenRatio = LODScreenRatioSquared[InSelectedLODIndex];
+		float NextLODScreenRatio = LastElement ? 0 : LODScreenRatioSquared[InSelectedLODIndex + 1];
+
+		float LODScreenRatioRange = CurrentLODScreenRatio - NextLODScreenRatio;
+
+		if (InComponentScreenSize > CurrentLODScreenRatio || InComponentScreenSize < NextLODScreenRatio)
+		{
+			// Find corresponding LODIndex to appropriately calculate Ratio and apply it to new LODIndex
+			int32 LODFromScreenSize = GetLODFromScreenSize(LODScreenRatioSquared, InComponentScreenSize, 1.0f); // for 4.19 only
+			CurrentLODScreenRatio = LODScreenRatioSquared[LODFromScreenSize];
+			NextLODScreenRatio = LODFromScreenSize == LODScreenRatioSquared.Num() - 1 ? 0 : LODScreenRatioSquared[LODFromScreenSize + 1];
+			LODScreenRatioRange = CurrentLODScreenRatio - NextLODScreenRatio;
+		}
+
+		float CurrentLODRangeRatio = (InComponentScreenSize - NextLODScreenRatio) / LODScreenRatioRange;
+		float fLOD = (float)InSelectedLODIndex + (1.0f - CurrentLODRangeRatio);
+
+		return fLOD;
+	}
+
+	/**
+	 * Continuous LOD the proxy renders a squared screen size with, after bias and clamping.
+	 * @param PreferedLOD - Forced or overridden LOD, negative to select from the screen size
+	 * @param MinLOD - Lowest LOD index allowed, the larger of the streamed mip and the biased minimum
+	 * @param MaxLOD - Highest LOD index allowed
+	 */
+	FORCEINLINE float GetBiasedLOD(const TArray<float>& LODScreenRatioSquared, float ScreenSizeSquared, float ViewLODScale, float PreferedLOD, int32 LODBias, float MinLOD, float MaxLOD)
+	{
+		if (PreferedLOD >= 0.0f)
+		{
+			return FMath::Clamp<float>(PreferedLOD + LODBias, MinLOD, MaxLOD);
+		}
+		return FMath::Clamp<float>(ComputeBatchElementCurrentLOD(LODScreenRatioSquared, GetLODFromScreenSize(LODScreenRatioSquared, ScreenSizeSquared, ViewLODScale), ScreenSizeSquared) + LODBias, MinLOD, MaxLOD);
+	}
+
+	/** Whether a component is large enough on screen for its sub-sections to pick their own LODs */
+	FORCEINLINE bool UseSubSectionLODs(float ComponentScreenSizeSquared, float ComponentSquaredScreenSizeToUseSubSections, float ViewLODScale)
+	{
+		return ComponentScreenSizeSquared > ComponentSquaredScreenSizeToUseSubSections * FMath::Square(ViewLODScale);
+	}
+
+	/** Whether the sub-sections of a component are close enough to the same screen size to be drawn as one batch */
+	inline bool SubSectionsHaveSameScreenSize(const float* SubSectionScreenSizeSquared, int32 NumSubSections, float ViewLODScale)
+	{
+		const float SquaredViewLODScale = FMath::Square(ViewLODScale);
+		float CombinedScreenRatio = 0.0f;
+
+		for (int32 SubSectionIndex = 0; SubSectionIndex < NumSubSections; ++SubSectionIndex)
+		{
+			float CurrentScreenRadiusSquared = SubSectionScreenSizeSquared[SubSectionIndex] * SquaredViewLODScale;
+
+			if (CombinedScreenRatio > 0.0f && !FMath::IsNearlyEqual(CombinedScreenRatio, CurrentScreenRadiusSquared, KINDA_SMALL_NUMBER))
+			{
+				return false;
+			}
+
+			CombinedScreenRatio += CurrentScreenRadiusSquared;
+
+			if (SubSectionIndex > 0)
+			{
+				CombinedScreenRatio *= 0.5f;
+			}
+		}
+
+		return true;
+	}
+
+	/** Whether the tessellated mesh batch is used at a squared screen size */
+	FORCEINLINE bool UseTessellation(float ScreenSizeSquared, float TessellationComponentSquaredScreenSize, float ViewLODScale)
+	{
+		return ScreenSizeSquared >= TessellationComponentSquaredScreenSize * ViewLODScale;
+	}
+
+	/** Whether a shadow cascade is fine enough for the tessellated shadow mesh batch to make a difference */
+	FORCEINLINE bool CanUseTessellationForShadowCascade(float TessellationDisablingShadowMapMeshSize, float ShadowMapTextureResolution, float ShadowMapCascadeSize, float WorldUnitsToTexelFactor)
+	{
+		if (TessellationDisablingShadowMapMeshSize == 0.0f)
+		{
+			return true;
+		}
+
+		float WorldUnitsForOneTexel = ShadowMapCascadeSize / ShadowMapTextureResolution; // We assume Shadow Map texture to be squared
+		return TessellationDisablingShadowMapMeshSize >= WorldUnitsForOneTexel * (WorldUnitsToTexelFactor != -1.0f ? WorldUnitsToTexelFactor : 1.0f);
+	}
+
+	/** Triangles of one sub-section drawn at a LOD */
+	FORCEINLINE int32 GetSubSectionTriangleCount(int32 SubsectionSizeVerts, int32 LOD)
+	{
+		const int32 LODSubsectionSizeQuads = FMath::Max((SubsectionSizeVerts >> LOD) - 1, 1);
+		return 2 * FMath::Square(LODSubsectionSizeQuads);
+	}
+}
@@ -0,0 +1,158 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLODSimulation.h: Offline replay of CyLand LOD decisions along camera paths
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One camera of a recorded or generated path */
+struct FCyLandCameraSample
+{
+	FCyLandCameraSample()
+		: Time(0.0f)
+		, Location(ForceInitToZero)
+		, Rotation(ForceInitToZero)
+		, FOV(90.0f)
+	{
+	}
+
+	float Time;
+	FVector Location;
+	FRotator Rotation;
+	/** Horizontal field of view in degrees */
+	float FOV;
+};
+
+/** Camera path replayed by FCyLandLODSimulation, saved as CSV lines of Time,X,Y,Z,Pitch,Yaw,Roll,FOV */
+struct CYLAND_API FCyLandCameraPath
+{
+	TArray<FCyLandCameraSample> Samples;
+
+	bool LoadFromFile(const FString& Filename);
+	bool SaveToFile(const FString& Filename) const;
+
+	/** Lap around a landscape of Size x Size world units centered on the origin, at Height and looking at the center */
+	static FCyLandCameraPath MakeFlyover(float Size, float Height, int32 NumSamples);
+};
+
+/** Synthetic landscape the simulation runs on, and the LOD settings under tuning (same meaning as on ACyLandProxy) */
+struct FCyLandLODSimulationSettings
+{
+	FCyLandLODSimulationSettings()
+		: NumComponents(32, 32)
+		, SubsectionSizeQuads(63)
+		, NumSubsections(1)
+		, Scale(100.0f, 100.0f, 100.0f)
+		, HeightRange(25600.0f)
+		, LOD0DistributionSetting(1.75f)
+		, LODDistributionSetting(2.0f)
+		, ComponentScreenSizeToUseSubSections(0.65f)
+		, TessellationComponentScreenSize(0.8f)
+		, MaxLODLevel(-1)
+		, LODBias(0)
+		, ForcedLOD(INDEX_NONE)
+		, ViewLODScale(1.0f)
+		, AspectRatio(16.0f / 9.0f)
+		, bFrustumCull(true)
+	{
+	}
+
+	/** Components of the grid, centered on the origin */
+	FIntPoint NumComponents;
+	int32 SubsectionSizeQuads;
+	int32 NumSubsections;
+	FVector Scale;
+	/** Peak to peak height of the rolling hills the component bounds are built from, in world units */
+	float HeightRange;
+
+	float LOD0DistributionSetting;
+	float LODDistributionSetting;
+	float ComponentScreenSizeToUseSubSections;
+	float TessellationComponentScreenSize;
+	int32 MaxLODLevel;
+	int32 LODBias;
+	int32 ForcedLOD;
+
+	float ViewLODScale;
+	float AspectRatio;
+	bool bFrustumCull;
+};
+
+/** LOD decisions of one simulated frame */
+struct FCyLandLODSimulationFrame
+{
+	FCyLandLODSimulationFrame()
+		: NumVisible(0)
+		, NumCombined(0)
+		, NumTessellated(0)
+		, NumTriangles(0)
+		, DecisionSeconds(0.0)
+	{
+	}
+
+	/** Components in the frustum */
+	int32 NumVisible;
+	/** Visible components drawn as one batch rather than per sub-section */
+	int32 NumCombined;
+	/** Visible components close enough for the tessellated mesh batch */
+	int32 NumTessellated;
+	int64 NumTriangles;
+	/** Visible sub-sections by the LOD they are drawn at */
+	TArray<int32> LODHistogram;
+	/** Time taken by the culling and the LOD decisions of the frame */
+	double DecisionSeconds;
+};
+
+struct CYLAND_API FCyLandLODSimulationReport
+{
+	TArray<FCyLandLODSimulationFrame> Frames;
+
+	/** Averages and peaks over all the frames */
+	FString GetSummary() const;
+
+	/** One CSV line per frame */
+	bool SaveToFile(const FString& Filename) const;
+};
+
+/**
+ * Replays camera paths over a synthetic grid of components with the LOD math of FCyLandComponentSceneProxy
+ * (CyLandLODMath), without a world, a scene or an RHI. Used to compare LOD settings offline, see the
+ * CyLand.LODSimulation console command.
+ *
+ * Editor and streaming state the proxy also reads (LOD overrides of the view family, heightmap mips, the
+ * combined batch debug options) is left out: components are fully streamed in.
+ */
+class CYLAND_API FCyLandLODSimulation
+{
+public:
+	explicit FCyLandLODSimulation(const FCyLandLODSimulationSettings& InSettings);
+
+	FCyLandLODSimulationFrame SimulateFrame(const FCyLandCameraSample& Camera) const;
+
+	FCyLandLODSimulationReport Run(const FCyLandCameraPath& Path) const;
+
+	/** Lowest detail LOD components are drawn with */
+	int32 GetMaxLOD() const { return MaxLOD; }
+
+private:
+	/** Same bounds UCyLandComponent and FCyLandComponentSceneProxy compute */
+	struct FComponent
+	{
+		FBox Box;
+		FVector Origin;
+		float SphereRadius;
+		FVector SubSectionOrigins[4];
+	};
+
+	FCyLandLODSimulationSettings Settings;
+	TArray<FComponent> Components;
+	TArray<float> LODScreenRatioSquared;
+	int32 MaxLOD;
+	int32 LastLOD;
+	float MinValidLOD;
+	float MaxValidLOD;
+	float ComponentMaxExtend;
+};
@@ -0,0 +1,80 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandNoise.h: Octave Perlin noise evaluated eight samples at a time
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Octave Perlin noise of the Noise tool, the erosion tools and procedural terrain.
+ *
+ * The noise is the one of FNoiseParameter, with the same permutation table and gradients. FNoiseParameter mirrors it
+ * around the axes, SampleRowMirrored does too so the tools look the same as before, the other samplers don't.
+ *
+ * Samples are evaluated eight at a time: the permutation lookups are done per sample, then the gradients, fades and
+ * lerps run on VectorRegister. The gradients are a table of X and Y factors instead of the branches of the per-sample
+ * code, and the scale and amplitude of each octave are computed once.
+ *
+ * Positions can optionally be displaced by another noise first (domain warping), which breaks the regular look of
+ * plain Perlin noise on large terrains.
+ */
+class CYLAND_API FCyLandNoise
+{
+public:
+	enum { NumSamplesPerCall = 8 };
+	enum { MaxOctaves = 8 };
+
+	/**
+	 * @param InScale - Size of the first octave, in vertices
+	 * @param InAmount - Amplitude of the noise
+	 * @param InBase - Added to every sample
+	 * @param InNumOctaves - Each octave has twice the frequency and half the amplitude of the one before
+	 */
+	FCyLandNoise(float InScale, float InAmount, float InBase = 0.0f, int32 InNumOctaves = 4);
+
+	/**
+	 * Displace the sample positions by another noise before sampling.
+	 * @param InWarpScale - Size of the displacement noise, in vertices
+	 * @param InWarpAmount - Largest displacement, in vertices. 0 disables warping
+	 */
+	void SetDomainWarp(float InWarpScale, float InWarpAmount);
+
+	/** Sample at eight positions, in vertices */
+	void Sample8(const float* X, const float* Y, float* OutValues) const;
+
+	/** Sample a row of vertices starting at X */
+	void SampleRow(int32 X, int32 Y, int32 Count, float* OutValues) const;
+
+	/**
+	 * Sample a row of vertices mirrored around the axes, with the same results as FNoiseParameter::Sample (ignoring
+	 * warping). Only for the editor tools, whose strokes have to look as they always did; the noise is symmetric around 0
+	 */
+	void SampleRowMirrored(int32 X, int32 Y, int32 Count, float* OutValues) const;
+
+	/** Sample a single vertex, prefer SampleRow for more than a few */
+	float Sample(int32 X, int32 Y) const;
+
+	/** Single octave of Perlin noise, in [-1, 1] */
+	static float PerlinNoise2D(float X, float Y);
+
+private:
+	void SampleRow(int32 X, int32 Y, int32 Count, float* OutValues, bool bMirrored) const;
+
+	/** Add one octave of noise at eight positions, times Amplitude, to InOutValues */
+	static void AddPerlinNoise8(const float* X, const float* Y, float Amplitude, float* InOutValues);
+
+	float Base;
+	float Amount;
+	int32 NumOctaves;
+
+	/** Frequency and amplitude of each octave, the amount scales their sum */
+	float OctaveScales[MaxOctaves];
+	float OctaveAmplitudes[MaxOctaves];
+
+	/** 0 if warping is off */
+	float WarpScale;
+	float WarpAmount;
+};
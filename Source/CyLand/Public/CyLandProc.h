@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "CyLand/Classes/CyLand.h"
+#include "CyLand/Classes/CyLandStreamingWorld.h"
 #include "CyLandProc.generated.h"
 
 
@@ -13,8 +14,20 @@ class CYLAND_API UProceuduralGameLandUtils : public UBlueprintFunctionLibrary
 {
 	GENERATED_UCLASS_BODY()
 
+	/**
+	 * Spawn a CyLand, flat unless given a noise amount.
+	 * @param NoiseAmount - Amplitude of the octave noise the terrain is generated with, in heightmap units
+	 * @param NoiseScale - Size of the first octave of the noise, in vertices
+	 */
 	UFUNCTION(BlueprintCallable, Category = "Procedural Rendering")
-	static ACyLand* SpawnGameLand(AActor* context, UMaterialInterface* mat, int32 SectionsPerComponent=1, int32 ComponentCountX = 8, int32 ComponentCountY = 8, int32 QuadsPerComponent = 127);
+	static ACyLand* SpawnGameLand(AActor* context, UMaterialInterface* mat, int32 SectionsPerComponent=1, int32 ComponentCountX = 8, int32 ComponentCountY = 8, int32 QuadsPerComponent = 127, float NoiseAmount = 0.0f, float NoiseScale = 256.0f);
+
+	/**
+	 * Spawn a CyLand that is streamed in tiles around the viewers instead of being imported at once.
+	 * @param StreamingDistance - Distance in world units around each viewer inside which tiles are kept resident
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Procedural Rendering")
+	static ACyLandStreamingWorld* SpawnStreamingGameLand(AActor* context, UMaterialInterface* mat, int32 SectionsPerComponent = 1, int32 ComponentsPerTile = 8, int32 QuadsPerComponent = 63, float StreamingDistance = 150000.0f);
 
 	UFUNCTION(BlueprintCallable, Category = "Procedural Rendering")
 	static void NotifyMaterialUpdated(ACyLand* CyLand);
@@ -10,6 +10,7 @@ CyLandRender.h: New terrain rendering
 #include "Misc/Guid.h"
 #include "Engine/EngineTypes.h"
 #include "Templates/RefCounting.h"
+#include "Math/Float16.h"
 #include "Containers/ArrayView.h"
 #include "ShaderParameters.h"
 #include "RenderResource.h"
@@ -34,6 +35,8 @@ CyLandRender.h: New terrain rendering
 #define LANDSCAPE_MAX_SUBSECTION_NUM 2
 
 class FCyLandComponentSceneProxy;
+class FCyLandLODSolver;
+struct FCyLandComponentLOD;
 
 #if WITH_EDITOR
 namespace ECyLandViewMode
@@ -242,6 +245,18 @@ struct FCyLandVertex
 	float SubY;
 };
 
+/**
+ * FCyLandVertex with 2 bytes per component, half the vertex memory and fetch bandwidth. Grid coordinates stay below
+ * 256, which halves hold exactly, so shaders read the same values (see r.CyLandPackedVertices).
+ */
+struct FCyLandPackedVertex
+{
+	FFloat16 VertexX;
+	FFloat16 VertexY;
+	FFloat16 SubX;
+	FFloat16 SubY;
+};
+
 //
 // FCyLandVertexBuffer
 //
@@ -251,14 +266,16 @@ class FCyLandVertexBuffer : public FVertexBuffer
 	int32 NumVertices;
 	int32 SubsectionSizeVerts;
 	int32 NumSubsections;
+	bool bPacked;
 public:
 
 	/** Constructor. */
-	FCyLandVertexBuffer(ERHIFeatureLevel::Type InFeatureLevel, int32 InNumVertices, int32 InSubsectionSizeVerts, int32 InNumSubsections)
+	FCyLandVertexBuffer(ERHIFeatureLevel::Type InFeatureLevel, int32 InNumVertices, int32 InSubsectionSizeVerts, int32 InNumSubsections, bool bInPacked = false)
 		: FeatureLevel(InFeatureLevel)
 		, NumVertices(InNumVertices)
 		, SubsectionSizeVerts(InSubsectionSizeVerts)
 		, NumSubsections(InNumSubsections)
+		, bPacked(bInPacked)
 	{
 		InitResource();
 	}
@@ -273,6 +290,15 @@ public:
 	* Initialize the RHI for this rendering resource
 	*/
 	virtual void InitRHI() override;
+	virtual void ReleaseRHI() override;
+
+	/** Whether vertices are FCyLandPackedVertex rather than FCyLandVertex */
+	bool IsPacked() const { return bPacked; }
+	uint32 GetStride() const { return bPacked ? sizeof(FCyLandPackedVertex) : sizeof(FCyLandVertex); }
+	EVertexElementType GetElementType() const { return bPacked ? VET_Half4 : VET_Float4; }
+
+	/** Writes the grid vertices of all sub-sections, in the layout IsPacked selects */
+	static void FillVertices(void* OutVertices, int32 InSubsectionSizeVerts, int32 InNumSubsections, bool bInPacked);
 };
 
 
@@ -282,9 +308,14 @@ public:
 class FCyLandSharedAdjacencyIndexBuffer
 {
 public:
+	/** Allocates the buffers of every LOD, LODs are filled by CreateLOD when a proxy needs them */
 	FCyLandSharedAdjacencyIndexBuffer(class FCyLandSharedBuffers* SharedBuffer);
 	virtual ~FCyLandSharedAdjacencyIndexBuffer();
 
+	/** Expands the triangle list of a LOD into PN-AEN patches and initializes the buffer of that LOD */
+	template <typename INDEX_TYPE>
+	void CreateLOD(int32 LODIndex, int32 LODSubsectionSizeQuads, int32 NumSubsections, const TArray<INDEX_TYPE>& Indices);
+
 	TArray<FIndexBuffer*> IndexBuffers; // For tessellation
 };
 
@@ -310,29 +341,63 @@ public:
 
 	FCyLandVertexFactory* VertexFactory;
 	FCyLandVertexBuffer* VertexBuffer;
+	/** One buffer per LOD, always allocated so mesh batches can point at them, but only filled for the LODs in BuiltLODMask */
 	FIndexBuffer** IndexBuffers;
 	FCyLandIndexRanges* IndexRanges;
 	FCyLandSharedAdjacencyIndexBuffer* AdjacencyIndexBuffers;
 	FOccluderIndexArraySP OccluderIndicesSP;
 	bool bUse32BitIndices;
+	/** LODs of IndexBuffers and AdjacencyIndexBuffers that are built */
+	uint32 BuiltLODMask;
+	uint32 BuiltAdjacencyLODMask;
+	/** Bytes of index data built so far, index and adjacency buffers of all LODs and the grass index buffer */
+	SIZE_T IndexBufferSize;
 #if WITH_EDITOR
+	/** Allocated with the other buffers, only filled by RequestGrassIndexBuffer the first time grass is rendered */
 	FIndexBuffer* GrassIndexBuffer;
 	TArray<int32, TInlineAllocator<8>> GrassIndexMipOffsets;
 #endif
 
-	FCyLandSharedBuffers(int32 SharedBuffersKey, int32 SubsectionSizeQuads, int32 NumSubsections, ERHIFeatureLevel::Type FeatureLevel, bool bRequiresAdjacencyInformation, int32 NumOcclusionVertices);
+	FCyLandSharedBuffers(int32 SharedBuffersKey, int32 SubsectionSizeQuads, int32 NumSubsections, ERHIFeatureLevel::Type FeatureLevel, int32 NumOcclusionVertices);
 
-	template <typename INDEX_TYPE>
-	void CreateIndexBuffers(ERHIFeatureLevel::Type InFeatureLevel, bool bRequiresAdjacencyInformation);
+	/**
+	 * Builds the index buffers of LODs MinLOD to MaxLOD that aren't built yet, and their adjacency buffers if
+	 * requested. Proxies call this with the LODs they can select so LODs no proxy can select are never built.
+	 */
+	void RequestLODs(int32 MinLOD, int32 MaxLOD, bool bRequiresAdjacencyInformation);
+
+#if WITH_EDITOR
+	void RequestGrassIndexBuffer();
+#endif
+
+	/** Vertex, index and occluder memory held by these buffers */
+	SIZE_T GetResourceSize() const;
 
 	void CreateOccluderIndexBuffer(int32 NumOcclderVertices);
-	
+
+	virtual ~FCyLandSharedBuffers();
+
+private:
+	/** Index buffers of every LOD in the ES3.1 layout */
+	template <typename INDEX_TYPE>
+	void CreateIndexBuffers();
+
+	/** Index ranges of the grid layout, which don't depend on the index data so are known before any LOD is built */
+	void InitGridIndexRanges();
+
+	template <typename INDEX_TYPE>
+	void BuildGridIndices(int32 Mip, TArray<INDEX_TYPE>& OutIndices) const;
+
+	template <typename INDEX_TYPE>
+	void CreateLODIndexBuffers(int32 MinLOD, int32 MaxLOD, bool bRequiresAdjacencyInformation);
+
 #if WITH_EDITOR
 	template <typename INDEX_TYPE>
 	void CreateGrassIndexBuffer();
 #endif
 
-	virtual ~FCyLandSharedBuffers();
+	/** Index buffers of the ES3.1 layout are vertex cache optimized over all LODs at once, so they can't be built per LOD */
+	bool bSupportsLODRequests;
 };
 
 //
@@ -394,8 +459,10 @@ protected:
 	int8					LODBias;
 	bool					bRegistered;
 	int32					PrimitiveCustomDataIndex;
+	int32					LODSolverSlot;
 
 	friend class FCyLandComponentSceneProxy;
+	friend class FCyLandLODSolver;
 
 public:
 	FCyLandNeighborInfo(const UWorld* InWorld, const FGuid& InGuid, const FIntPoint& InComponentBase, UTexture2D* InHeightmapTexture, int8 InForcedLOD, int8 InLODBias)
@@ -406,6 +473,7 @@ public:
 	, LODBias(InLODBias)
 	, bRegistered(false)
 	, PrimitiveCustomDataIndex(INDEX_NONE)
+	, LODSolverSlot(INDEX_NONE)
 	{
 		//       -Y       
 		//    - - 0 - -   
@@ -447,6 +515,7 @@ public:
 class FCyLandComponentSceneProxy : public FPrimitiveSceneProxy, public FCyLandNeighborInfo
 {
 	friend class FCyLandSharedBuffers;
+	friend class FCyLandLODSolver;
 
 	SIZE_T GetTypeHash() const override;
 	class FCyLandLCI final : public FLightCacheInterface
@@ -585,6 +654,8 @@ protected:
 
 	UTexture2D* XYOffsetmapTexture;
 
+	// Reference counted vertex and index buffer shared among all landscape scene proxies of the same component size,
+	// found in and released to FCyLandSharedBuffersPool. Key is the component size and number of subsections.
 	uint32						SharedBuffersKey;
 	FCyLandSharedBuffers*	SharedBuffers;
 	FCyLandVertexFactory*	VertexFactory;
@@ -610,9 +681,9 @@ protected:
 	/** Material Relevance for each material in AvailableMaterials */
 	TArray<FMaterialRelevance> MaterialRelevances;
 
-	// Reference counted vertex and index buffer shared among all landscape scene proxies of the same component size
-	// Key is the component size and number of subsections.
-	static TMap<uint32, FCyLandSharedBuffers*> SharedBuffersMap;
+
+	/** Solver of the per view LODs of all the components of this landscape, slot is LODSolverSlot */
+	FCyLandLODSolver* LODSolver;
 
 #if WITH_EDITORONLY_DATA
 	FCyLandEditToolRenderData EditToolRenderData;
@@ -648,7 +719,7 @@ protected:
 	bool CanUseMeshBatchForShadowCascade(int8 InLODIndex, float InShadowMapTextureResolution, float InShadowMapCascadeSize) const;
 	FORCEINLINE int32 ConvertBatchElementLODToBatchElementIndex(int8 InBatchElementLOD, bool InUseCombinedMeshBatch);
 	float GetNeighborLOD(const FSceneView& InView, float InBatchElementCurrentLOD, int8 InNeighborIndex, int8 InSubSectionX, int8 InSubSectionY, int8 InCurrentSubSectionIndex) const;
-	void CalculateBatchElementLOD(const FSceneView& InView, float InMeshScreenSizeSquared, float InViewLODScale, FViewCustomDataLOD& InOutLODData, bool InForceCombined) const;
+	void CalculateBatchElementLOD(const FSceneView& InView, float InMeshScreenSizeSquared, float InViewLODScale, FViewCustomDataLOD& InOutLODData, bool InForceCombined, const FCyLandComponentLOD* InSolvedLOD = nullptr) const;
 	void CalculateLODFromScreenSize(const FSceneView& InView, float InMeshScreenSizeSquared, float InViewLODScale, int32 InSubSectionIndex, FViewCustomDataLOD& InOutLODData) const;
 	FORCEINLINE void ComputeStaticBatchIndexToRender(FViewCustomDataLOD& OutLODData, int32 InSubSectionIndex);
 	int8 GetLODFromScreenSize(float InScreenSizeSquared, float InViewLODScale) const;
@@ -697,7 +768,7 @@ public:
 	// FCyLandComponentSceneProxy interface.
 	uint64 GetStaticBatchElementVisibility(const FSceneView& InView, const FMeshBatch* InBatch, const void* InViewCustomData) const;
 #if WITH_EDITOR
-	const FMeshBatch& GetGrassMeshBatch() const { return GrassMeshBatch; }
+	const FMeshBatch& GetGrassMeshBatch() const;
 #endif
 
 	// FLandcapeSceneProxy
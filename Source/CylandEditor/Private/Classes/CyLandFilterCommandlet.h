@@ -0,0 +1,30 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "Commandlets/Commandlet.h"
+#include "CyLandFilterGraph.h"
+#include "CyLandFilterCommandlet.generated.h"
+
+/**
+ * Runs a filter graph as a content build step, without the editor tools or a viewport.
+ * Stages are given as for CyLand.Filter, either on a raw 16 bit heightmap or on every CyLand of a map:
+ *
+ * -run=CyLandFilter -Filters="Smooth Radius=4 | Thermal Iterations=28" -Raw=In.r16 -Out=Out.r16 -SizeX=1009 -SizeY=1009 [-TileSize=128]
+ * -run=CyLandFilter -Filters="Smooth Radius=4 | Thermal Iterations=28" -Map=/Game/Maps/World [-ComponentsPerTile=2]
+ */
+UCLASS()
+class UCyLandFilterCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+private:
+	int32 FilterRaw(const FCyLandFilterGraph& Graph, const FString& Params);
+	int32 FilterMap(const FCyLandFilterGraph& Graph, const FString& Params);
+};
@@ -704,6 +704,9 @@ void FEdModeCyLand::Exit()
 	CyLandList.Empty();
 	CyLandTargetList.Empty();
 
+	// Free the FFT plans and buffers kept by detail smoothing
+	CyLandLowPassFilter::EmptyCache();
+
 	// Save UI settings to config file
 	UISettings->Save();
 	GCyLandViewMode = ECyLandViewMode::Normal;
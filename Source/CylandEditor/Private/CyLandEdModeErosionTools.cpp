@@ -7,6 +7,7 @@
 #include "CyLandEditorObject.h"
 #include "CyLandEdModeTools.h"
 #include "CyLand.h"
+#include "CyLandErosion.h"
 #include "Logging/TokenizedMessage.h"
 #include "Logging/MessageLog.h"
 #include "Misc/MapErrors.h"
@@ -86,10 +87,9 @@ public:
 		X2 += 1;
 		Y2 += 1;
 
-		const int32 NeighborNum = 4;
-		const int32 Iteration = UISettings->ErodeIterationNum;
-		const int32 Thickness = UISettings->ErodeSurfaceThickness;
 		const int32 LayerNum = CyLandInfo->Layers.Num();
+		const int32 SizeX = 1 + X2 - X1;
+		const int32 SizeY = 1 + Y2 - Y1;
 
 		HeightCache.CacheData(X1, Y1, X2, Y2);
 		TArray<uint16> HeightData;
@@ -99,137 +99,67 @@ public:
 		WeightCache.CacheData(X1, Y1, X2, Y2);
 		WeightCache.GetCachedData(X1, Y1, X2, Y2, WeightDatas, LayerNum);
 
-		// Apply the brush	
+		// Apply the brush, the vertices around the brush bounds have a mask of 0 so they only receive material
 		uint16 Thresh = UISettings->ErodeThresh;
-		int32 WeightMoveThresh = FMath::Min<int32>(FMath::Max<int32>(Thickness >> 2, Thresh), Thickness >> 1);
 
-		TArray<float> CenterWeights;
-		CenterWeights.Empty(LayerNum);
-		CenterWeights.AddUninitialized(LayerNum);
-		TArray<float> NeighborWeight;
-		NeighborWeight.Empty(NeighborNum*LayerNum);
-		NeighborWeight.AddUninitialized(NeighborNum*LayerNum);
+		FCyLandErosion Erosion(SizeX, SizeY);
+		Erosion.SetHeights(HeightData.GetData(), SizeX);
+		Erosion.Mask.SetNumZeroed(SizeX * SizeY);
+		Erosion.Softness.Init(1.0f, SizeX * SizeY);
 
-		bool bHasChanged = false;
-		for (int32 i = 0; i < Iteration; i++)
+		for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
 		{
-			bHasChanged = false;
-			for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
+			const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
+
+			for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
 			{
-				const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
+				const int32 Center = (X - X1) + (Y - Y1) * SizeX;
+				Erosion.Mask[Center] = BrushScanline[X];
 
-				for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
+				for (int32 Idx = 0; Idx < LayerNum; Idx++)
 				{
-					const float BrushValue = BrushScanline[X];
-
-					if (BrushValue > 0.0f)
+					UCyLandLayerInfoObject* LayerInfo = CyLandInfo->Layers[Idx].LayerInfoObj;
+					if (LayerInfo)
 					{
-						int32 Center = (X - X1) + (Y - Y1)*(1 + X2 - X1);
-						int32 Neighbor[NeighborNum] = {
-							(X - 1 - X1) + (Y - Y1)*(1 + X2 - X1),   // -X
-							(X + 1 - X1) + (Y - Y1)*(1 + X2 - X1),   // +X
-							(X - X1) + (Y - 1 - Y1)*(1 + X2 - X1),   // -Y
-							(X - X1) + (Y + 1 - Y1)*(1 + X2 - X1) }; // +Y
-						uint32 SlopeTotal = 0;
-						uint16 SlopeMax = Thresh;
-
-						for (int32 Idx = 0; Idx < NeighborNum; Idx++)
-						{
-							if (HeightData[Center] > HeightData[Neighbor[Idx]])
-							{
-								uint16 Slope = HeightData[Center] - HeightData[Neighbor[Idx]];
-								if (Slope * BrushValue > Thresh)
-								{
-									SlopeTotal += Slope;
-									if (SlopeMax < Slope)
-									{
-										SlopeMax = Slope;
-									}
-								}
-							}
-						}
-
-						if (SlopeTotal > 0)
-						{
-							float Softness = 1.0f;
-							{
-								for (int32 Idx = 0; Idx < LayerNum; Idx++)
-								{
-									UCyLandLayerInfoObject* LayerInfo = CyLandInfo->Layers[Idx].LayerInfoObj;
-									if (LayerInfo)
-									{
-										uint8 Weight = WeightDatas[Center*LayerNum + Idx];
-										Softness -= (float)(Weight) / 255.0f * LayerInfo->Hardness;
-									}
-								}
-							}
-							if (Softness > 0.0f)
-							{
-								//Softness = FMath::Clamp<float>(Softness, 0.0f, 1.0f);
-								float TotalHeightDiff = 0;
-								int32 WeightTransfer = FMath::Min<int32>(WeightMoveThresh, SlopeMax - Thresh);
-								for (int32 Idx = 0; Idx < NeighborNum; Idx++)
-								{
-									float TotalWeight = 0.0f;
-									if (HeightData[Center] > HeightData[Neighbor[Idx]])
-									{
-										uint16 Slope = HeightData[Center] - HeightData[Neighbor[Idx]];
-										if (Slope > Thresh)
-										{
-											float WeightDiff = Softness * UISettings->ToolStrength * Pressure * ((float)Slope / SlopeTotal) * BrushValue;
-											//uint16 HeightDiff = (uint16)((SlopeMax - Thresh) * WeightDiff);
-											float HeightDiff = (SlopeMax - Thresh) * WeightDiff;
-											HeightData[Neighbor[Idx]] += HeightDiff;
-											TotalHeightDiff += HeightDiff;
-
-											if (bWeightApplied)
-											{
-												for (int32 LayerIdx = 0; LayerIdx < LayerNum; LayerIdx++)
-												{
-													float CenterWeight = (float)(WeightDatas[Center*LayerNum + LayerIdx]) / 255.0f;
-													float Weight = (float)(WeightDatas[Neighbor[Idx] * LayerNum + LayerIdx]) / 255.0f;
-													NeighborWeight[Idx*LayerNum + LayerIdx] = Weight*(float)Thickness + CenterWeight*WeightDiff*WeightTransfer; // transferred + original...
-													TotalWeight += NeighborWeight[Idx*LayerNum + LayerIdx];
-												}
-												// Need to normalize weight...
-												for (int32 LayerIdx = 0; LayerIdx < LayerNum; LayerIdx++)
-												{
-													WeightDatas[Neighbor[Idx] * LayerNum + LayerIdx] = (uint8)(255.0f * NeighborWeight[Idx*LayerNum + LayerIdx] / TotalWeight);
-												}
-											}
-										}
-									}
-								}
-
-								HeightData[Center] -= TotalHeightDiff;
-
-								if (bWeightApplied)
-								{
-									float TotalWeight = 0.0f;
-									float WeightDiff = Softness * UISettings->ToolStrength * Pressure * BrushValue;
-
-									for (int32 LayerIdx = 0; LayerIdx < LayerNum; LayerIdx++)
-									{
-										float Weight = (float)(WeightDatas[Center*LayerNum + LayerIdx]) / 255.0f;
-										CenterWeights[LayerIdx] = Weight*Thickness - Weight*WeightDiff*WeightTransfer;
-										TotalWeight += CenterWeights[LayerIdx];
-									}
-									// Need to normalize weight...
-									for (int32 LayerIdx = 0; LayerIdx < LayerNum; LayerIdx++)
-									{
-										WeightDatas[Center*LayerNum + LayerIdx] = (uint8)(255.0f * CenterWeights[LayerIdx] / TotalWeight);
-									}
-								}
-
-								bHasChanged = true;
-							} // if Softness > 0.0f
-						} // if SlopeTotal > 0
+						uint8 Weight = WeightDatas[Center*LayerNum + Idx];
+						Erosion.Softness[Center] -= (float)(Weight) / 255.0f * LayerInfo->Hardness;
 					}
 				}
 			}
-			if (!bHasChanged)
+		}
+
+		// The paint layers slide down with the material
+		if (bWeightApplied)
+		{
+			Erosion.LayerWeights.SetNum(LayerNum);
+			for (int32 Idx = 0; Idx < LayerNum; Idx++)
+			{
+				TArray<float>& LayerWeights = Erosion.LayerWeights[Idx];
+				LayerWeights.SetNumUninitialized(SizeX * SizeY);
+				for (int32 Index = 0; Index < SizeX * SizeY; Index++)
+				{
+					LayerWeights[Index] = (float)WeightDatas[Index*LayerNum + Idx] / 255.0f;
+				}
+			}
+		}
+
+		FCyLandThermalErosionSettings ErosionSettings;
+		ErosionSettings.Iterations = UISettings->ErodeIterationNum;
+		ErosionSettings.Threshold = Thresh;
+		ErosionSettings.Strength = UISettings->ToolStrength * Pressure;
+		ErosionSettings.SurfaceThickness = UISettings->ErodeSurfaceThickness;
+		Erosion.RunThermal(ErosionSettings);
+		Erosion.GetHeights(HeightData.GetData(), SizeX);
+
+		if (bWeightApplied)
+		{
+			for (int32 Idx = 0; Idx < LayerNum; Idx++)
 			{
-				break;
+				const TArray<float>& LayerWeights = Erosion.LayerWeights[Idx];
+				for (int32 Index = 0; Index < SizeX * SizeY; Index++)
+				{
+					WeightDatas[Index*LayerNum + Idx] = (uint8)FMath::Clamp<int32>(FMath::RoundToInt(LayerWeights[Index] * 255.0f), 0, 255);
+				}
 			}
 		}
 
@@ -240,9 +170,15 @@ public:
 		}
 
 		// Make some noise...
+		// The amount changes with the brush, so the noise is sampled once per row at amount 1 and scaled per vertex
+		const FCyLandNoise Noise(UISettings->ErosionNoiseScale, 1.0f);
+		TArray<float> NoiseData;
+		NoiseData.SetNumUninitialized(BrushInfo.GetBounds().Width());
 		for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
 		{
 			const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
+			Noise.SampleRowMirrored(BrushInfo.GetBounds().Min.X, Y, NoiseData.Num(), NoiseData.GetData());
+			const float* NoiseScanline = NoiseData.GetData() - BrushInfo.GetBounds().Min.X;
 
 			for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
 			{
@@ -250,8 +186,8 @@ public:
 
 				if (BrushValue > 0.0f)
 				{
-					FNoiseParameter NoiseParam(0, UISettings->ErosionNoiseScale, BrushValue * Thresh * UISettings->ToolStrength * BrushSizeAdjust);
-					float PaintAmount = NoiseModeConversion((ECyLandToolNoiseMode)UISettings->ErosionNoiseMode, NoiseParam.NoiseAmount, NoiseParam.Sample(X, Y));
+					const float NoiseAmount = BrushValue * Thresh * UISettings->ToolStrength * BrushSizeAdjust;
+					float PaintAmount = NoiseModeConversion((ECyLandToolNoiseMode)UISettings->ErosionNoiseMode, NoiseAmount, NoiseScanline[X] * NoiseAmount);
 					HeightData[(X - X1) + (Y - Y1)*(1 + X2 - X1)] = FCyLandHeightCache::ClampValue(HeightData[(X - X1) + (Y - Y1)*(1 + X2 - X1)] + PaintAmount);
 				}
 			}
@@ -326,161 +262,53 @@ public:
 		X2 += 1;
 		Y2 += 1;
 
-		const int32 LayerNum = CyLandInfo->Layers.Num();
+		const int32 SizeX = 1 + X2 - X1;
+		const int32 SizeY = 1 + Y2 - Y1;
 
-		const int32 Iteration = UISettings->HErodeIterationNum;
 		const uint16 RainAmount = UISettings->RainAmount;
-		const float DissolvingRatio = 0.07 * UISettings->ToolStrength * Pressure;  //0.01;
-		const float EvaporateRatio = 0.5;
-		const float SedimentCapacity = 0.10 * UISettings->SedimentCapacity; //DissolvingRatio; //0.01;
 
 		HeightCache.CacheData(X1, Y1, X2, Y2);
 		TArray<uint16> HeightData;
 		HeightCache.GetCachedData(X1, Y1, X2, Y2, HeightData);
 
-		// Apply the brush
-		TArray<uint16> WaterData;
-		WaterData.Empty((1 + X2 - X1)*(1 + Y2 - Y1));
-		WaterData.AddZeroed((1 + X2 - X1)*(1 + Y2 - Y1));
-		TArray<uint16> SedimentData;
-		SedimentData.Empty((1 + X2 - X1)*(1 + Y2 - Y1));
-		SedimentData.AddZeroed((1 + X2 - X1)*(1 + Y2 - Y1));
+		// Apply the brush, the vertices around the brush bounds have a mask of 0 so they only receive water and sediment
+		FCyLandErosion Erosion(SizeX, SizeY);
+		Erosion.SetHeights(HeightData.GetData(), SizeX);
+		Erosion.Mask.SetNumZeroed(SizeX * SizeY);
+		Erosion.Water.SetNumZeroed(SizeX * SizeY);
 
 		// Only initial raining works better...
-		FNoiseParameter NoiseParam(0, UISettings->RainDistScale, RainAmount);
+		const FCyLandNoise RainNoise(UISettings->RainDistScale, RainAmount);
+		TArray<float> RainData;
+		RainData.SetNumUninitialized(BrushInfo.GetBounds().Width());
 		for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
 		{
 			const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
-			auto* WaterDataScanline = WaterData.GetData() + (Y - Y1) * (X2 - X1 + 1) + (0 - X1);
+			RainNoise.SampleRowMirrored(BrushInfo.GetBounds().Min.X, Y, RainData.Num(), RainData.GetData());
+			const float* RainScanline = RainData.GetData() - BrushInfo.GetBounds().Min.X;
+			float* MaskScanline = Erosion.Mask.GetData() + (Y - Y1) * SizeX + (0 - X1);
+			float* WaterScanline = Erosion.Water.GetData() + (Y - Y1) * SizeX + (0 - X1);
 
 			for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
 			{
 				const float BrushValue = BrushScanline[X];
+				MaskScanline[X] = BrushValue;
 
 				if (BrushValue >= 1.0f)
 				{
-					float PaintAmount = NoiseModeConversion((ECyLandToolNoiseMode)UISettings->RainDistMode, NoiseParam.NoiseAmount, NoiseParam.Sample(X, Y));
+					float PaintAmount = NoiseModeConversion((ECyLandToolNoiseMode)UISettings->RainDistMode, RainAmount, RainScanline[X]);
 					if (PaintAmount > 0) // Raining only for positive region...
-						WaterDataScanline[X] += PaintAmount;
+						WaterScanline[X] += PaintAmount;
 				}
 			}
 		}
 
-		for (int32 i = 0; i < Iteration; i++)
-		{
-			bool bWaterExist = false;
-			for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
-			{
-				const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
-
-				for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
-				{
-					const float BrushValue = BrushScanline[X];
-
-					if (BrushValue > 0.0f)
-					{
-						int32 Center = (X - X1) + (Y - Y1)*(1 + X2 - X1);
-
-						const int32 NeighborNum = 8;
-						int32 Neighbor[NeighborNum] = {
-							(X - 1 - X1) + (Y - Y1)*(1 + X2 - X1),   // -X
-							(X + 1 - X1) + (Y - Y1)*(1 + X2 - X1),   // +X
-							(X - X1) + (Y - 1 - Y1)*(1 + X2 - X1),   // -Y
-							(X - X1) + (Y + 1 - Y1)*(1 + X2 - X1),   // +Y
-							(X - 1 - X1) + (Y - 1 - Y1)*(1 + X2 - X1),   // -X -Y
-							(X + 1 - X1) + (Y + 1 - Y1)*(1 + X2 - X1),   // +X +Y
-							(X + 1 - X1) + (Y - 1 - Y1)*(1 + X2 - X1),   // +X -Y
-							(X - 1 - X1) + (Y + 1 - Y1)*(1 + X2 - X1) }; // -X +Y
-
-						// Dissolving...
-						float DissolvedAmount = DissolvingRatio * WaterData[Center] * BrushValue;
-						if (DissolvedAmount > 0 && HeightData[Center] >= DissolvedAmount)
-						{
-							HeightData[Center] -= DissolvedAmount;
-							SedimentData[Center] += DissolvedAmount;
-						}
-
-						uint32 TotalHeightDiff = 0;
-						uint32 TotalAltitudeDiff = 0;
-						uint32 AltitudeDiff[NeighborNum] = { 0 };
-						uint32 TotalWaterDiff = 0;
-						uint32 TotalSedimentDiff = 0;
-
-						uint32 Altitude = HeightData[Center] + WaterData[Center];
-						float AverageAltitude = 0;
-						uint32 LowerNeighbor = 0;
-						for (int32 Idx = 0; Idx < NeighborNum; Idx++)
-						{
-							uint32 NeighborAltitude = HeightData[Neighbor[Idx]] + WaterData[Neighbor[Idx]];
-							if (Altitude > NeighborAltitude)
-							{
-								AltitudeDiff[Idx] = Altitude - NeighborAltitude;
-								TotalAltitudeDiff += AltitudeDiff[Idx];
-								LowerNeighbor++;
-								AverageAltitude += NeighborAltitude;
-								if (HeightData[Center] > HeightData[Neighbor[Idx]])
-								{
-									TotalHeightDiff += HeightData[Center] - HeightData[Neighbor[Idx]];
-								}
-							}
-							else
-							{
-								AltitudeDiff[Idx] = 0;
-							}
-						}
-
-						// Water Transfer
-						if (LowerNeighbor > 0)
-						{
-							AverageAltitude /= (LowerNeighbor);
-							// This is not mathematically correct, but makes good result
-							if (TotalHeightDiff)
-							{
-								AverageAltitude *= (1.0f - 0.1 * UISettings->ToolStrength * Pressure);
-								//AverageAltitude -= 4000.0f * UISettings->ToolStrength;
-							}
-
-							uint32 WaterTransfer = FMath::Min<uint32>(WaterData[Center], Altitude - (uint32)AverageAltitude) * BrushValue;
-
-							for (int32 Idx = 0; Idx < NeighborNum; Idx++)
-							{
-								if (AltitudeDiff[Idx] > 0)
-								{
-									uint32 WaterDiff = (uint32)(WaterTransfer * (float)AltitudeDiff[Idx] / TotalAltitudeDiff);
-									WaterData[Neighbor[Idx]] += WaterDiff;
-									TotalWaterDiff += WaterDiff;
-									uint32 SedimentDiff = (uint32)(SedimentData[Center] * (float)WaterDiff / WaterData[Center]);
-									SedimentData[Neighbor[Idx]] += SedimentDiff;
-									TotalSedimentDiff += SedimentDiff;
-								}
-							}
-
-							WaterData[Center] -= TotalWaterDiff;
-							SedimentData[Center] -= TotalSedimentDiff;
-						}
-
-						// evaporation
-						if (WaterData[Center] > 0)
-						{
-							bWaterExist = true;
-							WaterData[Center] = (uint16)(WaterData[Center] * (1.0f - EvaporateRatio));
-							float SedimentCap = SedimentCapacity*WaterData[Center];
-							float SedimentDiff = SedimentData[Center] - SedimentCap;
-							if (SedimentDiff > 0)
-							{
-								SedimentData[Center] -= SedimentDiff;
-								HeightData[Center] = FMath::Clamp<uint16>(HeightData[Center] + SedimentDiff, 0, 65535);
-							}
-						}
-					}
-				}
-			}
-
-			if (!bWaterExist)
-			{
-				break;
-			}
-		}
+		FCyLandHydraulicErosionSettings ErosionSettings;
+		ErosionSettings.Iterations = UISettings->HErodeIterationNum;
+		ErosionSettings.Strength = UISettings->ToolStrength * Pressure;
+		ErosionSettings.SedimentCapacity = UISettings->SedimentCapacity;
+		Erosion.RunHydraulic(ErosionSettings);
+		Erosion.GetHeights(HeightData.GetData(), SizeX);
 
 		if (UISettings->bHErosionDetailSmooth)
 		{
@@ -13,6 +13,7 @@
 #include "CyLandEdit.h"
 #include "CyLandDataAccess.h"
 #include "CyLandEdModeTools.h"
+#include "CyLandSmoothFilter.h"
 #include "Settings/EditorExperimentalSettings.h"
 #include "CyLand.h"
 #include "Logging/TokenizedMessage.h"
@@ -21,23 +22,6 @@
 
 #define LOCTEXT_NAMESPACE "CyLandTools"
 
-const int32 FNoiseParameter::Permutations[256] =
-{
-	151, 160, 137, 91, 90, 15,
-	131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
-	190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
-	88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
-	77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
-	102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
-	135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
-	5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
-	223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
-	129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
-	251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
-	49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
-	138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
-};
-
 
 
 // 
@@ -633,59 +617,10 @@ public:
 		}
 		else
 		{
-			const int32 FilterRadius = UISettings->SmoothFilterKernelSize;
-
-			for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
-			{
-				const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
-				auto* DataScanline = Data.GetData() + (Y - Y1) * (X2 - X1 + 1) + (0 - X1);
-
-				for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
-				{
-					const float BrushValue = BrushScanline[X];
-
-					if (BrushValue > 0.0f)
-					{
-						// needs to be ~12 bits larger than ToolTarget::CacheClass::DataType (for max FilterRadius (31))
-						// the editor is 64-bit native so just go the whole hog :)
-						int64 FilterValue = 0;
-						int32 FilterSamplingNumber = 0;
-
-						const int32 XRadius = FMath::Min3<int32>(FilterRadius, X - BrushInfo.GetBounds().Min.X, BrushInfo.GetBounds().Max.X - X - 1);
-						const int32 YRadius = FMath::Min3<int32>(FilterRadius, Y - BrushInfo.GetBounds().Min.Y, BrushInfo.GetBounds().Max.Y - Y - 1);
-
-						const int32 SampleX1 = X - XRadius; checkSlow(SampleX1 >= BrushInfo.GetBounds().Min.X);
-						const int32 SampleY1 = Y - YRadius; checkSlow(SampleY1 >= BrushInfo.GetBounds().Min.Y);
-						const int32 SampleX2 = X + XRadius; checkSlow(SampleX2 <  BrushInfo.GetBounds().Max.X);
-						const int32 SampleY2 = Y + YRadius; checkSlow(SampleY2 <  BrushInfo.GetBounds().Max.Y);
-						for (int32 SampleY = SampleY1; SampleY <= SampleY2; SampleY++)
-						{
-							const float* SampleBrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, SampleY));
-							const float* SampleBrushScanline2 = BrushInfo.GetDataPtr(FIntPoint(0, Y + (Y - SampleY)));
-							auto* SampleDataScanline = Data.GetData() + (SampleY - Y1) * (X2 - X1 + 1) + (0 - X1);
-
-							for (int32 SampleX = SampleX1; SampleX <= SampleX2; SampleX++)
-							{
-								// constrain sample to within the brush, symmetrically to prevent flattening bug
-								const float SampleBrushValue =
-									FMath::Min(
-										FMath::Min<float>(SampleBrushScanline [SampleX], SampleBrushScanline [X + (X - SampleX)]),
-										FMath::Min<float>(SampleBrushScanline2[SampleX], SampleBrushScanline2[X + (X - SampleX)])
-										);
-								if (SampleBrushValue > 0.0f)
-								{
-									FilterValue += SampleDataScanline[SampleX];
-									FilterSamplingNumber++;
-								}
-							}
-						}
-
-						FilterValue /= FilterSamplingNumber;
-
-						DataScanline[X] = FMath::Lerp(DataScanline[X], (typename ToolTarget::CacheClass::DataType)FilterValue, BrushValue * ToolStrength);
-					}
-				}
-			}
+			// Summed-area tables, the cost per vertex doesn't depend on the filter radius
+			const FIntRect BrushBounds = BrushInfo.GetBounds();
+			auto* BrushedData = Data.GetData() + (BrushBounds.Min.Y - Y1) * (X2 - X1 + 1) + (BrushBounds.Min.X - X1);
+			CyLandSmoothFilter::Apply(BrushInfo.GetDataPtr(BrushBounds.Min), BrushedData, X2 - X1 + 1, BrushBounds.Width(), BrushBounds.Height(), UISettings->SmoothFilterKernelSize, ToolStrength);
 		}
 
 		ACyLand* CyLand = this->CyLandInfo->CyLandActor.Get();
@@ -1092,11 +1027,18 @@ public:
 		CA_SUPPRESS(6326);
 		bool bUseWeightTargetValue = UISettings->bUseWeightTargetValue && ToolTarget::TargetType == ECyLandToolTargetType::Weightmap;
 
+		// Unit noise of a whole brush row at a time, scaled per vertex below
+		const FCyLandNoise Noise(UISettings->NoiseScale, 1.0f);
+		TArray<float> NoiseData;
+		NoiseData.SetNumUninitialized(BrushInfo.GetBounds().Width());
+
 		// Apply the brush
 		for (int32 Y = BrushInfo.GetBounds().Min.Y; Y < BrushInfo.GetBounds().Max.Y; Y++)
 		{
 			const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
 			auto* DataScanline = Data.GetData() + (Y - Y1) * (X2 - X1 + 1) + (0 - X1);
+			const float* NoiseScanline = NoiseData.GetData() + (0 - BrushInfo.GetBounds().Min.X);
+			Noise.SampleRowMirrored(BrushInfo.GetBounds().Min.X, Y, NoiseData.Num(), NoiseData.GetData());
 
 			for (int32 X = BrushInfo.GetBounds().Min.X; X < BrushInfo.GetBounds().Max.X; X++)
 			{
@@ -1107,8 +1049,8 @@ public:
 					float OriginalValue = DataScanline[X];
 					if (bUseWeightTargetValue)
 					{
-						FNoiseParameter NoiseParam(0, UISettings->NoiseScale, 255.0f / 2.0f);
-						float DestValue = NoiseModeConversion(ECyLandToolNoiseMode::Add, NoiseParam.NoiseAmount, NoiseParam.Sample(X, Y)) * UISettings->WeightTargetValue;
+						const float NoiseAmount = 255.0f / 2.0f;
+						float DestValue = NoiseModeConversion(ECyLandToolNoiseMode::Add, NoiseAmount, NoiseScanline[X] * NoiseAmount) * UISettings->WeightTargetValue;
 						switch (UISettings->NoiseMode)
 						{
 						case ECyLandToolNoiseMode::Add:
@@ -1118,7 +1060,7 @@ public:
 							}
 							break;
 						case ECyLandToolNoiseMode::Sub:
-							DestValue += (1.0f - UISettings->WeightTargetValue) * NoiseParam.NoiseAmount;
+							DestValue += (1.0f - UISettings->WeightTargetValue) * NoiseAmount;
 							if (OriginalValue <= DestValue)
 							{
 								continue;
@@ -1130,8 +1072,8 @@ public:
 					else
 					{
 						float TotalStrength = BrushValue * UISettings->ToolStrength * Pressure * ToolTarget::StrengthMultiplier(this->CyLandInfo, UISettings->BrushRadius);
-						FNoiseParameter NoiseParam(0, UISettings->NoiseScale, TotalStrength * BrushSizeAdjust);
-						float PaintAmount = NoiseModeConversion(UISettings->NoiseMode, NoiseParam.NoiseAmount, NoiseParam.Sample(X, Y));
+						const float NoiseAmount = TotalStrength * BrushSizeAdjust;
+						float PaintAmount = NoiseModeConversion(UISettings->NoiseMode, NoiseAmount, NoiseScanline[X] * NoiseAmount);
 						DataScanline[X] = ToolTarget::CacheClass::ClampValue(OriginalValue + PaintAmount);
 					}
 				}
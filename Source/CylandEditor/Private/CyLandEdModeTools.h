@@ -12,6 +12,8 @@
 #include "CyLandComponent.h"
 #include "CyLandDataAccess.h"
 #include "CyLandHeightfieldCollisionComponent.h"
+#include "CyLandLowPassFilter.h"
+#include "CyLandNoise.h"
 #include "InstancedFoliageActor.h"
 #include "VREditorInteractor.h"
 #include "AI/NavigationSystemBase.h"
@@ -19,7 +21,7 @@
 // VR Editor
 
 //
-//	FNoiseParameter - Perlin noise
+//	FNoiseParameter - Perlin noise, see FCyLandNoise to sample many vertices at once
 //
 struct FNoiseParameter
 {
@@ -92,8 +94,6 @@ struct FNoiseParameter
 	bool TestLess(int32 X, int32 Y, float TestValue) const { return !TestGreater(X, Y, TestValue); }
 
 private:
-	static const int32 Permutations[256];
-
 	bool operator==(const FNoiseParameter& SrcNoise)
 	{
 		if ((Base == SrcNoise.Base) &&
@@ -114,56 +114,17 @@ private:
 	}
 
 
-	float Fade(float T) const
-	{
-		return T * T * T * (T * (T * 6 - 15) + 10);
-	}
-
-
-	float Grad(int32 Hash, float X, float Y) const
-	{
-		int32		H = Hash & 15;
-		float	U = H < 8 || H == 12 || H == 13 ? X : Y,
-			V = H < 4 || H == 12 || H == 13 ? Y : 0;
-		return ((H & 1) == 0 ? U : -U) + ((H & 2) == 0 ? V : -V);
-	}
-
 	float PerlinNoise2D(float X, float Y) const
 	{
-		int32		TruncX = FMath::TruncToInt(X),
-			TruncY = FMath::TruncToInt(Y),
-			IntX = TruncX & 255,
-			IntY = TruncY & 255;
-		float	FracX = X - TruncX,
-			FracY = Y - TruncY;
-
-		float	U = Fade(FracX),
-			V = Fade(FracY);
-
-		int32	A = Permutations[IntX] + IntY,
-			AA = Permutations[A & 255],
-			AB = Permutations[(A + 1) & 255],
-			B = Permutations[(IntX + 1) & 255] + IntY,
-			BA = Permutations[B & 255],
-			BB = Permutations[(B + 1) & 255];
-
-		return	FMath::Lerp(FMath::Lerp(Grad(Permutations[AA], FracX, FracY),
-			Grad(Permutations[BA], FracX - 1, FracY), U),
-			FMath::Lerp(Grad(Permutations[AB], FracX, FracY - 1),
-			Grad(Permutations[BB], FracX - 1, FracY - 1), U), V);
+		return FCyLandNoise::PerlinNoise2D(X, Y);
 	}
 };
 
 
 
-#if WITH_KISSFFT
-#include "tools/kiss_fftnd.h"
-#endif
-
 template<typename DataType>
 inline void LowPassFilter(int32 X1, int32 Y1, int32 X2, int32 Y2, FCyLandBrushData& BrushInfo, TArray<DataType>& Data, const float DetailScale, const float ApplyRatio = 1.0f)
 {
-#if WITH_KISSFFT
 	// Low-pass filter
 	int32 FFTWidth = X2 - X1 - 1;
 	int32 FFTHeight = Y2 - Y1 - 1;
@@ -174,105 +135,201 @@ inline void LowPassFilter(int32 X1, int32 Y1, int32 X2, int32 Y2, FCyLandBrushDa
 		return;
 	}
 
-	const int32 NDims = 2;
-	const int32 Dims[NDims] = { FFTHeight, FFTWidth };
-	kiss_fftnd_cfg stf = kiss_fftnd_alloc(Dims, NDims, 0, NULL, NULL),
-		sti = kiss_fftnd_alloc(Dims, NDims, 1, NULL, NULL);
-
-	kiss_fft_cpx *buf = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * Dims[0] * Dims[1]);
-	kiss_fft_cpx *out = (kiss_fft_cpx *)KISS_FFT_MALLOC(sizeof(kiss_fft_cpx) * Dims[0] * Dims[1]);
+	int32 FilteredStride = 0;
+	const float* Filtered = CyLandLowPassFilter::Apply(Data.GetData() + (X2 - X1 + 1) + 1, X2 - X1 + 1, FFTWidth, FFTHeight, DetailScale, FilteredStride);
+	if (!Filtered)
+	{
+		return;
+	}
 
-	for (int32 Y = Y1 + 1; Y <= Y2 - 1; Y++)
+	const int32 BrushX1 = FMath::Max<int32>(BrushInfo.GetBounds().Min.X, X1 + 1);
+	const int32 BrushY1 = FMath::Max<int32>(BrushInfo.GetBounds().Min.Y, Y1 + 1);
+	const int32 BrushX2 = FMath::Min<int32>(BrushInfo.GetBounds().Max.X, X2);
+	const int32 BrushY2 = FMath::Min<int32>(BrushInfo.GetBounds().Max.Y, Y2);
+	for (int32 Y = BrushY1; Y < BrushY2; Y++)
 	{
+		const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
 		auto* DataScanline = Data.GetData() + (Y - Y1) * (X2 - X1 + 1) + (0 - X1);
-		auto* bufScanline = buf + (Y - (Y1 + 1)) * Dims[1] + (0 - (X1 + 1));
+		const float* FilteredScanline = Filtered + (Y - (Y1 + 1)) * FilteredStride + (0 - (X1 + 1));
 
-		for (int32 X = X1 + 1; X <= X2 - 1; X++)
+		for (int32 X = BrushX1; X < BrushX2; X++)
 		{
-			bufScanline[X].r = DataScanline[X];
-			bufScanline[X].i = 0;
+			const float BrushValue = BrushScanline[X];
+
+			if (BrushValue > 0.0f)
+			{
+				DataScanline[X] = FMath::Lerp((float)DataScanline[X], FilteredScanline[X], BrushValue * ApplyRatio);
+			}
 		}
 	}
+}
+
 
-	// Forward FFT
-	kiss_fftnd(stf, buf, out);
 
-	int32 CenterPos[2] = { Dims[0] >> 1, Dims[1] >> 1 };
-	for (int32 Y = 0; Y < Dims[0]; Y++)
+//
+// TCyLandEditTileBuffer
+//
+// Dense 2D storage for samples of a rectangular region of the landscape. The region is aligned to
+// tiles of TileSize vertices and only grows by whole tiles, so extending it a little every brush
+// step does not reallocate. Rows of the whole region are contiguous in memory. Samples that were
+// never stored are tracked so missing data behaves as with a sparse map.
+//
+template<typename DataType>
+struct TCyLandEditTileBuffer
+{
+	enum { TileSize = 64 };
+
+	TCyLandEditTileBuffer()
+		: MinX(0)
+		, MinY(0)
+		, SizeX(0)
+		, SizeY(0)
 	{
-		float DistFromCenter = 0.0f;
-		for (int32 X = 0; X < Dims[1]; X++)
+	}
+
+	bool IsEmpty() const
+	{
+		return SizeX == 0 || SizeY == 0;
+	}
+
+	bool IsInside(int32 X, int32 Y) const
+	{
+		return X >= MinX && Y >= MinY && X < MinX + SizeX && Y < MinY + SizeY;
+	}
+
+	// Grow the buffer so it covers the region, existing samples are kept.
+	// X2/Y2 Coordinates are "inclusive" max values
+	void Reserve(int32 X1, int32 Y1, int32 X2, int32 Y2)
+	{
+		if (!IsEmpty() && IsInside(X1, Y1) && IsInside(X2, Y2))
+		{
+			return;
+		}
+
+		// Tile aligned bounds, max is exclusive. Masking rounds down for negative coordinates too.
+		int32 NewMinX = X1 & ~(TileSize - 1);
+		int32 NewMinY = Y1 & ~(TileSize - 1);
+		int32 NewMaxX = (X2 & ~(TileSize - 1)) + TileSize;
+		int32 NewMaxY = (Y2 & ~(TileSize - 1)) + TileSize;
+		if (!IsEmpty())
 		{
-			if (Y < CenterPos[0])
+			NewMinX = FMath::Min(NewMinX, MinX);
+			NewMinY = FMath::Min(NewMinY, MinY);
+			NewMaxX = FMath::Max(NewMaxX, MinX + SizeX);
+			NewMaxY = FMath::Max(NewMaxY, MinY + SizeY);
+		}
+
+		const int32 NewSizeX = NewMaxX - NewMinX;
+		const int32 NewSizeY = NewMaxY - NewMinY;
+
+		TArray<DataType> NewData;
+		NewData.SetNum(NewSizeX * NewSizeY);
+		TBitArray<> NewValid(false, NewSizeX * NewSizeY);
+
+		for (int32 Y = 0; Y < SizeY; Y++)
+		{
+			const int32 SrcRow = Y * SizeX;
+			const int32 DestRow = (Y + MinY - NewMinY) * NewSizeX + (MinX - NewMinX);
+			for (int32 X = 0; X < SizeX; X++)
 			{
-				if (X < CenterPos[1])
+				if (Valid[SrcRow + X])
 				{
-					// 1
-					DistFromCenter = X*X + Y*Y;
-				}
-				else
-				{
-					// 2
-					DistFromCenter = (X - Dims[1])*(X - Dims[1]) + Y*Y;
+					NewData[DestRow + X] = MoveTemp(Data[SrcRow + X]);
+					NewValid[DestRow + X] = true;
 				}
 			}
-			else
+		}
+
+		Data = MoveTemp(NewData);
+		Valid = MoveTemp(NewValid);
+		MinX = NewMinX;
+		MinY = NewMinY;
+		SizeX = NewSizeX;
+		SizeY = NewSizeY;
+	}
+
+	DataType* Find(int32 X, int32 Y)
+	{
+		if (!IsInside(X, Y))
+		{
+			return nullptr;
+		}
+		const int32 Index = (Y - MinY) * SizeX + (X - MinX);
+		return Valid[Index] ? &Data[Index] : nullptr;
+	}
+
+	const DataType* Find(int32 X, int32 Y) const
+	{
+		return const_cast<TCyLandEditTileBuffer*>(this)->Find(X, Y);
+	}
+
+	template<typename ValueType>
+	void Set(int32 X, int32 Y, ValueType&& Value)
+	{
+		Reserve(X, Y, X, Y);
+		const int32 Index = (Y - MinY) * SizeX + (X - MinX);
+		Data[Index] = Forward<ValueType>(Value);
+		Valid[Index] = true;
+	}
+
+	// Move the valid samples of a region laid out in rows of its width into the buffer.
+	// X2/Y2 Coordinates are "inclusive" max values
+	void SetRegion(int32 X1, int32 Y1, int32 X2, int32 Y2, TArray<DataType>& InData, const TBitArray<>& InValid)
+	{
+		const int32 InSizeX = 1 + X2 - X1;
+		checkSlow(InData.Num() == InSizeX * (1 + Y2 - Y1) && InValid.Num() == InData.Num());
+
+		Reserve(X1, Y1, X2, Y2);
+		for (int32 Y = Y1; Y <= Y2; Y++)
+		{
+			const int32 SrcRow = (Y - Y1) * InSizeX;
+			const int32 DestRow = (Y - MinY) * SizeX + (X1 - MinX);
+			for (int32 X = 0; X < InSizeX; X++)
 			{
-				if (X < CenterPos[1])
+				if (InValid[SrcRow + X])
 				{
-					// 3
-					DistFromCenter = X*X + (Y - Dims[0])*(Y - Dims[0]);
-				}
-				else
-				{
-					// 4
-					DistFromCenter = (X - Dims[1])*(X - Dims[1]) + (Y - Dims[0])*(Y - Dims[0]);
+					Data[DestRow + X] = MoveTemp(InData[SrcRow + X]);
+					Valid[DestRow + X] = true;
 				}
 			}
-			// High frequency removal
-			float Ratio = 1.0f - DetailScale;
-			float Dist = FMath::Min<float>((Dims[0] * Ratio)*(Dims[0] * Ratio), (Dims[1] * Ratio)*(Dims[1] * Ratio));
-			float Filter = 1.0 / (1.0 + DistFromCenter / Dist);
-			CA_SUPPRESS(6385);
-			out[X + Y*Dims[1]].r *= Filter;
-			out[X + Y*Dims[1]].i *= Filter;
 		}
 	}
 
-	// Inverse FFT
-	kiss_fftnd(sti, out, buf);
-
-	float Scale = Dims[0] * Dims[1];
-	const int32 BrushX1 = FMath::Max<int32>(BrushInfo.GetBounds().Min.X, X1 + 1);
-	const int32 BrushY1 = FMath::Max<int32>(BrushInfo.GetBounds().Min.Y, Y1 + 1);
-	const int32 BrushX2 = FMath::Min<int32>(BrushInfo.GetBounds().Max.X, X2);
-	const int32 BrushY2 = FMath::Min<int32>(BrushInfo.GetBounds().Max.Y, Y2);
-	for (int32 Y = BrushY1; Y < BrushY2; Y++)
+	// Contiguous samples X1..X2 of row Y, or nullptr if any of them was never stored.
+	// X2 Coordinate is an "inclusive" max value
+	DataType* GetRow(int32 X1, int32 X2, int32 Y)
 	{
-		const float* BrushScanline = BrushInfo.GetDataPtr(FIntPoint(0, Y));
-		auto* DataScanline = Data.GetData() + (Y - Y1) * (X2 - X1 + 1) + (0 - X1);
-		auto* bufScanline = buf + (Y - (Y1 + 1)) * Dims[1] + (0 - (X1 + 1));
-
-		for (int32 X = BrushX1; X < BrushX2; X++)
+		if (!IsInside(X1, Y) || !IsInside(X2, Y))
 		{
-			const float BrushValue = BrushScanline[X];
-
-			if (BrushValue > 0.0f)
+			return nullptr;
+		}
+		const int32 Index = (Y - MinY) * SizeX + (X1 - MinX);
+		for (int32 i = 0; i <= X2 - X1; i++)
+		{
+			if (!Valid[Index + i])
 			{
-				DataScanline[X] = FMath::Lerp((float)DataScanline[X], bufScanline[X].r / Scale, BrushValue * ApplyRatio);
+				return nullptr;
 			}
 		}
+		return &Data[Index];
 	}
 
-	// Free FFT allocation
-	KISS_FFT_FREE(stf);
-	KISS_FFT_FREE(sti);
-	KISS_FFT_FREE(buf);
-	KISS_FFT_FREE(out);
-#endif
-}
+	void Empty()
+	{
+		Data.Empty();
+		Valid.Empty();
+		MinX = MinY = SizeX = SizeY = 0;
+	}
 
+private:
+	int32 MinX;
+	int32 MinY;
+	int32 SizeX;
+	int32 SizeY;
 
+	TArray<DataType> Data;
+	TBitArray<> Valid;
+};
 
 //
 // TCyLandEditCache
@@ -302,7 +359,7 @@ public:
 				ValidX2 = CachedX2 = X2;
 				ValidY2 = CachedY2 = Y2;
 
-				DataAccess.GetData(ValidX1, ValidY1, ValidX2, ValidY2, CachedData);
+				FetchData(ValidX1, ValidY1, ValidX2, ValidY2);
 				if (!ensureMsgf(ValidX1 <= ValidX2 && ValidY1 <= ValidY2, TEXT("Invalid cache area: X(%d-%d), Y(%d-%d) from region X(%d-%d), Y(%d-%d)"), ValidX1, ValidX2, ValidY1, ValidY2, X1, X2, Y1, Y2))
 				{
 					Valid = false;
@@ -316,7 +373,7 @@ public:
 				CachedX2 = X2;
 				CachedY2 = Y2;
 
-				DataAccess.GetDataFast(CachedX1, CachedY1, CachedX2, CachedY2, CachedData);
+				FetchDataFast(CachedX1, CachedY1, CachedX2, CachedY2);
 			}
 
 			OriginalData = CachedData;
@@ -335,12 +392,12 @@ public:
 					int32 y1 = FMath::Min<int32>(Y1, CachedY1);
 					int32 y2 = FMath::Max<int32>(Y2, CachedY2);
 
-					DataAccess.GetData(x1, y1, x2, y2, CachedData);
+					FetchData(x1, y1, x2, y2);
 					ValidX1 = FMath::Min<int32>(x1, ValidX1);
 				}
 				else
 				{
-					DataAccess.GetDataFast(X1, CachedY1, CachedX1 - 1, CachedY2, CachedData);
+					FetchDataFast(X1, CachedY1, CachedX1 - 1, CachedY2);
 				}
 
 				CacheOriginalData(X1, CachedY1, CachedX1 - 1, CachedY2);
@@ -356,12 +413,12 @@ public:
 					int32 y1 = FMath::Min<int32>(Y1, CachedY1);
 					int32 y2 = FMath::Max<int32>(Y2, CachedY2);
 
-					DataAccess.GetData(x1, y1, x2, y2, CachedData);
+					FetchData(x1, y1, x2, y2);
 					ValidX2 = FMath::Max<int32>(x2, ValidX2);
 				}
 				else
 				{
-					DataAccess.GetDataFast(CachedX2 + 1, CachedY1, X2, CachedY2, CachedData);
+					FetchDataFast(CachedX2 + 1, CachedY1, X2, CachedY2);
 				}
 				CacheOriginalData(CachedX2 + 1, CachedY1, X2, CachedY2);
 				CachedX2 = X2;
@@ -376,12 +433,12 @@ public:
 					int32 y1 = Y1;
 					int32 y2 = ValidY1;
 
-					DataAccess.GetData(x1, y1, x2, y2, CachedData);
+					FetchData(x1, y1, x2, y2);
 					ValidY1 = FMath::Min<int32>(y1, ValidY1);
 				}
 				else
 				{
-					DataAccess.GetDataFast(CachedX1, Y1, CachedX2, CachedY1 - 1, CachedData);
+					FetchDataFast(CachedX1, Y1, CachedX2, CachedY1 - 1);
 				}
 				CacheOriginalData(CachedX1, Y1, CachedX2, CachedY1 - 1);
 				CachedY1 = Y1;
@@ -396,12 +453,12 @@ public:
 					int32 y1 = ValidY2;
 					int32 y2 = Y2;
 
-					DataAccess.GetData(x1, y1, x2, y2, CachedData);
+					FetchData(x1, y1, x2, y2);
 					ValidY2 = FMath::Max<int32>(y2, ValidY2);
 				}
 				else
 				{
-					DataAccess.GetDataFast(CachedX1, CachedY2 + 1, CachedX2, Y2, CachedData);
+					FetchDataFast(CachedX1, CachedY2 + 1, CachedX2, Y2);
 				}
 
 				CacheOriginalData(CachedX1, CachedY2 + 1, CachedX2, Y2);
@@ -412,17 +469,24 @@ public:
 
 	AccessorType* GetValueRef(int32 CyLandX, int32 CyLandY)
 	{
-		return CachedData.Find(FIntPoint(CyLandX, CyLandY));
+		return CachedData.Find(CyLandX, CyLandY);
+	}
+
+	// Contiguous cached samples X1..X2 of row Y, or nullptr if part of the row has no data.
+	// X2 Coordinate is an "inclusive" max value
+	const AccessorType* GetCachedRow(int32 X1, int32 X2, int32 Y)
+	{
+		return CachedData.GetRow(X1, X2, Y);
 	}
 
 	float GetValue(float CyLandX, float CyLandY)
 	{
 		int32 X = FMath::FloorToInt(CyLandX);
 		int32 Y = FMath::FloorToInt(CyLandY);
-		AccessorType* P00 = CachedData.Find(FIntPoint(X, Y));
-		AccessorType* P10 = CachedData.Find(FIntPoint(X + 1, Y));
-		AccessorType* P01 = CachedData.Find(FIntPoint(X, Y + 1));
-		AccessorType* P11 = CachedData.Find(FIntPoint(X + 1, Y + 1));
+		AccessorType* P00 = CachedData.Find(X, Y);
+		AccessorType* P10 = CachedData.Find(X + 1, Y);
+		AccessorType* P01 = CachedData.Find(X, Y + 1);
+		AccessorType* P11 = CachedData.Find(X + 1, Y + 1);
 
 		// Search for nearest value if missing data
 		float V00 = P00 ? *P00 : (P10 ? *P10 : (P01 ? *P01 : (P11 ? *P11 : 0.0f)));
@@ -438,10 +502,10 @@ public:
 
 	FVector GetNormal(int32 X, int32 Y)
 	{
-		AccessorType* P00 = CachedData.Find(FIntPoint(X, Y));
-		AccessorType* P10 = CachedData.Find(FIntPoint(X + 1, Y));
-		AccessorType* P01 = CachedData.Find(FIntPoint(X, Y + 1));
-		AccessorType* P11 = CachedData.Find(FIntPoint(X + 1, Y + 1));
+		AccessorType* P00 = CachedData.Find(X, Y);
+		AccessorType* P10 = CachedData.Find(X + 1, Y);
+		AccessorType* P01 = CachedData.Find(X, Y + 1);
+		AccessorType* P11 = CachedData.Find(X + 1, Y + 1);
 
 		// Search for nearest value if missing data
 		float V00 = P00 ? *P00 : (P10 ? *P10 : (P01 ? *P01 : (P11 ? *P11 : 0.0f)));
@@ -461,7 +525,7 @@ public:
 
 	void SetValue(int32 CyLandX, int32 CyLandY, AccessorType Value)
 	{
-		CachedData.Add(FIntPoint(CyLandX, CyLandY), Forward<AccessorType>(Value));
+		CachedData.Set(CyLandX, CyLandY, MoveTemp(Value));
 	}
 
 	bool IsZeroValue(const FVector& Value)
@@ -497,6 +561,18 @@ public:
 		for (int32 Y = Y1; Y <= Y2; Y++)
 		{
 			const int32 YOffset = (Y - Y1) * XSize;
+
+			// Common case: the whole row is cached
+			if (const AccessorType* Row = GetCachedRow(X1, X2, Y))
+			{
+				for (int32 X = 0; X < XSize; X++)
+				{
+					OutData[YOffset + X] = Row[X];
+					bHasNonZero = bHasNonZero || !IsZeroValue(Row[X]);
+				}
+				continue;
+			}
+
 			for (int32 X = X1; X <= X2; X++)
 			{
 				const int32 XYOffset = YOffset + (X - X1);
@@ -525,6 +601,7 @@ public:
 		checkSlow(Data.Num() == (1 + Y2 - Y1) * (1 + X2 - X1));
 
 		// Update cache
+		CachedData.Reserve(X1, Y1, X2, Y2);
 		for (int32 Y = Y1; Y <= Y2; Y++)
 		{
 			for (int32 X = X1; X <= X2; X++)
@@ -549,7 +626,7 @@ public:
 		{
 			for (int32 X = X1; X <= X2; X++)
 			{
-				AccessorType* Ptr = OriginalData.Find(FIntPoint(X, Y));
+				const AccessorType* Ptr = OriginalData.Find(X, Y);
 				if (Ptr)
 				{
 					OutOriginalData[(X - X1) + (Y - Y1)*(1 + X2 - X1)] = *Ptr;
@@ -564,26 +641,57 @@ public:
 	}
 
 private:
+	// Fetches go through a dense scratch region, missing components leave their samples unset in FetchValid
+	// X2/Y2 Coordinates are "inclusive" max values, the interpolated fetch returns the valid region
+	void FetchData(int32& X1, int32& Y1, int32& X2, int32& Y2)
+	{
+		const int32 RegionX1 = X1, RegionY1 = Y1, RegionX2 = X2, RegionY2 = Y2;
+		ResetFetchBuffer(RegionX1, RegionY1, RegionX2, RegionY2);
+		DataAccess.GetData(X1, Y1, X2, Y2, FetchBuffer, FetchValid);
+		CachedData.SetRegion(RegionX1, RegionY1, RegionX2, RegionY2, FetchBuffer, FetchValid);
+	}
+
+	// X2/Y2 Coordinates are "inclusive" max values
+	void FetchDataFast(int32 X1, int32 Y1, int32 X2, int32 Y2)
+	{
+		ResetFetchBuffer(X1, Y1, X2, Y2);
+		DataAccess.GetDataFast(X1, Y1, X2, Y2, FetchBuffer, FetchValid);
+		CachedData.SetRegion(X1, Y1, X2, Y2, FetchBuffer, FetchValid);
+	}
+
+	void ResetFetchBuffer(int32 X1, int32 Y1, int32 X2, int32 Y2)
+	{
+		// Samples are constructed again so array values (full weights) don't keep layers of a previous fetch
+		const int32 NumSamples = (1 + X2 - X1) * (1 + Y2 - Y1);
+		FetchBuffer.Reset(NumSamples);
+		FetchBuffer.SetNum(NumSamples, false);
+		FetchValid.Init(false, NumSamples);
+	}
+
 	// X2/Y2 Coordinates are "inclusive" max values
 	void CacheOriginalData(int32 X1, int32 Y1, int32 X2, int32 Y2)
 	{
+		OriginalData.Reserve(X1, Y1, X2, Y2);
 		for (int32 Y = Y1; Y <= Y2; Y++)
 		{
 			for (int32 X = X1; X <= X2; X++)
 			{
-				FIntPoint Key = FIntPoint(X, Y);
-				AccessorType* Ptr = CachedData.Find(Key);
+				AccessorType* Ptr = CachedData.Find(X, Y);
 				if (Ptr)
 				{
-					check(OriginalData.Find(Key) == NULL);
-					OriginalData.Add(Key, *Ptr);
+					check(OriginalData.Find(X, Y) == NULL);
+					OriginalData.Set(X, Y, *Ptr);
 				}
 			}
 		}
 	}
 
-	TMap<FIntPoint, AccessorType> CachedData;
-	TMap<FIntPoint, AccessorType> OriginalData;
+	TCyLandEditTileBuffer<AccessorType> CachedData;
+	TCyLandEditTileBuffer<AccessorType> OriginalData;
+
+	// Scratch of the last fetch, kept to reuse its allocation
+	TArray<AccessorType> FetchBuffer;
+	TBitArray<> FetchValid;
 
 	bool Valid;
 
@@ -672,6 +780,25 @@ struct FXYOffsetmapAccessor
 		}
 	}
 
+	// Dense versions, Data and Valid are sized by the caller to the requested region in rows of its width
+	void GetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<FVector>& Data, TBitArray<>& Valid)
+	{
+		const FIntRect Region(X1, Y1, X2, Y2);
+		CyLandEdit->GetXYOffsetData(X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+
+		// Heights of the valid region, which may be larger than the requested one
+		FIntRect HeightRegion(FMath::Max(X1, Region.Min.X), FMath::Max(Y1, Region.Min.Y), FMath::Min(X2, Region.Max.X), FMath::Min(Y2, Region.Max.Y));
+		SetHeights(Region, HeightRegion, Data, Valid);
+	}
+
+	void GetDataFast(int32 X1, int32 Y1, int32 X2, int32 Y2, TArray<FVector>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit->GetXYOffsetDataFast(X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+
+		const FIntRect Region(X1, Y1, X2, Y2);
+		SetHeights(Region, Region, Data, Valid);
+	}
+
 	void SetData(int32 X1, int32 Y1, int32 X2, int32 Y2, const FVector* Data, ECyLandLayerPaintingRestriction PaintingRestriction = ECyLandLayerPaintingRestriction::None)
 	{
 		TSet<UCyLandComponent*> Components;
@@ -759,6 +886,29 @@ struct FXYOffsetmapAccessor
 	}
 
 private:
+	// Fill Z of the valid offsets from the heights, inclusive rects, HeightRegion lies within Region
+	void SetHeights(const FIntRect& Region, FIntRect HeightRegion, TArray<FVector>& Data, const TBitArray<>& Valid)
+	{
+		if (HeightRegion.Min.X > HeightRegion.Max.X || HeightRegion.Min.Y > HeightRegion.Max.Y)
+		{
+			return;
+		}
+
+		const int32 Stride = 1 + Region.Max.X - Region.Min.X;
+		const int32 Offset = (HeightRegion.Min.X - Region.Min.X) + (HeightRegion.Min.Y - Region.Min.Y) * Stride;
+		TArray<uint16> Heights;
+		Heights.AddZeroed(Data.Num());
+		CyLandEdit->GetHeightData(HeightRegion.Min.X, HeightRegion.Min.Y, HeightRegion.Max.X, HeightRegion.Max.Y, Heights.GetData() + Offset, Stride);
+
+		for (int32 Index = 0; Index < Data.Num(); ++Index)
+		{
+			if (Valid[Index])
+			{
+				Data[Index].Z = ((float)Heights[Index] - 32768.0f) * LANDSCAPE_ZSCALE;
+			}
+		}
+	}
+
 	UCyLandInfo* CyLandInfo;
 	FCyLandEditDataInterface* CyLandEdit;
 	TSet<UCyLandComponent*> ChangedComponents;
@@ -863,6 +1013,19 @@ struct FFullWeightmapAccessor
 		CyLandEdit.GetWeightDataFast(NULL, X1, Y1, X2, Y2, Data);
 	}
 
+	// Dense versions, Data and Valid are sized by the caller to the requested region in rows of its width
+	void GetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<TArray<uint8>>& Data, TBitArray<>& Valid)
+	{
+		// Do not Support for interpolation....
+		check(false && TEXT("Do not support interpolation for FullWeightmapAccessor for now"));
+	}
+
+	void GetDataFast(int32 X1, int32 Y1, int32 X2, int32 Y2, TArray<TArray<uint8>>& Data, TBitArray<>& Valid)
+	{
+		DirtyLayerInfos.Empty();
+		CyLandEdit.GetWeightDataFast(NULL, X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
 	void SetData(int32 X1, int32 Y1, int32 X2, int32 Y2, const uint8* Data, ECyLandLayerPaintingRestriction PaintingRestriction)
 	{
 		TSet<UCyLandComponent*> Components;
@@ -991,6 +1154,17 @@ struct FDatamapAccessor
 		CyLandEdit.GetSelectData(X1, Y1, X2, Y2, Data);
 	}
 
+	// Dense versions, Data and Valid are sized by the caller to the requested region in rows of its width
+	void GetData(int32& X1, int32& Y1, int32& X2, int32& Y2, TArray<uint8>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit.GetSelectData(X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
+	void GetDataFast(const int32 X1, const int32 Y1, const int32 X2, const int32 Y2, TArray<uint8>& Data, TBitArray<>& Valid)
+	{
+		CyLandEdit.GetSelectData(X1, Y1, X2, Y2, Data.GetData(), 0, &Valid);
+	}
+
 	void SetData(int32 X1, int32 Y1, int32 X2, int32 Y2, const uint8* Data, ECyLandLayerPaintingRestriction PaintingRestriction = ECyLandLayerPaintingRestriction::None)
 	{
 		if (CyLandEdit.GetComponentsInRegion(X1, Y1, X2, Y2))
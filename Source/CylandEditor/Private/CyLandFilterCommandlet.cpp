@@ -0,0 +1,173 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+	CyLandFilterCommandlet.cpp: Runs a CyLand filter graph from the command line
+=============================================================================*/
+
+#include "Classes/CyLandFilterCommandlet.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "Engine/World.h"
+#include "CyLandInfo.h"
+#include "CyLandInfoMap.h"
+#include "CyLandProxy.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogCyLandFilterCommandlet, Log, All);
+
+UCyLandFilterCommandlet::UCyLandFilterCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCyLandFilterCommandlet::Main(const FString& Params)
+{
+	FString Filters;
+	if (!FParse::Value(*Params, TEXT("Filters="), Filters, false))
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Missing -Filters=\"Stage Args | Stage Args\""));
+		return 1;
+	}
+
+	FCyLandFilterGraph Graph;
+	FString Error;
+	if (!Graph.AddFromString(Filters, Error) || Graph.Num() == 0)
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Invalid filters '%s': %s"), *Filters, *Error);
+		return 1;
+	}
+
+	FString Unused;
+	if (FParse::Value(*Params, TEXT("Raw="), Unused))
+	{
+		return FilterRaw(Graph, Params);
+	}
+	if (FParse::Value(*Params, TEXT("Map="), Unused))
+	{
+		return FilterMap(Graph, Params);
+	}
+
+	UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Missing -Raw= or -Map="));
+	return 1;
+}
+
+int32 UCyLandFilterCommandlet::FilterRaw(const FCyLandFilterGraph& Graph, const FString& Params)
+{
+	FString InFilename;
+	FString OutFilename;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 TileSize = 128;
+	FParse::Value(*Params, TEXT("Raw="), InFilename);
+	FParse::Value(*Params, TEXT("SizeX="), SizeX);
+	FParse::Value(*Params, TEXT("SizeY="), SizeY);
+	FParse::Value(*Params, TEXT("TileSize="), TileSize);
+	if (!FParse::Value(*Params, TEXT("Out="), OutFilename))
+	{
+		OutFilename = InFilename;
+	}
+
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *InFilename))
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Couldn't read %s"), *InFilename);
+		return 1;
+	}
+
+	if (SizeX <= 0 || SizeY <= 0 || Data.Num() != SizeX * SizeY * (int32)sizeof(uint16))
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("%s has %d bytes, expected a %dx%d 16 bit heightmap"), *InFilename, Data.Num(), SizeX, SizeY);
+		return 1;
+	}
+
+	TArray<uint16> Heights;
+	Heights.SetNumUninitialized(SizeX * SizeY);
+	FMemory::Memcpy(Heights.GetData(), Data.GetData(), Data.Num());
+
+	if (!Graph.RunOnHeightmap(Heights, SizeX, SizeY, TileSize))
+	{
+		return 1;
+	}
+
+	FMemory::Memcpy(Data.GetData(), Heights.GetData(), Data.Num());
+	if (!FFileHelper::SaveArrayToFile(Data, *OutFilename))
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Couldn't write %s"), *OutFilename);
+		return 1;
+	}
+
+	UE_LOG(LogCyLandFilterCommandlet, Display, TEXT("Filtered %s into %s"), *InFilename, *OutFilename);
+	return 0;
+}
+
+int32 UCyLandFilterCommandlet::FilterMap(const FCyLandFilterGraph& Graph, const FString& Params)
+{
+	FString MapName;
+	int32 ComponentsPerTile = 2;
+	FParse::Value(*Params, TEXT("Map="), MapName);
+	FParse::Value(*Params, TEXT("ComponentsPerTile="), ComponentsPerTile);
+
+	UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Couldn't load the map %s"), *MapName);
+		return 1;
+	}
+
+	// The CyLand infos are only built once the components of the world are registered
+	World->WorldType = EWorldType::Editor;
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false));
+	}
+	World->UpdateWorldComponents(true, false);
+
+	int32 NumFiltered = 0;
+	TSet<UPackage*> Packages;
+	for (const TPair<FGuid, UCyLandInfo*>& Pair : UCyLandInfoMap::GetCyLandInfoMap(World).Map)
+	{
+		if (Graph.Run(Pair.Value, FIntRect(), ComponentsPerTile))
+		{
+			NumFiltered++;
+			Pair.Value->ForAllCyLandProxies([&Packages](ACyLandProxy* Proxy)
+			{
+				Packages.Add(Proxy->GetOutermost());
+			});
+		}
+	}
+
+	// Streaming proxies live in their own levels, every package holding heightmaps of a filtered CyLand is saved
+	int32 Result = 0;
+	for (UPackage* DirtyPackage : Packages)
+	{
+		if (!DirtyPackage->IsDirty())
+		{
+			continue;
+		}
+
+		UWorld* PackageWorld = UWorld::FindWorldInPackage(DirtyPackage);
+		const FString Filename = FPackageName::LongPackageNameToFilename(DirtyPackage->GetName(), FPackageName::GetMapPackageExtension());
+		if (!PackageWorld || !UPackage::SavePackage(DirtyPackage, PackageWorld, RF_Standalone, *Filename))
+		{
+			UE_LOG(LogCyLandFilterCommandlet, Error, TEXT("Couldn't save %s"), *DirtyPackage->GetName());
+			Result = 1;
+		}
+	}
+
+	UE_LOG(LogCyLandFilterCommandlet, Display, TEXT("Filtered %d CyLands of %s"), NumFiltered, *MapName);
+
+	World->RemoveFromRoot();
+	World->DestroyWorld(false);
+	return Result;
+}
@@ -0,0 +1,263 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLowPassFilter.cpp: FFT low-pass filter of the detail smoothing
+=============================================================================*/
+
+#include "CyLandLowPassFilter.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#if WITH_KISSFFT
+#include "kiss_fft.h"
+#include "tools/kiss_fftr.h"
+
+namespace
+{
+	/** Plans already built are reused, a stroke keeps the same size and few strokes use more than a couple of sizes */
+	const int32 MaxCachedPlans = 4;
+
+	/** Smallest length made of the factors 2, 3 and 5 only, which kissfft has fast butterflies for */
+	int32 GetFFTFriendlySize(int32 Size)
+	{
+		for (int32 Candidate = FMath::Max(Size, 1);; Candidate++)
+		{
+			int32 Remainder = Candidate;
+			for (int32 Factor : { 2, 3, 5 })
+			{
+				while (Remainder % Factor == 0)
+				{
+					Remainder /= Factor;
+				}
+			}
+			if (Remainder == 1)
+			{
+				return Candidate;
+			}
+		}
+	}
+
+	/** Index of a padded vertex in the region, mirrored at the far edge */
+	FORCEINLINE int32 MirrorIndex(int32 Index, int32 Size)
+	{
+		return Index < Size ? Index : FMath::Max(2 * Size - 2 - Index, 0);
+	}
+
+	/**
+	 * Plans and buffers of one padded size.
+	 * kiss_fftr uses scratch memory of its plan, so each row job has its own real plans. Complex plans only read
+	 * their twiddles when the input and output differ, so the column jobs share them.
+	 */
+	struct FLowPassFilterPlan
+	{
+		/** Padded width, even as the real transform needs */
+		int32 Width;
+		int32 Height;
+
+		/** Columns of the half spectrum */
+		int32 NumColumns;
+
+		int32 NumRowJobs;
+
+		TArray<kiss_fftr_cfg> ForwardRowPlans;
+		TArray<kiss_fftr_cfg> InverseRowPlans;
+		kiss_fft_cfg ForwardColumnPlan;
+		kiss_fft_cfg InverseColumnPlan;
+
+		/** Padded values, Height rows of Width */
+		TArray<kiss_fft_scalar> Values;
+
+		/** Half spectrum stored by columns, NumColumns columns of Height, and the output of the column transforms */
+		TArray<kiss_fft_cpx> Spectrum;
+		TArray<kiss_fft_cpx> SpectrumScratch;
+
+		/** One row of half spectrum per row job */
+		TArray<kiss_fft_cpx> RowScratch;
+
+		FLowPassFilterPlan(int32 InWidth, int32 InHeight)
+			: Width(InWidth)
+			, Height(InHeight)
+			, NumColumns(InWidth / 2 + 1)
+		{
+			NumRowJobs = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, Height);
+
+			for (int32 Job = 0; Job < NumRowJobs; Job++)
+			{
+				ForwardRowPlans.Add(kiss_fftr_alloc(Width, 0, nullptr, nullptr));
+				InverseRowPlans.Add(kiss_fftr_alloc(Width, 1, nullptr, nullptr));
+			}
+			ForwardColumnPlan = kiss_fft_alloc(Height, 0, nullptr, nullptr);
+			InverseColumnPlan = kiss_fft_alloc(Height, 1, nullptr, nullptr);
+
+			Values.SetNumUninitialized(Width * Height);
+			Spectrum.SetNumUninitialized(NumColumns * Height);
+			SpectrumScratch.SetNumUninitialized(NumColumns * Height);
+			RowScratch.SetNumUninitialized(NumColumns * NumRowJobs);
+		}
+
+		~FLowPassFilterPlan()
+		{
+			for (int32 Job = 0; Job < NumRowJobs; Job++)
+			{
+				KISS_FFT_FREE(ForwardRowPlans[Job]);
+				KISS_FFT_FREE(InverseRowPlans[Job]);
+			}
+			KISS_FFT_FREE(ForwardColumnPlan);
+			KISS_FFT_FREE(InverseColumnPlan);
+		}
+
+		/** Run a function on the rows of each row job */
+		template<typename FunctionType>
+		void ForEachRowJob(const FunctionType& Function)
+		{
+			ParallelFor(NumRowJobs, [&](int32 Job)
+			{
+				const int32 FirstRow = Job * Height / NumRowJobs;
+				const int32 LastRow = (Job + 1) * Height / NumRowJobs;
+				Function(Job, FirstRow, LastRow);
+			});
+		}
+
+		/**
+		 * Filter Values in place.
+		 * @param SizeX, SizeY - Size of the region before padding, the filter frequencies are relative to it
+		 */
+		void Filter(int32 SizeX, int32 SizeY, float DetailScale)
+		{
+			// Forward transform of the rows, written transposed so each column is contiguous
+			ForEachRowJob([&](int32 Job, int32 FirstRow, int32 LastRow)
+			{
+				kiss_fft_cpx* RESTRICT RowSpectrum = RowScratch.GetData() + Job * NumColumns;
+				for (int32 Y = FirstRow; Y < LastRow; Y++)
+				{
+					kiss_fftr(ForwardRowPlans[Job], Values.GetData() + Y * Width, RowSpectrum);
+					for (int32 X = 0; X < NumColumns; X++)
+					{
+						Spectrum[X * Height + Y] = RowSpectrum[X];
+					}
+				}
+			});
+
+			// High frequency removal, with the frequencies scaled back to the unpadded region
+			const float Ratio = 1.0f - DetailScale;
+			const float Dist = FMath::Min<float>((SizeY * Ratio)*(SizeY * Ratio), (SizeX * Ratio)*(SizeX * Ratio));
+			const float FrequencyScaleX = (float)SizeX / Width;
+			const float FrequencyScaleY = (float)SizeY / Height;
+			const int32 CenterY = Height >> 1;
+
+			ParallelFor(NumColumns, [&](int32 X)
+			{
+				kiss_fft_cpx* Column = Spectrum.GetData() + X * Height;
+				kiss_fft_cpx* RESTRICT ColumnScratch = SpectrumScratch.GetData() + X * Height;
+
+				kiss_fft(ForwardColumnPlan, Column, ColumnScratch);
+
+				const float FrequencyX = X * FrequencyScaleX;
+				for (int32 Y = 0; Y < Height; Y++)
+				{
+					const float FrequencyY = (Y < CenterY ? Y : Y - Height) * FrequencyScaleY;
+					const float DistFromCenter = FrequencyX * FrequencyX + FrequencyY * FrequencyY;
+					const float Filter = 1.0 / (1.0 + DistFromCenter / Dist);
+					ColumnScratch[Y].r *= Filter;
+					ColumnScratch[Y].i *= Filter;
+				}
+
+				kiss_fft(InverseColumnPlan, ColumnScratch, Column);
+			});
+
+			// Inverse transform of the rows, kissfft doesn't normalize
+			const float Scale = 1.0f / (Width * Height);
+			ForEachRowJob([&](int32 Job, int32 FirstRow, int32 LastRow)
+			{
+				kiss_fft_cpx* RESTRICT RowSpectrum = RowScratch.GetData() + Job * NumColumns;
+				for (int32 Y = FirstRow; Y < LastRow; Y++)
+				{
+					for (int32 X = 0; X < NumColumns; X++)
+					{
+						RowSpectrum[X] = Spectrum[X * Height + Y];
+					}
+
+					kiss_fft_scalar* RESTRICT Row = Values.GetData() + Y * Width;
+					kiss_fftri(InverseRowPlans[Job], RowSpectrum, Row);
+					for (int32 X = 0; X < Width; X++)
+					{
+						Row[X] *= Scale;
+					}
+				}
+			});
+		}
+	};
+
+	/** Most recently used plan last */
+	TArray<TUniquePtr<FLowPassFilterPlan>> CachedPlans;
+
+	FLowPassFilterPlan& FindOrAddPlan(int32 Width, int32 Height)
+	{
+		for (int32 Index = 0; Index < CachedPlans.Num(); Index++)
+		{
+			if (CachedPlans[Index]->Width == Width && CachedPlans[Index]->Height == Height)
+			{
+				TUniquePtr<FLowPassFilterPlan> Plan = MoveTemp(CachedPlans[Index]);
+				CachedPlans.RemoveAt(Index);
+				CachedPlans.Add(MoveTemp(Plan));
+				return *CachedPlans.Last();
+			}
+		}
+
+		if (CachedPlans.Num() >= MaxCachedPlans)
+		{
+			CachedPlans.RemoveAt(0);
+		}
+		CachedPlans.Add(MakeUnique<FLowPassFilterPlan>(Width, Height));
+		return *CachedPlans.Last();
+	}
+}
+#endif
+
+template<typename DataType>
+const float* CyLandLowPassFilter::Apply(const DataType* Data, int32 DataStride, int32 SizeX, int32 SizeY, float DetailScale, int32& OutStride)
+{
+#if WITH_KISSFFT
+	check(IsInGameThread());
+	static_assert(sizeof(kiss_fft_scalar) == sizeof(float), "The filtered values are returned as floats");
+
+	if (SizeX <= 0 || SizeY <= 0)
+	{
+		return nullptr;
+	}
+
+	// The real transform works on half the width as complex values, so that half has to be FFT friendly too
+	FLowPassFilterPlan& Plan = FindOrAddPlan(2 * GetFFTFriendlySize((SizeX + 1) / 2), GetFFTFriendlySize(SizeY));
+
+	for (int32 Y = 0; Y < Plan.Height; Y++)
+	{
+		const DataType* DataScanline = Data + MirrorIndex(Y, SizeY) * DataStride;
+		kiss_fft_scalar* RESTRICT ValuesScanline = Plan.Values.GetData() + Y * Plan.Width;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			ValuesScanline[X] = DataScanline[X];
+		}
+		for (int32 X = SizeX; X < Plan.Width; X++)
+		{
+			ValuesScanline[X] = DataScanline[MirrorIndex(X, SizeX)];
+		}
+	}
+
+	Plan.Filter(SizeX, SizeY, DetailScale);
+
+	OutStride = Plan.Width;
+	return Plan.Values.GetData();
+#else
+	return nullptr;
+#endif
+}
+
+void CyLandLowPassFilter::EmptyCache()
+{
+#if WITH_KISSFFT
+	CachedPlans.Empty();
+#endif
+}
+
+template const float* CyLandLowPassFilter::Apply<uint8>(const uint8* Data, int32 DataStride, int32 SizeX, int32 SizeY, float DetailScale, int32& OutStride);
+template const float* CyLandLowPassFilter::Apply<uint16>(const uint16* Data, int32 DataStride, int32 SizeX, int32 SizeY, float DetailScale, int32& OutStride);
@@ -0,0 +1,39 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandLowPassFilter.h: FFT low-pass filter of the detail smoothing
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Low-pass filter of the Smooth tool (detail mode) and of the detail smoothing of hydraulic erosion.
+ *
+ * The region is padded to lengths made of small prime factors, mirroring it at its edges, and goes through real to
+ * complex transforms: rows first, then the columns of the half spectrum. Rows and columns are transformed in
+ * parallel, and the filter is applied to each column between its forward and inverse transform.
+ *
+ * The FFT plans and the buffers are kept between calls, keyed by the padded size, since a stroke filters the same
+ * size over and over. The frequency response is the one of the unpadded region, so padding doesn't change how much
+ * detail is removed.
+ *
+ * Only called from the game thread.
+ */
+namespace CyLandLowPassFilter
+{
+	/**
+	 * Filter a region.
+	 * @param Data - First vertex of the region
+	 * @param DataStride - Distance between two rows of Data, in vertices
+	 * @param DetailScale - Larger values remove more detail, in [0, 1]
+	 * @param OutStride - Distance between two rows of the result, in values
+	 * @return SizeX * SizeY filtered values, valid until the next call. Null if the filter isn't available
+	 */
+	template<typename DataType>
+	const float* Apply(const DataType* Data, int32 DataStride, int32 SizeX, int32 SizeY, float DetailScale, int32& OutStride);
+
+	/** Free the cached plans and buffers */
+	void EmptyCache();
+}
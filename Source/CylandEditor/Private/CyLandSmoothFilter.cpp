@@ -0,0 +1,143 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandSmoothFilter.cpp: Box smoothing of the Smooth tool, constant time per vertex
+=============================================================================*/
+
+#include "CyLandSmoothFilter.h"
+
+namespace
+{
+	/** Sums of a whole region must not overflow: 8 bit weights fit 16M vertices in 32 bits, 16 bit heights need 64 */
+	template<typename DataType> struct TSmoothSumType;
+	template<> struct TSmoothSumType<uint8> { typedef uint32 Type; };
+	template<> struct TSmoothSumType<uint16> { typedef uint64 Type; };
+
+	/**
+	 * Summed-area table with a zero row and column in front, so the sum of a box is four reads.
+	 * Unsigned sums wrap around in the subtractions but the box sums come out right.
+	 */
+	template<typename SumType>
+	struct TSummedAreaTable
+	{
+		TArray<SumType> Sums;
+		TArray<SumType> RowSums;
+		int32 Stride;
+
+		void Init(int32 SizeX, int32 SizeY)
+		{
+			Stride = SizeX + 1;
+			Sums.SetNumZeroed(Stride * (SizeY + 1));
+			RowSums.SetNumZeroed(Stride);
+		}
+
+		/** Running sum along the row is serial, the add of the row above has independent lanes and is vectorized by the compiler */
+		void AddRow(int32 Y)
+		{
+			const SumType* RESTRICT Above = Sums.GetData() + Y * Stride;
+			const SumType* RESTRICT Row = RowSums.GetData();
+			SumType* RESTRICT Out = Sums.GetData() + (Y + 1) * Stride;
+			for (int32 X = 0; X < Stride; X++)
+			{
+				Out[X] = Above[X] + Row[X];
+			}
+		}
+
+		/** Sum of the inclusive box X1,Y1 - X2,Y2 */
+		FORCEINLINE SumType BoxSum(int32 X1, int32 Y1, int32 X2, int32 Y2) const
+		{
+			const SumType* Top = Sums.GetData() + Y1 * Stride;
+			const SumType* Bottom = Sums.GetData() + (Y2 + 1) * Stride;
+			return Bottom[X2 + 1] - Bottom[X1] - Top[X2 + 1] + Top[X1];
+		}
+	};
+}
+
+template<typename DataType>
+void CyLandSmoothFilter::Apply(const float* Brush, DataType* Data, int32 DataStride, int32 SizeX, int32 SizeY, int32 FilterRadius, float Strength)
+{
+	typedef typename TSmoothSumType<DataType>::Type SumType;
+
+	if (SizeX <= 0 || SizeY <= 0)
+	{
+		return;
+	}
+
+	// Values and counts of the vertices inside the brush
+	TSummedAreaTable<SumType> Values;
+	TSummedAreaTable<uint32> Counts;
+	Values.Init(SizeX, SizeY);
+	Counts.Init(SizeX, SizeY);
+
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const float* BrushScanline = Brush + Y * SizeX;
+		const DataType* DataScanline = Data + Y * DataStride;
+
+		SumType RunningValue = 0;
+		uint32 RunningCount = 0;
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const bool bInBrush = BrushScanline[X] > 0.0f;
+			RunningValue += bInBrush ? (SumType)DataScanline[X] : 0;
+			RunningCount += bInBrush ? 1 : 0;
+			Values.RowSums[X + 1] = RunningValue;
+			Counts.RowSums[X + 1] = RunningCount;
+		}
+
+		Values.AddRow(Y);
+		Counts.AddRow(Y);
+	}
+
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		const float* BrushScanline = Brush + Y * SizeX;
+		DataType* DataScanline = Data + Y * DataStride;
+		const int32 YRadius = FMath::Min3<int32>(FilterRadius, Y, SizeY - Y - 1);
+
+		// The largest window inside the brush changes by one vertex at most between neighbours, except near the
+		// region edges, so starting from the previous one keeps the search constant time on average
+		int32 Radius = 0;
+
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const float BrushValue = BrushScanline[X];
+			if (BrushValue <= 0.0f)
+			{
+				continue;
+			}
+
+			const int32 XRadius = FMath::Min3<int32>(FilterRadius, X, SizeX - X - 1);
+			const int32 MaxRadius = FMath::Max(XRadius, YRadius);
+
+			const auto IsInsideBrush = [&](int32 TestRadius)
+			{
+				const int32 SampleXRadius = FMath::Min(XRadius, TestRadius);
+				const int32 SampleYRadius = FMath::Min(YRadius, TestRadius);
+				const uint32 NumSamples = (2 * SampleXRadius + 1) * (2 * SampleYRadius + 1);
+				return Counts.BoxSum(X - SampleXRadius, Y - SampleYRadius, X + SampleXRadius, Y + SampleYRadius) == NumSamples;
+			};
+
+			// A radius of 0 is the vertex itself, which is in the brush
+			Radius = FMath::Clamp(Radius - 1, 0, MaxRadius);
+			while (Radius > 0 && !IsInsideBrush(Radius))
+			{
+				Radius--;
+			}
+			while (Radius < MaxRadius && IsInsideBrush(Radius + 1))
+			{
+				Radius++;
+			}
+
+			const int32 SampleXRadius = FMath::Min(XRadius, Radius);
+			const int32 SampleYRadius = FMath::Min(YRadius, Radius);
+			const SumType NumSamples = (2 * SampleXRadius + 1) * (2 * SampleYRadius + 1);
+			const SumType FilterValue = Values.BoxSum(X - SampleXRadius, Y - SampleYRadius, X + SampleXRadius, Y + SampleYRadius) / NumSamples;
+
+			DataScanline[X] = FMath::Lerp(DataScanline[X], (DataType)FilterValue, BrushValue * Strength);
+		}
+	}
+}
+
+template void CyLandSmoothFilter::Apply<uint8>(const float* Brush, uint8* Data, int32 DataStride, int32 SizeX, int32 SizeY, int32 FilterRadius, float Strength);
+template void CyLandSmoothFilter::Apply<uint16>(const float* Brush, uint16* Data, int32 DataStride, int32 SizeX, int32 SizeY, int32 FilterRadius, float Strength);
@@ -0,0 +1,34 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+/*=============================================================================
+CyLandSmoothFilter.h: Box smoothing of the Smooth tool, constant time per vertex
+=============================================================================*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Box filter of the Smooth tool (non-detail mode) built on summed-area tables, so the cost per brushed vertex doesn't
+ * depend on the filter radius.
+ *
+ * Only vertices inside the brush are sampled, and the window stays symmetric around the smoothed vertex so slopes
+ * aren't flattened. The old per-vertex loop got this by skipping samples whose mirror was outside the brush; here
+ * the window shrinks until it is fully inside the brush instead, which is what lets its sum come from the tables.
+ * Vertices further than the radius from the brush edge get the same result as before.
+ *
+ * All the samples are read before any vertex is written.
+ */
+namespace CyLandSmoothFilter
+{
+	/**
+	 * Smooth the brushed vertices of a region in place.
+	 * @param Brush - SizeX * SizeY brush values, vertices with a value of 0 are neither sampled nor written
+	 * @param Data - Vertex of the first brush value
+	 * @param DataStride - Distance between two rows of Data, in vertices
+	 * @param FilterRadius - Radius of the box filter, it is clamped to the region so the window stays symmetric
+	 * @param Strength - Scales the brush values to get the blend between the old and the smoothed value
+	 */
+	template<typename DataType>
+	void Apply(const float* Brush, DataType* Data, int32 DataStride, int32 SizeX, int32 SizeY, int32 FilterRadius, float Strength);
+}
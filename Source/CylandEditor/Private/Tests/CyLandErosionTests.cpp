@@ -0,0 +1,149 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "CyLandErosion.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CyLandErosionTest
+{
+	const int32 SizeX = 150;
+	const int32 SizeY = 130;
+
+	/** Hills with noise on them, a brush mask falling off towards the edges and two paint layers, optionally a hole in the middle */
+	void InitErosion(FCyLandErosion& Erosion, int32 TileSize, bool bHole = false)
+	{
+		FRandomStream RandomStream(0xE905);
+		Erosion.TileSize = TileSize;
+		Erosion.Mask.SetNumUninitialized(SizeX * SizeY);
+		Erosion.Softness.SetNumUninitialized(SizeX * SizeY);
+		Erosion.LayerWeights.SetNum(2);
+		Erosion.LayerWeights[0].SetNumUninitialized(SizeX * SizeY);
+		Erosion.LayerWeights[1].SetNumUninitialized(SizeX * SizeY);
+
+		for (int32 Y = 0; Y < SizeY; Y++)
+		{
+			for (int32 X = 0; X < SizeX; X++)
+			{
+				const int32 Index = X + Y * SizeX;
+				const float Hills = FMath::Sin(X * 0.11f) * FMath::Cos(Y * 0.07f);
+				Erosion.Heights[Index] = 32768.0f + 12000.0f * Hills + RandomStream.FRandRange(-400.0f, 400.0f);
+				Erosion.Mask[Index] = FMath::Clamp(1.5f - FVector2D(X - SizeX / 2, Y - SizeY / 2).Size() / 50.0f, 0.0f, 1.0f);
+				Erosion.Softness[Index] = RandomStream.FRandRange(0.5f, 1.0f);
+				Erosion.LayerWeights[0][Index] = Hills > 0.0f ? 1.0f : 0.0f;
+				Erosion.LayerWeights[1][Index] = 1.0f - Erosion.LayerWeights[0][Index];
+			}
+		}
+
+		if (bHole)
+		{
+			Erosion.Holes.Init(false, SizeX * SizeY);
+			for (int32 Y = 50; Y < 80; Y++)
+			{
+				for (int32 X = 60; X < 90; X++)
+				{
+					Erosion.Holes[X + Y * SizeX] = true;
+					Erosion.Heights[X + Y * SizeX] = 0.0f;
+				}
+			}
+		}
+	}
+
+	float MaxDifference(const TArray<float>& A, const TArray<float>& B)
+	{
+		float MaxError = 0.0f;
+		for (int32 Index = 0; Index < A.Num(); Index++)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(A[Index] - B[Index]));
+		}
+		return MaxError;
+	}
+}
+
+/**
+* Tiled erosion test, tiles exchanging their halos give the same result as the whole grid in one tile, also around a hole
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandErosionTilingTest, "System.Engine.CyLand.Erosion Tiling", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandErosionTilingTest::RunTest(const FString& Parameters)
+{
+	using namespace CyLandErosionTest;
+
+	// Tiles smaller than the halo, not dividing the grid, and the default size
+	const int32 TileSizes[] = { 5, 37, FCyLandErosion::DefaultTileSize };
+
+	FCyLandThermalErosionSettings Thermal;
+	Thermal.Iterations = 30;
+	Thermal.Threshold = 32.0f;
+
+	FCyLandErosion SingleTileThermal(SizeX, SizeY);
+	InitErosion(SingleTileThermal, FMath::Max(SizeX, SizeY));
+	const int32 ThermalIterations = SingleTileThermal.RunThermal(Thermal);
+
+	for (int32 TileSize : TileSizes)
+	{
+		FCyLandErosion Erosion(SizeX, SizeY);
+		InitErosion(Erosion, TileSize);
+		TestEqual(FString::Printf(TEXT("Thermal iterations with %d vertex tiles"), TileSize), Erosion.RunThermal(Thermal), ThermalIterations);
+		TestTrue(FString::Printf(TEXT("Thermal heights with %d vertex tiles"), TileSize), MaxDifference(Erosion.Heights, SingleTileThermal.Heights) < 0.01f);
+		TestTrue(FString::Printf(TEXT("Thermal layer weights with %d vertex tiles"), TileSize),
+			MaxDifference(Erosion.LayerWeights[0], SingleTileThermal.LayerWeights[0]) < 0.0001f && MaxDifference(Erosion.LayerWeights[1], SingleTileThermal.LayerWeights[1]) < 0.0001f);
+	}
+
+	FCyLandHydraulicErosionSettings Hydraulic;
+	Hydraulic.Iterations = 30;
+
+	FCyLandErosion SingleTileHydraulic(SizeX, SizeY);
+	InitErosion(SingleTileHydraulic, FMath::Max(SizeX, SizeY));
+	SingleTileHydraulic.Rain(256.0f);
+	const int32 HydraulicIterations = SingleTileHydraulic.RunHydraulic(Hydraulic);
+
+	for (int32 TileSize : TileSizes)
+	{
+		FCyLandErosion Erosion(SizeX, SizeY);
+		InitErosion(Erosion, TileSize);
+		Erosion.Rain(256.0f);
+		TestEqual(FString::Printf(TEXT("Hydraulic iterations with %d vertex tiles"), TileSize), Erosion.RunHydraulic(Hydraulic), HydraulicIterations);
+		TestTrue(FString::Printf(TEXT("Hydraulic heights with %d vertex tiles"), TileSize), MaxDifference(Erosion.Heights, SingleTileHydraulic.Heights) < 0.01f);
+		TestTrue(FString::Printf(TEXT("Hydraulic water with %d vertex tiles"), TileSize), MaxDifference(Erosion.Water, SingleTileHydraulic.Water) < 0.01f);
+		TestTrue(FString::Printf(TEXT("Hydraulic sediment with %d vertex tiles"), TileSize), MaxDifference(Erosion.Sediment, SingleTileHydraulic.Sediment) < 0.01f);
+	}
+
+	// A hole at height 0 in the middle of the hills is a wall, not a sink, and keeps its heights
+	FCyLandErosion SingleTileHole(SizeX, SizeY);
+	InitErosion(SingleTileHole, FMath::Max(SizeX, SizeY), true);
+	SingleTileHole.RunThermal(Thermal);
+	SingleTileHole.Rain(256.0f);
+	SingleTileHole.RunHydraulic(Hydraulic);
+
+	float MaxHoleHeight = 0.0f;
+	float MinHeight = MAX_flt;
+	for (int32 Index = 0; Index < SingleTileHole.Heights.Num(); Index++)
+	{
+		if (SingleTileHole.Holes[Index])
+		{
+			MaxHoleHeight = FMath::Max(MaxHoleHeight, SingleTileHole.Heights[Index]);
+		}
+		else
+		{
+			MinHeight = FMath::Min(MinHeight, SingleTileHole.Heights[Index]);
+		}
+	}
+	TestEqual(TEXT("Heights of the hole are kept"), MaxHoleHeight, 0.0f);
+	TestTrue(TEXT("Nothing slides into the hole"), MinHeight > 10000.0f);
+
+	for (int32 TileSize : TileSizes)
+	{
+		FCyLandErosion Erosion(SizeX, SizeY);
+		InitErosion(Erosion, TileSize, true);
+		Erosion.RunThermal(Thermal);
+		Erosion.Rain(256.0f);
+		Erosion.RunHydraulic(Hydraulic);
+		TestTrue(FString::Printf(TEXT("Heights around a hole with %d vertex tiles"), TileSize), MaxDifference(Erosion.Heights, SingleTileHole.Heights) < 0.01f);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,107 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "CyLandFilterGraph.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Filter graph banding test, bands of tiles read with their apron give the same heights as the whole heightmap in one tile,
+* with and without a missing component
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandFilterGraphBandingTest, "System.Engine.CyLand.Filter Graph Banding", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandFilterGraphBandingTest::RunTest(const FString& Parameters)
+{
+	const int32 SizeX = 300;
+	const int32 SizeY = 260;
+
+	FRandomStream RandomStream(0xF17E);
+	TArray<uint16> Heights;
+	Heights.SetNumUninitialized(SizeX * SizeY);
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			Heights[X + Y * SizeX] = (uint16)(20000.0f + 3000.0f * FMath::Sin(X * 0.2f) * FMath::Cos(Y * 0.15f) + RandomStream.RandRange(0, 2000));
+		}
+	}
+
+	// Every kind of filter, the erosions and the smoothing give the graph an apron wider than the smallest tiles
+	FCyLandFilterGraph Graph;
+	FString Error;
+	const bool bParsed = Graph.AddFromString(TEXT("Smooth Radius=3 Strength=0.7 | Thermal Iterations=5 Threshold=16 | Hydraulic Iterations=4 Rain=64 | ")
+		TEXT("Noise Amount=300 Scale=50 WarpScale=80 WarpAmount=10 | Flatten Height=21000 Strength=0.2 | ")
+		TEXT("Ramp StartX=10 StartY=10 StartZ=30000 EndX=280 EndY=200 EndZ=10000 Width=6 Falloff=4"), Error);
+	if (!TestTrue(FString::Printf(TEXT("Graph parses: %s"), *Error), bParsed))
+	{
+		return false;
+	}
+
+	TArray<uint16> SingleTile = Heights;
+	TestTrue(TEXT("Single tile run"), Graph.RunOnHeightmap(SingleTile, SizeX, SizeY, FMath::Max(SizeX, SizeY)));
+	TestTrue(TEXT("Filters changed the heights"), SingleTile != Heights);
+
+	// Tiles smaller than the apron, tiles not dividing the heightmap, and the default size
+	const int32 TileSizes[] = { 16, 37, 128 };
+	for (int32 TileSize : TileSizes)
+	{
+		TArray<uint16> Banded = Heights;
+		Graph.RunOnHeightmap(Banded, SizeX, SizeY, TileSize);
+
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < Banded.Num(); Index++)
+		{
+			NumMismatches += Banded[Index] != SingleTile[Index] ? 1 : 0;
+		}
+		TestEqual(FString::Printf(TEXT("Heights with %d vertex tiles"), TileSize), NumMismatches, 0);
+	}
+
+	// A missing 63 quad component, its edge vertices belong to its neighbours
+	const FIntRect Hole(127, 64, 189, 126);
+	TBitArray<> Valid(true, SizeX * SizeY);
+	TArray<uint16> LowHoles = Heights;
+	TArray<uint16> HighHoles = Heights;
+	for (int32 Y = Hole.Min.Y + 1; Y < Hole.Max.Y; Y++)
+	{
+		for (int32 X = Hole.Min.X + 1; X < Hole.Max.X; X++)
+		{
+			Valid[X + Y * SizeX] = false;
+			LowHoles[X + Y * SizeX] = 0;
+			HighHoles[X + Y * SizeX] = 65535;
+		}
+	}
+
+	// The heights of the hole are never read, and are kept
+	TArray<uint16> SingleTileHoles = LowHoles;
+	TestTrue(TEXT("Single tile run with a missing component"), Graph.RunOnHeightmap(SingleTileHoles, SizeX, SizeY, FMath::Max(SizeX, SizeY), &Valid));
+	Graph.RunOnHeightmap(HighHoles, SizeX, SizeY, FMath::Max(SizeX, SizeY), &Valid);
+
+	int32 NumHoleMismatches = 0;
+	int32 NumHoleChanges = 0;
+	for (int32 Index = 0; Index < Heights.Num(); Index++)
+	{
+		NumHoleMismatches += Valid[Index] && SingleTileHoles[Index] != HighHoles[Index] ? 1 : 0;
+		NumHoleChanges += !Valid[Index] && (SingleTileHoles[Index] != 0 || HighHoles[Index] != 65535) ? 1 : 0;
+	}
+	TestEqual(TEXT("Heights around a missing component don't depend on its heights"), NumHoleMismatches, 0);
+	TestEqual(TEXT("Heights of a missing component are kept"), NumHoleChanges, 0);
+
+	for (int32 TileSize : TileSizes)
+	{
+		TArray<uint16> Banded = LowHoles;
+		Graph.RunOnHeightmap(Banded, SizeX, SizeY, TileSize, &Valid);
+
+		int32 NumMismatches = 0;
+		for (int32 Index = 0; Index < Banded.Num(); Index++)
+		{
+			NumMismatches += Banded[Index] != SingleTileHoles[Index] ? 1 : 0;
+		}
+		TestEqual(FString::Printf(TEXT("Heights with a missing component and %d vertex tiles"), TileSize), NumMismatches, 0);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
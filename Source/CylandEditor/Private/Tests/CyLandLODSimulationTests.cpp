@@ -0,0 +1,60 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "CyLandLODMath.h"
+#include "CyLandLODSimulation.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* CyLand LOD math and simulation test, runs without a world or a renderer
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandLODSimulationTest, "System.Engine.CyLand.LOD Simulation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandLODSimulationTest::RunTest(const FString& Parameters)
+{
+	// Screen size thresholds decrease with the LOD and LODs increase with the distance
+	TArray<float> LODScreenRatioSquared;
+	CyLandLODMath::BuildLODScreenRatioSquared(5, 1.75f, 2.0f, LODScreenRatioSquared);
+	TestEqual(TEXT("LOD table size"), LODScreenRatioSquared.Num(), 6);
+	for (int32 LODIndex = 1; LODIndex < LODScreenRatioSquared.Num(); LODIndex++)
+	{
+		TestTrue(TEXT("LOD table decreases"), LODScreenRatioSquared[LODIndex] < LODScreenRatioSquared[LODIndex - 1]);
+	}
+
+	float PreviousLOD = 0.0f;
+	for (float Distance = 0.0f; Distance < 2000000.0f; Distance += 10000.0f)
+	{
+		const float ScreenSize = CyLandLODMath::GetComponentScreenSize(FVector(Distance, 0.0f, 1000.0f), 1.0f, FVector::ZeroVector, 6300.0f, 9000.0f);
+		TestTrue(TEXT("Screen size in range"), ScreenSize > 0.0f && ScreenSize <= 1.0f);
+
+		const float LOD = CyLandLODMath::GetBiasedLOD(LODScreenRatioSquared, ScreenSize, 1.0f, -1.0f, 0, 0.0f, 5.0f);
+		TestTrue(TEXT("LOD increases with the distance"), LOD >= PreviousLOD - KINDA_SMALL_NUMBER);
+		PreviousLOD = LOD;
+	}
+	TestEqual(TEXT("Far away components use the last LOD"), FMath::FloorToInt(PreviousLOD), 5);
+
+	// Every camera sample gives a frame, forcing LOD 0 gives the full triangle count of the visible components
+	FCyLandLODSimulationSettings Settings;
+	Settings.NumComponents = FIntPoint(8, 8);
+	Settings.NumSubsections = 2;
+	Settings.SubsectionSizeQuads = 31;
+
+	const FCyLandCameraPath Path = FCyLandCameraPath::MakeFlyover(8 * 62 * 100.0f, 10000.0f, 16);
+	const FCyLandLODSimulationReport Report = FCyLandLODSimulation(Settings).Run(Path);
+	TestEqual(TEXT("One frame per camera sample"), Report.Frames.Num(), Path.Samples.Num());
+
+	Settings.ForcedLOD = 0;
+	const FCyLandLODSimulationReport ForcedReport = FCyLandLODSimulation(Settings).Run(Path);
+	for (int32 FrameIndex = 0; FrameIndex < ForcedReport.Frames.Num(); FrameIndex++)
+	{
+		const FCyLandLODSimulationFrame& Frame = ForcedReport.Frames[FrameIndex];
+		TestEqual(TEXT("Forced LOD draws combined batches"), Frame.NumCombined, Frame.NumVisible);
+		TestEqual(TEXT("Forced LOD triangles"), Frame.NumTriangles, (int64)Frame.NumVisible * 4 * 2 * 31 * 31);
+		TestTrue(TEXT("Forced LOD has fewer triangles than LOD selection"), Report.Frames[FrameIndex].NumTriangles <= Frame.NumTriangles);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,112 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "CyLandLowPassFilter.h"
+
+#if WITH_KISSFFT
+#include "tools/kiss_fftnd.h"
+#endif
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_KISSFFT
+
+/**
+* Detail smoothing low-pass filter test, runs without a world or a renderer
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandLowPassFilterTest, "System.Engine.CyLand.Low Pass Filter", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandLowPassFilterTest::RunTest(const FString& Parameters)
+{
+	// Sizes that need no padding give the same result as the complex n-d transform of the whole region
+	const int32 SizeX = 24;
+	const int32 SizeY = 20;
+	const float DetailScale = 0.3f;
+
+	FRandomStream RandomStream(0x1095);
+	TArray<uint16> Heights;
+	Heights.SetNumUninitialized(SizeX * SizeY);
+	for (uint16& Height : Heights)
+	{
+		Height = (uint16)RandomStream.RandRange(0, 65535);
+	}
+
+	const int32 Dims[2] = { SizeY, SizeX };
+	kiss_fftnd_cfg Forward = kiss_fftnd_alloc(Dims, 2, 0, NULL, NULL);
+	kiss_fftnd_cfg Inverse = kiss_fftnd_alloc(Dims, 2, 1, NULL, NULL);
+	TArray<kiss_fft_cpx> Buffer, Spectrum;
+	Buffer.SetNumUninitialized(SizeX * SizeY);
+	Spectrum.SetNumUninitialized(SizeX * SizeY);
+	for (int32 Index = 0; Index < SizeX * SizeY; Index++)
+	{
+		Buffer[Index].r = Heights[Index];
+		Buffer[Index].i = 0;
+	}
+
+	kiss_fftnd(Forward, Buffer.GetData(), Spectrum.GetData());
+	for (int32 Y = 0; Y < SizeY; Y++)
+	{
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			const float FrequencyX = X < SizeX / 2 ? X : X - SizeX;
+			const float FrequencyY = Y < SizeY / 2 ? Y : Y - SizeY;
+			const float Ratio = 1.0f - DetailScale;
+			const float Dist = FMath::Min<float>((SizeY * Ratio)*(SizeY * Ratio), (SizeX * Ratio)*(SizeX * Ratio));
+			const float Filter = 1.0 / (1.0 + (FrequencyX * FrequencyX + FrequencyY * FrequencyY) / Dist);
+			Spectrum[X + Y * SizeX].r *= Filter;
+			Spectrum[X + Y * SizeX].i *= Filter;
+		}
+	}
+	kiss_fftnd(Inverse, Spectrum.GetData(), Buffer.GetData());
+	KISS_FFT_FREE(Forward);
+	KISS_FFT_FREE(Inverse);
+
+	// Twice, the second run reuses the cached plan
+	for (int32 Run = 0; Run < 2; Run++)
+	{
+		int32 Stride = 0;
+		const float* Filtered = CyLandLowPassFilter::Apply(Heights.GetData(), SizeX, SizeX, SizeY, DetailScale, Stride);
+		if (!TestNotNull(TEXT("Filter is available"), Filtered))
+		{
+			return false;
+		}
+
+		float MaxError = 0.0f;
+		for (int32 Y = 0; Y < SizeY; Y++)
+		{
+			for (int32 X = 0; X < SizeX; X++)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Filtered[X + Y * Stride] - Buffer[X + Y * SizeX].r / (SizeX * SizeY)));
+			}
+		}
+		TestTrue(TEXT("Matches the complex n-d transform"), MaxError < 0.5f);
+	}
+
+	// Padded sizes are mirrored at the edges, so a constant region stays constant
+	const int32 PaddedSizeX = 37;
+	const int32 PaddedSizeY = 29;
+	TArray<uint8> Weights;
+	Weights.Init(100, PaddedSizeX * PaddedSizeY);
+
+	int32 Stride = 0;
+	const float* Filtered = CyLandLowPassFilter::Apply(Weights.GetData(), PaddedSizeX, PaddedSizeX, PaddedSizeY, 0.8f, Stride);
+	if (!TestNotNull(TEXT("Filter is available"), Filtered))
+	{
+		return false;
+	}
+
+	float MaxError = 0.0f;
+	for (int32 Y = 0; Y < PaddedSizeY; Y++)
+	{
+		for (int32 X = 0; X < PaddedSizeX; X++)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(Filtered[X + Y * Stride] - 100.0f));
+		}
+	}
+	TestTrue(TEXT("Constant region is preserved"), MaxError < 0.01f);
+
+	CyLandLowPassFilter::EmptyCache();
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS && WITH_KISSFFT
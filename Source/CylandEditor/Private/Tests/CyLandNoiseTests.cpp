@@ -0,0 +1,82 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "CyLandEdModeTools.h"
+#include "CyLandNoise.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Eight sample noise test, runs without a world or a renderer
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandNoiseTest, "System.Engine.CyLand.Noise", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandNoiseTest::RunTest(const FString& Parameters)
+{
+	// Rows of a length that isn't a multiple of eight, across the origin where the coordinates are mirrored
+	const int32 RowLength = 45;
+	const float Scale = 37.5f;
+	const float Amount = 300.0f;
+	const float Base = 1000.0f;
+
+	const FNoiseParameter NoiseParam(Base, Scale, Amount);
+	const FCyLandNoise Noise(Scale, Amount, Base);
+
+	TArray<float> Row;
+	Row.SetNumUninitialized(RowLength);
+
+	float MaxError = 0.0f;
+	for (int32 Y = -20; Y < 20; Y++)
+	{
+		Noise.SampleRowMirrored(-20, Y, RowLength, Row.GetData());
+		for (int32 X = 0; X < RowLength; X++)
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(Row[X] - NoiseParam.Sample(X - 20, Y)));
+		}
+	}
+	TestTrue(TEXT("Mirrored noise matches FNoiseParameter"), MaxError < 0.01f);
+
+	// Without mirroring the octaves are sampled at the signed coordinates, so the noise isn't symmetric around 0
+	MaxError = 0.0f;
+	float MaxAsymmetry = 0.0f;
+	for (int32 Y = -20; Y < 20; Y++)
+	{
+		Noise.SampleRow(-20, Y, RowLength, Row.GetData());
+		for (int32 X = 0; X < RowLength; X++)
+		{
+			float Expected = 0.0f;
+			for (int32 Octave = 0; Octave < 4; Octave++)
+			{
+				const float OctaveShift = 1 << Octave;
+				const float OctaveScale = OctaveShift / Scale;
+				Expected += FCyLandNoise::PerlinNoise2D((X - 20) * OctaveScale, Y * OctaveScale) / OctaveShift;
+			}
+			MaxError = FMath::Max(MaxError, FMath::Abs(Row[X] - (Base + Expected * Amount)));
+			MaxAsymmetry = FMath::Max(MaxAsymmetry, FMath::Abs(Row[X] - Noise.Sample(20 - X, -Y)));
+		}
+	}
+	TestTrue(TEXT("Matches the octaves at signed coordinates"), MaxError < 0.01f);
+	TestTrue(TEXT("Isn't mirrored around the origin"), MaxAsymmetry > 1.0f);
+
+	// Warping moves the samples but keeps them within the amplitude of the octaves, also where they cross 0
+	FCyLandNoise WarpedNoise(Scale, Amount, Base);
+	WarpedNoise.SetDomainWarp(64.0f, 16.0f);
+
+	bool bInRange = true;
+	bool bWarped = false;
+	for (int32 Y = -10; Y < 10; Y++)
+	{
+		WarpedNoise.SampleRow(-20, Y, RowLength, Row.GetData());
+		for (int32 X = 0; X < RowLength; X++)
+		{
+			bInRange &= FMath::Abs(Row[X] - Base) <= 2.0f * Amount;
+			bWarped |= FMath::Abs(Row[X] - Noise.Sample(X - 20, Y)) > 0.01f;
+		}
+	}
+	TestTrue(TEXT("Warped noise stays in range"), bInRange);
+	TestTrue(TEXT("Warping changes the noise"), bWarped);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
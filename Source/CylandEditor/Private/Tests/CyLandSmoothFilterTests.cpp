@@ -0,0 +1,111 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "CyLandSmoothFilter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+* Smooth tool box filter test, runs without a world or a renderer
+*/
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCyLandSmoothFilterTest, "System.Engine.CyLand.Smooth Filter", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter);
+bool FCyLandSmoothFilterTest::RunTest(const FString& Parameters)
+{
+	const int32 Size = 24;
+	const int32 FilterRadius = 5;
+
+	// With the whole region brushed every vertex gets the mean of its clamped window, as with the per-sample loop
+	TArray<float> FullBrush;
+	FullBrush.Init(1.0f, Size * Size);
+
+	FRandomStream RandomStream(0x5300);
+	TArray<uint16> Heights;
+	Heights.SetNumUninitialized(Size * Size);
+	for (uint16& Height : Heights)
+	{
+		Height = (uint16)RandomStream.RandRange(0, 65535);
+	}
+
+	TArray<uint16> Smoothed = Heights;
+	CyLandSmoothFilter::Apply(FullBrush.GetData(), Smoothed.GetData(), Size, Size, Size, FilterRadius, 1.0f);
+
+	int32 NumMismatches = 0;
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			const int32 XRadius = FMath::Min3(FilterRadius, X, Size - X - 1);
+			const int32 YRadius = FMath::Min3(FilterRadius, Y, Size - Y - 1);
+
+			int64 FilterValue = 0;
+			for (int32 SampleY = Y - YRadius; SampleY <= Y + YRadius; SampleY++)
+			{
+				for (int32 SampleX = X - XRadius; SampleX <= X + XRadius; SampleX++)
+				{
+					FilterValue += Heights[SampleX + SampleY * Size];
+				}
+			}
+			FilterValue /= (2 * XRadius + 1) * (2 * YRadius + 1);
+
+			NumMismatches += Smoothed[X + Y * Size] != (uint16)FilterValue ? 1 : 0;
+		}
+	}
+	TestEqual(TEXT("Fully brushed region matches the brute force mean"), NumMismatches, 0);
+
+	// Windows stay symmetric inside a round brush, so a slope is left as it is and nothing outside the brush changes
+	TArray<float> RoundBrush;
+	TArray<uint8> Slope;
+	RoundBrush.SetNumZeroed(Size * Size);
+	Slope.SetNumUninitialized(Size * Size);
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			const float Distance = FVector2D(X - Size / 2, Y - Size / 2).Size();
+			RoundBrush[X + Y * Size] = FMath::Clamp(1.0f - Distance / (Size / 2 - 1), 0.0f, 1.0f);
+			Slope[X + Y * Size] = (uint8)(X * 3 + Y * 2);
+		}
+	}
+
+	TArray<uint8> SmoothedSlope = Slope;
+	CyLandSmoothFilter::Apply(RoundBrush.GetData(), SmoothedSlope.GetData(), Size, Size, Size, FilterRadius, 1.0f);
+	TestTrue(TEXT("Slope is preserved"), SmoothedSlope == Slope);
+
+	// Noise inside the brush is reduced
+	TArray<uint8> Noise;
+	Noise.SetNumUninitialized(Size * Size);
+	for (uint8& Weight : Noise)
+	{
+		Weight = (uint8)RandomStream.RandRange(0, 255);
+	}
+
+	TArray<uint8> SmoothedNoise = Noise;
+	CyLandSmoothFilter::Apply(RoundBrush.GetData(), SmoothedNoise.GetData(), Size, Size, Size, FilterRadius, 1.0f);
+
+	const int32 Center = Size / 2 + (Size / 2) * Size;
+	int32 CenterRange[2] = { 0, 0 };
+	for (const TArray<uint8>* Weights : { &Noise, &SmoothedNoise })
+	{
+		uint8 MinWeight = 255, MaxWeight = 0;
+		for (int32 Offset = -1; Offset <= 1; Offset++)
+		{
+			MinWeight = FMath::Min(MinWeight, (*Weights)[Center + Offset]);
+			MaxWeight = FMath::Max(MaxWeight, (*Weights)[Center + Offset]);
+		}
+		CenterRange[Weights == &Noise ? 0 : 1] = MaxWeight - MinWeight;
+	}
+	TestTrue(TEXT("Noise is smoothed at the brush center"), CenterRange[1] < CenterRange[0]);
+
+	int32 NumChangedOutside = 0;
+	for (int32 Index = 0; Index < Size * Size; Index++)
+	{
+		NumChangedOutside += (RoundBrush[Index] <= 0.0f && SmoothedNoise[Index] != Noise[Index]) ? 1 : 0;
+	}
+	TestEqual(TEXT("Vertices outside the brush are not written"), NumChangedOutside, 0);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -6,6 +6,7 @@
 #include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Engine/Private/InstancedStaticMesh.h"
 #include "Landscape/Classes/LandscapeGrassType.h"
+#include "CyLandGrassPlacement.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogGhrMimic, Warning, All);
 
@@ -104,21 +105,6 @@ FMyAsyncGhrTask::FMyAsyncGhrTask(FAsyncGhrBuilder* InBuilder, const FCachedMyFol
 {
 }
 
-template<uint32 Base>
-static FORCEINLINE float Halton(uint32 Index)
-{
-	float Result = 0.0f;
-	float InvBase = 1.0f / Base;
-	float Fraction = InvBase;
-	while (Index > 0)
-	{
-		Result += (Index % Base) * Fraction;
-		Index /= Base;
-		Fraction *= InvBase;
-	}
-	return Result;
-}
-
 struct FAsyncGhrBuilder : public FGhrBuilderBase
 {
 	FMyComponentGhrAccess GhrData;
@@ -228,14 +214,21 @@ struct FAsyncGhrBuilder : public FGhrBuilderBase
 		//	FVector2D LightMapCoordinate = NormalizedGhrCoordinate * LightmapBaseScale + LightmapBaseBias;
 		//	FVector2D ShadowMapCoordinate = NormalizedGhrCoordinate * ShadowmapBaseScale + ShadowmapBaseBias;
 		//
-		//	InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomStream.GetFraction(), LightMapCoordinate, ShadowMapCoordinate);
+		//	InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomFraction, LightMapCoordinate, ShadowMapCoordinate);
 		//}
 		//else
 		{
-			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomStream.GetFraction());
+			InstanceBuffer.SetInstance(InstanceIndex, InXForm, RandomFraction);
 		}
 	}
 
+	/** Same random sequence as FAsyncGrassBuilder::DrawInstanceRandom */
+	float DrawInstanceRandom()
+	{
+		RandomStream.GetFraction();
+		return RandomStream.GetFraction();
+	}
+
 	FVector GetRandomScale() const
 	{
 		FVector Result(1.0f);
@@ -282,179 +275,14 @@ struct FAsyncGhrBuilder : public FGhrBuilderBase
 		check(bHaveValidData);
 		double StartTime = FPlatformTime::Seconds();
 
-		float Div = 1.0f / float(SqrtMaxInstances);
 		TArray<FMatrix> InstanceTransforms;
 		if (HaltonBaseIndex)
 		{
-			if (Extent.X < 0)
-			{
-				Origin.X += Extent.X;
-				Extent.X *= -1.0f;
-			}
-			if (Extent.Y < 0)
-			{
-				Origin.Y += Extent.Y;
-				Extent.Y *= -1.0f;
-			}
-			int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
-			InstanceTransforms.Reserve(MaxNum);
-			FVector DivExtent(Extent * Div);
-			for (int32 InstanceIndex = 0; InstanceIndex < MaxNum; InstanceIndex++)
-			{
-				float HaltonX = Halton<2>(InstanceIndex + HaltonBaseIndex);
-				float HaltonY = Halton<3>(InstanceIndex + HaltonBaseIndex);
-				FVector Location(Origin.X + HaltonX * Extent.X, Origin.Y + HaltonY * Extent.Y, 0.0f);
-				FVector LocationWithHeight;
-				float Weight = GetLayerWeightAtLocationLocal(Location, &LocationWithHeight);
-				bool bKeep = Weight > 0.0f && Weight >= RandomStream.GetFraction() && !IsExcluded(LocationWithHeight);
-				if (bKeep)
-				{
-					const FVector Scale = RandomScale ? GetRandomScale() : FVector(1);
-					const float Rot = RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f;
-					const FMatrix BaseXForm = FScaleRotationTranslationMatrix(Scale, FRotator(0.0f, Rot, 0.0f), FVector::ZeroVector);
-					FMatrix OutXForm;
-					if (AlignToSurface)
-					{
-						FVector LocationWithHeightDX;
-						FVector LocationDX(Location);
-						LocationDX.X = FMath::Clamp<float>(LocationDX.X + (HaltonX < 0.5f ? DivExtent.X : -DivExtent.X), Origin.X, Origin.X + Extent.X);
-						GetLayerWeightAtLocationLocal(LocationDX, &LocationWithHeightDX, false);
-
-						FVector LocationWithHeightDY;
-						FVector LocationDY(Location);
-						LocationDY.Y = FMath::Clamp<float>(LocationDX.Y + (HaltonY < 0.5f ? DivExtent.Y : -DivExtent.Y), Origin.Y, Origin.Y + Extent.Y);
-						GetLayerWeightAtLocationLocal(LocationDY, &LocationWithHeightDY, false);
-
-						if (LocationWithHeight != LocationWithHeightDX && LocationWithHeight != LocationWithHeightDY)
-						{
-							FVector NewZ = ((LocationWithHeight - LocationWithHeightDX) ^ (LocationWithHeight - LocationWithHeightDY)).GetSafeNormal();
-							NewZ *= FMath::Sign(NewZ.Z);
-
-							const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
-							const FVector NewY = NewZ ^ NewX;
-
-							FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
-							OutXForm = (BaseXForm * Align).ConcatTranslation(LocationWithHeight) * XForm;
-						}
-						else
-						{
-							OutXForm = BaseXForm.ConcatTranslation(LocationWithHeight) * XForm;
-						}
-					}
-					else
-					{
-						OutXForm = BaseXForm.ConcatTranslation(LocationWithHeight) * XForm;
-					}
-					InstanceTransforms.Add(OutXForm);
-				}
-			}
-			if (InstanceTransforms.Num())
-			{
-				TotalInstances += InstanceTransforms.Num();
-				InstanceBuffer.AllocateInstances(InstanceTransforms.Num(), EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
-				for (int32 InstanceIndex = 0; InstanceIndex < InstanceTransforms.Num(); InstanceIndex++)
-				{
-					const FMatrix& OutXForm = InstanceTransforms[InstanceIndex];
-					SetInstance(InstanceIndex, OutXForm, RandomStream.GetFraction());
-				}
-			}
+			BuildHalton(InstanceTransforms);
 		}
 		else
 		{
-			int32 NumKept = 0;
-			float MaxJitter1D = FMath::Clamp<float>(PlacementJitter, 0.0f, .99f) * Div * .5f;
-			FVector MaxJitter(MaxJitter1D, MaxJitter1D, 0.0f);
-			MaxJitter *= Extent;
-			Origin += Extent * (Div * 0.5f);
-			struct FInstanceLocal
-			{
-				FVector Pos;
-				bool bKeep;
-			};
-			TArray<FInstanceLocal> Instances;
-			Instances.AddUninitialized(SqrtMaxInstances * SqrtMaxInstances);
-			{
-				int32 InstanceIndex = 0;
-				for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
-				{
-					for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
-					{
-						FVector Location(Origin.X + float(xStart) * Div * Extent.X, Origin.Y + float(yStart) * Div * Extent.Y, 0.0f);
-
-						// NOTE: We evaluate the random numbers on the stack and store them in locals rather than inline within the FVector() constructor below, because 
-						// the order of evaluation of function arguments in C++ is unspecified.  We really want this to behave consistently on all sorts of
-						// different platforms!
-						const float FirstRandom = RandomStream.GetFraction();
-						const float SecondRandom = RandomStream.GetFraction();
-						Location += FVector(FirstRandom * 2.0f - 1.0f, SecondRandom * 2.0f - 1.0f, 0.0f) * MaxJitter;
-
-						FInstanceLocal& Instance = Instances[InstanceIndex];
-						float Weight = GetLayerWeightAtLocationLocal(Location, &Instance.Pos);
-						Instance.bKeep = Weight > 0.0f && Weight >= RandomStream.GetFraction() && !IsExcluded(Instance.Pos);
-						if (Instance.bKeep)
-						{
-							NumKept++;
-						}
-						InstanceIndex++;
-					}
-				}
-			}
-			UE_LOG(LogGhrMimic, Warning, TEXT(" NumKept %d"), NumKept);
-
-			if (NumKept)
-			{
-				InstanceTransforms.AddUninitialized(NumKept);
-				TotalInstances += NumKept;
-				{
-					InstanceBuffer.AllocateInstances(NumKept, EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
-					int32 InstanceIndex = 0;
-					int32 OutInstanceIndex = 0;
-					for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
-					{
-						for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
-						{
-							const FInstanceLocal& Instance = Instances[InstanceIndex];
-							if (Instance.bKeep)
-							{
-								const FVector Scale = RandomScale ? GetRandomScale() : FVector(1);
-								const float Rot = RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f;
-								const FMatrix BaseXForm = FScaleRotationTranslationMatrix(Scale, FRotator(0.0f, Rot, 0.0f), FVector::ZeroVector);
-								FMatrix OutXForm;
-								if (AlignToSurface)
-								{
-									FVector PosX1 = xStart ? Instances[InstanceIndex - SqrtMaxInstances].Pos : Instance.Pos;
-									FVector PosX2 = (xStart + 1 < SqrtMaxInstances) ? Instances[InstanceIndex + SqrtMaxInstances].Pos : Instance.Pos;
-									FVector PosY1 = yStart ? Instances[InstanceIndex - 1].Pos : Instance.Pos;
-									FVector PosY2 = (yStart + 1 < SqrtMaxInstances) ? Instances[InstanceIndex + 1].Pos : Instance.Pos;
-
-									if (PosX1 != PosX2 && PosY1 != PosY2)
-									{
-										FVector NewZ = ((PosX1 - PosX2) ^ (PosY1 - PosY2)).GetSafeNormal();
-										NewZ *= FMath::Sign(NewZ.Z);
-
-										const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
-										const FVector NewY = NewZ ^ NewX;
-
-										FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
-										OutXForm = (BaseXForm * Align).ConcatTranslation(Instance.Pos) * XForm;
-									}
-									else
-									{
-										OutXForm = BaseXForm.ConcatTranslation(Instance.Pos) * XForm;
-									}
-								}
-								else
-								{
-									OutXForm = BaseXForm.ConcatTranslation(Instance.Pos) * XForm;
-								}
-								InstanceTransforms[OutInstanceIndex] = OutXForm;
-								SetInstance(OutInstanceIndex++, OutXForm, RandomStream.GetFraction());
-							}
-							InstanceIndex++;
-						}
-					}
-				}
-			}
+			BuildGrid(InstanceTransforms);
 		}
 
 		int32 NumInstances = InstanceTransforms.Num();
@@ -487,59 +315,238 @@ struct FAsyncGhrBuilder : public FGhrBuilderBase
 		}
 		BuildTime = FPlatformTime::Seconds() - StartTime;
 	}
-	FORCEINLINE_DEBUGGABLE float GetLayerWeightAtLocationLocal(const FVector& InLocation, FVector* OutLocation, bool bWeight = true)
+
+	/**
+	 * Halton placement, one block of candidates at a time: generate the positions, sample weight and height for the
+	 * whole block, walk the random stream in candidate order to pick the kept ones, then build their transforms.
+	 */
+	void BuildHalton(TArray<FMatrix>& InstanceTransforms)
 	{
-		// Find location
-		float TestX = InLocation.X / DrawScale.X - (float)SectionBase.X;
-		float TestY = InLocation.Y / DrawScale.Y - (float)SectionBase.Y;
-
-		// Find data
-		int32 X1 = FMath::FloorToInt(TestX);
-		int32 Y1 = FMath::FloorToInt(TestY);
-		int32 X2 = FMath::CeilToInt(TestX);
-		int32 Y2 = FMath::CeilToInt(TestY);
-
-		// Clamp to prevent the sampling of the final columns from overflowing
-		int32 IdxX1 = FMath::Clamp<int32>(X1, 0, GhrData.GetStride() - 1);
-		int32 IdxY1 = FMath::Clamp<int32>(Y1, 0, GhrData.GetStride() - 1);
-		int32 IdxX2 = FMath::Clamp<int32>(X2, 0, GhrData.GetStride() - 1);
-		int32 IdxY2 = FMath::Clamp<int32>(Y2, 0, GhrData.GetStride() - 1);
-
-		float LerpX = FMath::Fractional(TestX);
-		float LerpY = FMath::Fractional(TestY);
-
-		float Result = 0.0f;
-		if (bWeight)
+		using namespace CyLandGrassPlacement;
+
+		if (Extent.X < 0)
 		{
-			// sample
-			float Sample11 = GhrData.GetWeight(IdxX1, IdxY1);
-			float Sample21 = GhrData.GetWeight(IdxX2, IdxY1);
-			float Sample12 = GhrData.GetWeight(IdxX1, IdxY2);
-			float Sample22 = GhrData.GetWeight(IdxX2, IdxY2);
-
-			// Bilinear interpolate
-			Result = FMath::Lerp(
-				FMath::Lerp(Sample11, Sample21, LerpX),
-				FMath::Lerp(Sample12, Sample22, LerpX),
-				LerpY);
+			Origin.X += Extent.X;
+			Extent.X *= -1.0f;
+		}
+		if (Extent.Y < 0)
+		{
+			Origin.Y += Extent.Y;
+			Extent.Y *= -1.0f;
+		}
+		const float Div = 1.0f / float(SqrtMaxInstances);
+		const int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
+		InstanceTransforms.Reserve(MaxNum);
+		const FVector DivExtent(Extent * Div);
+		const FVector2D SectionOffset(DrawScale.X * float(MySectionOffset.X), DrawScale.Y * float(MySectionOffset.Y));
+
+		TArray<float> HaltonX, HaltonY, X, Y, Weight, Z;
+		for (TArray<float>* Array : { &HaltonX, &HaltonY, &X, &Y, &Weight, &Z })
+		{
+			Array->SetNumUninitialized(BlockSize);
 		}
 
+		// Kept candidates of the current block, and the locations next to them used to align to the surface
+		TArray<int32> Kept;
+		TArray<FVector> KeptScale;
+		TArray<float> KeptRotation;
+		TArray<float> AlignX, AlignY, AlignZ;
+
+		for (int32 BlockStart = 0; BlockStart < MaxNum; BlockStart += BlockSize)
 		{
-			// sample
-			float Sample11 = GhrData.GetHeight(IdxX1, IdxY1);
-			float Sample21 = GhrData.GetHeight(IdxX2, IdxY1);
-			float Sample12 = GhrData.GetHeight(IdxX1, IdxY2);
-			float Sample22 = GhrData.GetHeight(IdxX2, IdxY2);
-
-			OutLocation->X = InLocation.X - DrawScale.X * float(MySectionOffset.X);
-			OutLocation->Y = InLocation.Y - DrawScale.Y * float(MySectionOffset.Y);
-			// Bilinear interpolate
-			OutLocation->Z = DrawScale.Z * FMath::Lerp(
-				FMath::Lerp(Sample11, Sample21, LerpX),
-				FMath::Lerp(Sample12, Sample22, LerpX),
-				LerpY);
+			const int32 Num = FMath::Min<int32>(BlockSize, MaxNum - BlockStart);
+			GenerateHalton(HaltonBaseIndex + BlockStart, Num, Origin, Extent, HaltonX.GetData(), HaltonY.GetData(), X.GetData(), Y.GetData());
+			SampleBilinear(GhrData, DrawScale, SectionBase, X.GetData(), Y.GetData(), Num, Weight.GetData(), Z.GetData());
+
+			Kept.Reset();
+			KeptScale.Reset();
+			KeptRotation.Reset();
+			for (int32 Index = 0; Index < Num; Index++)
+			{
+				const FVector LocationWithHeight(X[Index] - SectionOffset.X, Y[Index] - SectionOffset.Y, Z[Index]);
+				if (Weight[Index] > 0.0f && Weight[Index] >= RandomStream.GetFraction() && !IsExcluded(LocationWithHeight))
+				{
+					Kept.Add(Index);
+					KeptScale.Add(RandomScale ? GetRandomScale() : FVector(1));
+					KeptRotation.Add(RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f);
+				}
+			}
+
+			const int32 NumKept = Kept.Num();
+			if (AlignToSurface && NumKept)
+			{
+				// [0, NumKept) are the neighbors along X, [NumKept, 2 * NumKept) along Y
+				AlignX.SetNumUninitialized(NumKept * 2, false);
+				AlignY.SetNumUninitialized(NumKept * 2, false);
+				AlignZ.SetNumUninitialized(NumKept * 2, false);
+				for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+				{
+					const int32 Index = Kept[KeptIndex];
+					AlignX[KeptIndex] = FMath::Clamp<float>(X[Index] + (HaltonX[Index] < 0.5f ? DivExtent.X : -DivExtent.X), Origin.X, Origin.X + Extent.X);
+					AlignY[KeptIndex] = Y[Index];
+					AlignX[NumKept + KeptIndex] = X[Index];
+					AlignY[NumKept + KeptIndex] = FMath::Clamp<float>(Y[Index] + (HaltonY[Index] < 0.5f ? DivExtent.Y : -DivExtent.Y), Origin.Y, Origin.Y + Extent.Y);
+				}
+				SampleBilinear(GhrData, DrawScale, SectionBase, AlignX.GetData(), AlignY.GetData(), NumKept * 2, nullptr, AlignZ.GetData());
+			}
+
+			for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+			{
+				const int32 Index = Kept[KeptIndex];
+				const FVector LocationWithHeight(X[Index] - SectionOffset.X, Y[Index] - SectionOffset.Y, Z[Index]);
+				const FMatrix BaseXForm = FScaleRotationTranslationMatrix(KeptScale[KeptIndex], FRotator(0.0f, KeptRotation[KeptIndex], 0.0f), FVector::ZeroVector);
+				if (AlignToSurface)
+				{
+					const FVector LocationWithHeightDX(AlignX[KeptIndex] - SectionOffset.X, AlignY[KeptIndex] - SectionOffset.Y, AlignZ[KeptIndex]);
+					const FVector LocationWithHeightDY(AlignX[NumKept + KeptIndex] - SectionOffset.X, AlignY[NumKept + KeptIndex] - SectionOffset.Y, AlignZ[NumKept + KeptIndex]);
+					InstanceTransforms.Add(GetAlignedTransform(BaseXForm, LocationWithHeight, LocationWithHeight, LocationWithHeightDX, LocationWithHeight, LocationWithHeightDY));
+				}
+				else
+				{
+					InstanceTransforms.Add(BaseXForm.ConcatTranslation(LocationWithHeight) * XForm);
+				}
+			}
 		}
-		return Result;
+
+		if (InstanceTransforms.Num())
+		{
+			TotalInstances += InstanceTransforms.Num();
+			InstanceBuffer.AllocateInstances(InstanceTransforms.Num(), EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
+			for (int32 InstanceIndex = 0; InstanceIndex < InstanceTransforms.Num(); InstanceIndex++)
+			{
+				SetInstance(InstanceIndex, InstanceTransforms[InstanceIndex], DrawInstanceRandom());
+			}
+		}
+	}
+
+	/**
+	 * Grid placement. The jitter of a candidate depends on how many random numbers the previous ones used, which
+	 * depends on their weight, so the jitter and weight pass stays sequential; heights are then sampled in one batch
+	 * and the random numbers of the kept instances drawn before building all transforms.
+	 */
+	void BuildGrid(TArray<FMatrix>& InstanceTransforms)
+	{
+		using namespace CyLandGrassPlacement;
+
+		const float Div = 1.0f / float(SqrtMaxInstances);
+		float MaxJitter1D = FMath::Clamp<float>(PlacementJitter, 0.0f, .99f) * Div * .5f;
+		FVector MaxJitter(MaxJitter1D, MaxJitter1D, 0.0f);
+		MaxJitter *= Extent;
+		Origin += Extent * (Div * 0.5f);
+		const FVector2D SectionOffset(DrawScale.X * float(MySectionOffset.X), DrawScale.Y * float(MySectionOffset.Y));
+
+		const int32 MaxNum = SqrtMaxInstances * SqrtMaxInstances;
+		TArray<float> X, Y, Z;
+		TArray<bool> Keep;
+		X.SetNumUninitialized(MaxNum);
+		Y.SetNumUninitialized(MaxNum);
+		Z.SetNumUninitialized(MaxNum);
+		Keep.SetNumUninitialized(MaxNum);
+		{
+			int32 InstanceIndex = 0;
+			for (int32 xStart = 0; xStart < SqrtMaxInstances; xStart++)
+			{
+				for (int32 yStart = 0; yStart < SqrtMaxInstances; yStart++)
+				{
+					// NOTE: We evaluate the random numbers on the stack and store them in locals rather than inline within the FVector() constructor below, because 
+					// the order of evaluation of function arguments in C++ is unspecified.  We really want this to behave consistently on all sorts of
+					// different platforms!
+					const float FirstRandom = RandomStream.GetFraction();
+					const float SecondRandom = RandomStream.GetFraction();
+					X[InstanceIndex] = Origin.X + float(xStart) * Div * Extent.X + (FirstRandom * 2.0f - 1.0f) * MaxJitter.X;
+					Y[InstanceIndex] = Origin.Y + float(yStart) * Div * Extent.Y + (SecondRandom * 2.0f - 1.0f) * MaxJitter.Y;
+
+					float Weight;
+					SampleBilinearScalar(GhrData, DrawScale, SectionBase, X[InstanceIndex], Y[InstanceIndex], &Weight, nullptr);
+					Keep[InstanceIndex] = Weight > 0.0f && Weight >= RandomStream.GetFraction();
+					InstanceIndex++;
+				}
+			}
+		}
+
+		SampleBilinear(GhrData, DrawScale, SectionBase, X.GetData(), Y.GetData(), MaxNum, nullptr, Z.GetData());
+
+		auto GetPos = [&](int32 InstanceIndex)
+		{
+			return FVector(X[InstanceIndex] - SectionOffset.X, Y[InstanceIndex] - SectionOffset.Y, Z[InstanceIndex]);
+		};
+
+		TArray<int32> Kept;
+		for (int32 InstanceIndex = 0; InstanceIndex < MaxNum; InstanceIndex++)
+		{
+			if (Keep[InstanceIndex] && !IsExcluded(GetPos(InstanceIndex)))
+			{
+				Kept.Add(InstanceIndex);
+			}
+		}
+
+		const int32 NumKept = Kept.Num();
+		UE_LOG(LogGhrMimic, Warning, TEXT(" NumKept %d"), NumKept);
+
+		if (NumKept == 0)
+		{
+			return;
+		}
+
+		// Same order of random numbers as when each instance was finished before starting the next one
+		TArray<FVector> KeptScale;
+		TArray<float> KeptRotation;
+		TArray<float> KeptRandom;
+		KeptScale.Reserve(NumKept);
+		KeptRotation.Reserve(NumKept);
+		KeptRandom.Reserve(NumKept);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			KeptScale.Add(RandomScale ? GetRandomScale() : FVector(1));
+			KeptRotation.Add(RandomRotation ? RandomStream.GetFraction() * 360.0f : 0.0f);
+			KeptRandom.Add(DrawInstanceRandom());
+		}
+
+		InstanceTransforms.SetNumUninitialized(NumKept);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			const int32 InstanceIndex = Kept[KeptIndex];
+			const int32 xStart = InstanceIndex / SqrtMaxInstances;
+			const int32 yStart = InstanceIndex % SqrtMaxInstances;
+			const FVector Pos = GetPos(InstanceIndex);
+			const FMatrix BaseXForm = FScaleRotationTranslationMatrix(KeptScale[KeptIndex], FRotator(0.0f, KeptRotation[KeptIndex], 0.0f), FVector::ZeroVector);
+			if (AlignToSurface)
+			{
+				const FVector PosX1 = xStart ? GetPos(InstanceIndex - SqrtMaxInstances) : Pos;
+				const FVector PosX2 = (xStart + 1 < SqrtMaxInstances) ? GetPos(InstanceIndex + SqrtMaxInstances) : Pos;
+				const FVector PosY1 = yStart ? GetPos(InstanceIndex - 1) : Pos;
+				const FVector PosY2 = (yStart + 1 < SqrtMaxInstances) ? GetPos(InstanceIndex + 1) : Pos;
+				InstanceTransforms[KeptIndex] = GetAlignedTransform(BaseXForm, Pos, PosX1, PosX2, PosY1, PosY2);
+			}
+			else
+			{
+				InstanceTransforms[KeptIndex] = BaseXForm.ConcatTranslation(Pos) * XForm;
+			}
+		}
+
+		TotalInstances += NumKept;
+		InstanceBuffer.AllocateInstances(NumKept, EResizeBufferFlags::AllowSlackOnGrow | EResizeBufferFlags::AllowSlackOnReduce, true);
+		for (int32 KeptIndex = 0; KeptIndex < NumKept; KeptIndex++)
+		{
+			SetInstance(KeptIndex, InstanceTransforms[KeptIndex], KeptRandom[KeptIndex]);
+		}
+	}
+
+	/** Transform of an instance at Pos, aligned to the surface through the pairs of positions around it when they differ */
+	FORCEINLINE FMatrix GetAlignedTransform(const FMatrix& BaseXForm, const FVector& Pos, const FVector& PosX1, const FVector& PosX2, const FVector& PosY1, const FVector& PosY2) const
+	{
+		if (PosX1 != PosX2 && PosY1 != PosY2)
+		{
+			FVector NewZ = ((PosX1 - PosX2) ^ (PosY1 - PosY2)).GetSafeNormal();
+			NewZ *= FMath::Sign(NewZ.Z);
+
+			const FVector NewX = (FVector(0, -1, 0) ^ NewZ).GetSafeNormal();
+			const FVector NewY = NewZ ^ NewX;
+
+			FMatrix Align = FMatrix(NewX, NewY, NewZ, FVector::ZeroVector);
+			return (BaseXForm * Align).ConcatTranslation(Pos) * XForm;
+		}
+		return BaseXForm.ConcatTranslation(Pos) * XForm;
 	}
 };
 